@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Fri Nov  9 14:24:19 PST 2020
-// Last Modified: Mon Nov  9 08:33:32 PST 2020
+// Last Modified: Sun Oct 18 14:41:07 PDT 2026
 // Filename:      cli/corscape.cpp
 // URL:           https://github.com/craigsapp/humlib/blob/master/cli/corscape.cpp
 // Syntax:        C++11
@@ -20,12 +20,11 @@ void   processFile      (HumdrumFile& infile, Options& options);
 void   printInputData   (vector<double>& x, vector<double>& y);
 void   printInputData   (vector<double>& x);
 void   extractData      (HumdrumFile& infile, vector<double>& x, int xindex, vector<double>&y, int yindex);
-bool   getCorrelation   (double& output, vector<double>& x, int xstart, vector<double>& y, int ystart, int len);
 bool   getCorrelation2  (double& output, vector<double>& x, int xstart, vector<double>& y);
 void   printRawAnalysis (vector<vector<double>>& analysis);
-void   doRowAnalysis    (vector<double>& row, int windowlen, vector<double>& x, vector<double>& y);
 void   doArchRowAnalysis(vector<double>& row, int windowlen, vector<double>& x);
-void   doCombRowAnalysis(vector<double>& row, int windowlen, vector<double>& x);
+void   doCombRowAnalysis(vector<double>& row, int windowlen, vector<double>& x, int cycle);
+void   suppressNaNs     (vector<double>& row);
 void   printCorrelationScape(vector<vector<double>>& correlations,
                          vector<double>& x, vector<double>& xsmooth,
                          vector<double>& y, vector<double>& ysmooth);
@@ -75,6 +74,7 @@ int main(int argc, char** argv) {
 	options.define("s|smooth=b", "smooth input data");
 	options.define("S|unsmooth=b", "unsmooth input data");
 	options.define("sf|smooth-factor=d:0.4", "smoothing factor");
+	options.define("t|threads=i:1", "number of threads for calculating the scape (0 = all)");
 	options.process(argc, argv);
 	HumdrumFileStream instream(options);
 	HumdrumFile infile;
@@ -176,31 +176,32 @@ void processFile(HumdrumFile& infile, Options& options) {
 		return;
 	}
 
+	vector<double>& xdata = (smoothQ || unsmoothQ) ? xsmooth : x;
+	vector<double>& ydata = (smoothQ || unsmoothQ) ? ysmooth : y;
+	int threads = options.getInteger("threads");
+	int cycle = options.getInteger("comb");
+
 	int tsize = (int)x.size();
 	vector<vector<double>> analysis;
-	analysis.resize(x.size()-1);
-	for (int i=0; i<tsize-1; i++) {
-		analysis.at(i).resize(i+1);
-		fill(analysis.at(i).begin(), analysis.at(i).end(), -123456789.0);
-		if (archQ) {
-			if (smoothQ || unsmoothQ) {
-				doArchRowAnalysis(analysis.at(i), tsize-i, xsmooth);
-			} else {
-				doArchRowAnalysis(analysis.at(i), tsize-i, x);
-			}
-		} else if (combQ) {
-			if (smoothQ || unsmoothQ) {
-				doCombRowAnalysis(analysis.at(i), tsize-i, xsmooth);
-			} else {
-				doCombRowAnalysis(analysis.at(i), tsize-i, x);
-			}
-		} else {
-			// Regular correlation plot comparing two sequences
-			if (smoothQ || unsmoothQ) {
-				doRowAnalysis(analysis.at(i), tsize-i, xsmooth, ysmooth);
+	if (singleQ) {
+		// The arch and comb shapes change with the window length, so
+		// each window is correlated separately.
+		analysis.resize(x.size()-1);
+		HumThreadPool pool(threads);
+		pool.run(tsize-1, [&](int i) {
+			analysis.at(i).resize(i+1);
+			fill(analysis.at(i).begin(), analysis.at(i).end(), -123456789.0);
+			if (archQ) {
+				doArchRowAnalysis(analysis.at(i), tsize-i, xdata);
 			} else {
-				doRowAnalysis(analysis.at(i), tsize-i, x, y);
+				doCombRowAnalysis(analysis.at(i), tsize-i, xdata, cycle);
 			}
+		});
+	} else {
+		// Regular correlation plot comparing two sequences
+		Convert::correlationScape(analysis, xdata, ydata, threads);
+		for (int i=0; i<(int)analysis.size(); i++) {
+			suppressNaNs(analysis[i]);
 		}
 	}
 
@@ -276,9 +277,8 @@ void doArchRowAnalysis(vector<double>& row, int windowlen, vector<double>& x) {
 // doCombRowAnalysis --
 //
 
-void doCombRowAnalysis(vector<double>& row, int windowlen, vector<double>& x) {
+void doCombRowAnalysis(vector<double>& row, int windowlen, vector<double>& x, int cycle) {
 	vector<double> y(windowlen);
-	int cycle = options.getInteger("comb");
 	getComb(y, cycle);
 
 	for (int i=0; i<(int)row.size(); i++) {
@@ -306,27 +306,20 @@ void doCombRowAnalysis(vector<double>& row, int windowlen, vector<double>& x) {
 
 //////////////////////////////
 //
-// doRowAnalysis --
+// suppressNaNs -- Convert the 0/0 correlations of flat windows to zeros
+//     and apply the -N option to the correlations in a row of the scape.
 //
 
-void doRowAnalysis(vector<double>& row, int windowlen, vector<double>& x, vector<double>& y) {
+void suppressNaNs(vector<double>& row) {
 	for (int i=0; i<(int)row.size(); i++) {
-		double value;
-		int status;
-		status = getCorrelation(value, x, i, y, i, windowlen);
-		if (!status) {
-			cerr << "Error" << endl;
-			return;
-		}
-		if (Convert::isNaN(value)) {
-			// suppressing 0/0 cases (converting them to zeros).
+		if (Convert::isNaN(row[i])) {
 			// This will happen most likely at length-2 correlations, but
 			// can happen with vastly decreasing likelihood for larger
 			// correlations when comparing flat sequences that have a
 			// zero standard devaition.
-			row.at(i) = -0.0;
+			row[i] = -0.0;
 		} else {
-			row.at(i) = value;
+			row[i] *= Negate;
 		}
 	}
 }
@@ -359,47 +352,6 @@ void printRawAnalysis(vector<vector<double>>& analysis) {
 
 
 
-//////////////////////////////
-//
-// getCorrelation -- return value is status: true if successful; false otherwise.
-//
-
-bool getCorrelation(double& output, vector<double>& x, int xstart, vector<double>& y, int ystart, int len) {
-	if ((xstart == 0) && (len == (int)x.size())) {
-		if ((ystart == 0) && (len == (int)y.size())) {
-			output = Convert::pearsonCorrelation(x, y);
-			output *= Negate;
-			return 1;
-		}
-	}
-
-	if (xstart + len > (int)x.size()) {
-		cerr << "Error: Cannot go beyond end of vector x: " << xstart + len << " max is " << ((int)x.size()) << endl;
-		cerr << "XSTART " << xstart << " LEN " << len << " vector size: " << x.size() << endl;
-		return 0;
-	}
-
-	if (ystart + len > (int)y.size()) {
-		cerr << "Error: Cannot go beyond end of vector y: " << ystart + len << " max is " << ((int)y.size()) << endl;
-		cerr << "YSTART " << ystart << " LEN " << len << " vector size: " << y.size() << endl;
-		return 0;
-	}
-
-	auto x1 = x.begin() + xstart;
-	auto x2 = x.begin() + xstart + len;
-	auto y1 = y.begin() + ystart;
-	auto y2 = y.begin() + xstart + len;
-
-	vector<double> xx(x1, x2);
-	vector<double> yy(y1, y2);
-
-	output = Convert::pearsonCorrelation(xx, yy);
-	output *= Negate;
-	return 1;
-}
-
-
-
 //////////////////////////////
 //
 // getCorrelation2 -- return value is status: true if successful; false otherwise.  This version
@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Mon Dec  5 23:07:22 PST 2016
-// Last Modified: Mon Dec  5 23:07:25 PST 2016
+// Last Modified: Sun Oct 18 20:41:09 PDT 2026
 // Filename:      cli/extractx.cpp
 // URL:           https://github.com/craigsapp/humlib/blob/master/cli/extractx.cpp
 // Syntax:        C++11
@@ -12,7 +12,7 @@
 
 #include "humlib.h"
 
-STREAM_INTERFACE(Tool_extract)
+PARALLEL_STREAM_INTERFACE(Tool_extract)
 
 
 
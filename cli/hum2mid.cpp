@@ -0,0 +1,212 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 10:12:44 PDT 2026
+// Last Modified: Mon Oct 19 00:36:05 PDT 2026
+// Filename:      cli/hum2mid.cpp
+// URL:           https://github.com/craigsapp/humlib/blob/master/cli/hum2mid.cpp
+// Syntax:        C++11
+// vim:           ts=3 noexpandtab
+//
+// Description:   Converter from Humdrum **kern data to MIDI files.  Multiple
+//                input files (or a stream of !!!!SEGMENT files) are placed
+//                one after another in the output MIDI file.  Events are
+//                written to the output as they are generated (as a type-0
+//                MIDI file, with one channel for each **kern spine), so
+//                the memory used does not depend on the length of the input.
+//
+
+#include "humlib.h"
+
+#include <cstdio>
+#include <iostream>
+
+using namespace std;
+using namespace hum;
+
+void processFile       (FILE* out, HumdrumFile& infile);
+void writeEvent        (FILE* out, int tick, int b0, int b1, int b2);
+void writeTempo        (FILE* out, int tick, double tempo);
+void writeVlv          (FILE* out, int value);
+void writeInt          (FILE* out, int value, int bytes);
+void writeTrackLength  (FILE* out, long start);
+
+// Global variables:
+Options options;
+int Tpq      = 480;  // used with -q option
+int Velocity = 64;   // used with -v option
+int Offset   = 0;    // tick time of the start of the next file
+int LastTick = 0;    // tick time of the last event written
+
+
+///////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv) {
+	options.define("q|tpq=i:480",      "Ticks per quarter note in MIDI file");
+	options.define("v|velocity=i:64",  "Attack velocity of notes");
+	options.define("t|tempo=d:120",    "Initial tempo of MIDI file");
+	options.define("o|output=s",       "Save MIDI file to given filename");
+	options.process(argc, argv);
+	Tpq = options.getInteger("tpq");
+	Velocity = options.getInteger("velocity");
+
+	// The track length is stored before the track data, so the output
+	// has to be seekable.  When writing to standard output, the MIDI
+	// data is first written to a temporary file.
+	FILE* outfile;
+	if (options.getBoolean("output")) {
+		outfile = std::fopen(options.getString("output").c_str(), "w+b");
+	} else {
+		outfile = std::tmpfile();
+	}
+	if (!outfile) {
+		cerr << "Error: cannot write MIDI file" << endl;
+		exit(1);
+	}
+
+	// MIDI file header (type-0 file with one track):
+	std::fputs("MThd", outfile);
+	writeInt(outfile, 6, 4);
+	writeInt(outfile, 0, 2);
+	writeInt(outfile, 1, 2);
+	writeInt(outfile, Tpq, 2);
+	std::fputs("MTrk", outfile);
+	long trackstart = std::ftell(outfile);
+	writeInt(outfile, 0, 4);
+
+	if (options.getBoolean("tempo")) {
+		writeTempo(outfile, 0, options.getDouble("tempo"));
+	}
+
+	HumdrumFileStream instream(options);
+	HumdrumFile infile;
+	while (instream.read(infile)) {
+		processFile(outfile, infile);
+	}
+
+	// end-of-track meta message:
+	writeVlv(outfile, 0);
+	writeInt(outfile, 0xff2f00, 3);
+	writeTrackLength(outfile, trackstart);
+
+	if (!options.getBoolean("output")) {
+		std::rewind(outfile);
+		char buffer[4096];
+		size_t count;
+		while ((count = std::fread(buffer, 1, sizeof(buffer), outfile)) > 0) {
+			cout.write(buffer, count);
+		}
+	}
+	std::fclose(outfile);
+
+	return 0;
+}
+
+
+///////////////////////////////////////////////////////////////////////////
+
+
+//////////////////////////////
+//
+// processFile -- Write the MIDI events for a Humdrum file after the events
+//     of the previous files.  Each **kern spine is given a separate MIDI
+//     channel.
+//
+
+void processFile(FILE* out, HumdrumFile& infile) {
+	Offset = infile.getMidiEvents([&](const HumMidiEvent& event) {
+		if (event.isTempo()) {
+			writeTempo(out, event.tick, event.tempo);
+		} else if (event.isNoteOn()) {
+			writeEvent(out, event.tick, 0x90 | event.channel, event.key,
+					event.velocity);
+		} else {
+			writeEvent(out, event.tick, 0x80 | event.channel, event.key, 0);
+		}
+	}, Tpq, Offset, Velocity);
+}
+
+
+
+//////////////////////////////
+//
+// writeEvent -- Write a three-byte MIDI message.  Events are given in
+//     time order, so the delta time is from the previous event.
+//
+
+void writeEvent(FILE* out, int tick, int b0, int b1, int b2) {
+	writeVlv(out, tick - LastTick);
+	LastTick = tick;
+	std::fputc(b0, out);
+	std::fputc(b1, out);
+	std::fputc(b2, out);
+}
+
+
+
+//////////////////////////////
+//
+// writeTempo -- Write a tempo meta message (tempo in quarter notes
+//     per minute).
+//
+
+void writeTempo(FILE* out, int tick, double tempo) {
+	if (tempo <= 0.0) {
+		return;
+	}
+	writeVlv(out, tick - LastTick);
+	LastTick = tick;
+	writeInt(out, 0xff5103, 3);
+	writeInt(out, (int)(60000000.0 / tempo + 0.5), 3);
+}
+
+
+
+//////////////////////////////
+//
+// writeVlv -- Write a variable-length value.
+//
+
+void writeVlv(FILE* out, int value) {
+	if (value < 0) {
+		value = 0;
+	}
+	int shift = 21;
+	while ((shift > 0) && !(value >> shift)) {
+		shift -= 7;
+	}
+	for ( ; shift > 0; shift -= 7) {
+		std::fputc(0x80 | ((value >> shift) & 0x7f), out);
+	}
+	std::fputc(value & 0x7f, out);
+}
+
+
+
+//////////////////////////////
+//
+// writeInt -- Write a big-endian integer with the given number of bytes.
+//
+
+void writeInt(FILE* out, int value, int bytes) {
+	for (int i=bytes-1; i>=0; i--) {
+		std::fputc((value >> (8 * i)) & 0xff, out);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// writeTrackLength -- Store the length of the track data after the
+//     track header.
+//
+
+void writeTrackLength(FILE* out, long start) {
+	long end = std::ftell(out);
+	std::fseek(out, start, SEEK_SET);
+	writeInt(out, (int)(end - start) - 4, 4);
+	std::fseek(out, end, SEEK_SET);
+}
+
+
+
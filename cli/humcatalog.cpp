@@ -0,0 +1,81 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 22:06:31 PDT 2026
+// Last Modified: Sun Oct 18 22:06:31 PDT 2026
+// Filename:      cli/humcatalog.cpp
+// URL:           https://github.com/craigsapp/humlib/blob/master/cli/humcatalog.cpp
+// Syntax:        C++11
+// vim:           ts=3 noexpandtab nowrap
+//
+// Description:   Make a catalog of the reference records of a corpus, or
+//                select files/segments from a catalog.
+//
+// Examples:
+//    humcatalog -o catalog.txt *.krn
+//    humcatalog -c catalog.txt -q "COM^=Bach; voices>=4"
+//    humcatalog -c catalog.txt -q "meter=3/4" -p | census
+//
+
+#include "humlib.h"
+
+using namespace std;
+using namespace hum;
+
+int main(int argc, char **argv) {
+	Options options;
+	options.define("c|catalog=s", "catalog file to query");
+	options.define("o|output=s", "write catalog to file");
+	options.define("q|query=s", "query conditions, such as \"COM^=Bach; voices>=4\"");
+	options.define("l|locations=b", "print offsets and segment names of matches");
+	options.define("p|print=b", "print contents of matches as a segmented stream");
+	options.define("f|fields=b", "list fields in catalog");
+	options.process(argc, argv);
+
+	HumCatalog catalog;
+	if (options.getBoolean("catalog")) {
+		if (!catalog.readCatalog(options.getString("catalog"))) {
+			return 1;
+		}
+	}
+	for (int i=1; i<=options.getArgCount(); i++) {
+		catalog.addFile(options.getArg(i));
+	}
+
+	if (options.getBoolean("output")) {
+		return catalog.writeCatalog(options.getString("output")) ? 0 : 1;
+	}
+	if (options.getBoolean("fields")) {
+		vector<string> fields = catalog.getFieldNames();
+		for (int i=0; i<(int)fields.size(); i++) {
+			cout << fields[i] << endl;
+		}
+		return 0;
+	}
+	if (!options.getBoolean("query")) {
+		catalog.printCatalog(cout);
+		return 0;
+	}
+
+	vector<int> entries = catalog.query(options.getString("query"));
+	for (int i=0; i<(int)entries.size(); i++) {
+		int entry = entries[i];
+		if (options.getBoolean("print")) {
+			HumdrumFile infile;
+			if (!catalog.readEntry(entry, infile)) {
+				continue;
+			}
+			cout << "!!!!SEGMENT: " << infile.getFilename() << endl;
+			cout << infile;
+		} else if (options.getBoolean("locations")) {
+			cout << catalog.getFilename(entry) << "\t" << catalog.getOffset(entry);
+			cout << "\t" << catalog.getSegment(entry) << endl;
+		} else {
+			cout << catalog.getFilename(entry) << endl;
+		}
+	}
+
+	return 0;
+}
+
+
+
@@ -0,0 +1,70 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 22:44:19 PDT 2026
+// Last Modified: Sun Oct 18 22:44:19 PDT 2026
+// Filename:      cli/humlyrics.cpp
+// URL:           https://github.com/craigsapp/humlib/blob/master/cli/humlyrics.cpp
+// Syntax:        C++11
+// vim:           ts=3 noexpandtab nowrap
+//
+// Description:   Make an index of the words in the lyrics of a corpus, or
+//                search for words in an index.
+//
+// Examples:
+//    humlyrics -o lyrics.txt *.krn
+//    humlyrics -i lyrics.txt -w "glori*"
+//    humlyrics -i lyrics.txt -r "^(kyrie|christe)$"
+//
+
+#include "humlib.h"
+
+using namespace std;
+using namespace hum;
+
+int main(int argc, char **argv) {
+	Options options;
+	options.define("i|index=s", "index file to search");
+	options.define("o|output=s", "write index to file");
+	options.define("w|wildcard=s", "search for words matching pattern with * and ?");
+	options.define("p|prefix=s", "search for words starting with text");
+	options.define("r|regex=s", "search for words matching regular expression");
+	options.process(argc, argv);
+
+	HumLyricIndex index;
+	if (options.getBoolean("index")) {
+		if (!index.readIndex(options.getString("index"))) {
+			return 1;
+		}
+	}
+	for (int i=1; i<=options.getArgCount(); i++) {
+		index.addFile(options.getArg(i));
+	}
+
+	if (options.getBoolean("output")) {
+		return index.writeIndex(options.getString("output")) ? 0 : 1;
+	}
+
+	vector<int> entries;
+	if (options.getBoolean("wildcard")) {
+		entries = index.findWildcard(options.getString("wildcard"));
+	} else if (options.getBoolean("prefix")) {
+		entries = index.findPrefix(options.getString("prefix"));
+	} else if (options.getBoolean("regex")) {
+		entries = index.findRegex(options.getString("regex"));
+	} else {
+		index.printIndex(cout);
+		return 0;
+	}
+
+	for (int i=0; i<(int)entries.size(); i++) {
+		const HumLyricEntry& entry = index.getEntry(entries[i]);
+		cout << index.getFilename(entry.file) << "\t" << entry.track;
+		cout << "\t" << entry.line + 1 << "\t" << entry.field + 1;
+		cout << "\t" << entry.word << endl;
+	}
+
+	return 0;
+}
+
+
+
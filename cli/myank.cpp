@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Wed Nov 30 20:35:56 PST 2016
-// Last Modified: Fri Dec  2 03:44:55 PST 2016
+// Last Modified: Sun Oct 18 20:41:09 PDT 2026
 // Filename:      cli/myank.cpp
 // URL:           https://github.com/craigsapp/humlib/blob/master/cli/myank.cpp
 // Syntax:        C++11
@@ -12,7 +12,7 @@
 
 #include "humlib.h"
 
-STREAM_INTERFACE(Tool_myank)
+PARALLEL_STREAM_INTERFACE(Tool_myank)
 
 
 
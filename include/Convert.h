@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Sat Aug  8 12:24:49 PDT 2015
-// Last Modified: Sun Aug  9 21:03:12 PDT 2015
+// Last Modified: Mon Oct 19 00:41:16 PDT 2026
 // Filename:      Convert.h
 // URL:           https://github.com/craigsapp/humlib/blob/master/include/Convert.h
 // Syntax:        C++11; humlib
@@ -255,6 +255,19 @@ class Convert {
 		static bool    isNaN                (double value);
 		static bool    isPowerOfTwo         (int value);
 		static double  pearsonCorrelation   (const std::vector<double> &x, const std::vector<double> &y);
+		static void    prepareCorrelationSums(std::vector<std::vector<long double>>& sums,
+		                                    const std::vector<double>& x,
+		                                    const std::vector<double>& y);
+		static double  windowCorrelation    (const std::vector<std::vector<long double>>& sums,
+		                                    int start, int length);
+		static double  windowCorrelation    (const std::vector<std::vector<long double>>& sums,
+		                                    const std::vector<double>& x,
+		                                    const std::vector<double>& y,
+		                                    int start, int length);
+		static void    correlationScape     (std::vector<std::vector<double>>& scape,
+		                                    const std::vector<double>& x,
+		                                    const std::vector<double>& y,
+		                                    int threads = 1);
 		static double  standardDeviation    (const std::vector<double>& x);
 		static double  standardDeviation    (const std::vector<int>& x);
 		static double  standardDeviationSample(const std::vector<double>& x);
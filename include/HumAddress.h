@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Sat Aug  8 12:24:49 PDT 2015
-// Last Modified: Sun Aug  9 21:19:53 PDT 2015
+// Last Modified: Sun Oct 18 18:52:10 PDT 2026
 // Filename:      HumAddress.h
 // URL:           https://github.com/craigsapp/humlib/blob/master/include/HumAddress.h
 // Syntax:        C++11; humlib
@@ -36,6 +36,7 @@ class HumAddress {
 		int                 getLineNumber     (void) const;
 		int                 getFieldIndex     (void) const;
 		const HumdrumToken& getDataType       (void) const;
+		int                 getDataTypeId     (void) const;
 		HTp                 getExclusiveInterpretation(void);
 		const std::string&  getSpineInfo      (void) const;
 		int                 getTrack          (void) const;
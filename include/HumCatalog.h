@@ -0,0 +1,108 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 21:58:14 PDT 2026
+// Last Modified: Sun Oct 18 21:58:14 PDT 2026
+// Filename:      HumCatalog.h
+// URL:           https://github.com/craigsapp/humlib/blob/master/include/HumCatalog.h
+// Syntax:        C++11; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Catalog of the reference records and basic spine
+//                information of a corpus, made by reading only the
+//                header of each file (or !!!!SEGMENT), for selecting
+//                files before parsing them.
+//
+
+#ifndef _HUMCATALOG_H_INCLUDED
+#define _HUMCATALOG_H_INCLUDED
+
+#include "HumdrumFile.h"
+
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace hum {
+
+// START_MERGE
+
+class HumCatalog {
+	public:
+		                 HumCatalog       (void);
+		                ~HumCatalog       ();
+
+		void             clear            (void);
+
+		// building the catalog:
+		bool             addFile          (const std::string& filename);
+		bool             addStream        (std::istream& input,
+		                                   const std::string& filename);
+
+		// reading/writing the catalog:
+		bool             readCatalog      (const std::string& filename);
+		bool             readCatalog      (std::istream& input);
+		bool             writeCatalog     (const std::string& filename);
+		std::ostream&    printCatalog     (std::ostream& out = std::cout);
+
+		// accessing entries:
+		int              getEntryCount    (void) const;
+		std::vector<std::string> getFieldNames(void) const;
+		bool             hasField         (const std::string& field) const;
+		const std::string& getValue       (int entry, const std::string& field) const;
+		const std::string& getFilename    (int entry) const;
+		const std::string& getSegment     (int entry) const;
+		int64_t          getOffset        (int entry) const;
+		bool             readEntry        (int entry, HumdrumFile& infile);
+
+		// queries (each returns the matching entry indexes in order):
+		std::vector<int> getAllEntries    (void) const;
+		std::vector<int> findEqual        (const std::string& field,
+		                                   const std::string& value) const;
+		std::vector<int> findPrefix       (const std::string& field,
+		                                   const std::string& prefix) const;
+		std::vector<int> findRange        (const std::string& field,
+		                                   double minimum, double maximum);
+		std::vector<int> query            (const std::string& expression);
+		static std::vector<int> intersect (const std::vector<int>& a,
+		                                   const std::vector<int>& b);
+
+	protected:
+		void             addEntry         (const std::string& filename,
+		                                   const std::string& segment, int64_t offset,
+		                                   std::map<std::string, std::string>& fields);
+		void             scanHeaderLine   (const std::string& line,
+		                                   std::map<std::string, std::string>& fields,
+		                                   bool& spinesQ, bool& doneQ);
+		const std::vector<double>& getNumbers(const std::string& field);
+		std::vector<int> queryCondition   (const std::string& condition);
+		static std::string escapeValue    (const std::string& value);
+		static std::string unescapeValue  (const std::string& value);
+
+	private:
+		// m_count: the number of entries (files or segments) in the catalog.
+		int m_count = 0;
+
+		// m_columns: the values of each field for every entry.  Entries
+		// without a field have an empty value.  The fields "filename",
+		// "segment" and "offset" give the location of the entry, and
+		// the fields "spines", "voices" (**kern spines), "meter", "keysig"
+		// and "key" are taken from the first spine lines.  Other fields
+		// are the keys of reference records.
+		std::map<std::string, std::vector<std::string>> m_columns;
+
+		// m_numbers: numeric values of the fields used in range queries
+		// (NAN for values that are not numbers), made when first needed.
+		std::map<std::string, std::vector<double>> m_numbers;
+};
+
+
+// END_MERGE
+
+} // end namespace hum
+
+#endif /* _HUMCATALOG_H_INCLUDED */
+
+
+
@@ -0,0 +1,70 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 18:20:44 PDT 2026
+// Last Modified: Sun Oct 18 18:20:44 PDT 2026
+// Filename:      HumDataType.h
+// URL:           https://github.com/craigsapp/humlib/blob/master/include/HumDataType.h
+// Syntax:        C++11; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Registry of exclusive interpretations, so that data types
+//                can be stored and compared as small integers.
+//
+
+#ifndef _HUMDATATYPE_H_INCLUDED
+#define _HUMDATATYPE_H_INCLUDED
+
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace hum {
+
+// START_MERGE
+
+// Data type IDs that are always registered (in this order).  Other
+// exclusive interpretations are given IDs after these when first seen.
+enum datatype_id {
+	datatype_unknown,      // no exclusive interpretation (empty string)
+	datatype_kern,         // **kern
+	datatype_mens,         // **mens
+	datatype_text,         // **text
+	datatype_recip,        // **recip
+	datatype_dynam,        // **dynam
+	datatype_builtin_count
+};
+
+class HumDataType {
+	public:
+		static int                getId       (const std::string& exinterp);
+		static int                findId      (const std::string& exinterp);
+		static const std::string& getName     (int id);
+		static int                getCount    (void);
+
+	protected:
+		// Registry -- The registered data types, shared by all threads.
+		class Registry {
+			public:
+				Registry(void);
+				int addName(const std::string& exinterp);
+				std::mutex mutex;
+				// names: the exclusive interpretation for each ID.  A deque
+				// keeps references to the names valid as more IDs are added.
+				std::deque<std::string> names;
+				// ids: the ID for each exclusive interpretation.
+				std::map<std::string, int> ids;
+		};
+
+		static Registry&          getRegistry (void);
+};
+
+
+// END_MERGE
+
+} // end namespace hum
+
+#endif /* _HUMDATATYPE_H_INCLUDED */
+
+
+
@@ -0,0 +1,72 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 15:02:44 PDT 2026
+// Last Modified: Sun Oct 18 15:02:44 PDT 2026
+// Filename:      HumKeyWindow.h
+// URL:           https://github.com/craigsapp/humlib/blob/master/include/HumKeyWindow.h
+// Syntax:        C++11; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Key analysis of a sliding window of pitch-class histograms.
+//
+
+#ifndef _HUMKEYWINDOW_H_INCLUDED
+#define _HUMKEYWINDOW_H_INCLUDED
+
+#include <cstddef>
+#include <vector>
+
+namespace hum {
+
+// START_MERGE
+
+class HumKeyWindow {
+	public:
+		             HumKeyWindow         (void);
+		            ~HumKeyWindow         () {};
+
+		void         setWeights           (const std::vector<double>& major,
+		                                   const std::vector<double>& minor);
+		static void  getKostkaPayneWeights(std::vector<double>& major,
+		                                   std::vector<double>& minor);
+
+		void         clear                (void);
+		void         addSegment           (const std::vector<double>& histogram);
+		void         removeSegment        (const std::vector<double>& histogram);
+		void         setWindow            (const std::vector<std::vector<double>>& segments,
+		                                   int start, int length);
+
+		const std::vector<double>& getHistogram(void) const;
+		bool         isEmpty              (void) const;
+		void         getCorrelations      (std::vector<double>& correls) const;
+		int          getBestKey           (void) const;
+
+	private:
+		// m_keyweights: the major and minor key weights, rotated to each
+		// tonic and normalized to a mean of zero and a length of one.
+		// Rows 0-11 are for major keys on C to B, and rows 12-23 are for
+		// minor keys.
+		double m_keyweights[24][12];
+
+		// m_histogram: pitch-class histogram of the current window.
+		std::vector<double> m_histogram;
+
+		// m_active: number of segments in the window that contain notes.
+		int m_active = 0;
+
+		// m_segments, m_start, m_end: segment list and range of the current
+		// window when using setWindow().
+		const std::vector<std::vector<double>>* m_segments = NULL;
+		int m_start = 0;
+		int m_end   = 0;
+};
+
+
+// END_MERGE
+
+} // end namespace hum
+
+#endif /* _HUMKEYWINDOW_H_INCLUDED */
+
+
+
@@ -0,0 +1,102 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 22:44:19 PDT 2026
+// Last Modified: Sun Oct 18 22:44:19 PDT 2026
+// Filename:      HumLyricIndex.h
+// URL:           https://github.com/craigsapp/humlib/blob/master/include/HumLyricIndex.h
+// Syntax:        C++11; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Inverted index of the words in the **text (or **silbe)
+//                spines of a corpus, for searching lyrics without
+//                reconstructing the words from their syllables for
+//                every query.
+//
+
+#ifndef _HUMLYRICINDEX_H_INCLUDED
+#define _HUMLYRICINDEX_H_INCLUDED
+
+#include "HumdrumFile.h"
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace hum {
+
+// START_MERGE
+
+// HumLyricEntry: A word in HumLyricIndex, and the location of its
+// first syllable.
+
+class HumLyricEntry {
+	public:
+		int         file  = 0;   // index of the file in the lyric index
+		int         track = 0;   // track of the text spine
+		int         line  = 0;   // line index of the first syllable
+		int         field = 0;   // field index of the first syllable
+		std::string word;        // word with syllable hyphens removed
+};
+
+
+class HumLyricIndex {
+	public:
+		                 HumLyricIndex    (void);
+		                ~HumLyricIndex    ();
+
+		void             clear            (void);
+
+		// building the index:
+		int              addFile          (HumdrumFile& infile);
+		bool             addFile          (const std::string& filename);
+
+		// reading/writing the index:
+		bool             readIndex        (const std::string& filename);
+		bool             readIndex        (std::istream& input);
+		bool             writeIndex       (const std::string& filename);
+		std::ostream&    printIndex       (std::ostream& out = std::cout);
+
+		// accessing entries:
+		int              getEntryCount    (void) const;
+		int              getFileCount     (void) const;
+		const std::string& getFilename    (int file) const;
+		const HumLyricEntry& getEntry     (int entry) const;
+		int              getNextEntry     (int entry) const;
+		HTp              getToken         (int entry, HumdrumFile& infile) const;
+
+		// queries (each returns the matching entry indexes in order,
+		// and ignores the case of letters):
+		std::vector<int> findWord         (const std::string& word) const;
+		std::vector<int> findPrefix       (const std::string& prefix) const;
+		std::vector<int> findWildcard     (const std::string& pattern) const;
+		std::vector<int> findRegex        (const std::string& exp) const;
+
+	protected:
+		void             addWordsForSpine (int file, HTp starttoken);
+		void             indexEntries     (int startentry);
+		static std::string foldCase       (const std::string& input);
+		static bool      wildcardMatch    (const char* pattern, const char* text);
+
+	private:
+		// m_filenames: the filenames (or !!!!SEGMENT names) of the files
+		// in the index.
+		std::vector<std::string> m_filenames;
+
+		// m_entries: the words of each file, in the order of the text spines
+		// and then of the lines in each spine.
+		std::vector<HumLyricEntry> m_entries;
+
+		// m_words: the entries of each word, with letters in lower case.
+		std::map<std::string, std::vector<int>> m_words;
+};
+
+
+// END_MERGE
+
+} // end namespace hum
+
+#endif /* _HUMLYRICINDEX_H_INCLUDED */
+
+
+
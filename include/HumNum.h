@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Sat Aug  8 12:24:49 PDT 2015
-// Last Modified: Sun Aug  9 21:03:12 PDT 2015
+// Last Modified: Sun Oct 18 19:24:37 PDT 2026
 // Filename:      HumNum.h
 // URL:           https://github.com/craigsapp/humlib/blob/master/include/HumNum.h
 // Syntax:        C++11; humlib
@@ -13,6 +13,7 @@
 #ifndef _HUMNUM_H_INCLUDED
 #define _HUMNUM_H_INCLUDED
 
+#include <cstdint>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -111,7 +112,66 @@ class HumNum {
 };
 
 
+
+
+// HumNum64: Rational number with 64-bit numerator and denominator.  All
+// arithmetic is checked for overflow.  A result that cannot be represented
+// becomes NaN (0/0), and stays NaN in further calculations, rather than
+// wrapping around silently as HumNum does.
+
+class HumNum64 {
+	public:
+		         HumNum64           (void);
+		         HumNum64           (int64_t value);
+		         HumNum64           (int64_t numerator, int64_t denominator);
+		         HumNum64           (const HumNum& value);
+		        ~HumNum64           () {}
+
+		bool     isNaN              (void) const;
+		bool     isNegative         (void) const;
+		bool     isPositive         (void) const;
+		bool     isZero             (void) const;
+		bool     isInteger          (void) const;
+		int64_t  getNumerator       (void) const { return top; }
+		int64_t  getDenominator     (void) const { return bot; }
+		double   getFloat           (void) const;
+		bool     getHumNum          (HumNum& output) const;
+		bool     getTicks           (int64_t tpq, int64_t& ticks) const;
+		void     setValue           (int64_t numerator, int64_t denominator);
+		HumNum64 operator+          (const HumNum64& value) const;
+		HumNum64 operator-          (const HumNum64& value) const;
+		HumNum64 operator-          (void) const;
+		HumNum64 operator*          (const HumNum64& value) const;
+		HumNum64 operator/          (const HumNum64& value) const;
+		HumNum64& operator+=        (const HumNum64& value);
+		HumNum64& operator-=        (const HumNum64& value);
+		HumNum64& operator*=        (const HumNum64& value);
+		HumNum64& operator/=        (const HumNum64& value);
+		bool     operator==         (const HumNum64& value) const;
+		bool     operator!=         (const HumNum64& value) const;
+		bool     operator<          (const HumNum64& value) const;
+		bool     operator<=         (const HumNum64& value) const;
+		bool     operator>          (const HumNum64& value) const;
+		bool     operator>=         (const HumNum64& value) const;
+		std::ostream& printFraction (std::ostream& out = std::cout) const;
+
+		static bool    add          (int64_t a, int64_t b, int64_t& output);
+		static bool    subtract     (int64_t a, int64_t b, int64_t& output);
+		static bool    multiply     (int64_t a, int64_t b, int64_t& output);
+		static bool    lcm          (int64_t a, int64_t b, int64_t& output);
+		static int64_t gcd          (int64_t a, int64_t b);
+
+	protected:
+		int      compare            (const HumNum64& value) const;
+
+	private:
+		int64_t top;
+		int64_t bot;
+};
+
+
 std::ostream& operator<<(std::ostream& out, const HumNum& number);
+std::ostream& operator<<(std::ostream& out, const HumNum64& number);
 
 template <typename A>
 std::ostream& operator<<(std::ostream& out, const std::vector<A>& v);
@@ -0,0 +1,104 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 17:42:19 PDT 2026
+// Last Modified: Sun Oct 18 17:42:19 PDT 2026
+// Filename:      HumSonority.h
+// URL:           https://github.com/craigsapp/humlib/blob/master/include/HumSonority.h
+// Syntax:        C++11; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Pitch-class set of a sonority stored as bitmasks, with
+//                chord classification by table lookup.
+//
+
+#ifndef _HUMSONORITY_H_INCLUDED
+#define _HUMSONORITY_H_INCLUDED
+
+#include <cstdint>
+#include <vector>
+
+namespace hum {
+
+// START_MERGE
+
+// Chord types for a 12-tone pitch-class set:
+enum sonority_type {
+	sonority_empty,        // no pitch classes
+	sonority_unison,       // one pitch class
+	sonority_minor_third,  // minor third or major sixth
+	sonority_major_third,  // major third or minor sixth
+	sonority_fifth,        // perfect fifth or perfect fourth
+	sonority_tritone,      // augmented fourth/diminished fifth
+	sonority_dyad,         // other two pitch classes (seconds and sevenths)
+	sonority_major,        // major triad
+	sonority_minor,        // minor triad
+	sonority_diminished,   // diminished triad
+	sonority_augmented,    // augmented triad
+	sonority_trichord,     // other three pitch classes
+	sonority_large         // more than three pitch classes
+};
+
+class HumSonority {
+	public:
+		                HumSonority        (void) {};
+		               ~HumSonority        () {};
+
+		void            clear              (void);
+		bool            isEmpty            (void) const;
+		void            addMidi            (int midi);
+		void            addDiatonic        (int base7);
+		void            addBase40          (int base40);
+		void            setBass            (int midi);
+
+		int             getPitchClassMask  (void) const { return m_pcmask;  }
+		int             getDiatonicMask    (void) const { return m_b7mask;  }
+		uint64_t        getBase40Mask      (void) const { return m_b40mask; }
+		bool            hasPitchClass      (int pc) const;
+		bool            hasDiatonic        (int base7) const;
+		bool            hasBase40          (int base40) const;
+		int             getPitchClassCount (void) const;
+		int             getBass            (void) const { return m_bass;    }
+
+		int             getType            (void) const;
+		int             getRoot            (void) const;
+		int             getThird           (void) const;
+		int             getFifth           (void) const;
+		int             getPosition        (int midi) const;
+		int             getInversion       (void) const;
+
+		static int      getType            (int pcmask);
+		static int      getRoot            (int pcmask);
+		static int      getThird           (int pcmask);
+		static int      getFifth           (int pcmask);
+		static int      getPosition        (int pcmask, int midi);
+		static bool     isTriad            (int type);
+		static int      countBits          (uint64_t mask);
+
+	protected:
+		static void     prepareChordTable  (std::vector<uint32_t>& table);
+		static uint32_t analyzeMask        (int pcmask);
+		static uint32_t getChordEntry      (int pcmask);
+
+	private:
+		// m_pcmask: bit n is set if pitch class n (C=0) is present.
+		int m_pcmask = 0;
+
+		// m_b7mask: bit n is set if diatonic pitch class n (C=0) is present.
+		int m_b7mask = 0;
+
+		// m_b40mask: bit n is set if base-40 pitch class n (C=0) is present.
+		uint64_t m_b40mask = 0;
+
+		// m_bass: pitch class of the bass, or -1 if not set.
+		int m_bass = -1;
+};
+
+
+// END_MERGE
+
+} // end namespace hum
+
+#endif /* _HUMSONORITY_H_INCLUDED */
+
+
+
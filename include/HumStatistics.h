@@ -0,0 +1,68 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 16:41:07 PDT 2026
+// Last Modified: Sun Oct 18 16:41:07 PDT 2026
+// Filename:      HumStatistics.h
+// URL:           https://github.com/craigsapp/humlib/blob/master/include/HumStatistics.h
+// Syntax:        C++11; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Named counters for collecting analysis statistics over
+//                many files.  Counters from separate workers can be merged
+//                and printed as a JSON summary.
+//
+
+#ifndef _HUMSTATISTICS_H_INCLUDED
+#define _HUMSTATISTICS_H_INCLUDED
+
+#include <map>
+#include <ostream>
+#include <string>
+
+namespace hum {
+
+// START_MERGE
+
+class HumStatistics {
+	public:
+		             HumStatistics     (void) {};
+		            ~HumStatistics     () {};
+
+		void         clear             (void);
+		bool         isEmpty           (void) const;
+
+		void         addFile           (void);
+		int          getFileCount      (void) const;
+
+		void         increment         (const std::string& group,
+		                                const std::string& key,
+		                                double amount = 1.0);
+		double       getValue          (const std::string& group,
+		                                const std::string& key) const;
+
+		void         merge             (const HumStatistics& other);
+		void         printJson         (std::ostream& out,
+		                                const std::string& name = "") const;
+
+	protected:
+		static void  printJsonString   (std::ostream& out,
+		                                const std::string& text);
+		static void  printJsonNumber   (std::ostream& out, double value);
+
+	private:
+		// m_files: the number of files that were analyzed.
+		int m_files = 0;
+
+		// m_counters: counter values, grouped by category and then by name.
+		std::map<std::string, std::map<std::string, double>> m_counters;
+};
+
+
+// END_MERGE
+
+} // end namespace hum
+
+#endif /* _HUMSTATISTICS_H_INCLUDED */
+
+
+
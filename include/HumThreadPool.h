@@ -0,0 +1,89 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 13:05:31 PDT 2026
+// Last Modified: Sun Oct 18 13:05:31 PDT 2026
+// Filename:      HumThreadPool.h
+// URL:           https://github.com/craigsapp/humlib/blob/master/include/HumThreadPool.h
+// Syntax:        C++11; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   A small set of persistent worker threads for running
+//                independent tasks of an analysis in parallel.
+//
+
+#ifndef _HUMTHREADPOOL_H_INCLUDED
+#define _HUMTHREADPOOL_H_INCLUDED
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hum {
+
+// START_MERGE
+
+class HumThreadPool {
+	public:
+		            HumThreadPool      (int threads = 0);
+		           ~HumThreadPool      ();
+
+		int         getThreadCount     (void) const;
+		void        run                (int count,
+		                                const std::function<void(int)>& task);
+
+		static int  getHardwareThreads (void);
+
+	protected:
+		void        workerLoop         (void);
+		void        doTasks            (void);
+
+	private:
+		// m_workers: the worker threads (the thread calling run() also
+		// processes tasks, so there is one less worker than the thread count).
+		std::vector<std::thread> m_workers;
+
+		// m_runMutex: Allow only one run() at a time.
+		std::mutex m_runMutex;
+
+		// m_mutex, m_wake, m_finished: Synchronization between run()
+		// and the workers.
+		std::mutex m_mutex;
+		std::condition_variable m_wake;
+		std::condition_variable m_finished;
+
+		// m_task: the task for the current run, called with the task index.
+		const std::function<void(int)>* m_task = NULL;
+
+		// m_count: the number of tasks in the current run.
+		int m_count = 0;
+
+		// m_next: the next task index to process.
+		std::atomic<int> m_next;
+
+		// m_busy: the number of workers still processing the current run.
+		int m_busy = 0;
+
+		// m_generation: incremented for each run so that workers know
+		// when new tasks are available.
+		int m_generation = 0;
+
+		// m_stop: set when the workers should exit.
+		bool m_stop = false;
+
+		// m_error: the first exception thrown by a task.
+		std::exception_ptr m_error;
+};
+
+
+// END_MERGE
+
+} // end namespace hum
+
+#endif /* _HUMTHREADPOOL_H_INCLUDED */
+
+
+
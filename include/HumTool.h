@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Mon Nov 28 08:55:15 PST 2016
-// Last Modified: Mon Nov 28 08:55:38 PST 2016
+// Last Modified: Mon Oct 19 01:16:38 PDT 2026
 // Filename:      HumTool.h
 // URL:           https://github.com/craigsapp/humlib/blob/master/include/HumTool.h
 // Syntax:        C++11; humlib
@@ -57,6 +57,8 @@ class HumTool : public Options {
 		void          setError        (const std::string& message);
 
 		virtual void  finally         (void) { };
+		virtual bool  isReusable      (void);
+		virtual int   getSegmentBatchSize(void);
 
 	protected:
 		std::stringstream m_humdrum_text;  // output text in Humdrum syntax.
@@ -164,20 +166,30 @@ int main(int argc, char** argv) {                      \
 //////////////////////////////
 //
 // STREAM_INTERFACE -- Use HumdrumFileStream (low-memory
-//    usage implementation).
+//    usage implementation).  Only one segment is kept in memory.  With
+//    the --prefetch option, the text of the next segment is read ahead in
+//    a separate thread while the current segment is processed.  Tools
+//    which process several segments at a time read them in batches (see
+//    HumTool::getSegmentBatchSize()).
 //
 
 #define STREAM_INTERFACE(CLASS)                                            \
 int main(int argc, char** argv) {                                          \
 	hum::CLASS interface;                                                   \
+	interface.define("prefetch=b",                                          \
+			"read the next segment while processing the current one");        \
 	if (!interface.process(argc, argv)) {                                   \
 		interface.getError(std::cerr);                                       \
 		return -1;                                                           \
 	}                                                                       \
 	hum::HumdrumFileStream instream(static_cast<hum::Options&>(interface)); \
+	if (interface.getBoolean("prefetch")) {                                 \
+		instream.setPrefetch();                                              \
+	}                                                                       \
 	hum::HumdrumFileSet infiles;                                            \
+	int batchsize = interface.getSegmentBatchSize();                        \
 	bool status = true;                                                     \
-	while (instream.readSingleSegment(infiles)) {                           \
+	while (instream.readSegments(infiles, batchsize)) {                     \
 		status &= interface.run(infiles);                                    \
 	}                                                                       \
 	interface.finally();                                                    \
@@ -202,6 +214,102 @@ int main(int argc, char** argv) {                                          \
 
 
 
+//////////////////////////////
+//
+// PARALLEL_STREAM_INTERFACE -- Same as STREAM_INTERFACE, but the segments
+//    are parsed and processed in parallel, each segment with a new
+//    instance of the tool.  Output is printed in input order (Humdrum text
+//    as each batch of segments finishes, then JSON and free text).
+//    Segments are read in batches to limit memory usage.  The options are
+//    parsed once, and the parsed options are copied to the tool instance
+//    of each segment.  The --threads option sets the number of threads
+//    (0 = all hardware threads).
+//
+//    Only use for tools that process each segment independently: finally()
+//    is called for each segment, and nothing is kept between segments, so
+//    tools which accumulate results over all segments (such as statistics
+//    or corpus summaries printed by finally()) must use STREAM_INTERFACE.
+//
+
+#define PARALLEL_STREAM_INTERFACE(CLASS)                                   \
+int main(int argc, char** argv) {                                          \
+	hum::CLASS interface;                                                   \
+	interface.define("threads=i:0",                                         \
+			"number of threads (0 = all hardware threads)");                  \
+	if (!interface.process(argc, argv)) {                                   \
+		interface.getError(std::cerr);                                       \
+		return -1;                                                           \
+	}                                                                       \
+	hum::HumdrumFileStream instream(static_cast<hum::Options&>(interface)); \
+	struct SegmentOutput {                                                  \
+		std::string humdrum, json, free, warning, error;                     \
+		bool text = false;                                                   \
+		bool status = true;                                                  \
+	};                                                                      \
+	hum::HumThreadPool pool(interface.getInteger("threads"));              \
+	int batchsize = 4 * pool.getThreadCount();                              \
+	std::vector<hum::HumdrumFileSet> infiles(batchsize);                    \
+	std::vector<std::stringstream> contents(batchsize);                     \
+	std::vector<SegmentOutput> output(batchsize);                           \
+	std::stringstream jsontext;                                             \
+	std::stringstream freetext;                                             \
+	std::stringstream errortext;                                            \
+	bool anytext = false;                                                   \
+	bool status = true;                                                     \
+	int last = -1;                                                          \
+	int count;                                                              \
+	do {                                                                    \
+		for (count=0; count<batchsize; count++) {                            \
+			hum::HumdrumFile* infile = new hum::HumdrumFile;                  \
+			if (!instream.getFileText(*infile, contents[count])) {            \
+				delete infile;                                                 \
+				break;                                                         \
+			}                                                                 \
+			infiles[count].clear();                                           \
+			infiles[count].appendHumdrumPointer(infile);                      \
+			last = count;                                                     \
+		}                                                                    \
+		pool.run(count, [&](int index) {                                     \
+			hum::HumdrumFileStream::parseFileText(infiles[index][0],          \
+					contents[index]);                                           \
+			hum::CLASS tool;                                                  \
+			static_cast<hum::Options&>(tool) = interface;                     \
+			SegmentOutput& out = output[index];                               \
+			out.status  = tool.run(infiles[index]);                           \
+			tool.finally();                                                   \
+			out.text    = tool.hasAnyText();                                  \
+			out.humdrum = tool.getHumdrumText();                              \
+			out.json    = tool.getJsonText();                                 \
+			out.free    = tool.getFreeText();                                 \
+			out.warning = tool.getWarning();                                  \
+			out.error   = tool.getError();                                    \
+		});                                                                  \
+		for (int i=0; i<count; i++) {                                        \
+			std::cerr << output[i].warning;                                   \
+			std::cout << output[i].humdrum;                                   \
+			jsontext  << output[i].json;                                      \
+			freetext  << output[i].free;                                      \
+			errortext << output[i].error;                                     \
+			anytext |= output[i].text;                                        \
+			status  &= output[i].status;                                      \
+		}                                                                    \
+	} while (count == batchsize);                                           \
+	std::cout << jsontext.str();                                            \
+	std::cout << freetext.str();                                            \
+	if (!errortext.str().empty()) {                                         \
+		std::cerr << errortext.str();                                        \
+		return -1;                                                           \
+	}                                                                       \
+	if (!anytext && (last >= 0)) {                                          \
+		for (int i=0; i<infiles[last].getCount(); i++) {                     \
+			std::cout << infiles[last][i];                                    \
+		}                                                                    \
+	}                                                                       \
+	return !status;                                                         \
+}
+
+
+
 //////////////////////////////
 //
 // RAW_STREAM_INTERFACE -- Use HumdrumFileStream but send the
@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Sat Aug  8 12:24:49 PDT 2015
-// Last Modified: Thu Jun 13 08:38:17 CEST 2019
+// Last Modified: Mon Oct 19 00:58:12 PDT 2026
 // Filename:      HumdrumFileBase.h
 // URL:           https://github.com/craigsapp/humlib/blob/master/include/HumdrumFileBase.h
 // Syntax:        C++11; humlib
@@ -18,10 +18,15 @@
 #ifndef _HUMDRUMFILEBASE_H_INCLUDED
 #define _HUMDRUMFILEBASE_H_INCLUDED
 
+#include "HumDataType.h"
 #include "HumSignifiers.h"
+#include "HumThreadPool.h"
 #include "HumdrumLine.h"
 
+#include <functional>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <string>
 #include <sstream>
 #include <vector>
@@ -38,6 +43,7 @@
 	#include <netdb.h>       /* gethostbyname   */
 	#include <unistd.h>      /* read, write     */
 	#include <string.h>      /* memcpy          */
+	#include <sys/stat.h>    /* mkdir, stat     */
 	#include <sstream>
 #endif
 
@@ -111,6 +117,10 @@ class HumFileAnalysis {
 
 			m_barlines_analyzed  = false;
 			m_barlines_different = false;
+
+			m_slices_analyzed    = false;
+			m_references_analyzed = false;
+			m_metric_analyzed    = false;
 		}
 
 		// m_structure_analyzed: Used to keep track of whether or not
@@ -152,11 +162,58 @@ class HumFileAnalysis {
 		// any barlines that are not all of the same at the same
 		// times.
 		bool m_barlines_different = false;
+
+		// m_slices_analyzed: Used to keep track of whether or not the
+		// **kern field lists of HumdrumFileContent are up to date.
+		bool m_slices_analyzed = false;
+
+		// m_references_analyzed: Used to keep track of whether or not the
+		// index of reference records is up to date.
+		bool m_references_analyzed = false;
+
+		// m_metric_analyzed: Used to keep track of whether or not the
+		// metric positions of HumdrumFileContent are up to date.
+		bool m_metric_analyzed = false;
 };
 
 bool sortTokenPairsByLineIndex(const TokenPair& a, const TokenPair& b);
 
 
+// HumHttpReader: buffered reader for HTTP responses from a socket.  Data
+// is read from the socket in blocks, and any bytes read past the end of
+// the response header are kept for reading the body of the response.
+// Only used when USING_URI is defined.
+
+class HumHttpReader {
+	public:
+		              HumHttpReader   (int socket_id) { m_socket = socket_id; }
+		             ~HumHttpReader   () {}
+		bool          readLine        (std::string& line);
+		int           read            (char* buffer, int size);
+		int           getSocket       (void) { return m_socket; }
+
+	private:
+		int           fill            (void);
+
+		int  m_socket = -1;
+		int  m_index  = 0;
+		int  m_length = 0;
+		char m_buffer[8192];
+};
+
+
+// HumHttpConnections: keep-alive sockets for downloading data from the
+// web, indexed by "hostname:port".  The sockets are closed when the
+// object is destroyed, such as at the end of the thread that owns it.
+// Only used when USING_URI is defined.
+
+class HumHttpConnections : public std::map<std::string, int> {
+	public:
+		             ~HumHttpConnections ();
+		void          closeAll           (void);
+};
+
+
 class HumdrumFileBase : public HumHash {
 	public:
 		              HumdrumFileBase          (void);
@@ -193,6 +250,8 @@ class HumdrumFileBase : public HumHash {
 		bool          areStrandsAnalyzed       (void);
 		bool          areStrophesAnalyzed      (void);
 		void          setFilenameFromSegment   (void);
+		void          setAnalysisThreads       (int count);
+		int           getAnalysisThreads       (void) const;
 
     	template <class TYPE>
 		   void       initializeArray          (std::vector<std::vector<TYPE>>& array, TYPE value);
@@ -205,13 +264,13 @@ class HumdrumFileBase : public HumHash {
 		                                    { return readString(contents); }
 		bool          parseCsv                 (std::istream& contents,
 		                                        const std::string& separator = ",")
-		                                    { return readCsv(contents); }
+		                                    { return readCsv(contents, separator); }
 		bool          parseCsv                 (const char* contents,
 		                                        const std::string& separator = ",")
-		                                    { return readStringCsv(contents); }
+		                                    { return readStringCsv(contents, separator); }
 		bool          parseCsv                 (const std::string& contents,
 		                                        const std::string& separator = ",")
-		                                    { return readStringCsv(contents); }
+		                                    { return readStringCsv(contents, separator); }
 
 		void          setXmlIdPrefix           (const std::string& value);
 		std::string   getXmlIdPrefix           (void);
@@ -251,12 +310,17 @@ class HumdrumFileBase : public HumHash {
 
 		bool          analyzeNonNullDataTokens (void);
 		HTp           getTrackStart            (int track) const;
+		int           getTrackDataType         (int track) const;
+		const std::vector<int>& getTrackDataTypes (void) const;
+		void          updateTrackDataType      (int track);
 		void          getSpineStopList         (std::vector<HTp>& spinestops);
 		HTp           getSpineStart            (int spine) const
 		                                       { return getTrackStart(spine+1); }
 		void          getSpineStartList        (std::vector<HTp>& spinestarts);
 		void          getSpineStartList        (std::vector<HTp>& spinestarts,
 		                                        const std::string& exinterp);
+		void          getSpineStartList        (std::vector<HTp>& spinestarts,
+		                                        int datatype);
 		void          getSpineStartList        (std::vector<HTp>& spinestarts,
 		                                        const std::vector<std::string>& exinterps);
 		void          getKernSpineStartList    (std::vector<HTp>& spinestarts);
@@ -312,7 +376,10 @@ class HumdrumFileBase : public HumHash {
 		std::vector<HLp> getReferenceRecords(void);
 		std::vector<HLp> getGlobalReferenceRecords(void);
 		std::vector<HLp> getUniversalReferenceRecords(void);
+		std::vector<HLp> getReferenceRecords(const std::string& key);
 		std::string getReferenceRecord(const std::string& key);
+		void          analyzeReferenceRecords  (void);
+		void          clearReferenceRecords    (void);
 
 		// spine analysis functionality:
 		void          getTrackSequence         (std::vector<std::vector<HTp> >& sequence,
@@ -346,6 +413,10 @@ class HumdrumFileBase : public HumHash {
 		void          readFromHttpUri           (const std::string& webaddress);
 		static void   readStringFromHttpUri     (std::stringstream& inputdata,
 		                                         const std::string& webaddress);
+		static void   setUriCacheDirectory      (const std::string& directory);
+		static std::string getUriCacheDirectory (void);
+		static void   setUriCacheMaxAge         (int seconds);
+		static void   closeHttpConnections      (void);
 
 		bool          analyzeBaseFromLines     (void);
 		bool          analyzeBaseFromTokens    (void);
@@ -357,13 +428,34 @@ class HumdrumFileBase : public HumHash {
 		bool          analyzeLines              (void);
 
 	protected:
-		static int    getChunk                  (int socket_id,
+		static int    getChunk                  (HumHttpReader& reader,
 		                                         std::stringstream& inputdata,
 		                                         char* buffer, int bufsize);
-		static int    getFixedDataSize          (int socket_id,
+		static int    getFixedDataSize          (HumHttpReader& reader,
 		                                         int datalength,
 		                                         std::stringstream& inputdata,
 		                                         char* buffer, int bufsize);
+		static bool   requestHttpUri            (std::stringstream& inputdata,
+		                                         const std::string& hostname,
+		                                         unsigned short int port,
+		                                         const std::string& location,
+		                                         const std::string& etag,
+		                                         int& status, std::string& newetag,
+		                                         int& maxage);
+		static int    getHttpConnection         (const std::string& hostname,
+		                                         unsigned short int port,
+		                                         bool& reusedQ);
+		static void   dropHttpConnection        (const std::string& hostname,
+		                                         unsigned short int port);
+		static std::string getUriCacheKey       (const std::string& contents);
+		static bool   readUriCache              (const std::string& webaddress,
+		                                         std::string& contents,
+		                                         std::string& etag,
+		                                         bool& expiredQ);
+		static void   writeUriCache             (const std::string& webaddress,
+		                                         const std::string& contents,
+		                                         const std::string& etag,
+		                                         int maxage);
 		static void   prepare_address           (struct sockaddr_in *address,
 		                                         const std::string& hostname,
 		                                         unsigned short int port);
@@ -379,16 +471,21 @@ class HumdrumFileBase : public HumHash {
 		bool          stitchLinesTogether       (HumdrumLine& previous,
 		                                         HumdrumLine& next);
 		void          addToTrackStarts          (HTp token);
+		void          prepareReferenceRecords   (void);
 		void          addUniqueTokens           (std::vector<HTp>& target,
 		                                         std::vector<HTp>& source);
 		bool          processNonNullDataTokensForTrackForward(HTp starttoken,
 		                                         std::vector<HTp> ptokens);
 		bool          processNonNullDataTokensForTrackBackward(HTp starttoken,
 		                                         std::vector<HTp> ptokens);
+		bool          readCsvText               (const char* contents, size_t length,
+		                                         const std::string& separator);
 		bool          setParseError             (std::stringstream& err);
 		bool          setParseError             (const std::string& err);
 		bool          setParseError             (const char* format, ...);
 //		void          fixMerges                 (int linei);
+		void          runParallel               (int count,
+		                                         const std::function<void(int)>& task);
 
 	protected:
 
@@ -408,6 +505,19 @@ class HumdrumFileBase : public HumHash {
 		// size of this list.
 		std::vector<HTp> m_trackstarts;
 
+		// m_trackdatatypes: the HumDataType ID of the exclusive
+		// interpretation for each entry in m_trackstarts.
+		std::vector<int> m_trackdatatypes;
+
+		// m_referencelines: the line indexes of the reference records
+		// (global and universal) in the file.
+		std::vector<int> m_referencelines;
+
+		// m_referencekeys: the line indexes of the reference records for
+		// each reference key.  m_referencelines and m_referencekeys are
+		// filled by analyzeReferenceRecords() when first needed.
+		std::map<std::string, std::vector<int>> m_referencekeys;
+
 		// m_trackends: list of the addresses of the spine terminators in the
 		// file. It is possible that spines can split and their subspines do not
 		// merge before termination; therefore, the ends are stored in
@@ -456,6 +566,29 @@ class HumdrumFileBase : public HumHash {
 		// m_analysis: Used to keep track of analysis states for the file.
 		HumFileAnalysis m_analyses;
 
+		// m_analysisThreads: Number of threads used for per-spine analyses.
+		// The default of 1 does all analysis in the calling thread.
+		int m_analysisThreads = 1;
+
+		// m_threadPool: Worker threads for per-spine analyses, created
+		// when first needed if m_analysisThreads is greater than 1.
+		std::shared_ptr<HumThreadPool> m_threadPool;
+
+		// m_httpConnections: Open keep-alive sockets for downloading
+		// data from the web, indexed by "hostname:port".  Each thread
+		// has its own connections, so a socket is never shared by
+		// two requests at the same time.
+		static thread_local HumHttpConnections m_httpConnections;
+
+		// m_uriCacheDirectory: Directory for storing downloaded files.
+		// If empty, then the HUMLIB_URI_CACHE environment variable will
+		// be used, and if that is not set, no caching is done.
+		static std::string m_uriCacheDirectory;
+
+		// m_uriCacheMaxAge: Default number of seconds that a cached
+		// download is considered fresh (if server does not specify).
+		static int m_uriCacheMaxAge;
+
 	public:
 		// Dummy functions to allow the HumdrumFile class's inheritance
 		// to be shifted between HumdrumFileContent (the top-level default),
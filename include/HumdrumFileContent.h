@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Mon Aug 17 02:39:28 PDT 2015
-// Last Modified: Fri Dec  6 19:27:27 PST 2019
+// Last Modified: Sun Oct 18 22:31:07 PDT 2026
 // Filename:      HumdrumFileContent.h
 // URL:           https://github.com/craigsapp/humlib/blob/master/include/HumdrumFileContent.h
 // Syntax:        C++11; humlib
@@ -18,6 +18,7 @@
 
 #include <iostream>
 #include <cmath>
+#include <functional>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -27,6 +28,41 @@ namespace hum {
 
 // START_MERGE
 
+// HumMidiEvent: A note-on, note-off or tempo event generated by
+// HumdrumFileContent::getMidiEvents().
+
+class HumMidiEvent {
+	public:
+		int    tick     = 0;     // absolute time in ticks
+		int    track    = 0;     // **kern spine index (0 = first **kern spine)
+		int    channel  = 0;     // MIDI channel
+		int    key      = 0;     // MIDI key number
+		int    velocity = 0;     // note-on attack velocity (0 = note-off)
+		double tempo    = 0.0;   // if > 0, tempo change in quarter notes per minute
+		HTp    token    = NULL;  // token for the note (NULL for tempo)
+		int    subtoken = 0;     // index of note in chord token
+
+		bool   isTempo   (void) const { return tempo > 0.0; }
+		bool   isNoteOn  (void) const { return (tempo <= 0.0) && (velocity > 0); }
+		bool   isNoteOff (void) const { return (tempo <= 0.0) && (velocity == 0); }
+};
+
+
+// HumMetricPosition: The metric position of a line, from
+// HumdrumFileContent::getMetricPosition().
+
+class HumMetricPosition {
+	public:
+		int    measure = 0;    // measure index (0 = before the first barline)
+		int    beat    = 0;    // beat in the measure (0 = first beat)
+		int    ticks   = 0;    // ticks (see tpq()) from the start of the measure
+		int    weight  = -1;   // 2 = whole-note, 1 = half-note, 0 = quarter-note
+		                       // position in the measure, -1 = otherwise
+		double level   = NAN;  // metric level (see getMetricLevels()), or NAN
+		                       // for non-data lines
+};
+
+
 class HumdrumFileContent : public HumdrumFileStructure {
 	public:
 		       HumdrumFileContent         (void);
@@ -44,6 +80,9 @@ class HumdrumFileContent : public HumdrumFileStructure {
 		bool   analyzeMensAccidentals     (void);
 		bool   analyzeRScale              (void);
 
+		// in HumdrumFileContent-notation.cpp
+		bool   analyzeNotation            (void);
+
 		// in HumdrumFileContent-hand.cpp
 		bool   doHandAnalysis             (bool attacksOnlyQ = false);
 		bool   doHandAnalysis             (HTp startSpine, bool attacksOnlyQ = false);
@@ -51,9 +90,18 @@ class HumdrumFileContent : public HumdrumFileStructure {
 		// in HumdrumFileContent-kern.cpp
 		std::vector<int> getTrackToKernIndex (void);
 
+		// in HumdrumFileContent-slice.cpp
+		void   analyzeSlices              (void);
+		const std::vector<int>& getKernFieldIndexes (int line);
+		const std::vector<int>& getFieldToKernSpine (int line);
+		int    getFieldKernSpine          (int line, int field);
+
 		// in HumdrumFileContent-midi.cpp
 		void fillMidiInfo(std::vector<std::vector<std::vector<std::pair<HTp, int>>>>& trackMidi);
 		void processStrandNotesForMidi(HTp sstart, HTp send, std::vector<std::vector<std::pair<HTp, int>>>& trackInfo);
+		int  getMidiEvents            (std::function<void(const HumMidiEvent&)> callback,
+		                               int tpq = 0, int tickoffset = 0,
+		                               int velocity = 64);
 
 		// in HumdrumFileContent-rest.cpp
 		void  analyzeRestPositions                  (void);
@@ -66,6 +114,9 @@ class HumdrumFileContent : public HumdrumFileStructure {
 		// in HumdrumFileContent-metlev.cpp
 		void  getMetricLevels             (std::vector<double>& output, int track = 0,
 		                                   double undefined = NAN);
+		void  analyzeMetricPositions      (void);
+		const HumMetricPosition& getMetricPosition (int line);
+		int   getMetricTrack              (void);
 		// in HumdrumFileContent-timesig.cpp
 		void  getTimeSigs                 (std::vector<std::pair<int, HumNum> >& output,
 		                                   int track = 0);
@@ -112,6 +163,73 @@ class HumdrumFileContent : public HumdrumFileStructure {
 
 	protected:
 
+		// SpanState -- Bookkeeping for linking slur, phrase or beam markers
+		// in a spine (see analyzeSpanMarkers()).
+		class SpanState {
+			public:
+				SpanState(char opener, const std::string& linksig);
+				char        open;         // '(' for slurs, '{' for phrases, 'L' for beams
+				char        close;        // ')' for slurs, '}' for phrases, 'J' for beams
+				std::string name;         // "Slur", "Phrase" or "Beam"
+				std::string prefix;       // "slur", "phrase" or "beam"
+				std::string ignorebegin;  // linked marker start sequence
+				std::string ignoreend;    // linked marker end sequence
+				// opens == unclosed markers: first dimension is elision level,
+				// second dimension is the layer in the spine.
+				std::vector<std::vector<std::vector<HTp>>> opens;
+				std::vector<HTp> linkstarts;
+				std::vector<HTp> linkends;
+		};
+
+		// TieState -- Bookkeeping for linking linked ties (see analyzeKernTieToken()).
+		class TieState {
+			public:
+				TieState(const std::string& linksig);
+				std::string lstart;
+				std::string lmiddle;
+				std::string lend;
+				// startdatabase == open tie for each base-40 pitch.
+				std::vector<std::pair<HTp, int>> startdatabase;
+				std::vector<std::pair<HTp, int>> linkstarts;
+				std::vector<std::pair<HTp, int>> linkends;
+		};
+
+		// AccidentalState -- Accidental states for each staff while
+		// scanning lines (see analyzeAccidentalToken()).
+		class AccidentalState {
+			public:
+				std::vector<int> rtracks;                // track to staff index
+				std::vector<std::vector<int>> keysigs;   // key signature per staff
+				std::vector<std::vector<int>> dstates;   // diatonic states per staff
+				std::vector<std::vector<int>> gdstates;  // grace-note diatonic states
+				std::vector<int> firstinbar;
+				std::vector<int> concurrentstate;
+				int lasttrack = -1;
+		};
+
+		// Shared marker analysis (defined in src/HumdrumFileContent-notation.cpp):
+		void   getLabelSequence           (std::vector<std::pair<HTp, HTp>>& labels,
+		                                   std::vector<int>& endings);
+		void   analyzeSpanMarkers         (HTp token, int layer, int opencount,
+		                                   int closecount, SpanState& state,
+		                                   std::vector<std::pair<HTp, HTp>>& labels,
+		                                   std::vector<int>& endings);
+		void   markHangingSpans           (SpanState& state);
+		void   analyzeSpans               (std::vector<HTp>& spines, char opener,
+		                                   std::vector<HTp>& linkstarts,
+		                                   std::vector<HTp>& linkends);
+		void   analyzeSpineSpans          (HTp spinestart, SpanState& state,
+		                                   std::vector<std::pair<HTp, HTp>>& labels,
+		                                   std::vector<int>& endings);
+		void   linkSpanEndpoints          (HTp start, HTp end, char opener);
+		void   splitSubtokens             (HTp token, std::vector<std::string>& subtokens);
+		void   analyzeKernTieToken        (HTp token, const std::vector<std::string>& subtokens,
+		                                   TieState& state);
+		bool   prepareAccidentalState     (AccidentalState& state, const std::string& dataType);
+		bool   startAccidentalLine        (HumdrumLine& line, AccidentalState& state);
+		void   analyzeAccidentalToken     (HTp token, const std::vector<std::string>& subtokens,
+		                                   AccidentalState& state);
+
 		bool   analyzeKernPhrasings       (HTp spinestart,
 		                                   std::vector<HTp>& linkstarts,
 		                                   std::vector<HTp>& linkends,
@@ -177,9 +295,27 @@ class HumdrumFileContent : public HumdrumFileStructure {
 		void    prepareStaffAboveNoteStems (HTp token);
 		void    prepareStaffBelowNoteStems (HTp token);
 
+		void    fillMetricPositions       (std::vector<HumMetricPosition>& positions,
+		                                   int track);
+
 		void    getBaselines              (std::vector<std::vector<int>>& centerlines);
 		void    createLinkedTies          (std::vector<std::pair<HTp, int>>& starts,
 		                                   std::vector<std::pair<HTp, int>>& ends);
+
+	private:
+		// m_kernfields: the field indexes of **kern tokens on each line
+		// (see analyzeSlices()).
+		std::vector<std::vector<int>> m_kernfields;
+
+		// m_fieldkernspine: the **kern spine index (position in
+		// getKernSpineStartList()) for each field on each line, or -1 if
+		// the field is not **kern.
+		std::vector<std::vector<int>> m_fieldkernspine;
+
+		// m_metricpositions: the metric position of each line, using the
+		// time signatures of the first **kern spine (see
+		// analyzeMetricPositions()).
+		std::vector<HumMetricPosition> m_metricpositions;
 };
 
 
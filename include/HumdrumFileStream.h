@@ -3,6 +3,8 @@
 // Creation Date: Tue Dec 11 16:03:43 PST 2012
 // Last Modified: Fri Mar 11 21:25:24 PST 2016 Changed to STL
 // Last Modified: Fri Dec  2 19:26:01 PST 2016 Ported to humlib
+// Last Modified: Sun Oct 18 23:12:07 PDT 2026 Added input streams and prefetching
+// Last Modified: Mon Oct 19 01:16:38 PDT 2026 Added readSegments
 // Filename:      HumdrumFileStream.h
 // URL:           https://github.com/craigsapp/humlib/blob/master/include/HumdrumFileStream.h
 // Syntax:        C++11; humlib
@@ -23,6 +25,8 @@
 
 
 #include <fstream>
+#include <future>
+#include <iostream>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -40,8 +44,11 @@ class HumdrumFileStream {
 		                HumdrumFileStream  (const std::vector<std::string>& list);
 		                HumdrumFileStream  (Options& options);
 		                HumdrumFileStream  (const std::string& datastream);
+		                HumdrumFileStream  (std::istream& input);
+		               ~HumdrumFileStream  ();
 
 		void            loadString         (const std::string& data);
+		void            setPrefetch        (bool state = true);
 
 		int             setFileList        (char** list);
 		int             setFileList        (const std::vector<std::string>& list);
@@ -50,21 +57,45 @@ class HumdrumFileStream {
 		int             eof                (void);
 
 		int             getFile            (HumdrumFile& infile);
+		int             getFileText        (HumdrumFile& infile,
+		                                    std::stringstream& contents);
+		static void     parseFileText      (HumdrumFile& infile,
+		                                    std::stringstream& contents);
 		int             read               (HumdrumFile& infile);
 		int             read               (HumdrumFileSet& infiles);
 		int             readSingleSegment  (HumdrumFileSet& infiles);
+		int             readSegments       (HumdrumFileSet& infiles, int count);
 
 	protected:
 		std::stringstream m_stringbuffer;   // used to read files from a string
 		std::ifstream     m_instream;       // used to read from list of files
 		std::stringstream m_urlbuffer;      // used to read data over internet
+		std::istream*     m_input = NULL;   // used to read from a given istream
 		std::string       m_newfilebuffer;  // used to keep track of !!!!segment:
 		                                    // records.
 
 		std::vector<std::string>  m_filelist;       // used when not using cin
 		int                       m_curfile;        // index into filelist
 
-		std::vector<std::string>  m_universals;     // storage for universal comments
+		// m_universals: universal comments of the stream, already demoted to
+		// global comments so that they are prepended to each segment with
+		// a single append.
+		std::string               m_universals;
+
+		// m_readbuffer: fixed-size read-ahead buffer for m_instream.
+		std::vector<char>         m_readbuffer;
+
+		// Reading the next segment in a separate thread while the current
+		// one is parsed and processed (see setPrefetch()):
+		bool                      m_prefetchQ = false;
+		int                       m_prefetchstatus = -1;
+		HumdrumFile               m_prefetchfile;
+		std::stringstream         m_prefetchtext;
+		std::future<int>          m_prefetch;
+
+		int      readFileText             (HumdrumFile& infile,
+		                                   std::stringstream& contents);
+		int      waitForPrefetch          (void);
 
 		// Automatic URL downloading of data from internet in read():
 		void     fillUrlBuffer            (std::stringstream& uribuffer,
@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Mon Aug 17 02:39:28 PDT 2015
-// Last Modified: Tue Feb  4 21:02:30 PST 2020 Strophe analysis
+// Last Modified: Sun Oct 18 19:24:37 PDT 2026
 // Filename:      HumdrumFileStructure.h
 // URL:           https://github.com/craigsapp/humlib/blob/master/include/HumdrumFileStructure.h
 // Syntax:        C++11; humlib
@@ -17,6 +17,7 @@
 #ifndef _HUMDRUMFILESTRUCTURE_H_INCLUDED
 #define _HUMDRUMFILESTRUCTURE_H_INCLUDED
 
+#include <cstdint>
 #include <iostream>
 #include <set>
 #include <string>
@@ -156,9 +157,19 @@ class HumdrumFileStructure : public HumdrumFileBase {
 		                                            HumNum linedur, int line);
 		bool          assignDurationsToTrack       (HTp starttoken,
 		                                            HumNum startdur);
+		template <class DURTYPE>
 		bool          prepareDurations             (HTp token, int state,
-		                                            HumNum startdur);
+		                                            DURTYPE startdur,
+		                                            std::vector<std::pair<HTp, DURTYPE>>* linedurs = NULL);
+		bool          prepareRhythmTicks           (void);
+		template <class DURTYPE>
+		bool          assignDurationsInParallel    (std::vector<int>& tracks,
+		                                            DURTYPE startdur);
+		void          addTokenDuration             (HumNum& dursum, HTp token);
+		void          addTokenDuration             (int64_t& durticks, HTp token);
+		bool          hasCrossTrackMerges          (void);
 		bool          setLineDurationFromStart     (HTp token, HumNum dursum);
+		bool          setLineDurationFromStart     (HTp token, int64_t durticks);
 		bool          analyzeRhythmOfFloatingSpine (HTp spinestart);
 		bool          analyzeNullLineRhythms       (void);
 		void          fillInNegativeStartTimes     (void);
@@ -175,6 +186,18 @@ class HumdrumFileStructure : public HumdrumFileBase {
 		void          analyzeSignifiers            (void);
 		void          setLineRhythmAnalyzed        (void);
 		bool          prepareMensurationInformation(void);
+
+	private:
+		// m_rhythmtpq: The number of ticks per quarter note used for integer
+		// timestamps during rhythm analysis (the least common multiple of
+		// the token duration denominators), or 0 if the file's durations
+		// cannot be represented in 64-bit ticks, in which case HumNum
+		// timestamps are used instead.
+		int64_t m_rhythmtpq = 0;
+
+		// m_lineticks: The durationFromStart of each line in ticks while
+		// the rhythm is being analyzed (-1 if not assigned yet).
+		std::vector<int64_t> m_lineticks;
 };
 
 
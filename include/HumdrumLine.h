@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Sat Aug  8 12:24:49 PDT 2015
-// Last Modified: Wed Aug 12 10:42:07 PDT 2015
+// Last Modified: Sun Oct 18 21:14:27 PDT 2026
 // Filename:      HumAddress.h
 // URL:           https://github.com/craigsapp/humlib/blob/master/include/HumAddress.h
 // Syntax:        C++11; humlib
@@ -86,6 +86,7 @@ class HumdrumLine : public std::string, public HumHash {
 		void        getTokens              (std::vector<HTp>& list);
 		int         getTokenCount          (void) const;
 		int         getFieldCount          (void) const { return getTokenCount(); }
+		int         getTabCount            (int index) const;
 		std::string getTokenString         (int index) const;
 		bool        equalChar              (int index, char ch) const;
 		char        getChar                (int index) const;
@@ -137,6 +138,7 @@ class HumdrumLine : public std::string, public HumHash {
 		HumNum   getBeat                (HumNum beatdur = 1);
 		HumNum   getBeatStr             (std::string beatrecip = "4");
 		HTp      getTrackStart          (int track) const;
+		int      getTrackDataType       (int track) const;
 		HTp      getTrackEnd            (int track, int subtrack = 0) const;
 		void     setLineFromCsv         (const char* csv,
 		                                 const std::string& separator = ",");
@@ -196,6 +198,8 @@ class HumdrumLine : public std::string, public HumHash {
 		void     clear                  (void);
 		void     setOwner               (void* hfile);
 		int      createTokensFromLine   (void);
+		int      createTokensFromCsv    (const char* csv, int length,
+		                                 const std::string& separator = ",");
 		void     setLayoutParameters    (void);
 		void     setParameters          (const std::string& pdata);
 		void     storeGlobalLinkedParameters(void);
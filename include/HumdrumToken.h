@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Sat Aug  8 12:24:49 PDT 2015
-// Last Modified: Thu Nov 24 08:31:41 PST 2016 Added null token resolving
+// Last Modified: Mon Oct 19 00:52:40 PDT 2026
 // Filename:      HumdrumToken.h
 // URL:           https://github.com/craigsapp/humlib/blob/master/include/HumdrumToken.h
 // Syntax:        C++11; humlib
@@ -16,6 +16,7 @@
 #include <algorithm>
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
 
 class HumParamSet;
@@ -32,6 +33,51 @@ namespace hum {
 
 typedef HumdrumToken* HTp;
 
+
+// HumSubtokenIterator -- Iterate over the subtokens of a token as views
+// into the token text, without allocating strings.  Empty subtokens are
+// included, as in HumdrumToken::getSubtokenCount().  An empty separator
+// iterates over single characters.
+class HumSubtokenIterator {
+	public:
+		                     HumSubtokenIterator (void);
+		                     HumSubtokenIterator (const std::string& text,
+		                                          const std::string& separator);
+		std::string_view     operator*           (void) const;
+		HumSubtokenIterator& operator++          (void);
+		bool                 operator==          (const HumSubtokenIterator& other) const;
+		bool                 operator!=          (const HumSubtokenIterator& other) const;
+		int                  getIndex            (void) const { return m_index; }
+
+	private:
+		void                 findEnd             (void);
+
+		const std::string* m_text      = NULL;
+		const std::string* m_separator = NULL;
+		size_t             m_start     = std::string::npos;
+		size_t             m_end       = std::string::npos;
+		int                m_index     = 0;
+};
+
+
+// HumSubtokenRange -- Return value of HumdrumToken::getSubtokenViews()
+// for use in range-based for loops:
+//    for (std::string_view subtok : token->getSubtokenViews()) { ... }
+// The views are valid until the token text is changed, and iterators are
+// valid while the range exists.
+class HumSubtokenRange {
+	public:
+		                    HumSubtokenRange (const std::string& text,
+		                                      const std::string& separator);
+		HumSubtokenIterator begin            (void) const;
+		HumSubtokenIterator end              (void) const;
+
+	private:
+		const std::string* m_text;
+		std::string        m_separator;
+};
+
+
 class HumdrumToken : public std::string, public HumHash {
 	public:
 		         HumdrumToken              (void);
@@ -234,8 +280,10 @@ class HumdrumToken : public std::string, public HumHash {
 		int      getTokenIndex             (void) const;
 		int      getTokenNumber            (void) const;
 		const std::string& getDataType     (void) const;
+		int      getDataTypeId             (void) const;
 		const std::string& getExInterp     (void) { return getDataType(); }
 		bool     isDataType                (const std::string& dtype) const;
+		bool     isDataType                (int datatype) const;
 		bool     isDataTypeLike            (const std::string& dtype) const;
 		bool     isKern                    (void) const;
 		bool     isKernLike                (void) const;
@@ -249,9 +297,17 @@ class HumdrumToken : public std::string, public HumHash {
 		bool     noteInLowerSubtrack       (void);
 		std::string   getTrackString       (void) const;
 		int      getSubtokenCount          (const std::string& separator = " ") const;
+		int      getSubtokenCount          (const std::string& separator = " ");
 		std::string   getSubtoken          (int index,
 		                                    const std::string& separator = " ") const;
+		std::string   getSubtoken          (int index,
+		                                    const std::string& separator = " ");
 		std::vector<std::string> getSubtokens (const std::string& separator = " ") const;
+		HumSubtokenRange getSubtokenViews  (const std::string& separator = " ") const;
+		std::string_view getSubtokenView   (int index,
+		                                    const std::string& separator = " ") const;
+		std::string_view getSubtokenView   (int index,
+		                                    const std::string& separator = " ");
 		void     replaceSubtoken           (int index, const std::string& newsubtok,
 		                                    const std::string& separator = " ");
 		void     setParameters             (HTp ptok);
@@ -370,6 +426,10 @@ class HumdrumToken : public std::string, public HumHash {
 		void     incrementState            (void);
 		void     setDuration               (const HumNum& dur);
 		void     setStrandIndex            (int index);
+		void     updateDataType            (void);
+		void     prepareSubtokenStarts     (const std::string& separator);
+		bool     hasSubtokenStarts         (const std::string& separator) const;
+		void     clearSubtokenStarts       (void);
 
 		bool     analyzeDuration           (void);
 		std::ostream& printXmlBaseInfo     (std::ostream& out = std::cout, int level = 0,
@@ -430,6 +490,20 @@ class HumdrumToken : public std::string, public HumHash {
 		// refers to.
 		HTp m_nullresolve;
 
+		// m_subtokenstarts: Cached start offsets of the subtokens of the
+		// token for m_subtokenseparator (see prepareSubtokenStarts()).
+		// The cache is cleared by setText() and assignment, and is not
+		// used if the length or hash of the text (m_subtokenlength and
+		// m_subtokenhash) changed in any other way since it was filled.
+		// Only the non-const subtoken accessors fill the cache, so the
+		// const accessors can be used for the same token in several
+		// threads at a time.
+		std::vector<int> m_subtokenstarts;
+		std::string      m_subtokenseparator;
+		size_t           m_subtokenlength = 0;
+		size_t           m_subtokenhash = 0;
+		bool             m_subtokenvalid = false;
+
 		// m_linkedParameterTokens: List of Humdrum tokens which are parameters
 		// (mostly only layout parameters at the moment).
 		// Was previously called m_linkedParameters;
@@ -30,6 +30,7 @@ class Tool_autobeam : public HumTool {
 		bool         run                 (HumdrumFileSet& infiles);
 		bool         run                 (const std::string& indata, std::ostream& out);
 		bool         run                 (HumdrumFile& infile, std::ostream& out);
+		bool         isReusable          (void);
 
 	protected:
 		void         initialize          (HumdrumFile& infile);
@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Date: Mon Sep 16 13:53:47 PDT 2013
-// Last Modified: Tue May 30 15:19:23 CEST 2017 Ported from Humdrum Extras
+// Last Modified: Sun Oct 18 17:04:38 PDT 2026
 // Filename:      tool-cint.h
 // URL:           https://github.com/craigsapp/humlib/blob/master/include/tool-dissonant.h
 // Syntax:        C++11; humlib
@@ -14,6 +14,7 @@
 #ifndef _TOOL_CINT_H
 #define _TOOL_CINT_H
 
+#include "HumStatistics.h"
 #include "HumTool.h"
 #include "HumdrumFile.h"
 #include "NoteGrid.h"
@@ -67,6 +68,8 @@ class Tool_cint : public HumTool {
 		bool     run                    (HumdrumFile& infile);
 		bool     run                    (const std::string& indata, ostream& out);
 		bool     run                    (HumdrumFile& infile, ostream& out);
+		void     finally                (void);
+		HumStatistics& getStatistics    (void);
 
 	protected:
 
@@ -201,6 +204,8 @@ class Tool_cint : public HumTool {
 		int       uncrossQ     = 0;      // used with -c option
 		int       retroQ       = 0;      // used with --retro option
 		int       idQ          = 0;      // used with --id option
+		int       statsQ       = 0;      // used with --stats option
+		HumStatistics m_stats;           // used with --stats option
 		std::vector<std::string> Ids;    // used with --id option
 		std::string NoteMarker;          // used with -N option
 		std::string MarkColor;           // used with --color
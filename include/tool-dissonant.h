@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Mon Nov 28 08:55:15 PST 2016
-// Last Modified: Mon Nov 28 08:55:38 PST 2016
+// Last Modified: Sun Oct 18 16:52:13 PDT 2026
 // Filename:      tool-dissonant.h
 // URL:           https://github.com/craigsapp/humlib/blob/master/include/tool-dissonant.h
 // Syntax:        C++11; humlib
@@ -13,6 +13,7 @@
 #ifndef _TOOL_DISSONANT_H
 #define _TOOL_DISSONANT_H
 
+#include "HumStatistics.h"
 #include "HumTool.h"
 #include "HumdrumFile.h"
 #include "NoteGrid.h"
@@ -30,29 +31,31 @@ class Tool_dissonant : public HumTool {
 		bool     run               (HumdrumFile& infile);
 		bool     run               (const string& indata, ostream& out);
 		bool     run               (HumdrumFile& infile, ostream& out);
+		void     finally           (void);
+		HumStatistics& getStatistics(void);
 
 	protected:
-		void    doAnalysis         (vector<vector<string> >& results,
+		void    doAnalysis         (vector<vector<int> >& results,
 		                            NoteGrid& grid,
 		                            vector<vector<NoteCell*> >& attacks,
 		                            bool debug);
-		void    doAnalysisForVoice (vector<vector<string> >& results,
+		void    doAnalysisForVoice (vector<vector<int> >& results,
 		                            NoteGrid& grid,
 		                            vector<NoteCell*>& attacks,
 		                            int vindex, bool debug);
-		void    findFakeSuspensions(vector<vector<string> >& results,
+		void    findFakeSuspensions(vector<vector<int> >& results,
 		                            NoteGrid& grid,
 		                            vector<NoteCell*>& attacks, int vindex);
-		void    findAppoggiaturas  (vector<vector<string> >& results,
+		void    findAppoggiaturas  (vector<vector<int> >& results,
 		                            NoteGrid& grid,
 		                            vector<NoteCell*>& attacks, int vindex);
-		void    findLs             (vector<vector<string> >& results,
+		void    findLs             (vector<vector<int> >& results,
 		                            NoteGrid& grid,
 		                            vector<NoteCell*>& attacks, int vindex);
-		void    findYs             (vector<vector<string> >& results,
+		void    findYs             (vector<vector<int> >& results,
 		                            NoteGrid& grid,
 		                            vector<NoteCell*>& attacks, int vindex);
-		void    findCadentialVoiceFunctions(vector<vector<string> >& results,
+		void    findCadentialVoiceFunctions(vector<vector<int> >& results,
 		                            NoteGrid& grid, vector<NoteCell*>& attacks,
 		                            vector<vector<string> >& voiceFuncs,
 		                            int vindex);
@@ -62,18 +65,25 @@ class Tool_dissonant : public HumTool {
 		                            int sliceindex);
 		void    fillLabels         (void);
 		void    fillLabels2        (void);
+		void    fillLabelIndexes   (void);
+		bool    isLabel            (int value, int label);
+		bool    isUnexplained      (int value);
+		vector<string> getLabelStrings(vector<int>& results);
+		void    printCountAnalysis (vector<vector<int> >& data);
 		void    printCountAnalysis (vector<vector<string> >& data);
+		void    addStatistics      (vector<vector<int> >& data);
+		void    addStatistics      (vector<vector<string> >& data);
 		void    suppressDissonances(HumdrumFile& infile, NoteGrid& grid,
 		                            vector<vector<NoteCell* > >& attacks,
-		                            vector<vector<string> >& results);
+		                            vector<vector<int> >& results);
 		void    suppressDissonancesInVoice(HumdrumFile& infile,
 		                            NoteGrid& grid, int vindex,
 		                            vector<NoteCell*>& attacks,
-		                            vector<string>& results);
+		                            vector<int>& results);
 		void    suppressSusOrnamentsInVoice(HumdrumFile& infile,
 		                            NoteGrid& grid, int vindex,
 		                            vector<NoteCell*>& attacks,
-		                            vector<string>& results);
+		                            vector<int>& results);
 		void    mergeWithPreviousNote(HumdrumFile& infile, int line, int field);
 		void    mergeWithNextNote(HumdrumFile& infile, int line, int field);
 		void    changeDurationOfNote(HTp note, HumNum dur);
@@ -104,9 +114,17 @@ class Tool_dissonant : public HumTool {
 		bool voiceFuncsQ = false;
 		bool m_voicenumQ = false;
 		bool m_selfnumQ = false;
+		bool m_statsQ = false;
+
+		// m_stats: dissonance counts of all files analyzed with --stats.
+		HumStatistics m_stats;
 
 		vector<string> m_labels;
 
+		// m_labelIndex: the first label type with the same text as each
+		// label type (see fillLabelIndexes()).
+		vector<int> m_labelIndex;
+
 		// unaccdented non-harmonic tones:
 		const int PASSING_UP           =  0; // rising passing tone
 		const int PASSING_DOWN         =  1; // downward passing tone
@@ -163,6 +181,10 @@ class Tool_dissonant : public HumTool {
 		const int UNLABELED_Z4         = 47; // unknown dissonance type, 4th interval
 
 		const int LABELS_SIZE          = 48; // one more than last index
+
+		// analysis results for notes without a label:
+		const int NO_LABEL             = -1; // no dissonance label
+		const int NULL_LABEL           = -2; // null label (not assigned by the analysis)
 };
 
 // END_MERGE
@@ -29,6 +29,7 @@ class Tool_extract : public HumTool {
 		bool     run                    (HumdrumFile& infile);
 		bool     run                    (const std::string& indata, std::ostream& out);
 		bool     run                    (HumdrumFile& infile, std::ostream& out);
+		bool     isReusable             (void);
 
 	protected:
 
@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Wed Dec 14 22:21:44 PST 2016
-// Last Modified: Wed Dec 14 22:21:47 PST 2016
+// Last Modified: Sun Oct 18 22:18:40 PDT 2026
 // Filename:      tool-filter.h
 // URL:           https://github.com/craigsapp/humlib/blob/master/include/tool-filter.h
 // Syntax:        C++11; humlib
@@ -16,6 +16,8 @@
 #include "HumTool.h"
 #include "HumdrumFileSet.h"
 
+#include <map>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -45,12 +47,47 @@ class Tool_filter : public HumTool {
 		void     removeUniversalFilterLines (HumdrumFileSet& infiles);
 		void     splitPipeline      (std::vector<std::string>& clist, const std::string& command);
 
+		template <class TOOL>
+		TOOL*    getTool            (const std::string& command);
+		void     releaseTool        (const std::string& command, HumTool* tool);
+		static std::map<std::string, std::unique_ptr<HumTool>>& getToolCache(void);
+
 	private:
 		std::string   m_variant;        // used with -v option.
 		bool     m_debugQ = false; // used with --debug option
 
 };
 
+
+
+//////////////////////////////
+//
+// Tool_filter::getTool -- Return an instance of a tool with the options
+//     of a filter command (such as "transpose -k c") processed.  Instances
+//     of reusable tools are kept for each command in the current thread,
+//     so their options are only defined and processed once.  Call
+//     releaseTool() after running the tool.
+//
+
+template <class TOOL>
+TOOL* Tool_filter::getTool(const std::string& command) {
+	std::map<std::string, std::unique_ptr<HumTool>>& cache = getToolCache();
+	auto it = cache.find(command);
+	if (it != cache.end()) {
+		return static_cast<TOOL*>(it->second.get());
+	}
+	TOOL* tool = new TOOL;
+	tool->process(command);
+	if (tool->isReusable()) {
+		if (cache.size() >= 100) {
+			// Avoid unlimited growth when commands vary for each file.
+			cache.clear();
+		}
+		cache[command].reset(tool);
+	}
+	return tool;
+}
+
 // END_MERGE
 
 } // end namespace hum
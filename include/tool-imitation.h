@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Sat Jun 17 20:18:23 CEST 2017
-// Last Modified: Sat Jun 17 22:40:59 CEST 2017
+// Last Modified: Sun Oct 18 21:06:33 PDT 2026
 // Filename:      tool-imitation.h
 // URL:           https://github.com/craigsapp/humlib/blob/master/include/tool-imitation.h
 // Syntax:        C++11; humlib
@@ -17,10 +17,41 @@
 #include "HumdrumFile.h"
 #include "NoteGrid.h"
 
+#include <climits>
+#include <map>
+#include <utility>
+
 namespace hum {
 
 // START_MERGE
 
+//////////////////////////////
+//
+// ImitationVoice -- The attacks of a voice as integer intervals and
+//    duration IDs, with an index of the attacks that can start a match.
+//
+
+class ImitationVoice {
+	public:
+		static const int NOINTERVAL = INT_MIN;
+
+		// intervals: the diatonic interval from each attack to the next one,
+		// or NOINTERVAL if either attack is a rest (or for the last attack).
+		vector<int> intervals;
+
+		// durations: the duration ID of each attack (all zero if durations
+		// are not compared).
+		vector<int> durations;
+
+		// starttimes: the start time of each attack in the score.
+		vector<HumNum> starttimes;
+
+		// starts: the attack indexes in increasing order for each interval
+		// and duration ID pair (excluding rests).
+		map<pair<int, int>, vector<int>> starts;
+};
+
+
 class Tool_imitation : public HumTool {
 	public:
 		         Tool_imitation    (void);
@@ -39,12 +70,16 @@ class Tool_imitation : public HumTool {
 		void    analyzeImitation  (vector<vector<string>>& results,
 		                            vector<vector<NoteCell*>>& attacks,
 		                            vector<vector<double>>& intervals,
+		                            vector<ImitationVoice>& voices,
 		                            int v1, int v2);
 		void    getIntervals       (vector<double>& intervals,
 		                            vector<NoteCell*>& attacks);
-		int     compareSequences   (vector<NoteCell*>& attack1, vector<double>& seq1,
-		                            int i1, vector<NoteCell*>& attack2,
-		                            vector<double>& seq2, int i2);
+		void    prepareVoice       (ImitationVoice& voice,
+		                            vector<NoteCell*>& attacks,
+		                            vector<double>& intervals,
+		                            map<HumNum, int>& durationids);
+		int     compareSequences   (ImitationVoice& voice1, int i1,
+		                            ImitationVoice& voice2, int i2);
 		int     checkForIntervalSequence(vector<int>& m_intervals,
 		                            vector<double>& v1i, int starti, int count);
 		void    markedTiedNotes    (vector<HTp>& tokens);
@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Sun Aug 27 07:18:04 PDT 2017
-// Last Modified: Sun Aug 27 07:18:07 PDT 2017
+// Last Modified: Sun Oct 18 22:44:19 PDT 2026
 // Filename:      tool-msearch.h
 // URL:           https://github.com/craigsapp/humlib/blob/master/include/tool-msearch.h
 // Syntax:        C++11; humlib
@@ -13,6 +13,7 @@
 #ifndef _TOOL_MSEARCH_H
 #define _TOOL_MSEARCH_H
 
+#include "HumSonority.h"
 #include "HumTool.h"
 #include "HumdrumFile.h"
 #include "NoteGrid.h"
@@ -148,13 +149,14 @@ class SonorityNoteData {
 class SonorityDatabase {
 	public:
 		SonorityDatabase(void) { clear(); }
-		void clear(void)       { m_notes.clear(); m_line = NULL; }
+		void clear(void)       { m_notes.clear(); m_line = NULL; m_sonority.clear(); }
 		int getCount(void)     { return (int)m_notes.size(); }
 		int getNoteCount(void) { return (int)m_notes.size(); }
 		int getSize(void)      { return (int)m_notes.size(); }
 		bool isEmpty(void)     { return m_notes.empty(); }
 		HLp getLine(void)      { return m_line; }
 		SonorityNoteData& getLowest(void) { return m_lowest; };
+		const HumSonority& getSonority(void) { return m_sonority; }
 		void addNote          (const std::string& text);
 		void buildDatabase     (HLp line);
 		SonorityNoteData& operator[](int index) {
@@ -169,6 +171,9 @@ class SonorityDatabase {
 		SonorityNoteData m_lowest;
 		std::vector<SonorityNoteData> m_notes;
 		HLp m_line = NULL;
+
+		// m_sonority: diatonic and base-40 pitch classes of m_notes.
+		HumSonority m_sonority;
 };
 
 
@@ -198,6 +203,7 @@ class MSearchQueryToken {
 			harmonic    = token.harmonic;
 			hpieces     = token.hpieces;
 			hquery      = token.hquery;
+			hsonority   = token.hsonority;
 		}
 		MSearchQueryToken& operator=(const MSearchQueryToken& token) {
 			if (this == &token) {
@@ -214,6 +220,7 @@ class MSearchQueryToken {
 			harmonic    = token.harmonic;
 			hpieces     = token.hpieces;
 			hquery      = token.hquery;
+			hsonority   = token.hsonority;
 			cinterval   = token.cinterval;
 			duration    = token.duration;
 			rhythm      = token.rhythm;
@@ -233,6 +240,7 @@ class MSearchQueryToken {
 			harmonic     = "";
 			hpieces.clear();
 			hquery.clear();
+			hsonority.clear();
 			rhythm       = "";
 		}
 		void parseHarmonicQuery(void);
@@ -253,6 +261,7 @@ class MSearchQueryToken {
 		std::string harmonic; // harmonic query
 		std::vector<std::string> hpieces;
 		std::vector<SonorityNoteData> hquery;
+		HumSonority hsonority; // pitch classes in hquery
 
 		// rhythm features:
 		HumNum duration;
@@ -353,10 +362,6 @@ class Tool_msearch : public HumTool {
 		                            vector<NoteCell*>& match);
 		void    storeMatch         (vector<NoteCell*>& match);
 		void    markTextMatch      (HumdrumFile& infile, TextInfo& word);
-		void    fillWords          (HumdrumFile& infile,
-		                            vector<TextInfo*>& words);
-		void    fillWordsForTrack  (vector<TextInfo*>& words,
-		                            HTp starttoken);
 		void    printQuery         (vector<MSearchQueryToken>& query);
 		void    addMusicSearchSummary(HumdrumFile& infile, int mcount, const std::string& marker);
 		void    addTextSearchSummary(HumdrumFile& infile, int mcount, const std::string& marker);
@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Sat Sep  7 20:13:13 PDT 2019
-// Last Modified: Sat Sep  7 20:13:15 PDT 2019
+// Last Modified: Mon Oct 19 01:16:38 PDT 2026
 // Filename:      tool-pccount.h
 // URL:           https://github.com/craigsapp/humlib/blob/master/include/tool-pccount.h
 // Syntax:        C++11; humlib
@@ -26,6 +26,20 @@ namespace hum {
 // START_MERGE
 
 
+// PccountHistogram: Pitch-class counts by instrument name, which can be
+// merged to combine the counts of several files.
+
+class PccountHistogram {
+	public:
+		void  clear                     (void);
+		int   getVoiceIndex             (const std::string& name);
+		void  merge                     (const PccountHistogram& histogram);
+
+		std::vector<std::string>         names;  // instrument name of each voice
+		std::vector<std::vector<double>> counts; // base-40 pitch-class counts by voice
+};
+
+
 class Tool_pccount : public HumTool {
 	public:
 		      Tool_pccount              (void);
@@ -35,13 +49,23 @@ class Tool_pccount : public HumTool {
 		bool  run                       (HumdrumFile& infile);
 		bool  run                       (const std::string& indata, std::ostream& out);
 		bool  run                       (HumdrumFile& infile, std::ostream& out);
+		void  finally                   (void);
+		int   getSegmentBatchSize       (void);
+
+		const PccountHistogram& getHistogram (void) const;
+		void  mergeHistogram            (const PccountHistogram& histogram);
 
 	protected:
 		void   initialize               (HumdrumFile& infile);
 		void   processFile              (HumdrumFile& infile);
+		void   printOutput              (HumdrumFile& infile);
 		void   initializePartInfo       (HumdrumFile& infile);
-		void   addCounts                (HTp sstart, HTp send);
+		void   addCounts                (HTp sstart, HTp send,
+		                                 std::vector<double>& counts);
 		void   countPitches             (HumdrumFile& infile);
+		void   fillHistogram            (HumdrumFile& infile,
+		                                 PccountHistogram& histogram);
+		void   loadHistogram            (void);
 		void   printHumdrumTable        (void);
 		void   printPitchClassList      (void);
 		void   printVegaLiteJsonTemplate(const std::string& datavariable, HumdrumFile& infile);
@@ -75,6 +99,7 @@ class Tool_pccount : public HumTool {
 		std::vector<std::string>       m_abbreviations;
 		std::vector<std::vector<double>> m_counts;
 		bool m_attack       = false;
+		bool m_corpus       = false;
 		bool m_full         = false;
 		bool m_doublefull   = false;
 		bool m_normalize    = false;
@@ -93,6 +118,9 @@ class Tool_pccount : public HumTool {
 		std::string m_id    = "id";
 		std::map<std::string, std::string> m_vcolor;
 
+		// m_histogram: the counts of all inputs for the --corpus option.
+		PccountHistogram m_histogram;
+
 };
 
 
@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Mon Jul 18 11:23:42 PDT 2005
-// Last Modified: Sat Jun  8 17:37:39 PDT 2024 (ported to humlib)
+// Last Modified: Mon Oct 19 01:16:38 PDT 2026
 // Filename:      include/tool-prange.h
 // URL:           https://github.com/craigsapp/humlib/blob/master/include/tool-prange.h
 // Syntax:        C++11; humlib
@@ -44,6 +44,7 @@ class _VoiceInfo {
 	public:
 		                _VoiceInfo        (void);
 		void            clear             (void);
+		void            add               (const _VoiceInfo& info);
 		std::ostream&   print             (std::ostream& out);
 
 };
@@ -59,12 +60,16 @@ class Tool_prange : public HumTool {
 		bool        run               (HumdrumFile& infile);
 		bool        run               (const std::string& indata, std::ostream& out);
 		bool        run               (HumdrumFile& infile, std::ostream& out);
+		void        finally           (void);
+		int         getSegmentBatchSize(void);
 
 	protected:
 		void        processFile         (HumdrumFile& infile);
 		void        initialize          (void);
 
 		void        mergeAllVoiceInfo           (std::vector<_VoiceInfo>& voiceInfo);
+		void        mergeCorpusVoiceInfo        (std::vector<_VoiceInfo>& voiceInfo);
+		void        printCorpusAnalysis         (void);
 		void        getVoiceInfo                (std::vector<_VoiceInfo>& voiceInfo, HumdrumFile& infile);
 		std::string getHand                     (HTp sstart);
 		void        fillHistograms              (std::vector<_VoiceInfo>& voiceInfo, HumdrumFile& infile);
@@ -121,6 +126,7 @@ class Tool_prange : public HumTool {
 		bool m_accQ         = false; // for --acc option
 		bool m_addFractionQ = false; // for --fraction option
 		bool m_allQ         = false; // for --all option
+		bool m_corpusQ      = false; // for --corpus option
 		bool m_debugQ       = false; // for --debug option
 		bool m_defineQ      = false; // for --score option (use text macro)
 		bool m_diatonicQ    = false; // for --diatonic option
@@ -168,6 +174,13 @@ class Tool_prange : public HumTool {
                 // m_voiceCount: Number of voices: (0 minimum voices)
 		int m_voiceCount = 0;
 
+		// m_corpusInfo: combined histograms of all inputs for the --corpus
+		// option (index 0 is the sum of all voices), and m_corpusKeys: the
+		// instrument name (with --instrument) or **kern spine number that
+		// identifies each voice.
+		std::vector<_VoiceInfo> m_corpusInfo;
+		std::vector<std::string> m_corpusKeys;
+
 };
 
 // END_MERGE
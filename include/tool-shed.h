@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Sun Oct 13 11:42:59 PDT 2019
-// Last Modified: Thu May 13 09:42:21 PDT 2021
+// Last Modified: Sun Oct 18 21:32:05 PDT 2026
 // Filename:      tool-shed.h
 // URL:           https://github.com/craigsapp/humlib/blob/master/include/tool-shed.h
 // Syntax:        C++11; humlib
@@ -17,6 +17,7 @@
 #include "HumdrumFile.h"
 
 #include <ostream>
+#include <regex>
 #include <string>
 #include <vector>
 
@@ -24,6 +25,40 @@ namespace hum {
 
 // START_MERGE
 
+class ShedExpression {
+	public:
+		std::string search;      // search string
+		std::string replace;     // replace string
+		std::string grepoptions; // "i" (ignore case) and/or "g" (global)
+
+		// list of exclusive interpretations to process (all if empty)
+		std::vector<std::string> exinterps;
+
+		bool data           = true;  // process data
+		bool barline        = false; // process barlines
+		bool exinterp       = false; // process exclusive interpretations
+		bool interpretation = false; // process interpretations
+		bool localcomment   = false; // process local comments
+		bool globalcomment  = false; // process global comments
+		bool reference      = false; // process reference records
+		bool referencekey   = false; // process reference records keys
+		bool referencevalue = false; // process reference records values
+
+		// Compiled search string, and the search string following the
+		// signifier of each record type:
+		std::regex searchRegex;
+		std::regex barlineRegex;
+		std::regex interpretationRegex;
+		std::regex localCommentRegex;
+		std::regex globalCommentRegex;
+		std::regex referenceRegex;
+		std::regex exinterpRegex;
+
+		// replaceFlags: format_first_only unless the "g" option is given.
+		std::regex_constants::match_flag_type replaceFlags;
+};
+
+
 class Tool_shed : public HumTool {
 	public:
 		         Tool_shed       (void);
@@ -33,28 +68,44 @@ class Tool_shed : public HumTool {
 		bool     run               (HumdrumFile& infile);
 		bool     run               (const std::string& indata, std::ostream& out);
 		bool     run               (HumdrumFile& infile, std::ostream& out);
+		bool     isReusable        (void);
 
 	protected:
 		void    processFile                      (HumdrumFile& infile);
-		void    processExpression                (HumdrumFile& infile);
-		void    searchAndReplaceInterpretation   (HumdrumFile& infile);
-		void    searchAndReplaceExinterp         (HumdrumFile& infile);
-		void    searchAndReplaceData             (HumdrumFile& infile);
-		void    searchAndReplaceBarline          (HumdrumFile& infile);
-		void    searchAndReplaceLocalComment     (HumdrumFile& infile);
-		void    searchAndReplaceGlobalComment    (HumdrumFile& infile);
-		void    searchAndReplaceReferenceRecords (HumdrumFile& infile);
-		void    searchAndReplaceReferenceKeys    (HumdrumFile& infile);
-		void    searchAndReplaceReferenceValues  (HumdrumFile& infile);
+		void    processExpression                (HumdrumFile& infile,
+		                                          ShedExpression& expression);
+		void    processLines                     (HumdrumFile& infile);
+		bool    processLine                      (HumdrumFile& infile, int index,
+		                                          ShedExpression& expression);
+		bool    searchAndReplaceInterpretation   (HumdrumFile& infile, int index,
+		                                          ShedExpression& expression);
+		bool    searchAndReplaceExinterp         (HumdrumFile& infile, int index,
+		                                          ShedExpression& expression);
+		bool    searchAndReplaceData             (HumdrumFile& infile, int index,
+		                                          ShedExpression& expression);
+		bool    searchAndReplaceBarline          (HumdrumFile& infile, int index,
+		                                          ShedExpression& expression);
+		bool    searchAndReplaceLocalComment     (HumdrumFile& infile, int index,
+		                                          ShedExpression& expression);
+		bool    searchAndReplaceGlobalComment    (HumdrumFile& infile, int index,
+		                                          ShedExpression& expression);
+		bool    searchAndReplaceReferenceRecords (HumdrumFile& infile, int index,
+		                                          ShedExpression& expression);
+		bool    searchAndReplaceReferenceKeys    (HumdrumFile& infile, int index,
+		                                          ShedExpression& expression);
+		bool    searchAndReplaceReferenceValues  (HumdrumFile& infile, int index,
+		                                          ShedExpression& expression);
 
 		void    initialize         (void);
 		void    initializeSegment  (HumdrumFile& infile);
-		bool    isValid            (HTp token);
-		bool    isValidDataType    (HTp token);
+		bool    isValid            (HTp token, ShedExpression& expression);
+		bool    isValidDataType    (HTp token, ShedExpression& expression);
 		bool    isValidSpine       (HTp token);
 		std::vector<std::string> addToExInterpList(void);
 		void    parseExpression    (const std::string& value);
 		void    prepareSearch      (int index);
+		void    prepareExpressions (void);
+		bool    needsSequentialProcessing(void);
 		std::string getExInterp    (const std::string& value);
 
 	private:
@@ -79,11 +130,13 @@ class Tool_shed : public HumTool {
 		std::string m_yInterp; // used with -y option
 		std::string m_zInterp; // used with -z option
 
-		bool m_modified       = false;
-
 		// list of exclusive interpretations to process
 		std::vector<std::string> m_exinterps;
 		std::string m_exclusion;
+		std::regex m_exclusionRegex;
+
+		// m_expressions: the compiled expressions, in the order given.
+		std::vector<ShedExpression> m_expressions;
 
 		std::vector<bool> m_spines; // usar with -s option
 		std::string m_grepoptions;
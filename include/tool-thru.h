@@ -33,6 +33,7 @@ class Tool_thru : public HumTool {
 		bool     run               (HumdrumFile& infile);
 		bool     run               (const std::string& indata, std::ostream& out);
 		bool     run               (HumdrumFile& infile, std::ostream& out);
+		bool     isReusable        (void);
 
 	protected:
 		void      processFile         (HumdrumFile& infile);
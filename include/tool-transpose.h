@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Mon Dec  5 23:09:00 PST 2016
-// Last Modified: Mon Dec  5 23:09:08 PST 2016
+// Last Modified: Sun Oct 18 15:02:44 PDT 2026
 // Filename:      tool-transpose.h
 // URL:           https://github.com/craigsapp/humlib/blob/master/include/tool-transpose.h
 // Syntax:        C++11; humlib
@@ -15,6 +15,7 @@
 
 #include "HumTool.h"
 #include "HumdrumFile.h"
+#include "HumKeyWindow.h"
 
 #include <ostream>
 #include <string>
@@ -34,6 +35,7 @@ class Tool_transpose : public HumTool {
 		bool     run             (HumdrumFile& infile);
 		bool     run             (const std::string& indata, std::ostream& out);
 		bool     run             (HumdrumFile& infile, std::ostream& out);
+		bool     isReusable      (void);
 
 	protected:
 
@@ -83,25 +85,15 @@ class Tool_transpose : public HumTool {
 		void     doTrackKeyAnalysis     (std::vector<std::vector<double> >& analysis,
 		                                 int level, int hop, int count,
 		                                 std::vector<std::vector<double> >& trackhist,
-		                                 std::vector<double>& majorweights,
-		                                 std::vector<double>& minorweights);
+		                                 HumKeyWindow& keywindow);
 		void     identifyKeyDouble      (std::vector<double>& correls,
 		                                 std::vector<double>& histogram,
 		                                 std::vector<double>& majorweights,
 		                                 std::vector<double>& minorweights);
-		void     fillWeightsWithKostkaPayne(std::vector<double>& maj,
-		                                 std::vector<double>& min);
 		void     printRawTrackAnalysis  (std::vector<std::vector<std::vector<double> > >&
 		                                 analysis, std::vector<int>& ktracks);
-		void     doSingleAnalysis       (std::vector<double>& analysis,
-		                                 int startindex, int length,
-		                                 std::vector<std::vector<double> >& trackhist,
-		                                 std::vector<double>& majorweights,
-		                                 std::vector<double>& minorweights);
 		void     identifyKey            (std::vector<double>& correls,
-		                                 std::vector<double>& histogram,
-		                                 std::vector<double>& majorweights,
-		                                 std::vector<double>& minorweights);
+		                                 HumKeyWindow& keywindow);
 		void     doTranspositionAnalysis(std::vector<std::vector<std::vector<double> > >&
 		                                 analysis);
 		int      calculateTranspositionFromKey(int targetkey,
@@ -1,7 +1,7 @@
 //
 // Programmer:    Katherine Wong
 // Creation Date: Mon Mar 13 23:47:52 PDT 2023
-// Last Modified: Tue Jun  6 19:23:10 PDT 2023
+// Last Modified: Sun Oct 18 17:58:40 PDT 2026
 // Filename:      tool-tspos.h
 // URL:           https://github.com/craigsapp/humlib/blob/master/include/tool-tspos.h
 // Syntax:        C++11; humlib
@@ -16,6 +16,8 @@
 #ifndef _TOOL_TPOS_H
 #define _TOOL_TPOS_H
 
+#include "HumSonority.h"
+#include "HumStatistics.h"
 #include "HumTool.h"
 #include "HumdrumFile.h"
 
@@ -36,21 +38,25 @@ class Tool_tspos : public HumTool {
 		bool     run               (HumdrumFile& infile);
 		bool     run               (const std::string& indata, std::ostream& out);
 		bool     run               (HumdrumFile& infile, std::ostream& out);
+		void     finally           (void);
+		HumStatistics& getStatistics(void);
 
 	protected:
 		void             initialize        (HumdrumFile& infile);
 		void             processFile       (HumdrumFile& infile);
 		std::vector<int> getMidiNotes(std::vector<HTp>& kernNotes);
-		std::vector<int> getChordPositions(std::vector<int>& midiNotes);
-		std::vector<int> getNoteMods(std::vector<int>& midiNotes);
-		std::vector<int> getThirds(std::vector<int>& midiNotes);
-		std::vector<int> getFifths(std::vector<int>& midiNotes);
+		std::vector<int> getChordPositions(std::vector<int>& midiNotes, int pcmask);
+		std::vector<int> getThirds(std::vector<int>& midiNotes, int pcmask);
+		std::vector<int> getFifths(std::vector<int>& midiNotes, int pcmask);
 		void             labelChordPositions(std::vector<HTp>& kernNotes, std::vector<int>& chordPositions);
 		void             labelThirds(std::vector<HTp>& kernNotes, std::vector<int>& thirdPositions);
 		void             labelFifths(std::vector<HTp>& kernNotes, std::vector<int>& fifthPositions);
 		void             keepOnlyDoubles(std::vector<int>& output);
 		void             checkForTriadicSonority(std::vector<int>& positions, int line);
 		std::string      generateStatistics(HumdrumFile& infile);
+		void             countSonorities(HumdrumFile& infile, int& sonorityCount,
+		                                 int& triadCount, HumNum& triadDuration);
+		void             addStatistics(HumdrumFile& infile);
 		std::vector<std::string> getTrackNames(HumdrumFile& infile);
 		int              getVectorSum(std::vector<int>& input);
 		void             analyzeVoiceCount(HumdrumFile& infile);
@@ -91,10 +97,14 @@ class Tool_tspos : public HumTool {
 		bool m_topQ = false;         // used with --top option
 		bool m_tableQ = false;       // used with -t option
 		bool m_triadAttack = false;  // used with -x option
+		bool m_statsQ = false;       // used with --stats option
 
 		// Statistical data variables:
 		std::vector<bool> m_triadState;
 
+		// m_stats: counts of all files analyzed with --stats.
+		HumStatistics m_stats;
+
 		// m_partTriadPositions -- count the number of chordal positions by
 		// voice.  The first dimention is the track number of the part, and
 		// the second dimension is the counts for 7 categories:
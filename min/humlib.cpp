@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Sat Aug  8 12:24:49 PDT 2015
-// Last Modified: Tue Aug 18 13:40:26 PDT 2026
+// Last Modified: Sun Oct 18 22:28:00 UTC 2026
 // Filename:      min/humlib.cpp
 // URL:           https://github.com/craigsapp/humlib/blob/master/min/humlib.cpp
 // Syntax:        C++11
@@ -1503,6 +1503,170 @@ double Convert::pearsonCorrelation(const vector<double>& x, const vector<double>
 
 
 
+//////////////////////////////
+//
+// Convert::prepareCorrelationSums -- Store running sums of x, y, x*x, y*y
+//     and x*y so that the Pearson correlation of any window of the two
+//     sequences can be calculated in constant time with windowCorrelation().
+//     sums[k][i] is the sum of the first i elements, so each list is one
+//     longer than the shorter input sequence.  The mean of each sequence
+//     is subtracted before summing to reduce rounding errors.
+//
+
+void Convert::prepareCorrelationSums(vector<vector<long double>>& sums,
+		const vector<double>& x, const vector<double>& y) {
+	int size = (int)x.size();
+	if ((int)y.size() < size) {
+		size = (int)y.size();
+	}
+
+	long double meanx = 0.0;
+	long double meany = 0.0;
+	for (int i=0; i<size; i++) {
+		meanx += x[i];
+		meany += y[i];
+	}
+	if (size > 0) {
+		meanx /= size;
+		meany /= size;
+	}
+
+	sums.resize(5);
+	for (int i=0; i<(int)sums.size(); i++) {
+		sums[i].resize(size + 1);
+		sums[i][0] = 0.0;
+	}
+	for (int i=0; i<size; i++) {
+		long double xi = x[i] - meanx;
+		long double yi = y[i] - meany;
+		sums[0][i+1] = sums[0][i] + xi;
+		sums[1][i+1] = sums[1][i] + yi;
+		sums[2][i+1] = sums[2][i] + xi * xi;
+		sums[3][i+1] = sums[3][i] + yi * yi;
+		sums[4][i+1] = sums[4][i] + xi * yi;
+	}
+}
+
+
+
+//////////////////////////////
+//
+// Convert::windowCorrelation -- Return the Pearson correlation of the
+//     window of the sequences given to prepareCorrelationSums() that starts
+//     at the given index.  A window where either sequence is flat returns
+//     NaN, like pearsonCorrelation().  Windows with very small variances
+//     compared to the running sums are not accurate, so give the input
+//     sequences as well when this is possible (see below).
+//
+
+double Convert::windowCorrelation(const vector<vector<long double>>& sums,
+		int start, int length) {
+	int end = start + length;
+	long double sx  = sums[0][end] - sums[0][start];
+	long double sy  = sums[1][end] - sums[1][start];
+	long double sxx = sums[2][end] - sums[2][start];
+	long double syy = sums[3][end] - sums[3][start];
+	long double sxy = sums[4][end] - sums[4][start];
+
+	long double varx = sxx - sx * sx / length;
+	long double vary = syy - sy * sy / length;
+	long double cov  = sxy - sx * sy / length;
+
+	// Variances at the level of rounding errors in the sums of squares
+	// of the window are for flat windows.
+	const long double tolerance = 1.0e-15;
+	if ((varx <= tolerance * sxx) || (vary <= tolerance * syy)) {
+		return std::nan("");
+	}
+
+	double output = (double)(cov / sqrtl(varx * vary));
+	if (output > 1.0) {
+		output = 1.0;
+	} else if (output < -1.0) {
+		output = -1.0;
+	}
+	return output;
+}
+
+
+//
+// Version which also is given the input sequences, so that windows which
+// cannot be calculated accurately from the running sums are calculated
+// directly with pearsonCorrelation().  The variance of a window is
+// calculated by subtracting running sums, so rounding errors are relative
+// to the size of the running sums rather than the size of the window
+// data.  Windows with a variance close to the rounding errors (such as
+// flat or nearly flat windows late in a long sequence) are recalculated.
+//
+
+double Convert::windowCorrelation(const vector<vector<long double>>& sums,
+		const vector<double>& x, const vector<double>& y, int start,
+		int length) {
+	int end = start + length;
+	long double sx  = sums[0][end] - sums[0][start];
+	long double sy  = sums[1][end] - sums[1][start];
+	long double varx = sums[2][end] - sums[2][start] - sx * sx / length;
+	long double vary = sums[3][end] - sums[3][start] - sy * sy / length;
+
+	auto scale = [&](int sum, int square) {
+		long double linear = fabsl(sums[sum][end]) + fabsl(sums[sum][start]);
+		return fabsl(sums[square][end]) + fabsl(sums[square][start]) +
+				linear * linear / length;
+	};
+
+	// Relative size of the window variance compared to the running sums
+	// below which rounding errors can be significant:
+	const long double tolerance = 1.0e-10;
+	if ((varx > tolerance * scale(0, 2)) && (vary > tolerance * scale(1, 3))) {
+		return windowCorrelation(sums, start, length);
+	}
+
+	vector<double> wx(x.begin() + start, x.begin() + end);
+	vector<double> wy(y.begin() + start, y.begin() + end);
+	double output = pearsonCorrelation(wx, wy);
+	if (output > 1.0) {
+		output = 1.0;
+	} else if (output < -1.0) {
+		output = -1.0;
+	}
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// Convert::correlationScape -- Calculate the Pearson correlation of
+//     every window of x and y that is at least two elements long.
+//     scape[i] contains the correlations for windows of length size-i,
+//     with scape[i][j] for the window starting at index j.  Rows are
+//     calculated in parallel if threads is not 1 (0 means to use all
+//     hardware threads).
+//
+
+void Convert::correlationScape(vector<vector<double>>& scape,
+		const vector<double>& x, const vector<double>& y, int threads) {
+	vector<vector<long double>> sums;
+	prepareCorrelationSums(sums, x, y);
+	int size = (int)sums[0].size() - 1;
+	scape.clear();
+	if (size < 2) {
+		return;
+	}
+	scape.resize(size - 1);
+
+	HumThreadPool pool(threads);
+	pool.run((int)scape.size(), [&](int i) {
+		int length = size - i;
+		scape[i].resize(i + 1);
+		for (int j=0; j<=i; j++) {
+			scape[i][j] = windowCorrelation(sums, x, y, j, length);
+		}
+	});
+}
+
+
+
 //////////////////////////////
 //
 // Convert::standardDeviation --
@@ -12128,6 +12292,21 @@ const HumdrumToken& HumAddress::getDataType(void) const {
 
 
 
+//////////////////////////////
+//
+// HumAddress::getDataTypeId -- Return the HumDataType ID of the exclusive
+//    interpretation of the token associated with the address.
+//
+
+int HumAddress::getDataTypeId(void) const {
+	if (m_owner == NULL) {
+		return datatype_unknown;
+	}
+	return m_owner->getTrackDataType(getTrack());
+}
+
+
+
 //////////////////////////////
 //
 // HumAddress::getExclusiveInterpretation -- Return the exclusive
@@ -12368,6 +12547,879 @@ void HumAddress::setSubtrackCount(int count) {
 
 
 
+
+
+//////////////////////////////
+//
+// HumCatalog::HumCatalog -- Constructor.
+//
+
+HumCatalog::HumCatalog(void) {
+	clear();
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::~HumCatalog -- Deconstructor.
+//
+
+HumCatalog::~HumCatalog() {
+	// do nothing
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::clear -- Remove all entries.
+//
+
+void HumCatalog::clear(void) {
+	m_count = 0;
+	m_columns.clear();
+	m_numbers.clear();
+	m_columns["filename"].clear();
+	m_columns["segment"].clear();
+	m_columns["offset"].clear();
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::addFile -- Add the file (or each !!!!SEGMENT in the file)
+//     to the catalog.  Returns false if the file cannot be read.
+//
+
+bool HumCatalog::addFile(const string& filename) {
+	ifstream input(filename, std::ios::binary);
+	if (!input.is_open()) {
+		cerr << "Error: cannot read " << filename << endl;
+		return false;
+	}
+	return addStream(input, filename);
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::addStream -- Add the entries for the contents of a stream.
+//     Only the reference records and interpretations before the first
+//     data line or barline of each entry are examined, so reference
+//     records at the end of a file are not in the catalog.  Files that
+//     do not contain !!!!SEGMENT records are not read past the header.
+//     In files that do, the rest of each segment is only checked for
+//     the next !!!!SEGMENT record.  Universal reference records before
+//     the first segment are included in every segment (as in
+//     HumdrumFileStream).
+//
+
+bool HumCatalog::addStream(istream& input, const string& filename) {
+	HumRegex hre;
+	map<string, string> fields;
+	map<string, string> universals;
+	string segment;
+	string line;
+	int64_t offset = 0;  // offset of the current line in the stream
+	int64_t start = 0;   // offset of the current entry in the stream
+	bool segmentQ = false; // currently in a !!!!SEGMENT
+	bool contentQ = false; // found something other than universal records
+	bool spinesQ  = false; // found exclusive interpretations
+	bool doneQ    = false; // finished with the header of the entry
+
+	while (getline(input, line)) {
+		int64_t length = (int64_t)line.size() + 1;
+		if ((!line.empty()) && (line.back() == 0x0d)) {
+			line.pop_back();
+		}
+		if (line.compare(0, 11, "!!!!SEGMENT") == 0) {
+			if (segmentQ || contentQ) {
+				addEntry(filename, segment, start, fields);
+			}
+			segment = "";
+			if (hre.search(line, R"(^!!!!SEGMENT\s*([+-]?\d+)?\s*:\s*(.*?)\s*$)")) {
+				segment = hre.getMatch(2);
+			}
+			fields = universals;
+			start = offset;
+			segmentQ = true;
+			contentQ = true;
+			spinesQ = false;
+			doneQ = false;
+		} else if (!doneQ) {
+			if ((!segmentQ) && (!contentQ) && (line.compare(0, 4, "!!!!") == 0)) {
+				HumdrumLine hline(line);
+				if (hline.isUniversalReference()) {
+					string key = hline.getReferenceKey();
+					if (universals.find(key) == universals.end()) {
+						universals[key] = hline.getReferenceValue();
+					}
+				}
+			} else if (!line.empty()) {
+				contentQ = true;
+			}
+			scanHeaderLine(line, fields, spinesQ, doneQ);
+		} else if (!segmentQ) {
+			// The rest of a file without segments is not needed.
+			break;
+		}
+		offset += length;
+	}
+
+	if (segmentQ || contentQ) {
+		addEntry(filename, segment, start, fields);
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::scanHeaderLine -- Add the information in a line from the
+//     header of an entry to the fields of the entry.  Reference records
+//     are stored by their key, and the spine count, **kern spine count,
+//     and first meter, key signature and key designation are taken from
+//     the interpretations.  doneQ is set to true at the first data line,
+//     barline or spine terminator.
+//
+
+void HumCatalog::scanHeaderLine(const string& line, map<string, string>& fields,
+		bool& spinesQ, bool& doneQ) {
+	if (line.empty()) {
+		return;
+	}
+
+	if (line[0] == '!') {
+		if (line.compare(0, 3, "!!!") != 0) {
+			return;
+		}
+		HumdrumLine hline(line);
+		if (!hline.isReference()) {
+			return;
+		}
+		string key = hline.getReferenceKey();
+		if (key == "SEGMENT") {
+			return;
+		}
+		if (fields.find(key) == fields.end()) {
+			fields[key] = hline.getReferenceValue();
+		}
+		return;
+	}
+
+	if (line[0] != '*') {
+		// data line or barline
+		doneQ = true;
+		return;
+	}
+
+	vector<string> tokens;
+	size_t fieldstart = 0;
+	while (true) {
+		size_t tab = line.find('\t', fieldstart);
+		if (tab == string::npos) {
+			tokens.push_back(line.substr(fieldstart));
+			break;
+		}
+		if (tab > fieldstart) {
+			tokens.push_back(line.substr(fieldstart, tab - fieldstart));
+		}
+		fieldstart = tab + 1;
+	}
+
+	if (!spinesQ) {
+		if (line.compare(0, 2, "**") != 0) {
+			return;
+		}
+		spinesQ = true;
+		int voices = 0;
+		for (int i=0; i<(int)tokens.size(); i++) {
+			if (tokens[i] == "**kern") {
+				voices++;
+			}
+		}
+		fields["spines"] = to_string(tokens.size());
+		fields["voices"] = to_string(voices);
+		return;
+	}
+
+	for (int i=0; i<(int)tokens.size(); i++) {
+		const string& token = tokens[i];
+		if (token == "*-") {
+			doneQ = true;
+		} else if ((token.size() > 2) && (token[1] == 'M') && isdigit(token[2])) {
+			if (fields.find("meter") == fields.end()) {
+				fields["meter"] = token.substr(2);
+			}
+		} else if ((token.compare(0, 3, "*k[") == 0) && (token.back() == ']')) {
+			if (fields.find("keysig") == fields.end()) {
+				fields["keysig"] = token.substr(3, token.size() - 4);
+			}
+		} else if ((token.size() > 2) && (token.back() == ':') &&
+				(string("ABCDEFGabcdefg").find(token[1]) != string::npos) &&
+				(token.find_first_not_of("#-", 2) == token.size() - 1)) {
+			if (fields.find("key") == fields.end()) {
+				fields["key"] = token.substr(1, token.size() - 2);
+			}
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::addEntry -- Add an entry with the given fields.
+//
+
+void HumCatalog::addEntry(const string& filename, const string& segment,
+		int64_t offset, map<string, string>& fields) {
+	fields["filename"] = filename;
+	fields["segment"]  = segment;
+	fields["offset"]   = to_string(offset);
+	for (auto& it : fields) {
+		vector<string>& column = m_columns[it.first];
+		column.resize(m_count);
+		column.push_back(it.second);
+	}
+	m_count++;
+	for (auto& it : m_columns) {
+		it.second.resize(m_count);
+	}
+	m_numbers.clear();
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::writeCatalog -- Write the catalog to a file.  Returns
+//     false if the file cannot be written.
+//
+
+bool HumCatalog::writeCatalog(const string& filename) {
+	std::ofstream output(filename, std::ios::binary);
+	if (!output.is_open()) {
+		cerr << "Error: cannot write " << filename << endl;
+		return false;
+	}
+	printCatalog(output);
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::printCatalog -- Print the catalog in the format read by
+//     readCatalog().
+//
+
+ostream& HumCatalog::printCatalog(ostream& out) {
+	out << "!!!!HUMCATALOG: " << m_count << "\n";
+	for (auto& it : m_columns) {
+		out << it.first;
+		for (int i=0; i<(int)it.second.size(); i++) {
+			out << '\t' << escapeValue(it.second[i]);
+		}
+		out << "\n";
+	}
+	return out;
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::readCatalog -- Read a catalog that was written with
+//     writeCatalog().  Returns false if the catalog cannot be read.
+//
+
+bool HumCatalog::readCatalog(const string& filename) {
+	ifstream input(filename, std::ios::binary);
+	if (!input.is_open()) {
+		cerr << "Error: cannot read " << filename << endl;
+		return false;
+	}
+	return readCatalog(input);
+}
+
+
+bool HumCatalog::readCatalog(istream& input) {
+	clear();
+	string line;
+	if (!getline(input, line) || (line.compare(0, 15, "!!!!HUMCATALOG:") != 0)) {
+		cerr << "Error: input is not a catalog" << endl;
+		return false;
+	}
+	int count = atoi(line.c_str() + 15);
+	while (getline(input, line)) {
+		if (line.empty()) {
+			continue;
+		}
+		vector<string> values;
+		size_t fieldstart = line.find('\t');
+		string field = line.substr(0, fieldstart);
+		while (fieldstart != string::npos) {
+			size_t tab = line.find('\t', fieldstart + 1);
+			size_t length = tab == string::npos ? string::npos : tab - fieldstart - 1;
+			values.push_back(unescapeValue(line.substr(fieldstart + 1, length)));
+			fieldstart = tab;
+		}
+		if ((int)values.size() != count) {
+			cerr << "Error: field " << field << " has " << values.size()
+			     << " values instead of " << count << endl;
+			clear();
+			return false;
+		}
+		m_columns[field] = std::move(values);
+	}
+	m_count = count;
+	for (auto& it : m_columns) {
+		it.second.resize(m_count);
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::escapeValue -- Escape tabs, newlines and backslashes.
+//
+
+string HumCatalog::escapeValue(const string& value) {
+	if (value.find_first_of("\t\n\r\\") == string::npos) {
+		return value;
+	}
+	string output;
+	for (int i=0; i<(int)value.size(); i++) {
+		switch (value[i]) {
+			case '\t': output += "\\t";  break;
+			case '\n': output += "\\n";  break;
+			case '\r': output += "\\r";  break;
+			case '\\': output += "\\\\"; break;
+			default:   output += value[i];
+		}
+	}
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::unescapeValue -- Undo escapeValue().
+//
+
+string HumCatalog::unescapeValue(const string& value) {
+	if (value.find('\\') == string::npos) {
+		return value;
+	}
+	string output;
+	for (int i=0; i<(int)value.size(); i++) {
+		if ((value[i] != '\\') || (i == (int)value.size() - 1)) {
+			output += value[i];
+			continue;
+		}
+		i++;
+		switch (value[i]) {
+			case 't': output += '\t'; break;
+			case 'n': output += '\n'; break;
+			case 'r': output += '\r'; break;
+			default:  output += value[i];
+		}
+	}
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::getEntryCount -- Return the number of entries.
+//
+
+int HumCatalog::getEntryCount(void) const {
+	return m_count;
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::getFieldNames -- Return the names of the fields in the
+//     catalog.
+//
+
+vector<string> HumCatalog::getFieldNames(void) const {
+	vector<string> output;
+	for (auto& it : m_columns) {
+		output.push_back(it.first);
+	}
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::hasField -- Returns true if any entry has the field.
+//
+
+bool HumCatalog::hasField(const string& field) const {
+	return m_columns.find(field) != m_columns.end();
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::getValue -- Return the value of a field for an entry, or
+//     an empty string if the entry does not have the field.
+//
+
+const string& HumCatalog::getValue(int entry, const string& field) const {
+	static const string empty;
+	auto it = m_columns.find(field);
+	if ((it == m_columns.end()) || (entry < 0) || (entry >= m_count)) {
+		return empty;
+	}
+	return it->second[entry];
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::getFilename -- Return the file that contains an entry.
+//
+
+const string& HumCatalog::getFilename(int entry) const {
+	return getValue(entry, "filename");
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::getSegment -- Return the !!!!SEGMENT name of an entry, or
+//     an empty string if the file does not contain segments.
+//
+
+const string& HumCatalog::getSegment(int entry) const {
+	return getValue(entry, "segment");
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::getOffset -- Return the byte offset of an entry in its
+//     file (the position of its !!!!SEGMENT record).
+//
+
+int64_t HumCatalog::getOffset(int entry) const {
+	return strtoll(getValue(entry, "offset").c_str(), NULL, 10);
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::readEntry -- Read the Humdrum data of an entry, starting
+//     at its offset in the file and stopping at the next !!!!SEGMENT
+//     record.  Universal records before the first segment of the file
+//     are not included.  Returns false if the data cannot be read.
+//
+
+bool HumCatalog::readEntry(int entry, HumdrumFile& infile) {
+	const string& filename = getFilename(entry);
+	const string& segment = getSegment(entry);
+	ifstream input(filename, std::ios::binary);
+	if (!input.is_open()) {
+		cerr << "Error: cannot read " << filename << endl;
+		return false;
+	}
+	input.seekg(getOffset(entry));
+
+	stringstream contents;
+	string line;
+	bool firstQ = true;
+	while (getline(input, line)) {
+		// Always stop at the next segment, also for entries without a
+		// segment name (such as data before the first segment).
+		if ((!firstQ) && (line.compare(0, 11, "!!!!SEGMENT") == 0)) {
+			break;
+		}
+		contents << line << "\n";
+		firstQ = false;
+	}
+
+	HumdrumFileStream instream(contents.str());
+	if (!instream.read(infile)) {
+		return false;
+	}
+	if (infile.getFilename().empty()) {
+		infile.setFilename(segment.empty() ? filename : segment);
+	}
+	return infile.isValid();
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::getAllEntries -- Return the indexes of all entries.
+//
+
+vector<int> HumCatalog::getAllEntries(void) const {
+	vector<int> output(m_count);
+	for (int i=0; i<m_count; i++) {
+		output[i] = i;
+	}
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::findEqual -- Return the entries that have the given value
+//     for a field.
+//
+
+vector<int> HumCatalog::findEqual(const string& field, const string& value) const {
+	auto it = m_columns.find(field);
+	if (it == m_columns.end()) {
+		return value.empty() ? getAllEntries() : vector<int>();
+	}
+	vector<int> output;
+	const vector<string>& column = it->second;
+	for (int i=0; i<(int)column.size(); i++) {
+		if (column[i] == value) {
+			output.push_back(i);
+		}
+	}
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::findPrefix -- Return the entries whose value for a field
+//     starts with the given string.
+//
+
+vector<int> HumCatalog::findPrefix(const string& field, const string& prefix) const {
+	auto it = m_columns.find(field);
+	if (it == m_columns.end()) {
+		return prefix.empty() ? getAllEntries() : vector<int>();
+	}
+	vector<int> output;
+	const vector<string>& column = it->second;
+	for (int i=0; i<(int)column.size(); i++) {
+		if (column[i].compare(0, prefix.size(), prefix) == 0) {
+			output.push_back(i);
+		}
+	}
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::findRange -- Return the entries whose value for a field is
+//     a number between the minimum and maximum (inclusive).
+//
+
+vector<int> HumCatalog::findRange(const string& field, double minimum,
+		double maximum) {
+	vector<int> output;
+	if (!hasField(field)) {
+		return output;
+	}
+	const vector<double>& numbers = getNumbers(field);
+	for (int i=0; i<(int)numbers.size(); i++) {
+		if ((numbers[i] >= minimum) && (numbers[i] <= maximum)) {
+			output.push_back(i);
+		}
+	}
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::getNumbers -- Return the numeric values of a field, which
+//     are NAN for values that are not numbers.  The values are converted
+//     when a field is first used in a range query.
+//
+
+const vector<double>& HumCatalog::getNumbers(const string& field) {
+	auto found = m_numbers.find(field);
+	if (found != m_numbers.end()) {
+		return found->second;
+	}
+	vector<double>& numbers = m_numbers[field];
+	const vector<string>& column = m_columns[field];
+	numbers.resize(column.size());
+	for (int i=0; i<(int)column.size(); i++) {
+		const char* value = column[i].c_str();
+		char* end = NULL;
+		double number = strtod(value, &end);
+		while ((end != NULL) && isspace(*end)) {
+			end++;
+		}
+		if ((end == value) || (end == NULL) || (*end != '\0')) {
+			number = NAN;
+		}
+		numbers[i] = number;
+	}
+	return numbers;
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::query -- Return the entries that match all of the conditions
+//     in a query, separated by semicolons.  Conditions are a field name,
+//     an operator and a value:
+//        =   value is equal
+//        ^=  value starts with
+//        <, <=, >, >=   numeric comparisons
+//     Example: "COM^=Bach; voices>=4; meter=3/4"
+//
+
+vector<int> HumCatalog::query(const string& expression) {
+	vector<int> output = getAllEntries();
+	stringstream conditions(expression);
+	string condition;
+	while (getline(conditions, condition, ';')) {
+		condition = Convert::trimWhiteSpace(condition);
+		if (condition.empty()) {
+			continue;
+		}
+		output = intersect(output, queryCondition(condition));
+	}
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::queryCondition -- Return the entries that match a single
+//     condition of a query.
+//
+
+vector<int> HumCatalog::queryCondition(const string& condition) {
+	size_t index = condition.find_first_of("^=<>");
+	if (index == string::npos) {
+		cerr << "Error: no operator in query condition " << condition << endl;
+		return vector<int>();
+	}
+	string op = condition.substr(index, 1);
+	if ((index + 1 < condition.size()) && (condition[index + 1] == '=') &&
+			(op != "=")) {
+		op += '=';
+	}
+	string field = Convert::trimWhiteSpace(condition.substr(0, index));
+	string value = Convert::trimWhiteSpace(condition.substr(index + op.size()));
+
+	if (op == "=") {
+		return findEqual(field, value);
+	} else if (op == "^=") {
+		return findPrefix(field, value);
+	} else if (op == "^") {
+		cerr << "Error: use ^= for prefix queries in " << condition << endl;
+		return vector<int>();
+	}
+
+	char* end = NULL;
+	double number = strtod(value.c_str(), &end);
+	if ((end == value.c_str()) || (*end != '\0')) {
+		cerr << "Error: " << value << " is not a number in query condition "
+		     << condition << endl;
+		return vector<int>();
+	}
+	if (op == "<") {
+		return findRange(field, -INFINITY, nextafter(number, -INFINITY));
+	} else if (op == "<=") {
+		return findRange(field, -INFINITY, number);
+	} else if (op == ">") {
+		return findRange(field, nextafter(number, INFINITY), INFINITY);
+	} else {
+		return findRange(field, number, INFINITY);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::intersect -- Return the entries that are in both sorted
+//     lists.
+//
+
+vector<int> HumCatalog::intersect(const vector<int>& a, const vector<int>& b) {
+	vector<int> output;
+	output.reserve(a.size() < b.size() ? a.size() : b.size());
+	int i = 0;
+	int j = 0;
+	while ((i < (int)a.size()) && (j < (int)b.size())) {
+		if (a[i] < b[j]) {
+			i++;
+		} else if (b[j] < a[i]) {
+			j++;
+		} else {
+			output.push_back(a[i]);
+			i++;
+			j++;
+		}
+	}
+	return output;
+}
+
+
+
+
+
+
+//////////////////////////////
+//
+// HumDataType::Registry::Registry -- Register the builtin data types
+//     in the order of the datatype_id enumeration.
+//
+
+HumDataType::Registry::Registry(void) {
+	addName("");
+	addName("**kern");
+	addName("**mens");
+	addName("**text");
+	addName("**recip");
+	addName("**dynam");
+}
+
+
+
+//////////////////////////////
+//
+// HumDataType::Registry::addName -- Add a new data type and return its ID.
+//     The mutex must be locked by the caller (except in the constructor).
+//
+
+int HumDataType::Registry::addName(const string& exinterp) {
+	int id = (int)names.size();
+	names.push_back(exinterp);
+	ids[exinterp] = id;
+	return id;
+}
+
+
+
+//////////////////////////////
+//
+// HumDataType::getRegistry -- Return the registry, which is created on
+//     first use.
+//
+
+HumDataType::Registry& HumDataType::getRegistry(void) {
+	static Registry registry;
+	return registry;
+}
+
+
+
+//////////////////////////////
+//
+// HumDataType::getId -- Return the ID for an exclusive interpretation,
+//     registering it if it has not been seen before.  The leading "**"
+//     is optional, and an empty string is datatype_unknown.
+//
+
+int HumDataType::getId(const string& exinterp) {
+	if (exinterp.empty()) {
+		return datatype_unknown;
+	}
+	if (exinterp.compare(0, 2, "**") != 0) {
+		return getId("**" + exinterp);
+	}
+	Registry& registry = getRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	auto it = registry.ids.find(exinterp);
+	if (it != registry.ids.end()) {
+		return it->second;
+	}
+	return registry.addName(exinterp);
+}
+
+
+
+//////////////////////////////
+//
+// HumDataType::findId -- Return the ID for an exclusive interpretation,
+//     or -1 if it has not been registered.  Use this instead of getId()
+//     for queries that should not add data types.
+//
+
+int HumDataType::findId(const string& exinterp) {
+	if (exinterp.empty()) {
+		return datatype_unknown;
+	}
+	if (exinterp.compare(0, 2, "**") != 0) {
+		return findId("**" + exinterp);
+	}
+	Registry& registry = getRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	auto it = registry.ids.find(exinterp);
+	if (it != registry.ids.end()) {
+		return it->second;
+	}
+	return -1;
+}
+
+
+
+//////////////////////////////
+//
+// HumDataType::getName -- Return the exclusive interpretation for an ID.
+//     Unknown IDs return an empty string.
+//
+
+const string& HumDataType::getName(int id) {
+	Registry& registry = getRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	if ((id < 0) || (id >= (int)registry.names.size())) {
+		return registry.names[datatype_unknown];
+	}
+	return registry.names[id];
+}
+
+
+
+//////////////////////////////
+//
+// HumDataType::getCount -- Return the number of registered data types.
+//
+
+int HumDataType::getCount(void) {
+	Registry& registry = getRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	return (int)registry.names.size();
+}
+
+
+
+
 //////////////////////////////
 //
 // HumGrid::HumGrid -- Constructor.
@@ -17452,6 +18504,737 @@ void HumInstrument::sortData(void) {
 
 
 
+
+
+//////////////////////////////
+//
+// HumKeyWindow::HumKeyWindow -- Uses Kostka-Payne key weights by default.
+//
+
+HumKeyWindow::HumKeyWindow(void) {
+	vector<double> major;
+	vector<double> minor;
+	getKostkaPayneWeights(major, minor);
+	setWeights(major, minor);
+	clear();
+}
+
+
+
+//////////////////////////////
+//
+// HumKeyWindow::setWeights -- Set the key profiles for C major and C minor.
+//     The Pearson correlation of a histogram with each rotated profile
+//     is the dot product of the normalized profile with the histogram
+//     divided by the deviation of the histogram, so the profiles are
+//     normalized here.
+//
+
+void HumKeyWindow::setWeights(const vector<double>& major,
+		const vector<double>& minor) {
+	for (int m=0; m<2; m++) {
+		const vector<double>& weights = m ? minor : major;
+		double mean = 0.0;
+		for (int i=0; i<12; i++) {
+			mean += weights[i];
+		}
+		mean /= 12.0;
+		double sum = 0.0;
+		for (int i=0; i<12; i++) {
+			sum += (weights[i] - mean) * (weights[i] - mean);
+		}
+		double norm = sqrt(sum);
+		for (int tonic=0; tonic<12; tonic++) {
+			for (int pc=0; pc<12; pc++) {
+				double value = weights[(pc - tonic + 12) % 12] - mean;
+				m_keyweights[m*12 + tonic][pc] = value / norm;
+			}
+		}
+	}
+}
+
+
+
+///////////////////////////////
+//
+// HumKeyWindow::getKostkaPayneWeights -- Key profiles for C major and
+//     C minor, found in David Temperley: Music and Probability 2006.
+//
+
+void HumKeyWindow::getKostkaPayneWeights(vector<double>& maj, vector<double>& min) {
+	maj.resize(12);
+	min.resize(12);
+
+	maj[0]  = 0.748;	// C major weights
+	maj[1]  = 0.060;	// C#
+	maj[2]  = 0.488;	// D
+	maj[3]  = 0.082;	// D#
+	maj[4]  = 0.670;	// E
+	maj[5]  = 0.460;	// F
+	maj[6]  = 0.096;	// F#
+	maj[7]  = 0.715;	// G
+	maj[8]  = 0.104;	// G#
+	maj[9]  = 0.366;	// A
+	maj[10] = 0.057;	// A#
+	maj[11] = 0.400;	// B
+	min[0]  = 0.712;	// c minor weights
+	min[1]  = 0.084;	// c#
+	min[2]  = 0.474;	// d
+	min[3]  = 0.618;	// d#
+	min[4]  = 0.049;	// e
+	min[5]  = 0.460;	// f
+	min[6]  = 0.105;	// f#
+	min[7]  = 0.747;	// g
+	min[8]  = 0.404;	// g#
+	min[9]  = 0.067;	// a
+	min[10] = 0.133;	// a#
+	min[11] = 0.330;	// b
+}
+
+
+
+//////////////////////////////
+//
+// HumKeyWindow::clear -- Empty the window.
+//
+
+void HumKeyWindow::clear(void) {
+	m_histogram.assign(12, 0.0);
+	m_active   = 0;
+	m_segments = NULL;
+	m_start    = 0;
+	m_end      = 0;
+}
+
+
+
+//////////////////////////////
+//
+// HumKeyWindow::addSegment -- Add a 12-element pitch-class histogram to
+//     the window.
+//
+
+void HumKeyWindow::addSegment(const vector<double>& histogram) {
+	bool active = false;
+	for (int i=0; i<12; i++) {
+		if (histogram[i] != 0.0) {
+			m_histogram[i] += histogram[i];
+			active = true;
+		}
+	}
+	if (active) {
+		m_active++;
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumKeyWindow::removeSegment -- Subtract a histogram that was added
+//     to the window.  Once no segments with notes are left, the histogram
+//     is reset so that rounding errors do not accumulate.
+//
+
+void HumKeyWindow::removeSegment(const vector<double>& histogram) {
+	bool active = false;
+	for (int i=0; i<12; i++) {
+		if (histogram[i] != 0.0) {
+			m_histogram[i] -= histogram[i];
+			active = true;
+		}
+	}
+	if (active) {
+		m_active--;
+	}
+	if (m_active <= 0) {
+		m_histogram.assign(12, 0.0);
+		m_active = 0;
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumKeyWindow::setWindow -- Move the window to the segments from start
+//     to start+length-1 (limited to the end of the list).  Segments that
+//     are already in the window from the previous call with the same list
+//     are not added again.  The segment list must not change between calls.
+//
+
+void HumKeyWindow::setWindow(const vector<vector<double>>& segments,
+		int start, int length) {
+	int end = start + length;
+	if (end > (int)segments.size()) {
+		end = (int)segments.size();
+	}
+	if (start < 0) {
+		start = 0;
+	}
+	if (end < start) {
+		end = start;
+	}
+
+	if ((m_segments != &segments) || (start >= m_end) || (end <= m_start)
+			|| (start < m_start) || (end < m_end)) {
+		// Not sliding forward through the same list, so start over:
+		clear();
+		for (int i=start; i<end; i++) {
+			addSegment(segments[i]);
+		}
+	} else {
+		for (int i=m_start; i<start; i++) {
+			removeSegment(segments[i]);
+		}
+		for (int i=m_end; i<end; i++) {
+			addSegment(segments[i]);
+		}
+	}
+	m_segments = &segments;
+	m_start    = start;
+	m_end      = end;
+}
+
+
+
+//////////////////////////////
+//
+// HumKeyWindow::getHistogram -- Return the pitch-class histogram of
+//     the window.
+//
+
+const vector<double>& HumKeyWindow::getHistogram(void) const {
+	return m_histogram;
+}
+
+
+
+//////////////////////////////
+//
+// HumKeyWindow::isEmpty -- Return true if the window contains no notes.
+//
+
+bool HumKeyWindow::isEmpty(void) const {
+	return m_active == 0;
+}
+
+
+
+//////////////////////////////
+//
+// HumKeyWindow::getCorrelations -- Return the Pearson correlations of the
+//     window's histogram with the 12 major key profiles (C to B), followed
+//     by the 12 minor key profiles.  If the histogram is flat, the
+//     correlations are NaN.
+//
+
+void HumKeyWindow::getCorrelations(vector<double>& correls) const {
+	double mean = 0.0;
+	for (int i=0; i<12; i++) {
+		mean += m_histogram[i];
+	}
+	mean /= 12.0;
+	double centered[12];
+	double sum = 0.0;
+	for (int i=0; i<12; i++) {
+		centered[i] = m_histogram[i] - mean;
+		sum += centered[i] * centered[i];
+	}
+	double scale = 1.0 / sqrt(sum);
+
+	correls.resize(24);
+	for (int k=0; k<24; k++) {
+		const double* weights = m_keyweights[k];
+		double dot = 0.0;
+		for (int i=0; i<12; i++) {
+			dot += weights[i] * centered[i];
+		}
+		correls[k] = dot * scale;
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumKeyWindow::getBestKey -- Return the index of the key with the highest
+//     correlation (0-11 for major keys, 12-23 for minor keys), or -1 if
+//     the window contains no notes.
+//
+
+int HumKeyWindow::getBestKey(void) const {
+	if (isEmpty()) {
+		return -1;
+	}
+	vector<double> correls;
+	getCorrelations(correls);
+	int output = 0;
+	for (int i=1; i<24; i++) {
+		if (correls[i] > correls[output]) {
+			output = i;
+		}
+	}
+	return output;
+}
+
+
+
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::HumLyricIndex -- Constructor.
+//
+
+HumLyricIndex::HumLyricIndex(void) {
+	// do nothing
+}
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::~HumLyricIndex -- Deconstructor.
+//
+
+HumLyricIndex::~HumLyricIndex() {
+	// do nothing
+}
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::clear -- Remove all files and words.
+//
+
+void HumLyricIndex::clear(void) {
+	m_filenames.clear();
+	m_entries.clear();
+	m_words.clear();
+}
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::addFile -- Add the words of a file to the index.  The
+//     **silbe spines are used if there are any, otherwise the **text
+//     spines.  A syllable starting with "-" continues the previous word,
+//     and a trailing "-" is removed from each syllable.  Returns the index
+//     of the file in the index.  The filename version adds each segment
+//     of the file, and returns false if the file cannot be read.
+//
+
+int HumLyricIndex::addFile(HumdrumFile& infile) {
+	int file = (int)m_filenames.size();
+	m_filenames.push_back(infile.getFilename());
+	int startentry = (int)m_entries.size();
+
+	vector<HTp> textspines;
+	infile.getSpineStartList(textspines, "**silbe");
+	if (textspines.empty()) {
+		infile.getSpineStartList(textspines, "**text");
+	}
+	for (int i=0; i<(int)textspines.size(); i++) {
+		addWordsForSpine(file, textspines[i]);
+	}
+
+	indexEntries(startentry);
+	return file;
+}
+
+
+bool HumLyricIndex::addFile(const string& filename) {
+	ifstream input(filename, std::ios::binary);
+	if (!input.is_open()) {
+		cerr << "Error: cannot read " << filename << endl;
+		return false;
+	}
+	input.close();
+	vector<string> list(1, filename);
+	HumdrumFileStream instream(list);
+	HumdrumFile infile;
+	while (instream.read(infile)) {
+		addFile(infile);
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::addWordsForSpine -- Add the words in a text spine.
+//     A continuing syllable at the start of the spine is added to the
+//     last word of the previous spine (as in Tool_msearch).
+//
+
+void HumLyricIndex::addWordsForSpine(int file, HTp starttoken) {
+	int track = starttoken->getTrack();
+	bool hasword = (!m_entries.empty()) && (m_entries.back().file == file);
+	HTp tok = starttoken->getNextToken();
+	while (tok != NULL) {
+		if (tok->empty() || tok->isNull() || !tok->isData()) {
+			tok = tok->getNextToken();
+			continue;
+		}
+		if (tok->at(0) == '-') {
+			// append a syllable to the end of previous word
+			if (hasword) {
+				string& word = m_entries.back().word;
+				word += tok->substr(1, string::npos);
+				if ((!word.empty()) && (word.back() == '-')) {
+					word.pop_back();
+				}
+			}
+		} else {
+			// start a new word
+			m_entries.emplace_back();
+			HumLyricEntry& entry = m_entries.back();
+			entry.file  = file;
+			entry.track = track;
+			entry.line  = tok->getLineIndex();
+			entry.field = tok->getFieldIndex();
+			entry.word  = *tok;
+			if (entry.word.back() == '-') {
+				entry.word.pop_back();
+			}
+			hasword = true;
+		}
+		tok = tok->getNextToken();
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::indexEntries -- Add the entries from startentry to the
+//     end of the entry list to the word index.
+//
+
+void HumLyricIndex::indexEntries(int startentry) {
+	for (int i=startentry; i<(int)m_entries.size(); i++) {
+		m_words[foldCase(m_entries[i].word)].push_back(i);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::writeIndex -- Write the index to a file.  Returns
+//     false if the file cannot be written.
+//
+
+bool HumLyricIndex::writeIndex(const string& filename) {
+	std::ofstream output(filename, std::ios::binary);
+	if (!output.is_open()) {
+		cerr << "Error: cannot write " << filename << endl;
+		return false;
+	}
+	printIndex(output);
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::printIndex -- Print the index in the format read by
+//     readIndex().
+//
+
+ostream& HumLyricIndex::printIndex(ostream& out) {
+	out << "!!!!HUMLYRICINDEX: " << m_entries.size() << "\n";
+	for (int i=0; i<(int)m_filenames.size(); i++) {
+		out << "file\t" << m_filenames[i] << "\n";
+	}
+	for (int i=0; i<(int)m_entries.size(); i++) {
+		const HumLyricEntry& entry = m_entries[i];
+		out << "word\t" << entry.file << '\t' << entry.track << '\t'
+		    << entry.line << '\t' << entry.field << '\t' << entry.word << "\n";
+	}
+	return out;
+}
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::readIndex -- Read an index that was written with
+//     writeIndex().  Returns false if the index cannot be read.
+//
+
+bool HumLyricIndex::readIndex(const string& filename) {
+	ifstream input(filename, std::ios::binary);
+	if (!input.is_open()) {
+		cerr << "Error: cannot read " << filename << endl;
+		return false;
+	}
+	return readIndex(input);
+}
+
+
+bool HumLyricIndex::readIndex(istream& input) {
+	clear();
+	string line;
+	if (!getline(input, line) || (line.compare(0, 18, "!!!!HUMLYRICINDEX:") != 0)) {
+		cerr << "Error: input is not a lyric index" << endl;
+		return false;
+	}
+	m_entries.reserve(atoi(line.c_str() + 18));
+	while (getline(input, line)) {
+		if (line.compare(0, 5, "file\t") == 0) {
+			m_filenames.push_back(line.substr(5));
+			continue;
+		}
+		if (line.compare(0, 5, "word\t") != 0) {
+			continue;
+		}
+		HumLyricEntry entry;
+		const char* ptr = line.c_str() + 5;
+		char* end;
+		entry.file  = (int)strtol(ptr, &end, 10); ptr = end;
+		entry.track = (int)strtol(ptr, &end, 10); ptr = end;
+		entry.line  = (int)strtol(ptr, &end, 10); ptr = end;
+		entry.field = (int)strtol(ptr, &end, 10); ptr = end;
+		if ((*ptr != '\t') || (entry.file < 0) ||
+				(entry.file >= (int)m_filenames.size())) {
+			cerr << "Error: invalid lyric index line: " << line << endl;
+			clear();
+			return false;
+		}
+		entry.word = ptr + 1;
+		m_entries.push_back(std::move(entry));
+	}
+	indexEntries(0);
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::getEntryCount -- Return the number of words.
+//
+
+int HumLyricIndex::getEntryCount(void) const {
+	return (int)m_entries.size();
+}
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::getFileCount -- Return the number of files.
+//
+
+int HumLyricIndex::getFileCount(void) const {
+	return (int)m_filenames.size();
+}
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::getFilename -- Return the filename of a file.
+//
+
+const string& HumLyricIndex::getFilename(int file) const {
+	return m_filenames.at(file);
+}
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::getEntry -- Return a word and its location.
+//
+
+const HumLyricEntry& HumLyricIndex::getEntry(int entry) const {
+	return m_entries.at(entry);
+}
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::getNextEntry -- Return the next word of the same file,
+//     which ends the syllables of the given word, or -1 if the given
+//     word is the last one in the file.
+//
+
+int HumLyricIndex::getNextEntry(int entry) const {
+	if (entry + 1 >= (int)m_entries.size()) {
+		return -1;
+	}
+	if (m_entries[entry + 1].file != m_entries[entry].file) {
+		return -1;
+	}
+	return entry + 1;
+}
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::getToken -- Return the first syllable of a word in the
+//     file that the word was indexed from, or NULL if the location is not
+//     in the file.
+//
+
+HTp HumLyricIndex::getToken(int entry, HumdrumFile& infile) const {
+	const HumLyricEntry& item = m_entries.at(entry);
+	if ((item.line < 0) || (item.line >= infile.getLineCount())) {
+		return NULL;
+	}
+	if ((item.field < 0) || (item.field >= infile[item.line].getFieldCount())) {
+		return NULL;
+	}
+	return infile.token(item.line, item.field);
+}
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::findWord -- Return the entries of a word.
+//
+
+vector<int> HumLyricIndex::findWord(const string& word) const {
+	auto it = m_words.find(foldCase(word));
+	if (it == m_words.end()) {
+		return vector<int>();
+	}
+	return it->second;
+}
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::findPrefix -- Return the entries of words starting
+//     with the given string.
+//
+
+vector<int> HumLyricIndex::findPrefix(const string& prefix) const {
+	string folded = foldCase(prefix);
+	vector<int> output;
+	for (auto it = m_words.lower_bound(folded); it != m_words.end(); it++) {
+		if (it->first.compare(0, folded.size(), folded) != 0) {
+			break;
+		}
+		output.insert(output.end(), it->second.begin(), it->second.end());
+	}
+	std::sort(output.begin(), output.end());
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::findWildcard -- Return the entries of words matching a
+//     pattern, where "*" matches any number of characters and "?" matches
+//     a single character.  Only the words starting with the text before
+//     the first wildcard are checked.
+//
+
+vector<int> HumLyricIndex::findWildcard(const string& pattern) const {
+	string folded = foldCase(pattern);
+	size_t wildcard = folded.find_first_of("*?");
+	if (wildcard == string::npos) {
+		return findWord(folded);
+	}
+	string prefix = folded.substr(0, wildcard);
+	vector<int> output;
+	for (auto it = m_words.lower_bound(prefix); it != m_words.end(); it++) {
+		if (it->first.compare(0, prefix.size(), prefix) != 0) {
+			break;
+		}
+		if (wildcardMatch(folded.c_str(), it->first.c_str())) {
+			output.insert(output.end(), it->second.begin(), it->second.end());
+		}
+	}
+	std::sort(output.begin(), output.end());
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::findRegex -- Return the entries of words containing
+//     a match to a regular expression.  The expression is compiled once
+//     and checked once for each distinct word.
+//
+
+vector<int> HumLyricIndex::findRegex(const string& exp) const {
+	regex re(exp, regex::ECMAScript | regex::icase);
+	vector<int> output;
+	for (auto& it : m_words) {
+		if (regex_search(it.first, re)) {
+			output.insert(output.end(), it.second.begin(), it.second.end());
+		}
+	}
+	std::sort(output.begin(), output.end());
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::foldCase -- Convert ASCII letters to lower case.
+//
+
+string HumLyricIndex::foldCase(const string& input) {
+	string output = input;
+	for (int i=0; i<(int)output.size(); i++) {
+		output[i] = tolower((unsigned char)output[i]);
+	}
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::wildcardMatch -- Return true if the text matches the
+//     pattern, where "*" matches any number of characters and "?" matches
+//     a single character.
+//
+
+bool HumLyricIndex::wildcardMatch(const char* pattern, const char* text) {
+	const char* star = NULL;   // position of the last "*" in the pattern
+	const char* retry = NULL;  // position in the text to retry after a "*"
+	while (*text) {
+		if ((*pattern == '?') || (*pattern == *text)) {
+			pattern++;
+			text++;
+		} else if (*pattern == '*') {
+			star = pattern++;
+			retry = text;
+		} else if (star) {
+			pattern = star + 1;
+			text = ++retry;
+		} else {
+			return false;
+		}
+	}
+	while (*pattern == '*') {
+		pattern++;
+	}
+	return *pattern == '\0';
+}
+
+
+
+
 //////////////////////////////
 //
 // HumNum::HumNum -- HumNum Constructor.  Set the default value
@@ -18344,6 +20127,501 @@ ostream& operator<<(ostream& out, const HumNum& number) {
 
 
 
+ostream& operator<<(ostream& out, const HumNum64& number) {
+	number.printFraction(out);
+	return out;
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::HumNum64 -- HumNum64 Constructor.  Set the default value
+//   of the number to zero, or the given number if specified.
+//
+
+HumNum64::HumNum64(void) {
+	top = 0;
+	bot = 1;
+}
+
+
+HumNum64::HumNum64(int64_t value) {
+	top = value;
+	bot = 1;
+}
+
+
+HumNum64::HumNum64(int64_t numerator, int64_t denominator) {
+	setValue(numerator, denominator);
+}
+
+
+HumNum64::HumNum64(const HumNum& value) {
+	if (value.isNaN() || value.isInfinite()) {
+		top = 0;
+		bot = 0;
+	} else {
+		setValue(value.getNumerator(), value.getDenominator());
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::setValue -- Set the number from a numerator and denominator.
+//    The fraction is reduced and the sign is kept in the numerator.  A zero
+//    denominator gives NaN (infinity is not represented).
+//
+
+void HumNum64::setValue(int64_t numerator, int64_t denominator) {
+	if ((denominator == 0) || ((denominator < 0) &&
+			((numerator == INT64_MIN) || (denominator == INT64_MIN)))) {
+		top = 0;
+		bot = 0;
+		return;
+	}
+	if (denominator < 0) {
+		numerator = -numerator;
+		denominator = -denominator;
+	}
+	int64_t gcdval = gcd(numerator, denominator);
+	if (gcdval > 1) {
+		numerator /= gcdval;
+		denominator /= gcdval;
+	}
+	top = numerator;
+	bot = denominator;
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::isNaN -- Returns true if the number is not valid, which
+//     happens when a calculation overflows or divides by zero.
+//
+
+bool HumNum64::isNaN(void) const {
+	return bot == 0;
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::isNegative -- Returns true if value is negative.
+//
+
+bool HumNum64::isNegative(void) const {
+	return (bot != 0) && (top < 0);
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::isPositive -- Returns true if value is positive.
+//
+
+bool HumNum64::isPositive(void) const {
+	return (bot != 0) && (top > 0);
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::isZero -- Returns true if value is zero.
+//
+
+bool HumNum64::isZero(void) const {
+	return (bot != 0) && (top == 0);
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::isInteger -- Returns true if the denominator is 1.
+//
+
+bool HumNum64::isInteger(void) const {
+	return bot == 1;
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::getFloat -- Returns the floating-point equivalent of the
+//     rational number.
+//
+
+double HumNum64::getFloat(void) const {
+	return (double)top / (double)bot;
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::getHumNum -- Convert to a HumNum.  Returns false if the
+//     number is NaN or does not fit into a HumNum.
+//
+
+bool HumNum64::getHumNum(HumNum& output) const {
+	if (isNaN() || (top > INT_MAX) || (top < INT_MIN) || (bot > INT_MAX)) {
+		return false;
+	}
+	output.setValue((int)top, (int)bot);
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::getTicks -- Return the number as an integer count of ticks
+//     at the given number of ticks per unit (such as ticks per quarter
+//     note for durations).  Returns false if the number is NaN, is not
+//     an integer number of ticks, or if the tick count overflows.
+//
+
+bool HumNum64::getTicks(int64_t tpq, int64_t& ticks) const {
+	if (isNaN() || (tpq <= 0) || (tpq % bot != 0)) {
+		return false;
+	}
+	return multiply(top, tpq / bot, ticks);
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::operator+ -- Addition operator.
+//
+
+HumNum64 HumNum64::operator+(const HumNum64& value) const {
+	HumNum64 output;
+	output.top = 0;
+	output.bot = 0;
+	if (isNaN() || value.isNaN()) {
+		return output;
+	}
+	int64_t gcdval = gcd(bot, value.bot);
+	int64_t denominator;
+	int64_t a;
+	int64_t b;
+	int64_t numerator;
+	if (!multiply(bot / gcdval, value.bot, denominator)) {
+		return output;
+	}
+	if (!multiply(top, denominator / bot, a)) {
+		return output;
+	}
+	if (!multiply(value.top, denominator / value.bot, b)) {
+		return output;
+	}
+	if (!add(a, b, numerator)) {
+		return output;
+	}
+	output.setValue(numerator, denominator);
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::operator- -- Subtraction and negation operators.
+//
+
+HumNum64 HumNum64::operator-(const HumNum64& value) const {
+	return *this + (-value);
+}
+
+
+HumNum64 HumNum64::operator-(void) const {
+	HumNum64 output;
+	if (isNaN() || (top == INT64_MIN)) {
+		output.bot = 0;
+	} else {
+		output.top = -top;
+		output.bot = bot;
+	}
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::operator* -- Multiplication operator.  Common factors
+//    are removed before multiplying to avoid unnecessary overflows.
+//
+
+HumNum64 HumNum64::operator*(const HumNum64& value) const {
+	HumNum64 output;
+	output.bot = 0;
+	if (isNaN() || value.isNaN()) {
+		return output;
+	}
+	int64_t gcd1 = gcd(top, value.bot);
+	int64_t gcd2 = gcd(value.top, bot);
+	if (gcd1 == 0) {
+		gcd1 = 1;
+	}
+	if (gcd2 == 0) {
+		gcd2 = 1;
+	}
+	int64_t numerator;
+	int64_t denominator;
+	if (!multiply(top / gcd1, value.top / gcd2, numerator)) {
+		return output;
+	}
+	if (!multiply(bot / gcd2, value.bot / gcd1, denominator)) {
+		return output;
+	}
+	output.setValue(numerator, denominator);
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::operator/ -- Division operator.  Division by zero gives NaN.
+//
+
+HumNum64 HumNum64::operator/(const HumNum64& value) const {
+	HumNum64 inverse(value.bot, value.top);
+	if (value.isNaN()) {
+		inverse.bot = 0;
+	}
+	return *this * inverse;
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::operator+= -- Arithmetic assignment operators.
+//
+
+HumNum64& HumNum64::operator+=(const HumNum64& value) {
+	*this = *this + value;
+	return *this;
+}
+
+
+HumNum64& HumNum64::operator-=(const HumNum64& value) {
+	*this = *this - value;
+	return *this;
+}
+
+
+HumNum64& HumNum64::operator*=(const HumNum64& value) {
+	*this = *this * value;
+	return *this;
+}
+
+
+HumNum64& HumNum64::operator/=(const HumNum64& value) {
+	*this = *this / value;
+	return *this;
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::compare -- Returns -1 if the number is less than the given
+//     value, 0 if equal, and +1 if greater.  The comparison is exact unless
+//     the cross products overflow, in which case long doubles are compared.
+//     Neither number can be NaN.
+//
+
+int HumNum64::compare(const HumNum64& value) const {
+	int64_t a;
+	int64_t b;
+	if (multiply(top, value.bot, a) && multiply(value.top, bot, b)) {
+		return (a < b) ? -1 : ((a > b) ? +1 : 0);
+	}
+	long double x = (long double)top / (long double)bot;
+	long double y = (long double)value.top / (long double)value.bot;
+	return (x < y) ? -1 : ((x > y) ? +1 : 0);
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::operator== -- Comparison operators.  Comparisons with NaN
+//    are false, except for !=.
+//
+
+bool HumNum64::operator==(const HumNum64& value) const {
+	if (isNaN() || value.isNaN()) {
+		return false;
+	}
+	return (top == value.top) && (bot == value.bot);
+}
+
+
+bool HumNum64::operator!=(const HumNum64& value) const {
+	return !(*this == value);
+}
+
+
+bool HumNum64::operator<(const HumNum64& value) const {
+	if (isNaN() || value.isNaN()) {
+		return false;
+	}
+	return compare(value) < 0;
+}
+
+
+bool HumNum64::operator<=(const HumNum64& value) const {
+	if (isNaN() || value.isNaN()) {
+		return false;
+	}
+	return compare(value) <= 0;
+}
+
+
+bool HumNum64::operator>(const HumNum64& value) const {
+	if (isNaN() || value.isNaN()) {
+		return false;
+	}
+	return compare(value) > 0;
+}
+
+
+bool HumNum64::operator>=(const HumNum64& value) const {
+	if (isNaN() || value.isNaN()) {
+		return false;
+	}
+	return compare(value) >= 0;
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::printFraction -- Print as a fraction, such as 3/2.  If the
+//    number is an integer, then do not print the denominator.
+//
+
+ostream& HumNum64::printFraction(ostream& out) const {
+	if (isInteger()) {
+		out << top;
+	} else {
+		out << top << '/' << bot;
+	}
+	return out;
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::add -- Add two integers.  Returns false if the sum overflows.
+//
+
+bool HumNum64::add(int64_t a, int64_t b, int64_t& output) {
+	if (((b > 0) && (a > INT64_MAX - b)) || ((b < 0) && (a < INT64_MIN - b))) {
+		return false;
+	}
+	output = a + b;
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::subtract -- Subtract two integers.  Returns false if the
+//     difference overflows.
+//
+
+bool HumNum64::subtract(int64_t a, int64_t b, int64_t& output) {
+	if (((b < 0) && (a > INT64_MAX + b)) || ((b > 0) && (a < INT64_MIN + b))) {
+		return false;
+	}
+	output = a - b;
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::multiply -- Multiply two integers.  Returns false if the
+//     product overflows.
+//
+
+bool HumNum64::multiply(int64_t a, int64_t b, int64_t& output) {
+	if (a > 0) {
+		if (b > 0) {
+			if (a > INT64_MAX / b) {
+				return false;
+			}
+		} else if (b < INT64_MIN / a) {
+			return false;
+		}
+	} else if (a < 0) {
+		if (b > 0) {
+			if (a < INT64_MIN / b) {
+				return false;
+			}
+		} else if ((b < 0) && (b < INT64_MAX / a)) {
+			return false;
+		}
+	}
+	output = a * b;
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::lcm -- Least common multiple of two positive integers.
+//     Returns false if the result overflows.
+//
+
+bool HumNum64::lcm(int64_t a, int64_t b, int64_t& output) {
+	int64_t gcdval = gcd(a, b);
+	if (gcdval == 0) {
+		output = 0;
+		return true;
+	}
+	return multiply(a / gcdval, b, output);
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::gcd -- Greatest common divisor (always non-negative).
+//
+
+int64_t HumNum64::gcd(int64_t a, int64_t b) {
+	uint64_t x = a < 0 ? 0 - (uint64_t)a : (uint64_t)a;
+	uint64_t y = b < 0 ? 0 - (uint64_t)b : (uint64_t)b;
+	uint64_t c;
+	while (y) {
+		c = x % y;
+		x = y;
+		y = c;
+	}
+	return x > (uint64_t)INT64_MAX ? 1 : (int64_t)x;
+}
+
+
+
 
 //////////////////////////////
 //
@@ -19967,6 +22245,792 @@ HumSignifier* HumSignifiers::getSignifier(int index) {
 
 
 
+
+//////////////////////////////
+//
+// HumSonority::clear -- Remove all pitches and the bass.
+//
+
+void HumSonority::clear(void) {
+	m_pcmask  = 0;
+	m_b7mask  = 0;
+	m_b40mask = 0;
+	m_bass    = -1;
+}
+
+
+
+//////////////////////////////
+//
+// HumSonority::isEmpty -- Return true if no pitches have been added.
+//
+
+bool HumSonority::isEmpty(void) const {
+	return (m_pcmask == 0) && (m_b7mask == 0) && (m_b40mask == 0);
+}
+
+
+
+//////////////////////////////
+//
+// HumSonority::addMidi -- Add the pitch class of a MIDI note number.
+//     Negative numbers (sustained notes) are treated as positive, and
+//     0 (rest) is ignored.
+//
+
+void HumSonority::addMidi(int midi) {
+	midi = abs(midi);
+	if (midi == 0) {
+		return;
+	}
+	m_pcmask |= 1 << (midi % 12);
+}
+
+
+
+//////////////////////////////
+//
+// HumSonority::addDiatonic -- Add the pitch class of a base-7 pitch.
+//     Negative values (rests) are ignored.
+//
+
+void HumSonority::addDiatonic(int base7) {
+	if (base7 < 0) {
+		return;
+	}
+	m_b7mask |= 1 << (base7 % 7);
+}
+
+
+
+//////////////////////////////
+//
+// HumSonority::addBase40 -- Add the pitch class of a base-40 pitch.
+//     Negative values (rests) are ignored.
+//
+
+void HumSonority::addBase40(int base40) {
+	if (base40 < 0) {
+		return;
+	}
+	m_b40mask |= (uint64_t)1 << (base40 % 40);
+}
+
+
+
+//////////////////////////////
+//
+// HumSonority::setBass -- Set the bass pitch class from a MIDI note number.
+//
+
+void HumSonority::setBass(int midi) {
+	midi = abs(midi);
+	if (midi == 0) {
+		m_bass = -1;
+	} else {
+		m_bass = midi % 12;
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumSonority::hasPitchClass -- Return true if the 12-tone pitch class
+//     is present.
+//
+
+bool HumSonority::hasPitchClass(int pc) const {
+	if (pc < 0) {
+		return false;
+	}
+	return (m_pcmask >> (pc % 12)) & 1;
+}
+
+
+
+//////////////////////////////
+//
+// HumSonority::hasDiatonic -- Return true if the diatonic pitch class of
+//     the base-7 pitch is present.
+//
+
+bool HumSonority::hasDiatonic(int base7) const {
+	if (base7 < 0) {
+		return false;
+	}
+	return (m_b7mask >> (base7 % 7)) & 1;
+}
+
+
+
+//////////////////////////////
+//
+// HumSonority::hasBase40 -- Return true if the pitch class of the base-40
+//     pitch is present.
+//
+
+bool HumSonority::hasBase40(int base40) const {
+	if (base40 < 0) {
+		return false;
+	}
+	return (m_b40mask >> (base40 % 40)) & 1;
+}
+
+
+
+//////////////////////////////
+//
+// HumSonority::getPitchClassCount -- Return the number of distinct
+//     12-tone pitch classes.
+//
+
+int HumSonority::getPitchClassCount(void) const {
+	return countBits(m_pcmask);
+}
+
+
+
+//////////////////////////////
+//
+// HumSonority::getType -- Return the chord type of the 12-tone pitch-class
+//     set (see sonority_type in HumSonority.h).
+//
+
+int HumSonority::getType(void) const {
+	return getType(m_pcmask);
+}
+
+
+int HumSonority::getType(int pcmask) {
+	return getChordEntry(pcmask) & 0xf;
+}
+
+
+
+//////////////////////////////
+//
+// HumSonority::getRoot -- Return the pitch class of the root, or -1 if
+//     there is no root.  For dyads, the root is the lower note of the
+//     third or fifth (of the tritone when written as a diminished fifth).
+//     For augmented triads, the root is the lowest pitch class counting
+//     from C.
+//
+
+int HumSonority::getRoot(void) const {
+	return getRoot(m_pcmask);
+}
+
+
+int HumSonority::getRoot(int pcmask) {
+	return (int)((getChordEntry(pcmask) >> 4) & 0xf) - 1;
+}
+
+
+
+//////////////////////////////
+//
+// HumSonority::getThird -- Return the pitch class of the third above the
+//     root, or -1 if there is none.
+//
+
+int HumSonority::getThird(void) const {
+	return getThird(m_pcmask);
+}
+
+
+int HumSonority::getThird(int pcmask) {
+	return (int)((getChordEntry(pcmask) >> 8) & 0xf) - 1;
+}
+
+
+
+//////////////////////////////
+//
+// HumSonority::getFifth -- Return the pitch class of the fifth above the
+//     root, or -1 if there is none.
+//
+
+int HumSonority::getFifth(void) const {
+	return getFifth(m_pcmask);
+}
+
+
+int HumSonority::getFifth(int pcmask) {
+	return (int)((getChordEntry(pcmask) >> 12) & 0xf) - 1;
+}
+
+
+
+//////////////////////////////
+//
+// HumSonority::getPosition -- Return the chord position of a MIDI note
+//     in the sonority: 1 = root, 3 = third, 5 = fifth, 0 = other.
+//
+
+int HumSonority::getPosition(int midi) const {
+	return getPosition(m_pcmask, midi);
+}
+
+
+int HumSonority::getPosition(int pcmask, int midi) {
+	int pc = abs(midi) % 12;
+	uint32_t entry = getChordEntry(pcmask);
+	if (pc == (int)((entry >> 4) & 0xf) - 1) {
+		return 1;
+	} else if (pc == (int)((entry >> 8) & 0xf) - 1) {
+		return 3;
+	} else if (pc == (int)((entry >> 12) & 0xf) - 1) {
+		return 5;
+	}
+	return 0;
+}
+
+
+
+//////////////////////////////
+//
+// HumSonority::getInversion -- Return the inversion of a triad from the
+//     bass: 0 = root position, 1 = first inversion, 2 = second inversion.
+//     Returns -1 if the sonority is not a triad or there is no bass.
+//
+
+int HumSonority::getInversion(void) const {
+	if ((m_bass < 0) || !isTriad(getType())) {
+		return -1;
+	}
+	if (m_bass == getThird()) {
+		return 1;
+	} else if (m_bass == getFifth()) {
+		return 2;
+	}
+	return 0;
+}
+
+
+
+//////////////////////////////
+//
+// HumSonority::isTriad -- Return true if the chord type is a major,
+//     minor, diminished or augmented triad.
+//
+
+bool HumSonority::isTriad(int type) {
+	switch (type) {
+		case sonority_major:
+		case sonority_minor:
+		case sonority_diminished:
+		case sonority_augmented:
+			return true;
+	}
+	return false;
+}
+
+
+
+//////////////////////////////
+//
+// HumSonority::countBits -- Return the number of set bits in a mask.
+//
+
+int HumSonority::countBits(uint64_t mask) {
+	int output = 0;
+	while (mask) {
+		mask &= mask - 1;
+		output++;
+	}
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumSonority::getChordEntry -- Return the chord table entry for a
+//     12-tone pitch-class set.  The table covers all 4096 sets and is
+//     filled once on first use.  Entries store the chord type in bits
+//     0-3, and the root, third and fifth plus one in the next three
+//     groups of four bits (0 meaning not present).
+//
+
+uint32_t HumSonority::getChordEntry(int pcmask) {
+	static const vector<uint32_t> table = []() {
+		vector<uint32_t> output;
+		prepareChordTable(output);
+		return output;
+	}();
+	return table[pcmask & 0xfff];
+}
+
+
+
+//////////////////////////////
+//
+// HumSonority::prepareChordTable -- Classify every 12-tone pitch-class set.
+//
+
+void HumSonority::prepareChordTable(vector<uint32_t>& table) {
+	table.resize(4096);
+	for (int i=0; i<(int)table.size(); i++) {
+		table[i] = analyzeMask(i);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumSonority::analyzeMask -- Classify a pitch-class set.  Triads are
+//     identified by trying each pitch class as the root in order from C,
+//     checking for major, minor, diminished and then augmented triads.
+//
+
+uint32_t HumSonority::analyzeMask(int pcmask) {
+	vector<int> pcs;
+	for (int i=0; i<12; i++) {
+		if ((pcmask >> i) & 1) {
+			pcs.push_back(i);
+		}
+	}
+
+	int type  = sonority_empty;
+	int root  = -1;
+	int third = -1;
+	int fifth = -1;
+
+	if (pcs.size() == 1) {
+		type = sonority_unison;
+		root = pcs[0];
+	} else if (pcs.size() == 2) {
+		int interval = pcs[1] - pcs[0];
+		switch (interval) {
+			case 3:
+				type = sonority_minor_third;
+				root = pcs[0];
+				third = pcs[1];
+				break;
+			case 9:
+				type = sonority_minor_third;
+				root = pcs[1];
+				third = pcs[0];
+				break;
+			case 4:
+				type = sonority_major_third;
+				root = pcs[0];
+				third = pcs[1];
+				break;
+			case 8:
+				type = sonority_major_third;
+				root = pcs[1];
+				third = pcs[0];
+				break;
+			case 7:
+				type = sonority_fifth;
+				root = pcs[0];
+				fifth = pcs[1];
+				break;
+			case 5:
+				type = sonority_fifth;
+				root = pcs[1];
+				fifth = pcs[0];
+				break;
+			case 6:
+				type = sonority_tritone;
+				root = pcs[0];
+				fifth = pcs[1];
+				break;
+			default:
+				type = sonority_dyad;
+		}
+	} else if (pcs.size() == 3) {
+		type = sonority_trichord;
+		for (int i=0; i<3; i++) {
+			int r = pcs[i];
+			auto has = [&](int interval) {
+				return (pcmask >> ((r + interval) % 12)) & 1;
+			};
+			if (has(4) && has(7)) {
+				type = sonority_major;
+			} else if (has(3) && has(7)) {
+				type = sonority_minor;
+			} else if (has(3) && has(6)) {
+				type = sonority_diminished;
+			} else if (has(4) && has(8)) {
+				type = sonority_augmented;
+			} else {
+				continue;
+			}
+			root  = r;
+			third = (r + ((type == sonority_minor) || (type == sonority_diminished) ? 3 : 4)) % 12;
+			fifth = (r + (type == sonority_diminished ? 6 : (type == sonority_augmented ? 8 : 7))) % 12;
+			break;
+		}
+	} else if (pcs.size() > 3) {
+		type = sonority_large;
+	}
+
+	return (uint32_t)type
+			| ((uint32_t)(root  + 1) << 4)
+			| ((uint32_t)(third + 1) << 8)
+			| ((uint32_t)(fifth + 1) << 12);
+}
+
+
+
+
+
+
+//////////////////////////////
+//
+// HumStatistics::clear -- Remove all counters.
+//
+
+void HumStatistics::clear(void) {
+	m_files = 0;
+	m_counters.clear();
+}
+
+
+
+//////////////////////////////
+//
+// HumStatistics::isEmpty -- Return true if no files have been counted
+//     and there are no counters.
+//
+
+bool HumStatistics::isEmpty(void) const {
+	return (m_files == 0) && m_counters.empty();
+}
+
+
+
+//////////////////////////////
+//
+// HumStatistics::addFile -- Count another analyzed file.
+//
+
+void HumStatistics::addFile(void) {
+	m_files++;
+}
+
+
+
+//////////////////////////////
+//
+// HumStatistics::getFileCount -- Return the number of analyzed files.
+//
+
+int HumStatistics::getFileCount(void) const {
+	return m_files;
+}
+
+
+
+//////////////////////////////
+//
+// HumStatistics::increment -- Add an amount to a counter, creating the
+//     counter if it does not exist yet.
+//
+
+void HumStatistics::increment(const string& group, const string& key,
+		double amount) {
+	m_counters[group][key] += amount;
+}
+
+
+
+//////////////////////////////
+//
+// HumStatistics::getValue -- Return the value of a counter, or 0 if it
+//     does not exist.
+//
+
+double HumStatistics::getValue(const string& group, const string& key) const {
+	auto git = m_counters.find(group);
+	if (git == m_counters.end()) {
+		return 0.0;
+	}
+	auto kit = git->second.find(key);
+	if (kit == git->second.end()) {
+		return 0.0;
+	}
+	return kit->second;
+}
+
+
+
+//////////////////////////////
+//
+// HumStatistics::merge -- Add the counters of another object to this one.
+//     Used to combine the results of separate workers.
+//
+
+void HumStatistics::merge(const HumStatistics& other) {
+	m_files += other.m_files;
+	for (auto& group : other.m_counters) {
+		map<string, double>& target = m_counters[group.first];
+		for (auto& counter : group.second) {
+			target[counter.first] += counter.second;
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumStatistics::printJson -- Print the counters as a JSON object, with
+//     one member object for each group.  If a name is given, it is printed
+//     as the "tool" member.
+//
+
+void HumStatistics::printJson(ostream& out, const string& name) const {
+	out << "{\n";
+	if (!name.empty()) {
+		out << "\t\"tool\": ";
+		printJsonString(out, name);
+		out << ",\n";
+	}
+	out << "\t\"files\": " << m_files;
+	for (auto& group : m_counters) {
+		out << ",\n\t";
+		printJsonString(out, group.first);
+		out << ": {";
+		bool first = true;
+		for (auto& counter : group.second) {
+			out << (first ? "\n\t\t" : ",\n\t\t");
+			first = false;
+			printJsonString(out, counter.first);
+			out << ": ";
+			printJsonNumber(out, counter.second);
+		}
+		out << (first ? "}" : "\n\t}");
+	}
+	out << "\n}\n";
+}
+
+
+
+//////////////////////////////
+//
+// HumStatistics::printJsonString -- Print text as a quoted JSON string.
+//
+
+void HumStatistics::printJsonString(ostream& out, const string& text) {
+	out << '"';
+	for (int i=0; i<(int)text.size(); i++) {
+		unsigned char ch = (unsigned char)text[i];
+		switch (ch) {
+			case '"':  out << "\\\""; break;
+			case '\\': out << "\\\\"; break;
+			case '\n': out << "\\n";  break;
+			case '\t': out << "\\t";  break;
+			case '\r': out << "\\r";  break;
+			default:
+				if (ch < 0x20) {
+					char buffer[8];
+					snprintf(buffer, sizeof(buffer), "\\u%04x", ch);
+					out << buffer;
+				} else {
+					out << text[i];
+				}
+		}
+	}
+	out << '"';
+}
+
+
+
+//////////////////////////////
+//
+// HumStatistics::printJsonNumber -- Print counts as integers and other
+//     values with enough digits to survive a round trip.
+//
+
+void HumStatistics::printJsonNumber(ostream& out, double value) {
+	if (!std::isfinite(value)) {
+		out << "null";
+	} else if ((value == std::floor(value)) && (std::fabs(value) < 1.0e15)) {
+		out << (long long)value;
+	} else {
+		char buffer[32];
+		snprintf(buffer, sizeof(buffer), "%.15g", value);
+		out << buffer;
+	}
+}
+
+
+
+
+
+
+//////////////////////////////
+//
+// HumThreadPool::HumThreadPool -- Start the worker threads.  A thread
+//     count of zero or less means to use the number of hardware threads.
+//
+
+HumThreadPool::HumThreadPool(int threads) {
+	if (threads <= 0) {
+		threads = getHardwareThreads();
+	}
+	m_next = 0;
+	for (int i=1; i<threads; i++) {
+		m_workers.emplace_back(&HumThreadPool::workerLoop, this);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumThreadPool::~HumThreadPool -- Stop the worker threads.
+//
+
+HumThreadPool::~HumThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+	for (int i=0; i<(int)m_workers.size(); i++) {
+		m_workers[i].join();
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumThreadPool::getThreadCount -- Return the number of threads that
+//     process tasks, including the thread calling run().
+//
+
+int HumThreadPool::getThreadCount(void) const {
+	return (int)m_workers.size() + 1;
+}
+
+
+
+//////////////////////////////
+//
+// HumThreadPool::getHardwareThreads -- Return the number of hardware
+//     threads, or 1 if unknown.
+//
+
+int HumThreadPool::getHardwareThreads(void) {
+	int output = (int)std::thread::hardware_concurrency();
+	if (output < 1) {
+		output = 1;
+	}
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumThreadPool::run -- Call task(0) through task(count-1), spread over
+//     the worker threads and the calling thread.  Returns when all tasks
+//     have finished.  The order in which tasks run is not defined, so each
+//     task should only modify data that belongs to its index.  If a task
+//     throws an exception, the remaining tasks are skipped and the first
+//     exception is rethrown.
+//
+
+void HumThreadPool::run(int count, const std::function<void(int)>& task) {
+	if (count <= 0) {
+		return;
+	}
+	std::lock_guard<std::mutex> runlock(m_runMutex);
+	if (m_workers.empty() || (count == 1)) {
+		for (int i=0; i<count; i++) {
+			task(i);
+		}
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_task  = &task;
+		m_count = count;
+		m_next  = 0;
+		m_busy  = (int)m_workers.size();
+		m_error = NULL;
+		m_generation++;
+	}
+	m_wake.notify_all();
+
+	doTasks();
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_finished.wait(lock, [this]() { return m_busy == 0; });
+	m_task = NULL;
+	if (m_error) {
+		std::exception_ptr error = m_error;
+		m_error = NULL;
+		std::rethrow_exception(error);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumThreadPool::workerLoop -- Wait for a run, then process tasks until
+//     none are left.
+//
+
+void HumThreadPool::workerLoop(void) {
+	int generation = 0;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wake.wait(lock, [&]() { return m_stop || (m_generation != generation); });
+			if (m_stop) {
+				return;
+			}
+			generation = m_generation;
+		}
+		doTasks();
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_busy--;
+		}
+		m_finished.notify_one();
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumThreadPool::doTasks -- Process tasks from the current run until all
+//     have been taken.
+//
+
+void HumThreadPool::doTasks(void) {
+	while (true) {
+		int index = m_next++;
+		if (index >= m_count) {
+			return;
+		}
+		try {
+			(*m_task)(index);
+		} catch (...) {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (!m_error) {
+				m_error = std::current_exception();
+			}
+			m_next = m_count;
+		}
+	}
+}
+
+
+
+
+
 //////////////////////////////
 //
 // HumTool::HumTool --
@@ -20226,6 +23290,36 @@ void HumTool::clearOutput(void) {
 
 
 
+//////////////////////////////
+//
+// HumTool::isReusable -- Returns true if the tool resets all of its
+//     analysis data at the start of each run, so that an instance can
+//     be run on several files with the same options (and only the output
+//     cleared between files).  Tool_filter reuses the instances of such
+//     tools.  Tools with data that carry over from one file to the next
+//     must not override this function.
+//
+
+bool HumTool::isReusable(void) {
+	return false;
+}
+
+
+
+//////////////////////////////
+//
+// HumTool::getSegmentBatchSize -- Returns the number of segments that
+//     STREAM_INTERFACE reads before each call to run(HumdrumFileSet&).
+//     Tools which process the files of a set in parallel can return a
+//     larger number.  Called after the options have been processed.
+//
+
+int HumTool::getSegmentBatchSize(void) {
+	return 1;
+}
+
+
+
 ///////////////////////////////
 //
 // HumTool::setError --
@@ -22338,6 +25432,11 @@ string HumdrumFileBase::getUriToUrlMapping(const string& uri) {
 
 #ifdef USING_URI
 
+thread_local HumHttpConnections HumdrumFileBase::m_httpConnections;
+string HumdrumFileBase::m_uriCacheDirectory;
+int HumdrumFileBase::m_uriCacheMaxAge = 24 * 60 * 60;
+
+
 //////////////////////////////
 //
 // HumdrumFileBase::readFromHumdrumUri -- Read a Humdrum file from an
@@ -22388,7 +25487,101 @@ void HumdrumFileBase::readFromHttpUri(const string& webaddress) {
 
 //////////////////////////////
 //
-// readStringFromHttpUri -- Read a Humdrum file from an http:// web address
+// HumdrumFileBase::setUriCacheDirectory -- Set a directory in which to
+//     store files downloaded from the web.  Downloaded content is stored
+//     in a file named by a hash of the content, and a metadata file named
+//     by a hash of the URL stores the ETag and expiry time of the
+//     download.  Set to an empty string to disable caching (the
+//     HUMLIB_URI_CACHE environment variable will then be used if set).
+//
+
+void HumdrumFileBase::setUriCacheDirectory(const string& directory) {
+	m_uriCacheDirectory = directory;
+	while ((m_uriCacheDirectory.size() > 1) && (m_uriCacheDirectory.back() == '/')) {
+		m_uriCacheDirectory.pop_back();
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::getUriCacheDirectory -- Return the directory used to
+//     cache downloaded files, or an empty string if no caching.
+//
+
+string HumdrumFileBase::getUriCacheDirectory(void) {
+	if (!m_uriCacheDirectory.empty()) {
+		return m_uriCacheDirectory;
+	}
+	const char* env = getenv("HUMLIB_URI_CACHE");
+	if (env == NULL) {
+		return "";
+	}
+	return env;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::setUriCacheMaxAge -- Set the number of seconds that
+//     a cached download is used without checking with the server, when
+//     the server does not give a Cache-Control max-age.  Default is one day.
+//
+
+void HumdrumFileBase::setUriCacheMaxAge(int seconds) {
+	m_uriCacheMaxAge = seconds;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::closeHttpConnections -- Close all keep-alive
+//     connections to web servers that were opened by the current thread.
+//
+
+void HumdrumFileBase::closeHttpConnections(void) {
+	m_httpConnections.closeAll();
+}
+
+
+
+//////////////////////////////
+//
+// HumHttpConnections::~HumHttpConnections -- Close the connections when
+//     the thread that owns them ends.
+//
+
+HumHttpConnections::~HumHttpConnections() {
+	closeAll();
+}
+
+
+
+//////////////////////////////
+//
+// HumHttpConnections::closeAll -- Close all of the connections.
+//
+
+void HumHttpConnections::closeAll(void) {
+	for (auto& item : *this) {
+		close(item.second);
+	}
+	clear();
+}
+
+
+
+//////////////////////////////
+//
+// readStringFromHttpUri -- Read a Humdrum file from an http:// web address.
+//     If a cache directory is set, then the cached copy of the file will be
+//     returned if it has not expired, or if the server replies that it has
+//     not changed since it was cached.  Connections to the server are kept
+//     open, so that downloading multiple files from the same server does not
+//     require a new connection for each file.
 //
 
 void HumdrumFileBase::readStringFromHttpUri(stringstream& inputdata,
@@ -22396,6 +25589,8 @@ void HumdrumFileBase::readStringFromHttpUri(stringstream& inputdata,
 	auto css = webaddress.find("://");
 	if (css == string::npos) {
 		// give up since URI was not in correct format
+		cerr << "Error: invalid URL: " << webaddress << endl;
+		exit(1);
 	}
 	string rest = webaddress.substr(css+3);
 	string hostname;
@@ -22412,125 +25607,388 @@ void HumdrumFileBase::readStringFromHttpUri(stringstream& inputdata,
 		location = "/";
 	}
 
+	unsigned short int port = 80;
+	auto colon = hostname.find(':');
+	if (colon != string::npos) {
+		port = (unsigned short int)atoi(hostname.substr(colon+1).c_str());
+		hostname = hostname.substr(0, colon);
+	}
+
+	string cached;
+	string etag;
+	bool expiredQ = true;
+	bool cachedQ = readUriCache(webaddress, cached, etag, expiredQ);
+	if (cachedQ && !expiredQ) {
+		inputdata << cached;
+		return;
+	}
+	if (!cachedQ) {
+		etag.clear();
+	}
+
+	stringstream body;
+	int status = 0;
+	string newetag;
+	int maxage = -1;
+	requestHttpUri(body, hostname, port, location, etag, status, newetag, maxage);
+
+	if ((status == 304) && cachedQ) {
+		// data has not changed on the server, so use the cached copy
+		writeUriCache(webaddress, cached, etag, maxage);
+		inputdata << cached;
+		return;
+	}
+
+	if ((status < 200) || (status >= 300)) {
+		// Do not return error pages as data.
+		cerr << "Error: HTTP status " << status << " for URI\n";
+		cerr << "URL:   " << webaddress << endl;
+		exit(1);
+	}
+
+	string contents = body.str();
+	if (contents.empty()) {
+		cerr << "Error: no data found for URI (probably invalid)\n";
+		cerr << "URL:   " << webaddress << endl;
+		exit(1);
+	}
+	if ((status == 200) && ((maxage != 0) || !newetag.empty())) {
+		// (Data that expires immediately and cannot be revalidated
+		// is not worth caching.)
+		writeUriCache(webaddress, contents, newetag, maxage);
+	}
+	inputdata << contents;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::requestHttpUri -- Send a GET request to a web server
+//     and read the response into inputdata.  An open connection to the
+//     server will be reused if available.  If the reused connection was
+//     closed by the server, then a new connection will be made.  If etag
+//     is not empty, then the request is conditional, and a status of 304
+//     means that the data has not changed.  The maxage parameter is set
+//     to the max-age value from a Cache-Control header, or -1 if none.
+//
+
+bool HumdrumFileBase::requestHttpUri(stringstream& inputdata,
+		const string& hostname, unsigned short int port, const string& location,
+		const string& etag, int& status, string& newetag, int& maxage) {
+
 	string newline({0x0d, 0x0a});
 
 	stringstream request;
 	request << "GET "   << location << " HTTP/1.1" << newline;
-	request << "Host: " << hostname << newline;
-	request << "User-Agent: HumdrumFile Downloader 2.0 ("
+	request << "Host: " << hostname;
+	if (port != 80) {
+		request << ":" << port;
+	}
+	request << newline;
+	request << "User-Agent: HumdrumFile Downloader 2.1 ("
 		     << __DATE__ << ")" << newline;
-	request << "Connection: close" << newline;  // this line is necessary
+	if (!etag.empty()) {
+		request << "If-None-Match: " << etag << newline;
+	}
+	request << "Connection: keep-alive" << newline;
 	request << newline;
+	string rstring = request.str();
+
+	for (int attempt=0; attempt<2; attempt++) {
+		bool reusedQ = false;
+		int socket_id = getHttpConnection(hostname, port, reusedQ);
+		// Do not raise SIGPIPE if the server has reset a kept-alive
+		// connection, so that the request can be tried again.
+		int flags = 0;
+		#ifdef MSG_NOSIGNAL
+			flags = MSG_NOSIGNAL;
+		#endif
+		if (send(socket_id, rstring.c_str(), rstring.size(), flags) != (ssize_t)rstring.size()) {
+			dropHttpConnection(hostname, port);
+			if (reusedQ) {
+				continue;
+			}
+			cerr << "Error writing to " << hostname << endl;
+			exit(1);
+		}
 
-	unsigned short int port = 80;
-	int socket_id = open_network_socket(hostname, port);
-	if (::write(socket_id, request.str().c_str(), request.str().size()) == -1) {
-		exit(-1);
-	}
+		HumHttpReader reader(socket_id);
+		string line;
+		if (!reader.readLine(line)) {
+			// The server closed a kept-alive connection, so try again
+			// with a new connection.
+			dropHttpConnection(hostname, port);
+			if (reusedQ) {
+				continue;
+			}
+			cerr << "Funny error trying to read server response" << endl;
+			exit(1);
+		}
 
-	#define URI_BUFFER_SIZE (10000)
-	char buffer[URI_BUFFER_SIZE];
-	unsigned int message_len;
-	stringstream header;
-	int foundcontent   = 0;
-	int newlinecounter = 0;
-	int i;
+		// status line: "HTTP/1.1 200 OK"
+		status = 0;
+		auto space = line.find(' ');
+		if (space != string::npos) {
+			status = atoi(line.c_str() + space + 1);
+		}
+		bool closeQ = Convert::startsWith(line, "HTTP/1.0");
 
-	// read the response header:
-	while ((message_len = ::read(socket_id, buffer, 1)) != 0) {
-		header << buffer[0];
-		if ((buffer[0] == 0x0a) || (buffer[0] == 0x0d)) {
-					newlinecounter++;
-		} else {
-					newlinecounter = 0;
+		// read the response header:
+		int datalength = -1;
+		bool chunked = false;
+		maxage = -1;
+		newetag.clear();
+		while (reader.readLine(line)) {
+			if (line.empty()) {
+				break;
+			}
+			auto colon = line.find(':');
+			if (colon == string::npos) {
+				continue;
+			}
+			string key = line.substr(0, colon);
+			for (int i=0; i<(int)key.size(); i++) {
+				key[i] = std::tolower(key[i]);
+			}
+			string value = Convert::trimWhiteSpace(line.substr(colon+1));
+			string lvalue = value;
+			for (int i=0; i<(int)lvalue.size(); i++) {
+				lvalue[i] = std::tolower(lvalue[i]);
+			}
+			if (key == "content-length") {
+				datalength = atoi(value.c_str());
+			} else if (key == "transfer-encoding") {
+				if (lvalue.find("chunked") != string::npos) {
+					chunked = true;
+				}
+			} else if (key == "connection") {
+				if (lvalue.find("close") != string::npos) {
+					closeQ = true;
+				} else if (lvalue.find("keep-alive") != string::npos) {
+					closeQ = false;
+				}
+			} else if (key == "etag") {
+				newetag = value;
+			} else if (key == "cache-control") {
+				auto loc = lvalue.find("max-age=");
+				if (loc != string::npos) {
+					maxage = atoi(lvalue.c_str() + loc + 8);
+				}
+				if ((lvalue.find("no-cache") != string::npos) ||
+						(lvalue.find("no-store") != string::npos)) {
+					maxage = 0;
+				}
+			}
 		}
-		if (newlinecounter == 4) {
-			foundcontent = 1;
-			break;
+
+		#define URI_BUFFER_SIZE (10000)
+		char buffer[URI_BUFFER_SIZE];
+		if ((status == 304) || (status == 204) || ((status >= 100) && (status < 200))) {
+			// no content in response
+		} else if (chunked) {
+			int chunksize;
+			do {
+				chunksize = getChunk(reader, inputdata, buffer, URI_BUFFER_SIZE);
+			} while (chunksize > 0);
+		} else if (datalength >= 0) {
+			getFixedDataSize(reader, datalength, inputdata, buffer,
+					URI_BUFFER_SIZE);
+		} else {
+			// if the size of the rest of the data cannot be found in the
+			// header, then just keep reading until the server closes
+			// the connection.
+			int message_len;
+			while ((message_len = reader.read(buffer, URI_BUFFER_SIZE)) > 0) {
+				inputdata.write(buffer, message_len);
+			}
+			closeQ = true;
+		}
+
+		if (closeQ) {
+			dropHttpConnection(hostname, port);
 		}
+		return true;
 	}
-	if (foundcontent == 0) {
-		cerr << "Funny error trying to read server response" << endl;
-		exit(1);
+
+	cerr << "Error: could not download data from " << hostname << endl;
+	exit(1);
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::getHttpConnection -- Return an open connection to
+//     the given server, reusing a kept-alive connection if available.
+//
+
+int HumdrumFileBase::getHttpConnection(const string& hostname,
+		unsigned short int port, bool& reusedQ) {
+	string key = hostname + ":" + to_string(port);
+	auto it = m_httpConnections.find(key);
+	if (it != m_httpConnections.end()) {
+		reusedQ = true;
+		return it->second;
+	}
+	reusedQ = false;
+	int socket_id = open_network_socket(hostname, port);
+	m_httpConnections[key] = socket_id;
+	return socket_id;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::dropHttpConnection -- Close the connection to
+//     the given server (such as when the server requests to close it).
+//
+
+void HumdrumFileBase::dropHttpConnection(const string& hostname,
+		unsigned short int port) {
+	string key = hostname + ":" + to_string(port);
+	auto it = m_httpConnections.find(key);
+	if (it == m_httpConnections.end()) {
+		return;
 	}
+	close(it->second);
+	m_httpConnections.erase(it);
+}
+
 
-	// now read the size of the rest of the data which is expected
-	int datalength = -1;
 
-	// also, check for chunked transfer encoding:
+//////////////////////////////
+//
+// HumdrumFileBase::getUriCacheKey -- Return a 64-bit FNV-1a hash of
+//     the input string as a hexadecimal string.  Used to name files
+//     in the URI cache directory.
+//
 
-	int chunked = 0;
+string HumdrumFileBase::getUriCacheKey(const string& contents) {
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	for (int i=0; i<(int)contents.size(); i++) {
+		hash ^= (unsigned char)contents[i];
+		hash *= 0x100000001b3ULL;
+	}
+	char output[32];
+	snprintf(output, 32, "%016llx", (unsigned long long)hash);
+	return output;
+}
 
-	header << ends; // necessary?
-	while (header.getline(buffer, URI_BUFFER_SIZE)) {
-		int len = (int)strlen(buffer);
-		for (i=0; i<len; i++) {
-			buffer[i] = std::tolower(buffer[i]);
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::readUriCache -- Read the cached copy of a download.
+//     Returns false if there is no cached copy.  The metadata file for
+//     a URL is named by the hash of the URL and contains the lines:
+//        url: <webaddress>
+//        etag: <ETag from server>
+//        expires: <seconds since epoch>
+//        content: <hash of contents>
+//     The contents are stored in a file named by the hash of the contents.
+//
+
+bool HumdrumFileBase::readUriCache(const string& webaddress, string& contents,
+		string& etag, bool& expiredQ) {
+	expiredQ = true;
+	string directory = getUriCacheDirectory();
+	if (directory.empty()) {
+		return false;
+	}
+	string metaname = directory + "/" + getUriCacheKey(webaddress) + ".meta";
+	ifstream metafile(metaname);
+	if (!metafile.is_open()) {
+		return false;
+	}
+	string url;
+	string content;
+	long long expires = 0;
+	string line;
+	while (getline(metafile, line)) {
+		auto colon = line.find(": ");
+		if (colon == string::npos) {
+			continue;
 		}
-		if (strstr(buffer, "content-length") != NULL) {
-			for (i=14; i<len; i++) {
-				if (std::isdigit(buffer[i])) {
-					sscanf(&buffer[i], "%d", &datalength);
-					if (datalength == 0) {
-						cerr << "Error: no data found for URI, probably invalid\n";
-						cerr << "URL:   " << webaddress << endl;
-						exit(1);
-					}
-					break;
-				}
-			}
-		} else if ((strstr(buffer, "transfer-encoding") != NULL) &&
-			(strstr(buffer, "chunked") != NULL)) {
-			chunked = 1;
+		string key = line.substr(0, colon);
+		string value = line.substr(colon+2);
+		if (key == "url") {
+			url = value;
+		} else if (key == "etag") {
+			etag = value;
+		} else if (key == "expires") {
+			expires = atoll(value.c_str());
+		} else if (key == "content") {
+			content = value;
 		}
 	}
+	if ((url != webaddress) || content.empty()) {
+		// hash collision or corrupted metadata
+		return false;
+	}
+	ifstream datafile(directory + "/" + content + ".dat", std::ios::binary);
+	if (!datafile.is_open()) {
+		return false;
+	}
+	contents.assign(istreambuf_iterator<char>(datafile), istreambuf_iterator<char>());
+	expiredQ = (long long)time(NULL) >= expires;
+	return true;
+}
 
-	// once the length of the remaining data is known (or not), read it:
-	if (datalength > 0) {
-		getFixedDataSize(socket_id, datalength, inputdata, buffer,
-				URI_BUFFER_SIZE);
 
-	} else if (chunked) {
-		int chunksize;
-		int totalsize = 0;
-		do {
-			chunksize = getChunk(socket_id, inputdata, buffer, URI_BUFFER_SIZE);
-			totalsize += chunksize;
-		} while (chunksize > 0);
-		if (totalsize == 0) {
-			cerr << "Error: no data found for URI (probably invalid)\n";
-			exit(1);
+
+//////////////////////////////
+//
+// HumdrumFileBase::writeUriCache -- Store a downloaded file in the cache
+//     directory (if there is one).  If maxage is negative, then use the
+//     default cache age.
+//
+
+void HumdrumFileBase::writeUriCache(const string& webaddress,
+		const string& contents, const string& etag, int maxage) {
+	string directory = getUriCacheDirectory();
+	if (directory.empty()) {
+		return;
+	}
+	struct stat info;
+	if (stat(directory.c_str(), &info) != 0) {
+		if (mkdir(directory.c_str(), 0755) != 0) {
+			cerr << "Warning: cannot create cache directory " << directory << endl;
+			return;
 		}
-	} else {
-		// if the size of the rest of the data cannot be found in the
-		// header, then just keep reading until done (but this will
-		// probably cause a 5 second delay at the last read).
-		while ((message_len = ::read(socket_id, buffer, URI_BUFFER_SIZE)) != 0) {
-			if (foundcontent) {
-				inputdata.write(buffer, message_len);
-			} else {
-				for (i=0; i<(int)message_len; i++) {
-					if (foundcontent) {
-						inputdata << buffer[i];
-					} else {
-						header << buffer[i];
-						if ((buffer[i] == 0x0a) || (buffer[i] == 0x0d)) {
-							newlinecounter++;
-						} else {
-							newlinecounter = 0;
-						}
-						if (newlinecounter == 4) {
-							foundcontent = 1;
-							continue;
-						}
-					}
+	}
+	if (maxage < 0) {
+		maxage = m_uriCacheMaxAge;
+	}
 
-				}
-			}
+	string content = getUriCacheKey(contents);
+	string dataname = directory + "/" + content + ".dat";
+	if (stat(dataname.c_str(), &info) != 0) {
+		// Write to a temporary file first so that other processes
+		// will not read a partially written file.
+		string tempname = dataname + ".tmp" + to_string(getpid());
+		std::ofstream datafile(tempname, std::ios::binary);
+		if (!datafile.is_open()) {
+			return;
 		}
+		datafile << contents;
+		datafile.close();
+		rename(tempname.c_str(), dataname.c_str());
 	}
 
-	close(socket_id);
+	string metaname = directory + "/" + getUriCacheKey(webaddress) + ".meta";
+	string tempname = metaname + ".tmp" + to_string(getpid());
+	std::ofstream metafile(tempname);
+	if (!metafile.is_open()) {
+		return;
+	}
+	metafile << "url: "     << webaddress << "\n";
+	metafile << "etag: "    << etag << "\n";
+	metafile << "expires: " << (long long)time(NULL) + maxage << "\n";
+	metafile << "content: " << content << "\n";
+	metafile.close();
+	rename(tempname.c_str(), metaname.c_str());
 }
 
 
@@ -22562,43 +26020,32 @@ void HumdrumFileBase::readStringFromHttpUri(stringstream& inputdata,
 //
 // The message is finally closed by a last CRLF combination.
 
-int HumdrumFileBase::getChunk(int socket_id, stringstream& inputdata,
+int HumdrumFileBase::getChunk(HumHttpReader& reader, stringstream& inputdata,
 		char* buffer, int bufsize) {
-	int chunksize = 0;
-	unsigned int message_len;
-	char digit[2] = {0};
-	int founddigit = 0;
-
-	// first read the chunk size:
-	while ((message_len = ::read(socket_id, buffer, 1)) != 0) {
-		if (isxdigit(buffer[0])) {
-			digit[0] = buffer[0];
-			chunksize = (chunksize << 4) | (int)strtol(digit, NULL, 16);
-			founddigit = 1;
-		} else if (founddigit) {
-			break;
-		} // else skipping whitespace before chunksize
-	}
-	if ((chunksize <= 0) || (message_len == 0)) {
-		// next chunk is zero, so no more primary data0:w
-		return 0;
-	}
+	string line;
 
-	// read the 0x0d and 0x0a characters which are expected (required)
-	// after the size of chunk size:
-	if (buffer[0] != 0x0d) {
-		cerr << "Strange error occurred right after reading a chunk size" << endl;
-		exit(1);
-	}
+	// first read the chunk size (skipping over the CRLF at the end
+	// of the previous chunk):
+	do {
+		if (!reader.readLine(line)) {
+			return 0;
+		}
+		line = Convert::trimWhiteSpace(line);
+	} while (line.empty());
 
-	// now expect 0x0a:
-	message_len = ::read(socket_id, buffer, 1);
-	if ((message_len == 0) || (buffer[0] != 0x0a)) {
-		cerr << "Strange error after reading newline at end of chunk size"<< endl;
-		exit(1);
+	int chunksize = (int)strtol(line.c_str(), NULL, 16);
+	if (chunksize <= 0) {
+		// Last chunk: read the optional trailers and the final CRLF
+		// so that the connection can be reused.
+		while (reader.readLine(line)) {
+			if (line.empty()) {
+				break;
+			}
+		}
+		return 0;
 	}
 
-	return getFixedDataSize(socket_id, chunksize, inputdata, buffer, bufsize);
+	return getFixedDataSize(reader, chunksize, inputdata, buffer, bufsize);
 }
 
 
@@ -22608,7 +26055,7 @@ int HumdrumFileBase::getChunk(int socket_id, stringstream& inputdata,
 // getFixedDataSize -- read a know amount of data from a socket.
 //
 
-int HumdrumFileBase::getFixedDataSize(int socket_id, int datalength,
+int HumdrumFileBase::getFixedDataSize(HumHttpReader& reader, int datalength,
 		stringstream& inputdata, char* buffer, int bufsize) {
 	int readcount = 0;
 	int readsize;
@@ -22619,8 +26066,8 @@ int HumdrumFileBase::getFixedDataSize(int socket_id, int datalength,
 		if (readcount + readsize > datalength) {
 			readsize = datalength - readcount;
 		}
-		message_len = (int)::read(socket_id, buffer, readsize);
-		if (message_len == 0) {
+		message_len = reader.read(buffer, readsize);
+		if (message_len <= 0) {
 			// shouldn't happen, but who knows...
 			break;
 		}
@@ -22633,6 +26080,88 @@ int HumdrumFileBase::getFixedDataSize(int socket_id, int datalength,
 
 
 
+//////////////////////////////
+//
+// HumHttpReader::fill -- Read the next block of data from the socket.
+//    Returns the number of bytes read, or 0 if the connection was closed.
+//
+
+int HumHttpReader::fill(void) {
+	m_index = 0;
+	m_length = 0;
+	int count = (int)::read(m_socket, m_buffer, sizeof(m_buffer));
+	if (count > 0) {
+		m_length = count;
+	}
+	return m_length;
+}
+
+
+
+//////////////////////////////
+//
+// HumHttpReader::readLine -- Read a line ending in LF (with an optional
+//    CR before it, which is removed).  Returns false if the connection was
+//    closed before any characters were read.
+//
+
+bool HumHttpReader::readLine(string& line) {
+	line.clear();
+	bool foundQ = false;
+	while (true) {
+		if (m_index >= m_length) {
+			if (fill() == 0) {
+				return foundQ;
+			}
+		}
+		foundQ = true;
+		char* start = m_buffer + m_index;
+		char* end = (char*)memchr(start, 0x0a, m_length - m_index);
+		if (end == NULL) {
+			line.append(start, m_length - m_index);
+			m_index = m_length;
+			continue;
+		}
+		line.append(start, end - start);
+		m_index += (int)(end - start) + 1;
+		break;
+	}
+	if (!line.empty() && (line.back() == 0x0d)) {
+		line.pop_back();
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumHttpReader::read -- Read up to size bytes, first returning any
+//    data already buffered.  Returns 0 if the connection was closed.
+//
+
+int HumHttpReader::read(char* buffer, int size) {
+	if (m_index >= m_length) {
+		if (size >= (int)sizeof(m_buffer)) {
+			// large reads do not need to go through the buffer
+			int count = (int)::read(m_socket, buffer, size);
+			return count > 0 ? count : 0;
+		}
+		if (fill() == 0) {
+			return 0;
+		}
+	}
+	int count = m_length - m_index;
+	if (count > size) {
+		count = size;
+	}
+	memcpy(buffer, m_buffer + m_index, count);
+	m_index += count;
+	return count;
+}
+
+
+
 //////////////////////////////
 //
 // HumdrumFileBase::prepare_address -- Store a computer name, such as
@@ -22687,6 +26216,11 @@ int HumdrumFileBase::open_network_socket(const string& hostname,
 		cerr << "Error opening socket to computer " << hostname << endl;
 		exit(1);
 	}
+	#ifdef SO_NOSIGPIPE
+		// Systems without MSG_NOSIGNAL (macOS) disable SIGPIPE on the socket.
+		int nosigpipe = 1;
+		setsockopt(inet_socket, SOL_SOCKET, SO_NOSIGPIPE, &nosigpipe, sizeof(nosigpipe));
+	#endif
 	if (connect(inet_socket, (struct sockaddr *)&servaddr,
 			sizeof(struct sockaddr_in)) < 0) {
 		// connect returns -1 on error
@@ -22741,10 +26275,12 @@ HumdrumFileBase::HumdrumFileBase(HumdrumFileBase& infile) {
 	m_filename = infile.m_filename;
 	m_segmentlevel = infile.m_segmentlevel;
 	m_trackstarts.clear();
+	m_trackdatatypes.clear();
 	m_trackends.clear();
 	m_barlines.clear();
 	m_ticksperquarternote = infile.m_ticksperquarternote;
 	m_idprefix = infile.m_idprefix;
+	m_analysisThreads = infile.m_analysisThreads;
 	m_strand1d.clear();
 	m_strand2d.clear();
 	m_strophes1d.clear();
@@ -22759,7 +26295,8 @@ HumdrumFileBase::HumdrumFileBase(HumdrumFileBase& infile) {
 		m_lines[i]->setOwner(this);
 	}
 
-	analyzeBaseFromLines();
+	// Tokens are created by the HumdrumLine constructor.
+	analyzeBaseFromTokens();
 }
 
 
@@ -22779,10 +26316,12 @@ HumdrumFileBase& HumdrumFileBase::operator=(HumdrumFileBase& infile) {
 	m_filename = infile.m_filename;
 	m_segmentlevel = infile.m_segmentlevel;
 	m_trackstarts.clear();
+	m_trackdatatypes.clear();
 	m_trackends.clear();
 	m_barlines.clear();
 	m_ticksperquarternote = infile.m_ticksperquarternote;
 	m_idprefix = infile.m_idprefix;
+	m_analysisThreads = infile.m_analysisThreads;
 	m_strand1d.clear();
 	m_strand2d.clear();
 	m_strophes1d.clear();
@@ -22797,7 +26336,8 @@ HumdrumFileBase& HumdrumFileBase::operator=(HumdrumFileBase& infile) {
 		m_lines[i]->setOwner(this);
 	}
 
-	analyzeBaseFromLines();
+	// Tokens are created by the HumdrumLine constructor.
+	analyzeBaseFromTokens();
 	return *this;
 }
 
@@ -22831,6 +26371,7 @@ void HumdrumFileBase::clear(void) {
 
 	// clear state variables which are now invalid:
 	m_trackstarts.clear();
+	m_trackdatatypes.clear();
 	m_trackends.clear();
 	m_barlines.clear();
 	m_ticksperquarternote = -1;
@@ -22890,6 +26431,65 @@ bool HumdrumFileBase::areStrophesAnalyzed(void) {
 
 
 
+//////////////////////////////
+//
+// HumdrumFileBase::setAnalysisThreads -- Set the number of threads to use
+//     for analyses that are done independently for each spine or strand
+//     (such as rhythm, slur, phrase, beam and stem-length analyses).  Set
+//     this before reading data to include the rhythm analysis.  A count of
+//     1 (the default) does all analysis in the calling thread, and 0 will
+//     use the number of hardware threads.  Results are the same as with
+//     a single thread.
+//
+
+void HumdrumFileBase::setAnalysisThreads(int count) {
+	if (count <= 0) {
+		count = HumThreadPool::getHardwareThreads();
+	}
+	if (count != m_analysisThreads) {
+		m_threadPool.reset();
+	}
+	m_analysisThreads = count;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::getAnalysisThreads -- Return the number of threads used
+//     for per-spine analyses.
+//
+
+int HumdrumFileBase::getAnalysisThreads(void) const {
+	return m_analysisThreads;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::runParallel -- Call task(0) through task(count-1) on the
+//     analysis threads, or in order in the calling thread if only one
+//     analysis thread is used.  Each task must only modify data that
+//     belongs to its index (such as the tokens of one spine), and anything
+//     shared must be merged after this function returns.
+//
+
+void HumdrumFileBase::runParallel(int count, const std::function<void(int)>& task) {
+	if ((m_analysisThreads <= 1) || (count <= 1)) {
+		for (int i=0; i<count; i++) {
+			task(i);
+		}
+		return;
+	}
+	if (!m_threadPool) {
+		m_threadPool = std::make_shared<HumThreadPool>(m_analysisThreads);
+	}
+	m_threadPool->run(count, task);
+}
+
+
+
 //////////////////////////////
 //
 // HumdrumFileBase::setXmlIdPrefix -- Set the prefix for a HumdrumXML ID
@@ -23026,7 +26626,8 @@ bool HumdrumFileBase::read(istream& contents) {
       s->setOwner(this);
       m_lines.push_back(s);
    }
-   return analyzeBaseFromLines();
+   // Tokens are created by the HumdrumLine constructor.
+   return analyzeBaseFromTokens();
 }
 
 
@@ -23039,7 +26640,7 @@ bool HumdrumFileBase::read(istream& contents) {
 //
 
 bool HumdrumFileBase::readCsv(const string& filename, const string& separator) {
-	return HumdrumFileBase::readCsv(filename.c_str());
+	return HumdrumFileBase::readCsv(filename.c_str(), separator);
 }
 
 
@@ -23060,16 +26661,39 @@ bool HumdrumFileBase::readCsv(const char* filename, const string& separator) {
 
 
 bool HumdrumFileBase::readCsv(istream& contents, const string& separator) {
+	string data((istreambuf_iterator<char>(contents)), istreambuf_iterator<char>());
+	return readCsvText(data.data(), data.size(), separator);
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::readCsvText -- Create lines and tokens from CSV data.
+//    Newlines are located with memchr(), and there is no limit on the
+//    length of lines.  The tokens are created while converting each line
+//    into TSV format, so they do not need to be created from the text of
+//    the line afterwards.
+//
+
+bool HumdrumFileBase::readCsvText(const char* contents, size_t length,
+		const string& separator) {
+	clear();
 	m_displayError = true;
-	char buffer[123123] = {0};
-	HLp s;
-	while (contents.getline(buffer, sizeof(buffer), '\n')) {
-		s = new HumdrumLine;
-		s->setLineFromCsv(buffer);
+	const char* ptr = contents;
+	const char* end = contents + length;
+	while (ptr < end) {
+		const char* newline = (const char*)memchr(ptr, '\n', end - ptr);
+		if (newline == NULL) {
+			newline = end;
+		}
+		HLp s = new HumdrumLine;
+		s->createTokensFromCsv(ptr, (int)(newline - ptr), separator);
 		s->setOwner(this);
 		m_lines.push_back(s);
+		ptr = newline + 1;
 	}
-	return analyzeBaseFromLines();
+	return analyzeBaseFromTokens();
 }
 
 
@@ -23168,17 +26792,13 @@ bool HumdrumFileBase::readString(const char* contents) {
 
 bool HumdrumFileBase::readStringCsv(const char* contents,
 		const string& separator) {
-	stringstream infile;
-	infile << contents;
-	return readCsv(infile, separator);
+	return readCsvText(contents, strlen(contents), separator);
 }
 
 
 bool HumdrumFileBase::readStringCsv(const string& contents,
 		const string& separator) {
-	stringstream infile;
-	infile << contents;
-	return readCsv(infile, separator);
+	return readCsvText(contents.data(), contents.size(), separator);
 }
 
 
@@ -23513,6 +27133,7 @@ void HumdrumFileBase::createLinesFromTokens(void) {
 	for (int i=0; i<(int)m_lines.size(); i++) {
 		m_lines[i]->createLineFromTokens();
 	}
+	m_analyses.m_references_analyzed = false;
 }
 
 
@@ -23526,12 +27147,18 @@ void HumdrumFileBase::createLinesFromTokens(void) {
 void HumdrumFileBase::appendLine(const string& line) {
 	HLp s = new HumdrumLine(line);
 	m_lines.push_back(s);
+	m_analyses.m_slices_analyzed = false;
+	m_analyses.m_references_analyzed = false;
+	m_analyses.m_metric_analyzed = false;
 }
 
 
 void HumdrumFileBase::appendLine(HLp line) {
 	// deletion will be handled by class.
 	m_lines.push_back(line);
+	m_analyses.m_slices_analyzed = false;
+	m_analyses.m_references_analyzed = false;
+	m_analyses.m_metric_analyzed = false;
 }
 
 
@@ -23545,6 +27172,9 @@ void HumdrumFileBase::appendLine(HLp line) {
 void HumdrumFileBase::insertLine(int index, const string& line) {
 	HLp s = new HumdrumLine(line);
 	m_lines.insert(m_lines.begin() + index, s);
+	m_analyses.m_slices_analyzed = false;
+	m_analyses.m_references_analyzed = false;
+	m_analyses.m_metric_analyzed = false;
 
 	// Update the line indexes for this line and the following ones:
 	for (int i=index; i<(int)m_lines.size(); i++) {
@@ -23556,6 +27186,9 @@ void HumdrumFileBase::insertLine(int index, const string& line) {
 void HumdrumFileBase::insertLine(int index, HLp line) {
 	// deletion will be handled by class.
 	m_lines.insert(m_lines.begin() + index, line);
+	m_analyses.m_slices_analyzed = false;
+	m_analyses.m_references_analyzed = false;
+	m_analyses.m_metric_analyzed = false;
 
 	// Update the line indexes for this line and the following ones:
 	for (int i=index; i<(int)m_lines.size(); i++) {
@@ -23585,6 +27218,9 @@ void HumdrumFileBase::deleteLine(int index) {
 		m_lines[i-1] = m_lines[i];
 	}
 	m_lines.resize(m_lines.size() - 1);
+	m_analyses.m_slices_analyzed = false;
+	m_analyses.m_references_analyzed = false;
+	m_analyses.m_metric_analyzed = false;
 }
 
 
@@ -23601,19 +27237,107 @@ HLp HumdrumFileBase::back(void) {
 
 //////////////////////////////
 //
-// HumdrumFileBase::getReferenceRecords --
+// HumdrumFileBase::analyzeReferenceRecords -- Index the reference records
+//     in the file by key, so that they can be found without checking every
+//     line of the file.  This is done automatically by the reference-record
+//     accessor functions below, and is redone after lines are inserted,
+//     appended or deleted, after the spine structure is analyzed again, and
+//     after the text of a global line or token is changed (see
+//     clearReferenceRecords()).
+//
+
+void HumdrumFileBase::analyzeReferenceRecords(void) {
+	m_referencelines.clear();
+	m_referencekeys.clear();
+	HumdrumFileBase& infile = *this;
+	for (int i=0; i<infile.getLineCount(); i++) {
+		if (!infile[i].isCommentGlobal()) {
+			continue;
+		}
+		if (!infile[i].isReference()) {
+			continue;
+		}
+		m_referencelines.push_back(i);
+		m_referencekeys[infile[i].getReferenceKey()].push_back(i);
+	}
+	m_analyses.m_references_analyzed = true;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::clearReferenceRecords -- Mark the index of reference
+//     records as out of date, so that it is made again when next needed.
+//     Called by HumdrumLine and HumdrumToken when their text changes.
+//
+
+void HumdrumFileBase::clearReferenceRecords(void) {
+	m_analyses.m_references_analyzed = false;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::prepareReferenceRecords -- Index the reference records
+//     if the index is out of date.  The indexed lines are also checked
+//     to still be reference records, in case the text of a line was
+//     changed through the std::string interface.
+//
+
+void HumdrumFileBase::prepareReferenceRecords(void) {
+	if (m_analyses.m_references_analyzed) {
+		for (int i=0; i<(int)m_referencelines.size(); i++) {
+			int index = m_referencelines[i];
+			if ((index >= (int)m_lines.size()) || !m_lines[index]->isReference()) {
+				m_analyses.m_references_analyzed = false;
+				break;
+			}
+		}
+	}
+	if (!m_analyses.m_references_analyzed) {
+		analyzeReferenceRecords();
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::getReferenceRecords -- Return the global and universal
+//     reference records in the file.  If a key is given, then only the
+//     reference records with that key are returned.
 //
 
 vector<HLp> HumdrumFileBase::getReferenceRecords(void) {
+	prepareReferenceRecords();
 	vector<HLp> hlps;
-	hlps.reserve(32);
-	HLp hlp;
-	auto& infile = *this;
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (infile[i].isReference()) {
-			hlp = &infile[i];
-			hlps.push_back(hlp);
+	hlps.reserve(m_referencelines.size());
+	for (int i=0; i<(int)m_referencelines.size(); i++) {
+		hlps.push_back(m_lines[m_referencelines[i]]);
+	}
+	return hlps;
+}
+
+
+vector<HLp> HumdrumFileBase::getReferenceRecords(const string& key) {
+	prepareReferenceRecords();
+	vector<HLp> hlps;
+	auto it = m_referencekeys.find(key);
+	if (it == m_referencekeys.end()) {
+		return hlps;
+	}
+	hlps.reserve(it->second.size());
+	for (int i=0; i<(int)it->second.size(); i++) {
+		HLp hlp = m_lines[it->second[i]];
+		if (hlp->getReferenceKey() != key) {
+			// The text of the line was changed after the index was
+			// made, so make the index again.
+			analyzeReferenceRecords();
+			return getReferenceRecords(key);
 		}
+		hlps.push_back(hlp);
 	}
 	return hlps;
 }
@@ -23626,13 +27350,12 @@ vector<HLp> HumdrumFileBase::getReferenceRecords(void) {
 //
 
 vector<HLp> HumdrumFileBase::getGlobalReferenceRecords(void) {
+	prepareReferenceRecords();
 	vector<HLp> hlps;
-	hlps.reserve(32);
-	HLp hlp;
-	auto& infile = *this;
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (infile[i].isGlobalReference()) {
-			hlp = &infile[i];
+	hlps.reserve(m_referencelines.size());
+	for (int i=0; i<(int)m_referencelines.size(); i++) {
+		HLp hlp = m_lines[m_referencelines[i]];
+		if (hlp->isGlobalReference()) {
 			hlps.push_back(hlp);
 		}
 	}
@@ -23647,13 +27370,11 @@ vector<HLp> HumdrumFileBase::getGlobalReferenceRecords(void) {
 //
 
 vector<HLp> HumdrumFileBase::getUniversalReferenceRecords(void) {
+	prepareReferenceRecords();
 	vector<HLp> hlps;
-	hlps.reserve(32);
-	HLp hlp;
-	HumdrumFileBase& infile = *this;
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (infile[i].isUniversalReference()) {
-			hlp = &infile[i];
+	for (int i=0; i<(int)m_referencelines.size(); i++) {
+		HLp hlp = m_lines[m_referencelines[i]];
+		if (hlp->isUniversalReference()) {
 			hlps.push_back(hlp);
 		}
 	}
@@ -23818,10 +27539,20 @@ void HumdrumFileBase::getSpineStartList(vector<HTp>& spinestarts,
 		newexinterp = "**";
 		newexinterp += exinterp;
 	}
+	getSpineStartList(spinestarts, HumDataType::findId(newexinterp));
+}
+
+
+void HumdrumFileBase::getSpineStartList(vector<HTp>& spinestarts,
+		int datatype) {
 	spinestarts.reserve(m_trackstarts.size());
 	spinestarts.resize(0);
+	if (datatype < 0) {
+		// data type is not in the registry, so no spines can match.
+		return;
+	}
 	for (int i=1; i<(int)m_trackstarts.size(); i++) {
-		if (newexinterp == *m_trackstarts[i]) {
+		if (m_trackdatatypes[i] == datatype) {
 			spinestarts.push_back(m_trackstarts[i]);
 		}
 	}
@@ -23857,7 +27588,7 @@ void HumdrumFileBase::getSpineStartList(vector<HTp>& spinestarts,
 //
 
 void HumdrumFileBase::getKernSpineStartList(vector<HTp>& spinestarts) {
-	getSpineStartList(spinestarts, "**kern");
+	getSpineStartList(spinestarts, datatype_kern);
 }
 
 vector<HTp> HumdrumFileBase::getKernSpineStartList(void) {
@@ -24119,6 +27850,54 @@ HTp HumdrumFileBase::getTrackStart(int track) const {
 
 
 
+//////////////////////////////
+//
+// HumdrumFileBase::getTrackDataType -- Return the HumDataType ID of the
+//     exclusive interpretation for the given track, such as datatype_kern.
+//     Returns datatype_unknown if the track number is out of range.
+//
+
+int HumdrumFileBase::getTrackDataType(int track) const {
+	if ((track > 0) && (track < (int)m_trackdatatypes.size())) {
+		return m_trackdatatypes[track];
+	} else {
+		return datatype_unknown;
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::getTrackDataTypes -- Return the HumDataType ID of the
+//     exclusive interpretation of each track.  The list is indexed by track
+//     number (index 0 is not used).
+//
+
+const vector<int>& HumdrumFileBase::getTrackDataTypes(void) const {
+	return m_trackdatatypes;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::updateTrackDataType -- Register the exclusive
+//     interpretation of a track again after its text has been changed
+//     (called by HumdrumToken::setText()).
+//
+
+void HumdrumFileBase::updateTrackDataType(int track) {
+	HTp start = getTrackStart(track);
+	if ((start == NULL) || (track >= (int)m_trackdatatypes.size())) {
+		return;
+	}
+	m_trackdatatypes[track] = HumDataType::getId(*start);
+	m_analyses.m_slices_analyzed = false;
+}
+
+
+
 //////////////////////////////
 //
 // HumdrumFileBase::getTrackEndCount -- Return the number of ending tokens
@@ -24381,7 +28160,11 @@ bool HumdrumFileBase::analyzeSpines(void) {
 	vector<string> sinfo;
 	vector<vector<HTp> > lastspine;
 	m_trackstarts.resize(0);
+	m_trackdatatypes.resize(0);
 	m_trackends.resize(0);
+	m_analyses.m_slices_analyzed = false;
+	m_analyses.m_references_analyzed = false;
+	m_analyses.m_metric_analyzed = false;
 	addToTrackStarts(NULL);
 
 	bool init = false;
@@ -24443,17 +28226,22 @@ bool HumdrumFileBase::analyzeSpines(void) {
 //
 // HumdrumFileBase::addToTrackStarts -- A starting exclusive interpretation was
 //    found, so store in the list of track starts.  The first index position
-//    in trackstarts is reserve for non-spine usage.
+//    in trackstarts is reserve for non-spine usage.  The exclusive
+//    interpretation is also registered in HumDataType so that data types
+//    can be compared as integers.
 //
 
 void HumdrumFileBase::addToTrackStarts(HTp token) {
 	if (token == NULL) {
 		m_trackstarts.push_back(NULL);
+		m_trackdatatypes.push_back(datatype_unknown);
 		m_trackends.resize(m_trackends.size()+1);
 	} else if ((m_trackstarts.size() > 1) && (m_trackstarts.back() == NULL)) {
 		m_trackstarts.back() = token;
+		m_trackdatatypes.back() = HumDataType::getId(*token);
 	} else {
 		m_trackstarts.push_back(token);
+		m_trackdatatypes.push_back(HumDataType::getId(*token));
 		m_trackends.resize(m_trackends.size()+1);
 	}
 }
@@ -25175,22 +28963,17 @@ int HumdrumFileBase::getMeasureNumber(int line) {
 
 //////////////////////////////
 //
-// HumdrumFileBase::getReferenceRecord --
+// HumdrumFileBase::getReferenceRecord -- Return the value of the first
+//     reference record with the given key, or an empty string if there
+//     is no such reference record.
 //
 
 std::string HumdrumFileBase::getReferenceRecord(const std::string& key) {
-	HumdrumFileBase& infile = *this;
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (!infile[i].isReference()) {
-			continue;
-		}
-		string refkey = infile[i].getReferenceKey();
-		if (refkey == key) {
-			string value = infile[i].getReferenceValue();
-			return value;
-		}
+	vector<HLp> hlps = getReferenceRecords(key);
+	if (hlps.empty()) {
+		return "";
 	}
-	return "";
+	return hlps[0]->getReferenceValue();
 }
 
 
@@ -25591,9 +29374,56 @@ bool HumdrumFileContent::analyzeKernAccidentals(const string& dataType) {
 	// ottava marks must be analyzed first:
 	this->analyzeOttavas();
 
+	AccidentalState state;
+	if (!prepareAccidentalState(state, dataType)) {
+		return true;
+	}
+
 	HumdrumFileContent& infile = *this;
-	int i, j, k;
-	int kindex;
+	vector<string> subtokens;
+	for (int i=0; i<infile.getLineCount(); i++) {
+		if (!infile[i].hasSpines()) {
+			continue;
+		}
+		if (!startAccidentalLine(infile[i], state)) {
+			continue;
+		}
+		for (int j=0; j<infile[i].getFieldCount(); j++) {
+			HTp token = infile.token(i, j);
+			if (!token->isKern()) {
+				continue;
+			}
+			if (token->isNull()) {
+				continue;
+			}
+			if (token->isRest()) {
+				continue;
+			}
+			splitSubtokens(token, subtokens);
+			analyzeAccidentalToken(token, subtokens, state);
+		}
+		std::fill(state.firstinbar.begin(), state.firstinbar.end(), 0);
+	}
+
+	// Indicate that the accidental analysis has been done:
+	string dataTypeDone = "accidentalAnalysis" + dataType;
+	infile.setValue("auto", dataTypeDone, "true");
+
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileContent::prepareAccidentalState -- Set up the accidental
+//     states for each spine of the given data type.  Returns false if
+//     there are no spines of that type.
+//
+
+bool HumdrumFileContent::prepareAccidentalState(AccidentalState& state,
+		const string& dataType) {
+	int i;
 	int track;
 
 	// ktracks == List of **kern spines in data.
@@ -25607,23 +29437,18 @@ bool HumdrumFileContent::analyzeKernAccidentals(const string& dataType) {
 		getSpineStartList(ktracks, dataType);
 	}
 	if (ktracks.empty()) {
-		return true;
+		return false;
 	}
-	vector<int> rtracks(getMaxTrack()+1, -1);
+	state.rtracks.assign(getMaxTrack()+1, -1);
 	for (i=0; i<(int)ktracks.size(); i++) {
 		track = ktracks[i]->getTrack();
-		rtracks[track] = i;
+		state.rtracks[track] = i;
 	}
 	int kcount = (int)ktracks.size();
 
 	// keysigs == key signature spellings of diatonic pitch classes.  This array
 	// is duplicated into dstates after each barline.
-	vector<vector<int> > keysigs;
-	keysigs.resize(kcount);
-	for (i=0; i<kcount; i++) {
-		keysigs[i].resize(7);
-		std::fill(keysigs[i].begin(), keysigs[i].end(), 0);
-	}
+	state.keysigs.assign(kcount, vector<int>(7, 0));
 
 	// dstates == diatonic states for every pitch in a spine.
 	// sub-spines are considered as a single unit, although there are
@@ -25633,390 +29458,390 @@ bool HumdrumFileContent::analyzeKernAccidentals(const string& dataType) {
 	// Eventually this algorithm should be adjusted for dealing with
 	// cross-staff notes, where the cross-staff notes should be following
 	// the accidentals of a different spine...
-	vector<vector<int> > dstates; // diatonic states
-	dstates.resize(kcount);
-	for (i=0; i<kcount; i++) {
-		dstates[i].resize(70);     // 10 octave limit for analysis
-			                        // may cause problems; fix later.
-		std::fill(dstates[i].begin(), dstates[i].end(), 0);
-	}
+	state.dstates.assign(kcount, vector<int>(70, 0)); // 10 octave limit for analysis
+	                                                  // may cause problems; fix later.
 
 	// gdstates == grace note diatonic states for every pitch in a spine.
-	vector<vector<int> > gdstates; // grace-note diatonic states
-	gdstates.resize(kcount);
-	for (i=0; i<kcount; i++) {
-		gdstates[i].resize(70);
-		std::fill(gdstates[i].begin(), gdstates[i].end(), 0);
-	}
+	state.gdstates.assign(kcount, vector<int>(70, 0));
 
 	// rhythmstart == keep track of first beat in measure.
-	vector<int> firstinbar(kcount, 0);
+	state.firstinbar.assign(kcount, 0);
 
-	int lasttrack = -1;
-	vector<int> concurrentstate(70, 0);
+	state.lasttrack = -1;
+	state.concurrentstate.assign(70, 0);
+	return true;
+}
 
-	for (i=0; i<infile.getLineCount(); i++) {
-		if (!infile[i].hasSpines()) {
-			continue;
-		}
-		if (infile[i].isInterpretation()) {
-			for (j=0; j<infile[i].getFieldCount(); j++) {
-				HTp token  = infile.token(i, j);
-				if (!token->isKern()) {
-					continue;
-				}
-				if (token->compare(0, 3, "*k[") == 0) {
-					track = token->getTrack();
-					kindex = rtracks[track];
-					fillKeySignature(keysigs[kindex], *infile[i].token(j));
-					// resetting key states of current measure.  What to do if this
-					// key signature is in the middle of a measure?
-					resetDiatonicStatesWithKeySignature(dstates[kindex], keysigs[kindex]);
-					resetDiatonicStatesWithKeySignature(gdstates[kindex], keysigs[kindex]);
-				}
-			}
-		} else if (infile[i].isBarline()) {
-			for (j=0; j<infile[i].getFieldCount(); j++) {
-				HTp token = infile.token(i, j);
-				if (!token->isKern()) {
-					continue;
-				}
-				if (token->isInvisible()) {
-					continue;
-				}
-				std::fill(firstinbar.begin(), firstinbar.end(), 1);
-				track = token->getTrack();
-				kindex = rtracks[track];
-				// reset the accidental states in dstates to match keysigs.
-				resetDiatonicStatesWithKeySignature(dstates[kindex], keysigs[kindex]);
-				resetDiatonicStatesWithKeySignature(gdstates[kindex], keysigs[kindex]);
-			}
-		}
 
-		if (!infile[i].isData()) {
-			continue;
-		}
-		fill(concurrentstate.begin(), concurrentstate.end(), 0);
-		lasttrack = -1;
 
-		for (j=0; j<infile[i].getFieldCount(); j++) {
-			HTp token = infile.token(i, j);
+//////////////////////////////
+//
+// HumdrumFileContent::startAccidentalLine -- Update the accidental states
+//     for key signatures and barlines on the line.  Returns true if the
+//     line is a data line, in which case the data tokens should be given to
+//     analyzeAccidentalToken() followed by clearing state.firstinbar.
+//
+
+bool HumdrumFileContent::startAccidentalLine(HumdrumLine& line,
+		AccidentalState& state) {
+	int kindex;
+	int track;
+	if (line.isInterpretation()) {
+		for (int j=0; j<line.getFieldCount(); j++) {
+			HTp token = line.token(j);
 			if (!token->isKern()) {
 				continue;
 			}
-			if (token->isNull()) {
+			if (token->compare(0, 3, "*k[") == 0) {
+				track = token->getTrack();
+				kindex = state.rtracks[track];
+				fillKeySignature(state.keysigs[kindex], *token);
+				// resetting key states of current measure.  What to do if this
+				// key signature is in the middle of a measure?
+				resetDiatonicStatesWithKeySignature(state.dstates[kindex], state.keysigs[kindex]);
+				resetDiatonicStatesWithKeySignature(state.gdstates[kindex], state.keysigs[kindex]);
+			}
+		}
+	} else if (line.isBarline()) {
+		for (int j=0; j<line.getFieldCount(); j++) {
+			HTp token = line.token(j);
+			if (!token->isKern()) {
 				continue;
 			}
-			if (token->isRest()) {
+			if (token->isInvisible()) {
 				continue;
 			}
-
-			int subcount = token->getSubtokenCount();
+			std::fill(state.firstinbar.begin(), state.firstinbar.end(), 1);
 			track = token->getTrack();
+			kindex = state.rtracks[track];
+			// reset the accidental states in dstates to match keysigs.
+			resetDiatonicStatesWithKeySignature(state.dstates[kindex], state.keysigs[kindex]);
+			resetDiatonicStatesWithKeySignature(state.gdstates[kindex], state.keysigs[kindex]);
+		}
+	}
 
-			if (lasttrack != track) {
-				fill(concurrentstate.begin(), concurrentstate.end(), 0);
-			}
-			lasttrack = track;
-			int rindex = rtracks[track];
-			for (k=0; k<subcount; k++) {
-				// bool tienote = false;
-				string subtok = token->getSubtoken(k);
-				if (subcount > 1) {
-					// Rests in chords represent unsounding notes.
-					// Rests can have pitch, but this is treated as
-					// Diatonic pitch which does not involve accidentals,
-					// so convert to pitch-like so that accidentals are
-					// processed on these notes.
-					for (int m=0; m<(int)subtok.size(); m++) {
-						if (subtok[m] == 'r') {
-							subtok[m] = 'R';
-						}
-					}
-				}
-				int b40 = Convert::kernToBase40(subtok);
-				int diatonic = Convert::kernToBase7(subtok);
-				int octaveadjust = token->getValueInt("auto", "ottava");
-				diatonic -= octaveadjust * 7;
-				if (diatonic < 0) {
-					// Deal with extra-low notes later.
-					continue;
-				}
-				int graceQ = token->isGrace();
-				int accid = Convert::kernToAccidentalCount(subtok);
-				int hiddenQ = 0;
-				if (subtok.find("yy") == string::npos) {
-					if ((subtok.find("ny") != string::npos) ||
-					    (subtok.find("#y") != string::npos) ||
-					    (subtok.find("-y") != string::npos)) {
-						hiddenQ = 1;
-					}
-				}
+	if (!line.isData()) {
+		return false;
+	}
+	std::fill(state.concurrentstate.begin(), state.concurrentstate.end(), 0);
+	state.lasttrack = -1;
+	return true;
+}
 
-				if (((subtok.find("_") != string::npos) || (subtok.find("]") != string::npos))) {
-					// tienote = true;
-					// tied notes do not have accidentals, so skip them
-					if ((accid != keysigs[rindex][diatonic % 7]) && firstinbar[rindex]) {
-						// But first, prepare to force an accidental to be shown on
-						// the note immediately following the end of a tied group
-						// if the tied group crosses a barline.
-						dstates[rindex][diatonic] = -1000 + accid;
-						gdstates[rindex][diatonic] = -1000 + accid;
-					}
-					auto loc = subtok.find('X');
-					if (loc == string::npos) {
-						continue;
-					} else if (loc == 0) {
-						continue;
-					} else {
-						if (!((subtok[loc-1] == '#') || (subtok[loc-1] == '-') ||
-								(subtok[loc-1] == 'n'))) {
-							continue;
-						} else {
-							// an accidental should be fored at end of tie
-						}
-					}
-				}
 
-				size_t loc;
-				// check for accidentals on trills, mordents and turns.
-				if (subtok.find("t") != string::npos) {
-					// minor second trill
-					int trillnote     = b40 + 5;
-					int trilldiatonic = Convert::base40ToDiatonic(trillnote);
-					int trillaccid    = Convert::base40ToAccidental(trillnote);
-					if (dstates[rindex][trilldiatonic] != trillaccid) {
-						token->setValue("auto", to_string(k),
-								"trillAccidental", to_string(trillaccid));
-						dstates[rindex][trilldiatonic] = -1000 + trillaccid;
-					}
-				} else if (subtok.find("T") != string::npos) {
-					// major second trill
-					int trillnote     = b40 + 6;
-					int trilldiatonic = Convert::base40ToDiatonic(trillnote);
-					int trillaccid    = Convert::base40ToAccidental(trillnote);
-					if (dstates[rindex][trilldiatonic] != trillaccid) {
-						token->setValue("auto", to_string(k), "trillAccidental", to_string(trillaccid));
-						dstates[rindex][trilldiatonic] = -1000 + trillaccid;
-					}
-				} else if (subtok.find("M") != string::npos) {
-					// major second upper mordent
-					int auxnote     = b40 + 6;
-					int auxdiatonic = Convert::base40ToDiatonic(auxnote);
-					int auxaccid    = Convert::base40ToAccidental(auxnote);
-					if (dstates[rindex][auxdiatonic] != auxaccid) {
-						token->setValue("auto", to_string(k), "mordentUpperAccidental", to_string(auxaccid));
-						dstates[rindex][auxdiatonic] = -1000 + auxaccid;
-					}
-				} else if (subtok.find("m") != string::npos) {
-					// minor second upper mordent
-					int auxnote     = b40 + 5;
-					int auxdiatonic = Convert::base40ToDiatonic(auxnote);
-					int auxaccid    = Convert::base40ToAccidental(auxnote);
-					if (dstates[rindex][auxdiatonic] != auxaccid) {
-						token->setValue("auto", to_string(k), "mordentUpperAccidental", to_string(auxaccid));
-						dstates[rindex][auxdiatonic] = -1000 + auxaccid;
-					}
-				} else if (subtok.find("W") != string::npos) {
-					// major second upper mordent
-					int auxnote     = b40 - 6;
-					int auxdiatonic = Convert::base40ToDiatonic(auxnote);
-					int auxaccid    = Convert::base40ToAccidental(auxnote);
-					if (dstates[rindex][auxdiatonic] != auxaccid) {
-						token->setValue("auto", to_string(k),
-								"mordentLowerAccidental", to_string(auxaccid));
-						dstates[rindex][auxdiatonic] = -1000 + auxaccid;
-					}
-				} else if (subtok.find("w") != string::npos) {
-					// minor second upper mordent
-					int auxnote     = b40 - 5;
-					int auxdiatonic = Convert::base40ToDiatonic(auxnote);
-					int auxaccid    = Convert::base40ToAccidental(auxnote);
-					if (dstates[rindex][auxdiatonic] != auxaccid) {
-						token->setValue("auto", to_string(k),
-								"mordentLowerAccidental", to_string(auxaccid));
-						dstates[rindex][auxdiatonic] = -1000 + auxaccid;
-					}
 
-				} else if ((loc = subtok.find("$")) != string::npos) {
-					int turndiatonic = Convert::base40ToDiatonic(b40);
-					// int turnaccid = Convert::base40ToAccidental(b40);
-					// inverted turn
-					int lowerint = 0;
-					int upperint = 0;
-					if (loc < subtok.size()-1) {
-						if (subtok[loc+1] == 's') {
-							lowerint = -5;
-						} else if (subtok[loc+1] == 'S') {
-							lowerint = -6;
-						}
-					}
-					if (loc < subtok.size()-2) {
-						if (subtok[loc+2] == 's') {
-							upperint = +5;
-						} else if (subtok[loc+2] == 'S') {
-							upperint = +6;
-						}
-					}
-					int lowerdiatonic = turndiatonic - 1;
-					// Maybe also need to check for forced accidental state...
-					int loweraccid = dstates[rindex][lowerdiatonic];
-					int lowerb40 = Convert::base7ToBase40(lowerdiatonic) + loweraccid;
-					int upperdiatonic = turndiatonic + 1;
-					// Maybe also need to check for forced accidental state...
-					int upperaccid = dstates[rindex][upperdiatonic];
-					int upperb40 = Convert::base7ToBase40(upperdiatonic) + upperaccid;
-					if (lowerint == 0) {
-						// need to calculate lower interval (but it will not appear
-						// below the inverted turn, just calculating for performance
-						// rendering.
-						lowerint = lowerb40 - b40;
-						lowerb40 = b40 + lowerint;
-					}
-					if (upperint == 0) {
-						// need to calculate upper interval (but it will not appear
-						// above the inverted turn, just calculating for performance
-						// rendering.
-						upperint = upperb40 - b40;
-						upperb40 = b40 + upperint;
-					}
-					int uacc = Convert::base40ToAccidental(b40 + upperint);
-					int bacc = Convert::base40ToAccidental(b40 + lowerint);
-					if (uacc != upperaccid) {
-						token->setValue("auto", to_string(k),
-								"turnUpperAccidental", to_string(uacc));
-						dstates[rindex][upperdiatonic] = -1000 + uacc;
-					}
-					if (bacc != loweraccid) {
-						token->setValue("auto", to_string(k),
-								"turnLowerAccidental", to_string(bacc));
-						dstates[rindex][lowerdiatonic] = -1000 + bacc;
-					}
-				} else if ((loc = subtok.find("S")) != string::npos) {
-					int turndiatonic = Convert::base40ToDiatonic(b40);
-					// int turnaccid = Convert::base40ToAccidental(b40);
-					// regular turn
-					int lowerint = 0;
-					int upperint = 0;
-					if (loc < subtok.size()-1) {
-						if (subtok[loc+1] == 's') {
-							upperint = +5;
-						} else if (subtok[loc+1] == 'S') {
-							upperint = +6;
-						}
-					}
-					if (loc < subtok.size()-2) {
-						if (subtok[loc+2] == 's') {
-							lowerint = -5;
-						} else if (subtok[loc+2] == 'S') {
-							lowerint = -6;
-						}
-					}
-					int lowerdiatonic = turndiatonic - 1;
-					// Maybe also need to check for forced accidental state...
-					int loweraccid = dstates[rindex][lowerdiatonic];
-					int lowerb40 = Convert::base7ToBase40(lowerdiatonic) + loweraccid;
-					int upperdiatonic = turndiatonic + 1;
-					// Maybe also need to check for forced accidental state...
-					int upperaccid = dstates[rindex][upperdiatonic];
-					int upperb40 = Convert::base7ToBase40(upperdiatonic) + upperaccid;
-					if (lowerint == 0) {
-						// need to calculate lower interval (but it will not appear
-						// below the inverted turn, just calculating for performance
-						// rendering.
-						lowerint = lowerb40 - b40;
-						lowerb40 = b40 + lowerint;
-					}
-					if (upperint == 0) {
-						// need to calculate upper interval (but it will not appear
-						// above the inverted turn, just calculating for performance
-						// rendering.
-						upperint = upperb40 - b40;
-						upperb40 = b40 + upperint;
-					}
-					int uacc = Convert::base40ToAccidental(b40 + upperint);
-					int bacc = Convert::base40ToAccidental(b40 + lowerint);
+//////////////////////////////
+//
+// HumdrumFileContent::analyzeAccidentalToken -- Identify the accidentals
+//     to display on a note or chord token, given its subtokens.
+//
 
-					if (uacc != upperaccid) {
-						token->setValue("auto", to_string(k), "turnUpperAccidental", to_string(uacc));
-						dstates[rindex][upperdiatonic] = -1000 + uacc;
-					}
-					if (bacc != loweraccid) {
-						token->setValue("auto", to_string(k), "turnLowerAccidental", to_string(bacc));
-						dstates[rindex][lowerdiatonic] = -1000 + bacc;
-					}
-				}
+void HumdrumFileContent::analyzeAccidentalToken(HTp token,
+		const vector<string>& subtokens, AccidentalState& state) {
+	vector<int>& rtracks = state.rtracks;
+	vector<vector<int>>& keysigs = state.keysigs;
+	vector<vector<int>>& dstates = state.dstates;
+	vector<vector<int>>& gdstates = state.gdstates;
+	vector<int>& firstinbar = state.firstinbar;
+	vector<int>& concurrentstate = state.concurrentstate;
 
-				// if (tienote) {
-				// 	continue;
-				// }
-
-				if (graceQ && (accid != gdstates[rindex][diatonic])) {
-					// accidental is different from the previous state so should be
-					// printed
-					if (!hiddenQ) {
-						token->setValue("auto", to_string(k), "visualAccidental", "true");
-						if (gdstates[rindex][diatonic] < -900) {
-							// this is an obligatory cautionary accidental
-							// or at least half the time it is (figure that out later)
-							token->setValue("auto", to_string(k), "obligatoryAccidental", "true");
-							token->setValue("auto", to_string(k), "cautionaryAccidental", "true");
-						}
-					}
-					gdstates[rindex][diatonic] = accid;
-					// regular notes are not affected by grace notes accidental
-					// changes, but should have an obligatory cautionary accidental,
-					// displayed for clarification.
-					dstates[rindex][diatonic] = -1000 + accid;
-
-				} else if (!graceQ && ((concurrentstate[diatonic] && (concurrentstate[diatonic] == accid))
-						|| (accid != dstates[rindex][diatonic]))) {
-					// accidental is different from the previous state so should be
-					// printed, but only print if not supposed to be hidden.
-					if (!hiddenQ) {
-						token->setValue("auto", to_string(k), "visualAccidental", "true");
-						concurrentstate[diatonic] = accid;
-						if (dstates[rindex][diatonic] < -900) {
-							// this is an obligatory cautionary accidental
-							// or at least half the time it is (figure that out later)
-							token->setValue("auto", to_string(k), "obligatoryAccidental", "true");
-							token->setValue("auto", to_string(k), "cautionaryAccidental", "true");
-						}
-					}
-					dstates[rindex][diatonic] = accid;
-					gdstates[rindex][diatonic] = accid;
+	int subcount = (int)subtokens.size();
+	int track = token->getTrack();
+
+	if (state.lasttrack != track) {
+		fill(concurrentstate.begin(), concurrentstate.end(), 0);
+	}
+	state.lasttrack = track;
+	int rindex = rtracks[track];
+	for (int k=0; k<subcount; k++) {
+		// bool tienote = false;
+		string subtok = subtokens[k];
+		if (subcount > 1) {
+			// Rests in chords represent unsounding notes.
+			// Rests can have pitch, but this is treated as
+			// Diatonic pitch which does not involve accidentals,
+			// so convert to pitch-like so that accidentals are
+			// processed on these notes.
+			for (int m=0; m<(int)subtok.size(); m++) {
+				if (subtok[m] == 'r') {
+					subtok[m] = 'R';
+				}
+			}
+		}
+		int b40 = Convert::kernToBase40(subtok);
+		int diatonic = Convert::kernToBase7(subtok);
+		int octaveadjust = token->getValueInt("auto", "ottava");
+		diatonic -= octaveadjust * 7;
+		if (diatonic < 0) {
+			// Deal with extra-low notes later.
+			continue;
+		}
+		int graceQ = token->isGrace();
+		int accid = Convert::kernToAccidentalCount(subtok);
+		int hiddenQ = 0;
+		if (subtok.find("yy") == string::npos) {
+			if ((subtok.find("ny") != string::npos) ||
+			    (subtok.find("#y") != string::npos) ||
+			    (subtok.find("-y") != string::npos)) {
+				hiddenQ = 1;
+			}
+		}
+
+		if (((subtok.find("_") != string::npos) || (subtok.find("]") != string::npos))) {
+			// tienote = true;
+			// tied notes do not have accidentals, so skip them
+			if ((accid != keysigs[rindex][diatonic % 7]) && firstinbar[rindex]) {
+				// But first, prepare to force an accidental to be shown on
+				// the note immediately following the end of a tied group
+				// if the tied group crosses a barline.
+				dstates[rindex][diatonic] = -1000 + accid;
+				gdstates[rindex][diatonic] = -1000 + accid;
+			}
+			auto loc = subtok.find('X');
+			if (loc == string::npos) {
+				continue;
+			} else if (loc == 0) {
+				continue;
+			} else {
+				if (!((subtok[loc-1] == '#') || (subtok[loc-1] == '-') ||
+						(subtok[loc-1] == 'n'))) {
+					continue;
+				} else {
+					// an accidental should be fored at end of tie
+				}
+			}
+		}
+
+		size_t loc;
+		// check for accidentals on trills, mordents and turns.
+		if (subtok.find("t") != string::npos) {
+			// minor second trill
+			int trillnote     = b40 + 5;
+			int trilldiatonic = Convert::base40ToDiatonic(trillnote);
+			int trillaccid    = Convert::base40ToAccidental(trillnote);
+			if (dstates[rindex][trilldiatonic] != trillaccid) {
+				token->setValue("auto", to_string(k),
+						"trillAccidental", to_string(trillaccid));
+				dstates[rindex][trilldiatonic] = -1000 + trillaccid;
+			}
+		} else if (subtok.find("T") != string::npos) {
+			// major second trill
+			int trillnote     = b40 + 6;
+			int trilldiatonic = Convert::base40ToDiatonic(trillnote);
+			int trillaccid    = Convert::base40ToAccidental(trillnote);
+			if (dstates[rindex][trilldiatonic] != trillaccid) {
+				token->setValue("auto", to_string(k), "trillAccidental", to_string(trillaccid));
+				dstates[rindex][trilldiatonic] = -1000 + trillaccid;
+			}
+		} else if (subtok.find("M") != string::npos) {
+			// major second upper mordent
+			int auxnote     = b40 + 6;
+			int auxdiatonic = Convert::base40ToDiatonic(auxnote);
+			int auxaccid    = Convert::base40ToAccidental(auxnote);
+			if (dstates[rindex][auxdiatonic] != auxaccid) {
+				token->setValue("auto", to_string(k), "mordentUpperAccidental", to_string(auxaccid));
+				dstates[rindex][auxdiatonic] = -1000 + auxaccid;
+			}
+		} else if (subtok.find("m") != string::npos) {
+			// minor second upper mordent
+			int auxnote     = b40 + 5;
+			int auxdiatonic = Convert::base40ToDiatonic(auxnote);
+			int auxaccid    = Convert::base40ToAccidental(auxnote);
+			if (dstates[rindex][auxdiatonic] != auxaccid) {
+				token->setValue("auto", to_string(k), "mordentUpperAccidental", to_string(auxaccid));
+				dstates[rindex][auxdiatonic] = -1000 + auxaccid;
+			}
+		} else if (subtok.find("W") != string::npos) {
+			// major second upper mordent
+			int auxnote     = b40 - 6;
+			int auxdiatonic = Convert::base40ToDiatonic(auxnote);
+			int auxaccid    = Convert::base40ToAccidental(auxnote);
+			if (dstates[rindex][auxdiatonic] != auxaccid) {
+				token->setValue("auto", to_string(k),
+						"mordentLowerAccidental", to_string(auxaccid));
+				dstates[rindex][auxdiatonic] = -1000 + auxaccid;
+			}
+		} else if (subtok.find("w") != string::npos) {
+			// minor second upper mordent
+			int auxnote     = b40 - 5;
+			int auxdiatonic = Convert::base40ToDiatonic(auxnote);
+			int auxaccid    = Convert::base40ToAccidental(auxnote);
+			if (dstates[rindex][auxdiatonic] != auxaccid) {
+				token->setValue("auto", to_string(k),
+						"mordentLowerAccidental", to_string(auxaccid));
+				dstates[rindex][auxdiatonic] = -1000 + auxaccid;
+			}
+
+		} else if ((loc = subtok.find("$")) != string::npos) {
+			int turndiatonic = Convert::base40ToDiatonic(b40);
+			// int turnaccid = Convert::base40ToAccidental(b40);
+			// inverted turn
+			int lowerint = 0;
+			int upperint = 0;
+			if (loc < subtok.size()-1) {
+				if (subtok[loc+1] == 's') {
+					lowerint = -5;
+				} else if (subtok[loc+1] == 'S') {
+					lowerint = -6;
+				}
+			}
+			if (loc < subtok.size()-2) {
+				if (subtok[loc+2] == 's') {
+					upperint = +5;
+				} else if (subtok[loc+2] == 'S') {
+					upperint = +6;
+				}
+			}
+			int lowerdiatonic = turndiatonic - 1;
+			// Maybe also need to check for forced accidental state...
+			int loweraccid = dstates[rindex][lowerdiatonic];
+			int lowerb40 = Convert::base7ToBase40(lowerdiatonic) + loweraccid;
+			int upperdiatonic = turndiatonic + 1;
+			// Maybe also need to check for forced accidental state...
+			int upperaccid = dstates[rindex][upperdiatonic];
+			int upperb40 = Convert::base7ToBase40(upperdiatonic) + upperaccid;
+			if (lowerint == 0) {
+				// need to calculate lower interval (but it will not appear
+				// below the inverted turn, just calculating for performance
+				// rendering.
+				lowerint = lowerb40 - b40;
+				lowerb40 = b40 + lowerint;
+			}
+			if (upperint == 0) {
+				// need to calculate upper interval (but it will not appear
+				// above the inverted turn, just calculating for performance
+				// rendering.
+				upperint = upperb40 - b40;
+				upperb40 = b40 + upperint;
+			}
+			int uacc = Convert::base40ToAccidental(b40 + upperint);
+			int bacc = Convert::base40ToAccidental(b40 + lowerint);
+			if (uacc != upperaccid) {
+				token->setValue("auto", to_string(k),
+						"turnUpperAccidental", to_string(uacc));
+				dstates[rindex][upperdiatonic] = -1000 + uacc;
+			}
+			if (bacc != loweraccid) {
+				token->setValue("auto", to_string(k),
+						"turnLowerAccidental", to_string(bacc));
+				dstates[rindex][lowerdiatonic] = -1000 + bacc;
+			}
+		} else if ((loc = subtok.find("S")) != string::npos) {
+			int turndiatonic = Convert::base40ToDiatonic(b40);
+			// int turnaccid = Convert::base40ToAccidental(b40);
+			// regular turn
+			int lowerint = 0;
+			int upperint = 0;
+			if (loc < subtok.size()-1) {
+				if (subtok[loc+1] == 's') {
+					upperint = +5;
+				} else if (subtok[loc+1] == 'S') {
+					upperint = +6;
+				}
+			}
+			if (loc < subtok.size()-2) {
+				if (subtok[loc+2] == 's') {
+					lowerint = -5;
+				} else if (subtok[loc+2] == 'S') {
+					lowerint = -6;
+				}
+			}
+			int lowerdiatonic = turndiatonic - 1;
+			// Maybe also need to check for forced accidental state...
+			int loweraccid = dstates[rindex][lowerdiatonic];
+			int lowerb40 = Convert::base7ToBase40(lowerdiatonic) + loweraccid;
+			int upperdiatonic = turndiatonic + 1;
+			// Maybe also need to check for forced accidental state...
+			int upperaccid = dstates[rindex][upperdiatonic];
+			int upperb40 = Convert::base7ToBase40(upperdiatonic) + upperaccid;
+			if (lowerint == 0) {
+				// need to calculate lower interval (but it will not appear
+				// below the inverted turn, just calculating for performance
+				// rendering.
+				lowerint = lowerb40 - b40;
+				lowerb40 = b40 + lowerint;
+			}
+			if (upperint == 0) {
+				// need to calculate upper interval (but it will not appear
+				// above the inverted turn, just calculating for performance
+				// rendering.
+				upperint = upperb40 - b40;
+				upperb40 = b40 + upperint;
+			}
+			int uacc = Convert::base40ToAccidental(b40 + upperint);
+			int bacc = Convert::base40ToAccidental(b40 + lowerint);
+
+			if (uacc != upperaccid) {
+				token->setValue("auto", to_string(k), "turnUpperAccidental", to_string(uacc));
+				dstates[rindex][upperdiatonic] = -1000 + uacc;
+			}
+			if (bacc != loweraccid) {
+				token->setValue("auto", to_string(k), "turnLowerAccidental", to_string(bacc));
+				dstates[rindex][lowerdiatonic] = -1000 + bacc;
+			}
+		}
+
+		// if (tienote) {
+		// 	continue;
+		// }
 
-				} else if ((accid == 0) && (subtok.find("n") != string::npos) && !hiddenQ) {
+		if (graceQ && (accid != gdstates[rindex][diatonic])) {
+			// accidental is different from the previous state so should be
+			// printed
+			if (!hiddenQ) {
+				token->setValue("auto", to_string(k), "visualAccidental", "true");
+				if (gdstates[rindex][diatonic] < -900) {
+					// this is an obligatory cautionary accidental
+					// or at least half the time it is (figure that out later)
+					token->setValue("auto", to_string(k), "obligatoryAccidental", "true");
+					token->setValue("auto", to_string(k), "cautionaryAccidental", "true");
+				}
+			}
+			gdstates[rindex][diatonic] = accid;
+			// regular notes are not affected by grace notes accidental
+			// changes, but should have an obligatory cautionary accidental,
+			// displayed for clarification.
+			dstates[rindex][diatonic] = -1000 + accid;
+
+		} else if (!graceQ && ((concurrentstate[diatonic] && (concurrentstate[diatonic] == accid))
+				|| (accid != dstates[rindex][diatonic]))) {
+			// accidental is different from the previous state so should be
+			// printed, but only print if not supposed to be hidden.
+			if (!hiddenQ) {
+				token->setValue("auto", to_string(k), "visualAccidental", "true");
+				concurrentstate[diatonic] = accid;
+				if (dstates[rindex][diatonic] < -900) {
+					// this is an obligatory cautionary accidental
+					// or at least half the time it is (figure that out later)
+					token->setValue("auto", to_string(k), "obligatoryAccidental", "true");
+					token->setValue("auto", to_string(k), "cautionaryAccidental", "true");
+				}
+			}
+			dstates[rindex][diatonic] = accid;
+			gdstates[rindex][diatonic] = accid;
+
+		} else if ((accid == 0) && (subtok.find("n") != string::npos) && !hiddenQ) {
+			token->setValue("auto", to_string(k), "cautionaryAccidental", "true");
+			token->setValue("auto", to_string(k), "visualAccidental", "true");
+		} else if (subtok.find("XX") == string::npos) {
+			// The accidental is not necessary. See if there is a single "X"
+			// immediately after the accidental which means to force it to
+			// display.
+			auto loc = subtok.find("X");
+			if ((loc != string::npos) && (loc > 0)) {
+				if (subtok[loc-1] == '#') {
+					token->setValue("auto", to_string(k), "cautionaryAccidental", "true");
+					token->setValue("auto", to_string(k), "visualAccidental", "true");
+				} else if (subtok[loc-1] == '-') {
+					token->setValue("auto", to_string(k), "cautionaryAccidental", "true");
+					token->setValue("auto", to_string(k), "visualAccidental", "true");
+				} else if (subtok[loc-1] == 'n') {
 					token->setValue("auto", to_string(k), "cautionaryAccidental", "true");
 					token->setValue("auto", to_string(k), "visualAccidental", "true");
-				} else if (subtok.find("XX") == string::npos) {
-					// The accidental is not necessary. See if there is a single "X"
-					// immediately after the accidental which means to force it to
-					// display.
-					auto loc = subtok.find("X");
-					if ((loc != string::npos) && (loc > 0)) {
-						if (subtok[loc-1] == '#') {
-							token->setValue("auto", to_string(k), "cautionaryAccidental", "true");
-							token->setValue("auto", to_string(k), "visualAccidental", "true");
-						} else if (subtok[loc-1] == '-') {
-							token->setValue("auto", to_string(k), "cautionaryAccidental", "true");
-							token->setValue("auto", to_string(k), "visualAccidental", "true");
-						} else if (subtok[loc-1] == 'n') {
-							token->setValue("auto", to_string(k), "cautionaryAccidental", "true");
-							token->setValue("auto", to_string(k), "visualAccidental", "true");
-						}
-					}
 				}
 			}
 		}
-		std::fill(firstinbar.begin(), firstinbar.end(), 0);
 	}
-
-	// Indicate that the accidental analysis has been done:
-	string dataTypeDone = "accidentalAnalysis" + dataType;
-	infile.setValue("auto", dataTypeDone, "true");
-
-	return true;
 }
 
 
@@ -26254,64 +30079,11 @@ bool HumdrumFileContent::analyzeBeams(void) {
 bool HumdrumFileContent::analyzeMensBeams(void) {
 	vector<HTp> beamstarts;
 	vector<HTp> beamends;
-
-	vector<HTp> l;
-	vector<pair<HTp, HTp>> labels; // first is previous label, second is next label
-	HumdrumFileBase& infile = *this;
-	labels.resize(infile.getLineCount());
-	l.resize(infile.getLineCount());
-	for (int i=0; i<infile.getLineCount(); i++) {
-		labels[i].first = NULL;
-		labels[i].second = NULL;
-		l[i] = NULL;
-	}
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (!infile[i].isInterpretation()) {
-			continue;
-		}
-		HTp token = infile.token(i, 0);
-		if ((token->compare(0, 2, "*>") == 0) && (token->find("[") == std::string::npos)) {
-			l[i] = token;
-		}
-	}
-	HTp current = NULL;
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (l[i] != NULL) {
-			current = l[i];
-		}
-		labels[i].first = current;
-	}
-	current = NULL;
-	for (int i=infile.getLineCount() - 1; i>=0; i--) {
-		if (l[i] != NULL) {
-			current = l[i];
-		}
-		labels[i].second = current;
-	}
-
-	vector<int> endings(infile.getLineCount(), 0);
-	int ending = 0;
-	for (int i=0; i<(int)endings.size(); i++) {
-		if (l[i]) {
-			char lastchar = l[i]->back();
-			if (isdigit(lastchar)) {
-				ending = lastchar - '0';
-			} else {
-				ending = 0;
-			}
-		}
-		endings[i] = ending;
-	}
-
 	vector<HTp> mensspines;
 	getSpineStartList(mensspines, "**mens");
-	bool output = true;
-	string linkSignifier = m_signifiers.getKernLinkSignifier();
-	for (int i=0; i<(int)mensspines.size(); i++) {
-		output = output && analyzeKernBeams(mensspines[i], beamstarts, beamends, labels, endings, linkSignifier);
-	}
+	analyzeSpans(mensspines, 'L', beamstarts, beamends);
 	createLinkedBeams(beamstarts, beamends);
-	return output;
+	return true;
 }
 
 
@@ -26325,198 +30097,21 @@ bool HumdrumFileContent::analyzeMensBeams(void) {
 bool HumdrumFileContent::analyzeKernBeams(void) {
 	vector<HTp> beamstarts;
 	vector<HTp> beamends;
-
-	vector<HTp> l;
-	vector<pair<HTp, HTp>> labels; // first is previous label, second is next label
-	HumdrumFileBase& infile = *this;
-	labels.resize(infile.getLineCount());
-	l.resize(infile.getLineCount());
-	for (int i=0; i<infile.getLineCount(); i++) {
-		labels[i].first = NULL;
-		labels[i].second = NULL;
-		l[i] = NULL;
-	}
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (!infile[i].isInterpretation()) {
-			continue;
-		}
-		HTp token = infile.token(i, 0);
-		if ((token->compare(0, 2, "*>") == 0) && (token->find("[") == std::string::npos)) {
-			l[i] = token;
-		}
-	}
-	HTp current = NULL;
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (l[i] != NULL) {
-			current = l[i];
-		}
-		labels[i].first = current;
-	}
-	current = NULL;
-	for (int i=infile.getLineCount() - 1; i>=0; i--) {
-		if (l[i] != NULL) {
-			current = l[i];
-		}
-		labels[i].second = current;
-	}
-
-	vector<int> endings(infile.getLineCount(), 0);
-	int ending = 0;
-	for (int i=0; i<(int)endings.size(); i++) {
-		if (l[i]) {
-			char lastchar = l[i]->back();
-			if (isdigit(lastchar)) {
-				ending = lastchar - '0';
-			} else {
-				ending = 0;
-			}
-		}
-		endings[i] = ending;
-	}
-
 	vector<HTp> kernspines;
 	getSpineStartList(kernspines, "**kern");
-	bool output = true;
-	string linkSignifier = m_signifiers.getKernLinkSignifier();
-	for (int i=0; i<(int)kernspines.size(); i++) {
-		output = output && analyzeKernBeams(kernspines[i], beamstarts, beamends, labels, endings, linkSignifier);
-	}
-
+	analyzeSpans(kernspines, 'L', beamstarts, beamends);
 	createLinkedBeams(beamstarts, beamends);
-	return output;
+	return true;
 }
 
 
 bool HumdrumFileContent::analyzeKernBeams(HTp spinestart,
 		vector<HTp>& linkstarts, vector<HTp>& linkends, vector<pair<HTp, HTp>>& labels,
 		vector<int>& endings, const string& linksig) {
-
-	// linked beams handled separately, so generate an ignore sequence:
-	string ignorebegin = linksig + "L";
-	string ignoreend = linksig + "J";
-
-	// tracktokens == the 2-D data list for the track,
-	// arranged in layers with the second dimension.
-	vector<vector<HTp> > tracktokens;
-	this->getTrackSeq(tracktokens, spinestart, OPT_DATA | OPT_NOEMPTY);
-	// printSequence(tracktokens);
-
-	// beamopens == list of beam openings for each track and elision level
-	// first dimension: elision level
-	// second dimension: track number
-	vector<vector<vector<HTp>>> beamopens;
-
-	beamopens.resize(4); // maximum of 4 elision levels
-	for (int i=0; i<(int)beamopens.size(); i++) {
-		beamopens[i].resize(8);  // maximum of 8 layers
-	}
-
-	int opencount = 0;
-	int closecount = 0;
-	int elision = 0;
-	HTp token;
-	for (int row=0; row<(int)tracktokens.size(); row++) {
-		for (int track=0; track<(int)tracktokens[row].size(); track++) {
-			token = tracktokens[row][track];
-			if (!token->isData()) {
-				continue;
-			}
-			if (token->isNull()) {
-				continue;
-			}
-			opencount = (int)count(token->begin(), token->end(), 'L');
-			closecount = (int)count(token->begin(), token->end(), 'J');
-
-			for (int i=0; i<closecount; i++) {
-				bool isLinked = isLinkedBeamEnd(token, i, ignoreend);
-				if (isLinked) {
-					linkends.push_back(token);
-					continue;
-				}
-				elision = token->getBeamEndElisionLevel(i);
-				if (elision < 0) {
-					continue;
-				}
-				if (beamopens[elision][track].size() > 0) {
-					linkBeamEndpoints(beamopens[elision][track].back(), token);
-					// remove beam opening from buffer
-					beamopens[elision][track].pop_back();
-				} else {
-					// No starting beam marker to match to this beam end in the
-					// given track.
-					// search for an open beam in another track:
-					bool found = false;
-					for (int itrack=0; itrack<(int)beamopens[elision].size(); itrack++) {
-						if (beamopens[elision][itrack].size() > 0) {
-							linkBeamEndpoints(beamopens[elision][itrack].back(), token);
-							// remove beam opening from buffer
-							beamopens[elision][itrack].pop_back();
-							found = true;
-							break;
-						}
-					}
-					if (!found) {
-						int lineindex = token->getLineIndex();
-						int endnum = endings[lineindex];
-						int pindex = -1;
-						if (labels[lineindex].first) {
-							pindex = labels[lineindex].first->getLineIndex();
-							pindex--;
-						}
-						int endnumpre = -1;
-						if (pindex >= 0) {
-							endnumpre = endings[pindex];
-						}
-
-						if ((endnumpre > 0) && (endnum > 0) && (endnumpre != endnum)) {
-							// This is a beam in an ending that start at the start of an ending.
-							HumNum duration = token->getDurationFromStart();
-							if (labels[token->getLineIndex()].first) {
-								duration -= labels[token->getLineIndex()].first->getDurationFromStart();
-							}
-							token->setValue("auto", "endingBeamBack", "true");
-							token->setValue("auto", "beamSide", "stop");
-							token->setValue("auto", "beamDuration",
-								token->getDurationToEnd());
-						} else {
-							// This is a beam closing that does not have a matching opening.
-							token->setValue("auto", "hangingBeam", "true");
-							token->setValue("auto", "beamSide", "stop");
-							token->setValue("auto", "beamOpenIndex", to_string(i));
-							token->setValue("auto", "beamDuration",
-								token->getDurationToEnd());
-						}
-					}
-				}
-			}
-
-			for (int i=0; i<opencount; i++) {
-				bool isLinked = isLinkedBeamBegin(token, i, ignorebegin);
-				if (isLinked) {
-					linkstarts.push_back(token);
-					continue;
-				}
-				elision = token->getBeamStartElisionLevel(i);
-				if (elision < 0) {
-					continue;
-				}
-				beamopens[elision][track].push_back(token);
-			}
-		}
-	}
-
-	// Mark un-closed beam starts:
-	for (int i=0; i<(int)beamopens.size(); i++) {
-		for (int j=0; j<(int)beamopens[i].size(); j++) {
-			for (int k=0; k<(int)beamopens[i][j].size(); k++) {
-				beamopens[i][j][k]->setValue("", "auto", "hangingBeam", "true");
-				beamopens[i][j][k]->setValue("", "auto", "beamSide", "start");
-				beamopens[i][j][k]->setValue("", "auto", "beamDuration",
-						beamopens[i][j][k]->getDurationFromStart());
-			}
-		}
-	}
-
+	SpanState state('L', linksig);
+	analyzeSpineSpans(spinestart, state, labels, endings);
+	linkstarts.insert(linkstarts.end(), state.linkstarts.begin(), state.linkstarts.end());
+	linkends.insert(linkends.end(), state.linkends.begin(), state.linkends.end());
 	return true;
 }
 
@@ -26849,7 +30444,7 @@ vector<int> HumdrumFileContent::getTrackToKernIndex(void) {
 
 //////////////////////////////
 //
-// HumdrumFileStructure::getMetricLevels -- Each line in the output
+// HumdrumFileContent::getMetricLevels -- Each line in the output
 //     vector matches to the line of the metric analysis data.
 //     undefined is the value to represent undefined analysis data
 //     (for non-data spines).
@@ -26864,17 +30459,97 @@ vector<int> HumdrumFileContent::getTrackToKernIndex(void) {
 void HumdrumFileContent::getMetricLevels(vector<double>& output,
 		int track, double undefined) {
 
-	HumdrumFileStructure& infile = *this;
+	HumdrumFileContent& infile = *this;
 	int lineCount = infile.getLineCount();
 	output.resize(lineCount);
 	fill(output.begin(), output.end(), undefined);
-	vector<HTp> kernspines = infile.getKernSpineStartList();
-	if ((track == 0) && (kernspines.size() > 0)) {
+
+	if ((track == 0) || (track == getMetricTrack())) {
+		for (int i=0; i<lineCount; i++) {
+			if (infile[i].isData()) {
+				output[i] = getMetricPosition(i).level;
+			}
+		}
+		return;
+	}
+
+	vector<HumMetricPosition> positions;
+	fillMetricPositions(positions, track);
+	for (int i=0; i<lineCount; i++) {
+		if (infile[i].isData()) {
+			output[i] = positions[i].level;
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileContent::getMetricTrack -- Return the track used for the
+//     time signatures of the metric positions: the first **kern spine
+//     in the file, or the first spine if there are no **kern spines.
+//
+
+int HumdrumFileContent::getMetricTrack(void) {
+	vector<HTp> kernspines = getKernSpineStartList();
+	int track = 0;
+	if (kernspines.size() > 0) {
 		track = kernspines[0]->getTrack();
 	}
 	if (track == 0) {
 		track = 1;
 	}
+	return track;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileContent::analyzeMetricPositions -- Store the metric position
+//     of each line.  This is done automatically by getMetricPosition(),
+//     and is redone after the rhythm of the file is analyzed again, or
+//     lines are inserted or deleted.
+//
+
+void HumdrumFileContent::analyzeMetricPositions(void) {
+	fillMetricPositions(m_metricpositions, getMetricTrack());
+	m_analyses.m_metric_analyzed = true;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileContent::getMetricPosition -- Return the metric position
+//     of a line, using the time signatures of the first **kern spine.
+//
+
+const HumMetricPosition& HumdrumFileContent::getMetricPosition(int line) {
+	if ((!m_analyses.m_metric_analyzed) ||
+			((int)m_metricpositions.size() != getLineCount())) {
+		analyzeMetricPositions();
+	}
+	return m_metricpositions[line];
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileContent::fillMetricPositions -- Calculate the metric position
+//     of each line, using the time signatures in the given track.
+//
+
+void HumdrumFileContent::fillMetricPositions(vector<HumMetricPosition>& positions,
+		int track) {
+
+	HumdrumFileContent& infile = *this;
+	int lineCount = infile.getLineCount();
+	positions.clear();
+	positions.resize(lineCount);
+	int tpq = infile.tpq();
 
 	int top = 1;                // top number of time signature (0 for no meter)
 	int bot = 4;                // bottom number of time signature
@@ -26883,8 +30558,14 @@ void HumdrumFileContent::getMetricLevels(vector<double>& output,
 	HumNum measurepos;          // quarter notes from the start of barline
 	HumNum combeatdur;          // for adjusting beat level in compound meters
 	HumNum commeasurepos;       // for adjusting beat level in compound meters
+	int measure = 0;
 
 	for (int i=0; i<lineCount; i++) {
+		HumMetricPosition& position = positions[i];
+		position.measure = measure;
+		if (infile[i].isBarline()) {
+			measure++;
+		}
 		if (infile[i].isInterpretation()) {
 			// check for time signature:
 			HumdrumLine& line = *infile.getLine(i);
@@ -26907,30 +30588,45 @@ void HumdrumFileContent::getMetricLevels(vector<double>& output,
 				}
 			}
 		}
-		if (!infile[i].isData()) {
-				continue;
+		if (!infile[i].hasSpines()) {
+			continue;
 		}
 
-		measurepos = infile[i].getDurationFromBarline();
+		HumNum durbar = infile[i].getDurationFromBarline();
+		position.ticks = (durbar * tpq).getInteger();
+		if (durbar.isInteger()) {
+			if (durbar.getNumerator() % 4 == 0) {
+				position.weight = 2;
+			} else if (durbar.getNumerator() % 2 == 0) {
+				position.weight = 1;
+			} else {
+				position.weight = 0;
+			}
+		}
 		// Might want to handle cases where the time signature changes in
 		// the middle or a measure...
-		measurepos /= beatdur;
+		measurepos = durbar / beatdur;
+		position.beat = measurepos.getInteger();
+
+		if (!infile[i].isData()) {
+			continue;
+		}
 		int denominator = measurepos.getDenominator();
 		if (compoundQ) {
-			output[i] = Convert::nearIntQuantize(log(denominator) / log(3.0));
-			if ((output[i] != 0.0) && (output[i] != 1.0)) {
+			position.level = Convert::nearIntQuantize(log(denominator) / log(3.0));
+			if ((position.level != 0.0) && (position.level != 1.0)) {
 				// if not the beat or first level, then calculate
 				// levels above level 1.  In 6/8 this means
 				// to move the 8th note level to be the "beat"
 				// and then use binary levels for rhythmic levels
 				// smaller than a beat.
 				combeatdur.setValue(4,bot);
-				commeasurepos = infile[i].getDurationFromBarline() / combeatdur;
+				commeasurepos = durbar / combeatdur;
 				denominator = commeasurepos.getDenominator();
-				output[i] = 1.0 + log(denominator)/log(2.0);
+				position.level = 1.0 + log(denominator)/log(2.0);
 			}
 		} else {
-			output[i] = Convert::nearIntQuantize(log(denominator) / log(2.0));
+			position.level = Convert::nearIntQuantize(log(denominator) / log(2.0));
 		}
 	}
 }
@@ -26939,6 +30635,7 @@ void HumdrumFileContent::getMetricLevels(vector<double>& output,
 
 
 
+
 /////////////////////////////////
 //
 // HumdrumFileContent::fillMidiInfo -- Create a data structure that
@@ -26988,27 +30685,31 @@ void HumdrumFileContent::fillMidiInfo(vector<vector<vector<pair<HTp, int>>>>& tr
 
 void HumdrumFileContent::processStrandNotesForMidi(HTp sstart, HTp send, vector<vector<pair<HTp, int>>>& trackInfo) {
 	HTp current = sstart->getNextToken();
+	string subtoken;
 	while (current && (current != send)) {
 		if (!current->isData() || current->isNull()) {
 			current = current->getNextToken();
 			continue;
 		}
-		vector<string> subtokens = current->getSubtokens();
-		for (int i=0; i<(int)subtokens.size(); i++) {
-			if (subtokens[i] == ".") {
+		// Iterate over subtokens without creating a list of them:
+		HumSubtokenRange subtokens = current->getSubtokenViews();
+		for (auto it = subtokens.begin(); it != subtokens.end(); ++it) {
+			subtoken.assign(*it);
+			int index = it.getIndex();
+			if (subtoken == ".") {
 				// something strange happened (no null tokens expected)
 				continue;
 			}
-			if (subtokens[i].find("r") != string::npos) {
+			if (subtoken.find("r") != string::npos) {
 				// rest, so store in MIDI[0]
 				trackInfo.at(0).emplace_back(current, 0);
-			} else if (subtokens[i].find("R") != string::npos) {
+			} else if (subtoken.find("R") != string::npos) {
 				// unpitched or quasi-pitched note, so store in MIDI[0]
 				trackInfo.at(0).emplace_back(current, 0);
 			} else {
-				int keyno = Convert::kernToMidiNoteNumber(subtokens[i]);
+				int keyno = Convert::kernToMidiNoteNumber(subtoken);
 				if ((keyno >= 0) && (keyno < 128)) {
-					trackInfo.at(keyno).emplace_back(current, i);
+					trackInfo.at(keyno).emplace_back(current, index);
 				}
 			}
 		}
@@ -27018,6 +30719,769 @@ void HumdrumFileContent::processStrandNotesForMidi(HTp sstart, HTp send, vector<
 
 
 
+//////////////////////////////
+//
+// HumdrumFileContent::getMidiEvents -- Generate note-on, note-off and tempo
+//     (from *MM) events for the **kern spines in the file, and send them to
+//     the callback function in time order.  Tied notes generate a single
+//     note-on/note-off pair: ties are followed through the spine from the
+//     first note, or with the links from analyzeKernTies() for linked ties.
+//     Only currently sounding notes are stored while processing the file,
+//     so long files use little memory.  Returns
+//     the tick time at the end of the file, which can be given as the
+//     tickoffset for the next file when converting a set of concatenated
+//     files into a single MIDI file.
+//
+//     tpq        == ticks per quarter note (0 = use tpq() of the file).
+//     tickoffset == tick time of the start of the file.
+//     velocity   == note-on attack velocity.
+//
+
+int HumdrumFileContent::getMidiEvents(std::function<void(const HumMidiEvent&)> callback,
+		int tpq, int tickoffset, int velocity) {
+	HumdrumFileContent& infile = *this;
+	if (tpq <= 0) {
+		tpq = infile.tpq();
+	}
+
+	auto getTick = [&](HumNum value) {
+		long long top = (long long)value.getNumerator() * tpq;
+		long long bot = value.getDenominator();
+		return tickoffset + (int)((top + bot / 2) / bot);
+	};
+
+	// pending note-offs, earliest first:
+	auto later = [](const HumMidiEvent& a, const HumMidiEvent& b) {
+		return a.tick > b.tick;
+	};
+	std::priority_queue<HumMidiEvent, vector<HumMidiEvent>, decltype(later)> noteoffs(later);
+
+	// Secondary notes of ties (token and subtoken index) which are
+	// already sounding from the first note of the tie:
+	std::set<pair<HTp, int>> tied;
+
+	auto flushEvents = [&](int tick) {
+		while (!noteoffs.empty() && (noteoffs.top().tick <= tick)) {
+			callback(noteoffs.top());
+			noteoffs.pop();
+		}
+	};
+
+	// Return the index of the subtoken in the token that continues a tie
+	// for the given key, or -1 if none:
+	auto findTiedNote = [&](HTp token, int key) {
+		HumSubtokenRange subtokens = token->getSubtokenViews();
+		for (auto it = subtokens.begin(); it != subtokens.end(); ++it) {
+			string_view note = *it;
+			if ((note.find('_') == string_view::npos) &&
+					(note.find(']') == string_view::npos)) {
+				continue;
+			}
+			if (Convert::kernToMidiNoteNumber(string(note)) == key) {
+				return it.getIndex();
+			}
+		}
+		return -1;
+	};
+
+	// Follow a tie from its first note to its last note, and return the
+	// end time of the last note.  Linked ties are followed with the links
+	// from analyzeKernTies(), and other ties with the next tokens in the
+	// spine (including both sides of spine splits).  The secondary notes
+	// are stored in "tied" so that they are not sounded again.
+	auto followTie = [&](HTp token, int index, int key, HumNum endtime) {
+		HTp current = token;
+		int cindex = index;
+		vector<HTp> pending;
+		while (true) {
+			string_view note = current->getSubtokenView(cindex);
+			if ((note.find('[') == string_view::npos) &&
+					(note.find('_') == string_view::npos)) {
+				break;
+			}
+			HTp next = NULL;
+			int nindex = -1;
+			string tag = "tieEnd";
+			if (current->isChord()) {
+				tag += to_string(cindex + 1);
+			}
+			HTp linked = current->getValueHTp("auto", tag);
+			if (linked) {
+				next = linked;
+				nindex = findTiedNote(linked, key);
+			} else {
+				pending.clear();
+				for (int k=0; k<current->getNextTokenCount(); k++) {
+					pending.push_back(current->getNextToken(k));
+				}
+				for (int k=0; k<(int)pending.size(); k++) {
+					HTp tok = pending[k];
+					if (!tok || (std::find(pending.begin(), pending.begin() + k, tok)
+							!= pending.begin() + k)) {
+						continue;
+					}
+					if (tok->isData() && !tok->isNull()) {
+						// The tie can only continue to the next note in
+						// the sub-spine.
+						nindex = findTiedNote(tok, key);
+						if (nindex >= 0) {
+							next = tok;
+							break;
+						}
+						continue;
+					}
+					for (int m=0; m<tok->getNextTokenCount(); m++) {
+						pending.push_back(tok->getNextToken(m));
+					}
+				}
+			}
+			if (!next || (nindex < 0)) {
+				// incomplete tie
+				break;
+			}
+			tied.emplace(next, nindex);
+			note = next->getSubtokenView(nindex);
+			endtime = next->getDurationFromStart() +
+					Convert::recipToDuration(string(note));
+			current = next;
+			cindex = nindex;
+		}
+		return endtime;
+	};
+
+	infile.analyzeKernTies();
+
+	vector<int> trackToKernIndex = infile.getTrackToKernIndex();
+	string subtoken;
+
+	for (int i=0; i<infile.getLineCount(); i++) {
+		HumdrumLine& line = infile[i];
+		if (!line.hasSpines()) {
+			continue;
+		}
+		bool interpQ = line.isInterpretation();
+		if (!(interpQ || line.isData())) {
+			continue;
+		}
+		HumNum starttime = line.getDurationFromStart();
+		int tick = getTick(starttime);
+		flushEvents(tick);
+
+		if (interpQ) {
+			for (int j=0; j<line.getFieldCount(); j++) {
+				HTp token = line.token(j);
+				if (!token->isKern()) {
+					continue;
+				}
+				if ((token->compare(0, 3, "*MM") != 0) || (token->size() < 4) ||
+						!isdigit(token->at(3))) {
+					continue;
+				}
+				HumMidiEvent event;
+				event.tick  = tick;
+				event.tempo = std::stod(token->substr(3));
+				callback(event);
+				break;
+			}
+			continue;
+		}
+
+		for (int j=0; j<line.getFieldCount(); j++) {
+			HTp token = line.token(j);
+			if (!token->isKern() || token->isNull()) {
+				continue;
+			}
+			int track = trackToKernIndex.at(token->getTrack());
+			int channel = track % 15;
+			if (channel >= 9) {
+				// skip the General MIDI percussion channel
+				channel++;
+			}
+
+			// Iterate over the notes in the token without creating
+			// a list of subtokens:
+			int sindex = 0;
+			size_t start = 0;
+			while (start <= token->size()) {
+				size_t end = token->find(' ', start);
+				if (end == string::npos) {
+					end = token->size();
+				}
+				subtoken.assign(*token, start, end - start);
+				start = end + 1;
+				int index = sindex++;
+
+				if (subtoken.find_first_of("rRqQ") != string::npos) {
+					// rests, unpitched notes and grace notes
+					continue;
+				}
+				int key = Convert::kernToMidiNoteNumber(subtoken);
+				if ((key < 0) || (key > 127)) {
+					continue;
+				}
+				HumNum duration = Convert::recipToDuration(subtoken);
+
+				if (tied.erase(make_pair(token, index))) {
+					// secondary note of a tie which is already sounding
+					continue;
+				}
+				HumNum endtime = starttime + duration;
+				if ((subtoken.find('[') != string::npos) ||
+						(subtoken.find('_') != string::npos)) {
+					// (A tie middle without a start is treated as a start
+					// of a tie, such as at the start of a segment.)
+					endtime = followTie(token, index, key, endtime);
+				}
+
+				HumMidiEvent event;
+				event.tick     = tick;
+				event.track    = track;
+				event.channel  = channel;
+				event.key      = key;
+				event.velocity = velocity;
+				event.token    = token;
+				event.subtoken = index;
+				callback(event);
+
+				event.tick     = getTick(endtime);
+				event.velocity = 0;
+				noteoffs.push(event);
+			}
+		}
+	}
+
+	int endtick = getTick(infile.getScoreDuration());
+	while (!noteoffs.empty()) {
+		callback(noteoffs.top());
+		noteoffs.pop();
+	}
+
+	return endtick;
+}
+
+
+
+
+
+//////////////////////////////
+//
+// HumdrumFileContent::analyzeNotation -- Do the same analyses as
+//    analyzeSlurs(), analyzePhrasings(), analyzeBeams(), analyzeKernTies()
+//    and analyzeKernAccidentals(), but visit each data token only once.
+//    Slur, phrase and beam analyses that were already done are skipped.
+//    The results are identical to calling the separate functions.
+//
+
+bool HumdrumFileContent::analyzeNotation(void) {
+	bool slurQ   = !m_analyses.m_slurs_analyzed;
+	bool phraseQ = !m_analyses.m_phrases_analyzed;
+	bool beamQ   = !m_analyses.m_beams_analyzed;
+	m_analyses.m_slurs_analyzed   = true;
+	m_analyses.m_phrases_analyzed = true;
+	m_analyses.m_beams_analyzed   = true;
+
+	HumdrumFileContent& infile = *this;
+	string linkSignifier = m_signifiers.getKernLinkSignifier();
+
+	vector<pair<HTp, HTp>> labels;
+	vector<int> endings;
+	if (slurQ || phraseQ || beamQ) {
+		getLabelSequence(labels, endings);
+	}
+
+	// spinetype == 1 for **kern tracks, 2 for **mens tracks, 0 otherwise.
+	int maxtrack = getMaxTrack();
+	vector<int> spinetype(maxtrack + 1, 0);
+	vector<HTp> kernspines;
+	vector<HTp> mensspines;
+	getSpineStartList(kernspines, "**kern");
+	getSpineStartList(mensspines, "**mens");
+	for (int i=0; i<(int)kernspines.size(); i++) {
+		spinetype[kernspines[i]->getTrack()] = 1;
+	}
+	for (int i=0; i<(int)mensspines.size(); i++) {
+		spinetype[mensspines[i]->getTrack()] = 2;
+	}
+
+	vector<SpanState> slurs(maxtrack + 1, SpanState('(', linkSignifier));
+	vector<SpanState> phrases(maxtrack + 1, SpanState('{', linkSignifier));
+	vector<SpanState> beams(maxtrack + 1, SpanState('L', linkSignifier));
+
+	TieState ties(linkSignifier);
+	bool tieQ = !linkSignifier.empty();
+
+	// ottava marks must be analyzed before accidentals:
+	this->analyzeOttavas();
+	AccidentalState accidentals;
+	bool accidentalQ = prepareAccidentalState(accidentals, "**kern");
+
+	vector<int> layers(maxtrack + 1, 0);
+	vector<string> subtokens;
+	for (int i=0; i<infile.getLineCount(); i++) {
+		if (!infile[i].hasSpines()) {
+			continue;
+		}
+		if (accidentalQ) {
+			if (!startAccidentalLine(infile[i], accidentals)) {
+				continue;
+			}
+		} else if (!infile[i].isData()) {
+			continue;
+		}
+		std::fill(layers.begin(), layers.end(), 0);
+
+		for (int j=0; j<infile[i].getFieldCount(); j++) {
+			HTp token = infile.token(i, j);
+			int track = token->getTrack();
+			int layer = layers[track]++;
+			int type = spinetype[track];
+			if (type == 0) {
+				continue;
+			}
+			if (token->isNull()) {
+				continue;
+			}
+
+			int slurstarts   = 0;
+			int slurends     = 0;
+			int phrasestarts = 0;
+			int phraseends   = 0;
+			int beamstarts   = 0;
+			int beamends     = 0;
+			for (int k=0; k<(int)token->size(); k++) {
+				switch (token->at(k)) {
+					case '(': slurstarts++;   break;
+					case ')': slurends++;     break;
+					case '{': phrasestarts++; break;
+					case '}': phraseends++;   break;
+					case 'L': beamstarts++;   break;
+					case 'J': beamends++;     break;
+				}
+			}
+			if (slurQ && (slurstarts || slurends)) {
+				analyzeSpanMarkers(token, layer, slurstarts, slurends, slurs[track],
+						labels, endings);
+			}
+			if (phraseQ && (type == 1) && (phrasestarts || phraseends)) {
+				analyzeSpanMarkers(token, layer, phrasestarts, phraseends, phrases[track],
+						labels, endings);
+			}
+			if (beamQ && (beamstarts || beamends)) {
+				analyzeSpanMarkers(token, layer, beamstarts, beamends, beams[track],
+						labels, endings);
+			}
+
+			if (type != 1) {
+				continue;
+			}
+			if (token->isRest()) {
+				continue;
+			}
+			if (!(tieQ || accidentalQ)) {
+				continue;
+			}
+			splitSubtokens(token, subtokens);
+			if (tieQ) {
+				analyzeKernTieToken(token, subtokens, ties);
+			}
+			if (accidentalQ) {
+				analyzeAccidentalToken(token, subtokens, accidentals);
+			}
+		}
+		if (accidentalQ) {
+			std::fill(accidentals.firstinbar.begin(), accidentals.firstinbar.end(), 0);
+		}
+	}
+
+	// Link markers in the same order as the separate analyses: unclosed
+	// markers first, then linked markers in spine order for **kern spines
+	// followed by **mens spines.
+	for (int stype=1; stype<=2; stype++) {
+		vector<HTp> slurstarts;
+		vector<HTp> slurends;
+		vector<HTp> beamstarts;
+		vector<HTp> beamends;
+		vector<HTp> phrasestarts;
+		vector<HTp> phraseends;
+		vector<HTp>& spines = (stype == 1) ? kernspines : mensspines;
+		for (int i=0; i<(int)spines.size(); i++) {
+			int track = spines[i]->getTrack();
+			if (slurQ) {
+				markHangingSpans(slurs[track]);
+				slurstarts.insert(slurstarts.end(), slurs[track].linkstarts.begin(),
+						slurs[track].linkstarts.end());
+				slurends.insert(slurends.end(), slurs[track].linkends.begin(),
+						slurs[track].linkends.end());
+			}
+			if (phraseQ && (stype == 1)) {
+				markHangingSpans(phrases[track]);
+				phrasestarts.insert(phrasestarts.end(), phrases[track].linkstarts.begin(),
+						phrases[track].linkstarts.end());
+				phraseends.insert(phraseends.end(), phrases[track].linkends.begin(),
+						phrases[track].linkends.end());
+			}
+			if (beamQ) {
+				markHangingSpans(beams[track]);
+				beamstarts.insert(beamstarts.end(), beams[track].linkstarts.begin(),
+						beams[track].linkstarts.end());
+				beamends.insert(beamends.end(), beams[track].linkends.begin(),
+						beams[track].linkends.end());
+			}
+		}
+		createLinkedSlurs(slurstarts, slurends);
+		createLinkedPhrasings(phrasestarts, phraseends);
+		createLinkedBeams(beamstarts, beamends);
+	}
+	createLinkedTies(ties.linkstarts, ties.linkends);
+
+	if (accidentalQ) {
+		infile.setValue("auto", "accidentalAnalysis**kern", "true");
+	}
+
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileContent::analyzeSpans -- Link the slur, phrase or beam
+//     markers (depending on the opener character) within each of the
+//     given spines.  The spines are independent, so they are analyzed in
+//     parallel if setAnalysisThreads() is greater than one.  Linked
+//     markers, which cross spines, are returned in spine order.
+//
+
+void HumdrumFileContent::analyzeSpans(vector<HTp>& spines, char opener,
+		vector<HTp>& linkstarts, vector<HTp>& linkends) {
+	vector<pair<HTp, HTp>> labels; // first is previous label, second is next label
+	vector<int> endings;
+	getLabelSequence(labels, endings);
+
+	string linkSignifier = m_signifiers.getKernLinkSignifier();
+	vector<SpanState> states(spines.size(), SpanState(opener, linkSignifier));
+	runParallel((int)spines.size(), [&](int index) {
+		analyzeSpineSpans(spines[index], states[index], labels, endings);
+	});
+
+	for (int i=0; i<(int)states.size(); i++) {
+		linkstarts.insert(linkstarts.end(), states[i].linkstarts.begin(),
+				states[i].linkstarts.end());
+		linkends.insert(linkends.end(), states[i].linkends.begin(),
+				states[i].linkends.end());
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileContent::analyzeSpineSpans -- Link the slur, phrase or beam
+//     markers in a single spine, and then mark unclosed starts.  Only tokens
+//     in the spine are modified.
+//
+
+void HumdrumFileContent::analyzeSpineSpans(HTp spinestart, SpanState& state,
+		vector<pair<HTp, HTp>>& labels, vector<int>& endings) {
+	// tracktokens == the 2-D data list for the track,
+	// arranged in layers with the second dimension.
+	vector<vector<HTp> > tracktokens;
+	this->getTrackSeq(tracktokens, spinestart, OPT_DATA | OPT_NOEMPTY);
+
+	HTp token;
+	for (int row=0; row<(int)tracktokens.size(); row++) {
+		for (int layer=0; layer<(int)tracktokens[row].size(); layer++) {
+			token = tracktokens[row][layer];
+			if (!token->isData()) {
+				continue;
+			}
+			if (token->isNull()) {
+				continue;
+			}
+			int opencount = (int)count(token->begin(), token->end(), state.open);
+			int closecount = (int)count(token->begin(), token->end(), state.close);
+			analyzeSpanMarkers(token, layer, opencount, closecount, state, labels, endings);
+		}
+	}
+
+	markHangingSpans(state);
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileContent::getLabelSequence -- Find the previous and next
+//     expansion label for each line, as well as the ending number that
+//     each line is in (0 if not in a numbered ending).
+//
+
+void HumdrumFileContent::getLabelSequence(vector<pair<HTp, HTp>>& labels,
+		vector<int>& endings) {
+	HumdrumFileBase& infile = *this;
+	vector<HTp> l(infile.getLineCount(), NULL);
+	labels.resize(infile.getLineCount());
+	for (int i=0; i<infile.getLineCount(); i++) {
+		labels[i].first = NULL;
+		labels[i].second = NULL;
+	}
+	for (int i=0; i<infile.getLineCount(); i++) {
+		if (!infile[i].isInterpretation()) {
+			continue;
+		}
+		HTp token = infile.token(i, 0);
+		if ((token->compare(0, 2, "*>") == 0) && (token->find("[") == std::string::npos)) {
+			l[i] = token;
+		}
+	}
+	HTp current = NULL;
+	for (int i=0; i<infile.getLineCount(); i++) {
+		if (l[i] != NULL) {
+			current = l[i];
+		}
+		labels[i].first = current;
+	}
+	current = NULL;
+	for (int i=infile.getLineCount() - 1; i>=0; i--) {
+		if (l[i] != NULL) {
+			current = l[i];
+		}
+		labels[i].second = current;
+	}
+
+	endings.resize(infile.getLineCount());
+	int ending = 0;
+	for (int i=0; i<(int)endings.size(); i++) {
+		if (l[i]) {
+			char lastchar = l[i]->back();
+			if (isdigit(lastchar)) {
+				ending = lastchar - '0';
+			} else {
+				ending = 0;
+			}
+		}
+		endings[i] = ending;
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileContent::SpanState::SpanState -- Prepare the bookkeeping for
+//     slurs (opener '('), phrases ('{') or beams ('L').
+//
+
+HumdrumFileContent::SpanState::SpanState(char opener, const string& linksig) {
+	open = opener;
+	if (opener == '(') {
+		close  = ')';
+		name   = "Slur";
+		prefix = "slur";
+	} else if (opener == '{') {
+		close  = '}';
+		name   = "Phrase";
+		prefix = "phrase";
+	} else {
+		close  = 'J';
+		name   = "Beam";
+		prefix = "beam";
+	}
+	// linked markers handled separately, so generate an ignore sequence:
+	ignorebegin = linksig + open;
+	ignoreend   = linksig + close;
+	opens.resize(4); // maximum of 4 elision levels
+	for (int i=0; i<(int)opens.size(); i++) {
+		opens[i].resize(8);  // 8 layers, expanded if necessary
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileContent::analyzeSpanMarkers -- Process the slur, phrase or
+//     beam markers on a data token (depending on the state's opener).
+//     Closing markers are processed before opening markers.  The layer
+//     is the index of the token among the tokens of its spine on the line.
+//
+
+void HumdrumFileContent::analyzeSpanMarkers(HTp token, int layer, int opencount,
+		int closecount, SpanState& state, vector<pair<HTp, HTp>>& labels,
+		vector<int>& endings) {
+	vector<vector<vector<HTp>>>& opens = state.opens;
+	int elision;
+
+	for (int i=0; i<closecount; i++) {
+		bool isLinked;
+		if (state.open == '(') {
+			isLinked = isLinkedSlurEnd(token, i, state.ignoreend);
+		} else if (state.open == '{') {
+			isLinked = isLinkedPhraseEnd(token, i, state.ignoreend);
+		} else {
+			isLinked = isLinkedBeamEnd(token, i, state.ignoreend);
+		}
+		if (isLinked) {
+			state.linkends.push_back(token);
+			continue;
+		}
+		if (state.open == '(') {
+			elision = token->getSlurEndElisionLevel(i);
+		} else if (state.open == '{') {
+			elision = token->getPhraseEndElisionLevel(i);
+		} else {
+			elision = token->getBeamEndElisionLevel(i);
+		}
+		if ((elision < 0) || (elision >= (int)opens.size())) {
+			continue;
+		}
+		if (layer >= (int)opens[elision].size()) {
+			opens[elision].resize(layer + 1);
+		}
+		if (opens[elision][layer].size() > 0) {
+			linkSpanEndpoints(opens[elision][layer].back(), token, state.open);
+			// remove opening from buffer
+			opens[elision][layer].pop_back();
+			continue;
+		}
+
+		// No starting marker to match to this end in the given layer.
+		// search for an open marker in another layer:
+		bool found = false;
+		for (int ilayer=0; ilayer<(int)opens[elision].size(); ilayer++) {
+			if (opens[elision][ilayer].size() > 0) {
+				linkSpanEndpoints(opens[elision][ilayer].back(), token, state.open);
+				// remove opening from buffer
+				opens[elision][ilayer].pop_back();
+				found = true;
+				break;
+			}
+		}
+		if (found) {
+			continue;
+		}
+
+		int lineindex = token->getLineIndex();
+		int endnum = endings[lineindex];
+		int pindex = -1;
+		if (labels[lineindex].first) {
+			pindex = labels[lineindex].first->getLineIndex();
+			pindex--;
+		}
+		int endnumpre = -1;
+		if (pindex >= 0) {
+			endnumpre = endings[pindex];
+		}
+
+		if ((endnumpre > 0) && (endnum > 0) && (endnumpre != endnum)) {
+			// This is a marker in an ending that start at the start of an ending.
+			token->setValue("auto", "ending" + state.name + "Back", "true");
+			token->setValue("auto", state.prefix + "Side", "stop");
+			token->setValue("auto", state.prefix + "Duration",
+				token->getDurationToEnd());
+		} else {
+			// This is a closing that does not have a matching opening.
+			token->setValue("auto", "hanging" + state.name, "true");
+			token->setValue("auto", state.prefix + "Side", "stop");
+			token->setValue("auto", state.prefix + "OpenIndex", to_string(i));
+			token->setValue("auto", state.prefix + "Duration",
+				token->getDurationToEnd());
+		}
+	}
+
+	for (int i=0; i<opencount; i++) {
+		bool isLinked;
+		if (state.open == '(') {
+			isLinked = isLinkedSlurBegin(token, i, state.ignorebegin);
+		} else if (state.open == '{') {
+			isLinked = isLinkedPhraseBegin(token, i, state.ignorebegin);
+		} else {
+			isLinked = isLinkedBeamBegin(token, i, state.ignorebegin);
+		}
+		if (isLinked) {
+			state.linkstarts.push_back(token);
+			continue;
+		}
+		if (state.open == '(') {
+			elision = token->getSlurStartElisionLevel(i);
+		} else if (state.open == '{') {
+			elision = token->getPhraseStartElisionLevel(i);
+		} else {
+			elision = token->getBeamStartElisionLevel(i);
+		}
+		if ((elision < 0) || (elision >= (int)opens.size())) {
+			continue;
+		}
+		if (layer >= (int)opens[elision].size()) {
+			opens[elision].resize(layer + 1);
+		}
+		opens[elision][layer].push_back(token);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileContent::markHangingSpans -- Mark slur, phrase or beam
+//     starts that were never closed.
+//
+
+void HumdrumFileContent::markHangingSpans(SpanState& state) {
+	vector<vector<vector<HTp>>>& opens = state.opens;
+	for (int i=0; i<(int)opens.size(); i++) {
+		for (int j=0; j<(int)opens[i].size(); j++) {
+			for (int k=0; k<(int)opens[i][j].size(); k++) {
+				opens[i][j][k]->setValue("", "auto", "hanging" + state.name, "true");
+				opens[i][j][k]->setValue("", "auto", state.prefix + "Side", "start");
+				opens[i][j][k]->setValue("", "auto", state.prefix + "Duration",
+						opens[i][j][k]->getDurationFromStart());
+			}
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileContent::linkSpanEndpoints -- Link the start and end of a
+//     slur, phrase or beam.
+//
+
+void HumdrumFileContent::linkSpanEndpoints(HTp start, HTp end, char opener) {
+	if (opener == '(') {
+		linkSlurEndpoints(start, end);
+	} else if (opener == '{') {
+		linkPhraseEndpoints(start, end);
+	} else {
+		linkBeamEndpoints(start, end);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileContent::splitSubtokens -- Split a token into its
+//     space-separated subtokens, equivalent to calling getSubtoken() for
+//     each index up to getSubtokenCount().
+//
+
+void HumdrumFileContent::splitSubtokens(HTp token, vector<string>& subtokens) {
+	subtokens.clear();
+	size_t start = 0;
+	size_t loc;
+	while ((loc = token->find(' ', start)) != string::npos) {
+		subtokens.emplace_back(*token, start, loc - start);
+		start = loc + 1;
+	}
+	subtokens.emplace_back(*token, start);
+}
+
+
+
+
 
 
 //////////////////////////////
@@ -27501,198 +31965,21 @@ bool HumdrumFileContent::analyzePhrasings(void) {
 bool HumdrumFileContent::analyzeKernPhrasings(void) {
 	vector<HTp> phrasestarts;
 	vector<HTp> phraseends;
-
-	vector<HTp> l;
-	vector<pair<HTp, HTp>> labels; // first is previous label, second is next label
-	HumdrumFileBase& infile = *this;
-	labels.resize(infile.getLineCount());
-	l.resize(infile.getLineCount());
-	for (int i=0; i<infile.getLineCount(); i++) {
-		labels[i].first = NULL;
-		labels[i].second = NULL;
-		l[i] = NULL;
-	}
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (!infile[i].isInterpretation()) {
-			continue;
-		}
-		HTp token = infile.token(i, 0);
-		if ((token->compare(0, 2, "*>") == 0) && (token->find("[") == std::string::npos)) {
-			l[i] = token;
-		}
-	}
-	HTp current = NULL;
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (l[i] != NULL) {
-			current = l[i];
-		}
-		labels[i].first = current;
-	}
-	current = NULL;
-	for (int i=infile.getLineCount() - 1; i>=0; i--) {
-		if (l[i] != NULL) {
-			current = l[i];
-		}
-		labels[i].second = current;
-	}
-
-	vector<int> endings(infile.getLineCount(), 0);
-	int ending = 0;
-	for (int i=0; i<(int)endings.size(); i++) {
-		if (l[i]) {
-			char lastchar = l[i]->back();
-			if (isdigit(lastchar)) {
-				ending = lastchar - '0';
-			} else {
-				ending = 0;
-			}
-		}
-		endings[i] = ending;
-	}
-
 	vector<HTp> kernspines;
 	getSpineStartList(kernspines, "**kern");
-	bool output = true;
-	string linkSignifier = m_signifiers.getKernLinkSignifier();
-	for (int i=0; i<(int)kernspines.size(); i++) {
-		output = output && analyzeKernPhrasings(kernspines[i], phrasestarts, phraseends, labels, endings, linkSignifier);
-	}
-
+	analyzeSpans(kernspines, '{', phrasestarts, phraseends);
 	createLinkedPhrasings(phrasestarts, phraseends);
-	return output;
+	return true;
 }
 
 
 bool HumdrumFileContent::analyzeKernPhrasings(HTp spinestart,
 		vector<HTp>& linkstarts, vector<HTp>& linkends, vector<pair<HTp, HTp>>& labels,
 		vector<int>& endings, const string& linksig) {
-
-	// linked phrases handled separately, so generate an ignore sequence:
-	string ignorebegin = linksig + "{";
-	string ignoreend = linksig + "}";
-
-	// tracktokens == the 2-D data list for the track,
-	// arranged in layers with the second dimension.
-	vector<vector<HTp> > tracktokens;
-	this->getTrackSeq(tracktokens, spinestart, OPT_DATA | OPT_NOEMPTY);
-	// printSequence(tracktokens);
-
-	// phraseopens == list of phrase openings for each track and elision level
-	// first dimension: elision level
-	// second dimension: track number
-	vector<vector<vector<HTp>>> phraseopens;
-
-	phraseopens.resize(4); // maximum of 4 elision levels
-	for (int i=0; i<(int)phraseopens.size(); i++) {
-		phraseopens[i].resize(8);  // maximum of 8 layers
-	}
-
-	int opencount = 0;
-	int closecount = 0;
-	int elision = 0;
-	HTp token;
-	for (int row=0; row<(int)tracktokens.size(); row++) {
-		for (int track=0; track<(int)tracktokens[row].size(); track++) {
-			token = tracktokens[row][track];
-			if (!token->isData()) {
-				continue;
-			}
-			if (token->isNull()) {
-				continue;
-			}
-			opencount = (int)count(token->begin(), token->end(), '{');
-			closecount = (int)count(token->begin(), token->end(), '}');
-
-			for (int i=0; i<closecount; i++) {
-				bool isLinked = isLinkedPhraseEnd(token, i, ignoreend);
-				if (isLinked) {
-					linkends.push_back(token);
-					continue;
-				}
-				elision = token->getPhraseEndElisionLevel(i);
-				if (elision < 0) {
-					continue;
-				}
-				if (phraseopens[elision][track].size() > 0) {
-					linkPhraseEndpoints(phraseopens[elision][track].back(), token);
-					// remove phrase opening from buffer
-					phraseopens[elision][track].pop_back();
-				} else {
-					// No starting phrase marker to match to this phrase end in the
-					// given track.
-					// search for an open phrase in another track:
-					bool found = false;
-					for (int itrack=0; itrack<(int)phraseopens[elision].size(); itrack++) {
-						if (phraseopens[elision][itrack].size() > 0) {
-							linkPhraseEndpoints(phraseopens[elision][itrack].back(), token);
-							// remove phrase opening from buffer
-							phraseopens[elision][itrack].pop_back();
-							found = true;
-							break;
-						}
-					}
-					if (!found) {
-						int lineindex = token->getLineIndex();
-						int endnum = endings[lineindex];
-						int pindex = -1;
-						if (labels[lineindex].first) {
-							pindex = labels[lineindex].first->getLineIndex();
-							pindex--;
-						}
-						int endnumpre = -1;
-						if (pindex >= 0) {
-							endnumpre = endings[pindex];
-						}
-
-						if ((endnumpre > 0) && (endnum > 0) && (endnumpre != endnum)) {
-							// This is a phrase in an ending that start at the start of an ending.
-							HumNum duration = token->getDurationFromStart();
-							if (labels[token->getLineIndex()].first) {
-								duration -= labels[token->getLineIndex()].first->getDurationFromStart();
-							}
-							token->setValue("auto", "endingPhraseBack", "true");
-							token->setValue("auto", "phraseSide", "stop");
-							token->setValue("auto", "phraseDuration",
-								token->getDurationToEnd());
-						} else {
-							// This is a phrase closing that does not have a matching opening.
-							token->setValue("auto", "hangingPhrase", "true");
-							token->setValue("auto", "phraseSide", "stop");
-							token->setValue("auto", "phraseOpenIndex", to_string(i));
-							token->setValue("auto", "phraseDuration",
-								token->getDurationToEnd());
-						}
-					}
-				}
-			}
-
-			for (int i=0; i<opencount; i++) {
-				bool isLinked = isLinkedPhraseBegin(token, i, ignorebegin);
-				if (isLinked) {
-					linkstarts.push_back(token);
-					continue;
-				}
-				elision = token->getPhraseStartElisionLevel(i);
-				if (elision < 0) {
-					continue;
-				}
-				phraseopens[elision][track].push_back(token);
-			}
-		}
-	}
-
-	// Mark un-closed phrase starts:
-	for (int i=0; i<(int)phraseopens.size(); i++) {
-		for (int j=0; j<(int)phraseopens[i].size(); j++) {
-			for (int k=0; k<(int)phraseopens[i][j].size(); k++) {
-				phraseopens[i][j][k]->setValue("", "auto", "hangingPhrase", "true");
-				phraseopens[i][j][k]->setValue("", "auto", "phraseSide", "start");
-				phraseopens[i][j][k]->setValue("", "auto", "phraseDuration",
-						phraseopens[i][j][k]->getDurationFromStart());
-			}
-		}
-	}
-
+	SpanState state('{', linksig);
+	analyzeSpineSpans(spinestart, state, labels, endings);
+	linkstarts.insert(linkstarts.end(), state.linkstarts.begin(), state.linkstarts.end());
+	linkends.insert(linkends.end(), state.linkends.begin(), state.linkends.end());
 	return true;
 }
 
@@ -28538,6 +32825,107 @@ int HumdrumFileContent::getRestPositionAboveNotes(HTp rest, vector<int>& vpos) {
 
 
 
+//////////////////////////////
+//
+// HumdrumFileContent::analyzeSlices -- Store the **kern fields of each
+//     line.  This is done automatically by the accessor functions below,
+//     and is redone after the spine structure is analyzed again, lines
+//     are inserted or deleted, or an exclusive interpretation is changed.
+//
+
+void HumdrumFileContent::analyzeSlices(void) {
+	HumdrumFileContent& infile = *this;
+	int maxtrack = infile.getMaxTrack();
+
+	vector<int> trackToKernIndex(maxtrack + 1, -1);
+	int kernindex = 0;
+	for (int track=1; track<=maxtrack; track++) {
+		if (infile.getTrackDataType(track) == datatype_kern) {
+			trackToKernIndex[track] = kernindex++;
+		}
+	}
+
+	m_kernfields.resize(infile.getLineCount());
+	m_fieldkernspine.resize(infile.getLineCount());
+	for (int i=0; i<infile.getLineCount(); i++) {
+		m_kernfields[i].clear();
+		m_fieldkernspine[i].clear();
+		if (!infile[i].hasSpines()) {
+			continue;
+		}
+		int fieldcount = infile[i].getFieldCount();
+		m_fieldkernspine[i].resize(fieldcount, -1);
+		for (int j=0; j<fieldcount; j++) {
+			int track = infile.token(i, j)->getTrack();
+			if ((track < 1) || (track > maxtrack)) {
+				continue;
+			}
+			int kernspine = trackToKernIndex[track];
+			if (kernspine < 0) {
+				continue;
+			}
+			m_kernfields[i].push_back(j);
+			m_fieldkernspine[i][j] = kernspine;
+		}
+	}
+
+	m_analyses.m_slices_analyzed = true;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileContent::getKernFieldIndexes -- Return the field indexes of
+//     the **kern tokens on a line, in left-to-right order.  Lines without
+//     spines return an empty list.
+//
+
+const vector<int>& HumdrumFileContent::getKernFieldIndexes(int line) {
+	if (!m_analyses.m_slices_analyzed) {
+		analyzeSlices();
+	}
+	return m_kernfields[line];
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileContent::getFieldToKernSpine -- Return a list with an entry
+//     for each field on the line, which is the **kern spine index of the
+//     field (its position in getKernSpineStartList()), or -1 if the field
+//     is not **kern.
+//
+
+const vector<int>& HumdrumFileContent::getFieldToKernSpine(int line) {
+	if (!m_analyses.m_slices_analyzed) {
+		analyzeSlices();
+	}
+	return m_fieldkernspine[line];
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileContent::getFieldKernSpine -- Return the **kern spine index
+//     of a field, or -1 if the field is not **kern.
+//
+
+int HumdrumFileContent::getFieldKernSpine(int line, int field) {
+	const vector<int>& kernspines = getFieldToKernSpine(line);
+	if ((field < 0) || (field >= (int)kernspines.size())) {
+		return -1;
+	}
+	return kernspines[field];
+}
+
+
+
+
+
+
 //////////////////////////////
 //
 // HumdrumFileContent::analyzeSlurs -- Link start and ends of
@@ -28567,64 +32955,11 @@ bool HumdrumFileContent::analyzeSlurs(void) {
 bool HumdrumFileContent::analyzeMensSlurs(void) {
 	vector<HTp> slurstarts;
 	vector<HTp> slurends;
-
-	vector<HTp> l;
-	vector<pair<HTp, HTp>> labels; // first is previous label, second is next label
-	HumdrumFileBase& infile = *this;
-	labels.resize(infile.getLineCount());
-	l.resize(infile.getLineCount());
-	for (int i=0; i<infile.getLineCount(); i++) {
-		labels[i].first = NULL;
-		labels[i].second = NULL;
-		l[i] = NULL;
-	}
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (!infile[i].isInterpretation()) {
-			continue;
-		}
-		HTp token = infile.token(i, 0);
-		if ((token->compare(0, 2, "*>") == 0) && (token->find("[") == std::string::npos)) {
-			l[i] = token;
-		}
-	}
-	HTp current = NULL;
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (l[i] != NULL) {
-			current = l[i];
-		}
-		labels[i].first = current;
-	}
-	current = NULL;
-	for (int i=infile.getLineCount() - 1; i>=0; i--) {
-		if (l[i] != NULL) {
-			current = l[i];
-		}
-		labels[i].second = current;
-	}
-
-	vector<int> endings(infile.getLineCount(), 0);
-	int ending = 0;
-	for (int i=0; i<(int)endings.size(); i++) {
-		if (l[i]) {
-			char lastchar = l[i]->back();
-			if (isdigit(lastchar)) {
-				ending = lastchar - '0';
-			} else {
-				ending = 0;
-			}
-		}
-		endings[i] = ending;
-	}
-
 	vector<HTp> mensspines;
 	getSpineStartList(mensspines, "**mens");
-	bool output = true;
-	string linkSignifier = m_signifiers.getKernLinkSignifier();
-	for (int i=0; i<(int)mensspines.size(); i++) {
-		output = output && analyzeKernSlurs(mensspines[i], slurstarts, slurends, labels, endings, linkSignifier);
-	}
+	analyzeSpans(mensspines, '(', slurstarts, slurends);
 	createLinkedSlurs(slurstarts, slurends);
-	return output;
+	return true;
 }
 
 
@@ -28638,198 +32973,21 @@ bool HumdrumFileContent::analyzeMensSlurs(void) {
 bool HumdrumFileContent::analyzeKernSlurs(void) {
 	vector<HTp> slurstarts;
 	vector<HTp> slurends;
-
-	vector<HTp> l;
-	vector<pair<HTp, HTp>> labels; // first is previous label, second is next label
-	HumdrumFileBase& infile = *this;
-	labels.resize(infile.getLineCount());
-	l.resize(infile.getLineCount());
-	for (int i=0; i<infile.getLineCount(); i++) {
-		labels[i].first = NULL;
-		labels[i].second = NULL;
-		l[i] = NULL;
-	}
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (!infile[i].isInterpretation()) {
-			continue;
-		}
-		HTp token = infile.token(i, 0);
-		if ((token->compare(0, 2, "*>") == 0) && (token->find("[") == std::string::npos)) {
-			l[i] = token;
-		}
-	}
-	HTp current = NULL;
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (l[i] != NULL) {
-			current = l[i];
-		}
-		labels[i].first = current;
-	}
-	current = NULL;
-	for (int i=infile.getLineCount() - 1; i>=0; i--) {
-		if (l[i] != NULL) {
-			current = l[i];
-		}
-		labels[i].second = current;
-	}
-
-	vector<int> endings(infile.getLineCount(), 0);
-	int ending = 0;
-	for (int i=0; i<(int)endings.size(); i++) {
-		if (l[i]) {
-			char lastchar = l[i]->back();
-			if (isdigit(lastchar)) {
-				ending = lastchar - '0';
-			} else {
-				ending = 0;
-			}
-		}
-		endings[i] = ending;
-	}
-
 	vector<HTp> kernspines;
 	getSpineStartList(kernspines, "**kern");
-	bool output = true;
-	string linkSignifier = m_signifiers.getKernLinkSignifier();
-	for (int i=0; i<(int)kernspines.size(); i++) {
-		output = output && analyzeKernSlurs(kernspines[i], slurstarts, slurends, labels, endings, linkSignifier);
-	}
-
+	analyzeSpans(kernspines, '(', slurstarts, slurends);
 	createLinkedSlurs(slurstarts, slurends);
-	return output;
+	return true;
 }
 
 
 bool HumdrumFileContent::analyzeKernSlurs(HTp spinestart,
 		vector<HTp>& linkstarts, vector<HTp>& linkends, vector<pair<HTp, HTp>>& labels,
 		vector<int>& endings, const string& linksig) {
-
-	// linked slurs handled separately, so generate an ignore sequence:
-	string ignorebegin = linksig + "(";
-	string ignoreend = linksig + ")";
-
-	// tracktokens == the 2-D data list for the track,
-	// arranged in layers with the second dimension.
-	vector<vector<HTp> > tracktokens;
-	this->getTrackSeq(tracktokens, spinestart, OPT_DATA | OPT_NOEMPTY);
-	// printSequence(tracktokens);
-
-	// sluropens == list of slur openings for each track and elision level
-	// first dimension: elision level
-	// second dimension: track number
-	vector<vector<vector<HTp>>> sluropens;
-
-	sluropens.resize(4); // maximum of 4 elision levels
-	for (int i=0; i<(int)sluropens.size(); i++) {
-		sluropens[i].resize(8);  // maximum of 8 layers
-	}
-
-	int opencount = 0;
-	int closecount = 0;
-	int elision = 0;
-	HTp token;
-	for (int row=0; row<(int)tracktokens.size(); row++) {
-		for (int track=0; track<(int)tracktokens[row].size(); track++) {
-			token = tracktokens[row][track];
-			if (!token->isData()) {
-				continue;
-			}
-			if (token->isNull()) {
-				continue;
-			}
-			opencount = (int)count(token->begin(), token->end(), '(');
-			closecount = (int)count(token->begin(), token->end(), ')');
-
-			for (int i=0; i<closecount; i++) {
-				bool isLinked = isLinkedSlurEnd(token, i, ignoreend);
-				if (isLinked) {
-					linkends.push_back(token);
-					continue;
-				}
-				elision = token->getSlurEndElisionLevel(i);
-				if (elision < 0) {
-					continue;
-				}
-				if (sluropens[elision][track].size() > 0) {
-					linkSlurEndpoints(sluropens[elision][track].back(), token);
-					// remove slur opening from buffer
-					sluropens[elision][track].pop_back();
-				} else {
-					// No starting slur marker to match to this slur end in the
-					// given track.
-					// search for an open slur in another track:
-					bool found = false;
-					for (int itrack=0; itrack<(int)sluropens[elision].size(); itrack++) {
-						if (sluropens[elision][itrack].size() > 0) {
-							linkSlurEndpoints(sluropens[elision][itrack].back(), token);
-							// remove slur opening from buffer
-							sluropens[elision][itrack].pop_back();
-							found = true;
-							break;
-						}
-					}
-					if (!found) {
-						int lineindex = token->getLineIndex();
-						int endnum = endings[lineindex];
-						int pindex = -1;
-						if (labels[lineindex].first) {
-							pindex = labels[lineindex].first->getLineIndex();
-							pindex--;
-						}
-						int endnumpre = -1;
-						if (pindex >= 0) {
-							endnumpre = endings[pindex];
-						}
-
-						if ((endnumpre > 0) && (endnum > 0) && (endnumpre != endnum)) {
-							// This is a slur in an ending that start at the start of an ending.
-							HumNum duration = token->getDurationFromStart();
-							if (labels[token->getLineIndex()].first) {
-								duration -= labels[token->getLineIndex()].first->getDurationFromStart();
-							}
-							token->setValue("auto", "endingSlurBack", "true");
-							token->setValue("auto", "slurSide", "stop");
-							token->setValue("auto", "slurDuration",
-								token->getDurationToEnd());
-						} else {
-							// This is a slur closing that does not have a matching opening.
-							token->setValue("auto", "hangingSlur", "true");
-							token->setValue("auto", "slurSide", "stop");
-							token->setValue("auto", "slurOpenIndex", to_string(i));
-							token->setValue("auto", "slurDuration",
-								token->getDurationToEnd());
-						}
-					}
-				}
-			}
-
-			for (int i=0; i<opencount; i++) {
-				bool isLinked = isLinkedSlurBegin(token, i, ignorebegin);
-				if (isLinked) {
-					linkstarts.push_back(token);
-					continue;
-				}
-				elision = token->getSlurStartElisionLevel(i);
-				if (elision < 0) {
-					continue;
-				}
-				sluropens[elision][track].push_back(token);
-			}
-		}
-	}
-
-	// Mark un-closed slur starts:
-	for (int i=0; i<(int)sluropens.size(); i++) {
-		for (int j=0; j<(int)sluropens[i].size(); j++) {
-			for (int k=0; k<(int)sluropens[i][j].size(); k++) {
-				sluropens[i][j][k]->setValue("", "auto", "hangingSlur", "true");
-				sluropens[i][j][k]->setValue("", "auto", "slurSide", "start");
-				sluropens[i][j][k]->setValue("", "auto", "slurDuration",
-						sluropens[i][j][k]->getDurationFromStart());
-			}
-		}
-	}
-
+	SpanState state('(', linksig);
+	analyzeSpineSpans(spinestart, state, labels, endings);
+	linkstarts.insert(linkstarts.end(), state.linkstarts.begin(), state.linkstarts.end());
+	linkends.insert(linkends.end(), state.linkends.begin(), state.linkends.end());
 	return true;
 }
 
@@ -28984,13 +33142,19 @@ bool HumdrumFileContent::analyzeKernStemLengths(void) {
 
 	vector<vector<int>> centerlines;
 	getBaselines(centerlines);
-	for (int i=0; i<scount; i++) {
-		HTp sstart = this->getStrandStart(i);
+
+	// Each strand is independent, so they can be done in parallel:
+	vector<int> results(scount, 1);
+	runParallel(scount, [&](int index) {
+		HTp sstart = this->getStrandStart(index);
 		if (!sstart->isKern()) {
-			continue;
+			return;
 		}
-		HTp send = this->getStrandEnd(i);
-		output = output && analyzeKernStemLengths(sstart, send, centerlines);
+		HTp send = this->getStrandEnd(index);
+		results[index] = analyzeKernStemLengths(sstart, send, centerlines);
+	});
+	for (int i=0; i<scount; i++) {
+		output = output && results[i];
 	}
 	return output;
 }
@@ -29228,16 +33392,8 @@ bool HumdrumFileContent::analyzeKernTies(
 		return true;
 	}
 
-	string lstart  = linkSignifier + "[";
-	string lmiddle = linkSignifier + "_";
-	string lend    = linkSignifier + "]";
-
-	vector<pair<HTp, int>> startdatabase(400);
-
-	for (int i=0; i<(int)startdatabase.size(); i++) {
-		startdatabase[i].first  = NULL;
-		startdatabase[i].second = -1;
-	}
+	TieState state(linkSignifier);
+	vector<string> subtokens;
 
 	HumdrumFileContent& infile = *this;
 	for (int i=0; i<infile.getLineCount(); i++) {
@@ -29258,49 +33414,84 @@ bool HumdrumFileContent::analyzeKernTies(
 			if (tok->isRest()) {
 				continue;
 			}
-			int scount = tok->getSubtokenCount();
-			int b40;
-			for (int k=0; k<scount; k++) {
-				int index = k;
-				if (scount == 1) {
-					index = -1;
-				}
-				std::string tstring = tok->getSubtoken(k);
-				if (tstring.find(lstart) != std::string::npos) {
-					b40 = Convert::kernToBase40(tstring);
-					startdatabase[b40].first  = tok;
-					startdatabase[b40].second = index;
-					// linkedtiestarts.push_back(std::make_pair(tok, index));
-				}
-				if (tstring.find(lend) != std::string::npos) {
-					b40 = Convert::kernToBase40(tstring);
-					if (startdatabase.at(b40).first) {
-						linkedtiestarts.push_back(startdatabase[b40]);
-						linkedtieends.push_back(std::make_pair(tok, index));
-						startdatabase[b40].first  = NULL;
-						startdatabase[b40].second = -1;
-					}
-				}
-				if (tstring.find(lmiddle) != std::string::npos) {
-					b40 = Convert::kernToBase40(tstring);
-					if (startdatabase[b40].first) {
-						linkedtiestarts.push_back(startdatabase[b40]);
-						linkedtieends.push_back(std::make_pair(tok, index));
-					}
-					startdatabase[b40].first  = tok;
-					startdatabase[b40].second = index;
-					// linkedtiestarts.push_back(std::make_pair(tok, index));
-					// linkedtieends.push_back(std::make_pair(tok, index));
-				}
-			}
+			splitSubtokens(tok, subtokens);
+			analyzeKernTieToken(tok, subtokens, state);
 		}
 	}
 
+	linkedtiestarts.insert(linkedtiestarts.end(), state.linkstarts.begin(),
+			state.linkstarts.end());
+	linkedtieends.insert(linkedtieends.end(), state.linkends.begin(),
+			state.linkends.end());
 	return true;
 }
 
 
 
+//////////////////////////////
+//
+// HumdrumFileContent::TieState::TieState -- Prepare the bookkeeping for
+//     linked ties.
+//
+
+HumdrumFileContent::TieState::TieState(const string& linksig) {
+	lstart  = linksig + "[";
+	lmiddle = linksig + "_";
+	lend    = linksig + "]";
+	startdatabase.resize(400);
+	for (int i=0; i<(int)startdatabase.size(); i++) {
+		startdatabase[i].first  = NULL;
+		startdatabase[i].second = -1;
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileContent::analyzeKernTieToken -- Check the subtokens of a
+//     **kern note for linked tie markers.
+//
+
+void HumdrumFileContent::analyzeKernTieToken(HTp tok, const vector<string>& subtokens,
+		TieState& state) {
+	vector<pair<HTp, int>>& startdatabase = state.startdatabase;
+	int scount = (int)subtokens.size();
+	int b40;
+	for (int k=0; k<scount; k++) {
+		int index = k;
+		if (scount == 1) {
+			index = -1;
+		}
+		const std::string& tstring = subtokens[k];
+		if (tstring.find(state.lstart) != std::string::npos) {
+			b40 = Convert::kernToBase40(tstring);
+			startdatabase[b40].first  = tok;
+			startdatabase[b40].second = index;
+		}
+		if (tstring.find(state.lend) != std::string::npos) {
+			b40 = Convert::kernToBase40(tstring);
+			if (startdatabase.at(b40).first) {
+				state.linkstarts.push_back(startdatabase[b40]);
+				state.linkends.push_back(std::make_pair(tok, index));
+				startdatabase[b40].first  = NULL;
+				startdatabase[b40].second = -1;
+			}
+		}
+		if (tstring.find(state.lmiddle) != std::string::npos) {
+			b40 = Convert::kernToBase40(tstring);
+			if (startdatabase[b40].first) {
+				state.linkstarts.push_back(startdatabase[b40]);
+				state.linkends.push_back(std::make_pair(tok, index));
+			}
+			startdatabase[b40].first  = tok;
+			startdatabase[b40].second = index;
+		}
+	}
+}
+
+
+
 //////////////////////////////
 //
 // HumdrumFileContent::createLinkedTies --
@@ -29796,9 +33987,7 @@ int HumdrumFileSet::read(HumdrumFileStream& instream) {
 int HumdrumFileSet::readAppendFile(const string& filename) {
 	ifstream indata;
 	indata.open(filename);
-	string contents((istreambuf_iterator<char>(indata)), istreambuf_iterator<char>());
-	HumdrumFileStream instream(contents);
-	return readAppend(instream);
+	return readAppend(indata);
 }
 
 
@@ -29814,8 +34003,9 @@ int HumdrumFileSet::readAppendStringCsv(const string& contents) {
 
 
 int HumdrumFileSet::readAppend(istream& inStream) {
-	string contents((istreambuf_iterator<char>(inStream)), istreambuf_iterator<char>());
-	HumdrumFileStream instream(contents);
+	// Read the segments directly from the stream rather than from a
+	// copy of its entire contents.
+	HumdrumFileStream instream(inStream);
 	return readAppend(instream);
 }
 
@@ -29997,6 +34187,22 @@ HumdrumFileStream::HumdrumFileStream(const string& datastring) {
 	m_stringbuffer << datastring;
 }
 
+HumdrumFileStream::HumdrumFileStream(istream& input) {
+	m_curfile = -1;
+	m_input = &input;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStream::~HumdrumFileStream --
+//
+
+HumdrumFileStream::~HumdrumFileStream() {
+	waitForPrefetch();
+}
+
 
 
 //////////////////////////////
@@ -30005,9 +34211,12 @@ HumdrumFileStream::HumdrumFileStream(const string& datastring) {
 //
 
 void HumdrumFileStream::clear(void) {
+	waitForPrefetch();
+	m_prefetchstatus = -1;
 	m_curfile = 0;
+	m_input = NULL;
 	m_filelist.resize(0);
-	m_universals.resize(0);
+	m_universals.clear();
 	m_newfilebuffer.resize(0);
 	// m_stringbuffer.clear(0);
 	m_stringbuffer.str("");
@@ -30021,6 +34230,7 @@ void HumdrumFileStream::clear(void) {
 //
 
 int HumdrumFileStream::setFileList(char** list) {
+	waitForPrefetch();
 	m_filelist.reserve(1000);
 	m_filelist.resize(0);
 	int i = 0;
@@ -30033,6 +34243,7 @@ int HumdrumFileStream::setFileList(char** list) {
 
 
 int HumdrumFileStream::setFileList(const vector<string>& list) {
+	waitForPrefetch();
 	m_filelist = list;
 	return (int)list.size();
 }
@@ -30045,12 +34256,45 @@ int HumdrumFileStream::setFileList(const vector<string>& list) {
 //
 
 void HumdrumFileStream::loadString(const string& data) {
+	waitForPrefetch();
 	m_curfile = -1;
 	m_stringbuffer << data;
 }
 
 
 
+//////////////////////////////
+//
+// HumdrumFileStream::setPrefetch -- Read the text of the next segment in
+//    a separate thread while the current segment is being parsed and
+//    processed.  At most one segment is read ahead, so the memory usage
+//    is still limited to that of two segments, regardless of the size
+//    of the input stream.
+//
+
+void HumdrumFileStream::setPrefetch(bool state) {
+	m_prefetchQ = state;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStream::waitForPrefetch -- Wait for the read-ahead thread to
+//    finish.  Returns -1 if no segment has been read ahead, 0 if the
+//    end of the input was reached, or 1 if the text of a segment is
+//    waiting in m_prefetchtext.
+//
+
+int HumdrumFileStream::waitForPrefetch(void) {
+	if (m_prefetch.valid()) {
+		m_prefetchstatus = m_prefetch.get();
+	}
+	return m_prefetchstatus;
+}
+
+
+
 //////////////////////////////
 //
 // HumdrumFileStream::read -- alias for getFile.
@@ -30093,6 +34337,29 @@ int HumdrumFileStream::readSingleSegment(HumdrumFileSet& infiles) {
 
 
 
+//////////////////////////////
+//
+// HumdrumFileStream::readSegments -- Get up to the given number of files
+//     for a set structure, so that several segments can be processed
+//     together while only a limited number of them are kept in memory.
+//     Returns the number of files read.
+//
+
+int HumdrumFileStream::readSegments(HumdrumFileSet& infiles, int count) {
+	infiles.clear();
+	for (int i=0; i<count; i++) {
+		HumdrumFile* infile = new HumdrumFile;
+		if (!getFile(*infile)) {
+			delete infile;
+			break;
+		}
+		infiles.appendHumdrumPointer(infile);
+	}
+	return infiles.getCount();
+}
+
+
+
 //////////////////////////////
 //
 // HumdrumFileStream::eof -- returns true if there is no more segements
@@ -30100,6 +34367,9 @@ int HumdrumFileStream::readSingleSegment(HumdrumFileSet& infiles) {
 //
 
 int HumdrumFileStream::eof(void) {
+	if (waitForPrefetch() > 0) {
+		return 0;
+	}
 	istream* newinput = NULL;
 
 	// Read HumdrumFile contents from:
@@ -30112,6 +34382,11 @@ int HumdrumFileStream::eof(void) {
 		return 0;
 	}
 
+	// (1a) Is there more to read from the given istream?
+	else if ((m_input != NULL) && m_input->good()) {
+		return 0;
+	}
+
 	// (1b) Is the URL data buffer open?
 	else if (m_urlbuffer.str() != "") {
 		return 0;
@@ -30147,11 +34422,71 @@ int HumdrumFileStream::eof(void) {
 //
 
 int HumdrumFileStream::getFile(HumdrumFile& infile) {
+	stringstream contents;
+	if (!getFileText(infile, contents)) {
+		return 0;
+	}
+	parseFileText(infile, contents);
+	return 1;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStream::getFileText -- Same as getFile(), but only read the
+//    text of the next HumdrumFile into contents without parsing it.  The
+//    filename and segment level are stored in infile.  Use parseFileText()
+//    to finish reading the file, which can be done in a separate thread
+//    since it does not access the stream.
+//
+
+int HumdrumFileStream::getFileText(HumdrumFile& infile, stringstream& contents) {
+	if (!m_prefetchQ && !m_prefetch.valid() && (m_prefetchstatus < 0)) {
+		return readFileText(infile, contents);
+	}
+
+	if (waitForPrefetch() < 0) {
+		m_prefetchstatus = readFileText(m_prefetchfile, m_prefetchtext);
+	}
+	int status = m_prefetchstatus;
+	m_prefetchstatus = -1;
+
+	infile.clear();
+	infile.setFilename(m_prefetchfile.getFilename());
+	infile.setSegmentLevel(m_prefetchfile.getSegmentLevel());
+	if (!status) {
+		return 0;
+	}
+	contents.swap(m_prefetchtext);
+
+	if (m_prefetchQ) {
+		m_prefetch = std::async(std::launch::async, [this]() {
+			return readFileText(m_prefetchfile, m_prefetchtext);
+		});
+	}
+	return 1;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStream::readFileText -- Read the text of the next segment
+//    from the input for getFileText().  The data lines are written
+//    directly into contents after the universal comments, so only one
+//    copy of the segment is kept in memory.
+//
+
+int HumdrumFileStream::readFileText(HumdrumFile& infile, stringstream& contents) {
 	infile.clear();
 	istream* newinput = NULL;
 
 restarting:
 
+	contents.str(""); // empty any contents in buffer
+	contents.clear(); // reset error flags in buffer
+
 	stringstream buffer;
 	string templine;
 	if (!m_newfilebuffer.empty()) {
@@ -30172,11 +34507,18 @@ restarting:
 	// (3) Next filename if ifstream is done
 	// (4) cin if no ifstream open and no filenames
 
-	// (1) Is there content in the string buffer?
-	if (!m_stringbuffer.str().empty()) {
+	// (1) Is there content in the string buffer?  (Check the size of
+	// the buffer without copying it as str() does.)
+	if (m_stringbuffer.rdbuf()->pubseekoff(0, std::ios::cur, std::ios::out) > 0) {
 		newinput = &m_stringbuffer;
 	}
 
+	// (1a) Is there a given istream?  (Like the string buffer, it is the
+	// only input source.)
+	else if (m_input != NULL) {
+		newinput = m_input;
+	}
+
 	// (2) Is an ifstream open?
 	else if (m_instream.is_open() && !m_instream.eof()) {
 		newinput = &m_instream;
@@ -30204,6 +34546,11 @@ restarting:
 			infile.setFilename(m_filelist[m_curfile]);
 			goto restarting;
 		}
+		if (m_readbuffer.empty()) {
+			// Use a fixed-size read-ahead buffer (set before opening).
+			m_readbuffer.resize(1 << 16);
+			m_instream.rdbuf()->pubsetbuf(m_readbuffer.data(), m_readbuffer.size());
+		}
 		m_instream.open(m_filelist[m_curfile]);
 		infile.setFilename(m_filelist[m_curfile]);
 		if (!m_instream.is_open()) {
@@ -30267,7 +34614,7 @@ restarting:
 		//searchName = 1;
 	}
 
-	if (newinput->eof()) {
+	if (!newinput->good()) {
 		if (m_curfile < (int)m_filelist.size()-1) {
 			m_curfile++;
 			goto restarting;
@@ -30286,12 +34633,12 @@ restarting:
 		starstarFoundQ = 1;
 	}
 
-	while (!input.eof()) {
+	while (input.good()) {
 		getline(input, templine);
 		if (templine.compare(0, strlen("!!!!SEGMENT"), "!!!!SEGMENT") == 0) {
 			// Store the current segment line in the buffer before breaking.
-			if (!buffer.str().empty()) {
-				m_newfilebuffer = templine;
+			if (dataFoundQ || (buffer.tellp() > 0)) {
+				m_newfilebuffer.swap(templine);
 				break;
 			}
 			m_newfilebuffer = templine;
@@ -30299,7 +34646,7 @@ restarting:
 
 		if (templine.compare(0, 2, "**") == 0) {
 			if (starstarFoundQ == 1) {
-				m_newfilebuffer = templine;
+				m_newfilebuffer.swap(templine);
 				// already found a **, so this one is defined as a file
 				// segment.  Exit from the loop and process the previous
 				// content, waiting until the next read to start with
@@ -30326,17 +34673,15 @@ restarting:
 			// This is a universal comment.  Should it be appended
 			// to the list or should the current list be erased and
 			// this record placed into the first entry?
-			if (foundUniversalQ) {
-				// already found a previous universal, so append.
-				m_universals.push_back(templine);
-			} else {
+			if (!foundUniversalQ) {
 				// new universal comment, to delete all previous
 				// universal comments and store this one.
-				m_universals.reserve(1000);
-				m_universals.resize(1);
-				m_universals[0] = templine;
+				m_universals.clear();
 				foundUniversalQ = 1;
 			}
+			// Store as a global comment:
+			m_universals.append(templine, 1, string::npos);
+			m_universals += '\n';
 			continue;
 		}
 
@@ -30360,10 +34705,19 @@ restarting:
 			}
 		}
 
-		dataFoundQ = 1; // found something other than universal comments
+		if (!dataFoundQ) {
+			// found something other than universal comments, so the
+			// universal comments for this segment are complete.
+			// Prepend them (demoted into global comments) at the start
+			// of the data stream (maybe allow for postpending Universal
+			// comments in the future).
+			contents << m_universals << buffer.rdbuf();
+			contents.clear();
+			dataFoundQ = 1;
+		}
 
 		// store the data line for later parsing into HumdrumFile record:
-		buffer << templine << "\n";
+		contents << templine << "\n";
 	}
 
 /*
@@ -30377,23 +34731,24 @@ restarting:
 */
 
 	// Arriving here means that reading of the data stream is complete.
-	// The string stream variable "buffer" contains the HumdrumFile
-	// content, so send it to the HumdrumFile variable.  Also, prepend
-	// Universal comments (demoted into Global comments) at the start
-	// of the data stream (maybe allow for postpending Universal comments
-	// in the future).
-	stringstream contents;
-	contents.str(""); // empty any contents in buffer
-	contents.clear(); // reset error flags in buffer
-
-	for (int i=0; i < (int)m_universals.size(); i++) {
-		if (m_universals[i].compare(0, 11, "!!!!filter:") == 0) {
-			continue;
-		}
-		contents << &(m_universals[i][1]) << "\n";
+	// The string stream variable "contents" contains the HumdrumFile
+	// content, unless only universal comments were found.
+	if (!dataFoundQ) {
+		contents << m_universals << buffer.rdbuf();
+		contents.clear();
 	}
+	return 1;
+}
+
+
 
-	contents << buffer.str();
+//////////////////////////////
+//
+// HumdrumFileStream::parseFileText -- Parse the text read by getFileText()
+//    into the HumdrumFile.
+//
+
+void HumdrumFileStream::parseFileText(HumdrumFile& infile, stringstream& contents) {
 	string oldfilename = infile.getFilename();
 	infile.readNoRhythm(contents);
 	string newfilename = infile.getFilename();
@@ -30401,8 +34756,6 @@ restarting:
 		infile.setFilename(oldfilename);
 	}
 	infile.setFilenameFromSegment();
-
-	return 1;
 }
 
 
@@ -30980,20 +35333,20 @@ bool HumdrumFileStructure::readNoRhythm(const string& filename) {
 //
 
 bool HumdrumFileStructure::readNoRhythmCsv(istream& infile,
-		const string& seperator) {
-	return HumdrumFileBase::readCsv(infile);
+		const string& separator) {
+	return HumdrumFileBase::readCsv(infile, separator);
 }
 
 
 bool HumdrumFileStructure::readNoRhythmCsv(const char* filename,
-		const string& seperator) {
-	return HumdrumFileBase::readCsv(filename);
+		const string& separator) {
+	return HumdrumFileBase::readCsv(filename, separator);
 }
 
 
 bool HumdrumFileStructure::readNoRhythmCsv(const string& filename,
-		const string& seperator) {
-	return HumdrumFileBase::readCsv(filename);
+		const string& separator) {
+	return HumdrumFileBase::readCsv(filename, separator);
 }
 
 
@@ -31026,13 +35379,13 @@ bool HumdrumFileStructure::readStringNoRhythm(const string& contents) {
 
 bool HumdrumFileStructure::readStringNoRhythmCsv(const char* contents,
 		const string& separator) {
-	return HumdrumFileBase::readStringCsv(contents);
+	return HumdrumFileBase::readStringCsv(contents, separator);
 }
 
 
 bool HumdrumFileStructure::readStringNoRhythmCsv(const string& contents,
 		const string& separator) {
-	return HumdrumFileBase::readStringCsv(contents);
+	return HumdrumFileBase::readStringCsv(contents, separator);
 }
 
 
@@ -31257,6 +35610,7 @@ bool HumdrumFileStructure::analyzeRhythm(void) {
 	HumNum zero(0);
 
 	int i;
+	vector<int> tracks;
 	for (int i=1; i<=getMaxTrack(); i++) {
 		if (!getTrackStart(i)->hasRhythm()) {
 			// Can't analyze rhythm of spines that do not have rhythm.
@@ -31264,9 +35618,7 @@ bool HumdrumFileStructure::analyzeRhythm(void) {
 		}
 		testline = getTrackStart(i)->getLineIndex();
 		if (testline == startline) {
-			if (!assignDurationsToTrack(getTrackStart(i), zero)) {
-				return false;
-			}
+			tracks.push_back(i);
 		} else {
 			// Spine does not start at beginning of data, so
 			// the starting position of the spine has to be
@@ -31277,6 +35629,30 @@ bool HumdrumFileStructure::analyzeRhythm(void) {
 		}
 	}
 
+	// Use integer timestamps while walking the spines if possible:
+	prepareRhythmTicks();
+
+	if ((getAnalysisThreads() > 1) && (tracks.size() > 1) && !hasCrossTrackMerges()) {
+		// Walk the tracks in parallel, then set the line durations in
+		// track order so that results (and rhythm errors) are the same
+		// as for a serial analysis.
+		bool status;
+		if (m_rhythmtpq > 0) {
+			status = assignDurationsInParallel(tracks, (int64_t)0);
+		} else {
+			status = assignDurationsInParallel(tracks, zero);
+		}
+		if (!status) {
+			return false;
+		}
+	} else {
+		for (i=0; i<(int)tracks.size(); i++) {
+			if (!assignDurationsToTrack(getTrackStart(tracks[i]), zero)) {
+				return false;
+			}
+		}
+	}
+
 	// Go back and analyze spines that do not start at the
 	// beginning of the data stream.
 	for (i=1; i<=getMaxTrack(); i++) {
@@ -31289,6 +35665,8 @@ bool HumdrumFileStructure::analyzeRhythm(void) {
 			if (!analyzeRhythmOfFloatingSpine(getTrackStart(i))) { return false; }
 		}
 	}
+	m_rhythmtpq = 0;
+	m_lineticks.clear();
 
 	if (!analyzeNullLineRhythms()) { return false; }
 	fillInNegativeStartTimes();
@@ -31314,6 +35692,7 @@ bool HumdrumFileStructure::analyzeRhythm(void) {
 bool HumdrumFileStructure::analyzeMeter(void) {
 
 	m_barlines.resize(0);
+	m_analyses.m_metric_analyzed = false;
 
 	int i;
 	HumNum sum = 0;
@@ -31657,6 +36036,11 @@ bool HumdrumFileStructure::assignDurationsToTrack(HTp starttoken,
 		return isValid();
 	}
 	int state = starttoken->getState();
+	int64_t startticks;
+	if ((m_rhythmtpq > 0) && HumNum64(startdur).getTicks(m_rhythmtpq, startticks)) {
+		prepareDurations(starttoken, state, startticks);
+		return isValid();
+	}
 	if (!prepareDurations(starttoken, state, startdur)) {
 		return isValid();
 	}
@@ -31665,30 +36049,62 @@ bool HumdrumFileStructure::assignDurationsToTrack(HTp starttoken,
 
 
 
+//////////////////////////////
+//
+// HumdrumFileStructure::assignDurationsInParallel -- Assign durations to
+//    tracks in separate threads, then set the line durations in track
+//    order so that results (and rhythm errors) are the same as for a
+//    serial analysis.  The tracks cannot be linked by merges.
+//
+
+template <class DURTYPE>
+bool HumdrumFileStructure::assignDurationsInParallel(vector<int>& tracks,
+		DURTYPE startdur) {
+	vector<vector<pair<HTp, DURTYPE>>> linedurs(tracks.size());
+	runParallel((int)tracks.size(), [&](int index) {
+		HTp starttoken = getTrackStart(tracks[index]);
+		prepareDurations(starttoken, starttoken->getState(), startdur, &linedurs[index]);
+	});
+	for (int i=0; i<(int)linedurs.size(); i++) {
+		for (int j=0; j<(int)linedurs[i].size(); j++) {
+			if (!setLineDurationFromStart(linedurs[i][j].first, linedurs[i][j].second)) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+
+
 //////////////////////////////
 //
 // HumdrumFileStructure::prepareDurations -- Helper function for
 //     HumdrumFileStructure::assignDurationsToTrack() which does all of the
-//     work for assigning durationFromStart values.
+//     work for assigning durationFromStart values.  DURTYPE is either
+//     HumNum or int64_t ticks (see prepareRhythmTicks()).
 //
 
+template <class DURTYPE>
 bool HumdrumFileStructure::prepareDurations(HTp token, int state,
-		HumNum startdur) {
+		DURTYPE startdur, vector<pair<HTp, DURTYPE>>* linedurs) {
 	if (state != token->getState()) {
 		return isValid();
 	}
 
-	HumNum dursum = startdur;
+	DURTYPE dursum = startdur;
 	token->incrementState();
 
-	if (!setLineDurationFromStart(token, dursum)) { return isValid(); }
-	if (token->getDuration().isPositive()) {
-		dursum += token->getDuration();
+	if (linedurs) {
+		linedurs->emplace_back(token, dursum);
+	} else if (!setLineDurationFromStart(token, dursum)) {
+		return isValid();
 	}
+	addTokenDuration(dursum, token);
 	int tcount = token->getNextTokenCount();
 
 	vector<HTp> reservoir;
-	vector<HumNum> startdurs;
+	vector<DURTYPE> startdurs;
 
 	// Assign line durationFromStarts for primary track first.
 	while (tcount > 0) {
@@ -31701,22 +36117,28 @@ bool HumdrumFileStructure::prepareDurations(HTp token, int state,
 			break;
 		}
 		token->incrementState();
-		if (!setLineDurationFromStart(token, dursum)) { return isValid(); }
-		if (token->getDuration().isPositive()) {
-			dursum += token->getDuration();
+		if (linedurs) {
+			linedurs->emplace_back(token, dursum);
+		} else if (!setLineDurationFromStart(token, dursum)) {
+			return isValid();
 		}
+		addTokenDuration(dursum, token);
 		tcount = token->getNextTokenCount();
 	}
 
 	if ((tcount == 0) && (token->isTerminateInterpretation())) {
-		if (!setLineDurationFromStart(token, dursum)) { return isValid(); }
+		if (linedurs) {
+			linedurs->emplace_back(token, dursum);
+		} else if (!setLineDurationFromStart(token, dursum)) {
+			return isValid();
+		}
 	}
 
 	// Process secondary tracks next:
 	int newstate = state;
 
 	for (int i=(int)reservoir.size()-1; i>=0; i--) {
-		prepareDurations(reservoir[i], newstate, startdurs[i]);
+		prepareDurations(reservoir[i], newstate, startdurs[i], linedurs);
 	}
 
 	return isValid();
@@ -31724,12 +36146,143 @@ bool HumdrumFileStructure::prepareDurations(HTp token, int state,
 
 
 
+//////////////////////////////
+//
+// HumdrumFileStructure::prepareRhythmTicks -- Prepare integer timestamps
+//     for the rhythm analysis, so that durations can be added without
+//     reducing fractions.  The number of ticks per quarter note is the
+//     least common multiple of the denominators of all token durations,
+//     which is calculated before the line durations needed for tpq() are
+//     known.  No timestamp can be larger than the sum of all token
+//     durations, so if that sum fits into 64 bits the analysis cannot
+//     overflow.  Returns false if ticks cannot be used, in which case the
+//     analysis is done with HumNum timestamps.
+//
+
+bool HumdrumFileStructure::prepareRhythmTicks(void) {
+	m_rhythmtpq = 0;
+	m_lineticks.clear();
+
+	int64_t tpq = 1;
+	for (int i=0; i<getLineCount(); i++) {
+		if (!m_lines[i]->isData()) {
+			continue;
+		}
+		for (int j=0; j<m_lines[i]->getTokenCount(); j++) {
+			HumNum dur = m_lines[i]->token(j)->getDuration();
+			if (dur.isPositive() && !HumNum64::lcm(tpq, dur.getDenominator(), tpq)) {
+				return false;
+			}
+		}
+	}
+
+	int64_t total = 0;
+	int64_t ticks;
+	for (int i=0; i<getLineCount(); i++) {
+		if (!m_lines[i]->isData()) {
+			continue;
+		}
+		for (int j=0; j<m_lines[i]->getTokenCount(); j++) {
+			HumNum dur = m_lines[i]->token(j)->getDuration();
+			if (!dur.isPositive()) {
+				continue;
+			}
+			if (!HumNum64::multiply(dur.getNumerator(), tpq / dur.getDenominator(), ticks)) {
+				return false;
+			}
+			if (!HumNum64::add(total, ticks, total)) {
+				return false;
+			}
+		}
+	}
+
+	// Timestamps already assigned to lines:
+	m_lineticks.assign(getLineCount(), -1);
+	for (int i=0; i<getLineCount(); i++) {
+		HumNum dur = m_lines[i]->getDurationFromStart();
+		if (dur.isNegative()) {
+			continue;
+		}
+		if (!HumNum64(dur).getTicks(tpq, m_lineticks[i])) {
+			m_lineticks.clear();
+			return false;
+		}
+	}
+
+	m_rhythmtpq = tpq;
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::addTokenDuration -- Add the duration of a token
+//     to a running timestamp if the duration is positive.
+//
+
+void HumdrumFileStructure::addTokenDuration(HumNum& dursum, HTp token) {
+	HumNum dur = token->getDuration();
+	if (dur.isPositive()) {
+		dursum += dur;
+	}
+}
+
+
+void HumdrumFileStructure::addTokenDuration(int64_t& durticks, HTp token) {
+	HumNum dur = token->getDuration();
+	if (dur.isPositive()) {
+		// Cannot overflow (checked in prepareRhythmTicks()):
+		durticks += (int64_t)dur.getNumerator() * (m_rhythmtpq / dur.getDenominator());
+	}
+}
+
+
+
 //////////////////////////////
 //
 // HumdrumFileStructure::setLineDurationFromStart -- Set the duration of
-//      a line based on the analysis of tokens in the spine.
+//      a line based on the analysis of tokens in the spine.  The second
+//      form takes the timestamp in ticks (see prepareRhythmTicks()), and
+//      only converts it to a HumNum when the line has no timestamp yet.
+//      Timestamps that do not fit into a HumNum are a parse error.
 //
 
+bool HumdrumFileStructure::setLineDurationFromStart(HTp token,
+		int64_t durticks) {
+	if ((!token->isTerminateInterpretation()) &&
+			token->getDuration().isNegative()) {
+		// undefined rhythm, so don't assign line duration information:
+		return isValid();
+	}
+	HLp line = token->getOwner();
+	int64_t& lineticks = m_lineticks[line->getLineIndex()];
+	if (lineticks < 0) {
+		HumNum dursum;
+		if (!HumNum64(durticks, m_rhythmtpq).getHumNum(dursum)) {
+			stringstream err;
+			err << "Error: durationFromStart too large near line "
+			    << token->getLineNumber() << endl;
+			err << "Duration is: " << HumNum64(durticks, m_rhythmtpq) << endl;
+			err << "Line: " << *line << endl;
+			return setParseError(err);
+		}
+		lineticks = durticks;
+		line->setDurationFromStart(dursum);
+	} else if (lineticks != durticks) {
+		stringstream err;
+		err << "Error: Inconsistent rhythm analysis occurring near line "
+		    << token->getLineNumber() << endl;
+		err << "Expected durationFromStart to be: " << HumNum64(durticks, m_rhythmtpq)
+		    << " but found it to be " << line->getDurationFromStart() << endl;
+		err << "Line: " << *line << endl;
+		return setParseError(err);
+	}
+
+	return isValid();
+}
+
+
 bool HumdrumFileStructure::setLineDurationFromStart(HTp token,
 		HumNum dursum) {
 	if ((!token->isTerminateInterpretation()) &&
@@ -31737,6 +36290,11 @@ bool HumdrumFileStructure::setLineDurationFromStart(HTp token,
 		// undefined rhythm, so don't assign line duration information:
 		return isValid();
 	}
+	if (m_rhythmtpq > 0) {
+		// Stop using ticks since the line timestamps will change:
+		m_rhythmtpq = 0;
+		m_lineticks.clear();
+	}
 	HLp line = token->getOwner();
 	if (line->getDurationFromStart().isNegative()) {
 		line->setDurationFromStart(dursum);
@@ -31755,6 +36313,34 @@ bool HumdrumFileStructure::setLineDurationFromStart(HTp token,
 
 
 
+//////////////////////////////
+//
+// HumdrumFileStructure::hasCrossTrackMerges -- Returns true if any spine
+//     manipulator links a token to a token in a different track (such as
+//     when *v merges two primary spines).  Tracks cannot be analyzed
+//     independently in that case.
+//
+
+bool HumdrumFileStructure::hasCrossTrackMerges(void) {
+	for (int i=0; i<getLineCount(); i++) {
+		if (!m_lines[i]->isManipulator()) {
+			continue;
+		}
+		for (int j=0; j<m_lines[i]->getFieldCount(); j++) {
+			HTp token = m_lines[i]->token(j);
+			int track = token->getTrack();
+			for (int k=0; k<token->getNextTokenCount(); k++) {
+				if (token->getNextToken(k)->getTrack() != track) {
+					return true;
+				}
+			}
+		}
+	}
+	return false;
+}
+
+
+
 //////////////////////////////
 //
 // HumdrumFileStructure::analyzeRhythmOfFloatingSpine --  This analysis
@@ -32507,6 +37093,7 @@ string HumdrumLine::getTriadicQuality(HumdrumFile& infile, int index,
 	}
 
 	vector<int> notes;
+	HumSonority sonority;
 
 	// Collect notes from all sounding tokens, including resolved nulls.
 	for (int i=0; i<infile[index].getFieldCount(); i++) {
@@ -32528,6 +37115,7 @@ string HumdrumLine::getTriadicQuality(HumdrumFile& infile, int index,
 
 		for (int j=0; j<(int)subtoks.size(); j++) {
 			notes.push_back(subtoks[j]);
+			sonority.addMidi(subtoks[j]);
 		}
 	}
 
@@ -32540,22 +37128,22 @@ string HumdrumLine::getTriadicQuality(HumdrumFile& infile, int index,
 		}
 	}
 
-	// Sort pitches if requested.
-	if (lowQ) {
-		sort(notes.begin(), notes.end(),
-			[](const int& a, const int& b) {
-				return abs(a) > abs(b);
-			}
-		);
-	} else {
-		sort(notes.begin(), notes.end(),
-			[](const int& a, const int& b) {
-				return abs(a) < abs(b);
-			}
-		);
-	}
-
 	if (pitchesQ) {
+		// Sort pitches if requested.
+		if (lowQ) {
+			sort(notes.begin(), notes.end(),
+				[](const int& a, const int& b) {
+					return abs(a) > abs(b);
+				}
+			);
+		} else {
+			sort(notes.begin(), notes.end(),
+				[](const int& a, const int& b) {
+					return abs(a) < abs(b);
+				}
+			);
+		}
+
 		string output = "[";
 
 		for (int i=0; i<(int)notes.size(); i++) {
@@ -32622,38 +37210,15 @@ string HumdrumLine::getTriadicQuality(HumdrumFile& infile, int index,
 		}
 	}
 
-	vector<bool> pcs(12, false);
-
-	for (int i=0; i<(int)notes.size(); i++) {
-
-		int pitch = notes[i];
-
-		if (pitch == 0) {
-			continue;
-		}
-
-		if (pitch < 0) {
-			pitch = -pitch;
-		}
-
-		pcs[pitch % 12] = true;
-	}
-
-	vector<int> pcs_new;
-
-	for (int i=0; i<12; i++) {
-		if (pcs[i]) {
-			pcs_new.push_back(i);
-		}
-	}
-
 	if (classQ) {
 
 		string output = "{";
 
-		for (int i=0; i<(int)pcs_new.size(); i++) {
-			output += to_string(pcs_new[i]);
-			output += " ";
+		for (int i=0; i<12; i++) {
+			if (sonority.hasPitchClass(i)) {
+				output += to_string(i);
+				output += " ";
+			}
 		}
 
 		if (output.size() == 1) {
@@ -32670,7 +37235,11 @@ string HumdrumLine::getTriadicQuality(HumdrumFile& infile, int index,
 		"F#", "G", "A♭", "A", "B♭", "B"
 	};
 
-	if (pcs_new.empty()) {
+	// Classify the pitch-class set by table lookup.
+	int type = sonority.getType();
+	int r    = sonority.getRoot();
+
+	if (type == sonority_empty) {
 		if (restQ) {
 			quality = "R";
 			return "";
@@ -32680,240 +37249,110 @@ string HumdrumLine::getTriadicQuality(HumdrumFile& infile, int index,
 	}
 
 	// Unison.
-	if (pcs_new.size() == 1) {
+	if (type == sonority_unison) {
 		if (unisonQ && partialQ) {
 			quality = "U";
-			root = pcnames[pcs_new[0]];
+			root = pcnames[r];
 			if (asciiQ) {
 				inversion = "1";
 			} else {
 				inversion = "₁";
 			}
-			return "";
 		}
+		return "";
 	}
 
 	// Dyads.
-	if (pcs_new.size() == 2) {
-
-		int pc1 = pcs_new[0];
-		int pc2 = pcs_new[1];
-
-		int interval = (pc2 - pc1 + 12) % 12;
-
-		if (interval == 7) {
-			if (partialQ) {
-				quality = "-5";
-				root = pcnames[pc1];
-				if (asciiQ) {
-					inversion = "5";
-				} else {
-					inversion = "₅";
-				}
-			}
-		} else if (interval == 5) {
-			if (partialQ) {
-				quality = "-5";
-					root = pcnames[pc2];
-				if (asciiQ) {
-					inversion = "5";
-				} else {
-					inversion = "₅";
-				}
-			}
-
-		} else if (interval == 3) {
-			if (partialQ) {
-				quality = "-m";
-				root = pcnames[pc1];
-				root[0] = tolower(root[0]);
-				if (asciiQ) {
-					inversion = "3";
-				} else {
-					inversion = "₃";
-				}
-			}
-
-		} else if (interval == 9) {
-			if (partialQ) {
-				quality = "-m";
-				root = pcnames[pc2];
-				root[0] = tolower(root[0]);
-				if (asciiQ) {
-					inversion = "3";
-				} else {
-					inversion = "₃";
-				}
+	if (type == sonority_fifth) {
+		if (partialQ) {
+			quality = "-5";
+			root = pcnames[r];
+			if (asciiQ) {
+				inversion = "5";
+			} else {
+				inversion = "₅";
 			}
-
-		} else if (interval == 4) {
-			if (partialQ) {
-				quality = "-M";
-				root = pcnames[pc1];
-				if (asciiQ) {
-					inversion = "3";
-				} else {
-					inversion = "₃";
-				}
+		}
+		return "";
+	} else if (type == sonority_minor_third) {
+		if (partialQ) {
+			quality = "-m";
+			root = pcnames[r];
+			root[0] = tolower(root[0]);
+			if (asciiQ) {
+				inversion = "3";
+			} else {
+				inversion = "₃";
 			}
-
-		} else if (interval == 8) {
-			if (partialQ) {
-				quality = "-M";
-				root = pcnames[pc2];
-				if (asciiQ) {
-					inversion = "3";
-				} else {
-					inversion = "₃";
-				}
+		}
+		return "";
+	} else if (type == sonority_major_third) {
+		if (partialQ) {
+			quality = "-M";
+			root = pcnames[r];
+			if (asciiQ) {
+				inversion = "3";
+			} else {
+				inversion = "₃";
 			}
-
-		} else {
-			quality = "?";
-			root.clear();
-			inversion.clear();
 		}
-
+		return "";
+	} else if ((type == sonority_tritone) || (type == sonority_dyad)) {
+		quality = "?";
 		return "";
 	}
 
 	// More than triad.
-	if (pcs_new.size() > 3) {
+	if (type == sonority_large) {
 		quality = "+";
 		return "";
 	}
 
-	// Try all pitch classes as root.
-	for (int i=0; i<3; i++) {
-
-		int r = pcs_new[i];
-
-		bool has3 = false;
-		bool has4 = false;
-		bool has6 = false;
-		bool has7 = false;
-		bool has8 = false;
-
-		for (int j=0; j<3; j++) {
-			int interval = (pcs_new[j] - r + 12) % 12;
-			if (interval == 3) {
-				has3 = true;
-			} else if (interval == 4) {
-				has4 = true;
-			} else if (interval == 6) {
-				has6 = true;
-			} else if (interval == 7) {
-				has7 = true;
-			} else if (interval == 8) {
-				has8 = true;
-			}
-		}
-
-		int bassint = (basspc - r + 12) % 12;
+	// Unknown trichord.
+	if (!HumSonority::isTriad(type)) {
+		quality = "?";
+		return "";
+	}
 
-		// Major triad.
-		if (has4 && has7) {
-			quality = "M";
-			root = pcnames[r];
-			if (bassint == 4) {
-				if (asciiQ) {
-					inversion = "6";
-				} else {
-					inversion += "₆";
-				}
-			} else if (bassint == 7) {
-				if (asciiQ) {
-					inversion = "4";
-				} else {
-					inversion = "₄";
-				}
-			}
-			return "";
+	// Triads: the bass indicates the inversion.
+	bool thirdQ = (basspc >= 0) && (basspc == sonority.getThird());
+	bool fifthQ = (basspc >= 0) && (basspc == sonority.getFifth());
+	root = pcnames[r];
+	if (type == sonority_major) {
+		quality = "M";
+	} else if (type == sonority_minor) {
+		quality = "m";
+		root[0] = tolower(root[0]);
+	} else if (type == sonority_diminished) {
+		quality = "d";
+		if (asciiQ) {
+			root += "o";
+		} else {
+			root += "°";
 		}
-
-		// Minor triad.
-		if (has3 && has7) {
-			quality = "m";
-			root = pcnames[r];
-			if (!root.empty()) {
-				root[0] = tolower(root[0]);
-			}
-			if (bassint == 3) {
-				if (asciiQ) {
-					inversion = "6";
-				} else {
-					inversion = "₆";
-				}
-			} else if (bassint == 7) {
-				if (asciiQ) {
-					inversion = "4";
-				} else {
-					inversion = "₄";
-				}
-			}
-
-			return "";
+		root[0] = tolower(root[0]);
+	} else if (type == sonority_augmented) {
+		quality = "A";
+		if (asciiQ) {
+			root += "+";
+		} else {
+			root += "⁺";
 		}
-
-		// Diminished triad.
-		if (has3 && has6) {
-			quality = "d";
-			root = pcnames[r];
-			if (asciiQ) {
-				root += "o";
-			} else {
-				root += "°";
-			}
-			if (!root.empty()) {
-				root[0] = tolower(root[0]);
-			}
-			if (bassint == 3) {
-				if (asciiQ) {
-					inversion = "6";
-				} else {
-					inversion = "₆";
-				}
-			} else if (bassint == 6) {
-				if (asciiQ) {
-					inversion = "4";
-				} else {
-					inversion = "₄";
-				}
-			}
-			return "";
+	}
+	if (thirdQ) {
+		if (asciiQ) {
+			inversion = "6";
+		} else {
+			inversion = "₆";
 		}
-
-		// Augmented triad.
-		if (has4 && has8) {
-			quality = "A";
-			root = pcnames[r];
-			if (asciiQ) {
-				root += "+";
-			} else {
-				root += "⁺";
-			}
-			if (bassint == 4) {
-				if (asciiQ) {
-					inversion = "6";
-				} else {
-					inversion = "₆";
-				}
-			} else if (bassint == 8) {
-				if (asciiQ) {
-					inversion = "4";
-				} else {
-					inversion = "₄";
-				}
-			}
-			return "";
+	} else if (fifthQ) {
+		if (asciiQ) {
+			inversion = "4";
+		} else {
+			inversion = "₄";
 		}
 	}
 
-	// Unknown trichord.
-	quality = "?";
-	root.clear();
-	inversion.clear();
-
 	return "";
 }
 
@@ -33183,7 +37622,7 @@ HumdrumLine::~HumdrumLine() {
 
 void HumdrumLine::setLineFromCsv(const char* csv, const string& separator) {
 	string temp = csv;
-	setLineFromCsv(temp);
+	setLineFromCsv(temp, separator);
 }
 
 
@@ -33244,6 +37683,9 @@ void HumdrumLine::setLineFromCsv(const string& csv, const string& separator) {
 
 void HumdrumLine::setText(const string& text) {
 	string::assign(text);
+	if (m_owner) {
+		((HumdrumFile*)m_owner)->clearReferenceRecords();
+	}
 }
 
 
@@ -33312,7 +37754,7 @@ bool HumdrumLine::isKernBoundaryStart(void) const {
 		return false;
 	}
 	for (int i=0; i<getFieldCount(); i++) {
-		if (!token(i)->isDataType("**kern")) {
+		if (!token(i)->isKern()) {
 			continue;
 		}
 		if (token(i)->isNull()) {
@@ -33356,7 +37798,7 @@ bool HumdrumLine::isKernBoundaryEnd(void) const {
 	}
 	HTp ntok;
 	for (int i=0; i<getFieldCount(); i++) {
-		if (!token(i)->isDataType("**kern")) {
+		if (!token(i)->isKern()) {
 			continue;
 		}
 		ntok = token(i)->getNextToken();
@@ -34077,6 +38519,22 @@ HTp HumdrumLine::getTrackStart(int track) const {
 
 
 
+//////////////////////////////
+//
+// HumdrumLine::getTrackDataType --  Returns the HumDataType ID of the
+//    exclusive interpretation for the given spine/track.
+//
+
+int HumdrumLine::getTrackDataType(int track) const {
+	if (!m_owner) {
+		return datatype_unknown;
+	} else {
+		return ((HumdrumFile*)m_owner)->getTrackDataType(track);
+	}
+}
+
+
+
 //////////////////////////////
 //
 // HumdrumLine::getTrackEnd --  Returns the ending exclusive interpretation
@@ -34313,7 +38771,12 @@ string HumdrumLine::getTokenString(int index) const {
 //////////////////////////////
 //
 // HumdrumLine::createTokensFromLine -- Chop up a HumdrumLine string into
-//     individual tokens.
+//     individual tokens.  Tab characters are found with memchr(), and the
+//     token and tab-count lists are sized in advance from the number of
+//     tabs on the line, so that each token is created with a single copy
+//     of its text.  A run of tabs separates two tokens (the number of tabs
+//     is stored in m_tabs), a leading tab creates an empty first token,
+//     and trailing tabs do not create an empty last token.
 //
 
 int HumdrumLine::createTokensFromLine(void) {
@@ -34326,51 +38789,203 @@ int HumdrumLine::createTokensFromLine(void) {
 	m_tokens.clear();
 	m_tabs.clear();
 	HTp token;
-	char ch = 0;
-	char lastch = 0;
-	string tstring;
 
-	if (this->size() == 0) {
-		token = new HumdrumToken();
+	if ((this->size() == 0) || (this->compare(0, 2, "!!") == 0)) {
+		token = new HumdrumToken(this->c_str());
 		token->setOwner(this);
 		m_tokens.push_back(token);
 		m_tabs.push_back(0);
-	} else if (this->compare(0, 2, "!!") == 0) {
-		token = new HumdrumToken(this->c_str());
+		return 1;
+	}
+
+	const char* start = this->data();
+	const char* end = start + this->size();
+	const char* ptr;
+
+	int tabcount = 0;
+	ptr = start;
+	while ((ptr = (const char*)memchr(ptr, '\t', end - ptr)) != NULL) {
+		tabcount++;
+		ptr++;
+	}
+	m_tokens.reserve(tabcount + 1);
+	m_tabs.reserve(tabcount + 1);
+
+	ptr = start;
+	while (ptr < end) {
+		const char* tab = (const char*)memchr(ptr, '\t', end - ptr);
+		if (tab == NULL) {
+			tab = end;
+		}
+		token = new HumdrumToken();
+		token->assign(ptr, tab - ptr);
 		token->setOwner(this);
 		m_tokens.push_back(token);
-		m_tabs.push_back(0);
+		if (tab == end) {
+			m_tabs.push_back(0);
+			break;
+		}
+		// Parser allows multiple tab characters in a row to represent
+		// a single tab.
+		m_tabs.push_back(1);
+		ptr = tab + 1;
+		while ((ptr < end) && (*ptr == '\t')) {
+			m_tabs.back()++;
+			ptr++;
+		}
+	}
+
+	return (int)m_tokens.size();
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumLine::getTabCount -- Return the number of tab characters after
+//     a token on the line (0 for the last token unless the line has
+//     trailing tabs).
+//
+
+int HumdrumLine::getTabCount(int index) const {
+	if ((index < 0) || (index >= (int)m_tabs.size())) {
+		return 0;
+	}
+	return m_tabs[index];
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumLine::createTokensFromCsv -- Set the text of the line from a
+//     line of CSV data (not including the newline), and create the tokens
+//     for the line at the same time.  The tokens are the same as those
+//     that createTokensFromLine() would create from the equivalent TSV line.
+//     Separators and quotes are found with memchr(), so that lines without
+//     quotes do not need to be examined one character at a time.  Lines
+//     starting with "!!" are not split into fields.
+// default value: separator = ","
+//
+
+int HumdrumLine::createTokensFromCsv(const char* csv, int length,
+		const string& separator) {
+	for (int i=0; i < (int)m_tokens.size(); i++) {
+		delete m_tokens[i];
+		m_tokens[i] = NULL;
+	}
+	m_tokens.clear();
+	m_tabs.clear();
+
+	if ((length > 0) && (csv[length-1] == 0x0d)) {
+		length--;
+	}
+	string& value = *this;
+	if (((length >= 2) && (csv[0] == '!') && (csv[1] == '!')) ||
+			separator.empty()) {
+		// Global comments and reference records are literal.
+		value.assign(csv, length);
+		return createTokensFromLine();
+	}
+	value.clear();
+	value.reserve(length);
+
+	// Fields may contain tab characters, which would be token separators
+	// in the TSV line, so let createTokensFromLine() deal with them.
+	bool tabQ = memchr(csv, '\t', length) != NULL;
+	bool quoteQ = memchr(csv, '"', length) != NULL;
+	const char* end = csv + length;
+	const char* sep = separator.data();
+	int seplen = (int)separator.size();
+	int fieldindex = 0;
+	int fieldstart = 0;
+
+	// addToken: Add a token for the field at the end of value.  An empty
+	// field after the first one adds an extra tab to the previous token
+	// instead of creating a token (and an empty last field is ignored).
+	auto addToken = [&](bool lastQ) {
+		int fieldlength = (int)value.size() - fieldstart;
+		if (!tabQ) {
+			if ((fieldlength > 0) || ((fieldindex == 0) && !lastQ)) {
+				HTp token = new HumdrumToken();
+				token->assign(value, fieldstart, fieldlength);
+				token->setOwner(this);
+				m_tokens.push_back(token);
+				m_tabs.push_back(lastQ ? 0 : 1);
+			} else if (!lastQ && !m_tabs.empty()) {
+				m_tabs.back()++;
+			}
+		}
+		if (!lastQ) {
+			value += '\t';
+			fieldstart = (int)value.size();
+			fieldindex++;
+		}
+	};
+
+	const char* ptr = csv;
+	if (!quoteQ) {
+		while (true) {
+			const char* found = ptr;
+			const char* next = NULL;
+			while (found < end) {
+				found = (const char*)memchr(found, sep[0], end - found);
+				if (found == NULL) {
+					break;
+				}
+				if ((end - found >= seplen) && (memcmp(found, sep, seplen) == 0)) {
+					next = found;
+					break;
+				}
+				found++;
+			}
+			if (next == NULL) {
+				value.append(ptr, end - ptr);
+				addToken(true);
+				break;
+			}
+			value.append(ptr, next - ptr);
+			addToken(false);
+			ptr = next + seplen;
+		}
 	} else {
-		for (int i=0; i<(int)size(); i++) {
-			lastch = ch;
-			ch = getChar(i);
-			if (ch == '\t') {
-				// Parser now allows multiple tab characters in a
-				// row to represent a single tab.
-				if (lastch != '\t') {
-					token = new HumdrumToken(tstring);
-					token->setOwner(this);
-					m_tokens.push_back(token);
-					m_tabs.push_back(1);
-					tstring.clear();
+		bool inquote = false;
+		while (ptr < end) {
+			if (*ptr == '"') {
+				if (!inquote) {
+					inquote = true;
+				} else if ((ptr + 1 < end) && (ptr[1] == '"')) {
+					value += '"';
+					ptr++;
 				} else {
-					if (m_tabs.size() > 0) {
-						m_tabs.back()++;
-					}
+					inquote = false;
 				}
-			} else {
-				tstring += ch;
+				ptr++;
+				continue;
 			}
+			if (!inquote && (end - ptr >= seplen) && (memcmp(ptr, sep, seplen) == 0)) {
+				addToken(false);
+				ptr += seplen;
+				continue;
+			}
+			if (inquote) {
+				// copy quoted text up to the next quote
+				const char* quote = (const char*)memchr(ptr, '"', end - ptr);
+				if (quote == NULL) {
+					quote = end;
+				}
+				value.append(ptr, quote - ptr);
+				ptr = quote;
+				continue;
+			}
+			value += *ptr++;
 		}
-	}
-	if (tstring.size() > 0) {
-		token = new HumdrumToken(tstring);
-		token->setOwner(this);
-		m_tokens.push_back(token);
-		m_tabs.push_back(0);
-		tstring.clear();
+		addToken(true);
 	}
 
+	if (tabQ || value.empty()) {
+		return createTokensFromLine();
+	}
 	return (int)m_tokens.size();
 }
 
@@ -34387,6 +39002,7 @@ int HumdrumLine::createTokensFromLine(void) {
 
 void HumdrumLine::createLineFromTokens(void) {
 	string& iline = *this;
+	bool globalQ = iline.compare(0, 2, "!!") == 0;
 	iline = "";
 	// needed for empty lines for some reason:
 	if (m_tokens.size()) {
@@ -34410,6 +39026,11 @@ void HumdrumLine::createLineFromTokens(void) {
 			}
 		}
 	}
+
+	// A global line may have become (or stopped being) a reference record:
+	if (m_owner && (globalQ || (iline.compare(0, 2, "!!") == 0))) {
+		((HumdrumFile*)m_owner)->clearReferenceRecords();
+	}
 }
 
 
@@ -35522,20 +40143,26 @@ void HumdrumToken::getBase40Pitches(vector<int>& output) {
 		output.clear();
 		return;
 	}
-	vector<string> pieces = this->getSubtokens();
-	output.resize(pieces.size());
-	for (int i=0; i<(int)pieces.size(); i++) {
-		if (pieces[i].find("r") != string::npos) {
-			output[i] = 0;
+	output.clear();
+	string piece;
+	for (string_view view : this->getSubtokenViews()) {
+		if (view.empty()) {
+			continue;
+		}
+		piece.assign(view);
+		int value;
+		if (piece.find("r") != string::npos) {
+			value = 0;
 		} else {
-			output[i] = Convert::kernToBase40(pieces[i]);
+			value = Convert::kernToBase40(piece);
 			// sustained notes are negative values:
-			if (pieces[i].find("_") != string::npos) {
-				output[i] = -output[i];
-			} else if (pieces[i].find("]") != string::npos) {
-				output[i] = -output[i];
+			if (piece.find("_") != string::npos) {
+				value = -value;
+			} else if (piece.find("]") != string::npos) {
+				value = -value;
 			}
 		}
+		output.push_back(value);
 	}
 }
 
@@ -35637,22 +40264,27 @@ void HumdrumToken::getBase40PitchesResolveNull(vector<int>& output) {
 	if (*token == ".") {
 		return;
 	}
-	vector<string> pieces = token->getSubtokens();
-	output.resize(pieces.size());
-	for (int i=0; i<(int)pieces.size(); i++) {
-		if (pieces[i].find("r") != string::npos) {
-			output[i] = 0;
+	string piece;
+	for (string_view view : token->getSubtokenViews()) {
+		if (view.empty()) {
+			continue;
+		}
+		piece.assign(view);
+		int value;
+		if (piece.find("r") != string::npos) {
+			value = 0;
 		} else {
-			output[i] = Convert::kernToBase40(pieces[i]);
+			value = Convert::kernToBase40(piece);
 			// sustained notes are negative values:
 			if (nullQ) {
-				output[i] = -output[i];
-			} else if (pieces[i].find("_") != string::npos) {
-				output[i] = -output[i];
-			} else if (pieces[i].find("]") != string::npos) {
-				output[i] = -output[i];
+				value = -value;
+			} else if (piece.find("_") != string::npos) {
+				value = -value;
+			} else if (piece.find("]") != string::npos) {
+				value = -value;
 			}
 		}
+		output.push_back(value);
 	}
 }
 
@@ -35731,20 +40363,26 @@ void HumdrumToken::getMidiPitches(vector<int>& output) {
 		output.clear();
 		return;
 	}
-	vector<string> pieces = this->getSubtokens();
-	output.resize(pieces.size());
-	for (int i=0; i<(int)pieces.size(); i++) {
-		if (pieces[i].find("r") != string::npos) {
-			output[i] = 0;
+	output.clear();
+	string piece;
+	for (string_view view : this->getSubtokenViews()) {
+		if (view.empty()) {
+			continue;
+		}
+		piece.assign(view);
+		int value;
+		if (piece.find("r") != string::npos) {
+			value = 0;
 		} else {
-			output[i] = Convert::kernToMidiNoteNumber(pieces[i]);
+			value = Convert::kernToMidiNoteNumber(piece);
 			// sustained notes are negative values:
-			if (pieces[i].find("_") != string::npos) {
-				output[i] = -output[i];
-			} else if (pieces[i].find("]") != string::npos) {
-				output[i] = -output[i];
+			if (piece.find("_") != string::npos) {
+				value = -value;
+			} else if (piece.find("]") != string::npos) {
+				value = -value;
 			}
 		}
+		output.push_back(value);
 	}
 }
 
@@ -35846,22 +40484,27 @@ void HumdrumToken::getMidiPitchesResolveNull(vector<int>& output) {
 	if (*token == ".") {
 		return;
 	}
-	vector<string> pieces = token->getSubtokens();
-	output.resize(pieces.size());
-	for (int i=0; i<(int)pieces.size(); i++) {
-		if (pieces[i].find("r") != string::npos) {
-			output[i] = 0;
+	string piece;
+	for (string_view view : token->getSubtokenViews()) {
+		if (view.empty()) {
+			continue;
+		}
+		piece.assign(view);
+		int value;
+		if (piece.find("r") != string::npos) {
+			value = 0;
 		} else {
-			output[i] = Convert::kernToMidiNoteNumber(pieces[i]);
+			value = Convert::kernToMidiNoteNumber(piece);
 			// sustained notes are negative values:
 			if (nullQ) {
-				output[i] = -output[i];
-			} else if (pieces[i].find("_") != string::npos) {
-				output[i] = -output[i];
-			} else if (pieces[i].find("]") != string::npos) {
-				output[i] = -output[i];
+				value = -value;
+			} else if (piece.find("_") != string::npos) {
+				value = -value;
+			} else if (piece.find("]") != string::npos) {
+				value = -value;
 			}
 		}
+		output.push_back(value);
 	}
 }
 
@@ -36054,6 +40697,7 @@ HumdrumToken& HumdrumToken::operator=(HumdrumToken& token) {
 	}
 	(string)(*this)   = (string)token;
 	(HumHash)(*this)  = (HumHash)token;
+	clearSubtokenStarts();
 
 	m_address         = token.m_address;
 	m_address.m_owner = NULL;
@@ -36073,7 +40717,9 @@ HumdrumToken& HumdrumToken::operator=(HumdrumToken& token) {
 
 
 HumdrumToken& HumdrumToken::operator=(const string& token) {
-	(string)(*this) = token;
+	// setText() before the owner is cleared, so that the data type of
+	// the track is updated if the token was an exclusive interpretation.
+	setText(token);
 
 	m_address.m_owner = NULL;
 	m_duration        = 0;
@@ -36092,7 +40738,7 @@ HumdrumToken& HumdrumToken::operator=(const string& token) {
 
 
 HumdrumToken& HumdrumToken::operator=(const char* token) {
-	(string)(*this) = token;
+	setText(token);
 
 	m_address.m_owner = NULL;
 	m_duration        = 0;
@@ -36286,6 +40932,20 @@ const string& HumdrumToken::getDataType(void) const {
 }
 
 
+
+//////////////////////////////
+//
+// HumdrumToken::getDataTypeId -- Get the HumDataType ID of the exclusive
+//     interpretation for the token, such as datatype_kern.  This is
+//     faster than getDataType() for comparing data types.
+// @SEEALSO: isDataType
+//
+
+int HumdrumToken::getDataTypeId(void) const {
+	return m_address.getDataTypeId();
+}
+
+
 /////////////////////////////
 //
 // HumdrumToken::getExclusiveInterpretation -- Get the exclusive
@@ -36314,6 +40974,11 @@ bool HumdrumToken::isDataType(const string& dtype) const {
 }
 
 
+bool HumdrumToken::isDataType(int datatype) const {
+	return getDataTypeId() == datatype;
+}
+
+
 
 //////////////////////////////
 //
@@ -36359,7 +41024,7 @@ bool HumdrumToken::isDataTypeLike(const string& dtype) const {
 //
 
 bool HumdrumToken::isKern(void) const {
-	return isDataType("**kern");
+	return getDataTypeId() == datatype_kern;
 }
 
 
@@ -36375,10 +41040,14 @@ bool HumdrumToken::isKern(void) const {
 //
 
 bool HumdrumToken::isKernLike(void) const {
-	string dtype = getDataType();
-	if (dtype == "**kern") {
+	int id = getDataTypeId();
+	if (id == datatype_kern) {
 		return true;
-	} else if (dtype.compare(0, 7, "**kern-") == 0) {
+	} else if ((id == datatype_unknown) || (id == datatype_mens)) {
+		return false;
+	}
+	const string& dtype = getDataType();
+	if (dtype.compare(0, 7, "**kern-") == 0) {
 		return true;
 	} else if (dtype == "**kernyy") {
 		return true;
@@ -36396,7 +41065,7 @@ bool HumdrumToken::isKernLike(void) const {
 //
 
 bool HumdrumToken::isMens(void) const {
-	return isDataType("**mens");
+	return getDataTypeId() == datatype_mens;
 }
 
 
@@ -36412,10 +41081,14 @@ bool HumdrumToken::isMens(void) const {
 //
 
 bool HumdrumToken::isMensLike(void) const {
-	string dtype = getDataType();
-	if (dtype == "**mens") {
+	int id = getDataTypeId();
+	if (id == datatype_mens) {
 		return true;
-	} else if (dtype.compare(0, 7, "**mens-") == 0) {
+	} else if ((id == datatype_unknown) || (id == datatype_kern)) {
+		return false;
+	}
+	const string& dtype = getDataType();
+	if (dtype.compare(0, 7, "**mens-") == 0) {
 		return true;
 	}
 	return false;
@@ -37377,7 +42050,7 @@ bool HumdrumToken::isNoteAttack(void) {
 //
 
 bool HumdrumToken::isInvisible(void) {
-	if (!isDataType("**kern")) {
+	if (!isKern()) {
 			return false;
 	}
 	if (isBarline()) {
@@ -37401,7 +42074,7 @@ bool HumdrumToken::isInvisible(void) {
 //
 
 bool HumdrumToken::isGrace(void) {
-	if (!isDataType("**kern")) {
+	if (!isKern()) {
 			return false;
 	}
 	if (!isData()) {
@@ -37421,7 +42094,7 @@ bool HumdrumToken::isGrace(void) {
 //
 
 bool HumdrumToken::isClef(void) {
-	if (!(isDataType("**kern") || isDataType("**mens"))) {
+	if (!(isKern() || isMens())) {
 			return false;
 	}
 	if (!isInterpretation()) {
@@ -37441,7 +42114,7 @@ bool HumdrumToken::isClef(void) {
 //
 
 bool HumdrumToken::isModernClef(void) {
-	if (!(isDataType("**kern") || isDataType("**mens"))) {
+	if (!(isKern() || isMens())) {
 			return false;
 	}
 	if (!isInterpretation()) {
@@ -37461,7 +42134,7 @@ bool HumdrumToken::isModernClef(void) {
 //
 
 bool HumdrumToken::isOriginalClef(void) {
-	if (!(isDataType("**kern") || isDataType("**mens"))) {
+	if (!(isKern() || isMens())) {
 			return false;
 	}
 	if (!isInterpretation()) {
@@ -37905,7 +42578,7 @@ string HumdrumToken::getInstrumentAbbreviation(void) {
 //
 
 bool HumdrumToken::hasSlurStart(void) {
-	if (isDataType("**kern")) {
+	if (isKern()) {
 		if (Convert::hasKernSlurStart((string)(*this))) {
 			return true;
 		}
@@ -37922,7 +42595,7 @@ bool HumdrumToken::hasSlurStart(void) {
 //
 
 bool HumdrumToken::hasSlurEnd(void) {
-	if (isDataType("**kern")) {
+	if (isKern()) {
 		if (Convert::hasKernSlurEnd((string)(*this))) {
 			return true;
 		}
@@ -38138,7 +42811,7 @@ bool HumdrumToken::hasObliquaLigatureEnd(void) {
 //
 
 bool HumdrumToken::isSecondaryTiedNote(void) {
-	if (isDataType("**kern")) {
+	if (isKern()) {
 		if (Convert::isKernSecondaryTiedNote((string)(*this))) {
 			return true;
 		}
@@ -38510,19 +43183,35 @@ string HumdrumToken::getTrackString(void) const {
 // HumdrumToken::getSubtokenCount -- Returns the number of sub-tokens in
 //     a token.  The input parameter is the sub-token separator.  If the
 //     separator comes at the start or end of the token, then there will
-//     be empty sub-token(s) included in the count.
+//     be empty sub-token(s) included in the count.  An empty separator
+//     counts characters.  The non-const version stores the subtoken
+//     offsets for later calls to getSubtoken() and getSubtokenView().
 // default value: separator = " "
 // @SEEALSO: getSubtoken
 //
 
 int HumdrumToken::getSubtokenCount(const string& separator) const {
-	int count = 0;
+	if (separator.empty()) {
+		return (int)size();
+	}
+	if (hasSubtokenStarts(separator)) {
+		return (int)m_subtokenstarts.size();
+	}
+	int output = 1;
 	string::size_type start = 0;
 	while ((start = string::find(separator, start)) != string::npos) {
-		count++;
 		start += separator.size();
+		output++;
+	}
+	return output;
+}
+
+
+int HumdrumToken::getSubtokenCount(const string& separator) {
+	if (!separator.empty()) {
+		prepareSubtokenStarts(separator);
 	}
-	return count+1;
+	return std::as_const(*this).getSubtokenCount(separator);
 }
 
 
@@ -38538,109 +43227,356 @@ int HumdrumToken::getSubtokenCount(const string& separator) const {
 //
 
 string HumdrumToken::getSubtoken(int index, const string& separator) const {
-    if (index < 0) return "";
+	return string(getSubtokenView(index, separator));
+}
 
-    const string& s = *this;
 
-    // If "separator" is empty, treat "index" as a character index.
-    if (separator.empty()) {
-        if (index >= 0 && static_cast<size_t>(index) < s.size()) {
-            return string(1, s[static_cast<size_t>(index)]);
-        } else {
-            return "";
-        }
-    }
+string HumdrumToken::getSubtoken(int index, const string& separator) {
+	return string(getSubtokenView(index, separator));
+}
 
-    size_t pos = 0;
-    int current = 0;
 
-    while (true) {
-        size_t next = s.find(separator, pos);
 
-        if (current == index) {
-            // We are at the target field: return up to the next separator (or end)
-            if (next == string::npos) {
-                return s.substr(pos);
-            } else {
-                return s.substr(pos, next - pos);
-            }
-        }
-
-        // Not at the target yet: advance to the next field
-        if (next == string::npos) {
-            return "";  // ran out of fields
-        }
-        pos = next + separator.size();
-        ++current;
-    }
+/////////////////////////////
+//
+// HumdrumToken::getSubtokenView -- Same as getSubtoken(), but returns a
+//    view into the token text rather than a copy.  The view is valid
+//    until the token text is changed.  The non-const version caches the
+//    offsets of the subtokens, so calling it for each index does not
+//    split the token each time.  The const version only reads the cache,
+//    so it can be used in several threads at a time.
+// default value: separator = " "
+//
+
+string_view HumdrumToken::getSubtokenView(int index, const string& separator) const {
+	if (index < 0) {
+		return string_view();
+	}
+	string_view text(*this);
+
+	// If "separator" is empty, treat "index" as a character index.
+	if (separator.empty()) {
+		if (index < (int)text.size()) {
+			return text.substr(index, 1);
+		}
+		return string_view();
+	}
+
+	size_t start = 0;
+	size_t end = text.size();
+	if (hasSubtokenStarts(separator)) {
+		if (index >= (int)m_subtokenstarts.size()) {
+			return string_view();
+		}
+		start = m_subtokenstarts[index];
+		if (index + 1 < (int)m_subtokenstarts.size()) {
+			end = m_subtokenstarts[index + 1] - separator.size();
+		}
+	} else {
+		for (int i=0; i<index; i++) {
+			start = text.find(separator, start);
+			if (start == string_view::npos) {
+				return string_view();
+			}
+			start += separator.size();
+		}
+		end = text.find(separator, start);
+		if (end == string_view::npos) {
+			end = text.size();
+		}
+	}
+	return text.substr(start, end - start);
 }
 
 
+string_view HumdrumToken::getSubtokenView(int index, const string& separator) {
+	if (!separator.empty()) {
+		prepareSubtokenStarts(separator);
+	}
+	return std::as_const(*this).getSubtokenView(index, separator);
+}
+
+
+
+/////////////////////////////
+//
+// HumdrumToken::getSubtokenViews -- Return the subtokens as views into
+//    the token text, for use in a range-based for loop.  Unlike
+//    getSubtokens(), empty subtokens are included.
+// default value: separator = " "
+//
+// Example:
+//    for (string_view subtok : token->getSubtokenViews()) {
+//       if (subtok.find('r') != string_view::npos) { ... }
+//    }
+//
+
+HumSubtokenRange HumdrumToken::getSubtokenViews(const string& separator) const {
+	return HumSubtokenRange(*this, separator);
+}
+
 
 
 //////////////////////////////
 //
 // HumdrumToken::getSubtokens -- Return the list of subtokens as an array
-//     of strings.
+//     of strings.  Empty subtokens are not included.
 //     default value: separator = " "
 //
 
 std::vector<std::string> HumdrumToken::getSubtokens(const std::string& separator) const {
-    std::vector<std::string> out;
-    const std::string& s = *this;
+	std::vector<std::string> out;
+	if (separator.empty()) {
+		if (!empty()) {
+			out.push_back(*this);
+		}
+		return out;
+	}
+	for (string_view piece : getSubtokenViews(separator)) {
+		if (!piece.empty()) {
+			out.emplace_back(piece);
+		}
+	}
+	return out;
+}
 
-    if (separator.empty()) {
-        if (!s.empty()) out.push_back(s);
-        return out;
-    }
 
-    std::string::size_type start = 0;
-    while (true) {
-        auto pos = s.find(separator, start);
-        if (pos == std::string::npos) {
-            if (start < s.size()) out.emplace_back(s.substr(start)); // last piece
-            break;
-        }
-        if (pos > start) out.emplace_back(s.substr(start, pos - start)); // ignore empties
-        start = pos + separator.size();
-    }
-    return out;
+
+//////////////////////////////
+//
+// HumdrumToken::replaceSubtoken -- Replace a subtoken, where the index
+//     counts only non-empty subtokens (as in getSubtokens()).  Empty
+//     subtokens are removed from the output.
+//     default value: separator = " "
+//
+
+void HumdrumToken::replaceSubtoken(int index, const std::string& newsubtok,
+		const std::string& separator) {
+	if (index < 0) {
+		return;
+	}
+	if (separator.empty()) {
+		if ((index == 0) && !empty()) {
+			setText(newsubtok);
+		}
+		return;
+	}
+
+	std::string output;
+	int count = 0;
+	bool found = false;
+	for (string_view piece : getSubtokenViews(separator)) {
+		if (piece.empty()) {
+			continue;
+		}
+		if (count > 0) {
+			output += separator;
+		}
+		if (count == index) {
+			output += newsubtok;
+			found = true;
+		} else {
+			output.append(piece);
+		}
+		count++;
+	}
+	if (!found) {
+		return;
+	}
+
+	// Update the HumdrumToken text
+	setText(output);
 }
 
 
 
 //////////////////////////////
 //
-// HumdrumToken::replaceSubtoken --
-//     default value: separator = " "
+// HumdrumToken::prepareSubtokenStarts -- Store the start offsets of the
+//     subtokens for the given separator, unless they are already stored.
+//     The separator must not be empty.
 //
 
+void HumdrumToken::prepareSubtokenStarts(const string& separator) {
+	if (hasSubtokenStarts(separator)) {
+		return;
+	}
+	m_subtokenstarts.clear();
+	m_subtokenstarts.push_back(0);
+	string::size_type start = 0;
+	while ((start = string::find(separator, start)) != string::npos) {
+		start += separator.size();
+		m_subtokenstarts.push_back((int)start);
+	}
+	m_subtokenseparator = separator;
+	m_subtokenlength = size();
+	m_subtokenhash = std::hash<string_view>()(string_view(*this));
+	m_subtokenvalid = true;
+}
+
+
+
 //////////////////////////////
 //
-// HumdrumToken::replaceSubtoken --
-//     default value: separator = " "
+// HumdrumToken::hasSubtokenStarts -- Return true if the stored subtoken
+//     offsets are for the separator and the current text of the token.
+//     The length and hash of the text are compared to the ones when the
+//     offsets were stored, so that changes to the text through the
+//     std::string interface are also noticed.
 //
 
-void HumdrumToken::replaceSubtoken(int index, const std::string& newsubtok,
-                const std::string& separator) {
+bool HumdrumToken::hasSubtokenStarts(const string& separator) const {
+	if (!m_subtokenvalid || (m_subtokenlength != size())) {
+		return false;
+	}
+	if (m_subtokenseparator != separator) {
+		return false;
+	}
+	return m_subtokenhash == std::hash<string_view>()(string_view(*this));
+}
 
-	if (index < 0) return;
 
-	std::vector<std::string> subtokens = getSubtokens(separator);
-	if (index >= static_cast<int>(subtokens.size())) return;
 
-	// Replace the requested subtoken safely
-	subtokens[index] = newsubtok;
+//////////////////////////////
+//
+// HumdrumToken::clearSubtokenStarts -- Remove the cached subtoken offsets
+//     after the token text has been changed.
+//
 
-	// Reconstruct the token text
-	std::string output;
-	for (std::size_t i = 0; i < subtokens.size(); i++) {
-		if (i > 0) output += separator;
-		output += subtokens[i];
+void HumdrumToken::clearSubtokenStarts(void) {
+	m_subtokenstarts.clear();
+	m_subtokenvalid = false;
+}
+
+
+
+//////////////////////////////
+//
+// HumSubtokenIterator::HumSubtokenIterator -- The default constructor is
+//     the end iterator.
+//
+
+HumSubtokenIterator::HumSubtokenIterator(void) {
+	// do nothing
+}
+
+
+HumSubtokenIterator::HumSubtokenIterator(const string& text,
+		const string& separator) {
+	m_text = &text;
+	m_separator = &separator;
+	if (separator.empty() && text.empty()) {
+		// no characters to iterate over
+		return;
 	}
+	m_start = 0;
+	findEnd();
+}
 
-	// Update the HumdrumToken text
-	setText(output);
+
+
+//////////////////////////////
+//
+// HumSubtokenIterator::operator* -- Return the current subtoken.
+//
+
+string_view HumSubtokenIterator::operator*(void) const {
+	if (m_start == string::npos) {
+		return string_view();
+	}
+	return string_view(*m_text).substr(m_start, m_end - m_start);
+}
+
+
+
+//////////////////////////////
+//
+// HumSubtokenIterator::operator++ -- Move to the next subtoken.
+//
+
+HumSubtokenIterator& HumSubtokenIterator::operator++(void) {
+	if (m_start == string::npos) {
+		return *this;
+	}
+	if (m_end >= m_text->size()) {
+		m_start = string::npos;
+		m_end = string::npos;
+		return *this;
+	}
+	m_start = m_end + m_separator->size();
+	m_index++;
+	findEnd();
+	return *this;
+}
+
+
+
+//////////////////////////////
+//
+// HumSubtokenIterator::operator== -- Iterators are equal if they are at
+//     the same position (all end iterators are equal).
+//
+
+bool HumSubtokenIterator::operator==(const HumSubtokenIterator& other) const {
+	return m_start == other.m_start;
+}
+
+
+bool HumSubtokenIterator::operator!=(const HumSubtokenIterator& other) const {
+	return m_start != other.m_start;
+}
+
+
+
+//////////////////////////////
+//
+// HumSubtokenIterator::findEnd -- Find the end of the current subtoken.
+//
+
+void HumSubtokenIterator::findEnd(void) {
+	if (m_separator->empty()) {
+		m_end = m_start + 1;
+		return;
+	}
+	m_end = m_text->find(*m_separator, m_start);
+	if (m_end == string::npos) {
+		m_end = m_text->size();
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumSubtokenRange::HumSubtokenRange -- The separator is copied so that
+//     the range can be used with a temporary separator string.
+//
+
+HumSubtokenRange::HumSubtokenRange(const string& text, const string& separator) {
+	m_text = &text;
+	m_separator = separator;
+}
+
+
+
+//////////////////////////////
+//
+// HumSubtokenRange::begin --
+//
+
+HumSubtokenIterator HumSubtokenRange::begin(void) const {
+	return HumSubtokenIterator(*m_text, m_separator);
+}
+
+
+
+//////////////////////////////
+//
+// HumSubtokenRange::end --
+//
+
+HumSubtokenIterator HumSubtokenRange::end(void) const {
+	return HumSubtokenIterator();
 }
 
 
@@ -38698,7 +43634,45 @@ void HumdrumToken::setParameters(const string& pdata, HumdrumToken* ptok) {
 //
 
 void HumdrumToken::setText(const string& text) {
+	bool exinterp = compare(0, 2, "**") == 0;
+	bool global = compare(0, 2, "!!") == 0;
 	string::assign(text);
+	clearSubtokenStarts();
+	if (exinterp || (compare(0, 2, "**") == 0)) {
+		updateDataType();
+	}
+	if (global || (compare(0, 2, "!!") == 0)) {
+		// The token may have become (or stopped being) a reference record.
+		HLp line = getOwner();
+		if (line && line->getOwner()) {
+			line->getOwner()->clearReferenceRecords();
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumToken::updateDataType -- If the token is the starting exclusive
+//     interpretation of a track, update the data type ID of the track
+//     after the text of the token has been changed.
+//
+
+void HumdrumToken::updateDataType(void) {
+	HLp line = getOwner();
+	if (line == NULL) {
+		return;
+	}
+	int track = getTrack();
+	if (line->getTrackStart(track) != this) {
+		return;
+	}
+	HumdrumFile* infile = line->getOwner();
+	if (infile == NULL) {
+		return;
+	}
+	infile->updateTrackDataType(track);
 }
 
 
@@ -39344,7 +44318,7 @@ int  HumdrumToken::getStrandIndex(void) const {
 //
 
 int HumdrumToken::getBeamStartElisionLevel(int index) const {
-	if (isDataType("**kern") || isDataType("**mens")) {
+	if (isKern() || isMens()) {
 		return Convert::getKernBeamStartElisionLevel((string)(*this), index);
 	} else {
 		return -1;
@@ -39362,7 +44336,7 @@ int HumdrumToken::getBeamStartElisionLevel(int index) const {
 //
 
 int HumdrumToken::getSlurStartElisionLevel(int index) const {
-	if (isDataType("**kern") || isDataType("**mens")) {
+	if (isKern() || isMens()) {
 		return Convert::getKernSlurStartElisionLevel((string)(*this), index);
 	} else {
 		return -1;
@@ -39380,7 +44354,7 @@ int HumdrumToken::getSlurStartElisionLevel(int index) const {
 //
 
 int HumdrumToken::getPhraseStartElisionLevel(int index) const {
-	if (isDataType("**kern") || isDataType("**mens")) {
+	if (isKern() || isMens()) {
 		return Convert::getKernPhraseStartElisionLevel((string)(*this), index);
 	} else {
 		return -1;
@@ -39398,7 +44372,7 @@ int HumdrumToken::getPhraseStartElisionLevel(int index) const {
 //
 
 int HumdrumToken::getBeamEndElisionLevel(int index) const {
-	if (isDataType("**kern") || isDataType("**mens")) {
+	if (isKern() || isMens()) {
 		return Convert::getKernBeamEndElisionLevel((string)(*this), index);
 	} else {
 		return -1;
@@ -39416,7 +44390,7 @@ int HumdrumToken::getBeamEndElisionLevel(int index) const {
 //
 
 int HumdrumToken::getSlurEndElisionLevel(int index) const {
-	if (isDataType("**kern") || isDataType("**mens")) {
+	if (isKern() || isMens()) {
 		return Convert::getKernSlurEndElisionLevel((string)(*this), index);
 	} else {
 		return -1;
@@ -39434,7 +44408,7 @@ int HumdrumToken::getSlurEndElisionLevel(int index) const {
 //
 
 int HumdrumToken::getPhraseEndElisionLevel(int index) const {
-	if (isDataType("**kern")) {
+	if (isKern()) {
 		return Convert::getKernPhraseEndElisionLevel((string)(*this), index);
 	} else {
 		return -1;
@@ -39655,7 +44629,7 @@ ostream& HumdrumToken::printXmlBaseInfo(ostream& out, int level,
 	out << "</tokenType>\n";
 
 	// <tokenFunction>
-	if (isDataType("**kern")) {
+	if (isKern()) {
 		if (isNote()) {
 			out << Convert::repeatString(indent, level) << "<tokenFunction>";
 			out << "note" << "</tokenFunction>\n";
@@ -53856,17 +58830,19 @@ bool NoteGrid::load(HumdrumFile& infile) {
 	vector<HTp> current;
 	HumRegex hre;
 	for (int i=0; i<infile.getLineCount(); i++) {
+		const vector<int>& kernfields = infile.getKernFieldIndexes(i);
 		if (infile[i].isInterpretation()) {
-			for (int j=0; j<infile[i].getFieldCount(); j++) {
-				if (!infile[i].token(j)->isKern()) {
+			for (int j : kernfields) {
+				HTp token = infile.token(i, j);
+				if (token->find("*M") == string::npos) {
 					continue;
 				}
-				track = infile.token(i, j)->getTrack();
-				if (hre.search(*infile.token(i, j), "\\*M(\\d+)/(\\d+)%(\\d+)")) {
+				track = token->getTrack();
+				if (hre.search(*token, "\\*M(\\d+)/(\\d+)%(\\d+)")) {
 					metertops[track] = hre.getMatchInt(1);
 					meterbots[track] = hre.getMatchInt(2);
 					meterbots[track] /= hre.getMatchInt(3);
-				} else if (hre.search(*infile.token(i, j), "\\*M(\\d+)/(\\d+)")) {
+				} else if (hre.search(*token, "\\*M(\\d+)/(\\d+)")) {
 					metertops[track] = hre.getMatchInt(1);
 					meterbots[track] = hre.getMatchInt(2);
 				} else {
@@ -53878,24 +58854,15 @@ bool NoteGrid::load(HumdrumFile& infile) {
 		if (!infile[i].isData()) {
 			continue;
 		}
-		track = 0;
-		//attack = 0;
 		current.clear();
-		for (int j=0; j<infile[i].getFieldCount(); j++) {
-			lasttrack = track;
+		for (int j : kernfields) {
 			track = infile.token(i, j)->getTrack();
-			if (!infile[i].token(j)->isDataType("**kern")) {
-				continue;
-			}
+			lasttrack = j > 0 ? infile.token(i, j-1)->getTrack() : 0;
 			if (track == lasttrack) {
 				// secondary voice: ignore
 				continue;
 			}
 			current.push_back(infile.token(i, j));
-			if (!(current.back()->isRest()
-					|| current.back()->isSecondaryTiedNote())) {
-				//attack++;
-			}
 		}
 		if (current.size() != kernspines.size()) {
 			cerr << "Error: Unequal vector sizes " << current.size()
@@ -60267,6 +65234,18 @@ Tool_autobeam::Tool_autobeam(void) {
 
 
 
+//////////////////////////////
+//
+// Tool_autobeam::isReusable -- Instances can be run on several files.
+//     Time signatures and track lists are recalculated for each file.
+//
+
+bool Tool_autobeam::isReusable(void) {
+	return true;
+}
+
+
+
 /////////////////////////////////
 //
 // Tool_autobeam::run -- Primary interfaces to the tool.
@@ -68365,6 +73344,7 @@ Tool_cint::Tool_cint(void) {
 	define("search=s:",                           "search string");
 	define("mark=b",                              "mark matches notes from searches in data");
 	define("count=b",                             "count matched modules from search query");
+	define("stats|statistics=b",                  "only print JSON summary of module counts for all inputs");
 	define("debug=b",                             "determine bad input line number");
 	define("author=b",                            "author of the program");
 	define("version=b",                           "complation info");
@@ -68420,7 +73400,7 @@ bool Tool_cint::run(HumdrumFile& infile) {
 	processFile(infile);
 
 
-	if (hasAnyText()) {
+	if (hasAnyText() || statsQ) {
 		// getAllText(cout);
 	} else {
 		// Re-load the text for each line from their tokens.
@@ -68431,6 +73411,34 @@ bool Tool_cint::run(HumdrumFile& infile) {
 }
 
 
+
+//////////////////////////////
+//
+// Tool_cint::finally -- Print the JSON summary of the module counts
+//     when using --stats.
+//
+
+void Tool_cint::finally(void) {
+	if (!statsQ) {
+		return;
+	}
+	m_stats.printJson(m_free_text, "cint");
+}
+
+
+
+//////////////////////////////
+//
+// Tool_cint::getStatistics -- Return the module counts collected with
+//     --stats.  Counts from tool objects used in separate threads can be
+//     combined with HumStatistics::merge().
+//
+
+HumStatistics& Tool_cint::getStatistics(void) {
+	return m_stats;
+}
+
+
 ///////////////////////////////////////////////////////////////////////////
 //
 // NoteNode class functions:
@@ -68551,8 +73559,15 @@ int Tool_cint::processFile(HumdrumFile& infile) {
 		exit(0);
 	}
 
+	if (statsQ) {
+		m_stats.addFile();
+	}
+
 	int count = 0;
-	if (latticeQ) {
+	if (statsQ && !suspensionsQ) {
+		count = printCombinations(notes, infile, ktracks, reverselookup,
+				Chaincount, retrospective, SearchString);
+	} else if (latticeQ) {
 		printLattice(notes, infile, ktracks, reverselookup, Chaincount);
 	} else if (interleavedQ) {
 		printLatticeInterleaved(notes, infile, ktracks, reverselookup,
@@ -68951,7 +73966,18 @@ int Tool_cint::printCombinationModulePrepare(ostream& out, const string& filenam
 // ggg
 	int status = printCombinationModule(tempstream, filename, notes,
 			n, startline, part1, part2, retrospective, notemarker);
-	if (status) {
+	if (status && statsQ) {
+		string module = tempstream.str();
+		if (!suspensionsQ) {
+			m_stats.increment("modules", module);
+			m_stats.increment("summary", "modules");
+		}
+		if (searchQ && hre.search(module, searchstring)) {
+			count++;
+			m_stats.increment("matches", module);
+			m_stats.increment("summary", "matches");
+		}
+	} else if (status) {
 		if (raw2Q || rawQ) {
 			tempstream << "\n";
 		}
@@ -70991,6 +76017,17 @@ void Tool_cint::initialize(void) {
 		SearchString = getString("search");
 	}
 
+	statsQ = getBoolean("stats");
+	if (statsQ) {
+		// Only collect counts: suppress all score and module output.
+		countQ    = 1;
+		markQ     = 0;
+		retroQ    = 0;
+		locationQ = 0;
+		debugQ    = 0;
+		pitchesQ  = 0;
+	}
+
 }
 
 
@@ -71279,16 +76316,8 @@ bool cmr_note_info::isLeapBefore(HTp token) {
 //
 
 double cmr_note_info::getMetricLevel(HTp token) {
-	HumNum beat = token->getDurationFromBarline();
-	if (!beat.isInteger()) { // anything less than quarter note level
-		return -1;
-	} else if (beat.getNumerator() % 4 == 0) { // whole note level
-		return 2;
-	} else if (beat.getNumerator() % 2 == 0) { // half note level
-		return 1;
-	} else { // quarter note level
-		return 0;
-	}
+	HumdrumFile& infile = *token->getOwner()->getOwner();
+	return infile.getMetricPosition(token->getLineIndex()).weight;
 }
 
 
@@ -83698,6 +88727,7 @@ Tool_dissonant::Tool_dissonant(void) {
 	define("i|x|e|exinterp=s:**cdata-rdiss", "specify exinterp for **diss spines");
 	define("color|colorize|color-by-rhythm=b",        "color dissonant notes by beat level");
 	define("color2|colorize2|color-by-interval=b",    "color dissonant notes by dissonant interval");
+	define("stats|statistics=b",             "only print JSON summary of dissonance counts for all inputs");
 }
 
 
@@ -83754,6 +88784,8 @@ bool Tool_dissonant::run(HumdrumFile& infile, ostream& out) {
 
 bool Tool_dissonant::run(HumdrumFile& infile) {
 
+	m_statsQ = getBoolean("stats");
+
 	if (getBoolean("voice-number")) {
 		m_voicenumQ = true;
 	}
@@ -83800,8 +88832,8 @@ bool Tool_dissonant::run(HumdrumFile& infile) {
 	suppressQ = getBoolean("suppress");
 	voiceFuncsQ = getBoolean("voice-functions");
 
-	vector<vector<string>> results;
-	vector<vector<string>> results2;
+	vector<vector<int>> results;
+	vector<vector<int>> results2;
 	vector<vector<string>> voiceFuncs;
 	vector<vector<NoteCell*>> attacks;
 	vector<vector<NoteCell*>> attacks2;
@@ -83809,7 +88841,7 @@ bool Tool_dissonant::run(HumdrumFile& infile) {
 	attacks.resize(grid.getVoiceCount());
 	results.resize(grid.getVoiceCount());
 	for (int i=0; i<(int)results.size(); i++) {
-		results[i].resize(infile.getLineCount());
+		results[i].resize(infile.getLineCount(), NO_LABEL);
 	}
 	doAnalysis(results, grid, attacks, getBoolean("debug"));
 
@@ -83825,7 +88857,7 @@ bool Tool_dissonant::run(HumdrumFile& infile) {
 		results2.resize(grid2.getVoiceCount());
 		for (int i=0; i<(int)results2.size(); i++) {
 			results2[i].clear();
-			results2[i].resize(infile.getLineCount());
+			results2[i].resize(infile.getLineCount(), NO_LABEL);
 		}
 		vector<vector<NoteCell*>> attacks2;
 		doAnalysis(results2, grid2, attacks2, getBoolean("debug"));
@@ -83833,16 +88865,19 @@ bool Tool_dissonant::run(HumdrumFile& infile) {
 	}
 
 	if (suppressQ) {
-		if (getBoolean("count")) {
+		if (m_statsQ) {
+			addStatistics(results2);
+			return true;
+		} else if (getBoolean("count")) {
 			printCountAnalysis(results2);
 			return false;
 		} else {
 			string exinterp = getString("exinterp");
 			vector<HTp> kernspines = infile.getKernSpineStartList();
-			infile.appendDataSpine(results2.back(), "", exinterp);
+			infile.appendDataSpine(getLabelStrings(results2.back()), "", exinterp);
 			for (int i = (int)results2.size()-1; i>0; i--) {
 				int track = kernspines[i]->getTrack();
-				infile.insertDataSpineBefore(track, results2[i-1], "", exinterp);
+				infile.insertDataSpineBefore(track, getLabelStrings(results2[i-1]), "", exinterp);
 			}
 			printColorLegend(infile);
 
@@ -83864,6 +88899,10 @@ bool Tool_dissonant::run(HumdrumFile& infile) {
 		for (int i=0; i<grid.getVoiceCount(); i++) {
 			findCadentialVoiceFunctions(results, grid, attacks[i], voiceFuncs, i);
 		}
+		if (m_statsQ) {
+			addStatistics(voiceFuncs);
+			return true;
+		}
 
 		string exinterp = getString("exinterp");
 		vector<HTp> kernspines = infile.getKernSpineStartList();
@@ -83880,16 +88919,19 @@ bool Tool_dissonant::run(HumdrumFile& infile) {
 		infile.createLinesFromTokens();
 		return true;
 	} else {
-		if (getBoolean("count")) {
+		if (m_statsQ) {
+			addStatistics(results);
+			return true;
+		} else if (getBoolean("count")) {
 			printCountAnalysis(results);
 			return false;
 		} else {
 			string exinterp = getString("exinterp");
 			vector<HTp> kernspines = infile.getKernSpineStartList();
-			infile.appendDataSpine(results.back(), "", exinterp);
+			infile.appendDataSpine(getLabelStrings(results.back()), "", exinterp);
 			for (int i = (int)results.size()-1; i>0; i--) {
 				int track = kernspines[i]->getTrack();
-				infile.insertDataSpineBefore(track, results[i-1], "", exinterp);
+				infile.insertDataSpineBefore(track, getLabelStrings(results[i-1]), "", exinterp);
 			}
 			printColorLegend(infile);
 			adjustColorization(infile);
@@ -83901,6 +88943,34 @@ bool Tool_dissonant::run(HumdrumFile& infile) {
 
 
 
+//////////////////////////////
+//
+// Tool_dissonant::finally -- Print the JSON summary of the dissonance
+//     counts when using --stats.
+//
+
+void Tool_dissonant::finally(void) {
+	if (!m_statsQ) {
+		return;
+	}
+	m_stats.printJson(m_free_text, "dissonant");
+}
+
+
+
+//////////////////////////////
+//
+// Tool_dissonant::getStatistics -- Return the dissonance counts collected
+//     with --stats.  Counts from tool objects used in separate threads
+//     can be combined with HumStatistics::merge().
+//
+
+HumStatistics& Tool_dissonant::getStatistics(void) {
+	return m_stats;
+}
+
+
+
 /////////////////////////////
 //
 // Tool_dissonant::adjustColorization -- The dissonance analysis will color the
@@ -84154,7 +89224,7 @@ void Tool_dissonant::addLabelToSuspensions(HTp disslabel, const string& marker)
 //
 
 void Tool_dissonant::suppressDissonances(HumdrumFile& infile, NoteGrid& grid,
-		vector<vector<NoteCell*>>& attacks, vector<vector<string>>& results) {
+		vector<vector<NoteCell*>>& attacks, vector<vector<int>>& results) {
 
 	// Loop over the dissonance results one full row at a time. The point of doing it
 	// one row at a time instead of one voice at a time is so that a weak dissonance in
@@ -84192,30 +89262,30 @@ void Tool_dissonant::suppressDissonances(HumdrumFile& infile, NoteGrid& grid,
 				continue;
 			}
 			int v = kernTrackToVoiceIndex.at(token->getTrack());
-			if (results[v][i].empty() || (results[v][i] == ".")) {
+			if ((results[v][i] == NO_LABEL) || (results[v][i] == NULL_LABEL)) {
 				continue;
 			}
 			// cerr << "\tCHECKING DISSONANCE " << results[v][i] << " for note " << token << endl;
 			HumNum notedur = token->getTiedDuration();
 
-			if ((results[v][i] == m_labels[PASSING_DOWN]) ||
-					(results[v][i] == m_labels[PASSING_UP]) ||
-					(results[v][i] == m_labels[NEIGHBOR_DOWN]) ||
-					(results[v][i] == m_labels[NEIGHBOR_UP]) ||
-					(results[v][i] == m_labels[CAMBIATA_DOWN_S]) ||
-					(results[v][i] == m_labels[CAMBIATA_UP_S]) ||
-					(results[v][i] == m_labels[CAMBIATA_DOWN_L]) ||
-					(results[v][i] == m_labels[CAMBIATA_UP_L]) ||
-					(results[v][i] == m_labels[ECHAPPEE_DOWN]) ||
-					(results[v][i] == m_labels[ECHAPPEE_UP]) ||
-					(results[v][i] == m_labels[ANT_DOWN]) ||
-					(results[v][i] == m_labels[ANT_UP]) ||
-					(results[v][i] == m_labels[REV_ECHAPPEE_DOWN]) ||
-					(results[v][i] == m_labels[REV_ECHAPPEE_UP]) ||
-					(results[v][i] == m_labels[REV_CAMBIATA_DOWN]) ||
-					(results[v][i] == m_labels[REV_CAMBIATA_UP]) ||
-					(results[v][i] == m_labels[DBL_NEIGHBOR_DOWN]) ||
-					(results[v][i] == m_labels[DBL_NEIGHBOR_UP]) ) {
+			if ((isLabel(results[v][i], PASSING_DOWN)) ||
+					(isLabel(results[v][i], PASSING_UP)) ||
+					(isLabel(results[v][i], NEIGHBOR_DOWN)) ||
+					(isLabel(results[v][i], NEIGHBOR_UP)) ||
+					(isLabel(results[v][i], CAMBIATA_DOWN_S)) ||
+					(isLabel(results[v][i], CAMBIATA_UP_S)) ||
+					(isLabel(results[v][i], CAMBIATA_DOWN_L)) ||
+					(isLabel(results[v][i], CAMBIATA_UP_L)) ||
+					(isLabel(results[v][i], ECHAPPEE_DOWN)) ||
+					(isLabel(results[v][i], ECHAPPEE_UP)) ||
+					(isLabel(results[v][i], ANT_DOWN)) ||
+					(isLabel(results[v][i], ANT_UP)) ||
+					(isLabel(results[v][i], REV_ECHAPPEE_DOWN)) ||
+					(isLabel(results[v][i], REV_ECHAPPEE_UP)) ||
+					(isLabel(results[v][i], REV_CAMBIATA_DOWN)) ||
+					(isLabel(results[v][i], REV_CAMBIATA_UP)) ||
+					(isLabel(results[v][i], DBL_NEIGHBOR_DOWN)) ||
+					(isLabel(results[v][i], DBL_NEIGHBOR_UP)) ) {
 				if (notedur > maxWeakDur) {
 					maxWeakDur = notedur;
 					maxToken = token;
@@ -84244,14 +89314,14 @@ void Tool_dissonant::suppressDissonances(HumdrumFile& infile, NoteGrid& grid,
 				continue;
 			}
 			int v = kernTrackToVoiceIndex.at(token->getTrack());
-			if (results[v][i].empty() || (results[v][i] == ".")) {
+			if ((results[v][i] == NO_LABEL) || (results[v][i] == NULL_LABEL)) {
 				continue;
 			}
 			HumNum notedur = token->getTiedDuration();
-			if ((results[v][i] == m_labels[SUS_BIN]) ||
-					(results[v][i] == m_labels[SUS_TERN]) ||
-					(results[v][i] == m_labels[AGENT_BIN]) ||
-					(results[v][i] == m_labels[AGENT_TERN])) {
+			if ((isLabel(results[v][i], SUS_BIN)) ||
+					(isLabel(results[v][i], SUS_TERN)) ||
+					(isLabel(results[v][i], AGENT_BIN)) ||
+					(isLabel(results[v][i], AGENT_TERN))) {
 				continue;
 			} else if (notedur <= maxWeakDur) {
 				mergeWithPreviousNote(infile, i, j);
@@ -84277,12 +89347,12 @@ void Tool_dissonant::suppressDissonances(HumdrumFile& infile, NoteGrid& grid,
 
 void Tool_dissonant::suppressDissonancesInVoice(HumdrumFile& infile,
 		NoteGrid& grid, int vindex, vector<NoteCell*>& attacks,
-		vector<string>& results) {
+		vector<int>& results) {
 
 	for (int i=0; i<(int)attacks.size(); i++) {
 		int lineindex = attacks[i]->getLineIndex();
 		int fieldindex = attacks[i]->getFieldIndex();
-		if ((results[lineindex] == "") || (results[lineindex] == ".") ) {
+		if ((results[lineindex] == NO_LABEL) || (results[lineindex] == NULL_LABEL) ) {
 			continue;
 		}
 
@@ -84296,21 +89366,21 @@ void Tool_dissonant::suppressDissonancesInVoice(HumdrumFile& infile,
 			continue;
 		}
 
-		if ((results[lineindex] == m_labels[THIRD_Q_PASS_UP]) ||
-			(results[lineindex] == m_labels[THIRD_Q_PASS_DOWN]) ||
-			(results[lineindex] == m_labels[THIRD_Q_LOWER_NEI]) ||
-			(results[lineindex] == m_labels[THIRD_Q_UPPER_NEI]) ||
-			(results[lineindex] == m_labels[ACC_PASSING_UP]) ||
-			(results[lineindex] == m_labels[ACC_PASSING_DOWN]) ||
-			(results[lineindex] == m_labels[ACC_LO_NEI]) ||
-			(results[lineindex] == m_labels[ACC_UP_NEI]) ||
-			(results[lineindex] == m_labels[RES_PITCH]) ||
-			(results[lineindex] == m_labels[APP_UPPER]) ||
-			(results[lineindex] == m_labels[APP_LOWER]) ||
-			(results[lineindex] == m_labels[PARALLEL_DOWN]) ||
-			(results[lineindex] == m_labels[PARALLEL_UP]) ||
-			(results[lineindex] == m_labels[ORNAMENTAL_SUS]) ||
-			(results[lineindex] == m_labels[CHANSON_IDIOM]) ) {
+		if ((isLabel(results[lineindex], THIRD_Q_PASS_UP)) ||
+			(isLabel(results[lineindex], THIRD_Q_PASS_DOWN)) ||
+			(isLabel(results[lineindex], THIRD_Q_LOWER_NEI)) ||
+			(isLabel(results[lineindex], THIRD_Q_UPPER_NEI)) ||
+			(isLabel(results[lineindex], ACC_PASSING_UP)) ||
+			(isLabel(results[lineindex], ACC_PASSING_DOWN)) ||
+			(isLabel(results[lineindex], ACC_LO_NEI)) ||
+			(isLabel(results[lineindex], ACC_UP_NEI)) ||
+			(isLabel(results[lineindex], RES_PITCH)) ||
+			(isLabel(results[lineindex], APP_UPPER)) ||
+			(isLabel(results[lineindex], APP_LOWER)) ||
+			(isLabel(results[lineindex], PARALLEL_DOWN)) ||
+			(isLabel(results[lineindex], PARALLEL_UP)) ||
+			(isLabel(results[lineindex], ORNAMENTAL_SUS)) ||
+			(isLabel(results[lineindex], CHANSON_IDIOM)) ) {
 			// cerr << "MERGING " << token << " with next note" << endl;
 			mergeWithNextNote(infile, lineindex, fieldindex);
 		}
@@ -84326,12 +89396,12 @@ void Tool_dissonant::suppressDissonancesInVoice(HumdrumFile& infile,
 
 void Tool_dissonant::suppressSusOrnamentsInVoice(HumdrumFile& infile,
 		NoteGrid& grid, int vindex, vector<NoteCell*>& attacks,
-		vector<string>& results) {
+		vector<int>& results) {
 
 	for (int i=0; i<(int)attacks.size(); i++) {
 		int lineindex = attacks[i]->getLineIndex();
 		int fieldindex = attacks[i]->getFieldIndex();
-		if ((results[lineindex] == "") || (results[lineindex] == ".") ) {
+		if ((results[lineindex] == NO_LABEL) || (results[lineindex] == NULL_LABEL) ) {
 			continue;
 		}
 
@@ -84345,8 +89415,8 @@ void Tool_dissonant::suppressSusOrnamentsInVoice(HumdrumFile& infile,
 			continue;
 		}
 
-		if (((results[lineindex] == m_labels[SUS_BIN]) ||
-			 (results[lineindex] == m_labels[SUS_TERN])) &&
+		if (((isLabel(results[lineindex], SUS_BIN)) ||
+			 (isLabel(results[lineindex], SUS_TERN))) &&
 			(i < ((int)attacks.size() - 3)) ) {
 			HumNum durn   = attacks[i+1]->getDuration();
 			HumNum durnn  = attacks[i+2]->getDuration();
@@ -84366,23 +89436,23 @@ void Tool_dissonant::suppressSusOrnamentsInVoice(HumdrumFile& infile,
 
 			if ((durn == durnn) && (durn < durnnn) && (levn > levnnn) &&
 				(intn == -1) && (intnn == -1) && (intnnn == 1) ) { // turn figure anticipation of resolution phase
-				if ((results[lineindexnn] == ".") && (!tokennn->isNull()) &&
+				if ((results[lineindexnn] == NULL_LABEL) && (!tokennn->isNull()) &&
 					(tokennn->isNoteAttack()) ) {
 					mergeWithPreviousNote(infile, lineindexnn, vindex);
 				}
-				if ((results[lineindexn] == ".") && (!tokenn->isNull()) &&
+				if ((results[lineindexn] == NULL_LABEL) && (!tokenn->isNull()) &&
 					(tokenn->isNoteAttack()) ) {
 					mergeWithPreviousNote(infile, lineindexn, vindex);
 				}
 			} else if ((durn == durnn) && (durn == durnnn) && (levn > levnn) &&
 				(levnn < levnnn) && (intn == -1) && (intnn == 0) &&
-				(intnnn == -1) && (results[lineindexnnn] == ".") &&
+				(intnnn == -1) && (results[lineindexnnn] == NULL_LABEL) &&
 				(!tokennnn->isNull()) && (tokennnn->isNoteAttack()) ) { // Du Fay ornament
 				mergeWithPreviousNote(infile, lineindexnnn, vindex);
 			}
 		}
-		if (((results[lineindex] == m_labels[SUS_BIN]) ||
-			 (results[lineindex] == m_labels[SUS_TERN])) &&
+		if (((isLabel(results[lineindex], SUS_BIN)) ||
+			 (isLabel(results[lineindex], SUS_TERN))) &&
 			(i < ((int)attacks.size() - 2)) ) {
 			HumNum durn  = attacks[i+1]->getDuration();
 			HumNum durnn = attacks[i+2]->getDuration();
@@ -84394,7 +89464,7 @@ void Tool_dissonant::suppressSusOrnamentsInVoice(HumdrumFile& infile,
 			HTp tokenn = infile.token(lineindexn, fieldindex);
 
 			if ((durn <= durnn) && (levn >= levnn) && (intn == -1) &&
-				(intnn == 0) && (results[lineindexn] == ".") &&
+				(intnn == 0) && (results[lineindexn] == NULL_LABEL) &&
 				(!tokenn->isNull()) && (tokenn->isNoteAttack()) ) { // anticipation of resolution phase
 				mergeWithPreviousNote(infile, lineindexn, vindex);
 			}
@@ -84825,7 +89895,7 @@ void Tool_dissonant::printColorLegend(HumdrumFile& infile) {
 // Tool_dissonant::doAnalysis -- do a basic melodic analysis of all parts.
 //
 
-void Tool_dissonant::doAnalysis(vector<vector<string>>& results,
+void Tool_dissonant::doAnalysis(vector<vector<int>>& results,
 		NoteGrid& grid, vector<vector<NoteCell*>>& attacks, bool debug) {
 	attacks.resize(grid.getVoiceCount());
 
@@ -84859,7 +89929,7 @@ void Tool_dissonant::doAnalysis(vector<vector<string>>& results,
 //     subtracting NoteCells to calculate the diatonic intervals.
 //
 
-void Tool_dissonant::doAnalysisForVoice(vector<vector<string>>& results,
+void Tool_dissonant::doAnalysisForVoice(vector<vector<int>>& results,
 		NoteGrid& grid, vector<NoteCell*>& attacks, int vindex, bool debug) {
 	attacks.clear();
 	grid.getNoteAndRestAttacks(attacks, vindex);
@@ -84874,8 +89944,8 @@ void Tool_dissonant::doAnalysisForVoice(vector<vector<string>>& results,
 		}
 	}
 	bool nodissonanceQ = getBoolean("no-dissonant");
-	bool colorizeQ = getBoolean("colorize");
-	bool colorize2Q = getBoolean("colorize2");
+	bool colorizeQ = getBoolean("colorize") && !m_statsQ;
+	bool colorize2Q = getBoolean("colorize2") && !m_statsQ;
 
 	HumNum durpp = -1; // duration of previous previous note
 	HumNum durp;       // duration of previous melodic note
@@ -84899,7 +89969,7 @@ void Tool_dissonant::doAnalysisForVoice(vector<vector<string>>& results,
 	bool dissonant;    // true if  note is dissonant with other sounding notes.
 	char marking = '\0';
 	int ovoiceindex = -1;
-	string unexp_label; // default dissonance label if none of the diss types apply
+	int unexp_label = NO_LABEL; // default dissonance label if none of the diss types apply
 	int refMeterNum;    // the numerator of the reference voice's notated time signature
 	HumNum refMeterDen; // the denominator of the reference voice's notated time signature
 	int othMeterNum;    // the numerator of the other voice's notated time signature
@@ -84973,7 +90043,7 @@ RECONSIDER:
 				dissonant = true;
 				diss2Q = true;
 				marking = '@';
-				unexp_label = m_labels[UNLABELED_Z2];
+				unexp_label = UNLABELED_Z2;
 				ovoiceindex = j;
 				oattackindexn = getNextPitchAttackIndex(grid, ovoiceindex, sliceindex);
 				break;
@@ -84982,7 +90052,7 @@ RECONSIDER:
 				dissonant = true;
 				diss7Q = true;
 				marking = '+';
-				unexp_label = m_labels[UNLABELED_Z7];
+				unexp_label = UNLABELED_Z7;
 				ovoiceindex = j;
 				oattackindexn = getNextPitchAttackIndex(grid, ovoiceindex, sliceindex);
 				break;
@@ -84998,7 +90068,7 @@ RECONSIDER:
 				dissonant = true;
 				diss4Q = true;
 				marking = 'N';
-				unexp_label = m_labels[UNLABELED_Z4];
+				unexp_label = UNLABELED_Z4;
 				// ovoiceindex = lowestnotei;
 				ovoiceindex = j;
 				// oattackindexn = grid.cell(ovoiceindex, sliceindex)->getNextAttackIndex();
@@ -85018,7 +90088,7 @@ RECONSIDER:
 				marking = 'N';
 				ovoiceindex = lowestnotei;
 				oattackindexn = grid.cell(ovoiceindex, sliceindex)->getNextAttackIndex();
-				unexp_label = m_labels[UNLABELED_Z4];
+				unexp_label = UNLABELED_Z4;
 			}
 		}
 */
@@ -85176,10 +90246,10 @@ RECONSIDER:
 
 		ternAgent = false;
 		if (((othMeterNum % 3 == 0) && (odur >= othMeterDen)) && // the durational value of the meter's denominator groups in threes and the sus lasts at least as long as the denominator
-			(results[ovoiceindex][lineindex] != m_labels[SUS_BIN]) && // the other voice hasn't already been labeled as a binary suspension
+			(!isLabel(results[ovoiceindex][lineindex], SUS_BIN)) && // the other voice hasn't already been labeled as a binary suspension
 			((dur == othMeterDen*2) || // the ref note lasts 2 times as long as the meter's denominator
 			 ((dur == othMeterDen*threehalves) && ((intn == 0) || (intn == -1))) || // ref note lasts 1.5 times the meter's denominator and next note is a tenorizans ornament
-			 ((dur == othMeterDen*threehalves) && ((unexp_label == m_labels[UNLABELED_Z4]) || (intn == 3))) || // 4-3 susp where agent leaps to diatonic pitch class of resolution
+			 ((dur == othMeterDen*threehalves) && (isLabel(unexp_label, UNLABELED_Z4) || (intn == 3))) || // 4-3 susp where agent leaps to diatonic pitch class of resolution
 			 ((dur == sixteenthirds) && (refMeterNum == 3) && (refMeterDen == threehalves)) || // special case for 3/3 time signature
 			 ((odur == othMeterDen*threehalves) && (ointn == -1) && (odurn == 2) && (ointnn == 0)) || // change of agent suspension with ant of resolution
 			 ((dur == othMeterDen) && (odur == othMeterDen*2)) || // unornamented change of agent suspension
@@ -85198,63 +90268,63 @@ RECONSIDER:
 			(dur <= durp) && (condition2 || condition2b) && valid_acc_exit) { // weak dissonances
 			if (intp == -1) { // descending dissonances
 				if (intn == -1) { // downward passing tone
-					results[vindex][lineindex] = m_labels[PASSING_DOWN];
+					results[vindex][lineindex] = PASSING_DOWN;
 				} else if (intn == 1) { // lower neighbor
-					results[vindex][lineindex] = m_labels[NEIGHBOR_DOWN];
+					results[vindex][lineindex] = NEIGHBOR_DOWN;
 				} else if ((intn == 0) && (dur <= 2)) { // descending anticipation
-					results[vindex][lineindex] = m_labels[ANT_DOWN];
+					results[vindex][lineindex] = ANT_DOWN;
 				} else if (intn > 1) { // lower échappée
-					results[vindex][lineindex] = m_labels[ECHAPPEE_DOWN];
+					results[vindex][lineindex] = ECHAPPEE_DOWN;
 				} else if (intn < -1) { // descending short nota cambiata
-					results[vindex][lineindex] = m_labels[CAMBIATA_DOWN_S];
+					results[vindex][lineindex] = CAMBIATA_DOWN_S;
 				}
 			} else if (intp == 1) { // ascending dissonances
 				if (intn == 1) { // rising passing tone
-					results[vindex][lineindex] = m_labels[PASSING_UP];
+					results[vindex][lineindex] = PASSING_UP;
 				} else if (intn == -1) { // upper neighbor
-					results[vindex][lineindex] = m_labels[NEIGHBOR_UP];
+					results[vindex][lineindex] = NEIGHBOR_UP;
 				} else if (intn < -1) { // upper échappée
-					results[vindex][lineindex] = m_labels[ECHAPPEE_UP];
+					results[vindex][lineindex] = ECHAPPEE_UP;
 				} else if ((intn == 0) && (dur <= 2)) { // rising anticipation
-					results[vindex][lineindex] = m_labels[ANT_UP];
+					results[vindex][lineindex] = ANT_UP;
 				} else if (intn > 1) { // ascending short nota cambiata
-					results[vindex][lineindex] = m_labels[CAMBIATA_UP_S];
+					results[vindex][lineindex] = CAMBIATA_UP_S;
 				}
 			} else if (intp < -1) {
 				if (intn == 1) { // reverse lower échappée
-					results[vindex][lineindex] = m_labels[REV_ECHAPPEE_DOWN];
+					results[vindex][lineindex] = REV_ECHAPPEE_DOWN;
 				} else if (intn == -1) { // reverse descending nota cambiata
-					results[vindex][lineindex] = m_labels[REV_CAMBIATA_DOWN];
+					results[vindex][lineindex] = REV_CAMBIATA_DOWN;
 				}
 			} else if (intp > 1) {
 				if (intn == -1) { // reverse upper échappée
-					results[vindex][lineindex] = m_labels[REV_ECHAPPEE_UP];
+					results[vindex][lineindex] = REV_ECHAPPEE_UP;
 				} else if (intn == 1) { // reverse ascending nota cambiata
-					results[vindex][lineindex] = m_labels[REV_CAMBIATA_UP];
+					results[vindex][lineindex] = REV_CAMBIATA_UP;
 				}
 			}
 		} else if ((durp >= 2) && (dur == 1) && (lev < levn) && valid_acc_exit &&
 					 (condition2 || condition2b) && (lev == 1)) {
 			if (intp == -1) {
 				if (intn == -1) { // dissonant third quarter descending passing tone
-					results[vindex][lineindex] = m_labels[THIRD_Q_PASS_DOWN];
+					results[vindex][lineindex] = THIRD_Q_PASS_DOWN;
 				} else if (intn == 1) { // dissonant third quarter lower neighbor
-					results[vindex][lineindex] = m_labels[THIRD_Q_LOWER_NEI];
+					results[vindex][lineindex] = THIRD_Q_LOWER_NEI;
 				}
 			} else if (intp == 1) {
 				if (intn == 1) { // dissonant third quarter ascending passing tone
-					results[vindex][lineindex] = m_labels[THIRD_Q_PASS_UP];
+					results[vindex][lineindex] = THIRD_Q_PASS_UP;
 				} else if (intn == -1) { // dissonant third quarter upper neighbor
-					results[vindex][lineindex] = m_labels[THIRD_Q_UPPER_NEI];
+					results[vindex][lineindex] = THIRD_Q_UPPER_NEI;
 				}
 			}
 		} else if (((lev > levp) || (durp+durp+durp+durp == dur)) &&
 				   (lev == levn) && condition2 && (intn == -1) &&
 				   (dur == (durn+durn)) && ((dur+dur) <= odur)) {
 			if (fabs(intp) > 1.0) {
-				results[vindex][lineindex] = m_labels[SUS_NO_AGENT_LEAP];
+				results[vindex][lineindex] = SUS_NO_AGENT_LEAP;
 			} else if ((fabs(intp) == 1.0) || ((intp == 0) && (fabs(intpp) == 1.0))) {
-				results[vindex][lineindex] = m_labels[SUS_NO_AGENT_STEP];
+				results[vindex][lineindex] = SUS_NO_AGENT_STEP;
 			}
 		}
 
@@ -85265,54 +90335,54 @@ RECONSIDER:
 
 		else if (valid_sus_acc && ((ointn == -1) || ((ointn == -2) && (ointnn == 1)))) {
 			if ((durpp == 1) && (durp == 1) && (intpp == -1) && (intp == 1) &&
-					((results[vindex][lineindexpp] == m_labels[THIRD_Q_PASS_DOWN]) ||
-					(results[vindex][lineindexpp] == m_labels[ACC_PASSING_DOWN]) ||
-					(results[vindex][lineindexpp] == m_labels[UNLABELED_Z7]) ||
-					(results[vindex][lineindexpp] == m_labels[UNLABELED_Z4]))) {
-				results[vindex][lineindexpp] = m_labels[CHANSON_IDIOM];
+					((isLabel(results[vindex][lineindexpp], THIRD_Q_PASS_DOWN)) ||
+					(isLabel(results[vindex][lineindexpp], ACC_PASSING_DOWN)) ||
+					(isLabel(results[vindex][lineindexpp], UNLABELED_Z7)) ||
+					(isLabel(results[vindex][lineindexpp], UNLABELED_Z4)))) {
+				results[vindex][lineindexpp] = CHANSON_IDIOM;
 			}
 			if (ternAgent) { // ternary agent and suspension
-				results[vindex][lineindex] = m_labels[AGENT_TERN];
-				results[ovoiceindex][lineindex] = m_labels[SUS_TERN];
+				results[vindex][lineindex] = AGENT_TERN;
+				results[ovoiceindex][lineindex] = SUS_TERN;
 			} else if (((odur == .5) || (odur == 1)) && // purely ornamental suspension
 						((odurn == .5) || (odurn == 1)) &&
 						(ointn == -1) && (ointnn == -1) ) {
-				results[vindex][lineindex] = m_labels[AGENT_BIN];
-				results[ovoiceindex][lineindex] = m_labels[ORNAMENTAL_SUS];
+				results[vindex][lineindex] = AGENT_BIN;
+				results[ovoiceindex][lineindex] = ORNAMENTAL_SUS;
 			} else { // binary agent and suspension
-				results[vindex][lineindex] = m_labels[AGENT_BIN];
-				results[ovoiceindex][lineindex] = m_labels[SUS_BIN];
+				results[vindex][lineindex] = AGENT_BIN;
+				results[ovoiceindex][lineindex] = SUS_BIN;
 			}
 		} else if (valid_ornam_sus_acc && ((ointn == 0) && (ointnn == -1))) {
 			if ((durpp == 1) && (durp == 1) && (intpp == -1) && (intp == 1) &&
-					((results[vindex][lineindexpp] == m_labels[THIRD_Q_PASS_DOWN]) ||
-					(results[vindex][lineindexpp] == m_labels[ACC_PASSING_DOWN]) ||
-					(results[vindex][lineindexpp] == m_labels[UNLABELED_Z7]) ||
-					(results[vindex][lineindexpp] == m_labels[UNLABELED_Z4]))) {
-				results[vindex][lineindexpp] = m_labels[CHANSON_IDIOM];
+					((isLabel(results[vindex][lineindexpp], THIRD_Q_PASS_DOWN)) ||
+					(isLabel(results[vindex][lineindexpp], ACC_PASSING_DOWN)) ||
+					(isLabel(results[vindex][lineindexpp], UNLABELED_Z7)) ||
+					(isLabel(results[vindex][lineindexpp], UNLABELED_Z4)))) {
+				results[vindex][lineindexpp] = CHANSON_IDIOM;
 			}
 			if (ternAgent) { // ternary agent and suspension
-				results[vindex][lineindex] = m_labels[AGENT_TERN];
-				results[ovoiceindex][lineindex] = m_labels[SUS_TERN];
+				results[vindex][lineindex] = AGENT_TERN;
+				results[ovoiceindex][lineindex] = SUS_TERN;
 			} else { // binary agent and suspension
-				results[vindex][lineindex] = m_labels[AGENT_BIN];
-				results[ovoiceindex][lineindex] = m_labels[SUS_BIN];
+				results[vindex][lineindex] = AGENT_BIN;
+				results[ovoiceindex][lineindex] = SUS_BIN;
 			} // repeated-note of suspension
-			results[ovoiceindex][olineindexn] = m_labels[SUSPENSION_REP];
+			results[ovoiceindex][olineindexn] = SUSPENSION_REP;
 		} else if (valid_ornam_sus_acc && ((ointn == 1) && (ointnn == -2))) {
 			if ((durpp == 1) && (durp == 1) && (intpp == -1) && (intp == 1) &&
-					((results[vindex][lineindexpp] == m_labels[THIRD_Q_PASS_DOWN]) ||
-					(results[vindex][lineindexpp] == m_labels[ACC_PASSING_DOWN]) ||
-					(results[vindex][lineindexpp] == m_labels[UNLABELED_Z7]) ||
-					(results[vindex][lineindexpp] == m_labels[UNLABELED_Z4]))) {
-				results[vindex][lineindexpp] = m_labels[CHANSON_IDIOM];
+					((isLabel(results[vindex][lineindexpp], THIRD_Q_PASS_DOWN)) ||
+					(isLabel(results[vindex][lineindexpp], ACC_PASSING_DOWN)) ||
+					(isLabel(results[vindex][lineindexpp], UNLABELED_Z7)) ||
+					(isLabel(results[vindex][lineindexpp], UNLABELED_Z4)))) {
+				results[vindex][lineindexpp] = CHANSON_IDIOM;
 			}
 			if (ternAgent) { // ternary agent and suspension
-				results[vindex][lineindex] = m_labels[AGENT_TERN];
-				results[ovoiceindex][lineindex] = m_labels[SUS_TERN];
+				results[vindex][lineindex] = AGENT_TERN;
+				results[ovoiceindex][lineindex] = SUS_TERN;
 			} else { // binary agent and suspension
-				results[vindex][lineindex] = m_labels[AGENT_BIN];
-				results[ovoiceindex][lineindex] = m_labels[SUS_BIN];
+				results[vindex][lineindex] = AGENT_BIN;
+				results[ovoiceindex][lineindex] = SUS_BIN;
 			} // This ornament is consonant against the agent so no ornament label.
 		}
 
@@ -85326,10 +90396,10 @@ RECONSIDER:
 
 			if ((dur <= durp) && (lev >= levp) && (lev >= levn) &&
 					(intp == -1) && (intn == -2) && (intnn == 1)) { // long-form descending cambiata
-				results[vindex][lineindex] = m_labels[CAMBIATA_DOWN_L];
+				results[vindex][lineindex] = CAMBIATA_DOWN_L;
 			} else if ((dur <= durp) && (lev >= levp) && (lev >= levn) &&
 					(intp == 1) && (intn == 2) && (intnn == -1)) { // long-form ascending nota cambiata
-				results[vindex][lineindex] = m_labels[CAMBIATA_UP_L];
+				results[vindex][lineindex] = CAMBIATA_UP_L;
 			}
 		}
 
@@ -85340,7 +90410,7 @@ RECONSIDER:
 		bool refLeaptFrom = fabs(intn) > 1 ? true : false;
 		bool othLeaptFrom = fabs(ointn) > 1 ? true : false;
 
-		if ((results[vindex][lineindex] == "") && // this voice doesn't already have a dissonance label
+		if ((results[vindex][lineindex] == NO_LABEL) && // this voice doesn't already have a dissonance label
 				((olineindexc < lineindex) || // other voice does not attack at this point
 				((olineindexc == lineindex) && (dur < odur)) || // both voices attack together, but ref voice leaves dissonance first
 				(((olineindexc == lineindex) && (dur == odur)) && // both voices enter and leave dissonance simultaneously
@@ -85358,10 +90428,10 @@ RECONSIDER:
 		// against another note with which it might have a known dissonant function.
 		// Also go back if this voice was identified as an agent, because it may be
 		// the agent of multiple patients.
-		if ((results[vindex][lineindex] == m_labels[UNLABELED_Z4]) ||
-				(results[vindex][lineindex] == m_labels[UNLABELED_Z7]) ||
-				(results[vindex][lineindex] == m_labels[AGENT_BIN]) ||
-				(results[vindex][lineindex] == m_labels[AGENT_TERN])) {
+		if ((isLabel(results[vindex][lineindex], UNLABELED_Z4)) ||
+				(isLabel(results[vindex][lineindex], UNLABELED_Z7)) ||
+				(isLabel(results[vindex][lineindex], AGENT_BIN)) ||
+				(isLabel(results[vindex][lineindex], AGENT_TERN))) {
 			if (nextj < (int)harmint.size()) {
 				goto RECONSIDER;
 			}
@@ -85377,7 +90447,7 @@ RECONSIDER:
 // Tool_dissonant::findFakeSuspensions --
 //
 
-void Tool_dissonant::findFakeSuspensions(vector<vector<string>>& results, NoteGrid& grid,
+void Tool_dissonant::findFakeSuspensions(vector<vector<int>>& results, NoteGrid& grid,
 		vector<NoteCell*>& attacks, int vindex) {
 	double intp;        // abs value of diatonic interval from previous melodic note
 	int lineindexn;     // line index of the next note in the voice
@@ -85385,18 +90455,17 @@ void Tool_dissonant::findFakeSuspensions(vector<vector<string>>& results, NoteGr
 
 	for (int i=1; i<(int)attacks.size()-1; i++) {
 		int lineindex = attacks[i]->getLineIndex();
-		if ((results[vindex][lineindex].find("Z") == string::npos) &&
-			(results[vindex][lineindex].find("z") == string::npos) &&
-			(results[vindex][lineindex].find("M") == string::npos) &&
-			(results[vindex][lineindex].find("m") == string::npos)) {
+		if (!isUnexplained(results[vindex][lineindex]) &&
+			!isLabel(results[vindex][lineindex], SUS_NO_AGENT_LEAP) &&
+			!isLabel(results[vindex][lineindex], SUS_NO_AGENT_STEP)) {
 			continue;
 		}
 		intp = fabs(*attacks[i] - *attacks[i-1]);
 		lineindexn = attacks[i+1]->getLineIndex();
 		sfound = false;
 		for (int j=lineindex + 1; j<=lineindexn; j++) {
-			if ((results[vindex][j].compare(0, 1, "s") == 0) ||
-					(results[vindex][j].compare(0, 1, "S") == 0)) {
+			if (isLabel(results[vindex][j], SUS_BIN) ||
+					isLabel(results[vindex][j], SUS_TERN)) {
 				sfound = true;
 				break;
 			}
@@ -85408,16 +90477,16 @@ void Tool_dissonant::findFakeSuspensions(vector<vector<string>>& results, NoteGr
 		// and sustained through to the beginning of the resolution.
 
 		if (intp == 1) { // Apply labels for normal fake suspensions.
-			results[vindex][lineindex] = m_labels[FAKE_SUSPENSION_STEP];
+			results[vindex][lineindex] = FAKE_SUSPENSION_STEP;
 		} else if (intp > 1) {
-			results[vindex][lineindex] = m_labels[FAKE_SUSPENSION_LEAP];
+			results[vindex][lineindex] = FAKE_SUSPENSION_LEAP;
 		} else if (i > 1) { // as long as i > 1 intpp will be in range.
 			double intpp = fabs(*attacks[i-1] - *attacks[i-2]);
 			if (intp == 0) { // fake suspensions preceded by an anticipation.
 				if (intpp == 1) {
-					results[vindex][lineindex] = m_labels[FAKE_SUSPENSION_STEP];
+					results[vindex][lineindex] = FAKE_SUSPENSION_STEP;
 				} else if (intpp > 1) {
-					results[vindex][lineindex] = m_labels[FAKE_SUSPENSION_LEAP];
+					results[vindex][lineindex] = FAKE_SUSPENSION_LEAP;
 				}
 			}
 		}
@@ -85428,7 +90497,7 @@ void Tool_dissonant::findFakeSuspensions(vector<vector<string>>& results, NoteGr
 //
 // Tool_dissonant::findLs --
 //
-void Tool_dissonant::findLs(vector<vector<string>>& results, NoteGrid& grid,
+void Tool_dissonant::findLs(vector<vector<int>>& results, NoteGrid& grid,
 		vector<NoteCell*>& attacks, int vindex) {
 	HumNum dur;        // duration of current note;
 	HumNum odur;       // duration of current note in other voice which may have started earlier;
@@ -85448,8 +90517,7 @@ void Tool_dissonant::findLs(vector<vector<string>>& results, NoteGrid& grid,
 
 	for (int i=1; i<(int)attacks.size()-1; i++) {
 		lineindex = attacks[i]->getLineIndex();
-		if ((results[vindex][lineindex].find("Z") == string::npos) &&
-			(results[vindex][lineindex].find("z") == string::npos)) {
+		if (!isUnexplained(results[vindex][lineindex])) {
 			continue;
 		}
 		dur  = attacks[i]->getDuration();
@@ -85461,11 +90529,11 @@ void Tool_dissonant::findLs(vector<vector<string>>& results, NoteGrid& grid,
 			if (vindex == j) { // only compare different voices
 				continue;
 			}
-			if ((results[j][lineindex] == m_labels[AGENT_BIN]) ||
-				(results[j][lineindex] == m_labels[AGENT_TERN]) ||
-				(results[j][lineindex] == m_labels[UNLABELED_Z7]) ||
-				(results[j][lineindex] == m_labels[UNLABELED_Z4]) ||
-				(results[j][lineindex] == "")) {
+			if ((isLabel(results[j][lineindex], AGENT_BIN)) ||
+				(isLabel(results[j][lineindex], AGENT_TERN)) ||
+				(isLabel(results[j][lineindex], UNLABELED_Z7)) ||
+				(isLabel(results[j][lineindex], UNLABELED_Z4)) ||
+				(results[j][lineindex] == NO_LABEL)) {
 				continue; // skip if other voice is an agent, unexplainable, or empty.
 			}
 			oattackindexc = grid.cell(j, sliceindex)->getCurrAttackIndex();
@@ -85486,10 +90554,10 @@ void Tool_dissonant::findLs(vector<vector<string>>& results, NoteGrid& grid,
 			ointn = opitchn - opitch;
 			if ((intp == ointp) && (intn == ointn)) { // this note moves in parallel with an identifiable dissonance
 				if (intp > 0) {
-					results[vindex][lineindex] = m_labels[PARALLEL_UP];
+					results[vindex][lineindex] = PARALLEL_UP;
 					break;
 				} else if (intp < 0) {
-					results[vindex][lineindex] = m_labels[PARALLEL_DOWN];
+					results[vindex][lineindex] = PARALLEL_DOWN;
 					break;
 				}
 			}
@@ -85501,7 +90569,7 @@ void Tool_dissonant::findLs(vector<vector<string>>& results, NoteGrid& grid,
 //
 // Tool_dissonant::findYs --
 //
-void Tool_dissonant::findYs(vector<vector<string>>& results, NoteGrid& grid,
+void Tool_dissonant::findYs(vector<vector<int>>& results, NoteGrid& grid,
 		vector<NoteCell*>& attacks, int vindex) {
 	double intp;       // diatonic interval from previous melodic note
 	double intn;       // diatonic interval to next melodic note
@@ -85518,8 +90586,7 @@ void Tool_dissonant::findYs(vector<vector<string>>& results, NoteGrid& grid,
 
 	for (int i=1; i<(int)attacks.size()-1; i++) {
 		lineindex = attacks[i]->getLineIndex();
-		if ((results[vindex][lineindex].find("Z") == string::npos) &&
-			(results[vindex][lineindex].find("z") == string::npos)) {
+		if (!isUnexplained(results[vindex][lineindex])) {
 			continue;
 		}
 		intp = *attacks[i] - *attacks[i-1];
@@ -85556,10 +90623,10 @@ void Tool_dissonant::findYs(vector<vector<string>>& results, NoteGrid& grid,
 			}
 
 			if (((thisMod7 == 1) || (thisMod7 == -6)) && // creates 2nd or 7th diss
-				((results[j][lineindex] == m_labels[SUS_BIN]) || // other voice is susp
-				 (results[j][lineindex] == m_labels[SUS_TERN])) &&
+				((isLabel(results[j][lineindex], SUS_BIN)) || // other voice is susp
+				 (isLabel(results[j][lineindex], SUS_TERN))) &&
 				(fabs(intp) == 1) && (intn == -1) && valid_acc_exit) {
-				results[vindex][lineindex] = m_labels[RES_PITCH];
+				results[vindex][lineindex] = RES_PITCH;
 				onlyWithValids = false;
 			} else if (((abs(thisMod7) == 1) || (abs(thisMod7) == 6)  ||
 					((thisInt > 0) && (thisMod7 == 3) &&
@@ -85568,23 +90635,23 @@ void Tool_dissonant::findYs(vector<vector<string>>& results, NoteGrid& grid,
 					((thisInt < 0) && (thisMod7 == -3) && // a fourth by inversion is -3 and -3%7 = -3.
 					!(((int(opitch-lowestnote) % 7) == 2) ||
 					((int(opitch-lowestnote) % 7) == 4)))) &&
-					((results[j][olineindex] == m_labels[AGENT_BIN]) ||
-					(results[j][olineindex] == m_labels[AGENT_TERN]) ||
-					(results[j][olineindex] == m_labels[UNLABELED_Z7]) ||
-					(results[j][olineindex] == m_labels[UNLABELED_Z4]) ||
-					((results[j][olineindex] == "") &&
-					((results[j][lineindex] != m_labels[SUS_BIN]) &&
-					(results[j][lineindex] != m_labels[SUS_TERN]))))) {
+					((isLabel(results[j][olineindex], AGENT_BIN)) ||
+					(isLabel(results[j][olineindex], AGENT_TERN)) ||
+					(isLabel(results[j][olineindex], UNLABELED_Z7)) ||
+					(isLabel(results[j][olineindex], UNLABELED_Z4)) ||
+					((results[j][olineindex] == NO_LABEL) &&
+					((!isLabel(results[j][lineindex], SUS_BIN)) &&
+					(!isLabel(results[j][lineindex], SUS_TERN)))))) {
 				onlyWithValids = false;
 			}
 		}
 
-		if (onlyWithValids && ((results[vindex][lineindex] == m_labels[UNLABELED_Z7]) ||
-				(results[vindex][lineindex] == m_labels[UNLABELED_Z4]))) {
+		if (onlyWithValids && ((isLabel(results[vindex][lineindex], UNLABELED_Z7)) ||
+				(isLabel(results[vindex][lineindex], UNLABELED_Z4)))) {
 			if (intp > 0) {
-				results[vindex][lineindex] = m_labels[ONLY_WITH_VALID_UP];
+				results[vindex][lineindex] = ONLY_WITH_VALID_UP;
 			} else if (intp <= 0) {
-				results[vindex][lineindex] = m_labels[ONLY_WITH_VALID_DOWN];
+				results[vindex][lineindex] = ONLY_WITH_VALID_DOWN;
 			}
 		}
 	}
@@ -85594,7 +90661,7 @@ void Tool_dissonant::findYs(vector<vector<string>>& results, NoteGrid& grid,
 //
 // Tool_dissonant::findAppoggiaturas --
 //
-void Tool_dissonant::findAppoggiaturas(vector<vector<string>>& results, NoteGrid& grid,
+void Tool_dissonant::findAppoggiaturas(vector<vector<int>>& results, NoteGrid& grid,
 		vector<NoteCell*>& attacks, int vindex) {
 	HumNum durpp;      // duration of previous previous note
 	HumNum durp;       // duration of previous note
@@ -85618,10 +90685,9 @@ void Tool_dissonant::findAppoggiaturas(vector<vector<string>>& results, NoteGrid
 	for (int i=1; i<(int)attacks.size()-1; i++) {
 		lineindexp = attacks[i-1]->getLineIndex();
 		lineindex = attacks[i]->getLineIndex();
-		if ((results[vindex][lineindex].find("Z") == string::npos) &&
-			(results[vindex][lineindex].find("z") == string::npos) &&
-			(results[vindex][lineindex].find("J") == string::npos) &&
-			(results[vindex][lineindex].find("j") == string::npos)) {
+		if (!isUnexplained(results[vindex][lineindex]) &&
+			!isLabel(results[vindex][lineindex], REV_ECHAPPEE_UP) &&
+			!isLabel(results[vindex][lineindex], REV_ECHAPPEE_DOWN)) {
 			continue;
 		}
 		durp = attacks[i-1]->getDuration();
@@ -85689,48 +90755,48 @@ void Tool_dissonant::findAppoggiaturas(vector<vector<string>>& results, NoteGrid
 					((int(opitch-lowestnote) % 7) == 4))))) {
 				continue;
 			} else if (((intp == -1) || ant_down) && ((lev <= levn) && (dur <= durn)) &&
-						((results[vindex][lineindex] == m_labels[UNLABELED_Z7]) ||
-						(results[vindex][lineindex] == m_labels[UNLABELED_Z4]))) {
+						((isLabel(results[vindex][lineindex], UNLABELED_Z7)) ||
+						(isLabel(results[vindex][lineindex], UNLABELED_Z4)))) {
 				if (intn == -1) {
-					results[vindex][lineindex] = m_labels[ACC_PASSING_DOWN]; // descending accented passing tone
+					results[vindex][lineindex] = ACC_PASSING_DOWN; // descending accented passing tone
 				} else if (intn == 1) {
-					results[vindex][lineindex] = m_labels[ACC_LO_NEI]; // accented lower neighbor
+					results[vindex][lineindex] = ACC_LO_NEI; // accented lower neighbor
 				}
 			} else if (((intp == 1) || ant_up) && ((lev <= levn) && (dur <= durn)) &&
-						((results[vindex][lineindex] == m_labels[UNLABELED_Z7]) ||
-						(results[vindex][lineindex] == m_labels[UNLABELED_Z4]))) {
+						((isLabel(results[vindex][lineindex], UNLABELED_Z7)) ||
+						(isLabel(results[vindex][lineindex], UNLABELED_Z4)))) {
 				if (intn == 1) {
-					results[vindex][lineindex] = m_labels[ACC_PASSING_UP]; // rising accented passing tone
+					results[vindex][lineindex] = ACC_PASSING_UP; // rising accented passing tone
 				} else if (intn == -1) {
-					results[vindex][lineindex] = m_labels[ACC_UP_NEI]; // accented upper neighbor
+					results[vindex][lineindex] = ACC_UP_NEI; // accented upper neighbor
 				}
 			} else if (intn == -1) {
-				if ((intp == 2) && (results[vindex][lineindexp] == m_labels[ECHAPPEE_DOWN]) &&
-					(((results[vindex][lineindex] == m_labels[UNLABELED_Z7]) ||
-						(results[vindex][lineindex] == m_labels[UNLABELED_Z4]) ||
-						(results[vindex][lineindex] == m_labels[REV_ECHAPPEE_UP])) ||
+				if ((intp == 2) && (isLabel(results[vindex][lineindexp], ECHAPPEE_DOWN)) &&
+					(((isLabel(results[vindex][lineindex], UNLABELED_Z7)) ||
+						(isLabel(results[vindex][lineindex], UNLABELED_Z4)) ||
+						(isLabel(results[vindex][lineindex], REV_ECHAPPEE_UP))) ||
 					 ((lev <= levn) && (dur <= durn)))) {
-					results[vindex][lineindexp] = m_labels[DBL_NEIGHBOR_DOWN];
-					results[vindex][lineindex]  = m_labels[DBL_NEIGHBOR_DOWN];
+					results[vindex][lineindexp] = DBL_NEIGHBOR_DOWN;
+					results[vindex][lineindex] = DBL_NEIGHBOR_DOWN;
 				} else if (((fabs(intp) > 1) || ant_leapt_to) &&
 							((lev <= levn) && (dur <= durn)) &&
-							((results[vindex][lineindex] == m_labels[UNLABELED_Z7]) ||
-							(results[vindex][lineindex] == m_labels[UNLABELED_Z4]))) { // upper appoggiatura
-					results[vindex][lineindex] = m_labels[APP_UPPER];
+							((isLabel(results[vindex][lineindex], UNLABELED_Z7)) ||
+							(isLabel(results[vindex][lineindex], UNLABELED_Z4)))) { // upper appoggiatura
+					results[vindex][lineindex] = APP_UPPER;
 				}
 			} else if (intn == 1) {
-				if ((intp == -2) && (results[vindex][lineindexp] == m_labels[ECHAPPEE_UP]) &&
-					(((results[vindex][lineindex] == m_labels[UNLABELED_Z7]) ||
-						(results[vindex][lineindex] == m_labels[UNLABELED_Z4]) ||
-						(results[vindex][lineindex] == m_labels[REV_ECHAPPEE_DOWN])) ||
+				if ((intp == -2) && (isLabel(results[vindex][lineindexp], ECHAPPEE_UP)) &&
+					(((isLabel(results[vindex][lineindex], UNLABELED_Z7)) ||
+						(isLabel(results[vindex][lineindex], UNLABELED_Z4)) ||
+						(isLabel(results[vindex][lineindex], REV_ECHAPPEE_DOWN))) ||
 					 ((lev <= levn) && (dur <= durn)))) {
-					results[vindex][lineindexp] = m_labels[DBL_NEIGHBOR_UP];
-					results[vindex][lineindex]  = m_labels[DBL_NEIGHBOR_UP];
+					results[vindex][lineindexp] = DBL_NEIGHBOR_UP;
+					results[vindex][lineindex] = DBL_NEIGHBOR_UP;
 				} else if (((fabs(intp) > 1) || ant_leapt_to) &&
 							((lev <= levn) && (dur <= durn)) &&
-							((results[vindex][lineindex] == m_labels[UNLABELED_Z7]) ||
-							(results[vindex][lineindex] == m_labels[UNLABELED_Z4]))) { // lower appoggiatura
-					results[vindex][lineindex] = m_labels[APP_LOWER];
+							((isLabel(results[vindex][lineindex], UNLABELED_Z7)) ||
+							(isLabel(results[vindex][lineindex], UNLABELED_Z4)))) { // lower appoggiatura
+					results[vindex][lineindex] = APP_LOWER;
 				}
 			}
 		}
@@ -85750,7 +90816,7 @@ void Tool_dissonant::findAppoggiaturas(vector<vector<string>>& results, NoteGrid
 //		Altizans must be found set against any of the other three types for
 //		anything to be detected.
 //
-void Tool_dissonant::findCadentialVoiceFunctions(vector<vector<string>>& results, NoteGrid& grid,
+void Tool_dissonant::findCadentialVoiceFunctions(vector<vector<int>>& results, NoteGrid& grid,
 		vector<NoteCell*>& attacks, vector<vector<string>>& voiceFuncs, int vindex) {
 	double int2;      // diatonic interval to next melodic note
 	double int3 = -22; // diatonic interval from next melodic note to following note
@@ -85781,8 +90847,8 @@ void Tool_dissonant::findCadentialVoiceFunctions(vector<vector<string>>& results
 	for (int i=1; i<(int)attacks.size()-1; i++) {
 		lineindex  = attacks[i]->getLineIndex();
 		// pass over if ref voice is not an agent
-		if ((results[vindex][lineindex] != m_labels[AGENT_BIN]) &&
-			(results[vindex][lineindex] != m_labels[AGENT_TERN])) {
+		if ((!isLabel(results[vindex][lineindex], AGENT_BIN)) &&
+			(!isLabel(results[vindex][lineindex], AGENT_TERN))) {
 			continue;
 		}
 		int2 = *attacks[i+1] - *attacks[i];
@@ -85794,8 +90860,8 @@ void Tool_dissonant::findCadentialVoiceFunctions(vector<vector<string>>& results
 			}
 
 			// skip if other voice isn't a patient
-			if ((results[j][lineindex] != m_labels[SUS_BIN]) &&
-				(results[j][lineindex] != m_labels[SUS_TERN])) {
+			if ((!isLabel(results[j][lineindex], SUS_BIN)) &&
+				(!isLabel(results[j][lineindex], SUS_TERN))) {
 				continue;
 			}
 
@@ -85863,12 +90929,12 @@ void Tool_dissonant::findCadentialVoiceFunctions(vector<vector<string>>& results
 				attInd3  = attacks[i+1]->getNextAttackIndex();
 				lineindex3 = attacks[i+2]->getLineIndex();
 				if (((thisMod7 == 6) || (thisMod7 == -1)) && (int2 == -1) &&
-					(results[vindex][lineindex2] == m_labels[ANT_DOWN]) &&
+					(isLabel(results[vindex][lineindex2], ANT_DOWN)) &&
 					(attInd3 == oattInd3) && (oint2 == -1) && (oint3 == 1)) {
 					voiceFuncs[j][lineindex3] = "C"; // cantizans
 					voiceFuncs[vindex][lineindex3] = "T"; // tenorizans
 				} else if ((thisMod7 == 3) && (int2 == -1) && (attInd3 == oattInd3) &&
-					(results[vindex][lineindex2] == m_labels[ANT_DOWN]) &&
+					(isLabel(results[vindex][lineindex2], ANT_DOWN)) &&
 					(oint2 == -1) && (oint3 == 1)) { // "^4xs 1 3sx -2 5xx$"
 					voiceFuncs[j][lineindex3] = "A"; // altizans
 					voiceFuncs[vindex][lineindex3] = "T"; // tenorizans
@@ -85983,7 +91049,149 @@ void Tool_dissonant::findCadentialVoiceFunctions(vector<vector<string>>& results
 
 ///////////////////////////////
 //
-// printCountAnalysis --
+// printCountAnalysis -- Print the number of each type of dissonance in
+//     each voice.  The labels are only needed for the row names.
+//
+
+void Tool_dissonant::printCountAnalysis(vector<vector<int>>& data) {
+
+	bool brief = getBoolean("u");
+	bool percentQ = getBoolean("percent");
+
+	// Count label types that are displayed with the same text together:
+	vector<vector<int>> analysis(data.size());
+	for (int i=0; i<(int)data.size(); i++) {
+		analysis[i].resize(LABELS_SIZE, 0);
+		for (int j=0; j<(int)data[i].size(); j++) {
+			if (data[i][j] >= 0) {
+				analysis[i][m_labelIndex[data[i][j]]]++;
+			}
+		}
+	}
+
+	m_humdrum_text << "**rdis";
+	if (brief) {
+		m_humdrum_text << "u";
+	}
+	m_humdrum_text << "\t**sum";
+	for (int j=0; j<(int)analysis.size(); j++) {
+		m_humdrum_text << "\t" << "**v" << j + 1;
+	}
+	m_humdrum_text << endl;
+
+	vector<bool> reduced(LABELS_SIZE, false);
+	int sumsum = 0;
+	for (int i=0; i<(int)LABELS_SIZE; i++) {
+		if (i == UNLABELED_Z2) {
+			continue;
+		}
+		if (i == UNLABELED_Z7) {
+			continue;
+		}
+
+		int item = m_labelIndex[i];
+		bool agent = isLabel(item, AGENT_BIN) || isLabel(item, AGENT_TERN);
+
+		if (brief && reduced[item]) {
+			continue;
+		}
+		reduced[item] = true;
+
+		int sum = 0;
+		for (int j=0; j<(int)analysis.size(); j++) {
+			sum += analysis[j][item];
+			// Don't include agents in dissonant note summation.
+			if (!agent) {
+				sumsum += analysis[j][item];
+			}
+		}
+
+		if (sum == 0) {
+			continue;
+		}
+
+		m_humdrum_text << m_labels[i];
+		m_humdrum_text << "\t" << sum;
+
+		for (int j=0; j<(int)analysis.size(); j++) {
+			m_humdrum_text << "\t";
+			if (percentQ && analysis[j][item]) {
+				if (agent) {
+					m_humdrum_text << ".";
+				} else {
+					m_humdrum_text << int(analysis[j][item] * 1.0 / sum * 1000.0 + 0.5) / 10.0;
+				}
+			} else {
+				m_humdrum_text << analysis[j][item];
+			}
+		}
+		m_humdrum_text << endl;
+	}
+
+	m_humdrum_text << "*-\t*-";
+	for (int j=0; j<(int)analysis.size(); j++) {
+		m_humdrum_text << "\t" << "*-";
+	}
+	m_humdrum_text << endl;
+
+	m_humdrum_text << "!!total_dissonances:\t" << sumsum << endl;
+
+}
+
+
+
+///////////////////////////////
+//
+// addStatistics -- Add the number of each type of dissonance to the
+//     statistics for --stats.  Labels with the same text are counted
+//     together, and agents are not included in the dissonance total.
+//
+
+void Tool_dissonant::addStatistics(vector<vector<int>>& data) {
+	m_stats.addFile();
+	int total = 0;
+	for (int i=0; i<(int)data.size(); i++) {
+		for (int j=0; j<(int)data[i].size(); j++) {
+			int value = data[i][j];
+			if (value < 0) {
+				continue;
+			}
+			m_stats.increment("labels", m_labels[value]);
+			if (!(isLabel(value, AGENT_BIN) || isLabel(value, AGENT_TERN))) {
+				total++;
+			}
+		}
+	}
+	m_stats.increment("summary", "dissonances", total);
+	m_stats.increment("summary", "voices", (double)data.size());
+}
+
+
+
+///////////////////////////////
+//
+// addStatistics -- String version, used for voice function labels.
+//
+
+void Tool_dissonant::addStatistics(vector<vector<string>>& data) {
+	m_stats.addFile();
+	for (int i=0; i<(int)data.size(); i++) {
+		for (int j=0; j<(int)data[i].size(); j++) {
+			const string& value = data[i][j];
+			if (value.empty() || (value == ".")) {
+				continue;
+			}
+			m_stats.increment("voice-functions", value);
+		}
+	}
+	m_stats.increment("summary", "voices", (double)data.size());
+}
+
+
+
+///////////////////////////////
+//
+// printCountAnalysis -- String version, used for voice function labels.
 //
 
 void Tool_dissonant::printCountAnalysis(vector<vector<string>>& data) {
@@ -86176,6 +91384,7 @@ void Tool_dissonant::fillLabels(void) {
 	m_labels[UNLABELED_Z2        ] = "Z"; // unknown dissonance, 2nd interval
 	m_labels[UNLABELED_Z7        ] = "Z"; // unknown dissonance, 7th interval
 	m_labels[UNLABELED_Z4        ] = "z"; // unknown dissonance, 4th interval
+	fillLabelIndexes();
 }
 
 
@@ -86236,6 +91445,78 @@ void Tool_dissonant::fillLabels2(void) {
 	m_labels[UNLABELED_Z2        ] = "Z"; // unknown dissonance, 2nd interval
 	m_labels[UNLABELED_Z7        ] = "Z"; // unknown dissonance, 7th interval
 	m_labels[UNLABELED_Z4        ] = "Z"; // unknown dissonance, 4th interval
+	fillLabelIndexes();
+}
+
+
+
+//////////////////////////////
+//
+// Tool_dissonant::fillLabelIndexes -- Map each label type to the first
+//     label type that is displayed with the same text, so that types which
+//     are not distinguished in the output (such as the upward and downward
+//     variants in undirected mode) compare as equal in isLabel().
+//
+
+void Tool_dissonant::fillLabelIndexes(void) {
+	m_labelIndex.resize(LABELS_SIZE);
+	for (int i=0; i<LABELS_SIZE; i++) {
+		m_labelIndex[i] = i;
+		for (int j=0; j<i; j++) {
+			if (m_labels[j] == m_labels[i]) {
+				m_labelIndex[i] = j;
+				break;
+			}
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// Tool_dissonant::isLabel -- Return true if the analysis result is the
+//     given label type (or another type displayed with the same text).
+//
+
+bool Tool_dissonant::isLabel(int value, int label) {
+	if (value < 0) {
+		return false;
+	}
+	return m_labelIndex[value] == m_labelIndex[label];
+}
+
+
+
+//////////////////////////////
+//
+// Tool_dissonant::isUnexplained -- Return true if the analysis result is
+//     a dissonance that has not been identified (Z/z).
+//
+
+bool Tool_dissonant::isUnexplained(int value) {
+	return isLabel(value, UNLABELED_Z2) ||
+	       isLabel(value, UNLABELED_Z7) ||
+	       isLabel(value, UNLABELED_Z4) ||
+	       isLabel(value, UNKNOWN_DISSONANCE);
+}
+
+
+
+//////////////////////////////
+//
+// Tool_dissonant::getLabelStrings -- Convert the analysis results of a
+//     voice into the text labels for the output spine.
+//
+
+vector<string> Tool_dissonant::getLabelStrings(vector<int>& results) {
+	vector<string> output(results.size());
+	for (int i=0; i<(int)results.size(); i++) {
+		if (results[i] >= 0) {
+			output[i] = m_labels[results[i]];
+		}
+	}
+	return output;
 }
 
 
@@ -91032,6 +96313,18 @@ Tool_extract::Tool_extract(void) {
 
 
 
+//////////////////////////////
+//
+// Tool_extract::isReusable -- Instances can be run on several files.
+//     Field lists are recalculated for each file.
+//
+
+bool Tool_extract::isReusable(void) {
+	return true;
+}
+
+
+
 /////////////////////////////////
 //
 // Tool_extract::run -- Primary interfaces to the tool.
@@ -95142,60 +100435,56 @@ const vector<FiguredBassAbbreviationMapping> FiguredBassAbbreviationMapping::s_m
 
 
 #define RUNTOOL(NAME, INFILE, COMMAND, STATUS)     \
-	Tool_##NAME *tool = new Tool_##NAME;            \
-	tool->process(COMMAND);                         \
+	Tool_##NAME *tool = getTool<Tool_##NAME>(COMMAND); \
 	tool->run(INFILE);                              \
 	if (tool->hasError()) {                         \
 		status = false;                              \
 		tool->getError(cerr);                        \
-		delete tool;                                 \
+		releaseTool(COMMAND, tool);                  \
 		break;                                       \
 	} else if (tool->hasHumdrumText()) {            \
 		INFILE.readString(tool->getHumdrumText());   \
 	}                                               \
-	delete tool;
+	releaseTool(COMMAND, tool);
 
 #define RUNTOOL2(NAME, INFILE1, INFILE2, COMMAND, STATUS) \
-	Tool_##NAME *tool = new Tool_##NAME;            \
-	tool->process(COMMAND);                         \
+	Tool_##NAME *tool = getTool<Tool_##NAME>(COMMAND); \
 	tool->run(INFILE1, INFILE2);                    \
 	if (tool->hasError()) {                         \
 		status = false;                              \
 		tool->getError(cerr);                        \
-		delete tool;                                 \
+		releaseTool(COMMAND, tool);                  \
 		break;                                       \
 	} else if (tool->hasHumdrumText()) {            \
 		INFILE1.readString(tool->getHumdrumText());  \
 	}                                               \
-	delete tool;
+	releaseTool(COMMAND, tool);
 
 #define RUNTOOLSET(NAME, INFILES, COMMAND, STATUS) \
-	Tool_##NAME *tool = new Tool_##NAME;            \
-	tool->process(COMMAND);                         \
+	Tool_##NAME *tool = getTool<Tool_##NAME>(COMMAND); \
 	tool->run(INFILES);                             \
 	if (tool->hasError()) {                         \
 		status = false;                              \
 		tool->getError(cerr);                        \
-		delete tool;                                 \
+		releaseTool(COMMAND, tool);                  \
 		break;                                       \
 	} else if (tool->hasHumdrumText()) {            \
 		INFILES.readString(tool->getHumdrumText());  \
 	}                                               \
-	delete tool;
+	releaseTool(COMMAND, tool);
 
 #define RUNTOOLSTREAM(NAME, INFILES, COMMAND, STATUS) \
-	Tool_##NAME *tool = new Tool_##NAME;               \
-	tool->process(COMMAND);                            \
+	Tool_##NAME *tool = getTool<Tool_##NAME>(COMMAND); \
 	tool->run(INFILES);                                \
 	if (tool->hasError()) {                            \
 		status = false;                                 \
 		tool->getError(cerr);                           \
-		delete tool;                                    \
+		releaseTool(COMMAND, tool);                     \
 		break;                                          \
 	} else if (tool->hasHumdrumText()) {               \
 		INFILES.readString(tool->getHumdrumText());     \
 	}                                                  \
-	delete tool;
+	releaseTool(COMMAND, tool);
 
 
 
@@ -95524,21 +100813,17 @@ bool Tool_filter::run(HumdrumFileSet& infiles) {
 //
 
 void Tool_filter::removeGlobalFilterLines(HumdrumFile& infile) {
-	HumRegex hre;
 	string text;
 
 	string maintag = "!!!filter:";
 	string mainXtag = "!!!Xfilter:";
-	string maintagQuery = "^!!!filter:";
 
 	string maintagV;
 	string mainXtagV;
-	string maintagQueryV;
 
 	if (m_variant.size() > 0) {
 		maintagV = "!!!filter-" + m_variant + ":";
 		mainXtagV = "!!!Xfilter-" + m_variant + ":";
-		maintagQueryV = "^!!!filter-" + m_variant + ":";
 	}
 
 	for (int i=0; i<infile.getLineCount(); i++) {
@@ -95548,14 +100833,12 @@ void Tool_filter::removeGlobalFilterLines(HumdrumFile& infile) {
 
 		if (m_variant.size() > 0) {
 			if (infile.token(i, 0)->compare(0, maintagV.size(), maintagV) == 0) {
-				text = infile.token(i, 0)->getText();
-				hre.replaceDestructive(text, mainXtagV, maintagQueryV);
+				text = mainXtagV + infile.token(i, 0)->substr(maintagV.size());
 				infile.token(i, 0)->setText(text);
 			}
 		} else {
 			if (infile.token(i, 0)->compare(0, maintag.size(), maintag) == 0) {
-				text = infile.token(i, 0)->getText();
-				hre.replaceDestructive(text, mainXtag, maintagQuery);
+				text = mainXtag + infile.token(i, 0)->substr(maintag.size());
 				infile.token(i, 0)->setText(text);
 			}
 		}
@@ -95631,7 +100914,6 @@ void Tool_filter::getCommandList(vector<pair<string, string> >& commands,
 		tag += m_variant;
 	}
 	vector<string> clist;
-	HumRegex hre;
 	for (int i=0; i<(int)refs.size(); i++) {
 		string refkey = refs[i]->getGlobalReferenceKey();
 		if (refkey != tag) {
@@ -95640,11 +100922,14 @@ void Tool_filter::getCommandList(vector<pair<string, string> >& commands,
 		string command = refs[i]->getGlobalReferenceValue();
 		splitPipeline(clist, command);
 		for (int j=0; j<(int)clist.size(); j++) {
-			if (hre.search(clist[j], "^\\s*([^\\s]+)")) {
-				entry.first  = hre.getMatch(1);
-				entry.second = clist[j];
-				commands.push_back(entry);
+			// commands have no leading spaces after splitPipeline():
+			if (clist[j].empty()) {
+				continue;
 			}
+			auto found = find_if(clist[j].begin(), clist[j].end(), ::isspace);
+			entry.first  = string(clist[j].begin(), found);
+			entry.second = clist[j];
+			commands.push_back(entry);
 		}
 	}
 }
@@ -95736,10 +101021,11 @@ void Tool_filter::splitPipeline(vector<string>& clist, const string& command) {
 	}
 
 	// remove leading and trailing spaces
-	HumRegex hre;
 	for (int i=0; i<(int)clist.size(); i++) {
-		hre.replaceDestructive(clist[i], "", "^\\s+");
-		hre.replaceDestructive(clist[i], "", "\\s+$");
+		auto first = find_if_not(clist[i].begin(), clist[i].end(), ::isspace);
+		clist[i].erase(clist[i].begin(), first);
+		auto last = find_if_not(clist[i].rbegin(), clist[i].rend(), ::isspace);
+		clist[i].erase(last.base(), clist[i].end());
 	}
 
 }
@@ -95781,6 +101067,40 @@ void Tool_filter::getUniversalCommandList(vector<pair<string, string> >& command
 
 
 
+//////////////////////////////
+//
+// Tool_filter::getToolCache -- Return the tool instances of the current
+//     thread, indexed by filter command.
+//
+
+map<string, std::unique_ptr<HumTool>>& Tool_filter::getToolCache(void) {
+	thread_local map<string, std::unique_ptr<HumTool>> cache;
+	return cache;
+}
+
+
+
+//////////////////////////////
+//
+// Tool_filter::releaseTool -- Clear the output of a cached tool so that
+//     it can be run again, or delete the tool if it is not cached.  Cached
+//     tools that had an error are deleted as well.
+//
+
+void Tool_filter::releaseTool(const string& command, HumTool* tool) {
+	map<string, std::unique_ptr<HumTool>>& cache = getToolCache();
+	auto it = cache.find(command);
+	if ((it == cache.end()) || (it->second.get() != tool)) {
+		delete tool;
+	} else if (tool->hasError()) {
+		cache.erase(it);
+	} else {
+		tool->clearOutput();
+	}
+}
+
+
+
 //////////////////////////////
 //
 // Tool_filter::initialize -- extract time signature lines for
@@ -102283,9 +107603,62 @@ void Tool_imitation::doAnalysis(vector<vector<string> >& results,
 		getIntervals(intervals.at(i), attacks.at(i));
 	}
 
+	vector<ImitationVoice> voices(attacks.size());
+	map<HumNum, int> durationids;
+	for (int i=0; i<(int)voices.size(); i++) {
+		prepareVoice(voices.at(i), attacks.at(i), intervals.at(i), durationids);
+	}
+
 	for (int i=0; i<(int)attacks.size(); i++) {
 		for (int j=i+1; j<(int)attacks.size(); j++) {
-			analyzeImitation(results, attacks, intervals, i, j);
+			analyzeImitation(results, attacks, intervals, voices, i, j);
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// Tool_imitation::prepareVoice -- Store the intervals, durations and start
+//    times of the attacks in a voice, and index the attacks by their
+//    interval and duration.  Only attacks that have the same interval (or
+//    the inverted interval) and duration as the first attack of a sequence
+//    can start a match with it, so the index gives the candidate matches
+//    without comparing every pair of attacks.
+//
+
+void Tool_imitation::prepareVoice(ImitationVoice& voice,
+		vector<NoteCell*>& attacks, vector<double>& intervals,
+		map<HumNum, int>& durationids) {
+	int size = (int)attacks.size();
+	voice.intervals.resize(size);
+	voice.durations.resize(size);
+	voice.starttimes.resize(size);
+	voice.starts.clear();
+
+	for (int i=0; i<size; i++) {
+		if (Convert::isNaN(intervals.at(i))) {
+			voice.intervals.at(i) = ImitationVoice::NOINTERVAL;
+		} else {
+			voice.intervals.at(i) = (int)intervals.at(i);
+		}
+		if (m_duration) {
+			HumNum duration = attacks.at(i)->getDuration();
+			auto it = durationids.find(duration);
+			if (it == durationids.end()) {
+				int id = (int)durationids.size();
+				durationids[duration] = id;
+				voice.durations.at(i) = id;
+			} else {
+				voice.durations.at(i) = it->second;
+			}
+		} else {
+			voice.durations.at(i) = 0;
+		}
+		voice.starttimes.at(i) = attacks.at(i)->getToken()->getDurationFromStart();
+		if (voice.intervals.at(i) != ImitationVoice::NOINTERVAL) {
+			voice.starts[std::make_pair(voice.intervals.at(i), voice.durations.at(i))].push_back(i);
 		}
 	}
 }
@@ -102323,12 +107696,14 @@ void Tool_imitation::getIntervals(vector<double>& intervals,
 
 void Tool_imitation::analyzeImitation(vector<vector<string>>& results,
 		vector<vector<NoteCell*>>& attacks, vector<vector<double>>& intervals,
-		int v1, int v2) {
+		vector<ImitationVoice>& voices, int v1, int v2) {
 
 	vector<NoteCell*>& v1a = attacks.at(v1);
 	vector<NoteCell*>& v2a = attacks.at(v2);
 	vector<double>& v1i = intervals.at(v1);
 	vector<double>& v2i = intervals.at(v2);
+	ImitationVoice& voice1 = voices.at(v1);
+	ImitationVoice& voice2 = voices.at(v2);
 
 	int min = m_threshold - 1;
 	int count;
@@ -102337,14 +107712,38 @@ void Tool_imitation::analyzeImitation(vector<vector<string>>& results,
 	vector<int> enum2(v2a.size(), 0);
 
 	for (int i=0; i<(int)v1i.size() - 1; i++) {
-		count = 0;
-		for (int j=0; j<(int)v2i.size() - 1; j++) {
-			if (m_rest || m_rest2) {
-				if ((i > 0) && (!Convert::isNaN(attacks.at(v1).at(i-1)->getSgnDiatonicPitch()))) {
-					// match initiator must be preceded by a rest (or start of music)
-					continue;
-				}
+		if (m_rest || m_rest2) {
+			if ((i > 0) && (!Convert::isNaN(attacks.at(v1).at(i-1)->getSgnDiatonicPitch()))) {
+				// match initiator must be preceded by a rest (or start of music)
+				continue;
 			}
+		}
+		int interval1 = voice1.intervals.at(i);
+		if (interval1 == ImitationVoice::NOINTERVAL) {
+			// sequences cannot start with rests
+			continue;
+		}
+		if (m_inversion) {
+			interval1 = -interval1;
+		}
+		auto found = voice2.starts.find(std::make_pair(interval1, voice1.durations.at(i)));
+		if (found == voice2.starts.end()) {
+			continue;
+		}
+
+		// Attacks in the second voice that are not in the list cannot
+		// start a match, so stepping over them is the same as comparing
+		// them.  nextj is the next attack that is not inside of an
+		// earlier (partial) match.
+		int nextj = 0;
+		for (int j : found->second) {
+			if (j >= (int)v2i.size() - 1) {
+				break;
+			}
+			if (j < nextj) {
+				continue;
+			}
+			nextj = j + 1;
 			if (m_rest2) {
 				if ((j > 0) && (!Convert::isNaN(attacks.at(v2).at(j-1)->getSgnDiatonicPitch()))) {
 					// match target must be preceded by a rest (or start of music)
@@ -102355,12 +107754,12 @@ void Tool_imitation::analyzeImitation(vector<vector<string>>& results,
 				// avoid re-matching an existing match as a submatch
 				continue;
 			}
-			count = compareSequences(v1a, v1i, i, v2a, v2i, j);
+			count = compareSequences(voice1, i, voice2, j);
 			if ((count >= min) && (m_intervals.size() > 0)) {
 				count = checkForIntervalSequence(m_intervals, v1i, i, count);
 			}
 			if (count < min) {
-				j += count;
+				nextj = j + count + 1;
 				continue;
 			}
 
@@ -102373,7 +107772,7 @@ void Tool_imitation::analyzeImitation(vector<vector<string>>& results,
 			HumNum distance2 = time1 - time2;
 
 			if (m_maxdistanceQ && (distance1.getAbs().getFloat() > m_maxdistance)) {
-				j += count;
+				nextj = j + count + 1;
 				continue;
 			}
 
@@ -102637,7 +108036,7 @@ void Tool_imitation::analyzeImitation(vector<vector<string>>& results,
 			}
 
 			// skip over match (need to do in i as well somehow)
-			j += count;
+			nextj = j + count + 1;
 		} // j loop
 	} // i loop
 }
@@ -102697,92 +108096,70 @@ int Tool_imitation::checkForIntervalSequence(vector<int>& m_intervals,
 //     interval count).
 //
 
-int Tool_imitation::compareSequences(vector<NoteCell*>& attack1,
-		vector<double>& seq1, int i1, vector<NoteCell*>& attack2,
-		vector<double>& seq2, int i2) {
+int Tool_imitation::compareSequences(ImitationVoice& voice1, int i1,
+		ImitationVoice& voice2, int i2) {
+	vector<int>& seq1 = voice1.intervals;
+	vector<int>& seq2 = voice2.intervals;
+	vector<int>& dur1 = voice1.durations;
+	vector<int>& dur2 = voice2.durations;
+
 	int count = 0;
 	// sequences cannot start with rests
-	if (Convert::isNaN(seq1.at(i1)) || Convert::isNaN(seq2.at(i2))) {
+	if ((seq1.at(i1) == ImitationVoice::NOINTERVAL) || (seq2.at(i2) == ImitationVoice::NOINTERVAL)) {
 		return count;
 	}
 	if (m_nozero) {
 		// exclude matches that start at the same time.
-		if (attack1.at(i1)->getToken()->getDurationFromStart() == attack2.at(i2)->getToken()->getDurationFromStart()) {
+		if (voice1.starttimes.at(i1) == voice2.starttimes.at(i2)) {
 			return count;
 		}
 	} else if (m_onlyzero) {
 		// exclude matches that do not start at the same time (parallel motion).
-		if (attack1.at(i1)->getToken()->getDurationFromStart() != attack2.at(i2)->getToken()->getDurationFromStart()) {
+		if (voice1.starttimes.at(i1) != voice2.starttimes.at(i2)) {
 			return count;
 		}
 	}
 
-	HumNum dur1;
-	HumNum dur2;
-
-	while ((i1+count < (int)seq1.size()) && (i2+count < (int)seq2.size())) {
-
-		if (m_duration) {
-			dur1 = attack1.at(i1+count)->getDuration();
-			dur2 = attack2.at(i2+count)->getDuration();
-			if (dur1 != dur2) {
-				break;
-			}
+	int size1 = (int)seq1.size();
+	int size2 = (int)seq2.size();
+	while ((i1+count < size1) && (i2+count < size2)) {
+		// (duration IDs are all zero if not comparing durations)
+		if (dur1[i1+count] != dur2[i2+count]) {
+			break;
 		}
 
-		if (Convert::isNaN(seq1.at(i1+count))) {
-			// the first voice's interval is to/from a rest
-			if (Convert::isNaN(seq2.at(i2+count))) {
-				// The seoncd voice's interval is also to/from a rest,
-				// so increment count and continue.
+		int interval1 = seq1[i1+count];
+		int interval2 = seq2[i2+count];
+		if ((interval1 == ImitationVoice::NOINTERVAL) || (interval2 == ImitationVoice::NOINTERVAL)) {
+			if (interval1 == interval2) {
+				// Both intervals are to/from a rest, so increment count
+				// and continue.
 				count++;
 				continue;
-			} else {
-				// The second voice's interval is not to/from a rest,
-				// so return the current count.
-				if (count) {
-					return count + 1;
-				} else {
-					return count;
-				}
-			}
-		} else if (Convert::isNaN(seq2.at(i2+count))) {
-			// The second voice's interval is to/from a rest
-			// but already know that the first one is not, so return
-			// current count;
-			if (count) {
-				return count + 1;
-			} else {
-				return count;
 			}
-		} else if (m_inversion && (seq1.at(i1+count) == -seq2.at(i2+count))) {
-         // The two sequences match as inversions at this point, so continue.
-			count++;
-		} else if ((!m_inversion) && (seq1.at(i1+count) == seq2.at(i2+count))) {
-         // The two sequences match at this point, so continue.
-			count++;
-			continue;
-		} else {
+			// Only one interval is to/from a rest, so return the
+			// current count.
+			return count ? count + 1 : count;
+		}
+		if (m_inversion) {
+			interval2 = -interval2;
+		}
+		if (interval1 != interval2) {
 			// The sequences do not match so return the current count.
-			if (count) {
-				return count + 1;
-			} else {
-				return count;
-			}
+			return count ? count + 1 : count;
 		}
+		// The two sequences match at this point, so continue.
+		count++;
 	}
 
-	if (count) {
-		// don't add one for some reaason (this will cause out-of-bounds)
-		return count;
-	} else {
-		return count;
-	}
+	// don't add one for some reaason (this will cause out-of-bounds)
+	return count;
 }
 
 
 
 
+
 /////////////////////////////////
 //
 // Tool_instinfo::Tool_instinfo -- Set the recognized options for the tool.
@@ -111187,14 +116564,13 @@ void Tool_meter::processLine(HumdrumLine& line, vector<HumNum>& curNum,
 		return;
 	}
 
-	HumRegex hre;
 	if (line.isBarline()) {
 		for (int i=0; i<fieldCount; i++) {
 			HTp token = line.token(i);
 			if (!token->isKern()) {
 				continue;
 			}
-			if (hre.search(token, "-")) {
+			if (token->find('-') != string::npos) {
 				// invisible barline: ignore
 				continue;
 			}
@@ -111207,11 +116583,16 @@ void Tool_meter::processLine(HumdrumLine& line, vector<HumNum>& curNum,
 
 	if (line.isInterpretation()) {
 		// check for time signatures
+		HumRegex hre;
 		for (int i=0; i<fieldCount; i++) {
 			HTp token = line.token(i);
 			if (!token->isKern()) {
 				continue;
 			}
+			if ((token->compare(0, 2, "*M") != 0) &&
+					(token->compare(0, 6, "*beat:") != 0)) {
+				continue;
+			}
 			if (hre.search(token, "^\\*M(\\d+)/(\\d+)")) {
 				int top = hre.getMatchInt(1);
 				int bot = hre.getMatchInt(2);
@@ -113443,6 +118824,8 @@ void SonorityDatabase::buildDatabase(HLp line) {
 		for (int j=0; j<scount; j++) {
 			expandList();
 			m_notes.back().setToken(token, nullQ, j);
+			m_sonority.addDiatonic(m_notes.back().getBase7());
+			m_sonority.addBase40(m_notes.back().getBase40());
 			if (m_notes.back().getBase12() < lowest12) {
 				lowesti = (int)m_notes.size() - 1;
 				lowest12 = m_notes.back().getBase12();
@@ -113464,6 +118847,8 @@ void SonorityDatabase::buildDatabase(HLp line) {
 void SonorityDatabase::addNote(const std::string& text) {
 	expandList();
 	m_notes.back().setString(text);
+	m_sonority.addDiatonic(m_notes.back().getBase7());
+	m_sonority.addBase40(m_notes.back().getBase40());
 	// not dealing with lowest note
 }
 
@@ -113494,8 +118879,11 @@ void MSearchQueryToken::parseHarmonicQuery(void) {
 	}
 
 	hquery.resize(hpieces.size());
+	hsonority.clear();
 	for (int i=0; i<(int)hpieces.size(); i++) {
 		hquery[i].setString(hpieces[i]);
+		hsonority.addDiatonic(hquery[i].getBase7());
+		hsonority.addBase40(hquery[i].getBase40());
 	}
 }
 
@@ -113616,98 +119004,30 @@ void Tool_msearch::initialize(void) {
 
 
 
-//////////////////////////////
-//
-// Tool_msearch::fillWords --
-//
-
-void Tool_msearch::fillWords(HumdrumFile& infile, vector<TextInfo*>& words) {
-	vector<HTp> textspines;
-	infile.getSpineStartList(textspines, "**silbe");
-	if (textspines.empty()) {
-		infile.getSpineStartList(textspines, "**text");
-	}
-	for (int i=0; i<(int)textspines.size(); i++) {
-		fillWordsForTrack(words, textspines[i]);
-	}
-}
-
-
-
-//////////////////////////////
-//
-// Tool_msearch::fillWordsForTrack --
-//
-
-void Tool_msearch::fillWordsForTrack(vector<TextInfo*>& words,
-		HTp starttoken) {
-	HTp tok = starttoken->getNextToken();
-	while (tok != NULL) {
-		if (tok->empty()) {
-			tok = tok->getNextToken();
-			continue;
-		}
-		if (tok->isNull()) {
-			tok = tok->getNextToken();
-			continue;
-		}
-		if (!tok->isData()) {
-			tok = tok->getNextToken();
-			continue;
-		}
-		if (tok->at(0) == '-') {
-			// append a syllable to the end of previous word
-			if (!words.empty()) {
-				words.back()->fullword += tok->substr(1, string::npos);
-				if (words.back()->fullword.back() == '-') {
-					words.back()->fullword.pop_back();
-				}
-			}
-			tok = tok->getNextToken();
-			continue;
-		} else {
-			// start a new word
-			TextInfo* temp = new TextInfo();
-			temp->nexttoken = NULL;
-			if (!words.empty()) {
-				words.back()->nexttoken = tok;
-			}
-			temp->fullword = *tok;
-			if (!temp->fullword.empty()) {
-				if (temp->fullword.back() == '-') {
-					temp->fullword.pop_back();
-				}
-			}
-			temp->starttoken = tok;
-			words.push_back(temp);
-			tok = tok->getNextToken();
-			continue;
-		}
-	}
-}
-
-
-
 //////////////////////////////
 //
 // Tool_msearch::doTextSearch -- do a basic text search of all parts.
+//     The words of the file are collected in a HumLyricIndex, so that
+//     each query is only compared once to each distinct word.
 //
 
 void Tool_msearch::doTextSearch(HumdrumFile& infile, NoteGrid& grid,
 		vector<MSearchTextQuery>& query) {
 
-	vector<TextInfo*> words;
-	words.reserve(10000);
-	fillWords(infile, words);
+	HumLyricIndex index;
+	index.addFile(infile);
 	int tcount = 0;
 
-	HumRegex hre;
+	TextInfo word;
 	for (int i=0; i<(int)query.size(); i++) {
-		for (int j=0; j<(int)words.size(); j++) {
-			if (hre.search(words.at(j)->fullword, query.at(i).word, "i")) {
-				tcount++;
-				markTextMatch(infile, *words[j]);
-			}
+		vector<int> entries = index.findRegex(query.at(i).word);
+		for (int j=0; j<(int)entries.size(); j++) {
+			int next = index.getNextEntry(entries[j]);
+			word.fullword = index.getEntry(entries[j]).word;
+			word.starttoken = index.getToken(entries[j], infile);
+			word.nexttoken = next < 0 ? NULL : index.getToken(next, infile);
+			tcount++;
+			markTextMatch(infile, word);
 		}
 	}
 
@@ -113742,11 +119062,6 @@ void Tool_msearch::doTextSearch(HumdrumFile& infile, NoteGrid& grid,
 		infile.createLinesFromTokens();
 	}
 
-	for (int i=0; i<(int)words.size(); i++) {
-		delete words[i];
-		words[i] = NULL;
-	}
-
 	if (!m_quietQ) {
 		addTextSearchSummary(infile, tcount, m_marker);
 	}
@@ -114419,17 +119734,30 @@ bool Tool_msearch::doHarmonicPitchSearch(MSearchQueryToken& query, HTp token) {
 		onlyQ = true;
 	}
 
+	// Reject the sonority with pitch-class mask lookups if any pitch class
+	// in the query is missing, before collecting notes to mark.
+	const HumSonority& present = sonorities.getSonority();
+	for (int i=0; i<(int)query.hquery.size(); i++) {
+		if (query.hquery[i].hasAccidental()) {
+			if (!present.hasBase40(query.hquery[i].getBase40())) {
+				return false;
+			}
+		} else if (!present.hasDiatonic(query.hquery[i].getBase7())) {
+			return false;
+		}
+	}
+	if (onlyQ) {
+		// All notes in the sonority must be in the query.
+		int extra = present.getDiatonicMask() & ~query.hsonority.getDiatonicMask();
+		if (extra) {
+			return false;
+		}
+	}
+
 	vector<int> diatonicCountsQuery(7, 0);
 	vector<int> diatonicCountsMatch(7, 0);
-	vector<int> diatonicCountsData(7, 0);
 	vector<int> chromaticCountsQuery(40, 0);
 	vector<int> chromaticCountsMatch(40, 0);
-	vector<int> chromaticCountsData(40, 0);
-
-	for (int i=0; i<sonorities.getNoteCount(); i++) {
-		diatonicCountsData.at(sonorities[i].getBase7Pc())++;
-		chromaticCountsData.at(sonorities[i].getBase40Pc())++;
-	}
 
 	int sum = 0;
 	for(int i=0; i<(int)query.hquery.size(); i++) {
@@ -114494,18 +119822,6 @@ bool Tool_msearch::doHarmonicPitchSearch(MSearchQueryToken& query, HTp token) {
 				return false;
 			}
 		}
-	} else if (onlyQ) {
-		SonorityDatabase son2;
-		for (int i=0; i<(int)query.hpieces.size(); i++) {
-			son2.addNote(query.hpieces[i]);
-		}
-
-		for (int k=0; k<sonorities.getNoteCount(); k++) {
-			int status2 = checkHarmonicPitchMatch(sonorities[k], son2, true);
-			if (!status2) {
-				return false;
-			}
-		}
 	}
 
 	return true;
@@ -125877,6 +131193,57 @@ void Tool_pbar::addBarLineToFollowingNoteOrRest(HTp token) {
 
 
 
+
+//////////////////////////////
+//
+// PccountHistogram::clear -- Remove all voices.
+//
+
+void PccountHistogram::clear(void) {
+	names.clear();
+	counts.clear();
+}
+
+
+
+//////////////////////////////
+//
+// PccountHistogram::getVoiceIndex -- Return the index of the voice with
+//     the given instrument name, adding the voice if it is not yet in
+//     the histogram.
+//
+
+int PccountHistogram::getVoiceIndex(const string& name) {
+	for (int i=0; i<(int)names.size(); i++) {
+		if (names[i] == name) {
+			return i;
+		}
+	}
+	names.push_back(name);
+	counts.emplace_back(40, 0.0);
+	return (int)names.size() - 1;
+}
+
+
+
+//////////////////////////////
+//
+// PccountHistogram::merge -- Add the counts of another histogram.  Voices
+//     with the same instrument name are combined, and new voices are added
+//     after the current ones.
+//
+
+void PccountHistogram::merge(const PccountHistogram& histogram) {
+	for (int i=0; i<(int)histogram.names.size(); i++) {
+		int index = getVoiceIndex(histogram.names[i]);
+		for (int j=0; j<(int)histogram.counts[i].size(); j++) {
+			counts[index][j] += histogram.counts[i][j];
+		}
+	}
+}
+
+
+
 /////////////////////////////////
 //
 // Tool_gridtest::Tool_pccount -- Set the recognized options for the tool.
@@ -125884,6 +131251,7 @@ void Tool_pbar::addBarLineToFollowingNoteOrRest(HTp token) {
 
 Tool_pccount::Tool_pccount(void) {
 	define("a|attacks=b",                 "count attacks instead of durations");
+	define("C|corpus=b",                  "combine counts of all inputs by instrument name");
 	define("d|data|vega-data=b",          "display the vega-lite template.");
 	define("f|full=b",                    "full count attacks all single sharps and flats.");
 	define("ff|double-full=b",            "full count attacks all double sharps and flats.");
@@ -125908,6 +131276,19 @@ Tool_pccount::Tool_pccount(void) {
 //
 
 bool Tool_pccount::run(HumdrumFileSet& infiles) {
+	if (getBoolean("corpus") && (infiles.getCount() > 1)) {
+		// Count the files in parallel, then merge the counts in input order.
+		initialize(infiles[0]);
+		vector<PccountHistogram> histograms(infiles.getCount());
+		HumThreadPool pool;
+		pool.run(infiles.getCount(), [&](int index) {
+			fillHistogram(infiles[index], histograms[index]);
+		});
+		for (int i=0; i<(int)histograms.size(); i++) {
+			m_histogram.merge(histograms[i]);
+		}
+		return true;
+	}
 	bool status = true;
 	for (int i=0; i<infiles.getCount(); i++) {
 		status &= run(infiles[i]);
@@ -125929,13 +131310,78 @@ bool Tool_pccount::run(HumdrumFile& infile, ostream& out) {
 
 
 bool Tool_pccount::run(HumdrumFile& infile) {
-   initialize(infile);
+	initialize(infile);
+	if (m_corpus) {
+		PccountHistogram histogram;
+		fillHistogram(infile, histogram);
+		m_histogram.merge(histogram);
+		return true;
+	}
 	processFile(infile);
 	return true;
 }
 
 
 
+//////////////////////////////
+//
+// Tool_pccount::getSegmentBatchSize -- With the --corpus option, read several
+//     segments at a time in STREAM_INTERFACE so that they are counted in
+//     parallel by run(HumdrumFileSet&).
+//
+
+int Tool_pccount::getSegmentBatchSize(void) {
+	if (getBoolean("corpus")) {
+		return 4 * HumThreadPool::getHardwareThreads();
+	}
+	return 1;
+}
+
+
+
+//////////////////////////////
+//
+// Tool_pccount::finally -- Print the combined counts of all inputs
+//     for the --corpus option.
+//
+
+void Tool_pccount::finally(void) {
+	if (!m_corpus || m_histogram.names.empty()) {
+		return;
+	}
+	loadHistogram();
+	HumdrumFile empty;
+	printOutput(empty);
+	m_histogram.clear();
+}
+
+
+
+//////////////////////////////
+//
+// Tool_pccount::getHistogram -- Return the combined counts of the inputs
+//     for the --corpus option.
+//
+
+const PccountHistogram& Tool_pccount::getHistogram(void) const {
+	return m_histogram;
+}
+
+
+
+//////////////////////////////
+//
+// Tool_pccount::mergeHistogram -- Add counts (such as from another
+//     instance of the tool) to the combined counts for the --corpus
+//     option.
+//
+
+void Tool_pccount::mergeHistogram(const PccountHistogram& histogram) {
+	m_histogram.merge(histogram);
+}
+
+
+
 //////////////////////////////
 //
 // Tool_pccount::initialize --
@@ -125943,6 +131389,7 @@ bool Tool_pccount::run(HumdrumFile& infile) {
 
 void Tool_pccount::initialize(HumdrumFile& infile) {
 	m_attack     = getBoolean("attacks");
+	m_corpus     = getBoolean("corpus");
 	m_full       = getBoolean("full");
 	m_doublefull = getBoolean("double-full");
 	m_normalize  = getBoolean("normalize");
@@ -125960,7 +131407,7 @@ void Tool_pccount::initialize(HumdrumFile& infile) {
 	m_page       = getBoolean("page");
 	if (getBoolean("id")) {
 		m_id = getString("id");
-	} else {
+	} else if (!m_corpus) {
 		string filename = infile.getFilename();
 	 	auto pos = filename.rfind("/");
 		if (pos != string::npos) {
@@ -126066,7 +131513,17 @@ string Tool_pccount::getFinal(HumdrumFile& infile) {
 
 void Tool_pccount::processFile(HumdrumFile& infile) {
 	countPitches(infile);
+	printOutput(infile);
+}
+
 
+
+//////////////////////////////
+//
+// Tool_pccount::printOutput -- Print the counts in the requested format.
+//
+
+void Tool_pccount::printOutput(HumdrumFile& infile) {
 	string datavar;
 	string target;
 	string jsonvar;
@@ -126346,7 +131803,11 @@ void Tool_pccount::countPitches(HumdrumFile& infile) {
 	for (int i=0; i<infile.getStrandCount(); i++) {
 		HTp sstart = infile.getStrandStart(i);
 		HTp send = infile.getStrandEnd(i);
-		addCounts(sstart, send);
+		if ((!sstart) || (!sstart->isKern())) {
+			continue;
+		}
+		int kindex = m_rkern[sstart->getTrack()];
+		addCounts(sstart, send, m_counts[kindex]);
 	}
 
 	// fill in sum for all parts
@@ -126359,20 +131820,80 @@ void Tool_pccount::countPitches(HumdrumFile& infile) {
 }
 
 
+
 //////////////////////////////
 //
-// Tool_pccount::addCounts --
+// Tool_pccount::fillHistogram -- Count the pitch classes of a file by
+//     instrument name (or "voice N" for the Nth **kern spine if it has
+//     no name).  This only uses the counting options of the tool, so
+//     files can be counted in parallel.
 //
 
-void Tool_pccount::addCounts(HTp sstart, HTp send) {
-	if (!sstart) {
-		return;
+void Tool_pccount::fillHistogram(HumdrumFile& infile, PccountHistogram& histogram) {
+	vector<int> rkern(infile.getTrackCount() + 1, -1);
+	vector<HTp> starts = infile.getKernSpineStartList();
+	for (int i=0; i<(int)starts.size(); i++) {
+		string name;
+		HTp current = starts[i];
+		while (current && !current->isData()) {
+			if (current->compare(0, 3, "*I\"") == 0) {
+				name = current->substr(3);
+				break;
+			}
+			current = current->getNextToken();
+		}
+		if (name.empty()) {
+			name = "voice " + to_string(i + 1);
+		}
+		rkern[starts[i]->getTrack()] = histogram.getVoiceIndex(name);
 	}
-	if (!sstart->isKern()) {
-		return;
+
+	for (int i=0; i<infile.getStrandCount(); i++) {
+		HTp sstart = infile.getStrandStart(i);
+		HTp send = infile.getStrandEnd(i);
+		if ((!sstart) || (!sstart->isKern())) {
+			continue;
+		}
+		int index = rkern[sstart->getTrack()];
+		if (index < 0) {
+			continue;
+		}
+		addCounts(sstart, send, histogram.counts[index]);
 	}
-	int track = sstart->getTrack();
-	int kindex = m_rkern[track];
+}
+
+
+
+//////////////////////////////
+//
+// Tool_pccount::loadHistogram -- Use the combined counts of the --corpus
+//     option for printing, with the sum of all voices first.
+//
+
+void Tool_pccount::loadHistogram(void) {
+	m_names.clear();
+	m_abbreviations.clear();
+	m_counts.clear();
+	m_names.push_back("all");
+	m_counts.emplace_back(40, 0.0);
+	for (int i=0; i<(int)m_histogram.names.size(); i++) {
+		m_names.push_back(m_histogram.names[i]);
+		m_counts.push_back(m_histogram.counts[i]);
+		for (int j=0; j<(int)m_counts[0].size(); j++) {
+			m_counts[0][j] += m_histogram.counts[i][j];
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// Tool_pccount::addCounts -- Add the pitch classes of a strand to the
+//     counts.
+//
+
+void Tool_pccount::addCounts(HTp sstart, HTp send, vector<double>& counts) {
 	HTp current = sstart;
 	while (current && (current != send)) {
 		if (!current->isData()) {
@@ -126396,10 +131917,10 @@ void Tool_pccount::addCounts(HTp sstart, HTp send) {
 			}
 			int b40 = Convert::kernToBase40(subtokens[i]);
 			if (m_attack) {
-				m_counts[kindex][b40%40]++;
+				counts[b40%40]++;
 			} else {
 				double duration = Convert::recipToDuration(subtokens[i]).getFloat();
-				m_counts[kindex][b40%40] += duration;
+				counts[b40%40] += duration;
 			}
 		}
 		current = current->getNextToken();
@@ -129079,6 +134600,27 @@ void _VoiceInfo::clear(void) {
 }
 
 
+
+//////////////////////////////
+//
+// _VoiceInfo::add -- Add the histograms and finals of another voice.
+//
+
+void _VoiceInfo::add(const _VoiceInfo& info) {
+	for (int i=0; i<(int)midibins.size(); i++) {
+		midibins[i] += info.midibins.at(i);
+	}
+	for (int i=0; i<(int)diatonic.size(); i++) {
+		for (int j=0; j<(int)diatonic[i].size(); j++) {
+			diatonic[i][j] += info.diatonic.at(i).at(j);
+		}
+	}
+	diafinal.insert(diafinal.end(), info.diafinal.begin(), info.diafinal.end());
+	accfinal.insert(accfinal.end(), info.accfinal.begin(), info.accfinal.end());
+	namfinal.insert(namfinal.end(), info.namfinal.begin(), info.namfinal.end());
+}
+
+
 //////////////////////////////
 //
 // _VoiceInfo::print --
@@ -129129,6 +134671,7 @@ Tool_prange::Tool_prange(void) {
 	define("S|score=b",                 "convert range info to SCORE");
 	define("T|no-title=b",              "do not display a title");
 	define("a|all=b",                   "generate all-voice analysis");
+	define("C|corpus=b",                "combine histograms of all inputs by voice (or instrument with -i)");
 	define("c|range|count=s:60-71",     "count notes in a particular MIDI note number range (inclusive)");
 	define("debug=b",                   "trace input parsing");
 	define("d|duration=b",              "weight pitches by duration");
@@ -129159,6 +134702,21 @@ Tool_prange::Tool_prange(void) {
 //
 
 bool Tool_prange::run(HumdrumFileSet& infiles) {
+	if (getBoolean("corpus") && (infiles.getCount() > 1)) {
+		// Fill the histograms of the files in parallel, then merge them
+		// in input order.
+		initialize();
+		vector<vector<_VoiceInfo>> voiceInfo(infiles.getCount());
+		HumThreadPool pool;
+		pool.run(infiles.getCount(), [&](int index) {
+			getVoiceInfo(voiceInfo[index], infiles[index]);
+			fillHistograms(voiceInfo[index], infiles[index]);
+		});
+		for (int i=0; i<(int)voiceInfo.size(); i++) {
+			mergeCorpusVoiceInfo(voiceInfo[i]);
+		}
+		return true;
+	}
 	bool status = true;
 	for (int i=0; i<infiles.getCount(); i++) {
 		status &= run(infiles[i]);
@@ -129192,12 +134750,52 @@ bool Tool_prange::run(HumdrumFile& infile, ostream& out) {
 
 bool Tool_prange::run(HumdrumFile& infile) {
 	initialize();
+	if (m_corpusQ) {
+		vector<_VoiceInfo> voiceInfo;
+		getVoiceInfo(voiceInfo, infile);
+		fillHistograms(voiceInfo, infile);
+		mergeCorpusVoiceInfo(voiceInfo);
+		return true;
+	}
 	processFile(infile);
 	return true;
 }
 
 
 
+//////////////////////////////
+//
+// Tool_prange::getSegmentBatchSize -- With the --corpus option, read several
+//     segments at a time in STREAM_INTERFACE so that they are analyzed in
+//     parallel by run(HumdrumFileSet&).
+//
+
+int Tool_prange::getSegmentBatchSize(void) {
+	if (getBoolean("corpus")) {
+		return 4 * HumThreadPool::getHardwareThreads();
+	}
+	return 1;
+}
+
+
+
+//////////////////////////////
+//
+// Tool_prange::finally -- Print the combined histograms of all inputs
+//     for the --corpus option.
+//
+
+void Tool_prange::finally(void) {
+	if (!m_corpusQ || m_corpusInfo.empty()) {
+		return;
+	}
+	printCorpusAnalysis();
+	m_corpusInfo.clear();
+	m_corpusKeys.clear();
+}
+
+
+
 //////////////////////////////
 //
 // Tool_prange::initialize --  Initializations that only have to be done once
@@ -129208,6 +134806,7 @@ void Tool_prange::initialize(void) {
 	m_accQ         = getBoolean("color-accidentals");
 	m_addFractionQ = getBoolean("fraction");
 	m_allQ         = getBoolean("all");
+	m_corpusQ      = getBoolean("corpus");
 	m_debugQ       = getBoolean("debug");
 	m_defineQ      = false;
 	m_diatonicQ    = getBoolean("diatonic");
@@ -129481,6 +135080,86 @@ void Tool_prange::mergeAllVoiceInfo(vector<_VoiceInfo>& voiceInfo) {
 
 
 
+//////////////////////////////
+//
+// Tool_prange::mergeCorpusVoiceInfo -- Add the **kern voices of a file to
+//     the combined histograms of the --corpus option.  Voices are matched
+//     by their position in the file, or by instrument name with the
+//     --instrument option (unnamed voices are then matched by position).
+//
+
+void Tool_prange::mergeCorpusVoiceInfo(vector<_VoiceInfo>& voiceInfo) {
+	if (m_corpusInfo.empty()) {
+		m_corpusInfo.resize(1);
+		m_corpusInfo[0].name  = "all";
+		m_corpusInfo[0].abbr  = "all";
+		m_corpusInfo[0].track = 0;
+		m_corpusInfo[0].index = 0;
+		m_corpusKeys.resize(1);
+	}
+
+	int voice = 0;
+	for (int i=1; i<(int)voiceInfo.size(); i++) {
+		if (!voiceInfo[i].kernQ) {
+			continue;
+		}
+		voice++;
+		string key;
+		if (m_instrumentQ && !voiceInfo[i].name.empty()) {
+			key = "*I\"" + voiceInfo[i].name;
+		} else {
+			key = to_string(voice);
+		}
+		auto it = std::find(m_corpusKeys.begin(), m_corpusKeys.end(), key);
+		if (it != m_corpusKeys.end()) {
+			m_corpusInfo[it - m_corpusKeys.begin()].add(voiceInfo[i]);
+			continue;
+		}
+		int index = (int)m_corpusInfo.size();
+		m_corpusInfo.push_back(voiceInfo[i]);
+		m_corpusInfo.back().index = index;
+		m_corpusInfo.back().track = index;
+		m_corpusKeys.push_back(key);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// Tool_prange::printCorpusAnalysis -- Print the combined histograms of
+//     the --corpus option.  Reference records and key signatures are not
+//     used since they differ between the inputs.
+//
+
+void Tool_prange::printCorpusAnalysis(void) {
+	vector<_VoiceInfo>& voiceInfo = m_corpusInfo;
+	voiceInfo[0].clear();
+	voiceInfo[0].name  = "all";
+	voiceInfo[0].abbr  = "all";
+	voiceInfo[0].track = 0;
+	voiceInfo[0].index = 0;
+	mergeAllVoiceInfo(voiceInfo);
+	m_refmap.clear();
+
+	if (m_debugQ) {
+		for (int i=0; i<(int)voiceInfo.size(); i++) {
+			voiceInfo[i].print(cerr);
+		}
+	}
+
+	if (m_scoreQ) {
+		HumdrumFile empty;
+		stringstream scoreout;
+		printScoreFile(scoreout, voiceInfo, empty);
+		m_humdrum_text << scoreout.str();
+	} else {
+		printAnalysis(m_humdrum_text, voiceInfo[0].midibins);
+	}
+}
+
+
+
 //////////////////////////////
 //
 // Tool_prange::getVoiceInfo -- get names and track info for **kern spines.
@@ -131671,6 +137350,18 @@ Tool_rid::Tool_rid(void) {
 
 
 
+//////////////////////////////
+//
+// Tool_rid::isReusable -- Instances can be run on several files.
+//     Options are read again for each file, and no other data is kept.
+//
+
+bool Tool_rid::isReusable(void) {
+	return true;
+}
+
+
+
 /////////////////////////////////
 //
 // Tool_rid::run -- Do the main work of the tool.
@@ -136132,6 +141823,18 @@ Tool_shed::Tool_shed(void) {
 
 
 
+//////////////////////////////
+//
+// Tool_shed::isReusable -- Instances can be run on several files.
+//     Search expressions are prepared again for each file.
+//
+
+bool Tool_shed::isReusable(void) {
+	return true;
+}
+
+
+
 /////////////////////////////////
 //
 // Tool_shed::run -- Do the main work of the tool.
@@ -136233,6 +141936,11 @@ void Tool_shed::prepareSearch(int index) {
 	m_exinterp = false;        // process exclusive interpretations
 	m_interpretation = false;  // process interpretations (other than exinterp
 	                           //     and spine manipulators).
+	m_localcomment = false;    // process local comments
+	m_globalcomment = false;   // process global comments
+	m_reference = false;       // process reference records
+	m_referencekey = false;    // process reference record keys
+	m_referencevalue = false;  // process reference record values
 
 	if (m_option.find("I") != std::string::npos) {
 		m_interpretation = true;
@@ -136293,6 +142001,9 @@ void Tool_shed::initialize(void) {
 		parseExpression(value);
 	}
 	m_exclusion = getString("exclusion-expression");
+	if (!m_exclusion.empty()) {
+		m_exclusionRegex = regex(m_exclusion);
+	}
 
 	if (getBoolean("X")) {
 		m_xInterp = getExInterp(getString("X"));
@@ -136303,6 +142014,7 @@ void Tool_shed::initialize(void) {
 	if (getBoolean("Z")) {
 		m_zInterp = getExInterp(getString("Z"));
 	}
+	prepareExpressions();
 }
 
 
@@ -136464,13 +142176,120 @@ vector<string> Tool_shed::addToExInterpList(void) {
 
 //////////////////////////////
 //
-// Tool_shed::processFile --
+// Tool_shed::prepareExpressions -- Prepare the options of each expression
+//     and compile its regular expressions, so that they do not have to be
+//     compiled again for each token.
 //
 
-void Tool_shed::processFile(HumdrumFile& infile) {
+void Tool_shed::prepareExpressions(void) {
+	m_expressions.clear();
+	m_expressions.resize(m_options.size());
 	for (int i=0; i<(int)m_options.size(); i++) {
 		prepareSearch(i);
-		processExpression(infile);
+		ShedExpression& expression = m_expressions[i];
+		expression.search         = m_search;
+		expression.replace        = m_replace;
+		expression.grepoptions    = m_grepoptions;
+		expression.exinterps      = m_exinterps;
+		expression.data           = m_data;
+		expression.barline        = m_barline;
+		expression.exinterp       = m_exinterp;
+		expression.interpretation = m_interpretation;
+		expression.localcomment   = m_localcomment;
+		expression.globalcomment  = m_globalcomment;
+		expression.reference      = m_reference;
+		expression.referencekey   = m_referencekey;
+		expression.referencevalue = m_referencevalue;
+		if (m_search.empty()) {
+			continue;
+		}
+
+		std::regex_constants::syntax_option_type flags = std::regex_constants::ECMAScript;
+		if (m_grepoptions.find("i") != std::string::npos) {
+			flags |= std::regex_constants::icase;
+		}
+		if (m_grepoptions.find("g") != std::string::npos) {
+			expression.replaceFlags = std::regex_constants::format_default;
+		} else {
+			expression.replaceFlags = std::regex_constants::format_first_only;
+		}
+
+		// searches that follow the signifier of the record type:
+		string anchor;
+		string search;
+		if (m_search[0] == '^') {
+			anchor = "";
+			search = m_search.substr(1);
+		} else {
+			anchor = ".*";
+			search = m_search;
+		}
+
+		expression.searchRegex = regex(m_search, flags);
+		if (expression.barline) {
+			expression.barlineRegex = regex("^=" + anchor + search, flags);
+		}
+		if (expression.interpretation) {
+			expression.interpretationRegex = regex("^\\*" + anchor + search, flags);
+		}
+		if (expression.localcomment) {
+			expression.localCommentRegex = regex("^!" + anchor + search, flags);
+		}
+		if (expression.globalcomment) {
+			expression.globalCommentRegex = regex("^!!" + anchor + search, flags);
+		}
+		if (expression.reference) {
+			expression.referenceRegex = regex("^!!!" + anchor + search, flags);
+		}
+		if (expression.exinterp) {
+			expression.exinterpRegex = regex("^\\*\\*" + anchor + search, flags);
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// Tool_shed::needsSequentialProcessing -- Returns true if the expressions
+//     have to be applied one at a time to the whole file.  This is only
+//     needed when an expression changes exclusive interpretations and an
+//     expression is limited to particular data types, since changing an
+//     exclusive interpretation changes the data type of the rest of the
+//     spine.  Otherwise all expressions can be applied to each line in turn.
+//
+
+bool Tool_shed::needsSequentialProcessing(void) {
+	bool exinterpQ = false;
+	bool datatypeQ = false;
+	for (int i=0; i<(int)m_expressions.size(); i++) {
+		if (m_expressions[i].search.empty()) {
+			continue;
+		}
+		if (m_expressions[i].exinterp) {
+			exinterpQ = true;
+		}
+		if (!m_expressions[i].exinterps.empty()) {
+			datatypeQ = true;
+		}
+	}
+	return exinterpQ && datatypeQ;
+}
+
+
+
+//////////////////////////////
+//
+// Tool_shed::processFile --
+//
+
+void Tool_shed::processFile(HumdrumFile& infile) {
+	if (needsSequentialProcessing()) {
+		for (int i=0; i<(int)m_expressions.size(); i++) {
+			processExpression(infile, m_expressions[i]);
+		}
+	} else {
+		processLines(infile);
 	}
 	m_humdrum_text << infile;
 }
@@ -136479,53 +142298,71 @@ void Tool_shed::processFile(HumdrumFile& infile) {
 
 //////////////////////////////
 //
-// Tool_shed::processExpression --
+// Tool_shed::processExpression -- Apply an expression to the whole file.
 //
 
-void Tool_shed::processExpression(HumdrumFile& infile) {
-	if (m_search == "") {
+void Tool_shed::processExpression(HumdrumFile& infile, ShedExpression& expression) {
+	if (expression.search == "") {
 		// nothing to do
 		return;
 	}
-	m_modified = false;
+	bool modified = false;
 
-	if (m_interpretation) {
-		searchAndReplaceInterpretation(infile);
+	if (expression.interpretation) {
+		for (int i=0; i<infile.getLineCount(); i++) {
+			modified |= searchAndReplaceInterpretation(infile, i, expression);
+		}
 	}
 
-	if (m_localcomment) {
-		searchAndReplaceLocalComment(infile);
+	if (expression.localcomment) {
+		for (int i=0; i<infile.getLineCount(); i++) {
+			modified |= searchAndReplaceLocalComment(infile, i, expression);
+		}
 	}
 
-	if (m_globalcomment) {
-		searchAndReplaceGlobalComment(infile);
+	if (expression.globalcomment) {
+		for (int i=0; i<infile.getLineCount(); i++) {
+			modified |= searchAndReplaceGlobalComment(infile, i, expression);
+		}
 	}
 
-	if (m_reference) {
-		searchAndReplaceReferenceRecords(infile);
+	if (expression.reference) {
+		for (int i=0; i<infile.getLineCount(); i++) {
+			modified |= searchAndReplaceReferenceRecords(infile, i, expression);
+		}
 	}
 
-	if (m_referencekey) {
-		searchAndReplaceReferenceKeys(infile);
+	if (expression.referencekey) {
+		for (int i=0; i<infile.getLineCount(); i++) {
+			modified |= searchAndReplaceReferenceKeys(infile, i, expression);
+		}
 	}
 
-	if (m_referencevalue) {
-		searchAndReplaceReferenceValues(infile);
+	if (expression.referencevalue) {
+		for (int i=0; i<infile.getLineCount(); i++) {
+			modified |= searchAndReplaceReferenceValues(infile, i, expression);
+		}
 	}
 
-	if (m_exinterp) {
-		searchAndReplaceExinterp(infile);
+	if (expression.exinterp) {
+		for (int i=0; i<infile.getLineCount(); i++) {
+			modified |= searchAndReplaceExinterp(infile, i, expression);
+		}
 	}
 
-	if (m_barline) {
-		searchAndReplaceBarline(infile);
+	if (expression.barline) {
+		for (int i=0; i<infile.getLineCount(); i++) {
+			modified |= searchAndReplaceBarline(infile, i, expression);
+		}
 	}
 
-	if (m_data) {
-		searchAndReplaceData(infile);
+	if (expression.data) {
+		for (int i=0; i<infile.getLineCount(); i++) {
+			modified |= searchAndReplaceData(infile, i, expression);
+		}
 	}
 
-	if (m_modified) {
+	if (modified) {
 		infile.createLinesFromTokens();
 	}
 }
@@ -136534,326 +142371,380 @@ void Tool_shed::processExpression(HumdrumFile& infile) {
 
 //////////////////////////////
 //
-// Tool_shed::searchAndReplaceBarline --
+// Tool_shed::processLines -- Apply all expressions to each line in turn,
+//     which gives the same result as applying each expression to the whole
+//     file before the next one (see needsSequentialProcessing()).  The text
+//     of a line is updated after each expression that changes it, since
+//     the type of a line and the keys and values of reference records are
+//     taken from the line text.
 //
 
-void Tool_shed::searchAndReplaceBarline(HumdrumFile& infile) {
-	string isearch;
-	if (m_search[0] == '^') {
-		isearch = "^=" + m_search.substr(1);
-	} else {
-		isearch = "^=.*" + m_search;
-	}
-	HumRegex hre;
+void Tool_shed::processLines(HumdrumFile& infile) {
+	bool modified = false;
 	for (int i=0; i<infile.getLineCount(); i++) {
-		if (!infile[i].isBarline()) {
-			continue;
-		}
-		for (int j=0; j<infile[i].getFieldCount(); j++) {
-			HTp token = infile.token(i, j);
-			if (token->isNull()) {
-				// Don't mess with null interpretations
-				continue;
-			}
-			if (!isValid(token)) {
-				continue;
-			}
-			if (hre.search(token, isearch, m_grepoptions)) {
-				string text = token->getText().substr(1);
-				hre.replaceDestructive(text, m_replace, m_search, m_grepoptions);
-				hre.replaceDestructive(text, "", "^=+");
-				text = "=" + text;
-				token->setText(text);
-				m_modified = true;
+		for (int j=0; j<(int)m_expressions.size(); j++) {
+			if (processLine(infile, i, m_expressions[j])) {
+				infile[i].createLineFromTokens();
+				modified = true;
 			}
 		}
 	}
+	if (modified) {
+		infile.createLinesFromTokens();
+	}
 }
 
 
 
 //////////////////////////////
 //
-// Tool_shed::searchAndReplaceInterpretation --
+// Tool_shed::processLine -- Apply an expression to a single line, with
+//     the record types processed in the same order as processExpression().
+//     Returns true if the line was changed.
 //
 
-void Tool_shed::searchAndReplaceInterpretation(HumdrumFile& infile) {
-	string isearch;
-	if (m_search[0] == '^') {
-		isearch = "^\\*" + m_search.substr(1);
-	} else {
-		isearch = "^\\*.*" + m_search;
+bool Tool_shed::processLine(HumdrumFile& infile, int index, ShedExpression& expression) {
+	if (expression.search == "") {
+		// nothing to do
+		return false;
 	}
-	HumRegex hre;
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (!infile[i].isInterpretation()) {
-			continue;
-		} else if (infile[i].isExclusiveInterpretation()) {
-			continue;
-		} else if (infile[i].isManipulator()) {
-			continue;
-		}
-		for (int j=0; j<infile[i].getFieldCount(); j++) {
-			HTp token = infile.token(i, j);
-			if (token->isNull()) {
-				// Don't mess with null interpretations
-				continue;
-			}
-			if (!isValid(token)) {
-				continue;
-			}
-			if (hre.search(token, isearch, m_grepoptions)) {
-				string text = token->getText().substr(1);
-				hre.replaceDestructive(text, m_replace, m_search, m_grepoptions);
-				hre.replaceDestructive(text, "", "^\\*+");
-				text = "*" + text;
-				token->setText(text);
-				m_modified = true;
-			}
-		}
+	bool modified = false;
+	if (expression.interpretation) {
+		modified |= searchAndReplaceInterpretation(infile, index, expression);
+	}
+	if (expression.localcomment) {
+		modified |= searchAndReplaceLocalComment(infile, index, expression);
+	}
+	if (expression.globalcomment) {
+		modified |= searchAndReplaceGlobalComment(infile, index, expression);
+	}
+	if (expression.reference) {
+		modified |= searchAndReplaceReferenceRecords(infile, index, expression);
+	}
+	if (expression.referencekey) {
+		modified |= searchAndReplaceReferenceKeys(infile, index, expression);
 	}
+	if (expression.referencevalue) {
+		modified |= searchAndReplaceReferenceValues(infile, index, expression);
+	}
+	if (expression.exinterp) {
+		modified |= searchAndReplaceExinterp(infile, index, expression);
+	}
+	if (expression.barline) {
+		modified |= searchAndReplaceBarline(infile, index, expression);
+	}
+	if (expression.data) {
+		modified |= searchAndReplaceData(infile, index, expression);
+	}
+	return modified;
 }
 
 
 
 //////////////////////////////
 //
-// Tool_shed::searchAndReplaceLocalComment --
+// Tool_shed::searchAndReplaceBarline -- Returns true if the line was changed.
 //
 
-void Tool_shed::searchAndReplaceLocalComment(HumdrumFile& infile) {
-	string isearch;
-	if (m_search[0] == '^') {
-		isearch = "^!" + m_search.substr(1);
-	} else {
-		isearch = "^!.*" + m_search;
+bool Tool_shed::searchAndReplaceBarline(HumdrumFile& infile, int index,
+		ShedExpression& expression) {
+	static const regex leading("^=+");
+	if (!infile[index].isBarline()) {
+		return false;
 	}
-	HumRegex hre;
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (!infile[i].isLocalComment()) {
+	bool modified = false;
+	for (int j=0; j<infile[index].getFieldCount(); j++) {
+		HTp token = infile.token(index, j);
+		if (token->isNull()) {
+			// Don't mess with null interpretations
 			continue;
 		}
-		for (int j=0; j<infile[i].getFieldCount(); j++) {
-			HTp token = infile.token(i, j);
-			if (token->isNull()) {
-				// Don't mess with null interpretations
-				continue;
-			}
-			if (!isValid(token)) {
-				continue;
-			}
-			if (hre.search(token, isearch, m_grepoptions)) {
-				string text = token->getText().substr(1);
-				hre.replaceDestructive(text, m_replace, m_search, m_grepoptions);
-				hre.replaceDestructive(text, "", "^!+");
-				text = "!" + text;
-				token->setText(text);
-				m_modified = true;
-			}
+		if (!isValid(token, expression)) {
+			continue;
+		}
+		if (regex_search(*token, expression.barlineRegex)) {
+			string text = token->getText().substr(1);
+			text = regex_replace(text, expression.searchRegex, expression.replace,
+					expression.replaceFlags);
+			text = regex_replace(text, leading, "", std::regex_constants::format_first_only);
+			text = "=" + text;
+			token->setText(text);
+			modified = true;
 		}
 	}
+	return modified;
 }
 
 
 
 //////////////////////////////
 //
-// Tool_shed::searchAndReplaceGlobalComment --
+// Tool_shed::searchAndReplaceInterpretation -- Returns true if the line
+//     was changed.
 //
 
-void Tool_shed::searchAndReplaceGlobalComment(HumdrumFile& infile) {
-	string isearch;
-	if (m_search[0] == '^') {
-		isearch = "^!!" + m_search.substr(1);
-	} else {
-		isearch = "^!!.*" + m_search;
+bool Tool_shed::searchAndReplaceInterpretation(HumdrumFile& infile, int index,
+		ShedExpression& expression) {
+	static const regex leading("^\\*+");
+	if (!infile[index].isInterpretation()) {
+		return false;
+	} else if (infile[index].isExclusiveInterpretation()) {
+		return false;
+	} else if (infile[index].isManipulator()) {
+		return false;
 	}
-	HumRegex hre;
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (!infile[i].isGlobalComment()) {
+	bool modified = false;
+	for (int j=0; j<infile[index].getFieldCount(); j++) {
+		HTp token = infile.token(index, j);
+		if (token->isNull()) {
+			// Don't mess with null interpretations
 			continue;
 		}
-		HTp token = infile.token(i, 0);
-		if (token->size() < 3) {
-			// Don't mess with null comments
+		if (!isValid(token, expression)) {
 			continue;
 		}
-		if (hre.search(token, isearch, m_grepoptions)) {
-			string text = token->getText().substr(2);
-			hre.replaceDestructive(text, m_replace, m_search, m_grepoptions);
-			hre.replaceDestructive(text, "", "^!+");
-			text = "!!" + text;
+		if (regex_search(*token, expression.interpretationRegex)) {
+			string text = token->getText().substr(1);
+			text = regex_replace(text, expression.searchRegex, expression.replace,
+					expression.replaceFlags);
+			text = regex_replace(text, leading, "", std::regex_constants::format_first_only);
+			text = "*" + text;
 			token->setText(text);
-			m_modified = true;
+			modified = true;
 		}
 	}
+	return modified;
 }
 
 
 
 //////////////////////////////
 //
-// Tool_shed::searchAndReplaceReferenceRecords --
+// Tool_shed::searchAndReplaceLocalComment -- Returns true if the line
+//     was changed.
 //
 
-void Tool_shed::searchAndReplaceReferenceRecords(HumdrumFile& infile) {
-	string isearch;
-	if (m_search[0] == '^') {
-		isearch = "^!!!" + m_search.substr(1);
-	} else {
-		isearch = "^!!!.*" + m_search;
+bool Tool_shed::searchAndReplaceLocalComment(HumdrumFile& infile, int index,
+		ShedExpression& expression) {
+	static const regex leading("^!+");
+	if (!infile[index].isLocalComment()) {
+		return false;
 	}
-	HumRegex hre;
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (!infile[i].isGlobalReference()) {
+	bool modified = false;
+	for (int j=0; j<infile[index].getFieldCount(); j++) {
+		HTp token = infile.token(index, j);
+		if (token->isNull()) {
+			// Don't mess with null interpretations
 			continue;
 		}
-		HTp token = infile.token(i, 0);
-		if (hre.search(token, isearch, m_grepoptions)) {
+		if (!isValid(token, expression)) {
+			continue;
+		}
+		if (regex_search(*token, expression.localCommentRegex)) {
 			string text = token->getText().substr(1);
-			hre.replaceDestructive(text, m_replace, m_search, m_grepoptions);
-			hre.replaceDestructive(text, "", "^!+");
-			text = "!!!" + text;
+			text = regex_replace(text, expression.searchRegex, expression.replace,
+					expression.replaceFlags);
+			text = regex_replace(text, leading, "", std::regex_constants::format_first_only);
+			text = "!" + text;
 			token->setText(text);
-			m_modified = true;
+			modified = true;
 		}
 	}
+	return modified;
 }
 
 
 
 //////////////////////////////
 //
-// Tool_shed::searchAndReplaceReferenceKeys --
+// Tool_shed::searchAndReplaceGlobalComment -- Returns true if the line
+//     was changed.
 //
 
-void Tool_shed::searchAndReplaceReferenceKeys(HumdrumFile& infile) {
-	string isearch = m_search;
-	HumRegex hre;
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (!infile[i].isGlobalReference()) {
-			continue;
-		}
-		HTp token = infile.token(i, 0);
-		string key = infile[i].getReferenceKey();
-		if (hre.search(key, isearch, m_grepoptions)) {
-			hre.replaceDestructive(key, m_replace, m_search, m_grepoptions);
-			hre.replaceDestructive(key, "", "^!+");
-			hre.replaceDestructive(key, "", ":+$");
-			string value = infile[i].getReferenceValue();
-			string text = "!!!" + key + ": " + value;
-			token->setText(text);
-			m_modified = true;
-		}
+bool Tool_shed::searchAndReplaceGlobalComment(HumdrumFile& infile, int index,
+		ShedExpression& expression) {
+	static const regex leading("^!+");
+	if (!infile[index].isGlobalComment()) {
+		return false;
+	}
+	HTp token = infile.token(index, 0);
+	if (token->size() < 3) {
+		// Don't mess with null comments
+		return false;
+	}
+	if (!regex_search(*token, expression.globalCommentRegex)) {
+		return false;
 	}
+	string text = token->getText().substr(2);
+	text = regex_replace(text, expression.searchRegex, expression.replace,
+			expression.replaceFlags);
+	text = regex_replace(text, leading, "", std::regex_constants::format_first_only);
+	text = "!!" + text;
+	token->setText(text);
+	return true;
 }
 
 
 
 //////////////////////////////
 //
-// Tool_shed::searchAndReplaceReferenceValues --
+// Tool_shed::searchAndReplaceReferenceRecords -- Returns true if the line
+//     was changed.
 //
 
-void Tool_shed::searchAndReplaceReferenceValues(HumdrumFile& infile) {
-	string isearch = m_search;
-	HumRegex hre;
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (!infile[i].isGlobalReference()) {
-			continue;
-		}
-		HTp token = infile.token(i, 0);
-		string value = infile[i].getReferenceValue();
-		if (hre.search(value, isearch, m_grepoptions)) {
-			hre.replaceDestructive(value, m_replace, m_search, m_grepoptions);
-			hre.replaceDestructive(value, "", "^!+");
-			hre.replaceDestructive(value, "", ":+$");
-			string key = infile[i].getReferenceKey();
-			string text = "!!!" + key + ": " + value;
-			token->setText(text);
-			m_modified = true;
-		}
+bool Tool_shed::searchAndReplaceReferenceRecords(HumdrumFile& infile, int index,
+		ShedExpression& expression) {
+	static const regex leading("^!+");
+	if (!infile[index].isGlobalReference()) {
+		return false;
+	}
+	HTp token = infile.token(index, 0);
+	if (!regex_search(*token, expression.referenceRegex)) {
+		return false;
 	}
+	string text = token->getText().substr(1);
+	text = regex_replace(text, expression.searchRegex, expression.replace,
+			expression.replaceFlags);
+	text = regex_replace(text, leading, "", std::regex_constants::format_first_only);
+	text = "!!!" + text;
+	token->setText(text);
+	return true;
 }
 
 
 
 //////////////////////////////
 //
-// Tool_shed::searchAndReplaceExinterp --
+// Tool_shed::searchAndReplaceReferenceKeys -- Returns true if the line
+//     was changed.
 //
 
-void Tool_shed::searchAndReplaceExinterp(HumdrumFile& infile) {
-	string isearch;
-	if (m_search[0] == '^') {
-		isearch = "^\\*\\*" + m_search.substr(1);
-	} else {
-		isearch = "^\\*\\*.*" + m_search;
+bool Tool_shed::searchAndReplaceReferenceKeys(HumdrumFile& infile, int index,
+		ShedExpression& expression) {
+	static const regex leading("^!+");
+	static const regex trailing(":+$");
+	if (!infile[index].isGlobalReference()) {
+		return false;
 	}
-	HumRegex hre;
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (!infile[i].isInterpretation()) {
+	HTp token = infile.token(index, 0);
+	string key = infile[index].getReferenceKey();
+	if (!regex_search(key, expression.searchRegex)) {
+		return false;
+	}
+	key = regex_replace(key, expression.searchRegex, expression.replace,
+			expression.replaceFlags);
+	key = regex_replace(key, leading, "", std::regex_constants::format_first_only);
+	key = regex_replace(key, trailing, "", std::regex_constants::format_first_only);
+	string value = infile[index].getReferenceValue();
+	string text = "!!!" + key + ": " + value;
+	token->setText(text);
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// Tool_shed::searchAndReplaceReferenceValues -- Returns true if the line
+//     was changed.
+//
+
+bool Tool_shed::searchAndReplaceReferenceValues(HumdrumFile& infile, int index,
+		ShedExpression& expression) {
+	static const regex leading("^!+");
+	static const regex trailing(":+$");
+	if (!infile[index].isGlobalReference()) {
+		return false;
+	}
+	HTp token = infile.token(index, 0);
+	string value = infile[index].getReferenceValue();
+	if (!regex_search(value, expression.searchRegex)) {
+		return false;
+	}
+	value = regex_replace(value, expression.searchRegex, expression.replace,
+			expression.replaceFlags);
+	value = regex_replace(value, leading, "", std::regex_constants::format_first_only);
+	value = regex_replace(value, trailing, "", std::regex_constants::format_first_only);
+	string key = infile[index].getReferenceKey();
+	string text = "!!!" + key + ": " + value;
+	token->setText(text);
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// Tool_shed::searchAndReplaceExinterp -- Returns true if the line was
+//     changed.
+//
+
+bool Tool_shed::searchAndReplaceExinterp(HumdrumFile& infile, int index,
+		ShedExpression& expression) {
+	static const regex leading("^\\*+");
+	if (!infile[index].isInterpretation()) {
+		return false;
+	} else if (!infile[index].isExclusiveInterpretation()) {
+		// assuming a single line for all exclusive interpretations
+		return false;
+	}
+	bool modified = false;
+	for (int j=0; j<infile[index].getFieldCount(); j++) {
+		HTp token = infile.token(index, j);
+		if (token->isNull()) {
+			// Don't mess with null interpretations
 			continue;
-		} else if (!infile[i].isExclusiveInterpretation()) {
-			// assuming a single line for all exclusive interpretations
+		}
+		if (!isValid(token, expression)) {
 			continue;
 		}
-		for (int j=0; j<infile[i].getFieldCount(); j++) {
-			HTp token = infile.token(i, j);
-			if (token->isNull()) {
-				// Don't mess with null interpretations
-				continue;
-			}
-			if (!isValid(token)) {
-				continue;
-			}
-			if (hre.search(token, isearch, m_grepoptions)) {
-				string text = token->getText().substr(2);
-				hre.replaceDestructive(text, m_replace, m_search, m_grepoptions);
-				hre.replaceDestructive(text, "", "^\\*+");
-				text = "**" + text;
-				token->setText(text);
-				m_modified = true;
-			}
+		if (regex_search(*token, expression.exinterpRegex)) {
+			string text = token->getText().substr(2);
+			text = regex_replace(text, expression.searchRegex, expression.replace,
+					expression.replaceFlags);
+			text = regex_replace(text, leading, "", std::regex_constants::format_first_only);
+			text = "**" + text;
+			token->setText(text);
+			modified = true;
 		}
 	}
+	return modified;
 }
 
 
 
 //////////////////////////////
 //
-// Tool_shed::searchAndReplaceData --
+// Tool_shed::searchAndReplaceData -- Returns true if the line was changed.
 //
 
-void Tool_shed::searchAndReplaceData(HumdrumFile& infile) {
-	string dsearch = m_search;
-
-	HumRegex hre;
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (!infile[i].isData()) {
+bool Tool_shed::searchAndReplaceData(HumdrumFile& infile, int index,
+		ShedExpression& expression) {
+	if (!infile[index].isData()) {
+		return false;
+	}
+	bool modified = false;
+	for (int j=0; j<infile[index].getFieldCount(); j++) {
+		HTp token = infile.token(index, j);
+		if (token->isNull()) {
+			// Don't mess with null interpretations
 			continue;
 		}
-		for (int j=0; j<infile[i].getFieldCount(); j++) {
-			HTp token = infile.token(i, j);
-			if (token->isNull()) {
-				// Don't mess with null interpretations
-				continue;
-			}
-			if (!isValid(token)) {
-				continue;
-			}
-			if (hre.search(token, dsearch, m_grepoptions)) {
-				string text = token->getText();
-				hre.replaceDestructive(text, m_replace, dsearch, m_grepoptions);
-				if (text == "") {
-					text = ".";
-				}
-				token->setText(text);
-				m_modified = true;
+		if (!isValid(token, expression)) {
+			continue;
+		}
+		if (regex_search(*token, expression.searchRegex)) {
+			string text = token->getText();
+			text = regex_replace(text, expression.searchRegex, expression.replace,
+					expression.replaceFlags);
+			if (text == "") {
+				text = ".";
 			}
+			token->setText(text);
+			modified = true;
 		}
 	}
+	return modified;
 }
 
 
@@ -136863,13 +142754,13 @@ void Tool_shed::searchAndReplaceData(HumdrumFile& infile) {
 // Tool_shed::isValidDataType -- usar with -x and -k options.
 //
 
-bool Tool_shed::isValidDataType(HTp token) {
-	if (m_exinterps.empty()) {
+bool Tool_shed::isValidDataType(HTp token, ShedExpression& expression) {
+	if (expression.exinterps.empty()) {
 		return true;
 	}
-	string datatype = token->getDataType();
-	for (int i=0; i<(int)m_exinterps.size(); i++) {
-		if (datatype == m_exinterps[i]) {
+	const string& datatype = token->getDataType();
+	for (int i=0; i<(int)expression.exinterps.size(); i++) {
+		if (datatype == expression.exinterps[i]) {
 			return true;
 		}
 	}
@@ -136898,14 +142789,13 @@ bool Tool_shed::isValidSpine(HTp token) {
 // Tool_shed::isValid --
 //
 
-bool Tool_shed::isValid(HTp token) {
+bool Tool_shed::isValid(HTp token, ShedExpression& expression) {
 	if (!m_exclusion.empty()) {
-		HumRegex hre;
-		if (hre.search(token, m_exclusion)) {
+		if (regex_search(*token, m_exclusionRegex)) {
 			return false;
 		}
 	}
-	if (isValidDataType(token) && isValidSpine(token)) {
+	if (isValidDataType(token, expression) && isValidSpine(token)) {
 		return true;
 	}
 	return false;
@@ -138898,17 +144788,8 @@ bool Tool_synco::isSyncopated(HTp token) {
 //
 
 double Tool_synco::getMetricLevel(HTp token) {
-	HumNum durbar = token->getDurationFromBarline();
-	if (!durbar.isInteger()) {
-		return -1.0;
-	}
-	if (durbar.getNumerator() % 4 == 0) {
-		return 2.0;
-	}
-	if (durbar.getNumerator() % 2 == 0) {
-		return 1.0;
-	}
-	return 0.0;
+	HumdrumFile& infile = *token->getOwner()->getOwner();
+	return infile.getMetricPosition(token->getLineIndex()).weight;
 }
 
 
@@ -145302,6 +151183,18 @@ Tool_thru::Tool_thru(void) {
 }
 
 
+//////////////////////////////
+//
+// Tool_thru::isReusable -- Instances can be run on several files.
+//     The tool keeps no data between files.
+//
+
+bool Tool_thru::isReusable(void) {
+	return true;
+}
+
+
+
 /////////////////////////////////
 //
 // Tool_thru::run -- Do the main work of the tool.
@@ -146357,6 +152250,18 @@ Tool_timebase::Tool_timebase(void) {
 
 
 
+//////////////////////////////
+//
+// Tool_timebase::isReusable -- Instances can be run on several files.
+//     Options are read again for each file, and no other data is kept.
+//
+
+bool Tool_timebase::isReusable(void) {
+	return true;
+}
+
+
+
 ///////////////////////////////
 //
 // Tool_timebase::run -- Primary interfaces to the tool.
@@ -146528,6 +152433,18 @@ Tool_transpose::Tool_transpose(void) {
 
 
 
+//////////////////////////////
+//
+// Tool_transpose::isReusable -- Instances can be run on several files.
+//     Transposition settings are recalculated for each file.
+//
+
+bool Tool_transpose::isReusable(void) {
+	return true;
+}
+
+
+
 /////////////////////////////////
 //
 // Tool_transpose::run -- Do the main work of the tool.
@@ -147536,9 +153453,7 @@ void Tool_transpose::doAutoTransposeAnalysis(HumdrumFile& infile) {
 	int i;
 	for (i=0; i<(int)tracks.size(); i++) {
 		if (tracks[i]->isKern()) {
-			ktracks[i] = tracks[i]->getTrack();
-		} else {
-			ktracks[i] = 0;
+			ktracks[tracks[i]->getTrack()] = tracks[i]->getTrack();
 		}
 	}
 
@@ -147607,8 +153522,8 @@ void Tool_transpose::doTranspositionAnalysis(vector<vector<vector<double> > >& a
 	int value;
 
 	for (i=0; i<1; i++) {
-		for (j=2; j<3; j++) {
-			for (k=0; k<(int)analysis[i].size(); k++) {
+		for (j=2; (j<3) && (j<(int)analysis.size()); j++) {
+			for (k=0; (k<(int)analysis[i].size()) && (k<(int)analysis[j].size()); k++) {
 				if (analysis[i][k][24] >= 0 && analysis[j][k][24] >= 0) {
 					value1 = (int)analysis[i][k][25];
 	 				if (value1 >= 12) {
@@ -147646,6 +153561,10 @@ void Tool_transpose::printRawTrackAnalysis(vector<vector<vector<double> > >& ana
 	int value;
 	int value2;
 
+	if (analysis.empty()) {
+		return;
+	}
+
 	for (i=0; i<(int)analysis[0].size(); i++) {
 		m_free_text << "Frame\t" << i << ":";
 		for (j=0; j<(int)analysis.size(); j++) {
@@ -147678,10 +153597,6 @@ void Tool_transpose::doAutoKeyAnalysis(vector<vector<vector<double> > >& analysi
 		int hop, int count, int segments, vector<int>& ktracks,
 		vector<vector<vector<double> > >& trackhist) {
 
-	vector<double> majorweights;
-	vector<double> minorweights;
-	fillWeightsWithKostkaPayne(majorweights, minorweights);
-
 	int size = 0;
 	int i;
 	for (i=1; i<(int)ktracks.size(); i++) {
@@ -147695,13 +153610,16 @@ void Tool_transpose::doAutoKeyAnalysis(vector<vector<vector<double> > >& analysi
 		analysis[i].reserve(count);
 	}
 
+	// Kostka-Payne weights are used by default:
+	HumKeyWindow keywindow;
+
 	int aindex = 0;
 	for (i=1; i<(int)ktracks.size(); i++) {
 		if (!ktracks[i]) {
 			continue;
 		}
 		doTrackKeyAnalysis(analysis[aindex++], level, hop, count,
-				trackhist[i], majorweights, minorweights);
+				trackhist[i], keywindow);
 	}
 }
 
@@ -147710,85 +153628,27 @@ void Tool_transpose::doAutoKeyAnalysis(vector<vector<vector<double> > >& analysi
 //////////////////////////////
 //
 // Tool_transpose::doTrackKeyAnalysis -- Do individual key analyses of sections of the
-//   given track.
+//   given track.  The key window slides over the track's segment histograms, so
+//   only the segments entering and leaving the window are processed for each hop.
 //
 
 void Tool_transpose::doTrackKeyAnalysis(vector<vector<double> >& analysis, int level, int hop,
-		int count, vector<vector<double> >& trackhist,
-		vector<double>& majorweights, vector<double>& minorweights) {
+		int count, vector<vector<double> >& trackhist, HumKeyWindow& keywindow) {
 
+	keywindow.clear();
 	int i;
 	for (i=0; i<count; i++) {
 		if (i * hop + level > (int)trackhist.size()) {
 			break;
 		}
 		analysis.resize(i+1);
-		doSingleAnalysis(analysis[analysis.size()-1], i*hop+level, level,
-				trackhist, majorweights, minorweights);
+		keywindow.setWindow(trackhist, i*hop, level);
+		identifyKey(analysis[analysis.size()-1], keywindow);
 	}
 }
 
 
 
-//////////////////////////////
-//
-// Tool_transpose::doSingleAnalysis --
-//
-
-void Tool_transpose::doSingleAnalysis(vector<double>& analysis, int startindex, int length,
-		vector<vector<double> >& trackhist, vector<double>& majorweights,
-		vector<double>& minorweights) {
-	vector<double> histsum(12, 0);
-
-	for (int i=0; (i<length) && (startindex+i+length<(int)trackhist.size()); i++) {
-		for (int k=0; k<12; k++) {
-			histsum[k] += trackhist[i+startindex][k];
-		}
-	}
-
-	identifyKey(analysis, histsum, majorweights, minorweights);
-}
-
-
-
-///////////////////////////////
-//
-// Tool_transpose::fillWeightsWithKostkaPayne --
-//
-
-void Tool_transpose::fillWeightsWithKostkaPayne(vector<double>& maj, vector<double>& min) {
-	maj.resize(12);
-	min.resize(12);
-
-	// found in David Temperley: Music and Probability 2006
-	maj[0]  = 0.748;	// C major weights
-	maj[1]  = 0.060;	// C#
-	maj[2]  = 0.488;	// D
-	maj[3]  = 0.082;	// D#
-	maj[4]  = 0.670;	// E
-	maj[5]  = 0.460;	// F
-	maj[6]  = 0.096;	// F#
-	maj[7]  = 0.715;	// G
-	maj[8]  = 0.104;	// G#
-	maj[9]  = 0.366;	// A
-	maj[10] = 0.057;	// A#
-	maj[11] = 0.400;	// B
-	min[0]  = 0.712;	// c minor weights
-	min[1]  = 0.084;	// c#
-	min[2]  = 0.474;	// d
-	min[3]  = 0.618;	// d#
-	min[4]  = 0.049;	// e
-	min[5]  = 0.460;	// f
-	min[6]  = 0.105;	// f#
-	min[7]  = 0.747;	// g
-	min[8]  = 0.404;	// g#
-	min[9]  = 0.067;	// a
-	min[10] = 0.133;	// a#
-	min[11] = 0.330;	// b
-}
-
-
-
 ////////////////////////////////////////
 //
 // identifyKey -- correls contains the 12 major key correlation
@@ -147798,18 +153658,12 @@ void Tool_transpose::fillWeightsWithKostkaPayne(vector<double>& maj, vector<doub
 //      all entries in the original histogram were zero (all rests).
 //
 
-void Tool_transpose::identifyKey(vector<double>& correls,
-		vector<double>& histogram, vector<double>& majorweights,
-		vector<double>& minorweights) {
+void Tool_transpose::identifyKey(vector<double>& correls, HumKeyWindow& keywindow) {
 
 	correls.clear();
 	correls.reserve(26);
 
-	double testsum = 0.0;
-	for (int i=0; i<12; i++) {
-		testsum += histogram[i];
-	}
-	if (testsum == 0.0) {
+	if (keywindow.isEmpty()) {
 		correls.resize(26);
 		fill(correls.begin(), correls.end(), -1);
 		correls[24] = -1;
@@ -147817,12 +153671,10 @@ void Tool_transpose::identifyKey(vector<double>& correls,
 		return;
 	}
 
-	vector<double> majorcorrels;
-	vector<double> minorcorrels;
-	for (int i=0; i<12; i++) {
-		majorcorrels[i] = Convert::pearsonCorrelation(majorweights, histogram);
-		minorcorrels[i] = Convert::pearsonCorrelation(minorweights, histogram);
-	}
+	vector<double> allcorrels;
+	keywindow.getCorrelations(allcorrels);
+	vector<double> majorcorrels(allcorrels.begin(), allcorrels.begin() + 12);
+	vector<double> minorcorrels(allcorrels.begin() + 12, allcorrels.end());
 
 	// find max value
 	int besti;
@@ -147931,7 +153783,7 @@ double Tool_transpose::storeHistogramForTrack(vector<vector<double> >& histogram
 		HumdrumFile& infile, int track, int segments) {
 
 	histogram.clear();
-	histogram.reserve(segments);
+	histogram.resize(segments);
 
 	int i;
 	int j;
@@ -147964,12 +153816,12 @@ double Tool_transpose::storeHistogramForTrack(vector<vector<double> >& histogram
 			if (!infile.token(i, j)->isKern()) {
 				continue;
 			}
-			if (!infile.token(i, j)->isNull()) {
+			if (infile.token(i, j)->isNull()) {
 				continue;
 			}
 			tokencount = infile.token(i, j)->getSubtokenCount();
 			for (k=0; k<tokencount; k++) {
-				buffer = *infile.token(j, k);
+				buffer = infile.token(i, j)->getSubtoken(k);
 				if (buffer == ".") {
 					continue;  // ignore illegal inline null tokens
 				}
@@ -149332,6 +155184,7 @@ Tool_tspos::Tool_tspos(void) {
 	define("t|table=b",         "add analysis table above score");
 	define("V|all-voices=b",    "require all voices in score to be sounding");
 	define("Q|no-question=b",   "do not show question mark in table header");
+	define("stats|statistics=b", "only print JSON summary of triadic positions for all inputs");
 }
 
 
@@ -149381,6 +155234,34 @@ bool Tool_tspos::run(HumdrumFile& infile) {
 
 
 
+//////////////////////////////
+//
+// Tool_tspos::finally -- Print the JSON summary of the triadic position
+//     counts when using --stats.
+//
+
+void Tool_tspos::finally(void) {
+	if (!m_statsQ) {
+		return;
+	}
+	m_stats.printJson(m_free_text, m_toolName);
+}
+
+
+
+//////////////////////////////
+//
+// Tool_tspos::getStatistics -- Return the counts collected with --stats.
+//     Counts from tool objects used in separate threads can be combined
+//     with HumStatistics::merge().
+//
+
+HumStatistics& Tool_tspos::getStatistics(void) {
+	return m_stats;
+}
+
+
+
 //////////////////////////////
 //
 // Tool_tspos::initialize -- Setup to do before processing a file.
@@ -149411,6 +155292,7 @@ void Tool_tspos::initialize(HumdrumFile& infile) {
 		m_minorQ = true;
 	}
 	m_questionQ = !getBoolean("no-question");
+	m_statsQ = getBoolean("stats");
 }
 
 
@@ -149430,7 +155312,9 @@ void Tool_tspos::processFile(HumdrumFile& infile) {
 	m_used_markers.resize(7);
 	fill(m_used_markers.begin(), m_used_markers.end(), 0);
 
-	avoidRdfCollisions(infile);
+	if (!m_statsQ) {
+		avoidRdfCollisions(infile);
+	}
 	analyzeVoiceCount(infile);
 
 	m_partTriadPositions.resize(infile.getMaxTrack() + 1);
@@ -149447,6 +155331,7 @@ void Tool_tspos::processFile(HumdrumFile& infile) {
 	vector<int> chordPositions;
 	vector<int> thirdPositions;
 	vector<int> fifthPositions;
+	HumSonority sonority;
 
 	for (int i=0; i<infile.getLineCount(); i++) {
 		if (!infile[i].isData()) { // if no notes in the line
@@ -149495,9 +155380,14 @@ void Tool_tspos::processFile(HumdrumFile& infile) {
 			}
 		}
 		midiNotes = getMidiNotes(kernNotes);
+		sonority.clear();
+		for (int k=0; k<(int)midiNotes.size(); k++) {
+			sonority.addMidi(midiNotes[k]);
+		}
+		int pcmask = sonority.getPitchClassMask();
 
 		if (m_colorThirds) { // thirds
-			thirdPositions = getThirds(midiNotes);
+			thirdPositions = getThirds(midiNotes, pcmask);
 			checkForTriadicSonority(thirdPositions, i);
 
 			if (m_doubleQ) { // label only doubles if prompted
@@ -149508,7 +155398,7 @@ void Tool_tspos::processFile(HumdrumFile& infile) {
 		}
 
 		if (m_colorFifths) { // fifths
-			fifthPositions = getFifths(midiNotes);
+			fifthPositions = getFifths(midiNotes, pcmask);
 			checkForTriadicSonority(fifthPositions, i);
 
 			if (m_doubleQ) { // label only doubles if prompted
@@ -149519,7 +155409,7 @@ void Tool_tspos::processFile(HumdrumFile& infile) {
 		}
 
 		if (m_colorTriads) { // triads
-		  	chordPositions = getChordPositions(midiNotes);
+		  	chordPositions = getChordPositions(midiNotes, pcmask);
 			checkForTriadicSonority(chordPositions, i);
 			if (m_doubleQ) { // label only doubles if prompted
 				keepOnlyDoubles(chordPositions);
@@ -149528,6 +155418,11 @@ void Tool_tspos::processFile(HumdrumFile& infile) {
 		}
 	}
 
+	if (m_statsQ) {
+		addStatistics(infile);
+		return;
+	}
+
 	infile.createLinesFromTokens();
 
 	m_humdrum_text << infile;
@@ -149622,43 +155517,14 @@ void Tool_tspos::printUsedMarkers(void) {
 //
 
 bool Tool_tspos::hasFullTriadAttack(HumdrumLine& line) {
-	vector<int> midiPitches = line.getMidiPitchesSortLH();
-	vector<int> positive(24, 0);
-	int count = 0;
+	vector<int> midiPitches = line.getMidiPitches();
+	HumSonority sonority;
 	for (int i=0; i<(int)midiPitches.size(); i++) {
 		if (midiPitches[i] > 0) {
-			if (!positive[midiPitches[i] % 12]) {
-				positive[midiPitches[i] % 12]++;
-				positive[midiPitches[i] % 12 + 12]++;
-				count++;
-			}
-		}
-	}
-
-	if (count != 3) {
-		return false;
-	}
-
-	for (int i=0; i<12; i++) {
-		if (!positive[i]) {
-			continue;
-		}
-		if (positive[i+3]) {
-			if (positive[i+3+3]) { // diminished triad pitch-classes present
-				return true;
-			} else if (positive[i+3+4]) { // minor
-				return true;
-			}
-		} else if (positive[i+4]) {
-			if (positive[i+4+3]) { // major
-				return true;
-			} else if (positive[i+4+4]) { // augmented
-				return true;
-			}
+			sonority.addMidi(midiPitches[i]);
 		}
 	}
-
-	return false;
+	return HumSonority::isTriad(sonority.getType());
 }
 
 
@@ -149740,22 +155606,7 @@ string Tool_tspos::generateStatistics(HumdrumFile& infile) {
 	int sonorityCount = 0;  // total number of sonorities
 	int triadCount = 0;     // sonorities that are triads
 	HumNum triadDuration = 0;
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (!infile[i].isData()) {
-			continue;
-		}
-		if (m_triadState.at(i)) {
-			triadDuration += infile[i].getDuration();
-		}
-		int attacks = infile[i].getKernNoteAttacks();
-		if (attacks == 0) {
-			continue;
-		}
-		sonorityCount++;
-		if (m_triadState.at(i)) {
-			triadCount++;
-		}
-	}
+	countSonorities(infile, sonorityCount, triadCount, triadDuration);
 
 	string toolPrefix = "!!!TOOL-";
 	if (m_toolCount > 0) {
@@ -149834,6 +155685,90 @@ string Tool_tspos::generateStatistics(HumdrumFile& infile) {
 
 
 
+//////////////////////////////
+//
+// Tool_tspos::countSonorities -- Count the sonorities with note attacks,
+//     the triadic sonorities among them, and the duration of the triadic
+//     sonorities.
+//
+
+void Tool_tspos::countSonorities(HumdrumFile& infile, int& sonorityCount,
+		int& triadCount, HumNum& triadDuration) {
+	sonorityCount = 0;
+	triadCount = 0;
+	triadDuration = 0;
+	for (int i=0; i<infile.getLineCount(); i++) {
+		if (!infile[i].isData()) {
+			continue;
+		}
+		if (m_triadState.at(i)) {
+			triadDuration += infile[i].getDuration();
+		}
+		int attacks = infile[i].getKernNoteAttacks();
+		if (attacks == 0) {
+			continue;
+		}
+		sonorityCount++;
+		if (m_triadState.at(i)) {
+			triadCount++;
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// Tool_tspos::addStatistics -- Add the counts for the current file to the
+//     statistics for --stats.  The "positions" group combines the full and
+//     partial triad counts in the same way as generateStatistics(), and
+//     "top-voice" gives the same counts for the highest **kern spine.
+//
+
+void Tool_tspos::addStatistics(HumdrumFile& infile) {
+	int sonorityCount = 0;
+	int triadCount = 0;
+	HumNum triadDuration = 0;
+	countSonorities(infile, sonorityCount, triadCount, triadDuration);
+
+	m_stats.addFile();
+	m_stats.increment("summary", "sonority-count", sonorityCount);
+	m_stats.increment("summary", "sonority-duration", infile.getScoreDuration().getFloat());
+	m_stats.increment("summary", "triadic-count", triadCount);
+	m_stats.increment("summary", "triadic-duration", triadDuration.getFloat());
+
+	vector<string> categories = {
+		"triad-root", "triad-third", "triad-fifth",
+		"third-root", "third-third", "fifth-root", "fifth-fifth"
+	};
+	vector<string> positions = {
+		"root", "third", "fifth", "root", "third", "root", "fifth"
+	};
+
+	int topTrack = -1;
+	vector<HTp> kernstarts;
+	infile.getKernSpineStartList(kernstarts);
+	if (!kernstarts.empty()) {
+		topTrack = kernstarts.back()->getTrack();
+	}
+
+	for (int i=1; i<(int)m_partTriadPositions.size(); i++) {
+		vector<int>& entry = m_partTriadPositions[i];
+		for (int j=0; j<(int)entry.size(); j++) {
+			if (entry[j] == 0) {
+				continue;
+			}
+			m_stats.increment("categories", categories.at(j), entry[j]);
+			m_stats.increment("positions", positions.at(j), entry[j]);
+			if (i == topTrack) {
+				m_stats.increment("top-voice", positions.at(j), entry[j]);
+			}
+		}
+	}
+}
+
+
+
 //////////////////////////////
 //
 // Tool_tspos::generateTable -- Create an HTML table that the statistics
@@ -150180,7 +156115,7 @@ void Tool_tspos::labelChordPositions(vector<HTp>& kernNotes, vector<int>& chordP
 				m_partTriadPositions.at(track).at(2)++;
 				break;
 		}
-		if (label.empty()) {
+		if (label.empty() || m_statsQ) {
 			continue;
 		}
 		string text = *kernNotes.at(i);
@@ -150220,7 +156155,7 @@ void Tool_tspos::labelThirds(vector<HTp>& kernNotes, vector<int>& thirdPositions
 				break;
 		}
 
-		if (label.empty()) {
+		if (label.empty() || m_statsQ) {
 			continue;
 		}
 		string text = *kernNotes.at(i);
@@ -150260,7 +156195,7 @@ void Tool_tspos::labelFifths(vector<HTp>& kernNotes, vector<int>& fifthPositions
 				break;
 		}
 
-		if (label.empty()) {
+		if (label.empty() || m_statsQ) {
 			continue;
 		}
 		string text = *kernNotes.at(i);
@@ -150271,37 +156206,6 @@ void Tool_tspos::labelFifths(vector<HTp>& kernNotes, vector<int>& fifthPositions
 
 
 
-//////////////////////////////
-//
-// Tool_tspos::getNoteMods -- Identify if the sonority is a triad, and if so, place
-//    the position of the note in the chord:
-//       0: not in triadic sonority.
-//       1: root (such as C in C major triad)
-//       3: third (such as E in C major triad)
-//       5: fifth (such as G in C major triad)
-//
-
-vector<int> Tool_tspos::getNoteMods(vector<int>& midiNotes) {
-	// create modulo 12 arr
-	vector<int> pitchClasses(12, 0);
-	for (int i = 0; i < (int)midiNotes.size(); i++) {
-		int index = midiNotes.at(i) % 12;
-		pitchClasses.at(index)++; // add one to the pitch
-	}
-
-	vector<int> noteMods;
-
-	for (int i = 0; i < (int)pitchClasses.size(); i++) {
-		if (pitchClasses.at(i) != 0) { // not zero
-			noteMods.push_back(i); // add the index
-		}
-	}
-
-	return noteMods;
-}
-
-
-
 //////////////////////////////
 //
 // Tool_tspos::getThirds -- Identify if the sonority is a third interval, and if so,
@@ -150310,70 +156214,25 @@ vector<int> Tool_tspos::getNoteMods(vector<int>& midiNotes) {
 //       1: root (bottom of the interval)
 //       3: third (top of the interval)
 
-vector<int> Tool_tspos::getThirds(vector<int>& midiNotes) {
+vector<int> Tool_tspos::getThirds(vector<int>& midiNotes, int pcmask) {
 	vector<int> output(midiNotes.size(), 0);
 
-	if (midiNotes.empty()) {
-		return output;
-	}
-
-	vector<int> noteMods = getNoteMods(midiNotes); // we know noteMods is sorted
-	if (noteMods.size() != 2) {
-		return output;
-	}
-
-	int interval = noteMods[1] - noteMods[0];
-	int rootClass = -1; // currently uninitialized
-	int thirdClass = -1;
-
+	int type = HumSonority::getType(pcmask);
+	bool found = false;
 	if (m_majorQ && m_minorQ) {
-
-		if (interval == 3 || interval == 4) { // third is found
-			rootClass = noteMods.at(0);
-			thirdClass = noteMods.at(1);
-		}
-		else if (interval == 8 || interval == 9) { // third is found (inversion)
-			rootClass = noteMods.at(1);
-			thirdClass = noteMods.at(0);
-		}
-
-	}
-
-	else if (!m_majorQ && m_minorQ) {
-		if (interval == 3) { // minor third is found
-			rootClass = noteMods.at(0);
-			thirdClass = noteMods.at(1);
-		}
-		else if (interval == 9) { // major sixth is found (inversion)
-			rootClass = noteMods.at(1);
-			thirdClass = noteMods.at(0);
-		}
-	}
-
-	else if (m_majorQ && !m_minorQ) {
-
-		if (interval == 4) { // major third is found
-			rootClass = noteMods.at(0);
-			thirdClass = noteMods.at(1);
-		}
-		else if (interval == 8) { // minor sixth is found (inversion)
-			rootClass = noteMods.at(1);
-			thirdClass = noteMods.at(0);
-		}
-
+		found = (type == sonority_minor_third) || (type == sonority_major_third);
+	} else if (!m_majorQ && m_minorQ) {
+		found = (type == sonority_minor_third);
+	} else if (m_majorQ && !m_minorQ) {
+		found = (type == sonority_major_third);
 	}
-
-	if (rootClass == -1) { // third was not found
+	if (!found) {
 		return output;
 	}
 
 	// populate output
 	for (int i = 0; i < (int)midiNotes.size(); i++) {
-		if (midiNotes.at(i) % 12 == rootClass) {
-		output.at(i) = 1;
-		} else if (midiNotes.at(i) % 12 == thirdClass) {
-			output.at(i) = 3;
-		}
+		output.at(i) = HumSonority::getPosition(pcmask, midiNotes.at(i));
 	}
 
 	return output;
@@ -150384,49 +156243,23 @@ vector<int> Tool_tspos::getThirds(vector<int>& midiNotes) {
 //////////////////////////////
 //
 // Tool_tspos::getFifths -- Identify if the sonority is a fifth interval, and if so,
-//    place the position of the note in the output.
+//    place the position of the note in the output.  Tritones are included,
+//    with the lower pitch class as the root.
 //       0: not in the sonority
 //       1: root (bottom of the interval)
 //       5: fifth (top of the interval)
 
-vector<int> Tool_tspos::getFifths(vector<int>& midiNotes) {
+vector<int> Tool_tspos::getFifths(vector<int>& midiNotes, int pcmask) {
 	vector<int> output(midiNotes.size(), 0);
 
-	if (midiNotes.empty()) {
-		return output;
-	}
-
-	vector<int> noteMods = getNoteMods(midiNotes);
-	if (noteMods.size() != 2) {
-		return output;
-	}
-
-	int interval = noteMods.at(1) - noteMods.at(0);
-	int rootClass = -1; // currently uninitialized
-	int fifthClass = -1;
-
-	if ((interval == 7) || (interval == 6)) { // fifth found
-		rootClass = noteMods.at(0);
-		fifthClass = noteMods.at(1);
-	}
-
-	if (interval == 5) { // inverted fifth found
-		rootClass = noteMods.at(1);
-		fifthClass = noteMods.at(0);
-	}
-
-	if (rootClass == -1) { // fifth not found
+	int type = HumSonority::getType(pcmask);
+	if ((type != sonority_fifth) && (type != sonority_tritone)) {
 		return output;
 	}
 
 	// populate output
 	for (int i = 0; i < (int)midiNotes.size(); i++) {
-		if (midiNotes.at(i) % 12 == rootClass) {
-			output.at(i) = 1;
-		}
-		else if (midiNotes.at(i) % 12 == fifthClass) {
-			output.at(i) = 5;
-		}
+		output.at(i) = HumSonority::getPosition(pcmask, midiNotes.at(i));
 	}
 
 	return output;
@@ -150436,91 +156269,34 @@ vector<int> Tool_tspos::getFifths(vector<int>& midiNotes) {
 
 ///////////////////////////////
 //
-// Tool_tspos::getChordPositions --
+// Tool_tspos::getChordPositions -- Identify if the sonority is a major,
+//    minor or diminished triad, and if so, place the position of the note
+//    in the chord in the output.
+//       0: not in the triad
+//       1: root
+//       3: third
+//       5: fifth
 //
 
-vector<int> Tool_tspos::getChordPositions(vector<int>& midiNotes) {
+vector<int> Tool_tspos::getChordPositions(vector<int>& midiNotes, int pcmask) {
 	vector<int> output(midiNotes.size(), 0);
-	if (midiNotes.empty()) {
-		return output;
-	}
-
-	vector<int> noteMods = getNoteMods(midiNotes);
-
-	if (noteMods.size() != 3) { // not a triad
-		return output;
-	}
-
-	int bint = noteMods.at(1) - noteMods.at(0);
-	int tint = noteMods.at(2) - noteMods.at(1);
-
-	int rootClass = -1; // curr uninitialized
-	int thirdClass = -1;
-	int fifthClass = -1;
 
+	int type = HumSonority::getType(pcmask);
+	bool found = false;
 	if (m_majorQ && m_minorQ) {
-
-		if ((bint == 3 && tint == 4) || (bint == 4 && tint == 3) || (bint == 3 && tint == 3)) { // root pos
-			rootClass = noteMods.at(0);
-			thirdClass = noteMods.at(1);
-			fifthClass = noteMods.at(2);
-		} else if ((bint == 4 && tint == 5) || (bint == 3 && tint == 5) || (bint == 3 && tint == 6)) { // first inv
-			rootClass = noteMods.at(2);
-			thirdClass = noteMods.at(0);
-			fifthClass = noteMods.at(1);
-		} else if ((bint == 5 && tint == 3) || (bint == 5 && tint == 4) || (bint == 6 && tint == 3)) { // sec inv
-			rootClass = noteMods.at(1);
-			thirdClass = noteMods.at(2);
-			fifthClass = noteMods.at(0);
-		}
-	}
-
-	else if (!m_majorQ && m_minorQ) {
-		if (bint == 3 && tint == 4) {// minor root pos
-			rootClass = noteMods.at(0);
-			thirdClass = noteMods.at(1);
-			fifthClass = noteMods.at(2);
-		} else if (bint == 4 && tint == 5) { // minor first inv
-			rootClass = noteMods.at(2);
-			thirdClass = noteMods.at(0);
-			fifthClass = noteMods.at(1);
-		} else if (bint == 5 && tint == 3) { // minor sec inv
-			rootClass = noteMods.at(1);
-			thirdClass = noteMods.at(2);
-			fifthClass = noteMods.at(0);
-		}
-	}
-
-	else if (m_majorQ && !m_minorQ) {
-		if (bint == 4 && tint == 3) {// major root pos
-			rootClass = noteMods.at(0);
-			thirdClass = noteMods.at(1);
-			fifthClass = noteMods.at(2);
-		} else if (bint == 3 && tint == 5) { // major first inv
-			rootClass = noteMods.at(2);
-			thirdClass = noteMods.at(0);
-			fifthClass = noteMods.at(1);
-		} else if (bint == 5 && tint == 4) { // major sec inv
-			rootClass = noteMods.at(1);
-			thirdClass = noteMods.at(2);
-			fifthClass = noteMods.at(0);
-		}
-	}
-
-	if (rootClass == -1) {
+		found = (type == sonority_major) || (type == sonority_minor) ||
+				(type == sonority_diminished);
+	} else if (!m_majorQ && m_minorQ) {
+		found = (type == sonority_minor);
+	} else if (m_majorQ && !m_minorQ) {
+		found = (type == sonority_major);
+	}
+	if (!found) {
 		return output;
 	}
 
 	for (int i = 0; i < (int)midiNotes.size(); i++) {
-		if (midiNotes.at(i) % 12 == rootClass) {
-			output.at(i) = 1;
-		}
-		else if (midiNotes.at(i) % 12 == thirdClass) {
-			output.at(i) = 3;
-		}
-		else if (midiNotes.at(i) % 12 == fifthClass) {
-			output.at(i) = 5;
-		}
+		output.at(i) = HumSonority::getPosition(pcmask, midiNotes.at(i));
 	}
 
 	if (m_doubleQ) {
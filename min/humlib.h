@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Sat Aug  8 12:24:49 PDT 2015
-// Last Modified: Tue Aug 18 13:40:26 PDT 2026
+// Last Modified: Sun Oct 18 22:28:00 UTC 2026
 // Filename:      min/humlib.h
 // URL:           https://github.com/craigsapp/humlib/blob/master/min/humlib.h
 // Syntax:        C++11
@@ -40,26 +40,40 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define _HUMLIB_H_INCLUDED
 
 #include <algorithm>
+#include <atomic>
 #include <cctype>
 #include <chrono>
+#include <climits>
 #include <cmath>
+#include <condition_variable>
 #include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
 #include <cstring>
 #include <cstring>
 #include <ctime>
+#include <deque>
+#include <exception>
 #include <fstream>
 #include <functional>
+#include <future>
 #include <iomanip>
 #include <iostream>
 #include <list>
 #include <locale>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <numeric>
+#include <queue>
 #include <random>
 #include <regex>
 #include <set>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -83,6 +97,7 @@ using std::pair;
 using std::regex;
 using std::set;
 using std::string;
+using std::string_view;
 using std::stringstream;
 using std::istringstream;
 using std::ostringstream;
@@ -98,6 +113,7 @@ using std::max;
 	#include <netdb.h>       /* gethostbyname   */
 	#include <unistd.h>      /* read, write     */
 	#include <string.h>      /* memcpy          */
+	#include <sys/stat.h>    /* mkdir, stat     */
    #include <sstream>
 #endif
 
@@ -375,7 +391,66 @@ class HumNum {
 };
 
 
+
+
+// HumNum64: Rational number with 64-bit numerator and denominator.  All
+// arithmetic is checked for overflow.  A result that cannot be represented
+// becomes NaN (0/0), and stays NaN in further calculations, rather than
+// wrapping around silently as HumNum does.
+
+class HumNum64 {
+	public:
+		         HumNum64           (void);
+		         HumNum64           (int64_t value);
+		         HumNum64           (int64_t numerator, int64_t denominator);
+		         HumNum64           (const HumNum& value);
+		        ~HumNum64           () {}
+
+		bool     isNaN              (void) const;
+		bool     isNegative         (void) const;
+		bool     isPositive         (void) const;
+		bool     isZero             (void) const;
+		bool     isInteger          (void) const;
+		int64_t  getNumerator       (void) const { return top; }
+		int64_t  getDenominator     (void) const { return bot; }
+		double   getFloat           (void) const;
+		bool     getHumNum          (HumNum& output) const;
+		bool     getTicks           (int64_t tpq, int64_t& ticks) const;
+		void     setValue           (int64_t numerator, int64_t denominator);
+		HumNum64 operator+          (const HumNum64& value) const;
+		HumNum64 operator-          (const HumNum64& value) const;
+		HumNum64 operator-          (void) const;
+		HumNum64 operator*          (const HumNum64& value) const;
+		HumNum64 operator/          (const HumNum64& value) const;
+		HumNum64& operator+=        (const HumNum64& value);
+		HumNum64& operator-=        (const HumNum64& value);
+		HumNum64& operator*=        (const HumNum64& value);
+		HumNum64& operator/=        (const HumNum64& value);
+		bool     operator==         (const HumNum64& value) const;
+		bool     operator!=         (const HumNum64& value) const;
+		bool     operator<          (const HumNum64& value) const;
+		bool     operator<=         (const HumNum64& value) const;
+		bool     operator>          (const HumNum64& value) const;
+		bool     operator>=         (const HumNum64& value) const;
+		std::ostream& printFraction (std::ostream& out = std::cout) const;
+
+		static bool    add          (int64_t a, int64_t b, int64_t& output);
+		static bool    subtract     (int64_t a, int64_t b, int64_t& output);
+		static bool    multiply     (int64_t a, int64_t b, int64_t& output);
+		static bool    lcm          (int64_t a, int64_t b, int64_t& output);
+		static int64_t gcd          (int64_t a, int64_t b);
+
+	protected:
+		int      compare            (const HumNum64& value) const;
+
+	private:
+		int64_t top;
+		int64_t bot;
+};
+
+
 std::ostream& operator<<(std::ostream& out, const HumNum& number);
+std::ostream& operator<<(std::ostream& out, const HumNum64& number);
 
 template <typename A>
 std::ostream& operator<<(std::ostream& out, const std::vector<A>& v);
@@ -836,6 +911,7 @@ class HumAddress {
 		int                 getLineNumber     (void) const;
 		int                 getFieldIndex     (void) const;
 		const HumdrumToken& getDataType       (void) const;
+		int                 getDataTypeId     (void) const;
 		HTp                 getExclusiveInterpretation(void);
 		const std::string&  getSpineInfo      (void) const;
 		int                 getTrack          (void) const;
@@ -1220,6 +1296,251 @@ class HumInstrument {
 
 
 
+class HumKeyWindow {
+	public:
+		             HumKeyWindow         (void);
+		            ~HumKeyWindow         () {};
+
+		void         setWeights           (const std::vector<double>& major,
+		                                   const std::vector<double>& minor);
+		static void  getKostkaPayneWeights(std::vector<double>& major,
+		                                   std::vector<double>& minor);
+
+		void         clear                (void);
+		void         addSegment           (const std::vector<double>& histogram);
+		void         removeSegment        (const std::vector<double>& histogram);
+		void         setWindow            (const std::vector<std::vector<double>>& segments,
+		                                   int start, int length);
+
+		const std::vector<double>& getHistogram(void) const;
+		bool         isEmpty              (void) const;
+		void         getCorrelations      (std::vector<double>& correls) const;
+		int          getBestKey           (void) const;
+
+	private:
+		// m_keyweights: the major and minor key weights, rotated to each
+		// tonic and normalized to a mean of zero and a length of one.
+		// Rows 0-11 are for major keys on C to B, and rows 12-23 are for
+		// minor keys.
+		double m_keyweights[24][12];
+
+		// m_histogram: pitch-class histogram of the current window.
+		std::vector<double> m_histogram;
+
+		// m_active: number of segments in the window that contain notes.
+		int m_active = 0;
+
+		// m_segments, m_start, m_end: segment list and range of the current
+		// window when using setWindow().
+		const std::vector<std::vector<double>>* m_segments = NULL;
+		int m_start = 0;
+		int m_end   = 0;
+};
+
+
+
+class HumThreadPool {
+	public:
+		            HumThreadPool      (int threads = 0);
+		           ~HumThreadPool      ();
+
+		int         getThreadCount     (void) const;
+		void        run                (int count,
+		                                const std::function<void(int)>& task);
+
+		static int  getHardwareThreads (void);
+
+	protected:
+		void        workerLoop         (void);
+		void        doTasks            (void);
+
+	private:
+		// m_workers: the worker threads (the thread calling run() also
+		// processes tasks, so there is one less worker than the thread count).
+		std::vector<std::thread> m_workers;
+
+		// m_runMutex: Allow only one run() at a time.
+		std::mutex m_runMutex;
+
+		// m_mutex, m_wake, m_finished: Synchronization between run()
+		// and the workers.
+		std::mutex m_mutex;
+		std::condition_variable m_wake;
+		std::condition_variable m_finished;
+
+		// m_task: the task for the current run, called with the task index.
+		const std::function<void(int)>* m_task = NULL;
+
+		// m_count: the number of tasks in the current run.
+		int m_count = 0;
+
+		// m_next: the next task index to process.
+		std::atomic<int> m_next;
+
+		// m_busy: the number of workers still processing the current run.
+		int m_busy = 0;
+
+		// m_generation: incremented for each run so that workers know
+		// when new tasks are available.
+		int m_generation = 0;
+
+		// m_stop: set when the workers should exit.
+		bool m_stop = false;
+
+		// m_error: the first exception thrown by a task.
+		std::exception_ptr m_error;
+};
+
+
+
+class HumStatistics {
+	public:
+		             HumStatistics     (void) {};
+		            ~HumStatistics     () {};
+
+		void         clear             (void);
+		bool         isEmpty           (void) const;
+
+		void         addFile           (void);
+		int          getFileCount      (void) const;
+
+		void         increment         (const std::string& group,
+		                                const std::string& key,
+		                                double amount = 1.0);
+		double       getValue          (const std::string& group,
+		                                const std::string& key) const;
+
+		void         merge             (const HumStatistics& other);
+		void         printJson         (std::ostream& out,
+		                                const std::string& name = "") const;
+
+	protected:
+		static void  printJsonString   (std::ostream& out,
+		                                const std::string& text);
+		static void  printJsonNumber   (std::ostream& out, double value);
+
+	private:
+		// m_files: the number of files that were analyzed.
+		int m_files = 0;
+
+		// m_counters: counter values, grouped by category and then by name.
+		std::map<std::string, std::map<std::string, double>> m_counters;
+};
+
+
+
+// Chord types for a 12-tone pitch-class set:
+enum sonority_type {
+	sonority_empty,        // no pitch classes
+	sonority_unison,       // one pitch class
+	sonority_minor_third,  // minor third or major sixth
+	sonority_major_third,  // major third or minor sixth
+	sonority_fifth,        // perfect fifth or perfect fourth
+	sonority_tritone,      // augmented fourth/diminished fifth
+	sonority_dyad,         // other two pitch classes (seconds and sevenths)
+	sonority_major,        // major triad
+	sonority_minor,        // minor triad
+	sonority_diminished,   // diminished triad
+	sonority_augmented,    // augmented triad
+	sonority_trichord,     // other three pitch classes
+	sonority_large         // more than three pitch classes
+};
+
+class HumSonority {
+	public:
+		                HumSonority        (void) {};
+		               ~HumSonority        () {};
+
+		void            clear              (void);
+		bool            isEmpty            (void) const;
+		void            addMidi            (int midi);
+		void            addDiatonic        (int base7);
+		void            addBase40          (int base40);
+		void            setBass            (int midi);
+
+		int             getPitchClassMask  (void) const { return m_pcmask;  }
+		int             getDiatonicMask    (void) const { return m_b7mask;  }
+		uint64_t        getBase40Mask      (void) const { return m_b40mask; }
+		bool            hasPitchClass      (int pc) const;
+		bool            hasDiatonic        (int base7) const;
+		bool            hasBase40          (int base40) const;
+		int             getPitchClassCount (void) const;
+		int             getBass            (void) const { return m_bass;    }
+
+		int             getType            (void) const;
+		int             getRoot            (void) const;
+		int             getThird           (void) const;
+		int             getFifth           (void) const;
+		int             getPosition        (int midi) const;
+		int             getInversion       (void) const;
+
+		static int      getType            (int pcmask);
+		static int      getRoot            (int pcmask);
+		static int      getThird           (int pcmask);
+		static int      getFifth           (int pcmask);
+		static int      getPosition        (int pcmask, int midi);
+		static bool     isTriad            (int type);
+		static int      countBits          (uint64_t mask);
+
+	protected:
+		static void     prepareChordTable  (std::vector<uint32_t>& table);
+		static uint32_t analyzeMask        (int pcmask);
+		static uint32_t getChordEntry      (int pcmask);
+
+	private:
+		// m_pcmask: bit n is set if pitch class n (C=0) is present.
+		int m_pcmask = 0;
+
+		// m_b7mask: bit n is set if diatonic pitch class n (C=0) is present.
+		int m_b7mask = 0;
+
+		// m_b40mask: bit n is set if base-40 pitch class n (C=0) is present.
+		uint64_t m_b40mask = 0;
+
+		// m_bass: pitch class of the bass, or -1 if not set.
+		int m_bass = -1;
+};
+
+
+
+// Data type IDs that are always registered (in this order).  Other
+// exclusive interpretations are given IDs after these when first seen.
+enum datatype_id {
+	datatype_unknown,      // no exclusive interpretation (empty string)
+	datatype_kern,         // **kern
+	datatype_mens,         // **mens
+	datatype_text,         // **text
+	datatype_recip,        // **recip
+	datatype_dynam,        // **dynam
+	datatype_builtin_count
+};
+
+class HumDataType {
+	public:
+		static int                getId       (const std::string& exinterp);
+		static int                findId      (const std::string& exinterp);
+		static const std::string& getName     (int id);
+		static int                getCount    (void);
+
+	protected:
+		// Registry -- The registered data types, shared by all threads.
+		class Registry {
+			public:
+				Registry(void);
+				int addName(const std::string& exinterp);
+				std::mutex mutex;
+				// names: the exclusive interpretation for each ID.  A deque
+				// keeps references to the names valid as more IDs are added.
+				std::deque<std::string> names;
+				// ids: the ID for each exclusive interpretation.
+				std::map<std::string, int> ids;
+		};
+
+		static Registry&          getRegistry (void);
+};
+
+
+
 typedef HumdrumLine* HLp;
 
 class HumdrumLine : public std::string, public HumHash {
@@ -1278,6 +1599,7 @@ class HumdrumLine : public std::string, public HumHash {
 		void        getTokens              (std::vector<HTp>& list);
 		int         getTokenCount          (void) const;
 		int         getFieldCount          (void) const { return getTokenCount(); }
+		int         getTabCount            (int index) const;
 		std::string getTokenString         (int index) const;
 		bool        equalChar              (int index, char ch) const;
 		char        getChar                (int index) const;
@@ -1329,6 +1651,7 @@ class HumdrumLine : public std::string, public HumHash {
 		HumNum   getBeat                (HumNum beatdur = 1);
 		HumNum   getBeatStr             (std::string beatrecip = "4");
 		HTp      getTrackStart          (int track) const;
+		int      getTrackDataType       (int track) const;
 		HTp      getTrackEnd            (int track, int subtrack = 0) const;
 		void     setLineFromCsv         (const char* csv,
 		                                 const std::string& separator = ",");
@@ -1388,6 +1711,8 @@ class HumdrumLine : public std::string, public HumHash {
 		void     clear                  (void);
 		void     setOwner               (void* hfile);
 		int      createTokensFromLine   (void);
+		int      createTokensFromCsv    (const char* csv, int length,
+		                                 const std::string& separator = ",");
 		void     setLayoutParameters    (void);
 		void     setParameters          (const std::string& pdata);
 		void     storeGlobalLinkedParameters(void);
@@ -1477,6 +1802,51 @@ std::ostream& operator<< (std::ostream& out, HLp line);
 
 typedef HumdrumToken* HTp;
 
+
+// HumSubtokenIterator -- Iterate over the subtokens of a token as views
+// into the token text, without allocating strings.  Empty subtokens are
+// included, as in HumdrumToken::getSubtokenCount().  An empty separator
+// iterates over single characters.
+class HumSubtokenIterator {
+	public:
+		                     HumSubtokenIterator (void);
+		                     HumSubtokenIterator (const std::string& text,
+		                                          const std::string& separator);
+		std::string_view     operator*           (void) const;
+		HumSubtokenIterator& operator++          (void);
+		bool                 operator==          (const HumSubtokenIterator& other) const;
+		bool                 operator!=          (const HumSubtokenIterator& other) const;
+		int                  getIndex            (void) const { return m_index; }
+
+	private:
+		void                 findEnd             (void);
+
+		const std::string* m_text      = NULL;
+		const std::string* m_separator = NULL;
+		size_t             m_start     = std::string::npos;
+		size_t             m_end       = std::string::npos;
+		int                m_index     = 0;
+};
+
+
+// HumSubtokenRange -- Return value of HumdrumToken::getSubtokenViews()
+// for use in range-based for loops:
+//    for (std::string_view subtok : token->getSubtokenViews()) { ... }
+// The views are valid until the token text is changed, and iterators are
+// valid while the range exists.
+class HumSubtokenRange {
+	public:
+		                    HumSubtokenRange (const std::string& text,
+		                                      const std::string& separator);
+		HumSubtokenIterator begin            (void) const;
+		HumSubtokenIterator end              (void) const;
+
+	private:
+		const std::string* m_text;
+		std::string        m_separator;
+};
+
+
 class HumdrumToken : public std::string, public HumHash {
 	public:
 		         HumdrumToken              (void);
@@ -1679,8 +2049,10 @@ class HumdrumToken : public std::string, public HumHash {
 		int      getTokenIndex             (void) const;
 		int      getTokenNumber            (void) const;
 		const std::string& getDataType     (void) const;
+		int      getDataTypeId             (void) const;
 		const std::string& getExInterp     (void) { return getDataType(); }
 		bool     isDataType                (const std::string& dtype) const;
+		bool     isDataType                (int datatype) const;
 		bool     isDataTypeLike            (const std::string& dtype) const;
 		bool     isKern                    (void) const;
 		bool     isKernLike                (void) const;
@@ -1694,9 +2066,17 @@ class HumdrumToken : public std::string, public HumHash {
 		bool     noteInLowerSubtrack       (void);
 		std::string   getTrackString       (void) const;
 		int      getSubtokenCount          (const std::string& separator = " ") const;
+		int      getSubtokenCount          (const std::string& separator = " ");
 		std::string   getSubtoken          (int index,
 		                                    const std::string& separator = " ") const;
+		std::string   getSubtoken          (int index,
+		                                    const std::string& separator = " ");
 		std::vector<std::string> getSubtokens (const std::string& separator = " ") const;
+		HumSubtokenRange getSubtokenViews  (const std::string& separator = " ") const;
+		std::string_view getSubtokenView   (int index,
+		                                    const std::string& separator = " ") const;
+		std::string_view getSubtokenView   (int index,
+		                                    const std::string& separator = " ");
 		void     replaceSubtoken           (int index, const std::string& newsubtok,
 		                                    const std::string& separator = " ");
 		void     setParameters             (HTp ptok);
@@ -1815,6 +2195,10 @@ class HumdrumToken : public std::string, public HumHash {
 		void     incrementState            (void);
 		void     setDuration               (const HumNum& dur);
 		void     setStrandIndex            (int index);
+		void     updateDataType            (void);
+		void     prepareSubtokenStarts     (const std::string& separator);
+		bool     hasSubtokenStarts         (const std::string& separator) const;
+		void     clearSubtokenStarts       (void);
 
 		bool     analyzeDuration           (void);
 		std::ostream& printXmlBaseInfo     (std::ostream& out = std::cout, int level = 0,
@@ -1875,6 +2259,20 @@ class HumdrumToken : public std::string, public HumHash {
 		// refers to.
 		HTp m_nullresolve;
 
+		// m_subtokenstarts: Cached start offsets of the subtokens of the
+		// token for m_subtokenseparator (see prepareSubtokenStarts()).
+		// The cache is cleared by setText() and assignment, and is not
+		// used if the length or hash of the text (m_subtokenlength and
+		// m_subtokenhash) changed in any other way since it was filled.
+		// Only the non-const subtoken accessors fill the cache, so the
+		// const accessors can be used for the same token in several
+		// threads at a time.
+		std::vector<int> m_subtokenstarts;
+		std::string      m_subtokenseparator;
+		size_t           m_subtokenlength = 0;
+		size_t           m_subtokenhash = 0;
+		bool             m_subtokenvalid = false;
+
 		// m_linkedParameterTokens: List of Humdrum tokens which are parameters
 		// (mostly only layout parameters at the moment).
 		// Was previously called m_linkedParameters;
@@ -1973,6 +2371,10 @@ class HumFileAnalysis {
 
 			m_barlines_analyzed  = false;
 			m_barlines_different = false;
+
+			m_slices_analyzed    = false;
+			m_references_analyzed = false;
+			m_metric_analyzed    = false;
 		}
 
 		// m_structure_analyzed: Used to keep track of whether or not
@@ -2014,11 +2416,58 @@ class HumFileAnalysis {
 		// any barlines that are not all of the same at the same
 		// times.
 		bool m_barlines_different = false;
+
+		// m_slices_analyzed: Used to keep track of whether or not the
+		// **kern field lists of HumdrumFileContent are up to date.
+		bool m_slices_analyzed = false;
+
+		// m_references_analyzed: Used to keep track of whether or not the
+		// index of reference records is up to date.
+		bool m_references_analyzed = false;
+
+		// m_metric_analyzed: Used to keep track of whether or not the
+		// metric positions of HumdrumFileContent are up to date.
+		bool m_metric_analyzed = false;
 };
 
 bool sortTokenPairsByLineIndex(const TokenPair& a, const TokenPair& b);
 
 
+// HumHttpReader: buffered reader for HTTP responses from a socket.  Data
+// is read from the socket in blocks, and any bytes read past the end of
+// the response header are kept for reading the body of the response.
+// Only used when USING_URI is defined.
+
+class HumHttpReader {
+	public:
+		              HumHttpReader   (int socket_id) { m_socket = socket_id; }
+		             ~HumHttpReader   () {}
+		bool          readLine        (std::string& line);
+		int           read            (char* buffer, int size);
+		int           getSocket       (void) { return m_socket; }
+
+	private:
+		int           fill            (void);
+
+		int  m_socket = -1;
+		int  m_index  = 0;
+		int  m_length = 0;
+		char m_buffer[8192];
+};
+
+
+// HumHttpConnections: keep-alive sockets for downloading data from the
+// web, indexed by "hostname:port".  The sockets are closed when the
+// object is destroyed, such as at the end of the thread that owns it.
+// Only used when USING_URI is defined.
+
+class HumHttpConnections : public std::map<std::string, int> {
+	public:
+		             ~HumHttpConnections ();
+		void          closeAll           (void);
+};
+
+
 class HumdrumFileBase : public HumHash {
 	public:
 		              HumdrumFileBase          (void);
@@ -2055,6 +2504,8 @@ class HumdrumFileBase : public HumHash {
 		bool          areStrandsAnalyzed       (void);
 		bool          areStrophesAnalyzed      (void);
 		void          setFilenameFromSegment   (void);
+		void          setAnalysisThreads       (int count);
+		int           getAnalysisThreads       (void) const;
 
     	template <class TYPE>
 		   void       initializeArray          (std::vector<std::vector<TYPE>>& array, TYPE value);
@@ -2067,13 +2518,13 @@ class HumdrumFileBase : public HumHash {
 		                                    { return readString(contents); }
 		bool          parseCsv                 (std::istream& contents,
 		                                        const std::string& separator = ",")
-		                                    { return readCsv(contents); }
+		                                    { return readCsv(contents, separator); }
 		bool          parseCsv                 (const char* contents,
 		                                        const std::string& separator = ",")
-		                                    { return readStringCsv(contents); }
+		                                    { return readStringCsv(contents, separator); }
 		bool          parseCsv                 (const std::string& contents,
 		                                        const std::string& separator = ",")
-		                                    { return readStringCsv(contents); }
+		                                    { return readStringCsv(contents, separator); }
 
 		void          setXmlIdPrefix           (const std::string& value);
 		std::string   getXmlIdPrefix           (void);
@@ -2113,12 +2564,17 @@ class HumdrumFileBase : public HumHash {
 
 		bool          analyzeNonNullDataTokens (void);
 		HTp           getTrackStart            (int track) const;
+		int           getTrackDataType         (int track) const;
+		const std::vector<int>& getTrackDataTypes (void) const;
+		void          updateTrackDataType      (int track);
 		void          getSpineStopList         (std::vector<HTp>& spinestops);
 		HTp           getSpineStart            (int spine) const
 		                                       { return getTrackStart(spine+1); }
 		void          getSpineStartList        (std::vector<HTp>& spinestarts);
 		void          getSpineStartList        (std::vector<HTp>& spinestarts,
 		                                        const std::string& exinterp);
+		void          getSpineStartList        (std::vector<HTp>& spinestarts,
+		                                        int datatype);
 		void          getSpineStartList        (std::vector<HTp>& spinestarts,
 		                                        const std::vector<std::string>& exinterps);
 		void          getKernSpineStartList    (std::vector<HTp>& spinestarts);
@@ -2174,7 +2630,10 @@ class HumdrumFileBase : public HumHash {
 		std::vector<HLp> getReferenceRecords(void);
 		std::vector<HLp> getGlobalReferenceRecords(void);
 		std::vector<HLp> getUniversalReferenceRecords(void);
+		std::vector<HLp> getReferenceRecords(const std::string& key);
 		std::string getReferenceRecord(const std::string& key);
+		void          analyzeReferenceRecords  (void);
+		void          clearReferenceRecords    (void);
 
 		// spine analysis functionality:
 		void          getTrackSequence         (std::vector<std::vector<HTp> >& sequence,
@@ -2208,6 +2667,10 @@ class HumdrumFileBase : public HumHash {
 		void          readFromHttpUri           (const std::string& webaddress);
 		static void   readStringFromHttpUri     (std::stringstream& inputdata,
 		                                         const std::string& webaddress);
+		static void   setUriCacheDirectory      (const std::string& directory);
+		static std::string getUriCacheDirectory (void);
+		static void   setUriCacheMaxAge         (int seconds);
+		static void   closeHttpConnections      (void);
 
 		bool          analyzeBaseFromLines     (void);
 		bool          analyzeBaseFromTokens    (void);
@@ -2219,13 +2682,34 @@ class HumdrumFileBase : public HumHash {
 		bool          analyzeLines              (void);
 
 	protected:
-		static int    getChunk                  (int socket_id,
+		static int    getChunk                  (HumHttpReader& reader,
 		                                         std::stringstream& inputdata,
 		                                         char* buffer, int bufsize);
-		static int    getFixedDataSize          (int socket_id,
+		static int    getFixedDataSize          (HumHttpReader& reader,
 		                                         int datalength,
 		                                         std::stringstream& inputdata,
 		                                         char* buffer, int bufsize);
+		static bool   requestHttpUri            (std::stringstream& inputdata,
+		                                         const std::string& hostname,
+		                                         unsigned short int port,
+		                                         const std::string& location,
+		                                         const std::string& etag,
+		                                         int& status, std::string& newetag,
+		                                         int& maxage);
+		static int    getHttpConnection         (const std::string& hostname,
+		                                         unsigned short int port,
+		                                         bool& reusedQ);
+		static void   dropHttpConnection        (const std::string& hostname,
+		                                         unsigned short int port);
+		static std::string getUriCacheKey       (const std::string& contents);
+		static bool   readUriCache              (const std::string& webaddress,
+		                                         std::string& contents,
+		                                         std::string& etag,
+		                                         bool& expiredQ);
+		static void   writeUriCache             (const std::string& webaddress,
+		                                         const std::string& contents,
+		                                         const std::string& etag,
+		                                         int maxage);
 		static void   prepare_address           (struct sockaddr_in *address,
 		                                         const std::string& hostname,
 		                                         unsigned short int port);
@@ -2241,16 +2725,21 @@ class HumdrumFileBase : public HumHash {
 		bool          stitchLinesTogether       (HumdrumLine& previous,
 		                                         HumdrumLine& next);
 		void          addToTrackStarts          (HTp token);
+		void          prepareReferenceRecords   (void);
 		void          addUniqueTokens           (std::vector<HTp>& target,
 		                                         std::vector<HTp>& source);
 		bool          processNonNullDataTokensForTrackForward(HTp starttoken,
 		                                         std::vector<HTp> ptokens);
 		bool          processNonNullDataTokensForTrackBackward(HTp starttoken,
 		                                         std::vector<HTp> ptokens);
+		bool          readCsvText               (const char* contents, size_t length,
+		                                         const std::string& separator);
 		bool          setParseError             (std::stringstream& err);
 		bool          setParseError             (const std::string& err);
 		bool          setParseError             (const char* format, ...);
 //		void          fixMerges                 (int linei);
+		void          runParallel               (int count,
+		                                         const std::function<void(int)>& task);
 
 	protected:
 
@@ -2270,6 +2759,19 @@ class HumdrumFileBase : public HumHash {
 		// size of this list.
 		std::vector<HTp> m_trackstarts;
 
+		// m_trackdatatypes: the HumDataType ID of the exclusive
+		// interpretation for each entry in m_trackstarts.
+		std::vector<int> m_trackdatatypes;
+
+		// m_referencelines: the line indexes of the reference records
+		// (global and universal) in the file.
+		std::vector<int> m_referencelines;
+
+		// m_referencekeys: the line indexes of the reference records for
+		// each reference key.  m_referencelines and m_referencekeys are
+		// filled by analyzeReferenceRecords() when first needed.
+		std::map<std::string, std::vector<int>> m_referencekeys;
+
 		// m_trackends: list of the addresses of the spine terminators in the
 		// file. It is possible that spines can split and their subspines do not
 		// merge before termination; therefore, the ends are stored in
@@ -2318,6 +2820,29 @@ class HumdrumFileBase : public HumHash {
 		// m_analysis: Used to keep track of analysis states for the file.
 		HumFileAnalysis m_analyses;
 
+		// m_analysisThreads: Number of threads used for per-spine analyses.
+		// The default of 1 does all analysis in the calling thread.
+		int m_analysisThreads = 1;
+
+		// m_threadPool: Worker threads for per-spine analyses, created
+		// when first needed if m_analysisThreads is greater than 1.
+		std::shared_ptr<HumThreadPool> m_threadPool;
+
+		// m_httpConnections: Open keep-alive sockets for downloading
+		// data from the web, indexed by "hostname:port".  Each thread
+		// has its own connections, so a socket is never shared by
+		// two requests at the same time.
+		static thread_local HumHttpConnections m_httpConnections;
+
+		// m_uriCacheDirectory: Directory for storing downloaded files.
+		// If empty, then the HUMLIB_URI_CACHE environment variable will
+		// be used, and if that is not set, no caching is done.
+		static std::string m_uriCacheDirectory;
+
+		// m_uriCacheMaxAge: Default number of seconds that a cached
+		// download is considered fresh (if server does not specify).
+		static int m_uriCacheMaxAge;
+
 	public:
 		// Dummy functions to allow the HumdrumFile class's inheritance
 		// to be shifted between HumdrumFileContent (the top-level default),
@@ -2498,9 +3023,19 @@ class HumdrumFileStructure : public HumdrumFileBase {
 		                                            HumNum linedur, int line);
 		bool          assignDurationsToTrack       (HTp starttoken,
 		                                            HumNum startdur);
+		template <class DURTYPE>
 		bool          prepareDurations             (HTp token, int state,
-		                                            HumNum startdur);
+		                                            DURTYPE startdur,
+		                                            std::vector<std::pair<HTp, DURTYPE>>* linedurs = NULL);
+		bool          prepareRhythmTicks           (void);
+		template <class DURTYPE>
+		bool          assignDurationsInParallel    (std::vector<int>& tracks,
+		                                            DURTYPE startdur);
+		void          addTokenDuration             (HumNum& dursum, HTp token);
+		void          addTokenDuration             (int64_t& durticks, HTp token);
+		bool          hasCrossTrackMerges          (void);
 		bool          setLineDurationFromStart     (HTp token, HumNum dursum);
+		bool          setLineDurationFromStart     (HTp token, int64_t durticks);
 		bool          analyzeRhythmOfFloatingSpine (HTp spinestart);
 		bool          analyzeNullLineRhythms       (void);
 		void          fillInNegativeStartTimes     (void);
@@ -2517,11 +3052,58 @@ class HumdrumFileStructure : public HumdrumFileBase {
 		void          analyzeSignifiers            (void);
 		void          setLineRhythmAnalyzed        (void);
 		bool          prepareMensurationInformation(void);
+
+	private:
+		// m_rhythmtpq: The number of ticks per quarter note used for integer
+		// timestamps during rhythm analysis (the least common multiple of
+		// the token duration denominators), or 0 if the file's durations
+		// cannot be represented in 64-bit ticks, in which case HumNum
+		// timestamps are used instead.
+		int64_t m_rhythmtpq = 0;
+
+		// m_lineticks: The durationFromStart of each line in ticks while
+		// the rhythm is being analyzed (-1 if not assigned yet).
+		std::vector<int64_t> m_lineticks;
 };
 
 
 
 
+// HumMidiEvent: A note-on, note-off or tempo event generated by
+// HumdrumFileContent::getMidiEvents().
+
+class HumMidiEvent {
+	public:
+		int    tick     = 0;     // absolute time in ticks
+		int    track    = 0;     // **kern spine index (0 = first **kern spine)
+		int    channel  = 0;     // MIDI channel
+		int    key      = 0;     // MIDI key number
+		int    velocity = 0;     // note-on attack velocity (0 = note-off)
+		double tempo    = 0.0;   // if > 0, tempo change in quarter notes per minute
+		HTp    token    = NULL;  // token for the note (NULL for tempo)
+		int    subtoken = 0;     // index of note in chord token
+
+		bool   isTempo   (void) const { return tempo > 0.0; }
+		bool   isNoteOn  (void) const { return (tempo <= 0.0) && (velocity > 0); }
+		bool   isNoteOff (void) const { return (tempo <= 0.0) && (velocity == 0); }
+};
+
+
+// HumMetricPosition: The metric position of a line, from
+// HumdrumFileContent::getMetricPosition().
+
+class HumMetricPosition {
+	public:
+		int    measure = 0;    // measure index (0 = before the first barline)
+		int    beat    = 0;    // beat in the measure (0 = first beat)
+		int    ticks   = 0;    // ticks (see tpq()) from the start of the measure
+		int    weight  = -1;   // 2 = whole-note, 1 = half-note, 0 = quarter-note
+		                       // position in the measure, -1 = otherwise
+		double level   = NAN;  // metric level (see getMetricLevels()), or NAN
+		                       // for non-data lines
+};
+
+
 class HumdrumFileContent : public HumdrumFileStructure {
 	public:
 		       HumdrumFileContent         (void);
@@ -2539,6 +3121,9 @@ class HumdrumFileContent : public HumdrumFileStructure {
 		bool   analyzeMensAccidentals     (void);
 		bool   analyzeRScale              (void);
 
+		// in HumdrumFileContent-notation.cpp
+		bool   analyzeNotation            (void);
+
 		// in HumdrumFileContent-hand.cpp
 		bool   doHandAnalysis             (bool attacksOnlyQ = false);
 		bool   doHandAnalysis             (HTp startSpine, bool attacksOnlyQ = false);
@@ -2546,9 +3131,18 @@ class HumdrumFileContent : public HumdrumFileStructure {
 		// in HumdrumFileContent-kern.cpp
 		std::vector<int> getTrackToKernIndex (void);
 
+		// in HumdrumFileContent-slice.cpp
+		void   analyzeSlices              (void);
+		const std::vector<int>& getKernFieldIndexes (int line);
+		const std::vector<int>& getFieldToKernSpine (int line);
+		int    getFieldKernSpine          (int line, int field);
+
 		// in HumdrumFileContent-midi.cpp
 		void fillMidiInfo(std::vector<std::vector<std::vector<std::pair<HTp, int>>>>& trackMidi);
 		void processStrandNotesForMidi(HTp sstart, HTp send, std::vector<std::vector<std::pair<HTp, int>>>& trackInfo);
+		int  getMidiEvents            (std::function<void(const HumMidiEvent&)> callback,
+		                               int tpq = 0, int tickoffset = 0,
+		                               int velocity = 64);
 
 		// in HumdrumFileContent-rest.cpp
 		void  analyzeRestPositions                  (void);
@@ -2561,6 +3155,9 @@ class HumdrumFileContent : public HumdrumFileStructure {
 		// in HumdrumFileContent-metlev.cpp
 		void  getMetricLevels             (std::vector<double>& output, int track = 0,
 		                                   double undefined = NAN);
+		void  analyzeMetricPositions      (void);
+		const HumMetricPosition& getMetricPosition (int line);
+		int   getMetricTrack              (void);
 		// in HumdrumFileContent-timesig.cpp
 		void  getTimeSigs                 (std::vector<std::pair<int, HumNum> >& output,
 		                                   int track = 0);
@@ -2607,6 +3204,73 @@ class HumdrumFileContent : public HumdrumFileStructure {
 
 	protected:
 
+		// SpanState -- Bookkeeping for linking slur, phrase or beam markers
+		// in a spine (see analyzeSpanMarkers()).
+		class SpanState {
+			public:
+				SpanState(char opener, const std::string& linksig);
+				char        open;         // '(' for slurs, '{' for phrases, 'L' for beams
+				char        close;        // ')' for slurs, '}' for phrases, 'J' for beams
+				std::string name;         // "Slur", "Phrase" or "Beam"
+				std::string prefix;       // "slur", "phrase" or "beam"
+				std::string ignorebegin;  // linked marker start sequence
+				std::string ignoreend;    // linked marker end sequence
+				// opens == unclosed markers: first dimension is elision level,
+				// second dimension is the layer in the spine.
+				std::vector<std::vector<std::vector<HTp>>> opens;
+				std::vector<HTp> linkstarts;
+				std::vector<HTp> linkends;
+		};
+
+		// TieState -- Bookkeeping for linking linked ties (see analyzeKernTieToken()).
+		class TieState {
+			public:
+				TieState(const std::string& linksig);
+				std::string lstart;
+				std::string lmiddle;
+				std::string lend;
+				// startdatabase == open tie for each base-40 pitch.
+				std::vector<std::pair<HTp, int>> startdatabase;
+				std::vector<std::pair<HTp, int>> linkstarts;
+				std::vector<std::pair<HTp, int>> linkends;
+		};
+
+		// AccidentalState -- Accidental states for each staff while
+		// scanning lines (see analyzeAccidentalToken()).
+		class AccidentalState {
+			public:
+				std::vector<int> rtracks;                // track to staff index
+				std::vector<std::vector<int>> keysigs;   // key signature per staff
+				std::vector<std::vector<int>> dstates;   // diatonic states per staff
+				std::vector<std::vector<int>> gdstates;  // grace-note diatonic states
+				std::vector<int> firstinbar;
+				std::vector<int> concurrentstate;
+				int lasttrack = -1;
+		};
+
+		// Shared marker analysis (defined in src/HumdrumFileContent-notation.cpp):
+		void   getLabelSequence           (std::vector<std::pair<HTp, HTp>>& labels,
+		                                   std::vector<int>& endings);
+		void   analyzeSpanMarkers         (HTp token, int layer, int opencount,
+		                                   int closecount, SpanState& state,
+		                                   std::vector<std::pair<HTp, HTp>>& labels,
+		                                   std::vector<int>& endings);
+		void   markHangingSpans           (SpanState& state);
+		void   analyzeSpans               (std::vector<HTp>& spines, char opener,
+		                                   std::vector<HTp>& linkstarts,
+		                                   std::vector<HTp>& linkends);
+		void   analyzeSpineSpans          (HTp spinestart, SpanState& state,
+		                                   std::vector<std::pair<HTp, HTp>>& labels,
+		                                   std::vector<int>& endings);
+		void   linkSpanEndpoints          (HTp start, HTp end, char opener);
+		void   splitSubtokens             (HTp token, std::vector<std::string>& subtokens);
+		void   analyzeKernTieToken        (HTp token, const std::vector<std::string>& subtokens,
+		                                   TieState& state);
+		bool   prepareAccidentalState     (AccidentalState& state, const std::string& dataType);
+		bool   startAccidentalLine        (HumdrumLine& line, AccidentalState& state);
+		void   analyzeAccidentalToken     (HTp token, const std::vector<std::string>& subtokens,
+		                                   AccidentalState& state);
+
 		bool   analyzeKernPhrasings       (HTp spinestart,
 		                                   std::vector<HTp>& linkstarts,
 		                                   std::vector<HTp>& linkends,
@@ -2672,9 +3336,27 @@ class HumdrumFileContent : public HumdrumFileStructure {
 		void    prepareStaffAboveNoteStems (HTp token);
 		void    prepareStaffBelowNoteStems (HTp token);
 
+		void    fillMetricPositions       (std::vector<HumMetricPosition>& positions,
+		                                   int track);
+
 		void    getBaselines              (std::vector<std::vector<int>>& centerlines);
 		void    createLinkedTies          (std::vector<std::pair<HTp, int>>& starts,
 		                                   std::vector<std::pair<HTp, int>>& ends);
+
+	private:
+		// m_kernfields: the field indexes of **kern tokens on each line
+		// (see analyzeSlices()).
+		std::vector<std::vector<int>> m_kernfields;
+
+		// m_fieldkernspine: the **kern spine index (position in
+		// getKernSpineStartList()) for each field on each line, or -1 if
+		// the field is not **kern.
+		std::vector<std::vector<int>> m_fieldkernspine;
+
+		// m_metricpositions: the metric position of each line, using the
+		// time signatures of the first **kern spine (see
+		// analyzeMetricPositions()).
+		std::vector<HumMetricPosition> m_metricpositions;
 };
 
 
@@ -4263,6 +4945,19 @@ class Convert {
 		static bool    isNaN                (double value);
 		static bool    isPowerOfTwo         (int value);
 		static double  pearsonCorrelation   (const std::vector<double> &x, const std::vector<double> &y);
+		static void    prepareCorrelationSums(std::vector<std::vector<long double>>& sums,
+		                                    const std::vector<double>& x,
+		                                    const std::vector<double>& y);
+		static double  windowCorrelation    (const std::vector<std::vector<long double>>& sums,
+		                                    int start, int length);
+		static double  windowCorrelation    (const std::vector<std::vector<long double>>& sums,
+		                                    const std::vector<double>& x,
+		                                    const std::vector<double>& y,
+		                                    int start, int length);
+		static void    correlationScape     (std::vector<std::vector<double>>& scape,
+		                                    const std::vector<double>& x,
+		                                    const std::vector<double>& y,
+		                                    int threads = 1);
 		static double  standardDeviation    (const std::vector<double>& x);
 		static double  standardDeviation    (const std::vector<int>& x);
 		static double  standardDeviationSample(const std::vector<double>& x);
@@ -5614,6 +6309,8 @@ class HumTool : public Options {
 		void          setError        (const std::string& message);
 
 		virtual void  finally         (void) { };
+		virtual bool  isReusable      (void);
+		virtual int   getSegmentBatchSize(void);
 
 	protected:
 		std::stringstream m_humdrum_text;  // output text in Humdrum syntax.
@@ -5721,20 +6418,30 @@ int main(int argc, char** argv) {                      \
 //////////////////////////////
 //
 // STREAM_INTERFACE -- Use HumdrumFileStream (low-memory
-//    usage implementation).
+//    usage implementation).  Only one segment is kept in memory.  With
+//    the --prefetch option, the text of the next segment is read ahead in
+//    a separate thread while the current segment is processed.  Tools
+//    which process several segments at a time read them in batches (see
+//    HumTool::getSegmentBatchSize()).
 //
 
 #define STREAM_INTERFACE(CLASS)                                            \
 int main(int argc, char** argv) {                                          \
 	hum::CLASS interface;                                                   \
+	interface.define("prefetch=b",                                          \
+			"read the next segment while processing the current one");        \
 	if (!interface.process(argc, argv)) {                                   \
 		interface.getError(std::cerr);                                       \
 		return -1;                                                           \
 	}                                                                       \
 	hum::HumdrumFileStream instream(static_cast<hum::Options&>(interface)); \
+	if (interface.getBoolean("prefetch")) {                                 \
+		instream.setPrefetch();                                              \
+	}                                                                       \
 	hum::HumdrumFileSet infiles;                                            \
+	int batchsize = interface.getSegmentBatchSize();                        \
 	bool status = true;                                                     \
-	while (instream.readSingleSegment(infiles)) {                           \
+	while (instream.readSegments(infiles, batchsize)) {                     \
 		status &= interface.run(infiles);                                    \
 	}                                                                       \
 	interface.finally();                                                    \
@@ -5759,6 +6466,102 @@ int main(int argc, char** argv) {                                          \
 
 
 
+//////////////////////////////
+//
+// PARALLEL_STREAM_INTERFACE -- Same as STREAM_INTERFACE, but the segments
+//    are parsed and processed in parallel, each segment with a new
+//    instance of the tool.  Output is printed in input order (Humdrum text
+//    as each batch of segments finishes, then JSON and free text).
+//    Segments are read in batches to limit memory usage.  The options are
+//    parsed once, and the parsed options are copied to the tool instance
+//    of each segment.  The --threads option sets the number of threads
+//    (0 = all hardware threads).
+//
+//    Only use for tools that process each segment independently: finally()
+//    is called for each segment, and nothing is kept between segments, so
+//    tools which accumulate results over all segments (such as statistics
+//    or corpus summaries printed by finally()) must use STREAM_INTERFACE.
+//
+
+#define PARALLEL_STREAM_INTERFACE(CLASS)                                   \
+int main(int argc, char** argv) {                                          \
+	hum::CLASS interface;                                                   \
+	interface.define("threads=i:0",                                         \
+			"number of threads (0 = all hardware threads)");                  \
+	if (!interface.process(argc, argv)) {                                   \
+		interface.getError(std::cerr);                                       \
+		return -1;                                                           \
+	}                                                                       \
+	hum::HumdrumFileStream instream(static_cast<hum::Options&>(interface)); \
+	struct SegmentOutput {                                                  \
+		std::string humdrum, json, free, warning, error;                     \
+		bool text = false;                                                   \
+		bool status = true;                                                  \
+	};                                                                      \
+	hum::HumThreadPool pool(interface.getInteger("threads"));              \
+	int batchsize = 4 * pool.getThreadCount();                              \
+	std::vector<hum::HumdrumFileSet> infiles(batchsize);                    \
+	std::vector<std::stringstream> contents(batchsize);                     \
+	std::vector<SegmentOutput> output(batchsize);                           \
+	std::stringstream jsontext;                                             \
+	std::stringstream freetext;                                             \
+	std::stringstream errortext;                                            \
+	bool anytext = false;                                                   \
+	bool status = true;                                                     \
+	int last = -1;                                                          \
+	int count;                                                              \
+	do {                                                                    \
+		for (count=0; count<batchsize; count++) {                            \
+			hum::HumdrumFile* infile = new hum::HumdrumFile;                  \
+			if (!instream.getFileText(*infile, contents[count])) {            \
+				delete infile;                                                 \
+				break;                                                         \
+			}                                                                 \
+			infiles[count].clear();                                           \
+			infiles[count].appendHumdrumPointer(infile);                      \
+			last = count;                                                     \
+		}                                                                    \
+		pool.run(count, [&](int index) {                                     \
+			hum::HumdrumFileStream::parseFileText(infiles[index][0],          \
+					contents[index]);                                           \
+			hum::CLASS tool;                                                  \
+			static_cast<hum::Options&>(tool) = interface;                     \
+			SegmentOutput& out = output[index];                               \
+			out.status  = tool.run(infiles[index]);                           \
+			tool.finally();                                                   \
+			out.text    = tool.hasAnyText();                                  \
+			out.humdrum = tool.getHumdrumText();                              \
+			out.json    = tool.getJsonText();                                 \
+			out.free    = tool.getFreeText();                                 \
+			out.warning = tool.getWarning();                                  \
+			out.error   = tool.getError();                                    \
+		});                                                                  \
+		for (int i=0; i<count; i++) {                                        \
+			std::cerr << output[i].warning;                                   \
+			std::cout << output[i].humdrum;                                   \
+			jsontext  << output[i].json;                                      \
+			freetext  << output[i].free;                                      \
+			errortext << output[i].error;                                     \
+			anytext |= output[i].text;                                        \
+			status  &= output[i].status;                                      \
+		}                                                                    \
+	} while (count == batchsize);                                           \
+	std::cout << jsontext.str();                                            \
+	std::cout << freetext.str();                                            \
+	if (!errortext.str().empty()) {                                         \
+		std::cerr << errortext.str();                                        \
+		return -1;                                                           \
+	}                                                                       \
+	if (!anytext && (last >= 0)) {                                          \
+		for (int i=0; i<infiles[last].getCount(); i++) {                     \
+			std::cout << infiles[last][i];                                    \
+		}                                                                    \
+	}                                                                       \
+	return !status;                                                         \
+}
+
+
+
 //////////////////////////////
 //
 // RAW_STREAM_INTERFACE -- Use HumdrumFileStream but send the
@@ -5840,8 +6643,11 @@ class HumdrumFileStream {
 		                HumdrumFileStream  (const std::vector<std::string>& list);
 		                HumdrumFileStream  (Options& options);
 		                HumdrumFileStream  (const std::string& datastream);
+		                HumdrumFileStream  (std::istream& input);
+		               ~HumdrumFileStream  ();
 
 		void            loadString         (const std::string& data);
+		void            setPrefetch        (bool state = true);
 
 		int             setFileList        (char** list);
 		int             setFileList        (const std::vector<std::string>& list);
@@ -5850,21 +6656,45 @@ class HumdrumFileStream {
 		int             eof                (void);
 
 		int             getFile            (HumdrumFile& infile);
+		int             getFileText        (HumdrumFile& infile,
+		                                    std::stringstream& contents);
+		static void     parseFileText      (HumdrumFile& infile,
+		                                    std::stringstream& contents);
 		int             read               (HumdrumFile& infile);
 		int             read               (HumdrumFileSet& infiles);
 		int             readSingleSegment  (HumdrumFileSet& infiles);
+		int             readSegments       (HumdrumFileSet& infiles, int count);
 
 	protected:
 		std::stringstream m_stringbuffer;   // used to read files from a string
 		std::ifstream     m_instream;       // used to read from list of files
 		std::stringstream m_urlbuffer;      // used to read data over internet
+		std::istream*     m_input = NULL;   // used to read from a given istream
 		std::string       m_newfilebuffer;  // used to keep track of !!!!segment:
 		                                    // records.
 
 		std::vector<std::string>  m_filelist;       // used when not using cin
 		int                       m_curfile;        // index into filelist
 
-		std::vector<std::string>  m_universals;     // storage for universal comments
+		// m_universals: universal comments of the stream, already demoted to
+		// global comments so that they are prepended to each segment with
+		// a single append.
+		std::string               m_universals;
+
+		// m_readbuffer: fixed-size read-ahead buffer for m_instream.
+		std::vector<char>         m_readbuffer;
+
+		// Reading the next segment in a separate thread while the current
+		// one is parsed and processed (see setPrefetch()):
+		bool                      m_prefetchQ = false;
+		int                       m_prefetchstatus = -1;
+		HumdrumFile               m_prefetchfile;
+		std::stringstream         m_prefetchtext;
+		std::future<int>          m_prefetch;
+
+		int      readFileText             (HumdrumFile& infile,
+		                                   std::stringstream& contents);
+		int      waitForPrefetch          (void);
 
 		// Automatic URL downloading of data from internet in read():
 		void     fillUrlBuffer            (std::stringstream& uribuffer,
@@ -5919,6 +6749,143 @@ class HumdrumFileSet {
 
 
 
+class HumCatalog {
+	public:
+		                 HumCatalog       (void);
+		                ~HumCatalog       ();
+
+		void             clear            (void);
+
+		// building the catalog:
+		bool             addFile          (const std::string& filename);
+		bool             addStream        (std::istream& input,
+		                                   const std::string& filename);
+
+		// reading/writing the catalog:
+		bool             readCatalog      (const std::string& filename);
+		bool             readCatalog      (std::istream& input);
+		bool             writeCatalog     (const std::string& filename);
+		std::ostream&    printCatalog     (std::ostream& out = std::cout);
+
+		// accessing entries:
+		int              getEntryCount    (void) const;
+		std::vector<std::string> getFieldNames(void) const;
+		bool             hasField         (const std::string& field) const;
+		const std::string& getValue       (int entry, const std::string& field) const;
+		const std::string& getFilename    (int entry) const;
+		const std::string& getSegment     (int entry) const;
+		int64_t          getOffset        (int entry) const;
+		bool             readEntry        (int entry, HumdrumFile& infile);
+
+		// queries (each returns the matching entry indexes in order):
+		std::vector<int> getAllEntries    (void) const;
+		std::vector<int> findEqual        (const std::string& field,
+		                                   const std::string& value) const;
+		std::vector<int> findPrefix       (const std::string& field,
+		                                   const std::string& prefix) const;
+		std::vector<int> findRange        (const std::string& field,
+		                                   double minimum, double maximum);
+		std::vector<int> query            (const std::string& expression);
+		static std::vector<int> intersect (const std::vector<int>& a,
+		                                   const std::vector<int>& b);
+
+	protected:
+		void             addEntry         (const std::string& filename,
+		                                   const std::string& segment, int64_t offset,
+		                                   std::map<std::string, std::string>& fields);
+		void             scanHeaderLine   (const std::string& line,
+		                                   std::map<std::string, std::string>& fields,
+		                                   bool& spinesQ, bool& doneQ);
+		const std::vector<double>& getNumbers(const std::string& field);
+		std::vector<int> queryCondition   (const std::string& condition);
+		static std::string escapeValue    (const std::string& value);
+		static std::string unescapeValue  (const std::string& value);
+
+	private:
+		// m_count: the number of entries (files or segments) in the catalog.
+		int m_count = 0;
+
+		// m_columns: the values of each field for every entry.  Entries
+		// without a field have an empty value.  The fields "filename",
+		// "segment" and "offset" give the location of the entry, and
+		// the fields "spines", "voices" (**kern spines), "meter", "keysig"
+		// and "key" are taken from the first spine lines.  Other fields
+		// are the keys of reference records.
+		std::map<std::string, std::vector<std::string>> m_columns;
+
+		// m_numbers: numeric values of the fields used in range queries
+		// (NAN for values that are not numbers), made when first needed.
+		std::map<std::string, std::vector<double>> m_numbers;
+};
+
+
+
+// HumLyricEntry: A word in HumLyricIndex, and the location of its
+// first syllable.
+
+class HumLyricEntry {
+	public:
+		int         file  = 0;   // index of the file in the lyric index
+		int         track = 0;   // track of the text spine
+		int         line  = 0;   // line index of the first syllable
+		int         field = 0;   // field index of the first syllable
+		std::string word;        // word with syllable hyphens removed
+};
+
+
+class HumLyricIndex {
+	public:
+		                 HumLyricIndex    (void);
+		                ~HumLyricIndex    ();
+
+		void             clear            (void);
+
+		// building the index:
+		int              addFile          (HumdrumFile& infile);
+		bool             addFile          (const std::string& filename);
+
+		// reading/writing the index:
+		bool             readIndex        (const std::string& filename);
+		bool             readIndex        (std::istream& input);
+		bool             writeIndex       (const std::string& filename);
+		std::ostream&    printIndex       (std::ostream& out = std::cout);
+
+		// accessing entries:
+		int              getEntryCount    (void) const;
+		int              getFileCount     (void) const;
+		const std::string& getFilename    (int file) const;
+		const HumLyricEntry& getEntry     (int entry) const;
+		int              getNextEntry     (int entry) const;
+		HTp              getToken         (int entry, HumdrumFile& infile) const;
+
+		// queries (each returns the matching entry indexes in order,
+		// and ignores the case of letters):
+		std::vector<int> findWord         (const std::string& word) const;
+		std::vector<int> findPrefix       (const std::string& prefix) const;
+		std::vector<int> findWildcard     (const std::string& pattern) const;
+		std::vector<int> findRegex        (const std::string& exp) const;
+
+	protected:
+		void             addWordsForSpine (int file, HTp starttoken);
+		void             indexEntries     (int startentry);
+		static std::string foldCase       (const std::string& input);
+		static bool      wildcardMatch    (const char* pattern, const char* text);
+
+	private:
+		// m_filenames: the filenames (or !!!!SEGMENT names) of the files
+		// in the index.
+		std::vector<std::string> m_filenames;
+
+		// m_entries: the words of each file, in the order of the text spines
+		// and then of the lines in each spine.
+		std::vector<HumLyricEntry> m_entries;
+
+		// m_words: the entries of each word, with letters in lower case.
+		std::map<std::string, std::vector<int>> m_words;
+};
+
+
+
 class Tool_1520ify : public HumTool {
 	public:
 		            Tool_1520ify       (void);
@@ -6105,6 +7072,7 @@ class Tool_autobeam : public HumTool {
 		bool         run                 (HumdrumFileSet& infiles);
 		bool         run                 (const std::string& indata, std::ostream& out);
 		bool         run                 (HumdrumFile& infile, std::ostream& out);
+		bool         isReusable          (void);
 
 	protected:
 		void         initialize          (HumdrumFile& infile);
@@ -6701,6 +7669,8 @@ class Tool_cint : public HumTool {
 		bool     run                    (HumdrumFile& infile);
 		bool     run                    (const std::string& indata, ostream& out);
 		bool     run                    (HumdrumFile& infile, ostream& out);
+		void     finally                (void);
+		HumStatistics& getStatistics    (void);
 
 	protected:
 
@@ -6835,6 +7805,8 @@ class Tool_cint : public HumTool {
 		int       uncrossQ     = 0;      // used with -c option
 		int       retroQ       = 0;      // used with --retro option
 		int       idQ          = 0;      // used with --id option
+		int       statsQ       = 0;      // used with --stats option
+		HumStatistics m_stats;           // used with --stats option
 		std::vector<std::string> Ids;    // used with --id option
 		std::string NoteMarker;          // used with -N option
 		std::string MarkColor;           // used with --color
@@ -7770,29 +8742,31 @@ class Tool_dissonant : public HumTool {
 		bool     run               (HumdrumFile& infile);
 		bool     run               (const string& indata, ostream& out);
 		bool     run               (HumdrumFile& infile, ostream& out);
+		void     finally           (void);
+		HumStatistics& getStatistics(void);
 
 	protected:
-		void    doAnalysis         (vector<vector<string> >& results,
+		void    doAnalysis         (vector<vector<int> >& results,
 		                            NoteGrid& grid,
 		                            vector<vector<NoteCell*> >& attacks,
 		                            bool debug);
-		void    doAnalysisForVoice (vector<vector<string> >& results,
+		void    doAnalysisForVoice (vector<vector<int> >& results,
 		                            NoteGrid& grid,
 		                            vector<NoteCell*>& attacks,
 		                            int vindex, bool debug);
-		void    findFakeSuspensions(vector<vector<string> >& results,
+		void    findFakeSuspensions(vector<vector<int> >& results,
 		                            NoteGrid& grid,
 		                            vector<NoteCell*>& attacks, int vindex);
-		void    findAppoggiaturas  (vector<vector<string> >& results,
+		void    findAppoggiaturas  (vector<vector<int> >& results,
 		                            NoteGrid& grid,
 		                            vector<NoteCell*>& attacks, int vindex);
-		void    findLs             (vector<vector<string> >& results,
+		void    findLs             (vector<vector<int> >& results,
 		                            NoteGrid& grid,
 		                            vector<NoteCell*>& attacks, int vindex);
-		void    findYs             (vector<vector<string> >& results,
+		void    findYs             (vector<vector<int> >& results,
 		                            NoteGrid& grid,
 		                            vector<NoteCell*>& attacks, int vindex);
-		void    findCadentialVoiceFunctions(vector<vector<string> >& results,
+		void    findCadentialVoiceFunctions(vector<vector<int> >& results,
 		                            NoteGrid& grid, vector<NoteCell*>& attacks,
 		                            vector<vector<string> >& voiceFuncs,
 		                            int vindex);
@@ -7802,18 +8776,25 @@ class Tool_dissonant : public HumTool {
 		                            int sliceindex);
 		void    fillLabels         (void);
 		void    fillLabels2        (void);
+		void    fillLabelIndexes   (void);
+		bool    isLabel            (int value, int label);
+		bool    isUnexplained      (int value);
+		vector<string> getLabelStrings(vector<int>& results);
+		void    printCountAnalysis (vector<vector<int> >& data);
 		void    printCountAnalysis (vector<vector<string> >& data);
+		void    addStatistics      (vector<vector<int> >& data);
+		void    addStatistics      (vector<vector<string> >& data);
 		void    suppressDissonances(HumdrumFile& infile, NoteGrid& grid,
 		                            vector<vector<NoteCell* > >& attacks,
-		                            vector<vector<string> >& results);
+		                            vector<vector<int> >& results);
 		void    suppressDissonancesInVoice(HumdrumFile& infile,
 		                            NoteGrid& grid, int vindex,
 		                            vector<NoteCell*>& attacks,
-		                            vector<string>& results);
+		                            vector<int>& results);
 		void    suppressSusOrnamentsInVoice(HumdrumFile& infile,
 		                            NoteGrid& grid, int vindex,
 		                            vector<NoteCell*>& attacks,
-		                            vector<string>& results);
+		                            vector<int>& results);
 		void    mergeWithPreviousNote(HumdrumFile& infile, int line, int field);
 		void    mergeWithNextNote(HumdrumFile& infile, int line, int field);
 		void    changeDurationOfNote(HTp note, HumNum dur);
@@ -7844,9 +8825,17 @@ class Tool_dissonant : public HumTool {
 		bool voiceFuncsQ = false;
 		bool m_voicenumQ = false;
 		bool m_selfnumQ = false;
+		bool m_statsQ = false;
+
+		// m_stats: dissonance counts of all files analyzed with --stats.
+		HumStatistics m_stats;
 
 		vector<string> m_labels;
 
+		// m_labelIndex: the first label type with the same text as each
+		// label type (see fillLabelIndexes()).
+		vector<int> m_labelIndex;
+
 		// unaccdented non-harmonic tones:
 		const int PASSING_UP           =  0; // rising passing tone
 		const int PASSING_DOWN         =  1; // downward passing tone
@@ -7903,6 +8892,10 @@ class Tool_dissonant : public HumTool {
 		const int UNLABELED_Z4         = 47; // unknown dissonance type, 4th interval
 
 		const int LABELS_SIZE          = 48; // one more than last index
+
+		// analysis results for notes without a label:
+		const int NO_LABEL             = -1; // no dissonance label
+		const int NULL_LABEL           = -2; // null label (not assigned by the analysis)
 };
 
 
@@ -8231,6 +9224,7 @@ class Tool_extract : public HumTool {
 		bool     run                    (HumdrumFile& infile);
 		bool     run                    (const std::string& indata, std::ostream& out);
 		bool     run                    (HumdrumFile& infile, std::ostream& out);
+		bool     isReusable             (void);
 
 	protected:
 
@@ -8528,6 +9522,11 @@ class Tool_filter : public HumTool {
 		void     removeUniversalFilterLines (HumdrumFileSet& infiles);
 		void     splitPipeline      (std::vector<std::string>& clist, const std::string& command);
 
+		template <class TOOL>
+		TOOL*    getTool            (const std::string& command);
+		void     releaseTool        (const std::string& command, HumTool* tool);
+		static std::map<std::string, std::unique_ptr<HumTool>>& getToolCache(void);
+
 	private:
 		std::string   m_variant;        // used with -v option.
 		bool     m_debugQ = false; // used with --debug option
@@ -8535,6 +9534,36 @@ class Tool_filter : public HumTool {
 };
 
 
+
+//////////////////////////////
+//
+// Tool_filter::getTool -- Return an instance of a tool with the options
+//     of a filter command (such as "transpose -k c") processed.  Instances
+//     of reusable tools are kept for each command in the current thread,
+//     so their options are only defined and processed once.  Call
+//     releaseTool() after running the tool.
+//
+
+template <class TOOL>
+TOOL* Tool_filter::getTool(const std::string& command) {
+	std::map<std::string, std::unique_ptr<HumTool>>& cache = getToolCache();
+	auto it = cache.find(command);
+	if (it != cache.end()) {
+		return static_cast<TOOL*>(it->second.get());
+	}
+	TOOL* tool = new TOOL;
+	tool->process(command);
+	if (tool->isReusable()) {
+		if (cache.size() >= 100) {
+			// Avoid unlimited growth when commands vary for each file.
+			cache.clear();
+		}
+		cache[command].reset(tool);
+	}
+	return tool;
+}
+
+
 class Tool_fixps : public HumTool {
 	public:
 		         Tool_fixps         (void);
@@ -9084,6 +10113,33 @@ class Tool_humtr : public HumTool {
 };
 
 
+//////////////////////////////
+//
+// ImitationVoice -- The attacks of a voice as integer intervals and
+//    duration IDs, with an index of the attacks that can start a match.
+//
+
+class ImitationVoice {
+	public:
+		static const int NOINTERVAL = INT_MIN;
+
+		// intervals: the diatonic interval from each attack to the next one,
+		// or NOINTERVAL if either attack is a rest (or for the last attack).
+		vector<int> intervals;
+
+		// durations: the duration ID of each attack (all zero if durations
+		// are not compared).
+		vector<int> durations;
+
+		// starttimes: the start time of each attack in the score.
+		vector<HumNum> starttimes;
+
+		// starts: the attack indexes in increasing order for each interval
+		// and duration ID pair (excluding rests).
+		map<pair<int, int>, vector<int>> starts;
+};
+
+
 class Tool_imitation : public HumTool {
 	public:
 		         Tool_imitation    (void);
@@ -9102,12 +10158,16 @@ class Tool_imitation : public HumTool {
 		void    analyzeImitation  (vector<vector<string>>& results,
 		                            vector<vector<NoteCell*>>& attacks,
 		                            vector<vector<double>>& intervals,
+		                            vector<ImitationVoice>& voices,
 		                            int v1, int v2);
 		void    getIntervals       (vector<double>& intervals,
 		                            vector<NoteCell*>& attacks);
-		int     compareSequences   (vector<NoteCell*>& attack1, vector<double>& seq1,
-		                            int i1, vector<NoteCell*>& attack2,
-		                            vector<double>& seq2, int i2);
+		void    prepareVoice       (ImitationVoice& voice,
+		                            vector<NoteCell*>& attacks,
+		                            vector<double>& intervals,
+		                            map<HumNum, int>& durationids);
+		int     compareSequences   (ImitationVoice& voice1, int i1,
+		                            ImitationVoice& voice2, int i2);
 		int     checkForIntervalSequence(vector<int>& m_intervals,
 		                            vector<double>& v1i, int starti, int count);
 		void    markedTiedNotes    (vector<HTp>& tokens);
@@ -9972,13 +11032,14 @@ class SonorityNoteData {
 class SonorityDatabase {
 	public:
 		SonorityDatabase(void) { clear(); }
-		void clear(void)       { m_notes.clear(); m_line = NULL; }
+		void clear(void)       { m_notes.clear(); m_line = NULL; m_sonority.clear(); }
 		int getCount(void)     { return (int)m_notes.size(); }
 		int getNoteCount(void) { return (int)m_notes.size(); }
 		int getSize(void)      { return (int)m_notes.size(); }
 		bool isEmpty(void)     { return m_notes.empty(); }
 		HLp getLine(void)      { return m_line; }
 		SonorityNoteData& getLowest(void) { return m_lowest; };
+		const HumSonority& getSonority(void) { return m_sonority; }
 		void addNote          (const std::string& text);
 		void buildDatabase     (HLp line);
 		SonorityNoteData& operator[](int index) {
@@ -9993,6 +11054,9 @@ class SonorityDatabase {
 		SonorityNoteData m_lowest;
 		std::vector<SonorityNoteData> m_notes;
 		HLp m_line = NULL;
+
+		// m_sonority: diatonic and base-40 pitch classes of m_notes.
+		HumSonority m_sonority;
 };
 
 
@@ -10022,6 +11086,7 @@ class MSearchQueryToken {
 			harmonic    = token.harmonic;
 			hpieces     = token.hpieces;
 			hquery      = token.hquery;
+			hsonority   = token.hsonority;
 		}
 		MSearchQueryToken& operator=(const MSearchQueryToken& token) {
 			if (this == &token) {
@@ -10038,6 +11103,7 @@ class MSearchQueryToken {
 			harmonic    = token.harmonic;
 			hpieces     = token.hpieces;
 			hquery      = token.hquery;
+			hsonority   = token.hsonority;
 			cinterval   = token.cinterval;
 			duration    = token.duration;
 			rhythm      = token.rhythm;
@@ -10057,6 +11123,7 @@ class MSearchQueryToken {
 			harmonic     = "";
 			hpieces.clear();
 			hquery.clear();
+			hsonority.clear();
 			rhythm       = "";
 		}
 		void parseHarmonicQuery(void);
@@ -10077,6 +11144,7 @@ class MSearchQueryToken {
 		std::string harmonic; // harmonic query
 		std::vector<std::string> hpieces;
 		std::vector<SonorityNoteData> hquery;
+		HumSonority hsonority; // pitch classes in hquery
 
 		// rhythm features:
 		HumNum duration;
@@ -10177,10 +11245,6 @@ class Tool_msearch : public HumTool {
 		                            vector<NoteCell*>& match);
 		void    storeMatch         (vector<NoteCell*>& match);
 		void    markTextMatch      (HumdrumFile& infile, TextInfo& word);
-		void    fillWords          (HumdrumFile& infile,
-		                            vector<TextInfo*>& words);
-		void    fillWordsForTrack  (vector<TextInfo*>& words,
-		                            HTp starttoken);
 		void    printQuery         (vector<MSearchQueryToken>& query);
 		void    addMusicSearchSummary(HumdrumFile& infile, int mcount, const std::string& marker);
 		void    addTextSearchSummary(HumdrumFile& infile, int mcount, const std::string& marker);
@@ -10794,6 +11858,20 @@ class Tool_pbar : public HumTool {
 
 
 
+// PccountHistogram: Pitch-class counts by instrument name, which can be
+// merged to combine the counts of several files.
+
+class PccountHistogram {
+	public:
+		void  clear                     (void);
+		int   getVoiceIndex             (const std::string& name);
+		void  merge                     (const PccountHistogram& histogram);
+
+		std::vector<std::string>         names;  // instrument name of each voice
+		std::vector<std::vector<double>> counts; // base-40 pitch-class counts by voice
+};
+
+
 class Tool_pccount : public HumTool {
 	public:
 		      Tool_pccount              (void);
@@ -10803,13 +11881,23 @@ class Tool_pccount : public HumTool {
 		bool  run                       (HumdrumFile& infile);
 		bool  run                       (const std::string& indata, std::ostream& out);
 		bool  run                       (HumdrumFile& infile, std::ostream& out);
+		void  finally                   (void);
+		int   getSegmentBatchSize       (void);
+
+		const PccountHistogram& getHistogram (void) const;
+		void  mergeHistogram            (const PccountHistogram& histogram);
 
 	protected:
 		void   initialize               (HumdrumFile& infile);
 		void   processFile              (HumdrumFile& infile);
+		void   printOutput              (HumdrumFile& infile);
 		void   initializePartInfo       (HumdrumFile& infile);
-		void   addCounts                (HTp sstart, HTp send);
+		void   addCounts                (HTp sstart, HTp send,
+		                                 std::vector<double>& counts);
 		void   countPitches             (HumdrumFile& infile);
+		void   fillHistogram            (HumdrumFile& infile,
+		                                 PccountHistogram& histogram);
+		void   loadHistogram            (void);
 		void   printHumdrumTable        (void);
 		void   printPitchClassList      (void);
 		void   printVegaLiteJsonTemplate(const std::string& datavariable, HumdrumFile& infile);
@@ -10843,6 +11931,7 @@ class Tool_pccount : public HumTool {
 		std::vector<std::string>       m_abbreviations;
 		std::vector<std::vector<double>> m_counts;
 		bool m_attack       = false;
+		bool m_corpus       = false;
 		bool m_full         = false;
 		bool m_doublefull   = false;
 		bool m_normalize    = false;
@@ -10861,6 +11950,9 @@ class Tool_pccount : public HumTool {
 		std::string m_id    = "id";
 		std::map<std::string, std::string> m_vcolor;
 
+		// m_histogram: the counts of all inputs for the --corpus option.
+		PccountHistogram m_histogram;
+
 };
 
 
@@ -11070,6 +12162,7 @@ class _VoiceInfo {
 	public:
 		                _VoiceInfo        (void);
 		void            clear             (void);
+		void            add               (const _VoiceInfo& info);
 		std::ostream&   print             (std::ostream& out);
 
 };
@@ -11085,12 +12178,16 @@ class Tool_prange : public HumTool {
 		bool        run               (HumdrumFile& infile);
 		bool        run               (const std::string& indata, std::ostream& out);
 		bool        run               (HumdrumFile& infile, std::ostream& out);
+		void        finally           (void);
+		int         getSegmentBatchSize(void);
 
 	protected:
 		void        processFile         (HumdrumFile& infile);
 		void        initialize          (void);
 
 		void        mergeAllVoiceInfo           (std::vector<_VoiceInfo>& voiceInfo);
+		void        mergeCorpusVoiceInfo        (std::vector<_VoiceInfo>& voiceInfo);
+		void        printCorpusAnalysis         (void);
 		void        getVoiceInfo                (std::vector<_VoiceInfo>& voiceInfo, HumdrumFile& infile);
 		std::string getHand                     (HTp sstart);
 		void        fillHistograms              (std::vector<_VoiceInfo>& voiceInfo, HumdrumFile& infile);
@@ -11147,6 +12244,7 @@ class Tool_prange : public HumTool {
 		bool m_accQ         = false; // for --acc option
 		bool m_addFractionQ = false; // for --fraction option
 		bool m_allQ         = false; // for --all option
+		bool m_corpusQ      = false; // for --corpus option
 		bool m_debugQ       = false; // for --debug option
 		bool m_defineQ      = false; // for --score option (use text macro)
 		bool m_diatonicQ    = false; // for --diatonic option
@@ -11194,6 +12292,13 @@ class Tool_prange : public HumTool {
                 // m_voiceCount: Number of voices: (0 minimum voices)
 		int m_voiceCount = 0;
 
+		// m_corpusInfo: combined histograms of all inputs for the --corpus
+		// option (index 0 is the sum of all voices), and m_corpusKeys: the
+		// instrument name (with --instrument) or **kern spine number that
+		// identifies each voice.
+		std::vector<_VoiceInfo> m_corpusInfo;
+		std::vector<std::string> m_corpusKeys;
+
 };
 
 
@@ -11257,6 +12362,7 @@ class Tool_rid : public HumTool {
 		bool     run               (HumdrumFile& infile);
 		bool     run               (const std::string& indata, std::ostream& out);
 		bool     run               (HumdrumFile& infile, std::ostream& out);
+		bool     isReusable        (void);
 
 	protected:
 		void     processFile       (HumdrumFile& infile);
@@ -11573,6 +12679,40 @@ class Tool_semitones : public HumTool {
 
 
 
+class ShedExpression {
+	public:
+		std::string search;      // search string
+		std::string replace;     // replace string
+		std::string grepoptions; // "i" (ignore case) and/or "g" (global)
+
+		// list of exclusive interpretations to process (all if empty)
+		std::vector<std::string> exinterps;
+
+		bool data           = true;  // process data
+		bool barline        = false; // process barlines
+		bool exinterp       = false; // process exclusive interpretations
+		bool interpretation = false; // process interpretations
+		bool localcomment   = false; // process local comments
+		bool globalcomment  = false; // process global comments
+		bool reference      = false; // process reference records
+		bool referencekey   = false; // process reference records keys
+		bool referencevalue = false; // process reference records values
+
+		// Compiled search string, and the search string following the
+		// signifier of each record type:
+		std::regex searchRegex;
+		std::regex barlineRegex;
+		std::regex interpretationRegex;
+		std::regex localCommentRegex;
+		std::regex globalCommentRegex;
+		std::regex referenceRegex;
+		std::regex exinterpRegex;
+
+		// replaceFlags: format_first_only unless the "g" option is given.
+		std::regex_constants::match_flag_type replaceFlags;
+};
+
+
 class Tool_shed : public HumTool {
 	public:
 		         Tool_shed       (void);
@@ -11582,28 +12722,44 @@ class Tool_shed : public HumTool {
 		bool     run               (HumdrumFile& infile);
 		bool     run               (const std::string& indata, std::ostream& out);
 		bool     run               (HumdrumFile& infile, std::ostream& out);
+		bool     isReusable        (void);
 
 	protected:
 		void    processFile                      (HumdrumFile& infile);
-		void    processExpression                (HumdrumFile& infile);
-		void    searchAndReplaceInterpretation   (HumdrumFile& infile);
-		void    searchAndReplaceExinterp         (HumdrumFile& infile);
-		void    searchAndReplaceData             (HumdrumFile& infile);
-		void    searchAndReplaceBarline          (HumdrumFile& infile);
-		void    searchAndReplaceLocalComment     (HumdrumFile& infile);
-		void    searchAndReplaceGlobalComment    (HumdrumFile& infile);
-		void    searchAndReplaceReferenceRecords (HumdrumFile& infile);
-		void    searchAndReplaceReferenceKeys    (HumdrumFile& infile);
-		void    searchAndReplaceReferenceValues  (HumdrumFile& infile);
+		void    processExpression                (HumdrumFile& infile,
+		                                          ShedExpression& expression);
+		void    processLines                     (HumdrumFile& infile);
+		bool    processLine                      (HumdrumFile& infile, int index,
+		                                          ShedExpression& expression);
+		bool    searchAndReplaceInterpretation   (HumdrumFile& infile, int index,
+		                                          ShedExpression& expression);
+		bool    searchAndReplaceExinterp         (HumdrumFile& infile, int index,
+		                                          ShedExpression& expression);
+		bool    searchAndReplaceData             (HumdrumFile& infile, int index,
+		                                          ShedExpression& expression);
+		bool    searchAndReplaceBarline          (HumdrumFile& infile, int index,
+		                                          ShedExpression& expression);
+		bool    searchAndReplaceLocalComment     (HumdrumFile& infile, int index,
+		                                          ShedExpression& expression);
+		bool    searchAndReplaceGlobalComment    (HumdrumFile& infile, int index,
+		                                          ShedExpression& expression);
+		bool    searchAndReplaceReferenceRecords (HumdrumFile& infile, int index,
+		                                          ShedExpression& expression);
+		bool    searchAndReplaceReferenceKeys    (HumdrumFile& infile, int index,
+		                                          ShedExpression& expression);
+		bool    searchAndReplaceReferenceValues  (HumdrumFile& infile, int index,
+		                                          ShedExpression& expression);
 
 		void    initialize         (void);
 		void    initializeSegment  (HumdrumFile& infile);
-		bool    isValid            (HTp token);
-		bool    isValidDataType    (HTp token);
+		bool    isValid            (HTp token, ShedExpression& expression);
+		bool    isValidDataType    (HTp token, ShedExpression& expression);
 		bool    isValidSpine       (HTp token);
 		std::vector<std::string> addToExInterpList(void);
 		void    parseExpression    (const std::string& value);
 		void    prepareSearch      (int index);
+		void    prepareExpressions (void);
+		bool    needsSequentialProcessing(void);
 		std::string getExInterp    (const std::string& value);
 
 	private:
@@ -11628,11 +12784,13 @@ class Tool_shed : public HumTool {
 		std::string m_yInterp; // used with -y option
 		std::string m_zInterp; // used with -z option
 
-		bool m_modified       = false;
-
 		// list of exclusive interpretations to process
 		std::vector<std::string> m_exinterps;
 		std::string m_exclusion;
+		std::regex m_exclusionRegex;
+
+		// m_expressions: the compiled expressions, in the order given.
+		std::vector<ShedExpression> m_expressions;
 
 		std::vector<bool> m_spines; // usar with -s option
 		std::string m_grepoptions;
@@ -12231,6 +13389,7 @@ class Tool_thru : public HumTool {
 		bool     run               (HumdrumFile& infile);
 		bool     run               (const std::string& indata, std::ostream& out);
 		bool     run               (HumdrumFile& infile, std::ostream& out);
+		bool     isReusable        (void);
 
 	protected:
 		void      processFile         (HumdrumFile& infile);
@@ -12305,6 +13464,7 @@ class Tool_timebase : public HumTool {
 		bool  run                 (HumdrumFile& infile);
 		bool  run                 (const std::string& indata, std::ostream& out);
 		bool  run                 (HumdrumFile& infile, std::ostream& out);
+		bool  isReusable          (void);
 
 	protected:
 		void   processFile         (HumdrumFile& infile);
@@ -12329,6 +13489,7 @@ class Tool_transpose : public HumTool {
 		bool     run             (HumdrumFile& infile);
 		bool     run             (const std::string& indata, std::ostream& out);
 		bool     run             (HumdrumFile& infile, std::ostream& out);
+		bool     isReusable      (void);
 
 	protected:
 
@@ -12378,25 +13539,15 @@ class Tool_transpose : public HumTool {
 		void     doTrackKeyAnalysis     (std::vector<std::vector<double> >& analysis,
 		                                 int level, int hop, int count,
 		                                 std::vector<std::vector<double> >& trackhist,
-		                                 std::vector<double>& majorweights,
-		                                 std::vector<double>& minorweights);
+		                                 HumKeyWindow& keywindow);
 		void     identifyKeyDouble      (std::vector<double>& correls,
 		                                 std::vector<double>& histogram,
 		                                 std::vector<double>& majorweights,
 		                                 std::vector<double>& minorweights);
-		void     fillWeightsWithKostkaPayne(std::vector<double>& maj,
-		                                 std::vector<double>& min);
 		void     printRawTrackAnalysis  (std::vector<std::vector<std::vector<double> > >&
 		                                 analysis, std::vector<int>& ktracks);
-		void     doSingleAnalysis       (std::vector<double>& analysis,
-		                                 int startindex, int length,
-		                                 std::vector<std::vector<double> >& trackhist,
-		                                 std::vector<double>& majorweights,
-		                                 std::vector<double>& minorweights);
 		void     identifyKey            (std::vector<double>& correls,
-		                                 std::vector<double>& histogram,
-		                                 std::vector<double>& majorweights,
-		                                 std::vector<double>& minorweights);
+		                                 HumKeyWindow& keywindow);
 		void     doTranspositionAnalysis(std::vector<std::vector<std::vector<double> > >&
 		                                 analysis);
 		int      calculateTranspositionFromKey(int targetkey,
@@ -12526,21 +13677,25 @@ class Tool_tspos : public HumTool {
 		bool     run               (HumdrumFile& infile);
 		bool     run               (const std::string& indata, std::ostream& out);
 		bool     run               (HumdrumFile& infile, std::ostream& out);
+		void     finally           (void);
+		HumStatistics& getStatistics(void);
 
 	protected:
 		void             initialize        (HumdrumFile& infile);
 		void             processFile       (HumdrumFile& infile);
 		std::vector<int> getMidiNotes(std::vector<HTp>& kernNotes);
-		std::vector<int> getChordPositions(std::vector<int>& midiNotes);
-		std::vector<int> getNoteMods(std::vector<int>& midiNotes);
-		std::vector<int> getThirds(std::vector<int>& midiNotes);
-		std::vector<int> getFifths(std::vector<int>& midiNotes);
+		std::vector<int> getChordPositions(std::vector<int>& midiNotes, int pcmask);
+		std::vector<int> getThirds(std::vector<int>& midiNotes, int pcmask);
+		std::vector<int> getFifths(std::vector<int>& midiNotes, int pcmask);
 		void             labelChordPositions(std::vector<HTp>& kernNotes, std::vector<int>& chordPositions);
 		void             labelThirds(std::vector<HTp>& kernNotes, std::vector<int>& thirdPositions);
 		void             labelFifths(std::vector<HTp>& kernNotes, std::vector<int>& fifthPositions);
 		void             keepOnlyDoubles(std::vector<int>& output);
 		void             checkForTriadicSonority(std::vector<int>& positions, int line);
 		std::string      generateStatistics(HumdrumFile& infile);
+		void             countSonorities(HumdrumFile& infile, int& sonorityCount,
+		                                 int& triadCount, HumNum& triadDuration);
+		void             addStatistics(HumdrumFile& infile);
 		std::vector<std::string> getTrackNames(HumdrumFile& infile);
 		int              getVectorSum(std::vector<int>& input);
 		void             analyzeVoiceCount(HumdrumFile& infile);
@@ -12581,10 +13736,14 @@ class Tool_tspos : public HumTool {
 		bool m_topQ = false;         // used with --top option
 		bool m_tableQ = false;       // used with -t option
 		bool m_triadAttack = false;  // used with -x option
+		bool m_statsQ = false;       // used with --stats option
 
 		// Statistical data variables:
 		std::vector<bool> m_triadState;
 
+		// m_stats: counts of all files analyzed with --stats.
+		HumStatistics m_stats;
+
 		// m_partTriadPositions -- count the number of chordal positions by
 		// voice.  The first dimention is the track number of the part, and
 		// the second dimension is the counts for 7 categories:
@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Sat Aug  8 12:24:49 PDT 2015
-// Last Modified: Wed Aug 19 00:06:32 PDT 2015
+// Last Modified: Mon Oct 19 00:41:16 PDT 2026
 // Filename:      Convert-math.cpp
 // URL:           https://github.com/craigsapp/humlib/blob/master/src/Convert-math.cpp
 // Syntax:        C++11; humlib
@@ -11,6 +11,7 @@
 //
 
 #include "Convert.h"
+#include "HumThreadPool.h"
 
 #include <cmath>
 #include <cstdint>
@@ -177,6 +178,170 @@ double Convert::pearsonCorrelation(const vector<double>& x, const vector<double>
 
 
 
+//////////////////////////////
+//
+// Convert::prepareCorrelationSums -- Store running sums of x, y, x*x, y*y
+//     and x*y so that the Pearson correlation of any window of the two
+//     sequences can be calculated in constant time with windowCorrelation().
+//     sums[k][i] is the sum of the first i elements, so each list is one
+//     longer than the shorter input sequence.  The mean of each sequence
+//     is subtracted before summing to reduce rounding errors.
+//
+
+void Convert::prepareCorrelationSums(vector<vector<long double>>& sums,
+		const vector<double>& x, const vector<double>& y) {
+	int size = (int)x.size();
+	if ((int)y.size() < size) {
+		size = (int)y.size();
+	}
+
+	long double meanx = 0.0;
+	long double meany = 0.0;
+	for (int i=0; i<size; i++) {
+		meanx += x[i];
+		meany += y[i];
+	}
+	if (size > 0) {
+		meanx /= size;
+		meany /= size;
+	}
+
+	sums.resize(5);
+	for (int i=0; i<(int)sums.size(); i++) {
+		sums[i].resize(size + 1);
+		sums[i][0] = 0.0;
+	}
+	for (int i=0; i<size; i++) {
+		long double xi = x[i] - meanx;
+		long double yi = y[i] - meany;
+		sums[0][i+1] = sums[0][i] + xi;
+		sums[1][i+1] = sums[1][i] + yi;
+		sums[2][i+1] = sums[2][i] + xi * xi;
+		sums[3][i+1] = sums[3][i] + yi * yi;
+		sums[4][i+1] = sums[4][i] + xi * yi;
+	}
+}
+
+
+
+//////////////////////////////
+//
+// Convert::windowCorrelation -- Return the Pearson correlation of the
+//     window of the sequences given to prepareCorrelationSums() that starts
+//     at the given index.  A window where either sequence is flat returns
+//     NaN, like pearsonCorrelation().  Windows with very small variances
+//     compared to the running sums are not accurate, so give the input
+//     sequences as well when this is possible (see below).
+//
+
+double Convert::windowCorrelation(const vector<vector<long double>>& sums,
+		int start, int length) {
+	int end = start + length;
+	long double sx  = sums[0][end] - sums[0][start];
+	long double sy  = sums[1][end] - sums[1][start];
+	long double sxx = sums[2][end] - sums[2][start];
+	long double syy = sums[3][end] - sums[3][start];
+	long double sxy = sums[4][end] - sums[4][start];
+
+	long double varx = sxx - sx * sx / length;
+	long double vary = syy - sy * sy / length;
+	long double cov  = sxy - sx * sy / length;
+
+	// Variances at the level of rounding errors in the sums of squares
+	// of the window are for flat windows.
+	const long double tolerance = 1.0e-15;
+	if ((varx <= tolerance * sxx) || (vary <= tolerance * syy)) {
+		return std::nan("");
+	}
+
+	double output = (double)(cov / sqrtl(varx * vary));
+	if (output > 1.0) {
+		output = 1.0;
+	} else if (output < -1.0) {
+		output = -1.0;
+	}
+	return output;
+}
+
+
+//
+// Version which also is given the input sequences, so that windows which
+// cannot be calculated accurately from the running sums are calculated
+// directly with pearsonCorrelation().  The variance of a window is
+// calculated by subtracting running sums, so rounding errors are relative
+// to the size of the running sums rather than the size of the window
+// data.  Windows with a variance close to the rounding errors (such as
+// flat or nearly flat windows late in a long sequence) are recalculated.
+//
+
+double Convert::windowCorrelation(const vector<vector<long double>>& sums,
+		const vector<double>& x, const vector<double>& y, int start,
+		int length) {
+	int end = start + length;
+	long double sx  = sums[0][end] - sums[0][start];
+	long double sy  = sums[1][end] - sums[1][start];
+	long double varx = sums[2][end] - sums[2][start] - sx * sx / length;
+	long double vary = sums[3][end] - sums[3][start] - sy * sy / length;
+
+	auto scale = [&](int sum, int square) {
+		long double linear = fabsl(sums[sum][end]) + fabsl(sums[sum][start]);
+		return fabsl(sums[square][end]) + fabsl(sums[square][start]) +
+				linear * linear / length;
+	};
+
+	// Relative size of the window variance compared to the running sums
+	// below which rounding errors can be significant:
+	const long double tolerance = 1.0e-10;
+	if ((varx > tolerance * scale(0, 2)) && (vary > tolerance * scale(1, 3))) {
+		return windowCorrelation(sums, start, length);
+	}
+
+	vector<double> wx(x.begin() + start, x.begin() + end);
+	vector<double> wy(y.begin() + start, y.begin() + end);
+	double output = pearsonCorrelation(wx, wy);
+	if (output > 1.0) {
+		output = 1.0;
+	} else if (output < -1.0) {
+		output = -1.0;
+	}
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// Convert::correlationScape -- Calculate the Pearson correlation of
+//     every window of x and y that is at least two elements long.
+//     scape[i] contains the correlations for windows of length size-i,
+//     with scape[i][j] for the window starting at index j.  Rows are
+//     calculated in parallel if threads is not 1 (0 means to use all
+//     hardware threads).
+//
+
+void Convert::correlationScape(vector<vector<double>>& scape,
+		const vector<double>& x, const vector<double>& y, int threads) {
+	vector<vector<long double>> sums;
+	prepareCorrelationSums(sums, x, y);
+	int size = (int)sums[0].size() - 1;
+	scape.clear();
+	if (size < 2) {
+		return;
+	}
+	scape.resize(size - 1);
+
+	HumThreadPool pool(threads);
+	pool.run((int)scape.size(), [&](int i) {
+		int length = size - i;
+		scape[i].resize(i + 1);
+		for (int j=0; j<=i; j++) {
+			scape[i][j] = windowCorrelation(sums, x, y, j, length);
+		}
+	});
+}
+
+
+
 //////////////////////////////
 //
 // Convert::standardDeviation --
@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Sat Aug  8 12:24:49 PDT 2015
-// Last Modified: Sun Aug  9 21:03:12 PDT 2015
+// Last Modified: Sun Oct 18 18:52:10 PDT 2026
 // Filename:      HumAddress.cpp
 // URL:           https://github.com/craigsapp/humlib/blob/master/src/HumAddress.cpp
 // Syntax:        C++11; humlib
@@ -11,6 +11,7 @@
 //
 
 #include "HumAddress.h"
+#include "HumDataType.h"
 #include "HumdrumLine.h"
 
 using namespace std;
@@ -137,6 +138,21 @@ const HumdrumToken& HumAddress::getDataType(void) const {
 
 
 
+//////////////////////////////
+//
+// HumAddress::getDataTypeId -- Return the HumDataType ID of the exclusive
+//    interpretation of the token associated with the address.
+//
+
+int HumAddress::getDataTypeId(void) const {
+	if (m_owner == NULL) {
+		return datatype_unknown;
+	}
+	return m_owner->getTrackDataType(getTrack());
+}
+
+
+
 //////////////////////////////
 //
 // HumAddress::getExclusiveInterpretation -- Return the exclusive
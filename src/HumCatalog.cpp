@@ -0,0 +1,797 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 21:58:14 PDT 2026
+// Last Modified: Mon Oct 19 00:38:27 PDT 2026
+// Filename:      HumCatalog.cpp
+// URL:           https://github.com/craigsapp/humlib/blob/master/src/HumCatalog.cpp
+// Syntax:        C++11; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Catalog of the reference records and basic spine
+//                information of a corpus, made by reading only the
+//                header of each file (or !!!!SEGMENT), for selecting
+//                files before parsing them.
+//
+//                Catalog files start with the line "!!!!HUMCATALOG: N",
+//                where N is the number of entries, followed by one line
+//                for each field: the field name and then the value of
+//                the field for each entry, separated by tabs.  Tabs,
+//                newlines and backslashes in values are written as \t,
+//                \n and \\.
+//
+//                Example of selecting files from a catalog:
+//                   HumCatalog catalog;
+//                   catalog.readCatalog("catalog.txt");
+//                   vector<int> entries = catalog.query("COM^=Bach; voices>=4");
+//                   for (int i=0; i<(int)entries.size(); i++) {
+//                      HumdrumFile infile;
+//                      catalog.readEntry(entries[i], infile);
+//                   }
+//
+
+#include "HumCatalog.h"
+#include "Convert.h"
+#include "HumRegex.h"
+#include "HumdrumFileStream.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+
+namespace hum {
+
+// START_MERGE
+
+
+
+//////////////////////////////
+//
+// HumCatalog::HumCatalog -- Constructor.
+//
+
+HumCatalog::HumCatalog(void) {
+	clear();
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::~HumCatalog -- Deconstructor.
+//
+
+HumCatalog::~HumCatalog() {
+	// do nothing
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::clear -- Remove all entries.
+//
+
+void HumCatalog::clear(void) {
+	m_count = 0;
+	m_columns.clear();
+	m_numbers.clear();
+	m_columns["filename"].clear();
+	m_columns["segment"].clear();
+	m_columns["offset"].clear();
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::addFile -- Add the file (or each !!!!SEGMENT in the file)
+//     to the catalog.  Returns false if the file cannot be read.
+//
+
+bool HumCatalog::addFile(const string& filename) {
+	ifstream input(filename, std::ios::binary);
+	if (!input.is_open()) {
+		cerr << "Error: cannot read " << filename << endl;
+		return false;
+	}
+	return addStream(input, filename);
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::addStream -- Add the entries for the contents of a stream.
+//     Only the reference records and interpretations before the first
+//     data line or barline of each entry are examined, so reference
+//     records at the end of a file are not in the catalog.  Files that
+//     do not contain !!!!SEGMENT records are not read past the header.
+//     In files that do, the rest of each segment is only checked for
+//     the next !!!!SEGMENT record.  Universal reference records before
+//     the first segment are included in every segment (as in
+//     HumdrumFileStream).
+//
+
+bool HumCatalog::addStream(istream& input, const string& filename) {
+	HumRegex hre;
+	map<string, string> fields;
+	map<string, string> universals;
+	string segment;
+	string line;
+	int64_t offset = 0;  // offset of the current line in the stream
+	int64_t start = 0;   // offset of the current entry in the stream
+	bool segmentQ = false; // currently in a !!!!SEGMENT
+	bool contentQ = false; // found something other than universal records
+	bool spinesQ  = false; // found exclusive interpretations
+	bool doneQ    = false; // finished with the header of the entry
+
+	while (getline(input, line)) {
+		int64_t length = (int64_t)line.size() + 1;
+		if ((!line.empty()) && (line.back() == 0x0d)) {
+			line.pop_back();
+		}
+		if (line.compare(0, 11, "!!!!SEGMENT") == 0) {
+			if (segmentQ || contentQ) {
+				addEntry(filename, segment, start, fields);
+			}
+			segment = "";
+			if (hre.search(line, R"(^!!!!SEGMENT\s*([+-]?\d+)?\s*:\s*(.*?)\s*$)")) {
+				segment = hre.getMatch(2);
+			}
+			fields = universals;
+			start = offset;
+			segmentQ = true;
+			contentQ = true;
+			spinesQ = false;
+			doneQ = false;
+		} else if (!doneQ) {
+			if ((!segmentQ) && (!contentQ) && (line.compare(0, 4, "!!!!") == 0)) {
+				HumdrumLine hline(line);
+				if (hline.isUniversalReference()) {
+					string key = hline.getReferenceKey();
+					if (universals.find(key) == universals.end()) {
+						universals[key] = hline.getReferenceValue();
+					}
+				}
+			} else if (!line.empty()) {
+				contentQ = true;
+			}
+			scanHeaderLine(line, fields, spinesQ, doneQ);
+		} else if (!segmentQ) {
+			// The rest of a file without segments is not needed.
+			break;
+		}
+		offset += length;
+	}
+
+	if (segmentQ || contentQ) {
+		addEntry(filename, segment, start, fields);
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::scanHeaderLine -- Add the information in a line from the
+//     header of an entry to the fields of the entry.  Reference records
+//     are stored by their key, and the spine count, **kern spine count,
+//     and first meter, key signature and key designation are taken from
+//     the interpretations.  doneQ is set to true at the first data line,
+//     barline or spine terminator.
+//
+
+void HumCatalog::scanHeaderLine(const string& line, map<string, string>& fields,
+		bool& spinesQ, bool& doneQ) {
+	if (line.empty()) {
+		return;
+	}
+
+	if (line[0] == '!') {
+		if (line.compare(0, 3, "!!!") != 0) {
+			return;
+		}
+		HumdrumLine hline(line);
+		if (!hline.isReference()) {
+			return;
+		}
+		string key = hline.getReferenceKey();
+		if (key == "SEGMENT") {
+			return;
+		}
+		if (fields.find(key) == fields.end()) {
+			fields[key] = hline.getReferenceValue();
+		}
+		return;
+	}
+
+	if (line[0] != '*') {
+		// data line or barline
+		doneQ = true;
+		return;
+	}
+
+	vector<string> tokens;
+	size_t fieldstart = 0;
+	while (true) {
+		size_t tab = line.find('\t', fieldstart);
+		if (tab == string::npos) {
+			tokens.push_back(line.substr(fieldstart));
+			break;
+		}
+		if (tab > fieldstart) {
+			tokens.push_back(line.substr(fieldstart, tab - fieldstart));
+		}
+		fieldstart = tab + 1;
+	}
+
+	if (!spinesQ) {
+		if (line.compare(0, 2, "**") != 0) {
+			return;
+		}
+		spinesQ = true;
+		int voices = 0;
+		for (int i=0; i<(int)tokens.size(); i++) {
+			if (tokens[i] == "**kern") {
+				voices++;
+			}
+		}
+		fields["spines"] = to_string(tokens.size());
+		fields["voices"] = to_string(voices);
+		return;
+	}
+
+	for (int i=0; i<(int)tokens.size(); i++) {
+		const string& token = tokens[i];
+		if (token == "*-") {
+			doneQ = true;
+		} else if ((token.size() > 2) && (token[1] == 'M') && isdigit(token[2])) {
+			if (fields.find("meter") == fields.end()) {
+				fields["meter"] = token.substr(2);
+			}
+		} else if ((token.compare(0, 3, "*k[") == 0) && (token.back() == ']')) {
+			if (fields.find("keysig") == fields.end()) {
+				fields["keysig"] = token.substr(3, token.size() - 4);
+			}
+		} else if ((token.size() > 2) && (token.back() == ':') &&
+				(string("ABCDEFGabcdefg").find(token[1]) != string::npos) &&
+				(token.find_first_not_of("#-", 2) == token.size() - 1)) {
+			if (fields.find("key") == fields.end()) {
+				fields["key"] = token.substr(1, token.size() - 2);
+			}
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::addEntry -- Add an entry with the given fields.
+//
+
+void HumCatalog::addEntry(const string& filename, const string& segment,
+		int64_t offset, map<string, string>& fields) {
+	fields["filename"] = filename;
+	fields["segment"]  = segment;
+	fields["offset"]   = to_string(offset);
+	for (auto& it : fields) {
+		vector<string>& column = m_columns[it.first];
+		column.resize(m_count);
+		column.push_back(it.second);
+	}
+	m_count++;
+	for (auto& it : m_columns) {
+		it.second.resize(m_count);
+	}
+	m_numbers.clear();
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::writeCatalog -- Write the catalog to a file.  Returns
+//     false if the file cannot be written.
+//
+
+bool HumCatalog::writeCatalog(const string& filename) {
+	std::ofstream output(filename, std::ios::binary);
+	if (!output.is_open()) {
+		cerr << "Error: cannot write " << filename << endl;
+		return false;
+	}
+	printCatalog(output);
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::printCatalog -- Print the catalog in the format read by
+//     readCatalog().
+//
+
+ostream& HumCatalog::printCatalog(ostream& out) {
+	out << "!!!!HUMCATALOG: " << m_count << "\n";
+	for (auto& it : m_columns) {
+		out << it.first;
+		for (int i=0; i<(int)it.second.size(); i++) {
+			out << '\t' << escapeValue(it.second[i]);
+		}
+		out << "\n";
+	}
+	return out;
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::readCatalog -- Read a catalog that was written with
+//     writeCatalog().  Returns false if the catalog cannot be read.
+//
+
+bool HumCatalog::readCatalog(const string& filename) {
+	ifstream input(filename, std::ios::binary);
+	if (!input.is_open()) {
+		cerr << "Error: cannot read " << filename << endl;
+		return false;
+	}
+	return readCatalog(input);
+}
+
+
+bool HumCatalog::readCatalog(istream& input) {
+	clear();
+	string line;
+	if (!getline(input, line) || (line.compare(0, 15, "!!!!HUMCATALOG:") != 0)) {
+		cerr << "Error: input is not a catalog" << endl;
+		return false;
+	}
+	int count = atoi(line.c_str() + 15);
+	while (getline(input, line)) {
+		if (line.empty()) {
+			continue;
+		}
+		vector<string> values;
+		size_t fieldstart = line.find('\t');
+		string field = line.substr(0, fieldstart);
+		while (fieldstart != string::npos) {
+			size_t tab = line.find('\t', fieldstart + 1);
+			size_t length = tab == string::npos ? string::npos : tab - fieldstart - 1;
+			values.push_back(unescapeValue(line.substr(fieldstart + 1, length)));
+			fieldstart = tab;
+		}
+		if ((int)values.size() != count) {
+			cerr << "Error: field " << field << " has " << values.size()
+			     << " values instead of " << count << endl;
+			clear();
+			return false;
+		}
+		m_columns[field] = std::move(values);
+	}
+	m_count = count;
+	for (auto& it : m_columns) {
+		it.second.resize(m_count);
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::escapeValue -- Escape tabs, newlines and backslashes.
+//
+
+string HumCatalog::escapeValue(const string& value) {
+	if (value.find_first_of("\t\n\r\\") == string::npos) {
+		return value;
+	}
+	string output;
+	for (int i=0; i<(int)value.size(); i++) {
+		switch (value[i]) {
+			case '\t': output += "\\t";  break;
+			case '\n': output += "\\n";  break;
+			case '\r': output += "\\r";  break;
+			case '\\': output += "\\\\"; break;
+			default:   output += value[i];
+		}
+	}
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::unescapeValue -- Undo escapeValue().
+//
+
+string HumCatalog::unescapeValue(const string& value) {
+	if (value.find('\\') == string::npos) {
+		return value;
+	}
+	string output;
+	for (int i=0; i<(int)value.size(); i++) {
+		if ((value[i] != '\\') || (i == (int)value.size() - 1)) {
+			output += value[i];
+			continue;
+		}
+		i++;
+		switch (value[i]) {
+			case 't': output += '\t'; break;
+			case 'n': output += '\n'; break;
+			case 'r': output += '\r'; break;
+			default:  output += value[i];
+		}
+	}
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::getEntryCount -- Return the number of entries.
+//
+
+int HumCatalog::getEntryCount(void) const {
+	return m_count;
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::getFieldNames -- Return the names of the fields in the
+//     catalog.
+//
+
+vector<string> HumCatalog::getFieldNames(void) const {
+	vector<string> output;
+	for (auto& it : m_columns) {
+		output.push_back(it.first);
+	}
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::hasField -- Returns true if any entry has the field.
+//
+
+bool HumCatalog::hasField(const string& field) const {
+	return m_columns.find(field) != m_columns.end();
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::getValue -- Return the value of a field for an entry, or
+//     an empty string if the entry does not have the field.
+//
+
+const string& HumCatalog::getValue(int entry, const string& field) const {
+	static const string empty;
+	auto it = m_columns.find(field);
+	if ((it == m_columns.end()) || (entry < 0) || (entry >= m_count)) {
+		return empty;
+	}
+	return it->second[entry];
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::getFilename -- Return the file that contains an entry.
+//
+
+const string& HumCatalog::getFilename(int entry) const {
+	return getValue(entry, "filename");
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::getSegment -- Return the !!!!SEGMENT name of an entry, or
+//     an empty string if the file does not contain segments.
+//
+
+const string& HumCatalog::getSegment(int entry) const {
+	return getValue(entry, "segment");
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::getOffset -- Return the byte offset of an entry in its
+//     file (the position of its !!!!SEGMENT record).
+//
+
+int64_t HumCatalog::getOffset(int entry) const {
+	return strtoll(getValue(entry, "offset").c_str(), NULL, 10);
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::readEntry -- Read the Humdrum data of an entry, starting
+//     at its offset in the file and stopping at the next !!!!SEGMENT
+//     record.  Universal records before the first segment of the file
+//     are not included.  Returns false if the data cannot be read.
+//
+
+bool HumCatalog::readEntry(int entry, HumdrumFile& infile) {
+	const string& filename = getFilename(entry);
+	const string& segment = getSegment(entry);
+	ifstream input(filename, std::ios::binary);
+	if (!input.is_open()) {
+		cerr << "Error: cannot read " << filename << endl;
+		return false;
+	}
+	input.seekg(getOffset(entry));
+
+	stringstream contents;
+	string line;
+	bool firstQ = true;
+	while (getline(input, line)) {
+		// Always stop at the next segment, also for entries without a
+		// segment name (such as data before the first segment).
+		if ((!firstQ) && (line.compare(0, 11, "!!!!SEGMENT") == 0)) {
+			break;
+		}
+		contents << line << "\n";
+		firstQ = false;
+	}
+
+	HumdrumFileStream instream(contents.str());
+	if (!instream.read(infile)) {
+		return false;
+	}
+	if (infile.getFilename().empty()) {
+		infile.setFilename(segment.empty() ? filename : segment);
+	}
+	return infile.isValid();
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::getAllEntries -- Return the indexes of all entries.
+//
+
+vector<int> HumCatalog::getAllEntries(void) const {
+	vector<int> output(m_count);
+	for (int i=0; i<m_count; i++) {
+		output[i] = i;
+	}
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::findEqual -- Return the entries that have the given value
+//     for a field.
+//
+
+vector<int> HumCatalog::findEqual(const string& field, const string& value) const {
+	auto it = m_columns.find(field);
+	if (it == m_columns.end()) {
+		return value.empty() ? getAllEntries() : vector<int>();
+	}
+	vector<int> output;
+	const vector<string>& column = it->second;
+	for (int i=0; i<(int)column.size(); i++) {
+		if (column[i] == value) {
+			output.push_back(i);
+		}
+	}
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::findPrefix -- Return the entries whose value for a field
+//     starts with the given string.
+//
+
+vector<int> HumCatalog::findPrefix(const string& field, const string& prefix) const {
+	auto it = m_columns.find(field);
+	if (it == m_columns.end()) {
+		return prefix.empty() ? getAllEntries() : vector<int>();
+	}
+	vector<int> output;
+	const vector<string>& column = it->second;
+	for (int i=0; i<(int)column.size(); i++) {
+		if (column[i].compare(0, prefix.size(), prefix) == 0) {
+			output.push_back(i);
+		}
+	}
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::findRange -- Return the entries whose value for a field is
+//     a number between the minimum and maximum (inclusive).
+//
+
+vector<int> HumCatalog::findRange(const string& field, double minimum,
+		double maximum) {
+	vector<int> output;
+	if (!hasField(field)) {
+		return output;
+	}
+	const vector<double>& numbers = getNumbers(field);
+	for (int i=0; i<(int)numbers.size(); i++) {
+		if ((numbers[i] >= minimum) && (numbers[i] <= maximum)) {
+			output.push_back(i);
+		}
+	}
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::getNumbers -- Return the numeric values of a field, which
+//     are NAN for values that are not numbers.  The values are converted
+//     when a field is first used in a range query.
+//
+
+const vector<double>& HumCatalog::getNumbers(const string& field) {
+	auto found = m_numbers.find(field);
+	if (found != m_numbers.end()) {
+		return found->second;
+	}
+	vector<double>& numbers = m_numbers[field];
+	const vector<string>& column = m_columns[field];
+	numbers.resize(column.size());
+	for (int i=0; i<(int)column.size(); i++) {
+		const char* value = column[i].c_str();
+		char* end = NULL;
+		double number = strtod(value, &end);
+		while ((end != NULL) && isspace(*end)) {
+			end++;
+		}
+		if ((end == value) || (end == NULL) || (*end != '\0')) {
+			number = NAN;
+		}
+		numbers[i] = number;
+	}
+	return numbers;
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::query -- Return the entries that match all of the conditions
+//     in a query, separated by semicolons.  Conditions are a field name,
+//     an operator and a value:
+//        =   value is equal
+//        ^=  value starts with
+//        <, <=, >, >=   numeric comparisons
+//     Example: "COM^=Bach; voices>=4; meter=3/4"
+//
+
+vector<int> HumCatalog::query(const string& expression) {
+	vector<int> output = getAllEntries();
+	stringstream conditions(expression);
+	string condition;
+	while (getline(conditions, condition, ';')) {
+		condition = Convert::trimWhiteSpace(condition);
+		if (condition.empty()) {
+			continue;
+		}
+		output = intersect(output, queryCondition(condition));
+	}
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::queryCondition -- Return the entries that match a single
+//     condition of a query.
+//
+
+vector<int> HumCatalog::queryCondition(const string& condition) {
+	size_t index = condition.find_first_of("^=<>");
+	if (index == string::npos) {
+		cerr << "Error: no operator in query condition " << condition << endl;
+		return vector<int>();
+	}
+	string op = condition.substr(index, 1);
+	if ((index + 1 < condition.size()) && (condition[index + 1] == '=') &&
+			(op != "=")) {
+		op += '=';
+	}
+	string field = Convert::trimWhiteSpace(condition.substr(0, index));
+	string value = Convert::trimWhiteSpace(condition.substr(index + op.size()));
+
+	if (op == "=") {
+		return findEqual(field, value);
+	} else if (op == "^=") {
+		return findPrefix(field, value);
+	} else if (op == "^") {
+		cerr << "Error: use ^= for prefix queries in " << condition << endl;
+		return vector<int>();
+	}
+
+	char* end = NULL;
+	double number = strtod(value.c_str(), &end);
+	if ((end == value.c_str()) || (*end != '\0')) {
+		cerr << "Error: " << value << " is not a number in query condition "
+		     << condition << endl;
+		return vector<int>();
+	}
+	if (op == "<") {
+		return findRange(field, -INFINITY, nextafter(number, -INFINITY));
+	} else if (op == "<=") {
+		return findRange(field, -INFINITY, number);
+	} else if (op == ">") {
+		return findRange(field, nextafter(number, INFINITY), INFINITY);
+	} else {
+		return findRange(field, number, INFINITY);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumCatalog::intersect -- Return the entries that are in both sorted
+//     lists.
+//
+
+vector<int> HumCatalog::intersect(const vector<int>& a, const vector<int>& b) {
+	vector<int> output;
+	output.reserve(a.size() < b.size() ? a.size() : b.size());
+	int i = 0;
+	int j = 0;
+	while ((i < (int)a.size()) && (j < (int)b.size())) {
+		if (a[i] < b[j]) {
+			i++;
+		} else if (b[j] < a[i]) {
+			j++;
+		} else {
+			output.push_back(a[i]);
+			i++;
+			j++;
+		}
+	}
+	return output;
+}
+
+
+
+// END_MERGE
+
+} // end namespace hum
+
+
+
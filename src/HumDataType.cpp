@@ -0,0 +1,154 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 18:20:44 PDT 2026
+// Last Modified: Sun Oct 18 18:20:44 PDT 2026
+// Filename:      HumDataType.cpp
+// URL:           https://github.com/craigsapp/humlib/blob/master/src/HumDataType.cpp
+// Syntax:        C++11; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Registry of exclusive interpretations, so that data types
+//                can be stored and compared as small integers.
+//
+
+#include "HumDataType.h"
+
+using namespace std;
+
+namespace hum {
+
+// START_MERGE
+
+
+
+//////////////////////////////
+//
+// HumDataType::Registry::Registry -- Register the builtin data types
+//     in the order of the datatype_id enumeration.
+//
+
+HumDataType::Registry::Registry(void) {
+	addName("");
+	addName("**kern");
+	addName("**mens");
+	addName("**text");
+	addName("**recip");
+	addName("**dynam");
+}
+
+
+
+//////////////////////////////
+//
+// HumDataType::Registry::addName -- Add a new data type and return its ID.
+//     The mutex must be locked by the caller (except in the constructor).
+//
+
+int HumDataType::Registry::addName(const string& exinterp) {
+	int id = (int)names.size();
+	names.push_back(exinterp);
+	ids[exinterp] = id;
+	return id;
+}
+
+
+
+//////////////////////////////
+//
+// HumDataType::getRegistry -- Return the registry, which is created on
+//     first use.
+//
+
+HumDataType::Registry& HumDataType::getRegistry(void) {
+	static Registry registry;
+	return registry;
+}
+
+
+
+//////////////////////////////
+//
+// HumDataType::getId -- Return the ID for an exclusive interpretation,
+//     registering it if it has not been seen before.  The leading "**"
+//     is optional, and an empty string is datatype_unknown.
+//
+
+int HumDataType::getId(const string& exinterp) {
+	if (exinterp.empty()) {
+		return datatype_unknown;
+	}
+	if (exinterp.compare(0, 2, "**") != 0) {
+		return getId("**" + exinterp);
+	}
+	Registry& registry = getRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	auto it = registry.ids.find(exinterp);
+	if (it != registry.ids.end()) {
+		return it->second;
+	}
+	return registry.addName(exinterp);
+}
+
+
+
+//////////////////////////////
+//
+// HumDataType::findId -- Return the ID for an exclusive interpretation,
+//     or -1 if it has not been registered.  Use this instead of getId()
+//     for queries that should not add data types.
+//
+
+int HumDataType::findId(const string& exinterp) {
+	if (exinterp.empty()) {
+		return datatype_unknown;
+	}
+	if (exinterp.compare(0, 2, "**") != 0) {
+		return findId("**" + exinterp);
+	}
+	Registry& registry = getRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	auto it = registry.ids.find(exinterp);
+	if (it != registry.ids.end()) {
+		return it->second;
+	}
+	return -1;
+}
+
+
+
+//////////////////////////////
+//
+// HumDataType::getName -- Return the exclusive interpretation for an ID.
+//     Unknown IDs return an empty string.
+//
+
+const string& HumDataType::getName(int id) {
+	Registry& registry = getRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	if ((id < 0) || (id >= (int)registry.names.size())) {
+		return registry.names[datatype_unknown];
+	}
+	return registry.names[id];
+}
+
+
+
+//////////////////////////////
+//
+// HumDataType::getCount -- Return the number of registered data types.
+//
+
+int HumDataType::getCount(void) {
+	Registry& registry = getRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	return (int)registry.names.size();
+}
+
+
+
+// END_MERGE
+
+} // end namespace hum
+
+
+
@@ -0,0 +1,308 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 15:02:44 PDT 2026
+// Last Modified: Sun Oct 18 15:02:44 PDT 2026
+// Filename:      HumKeyWindow.cpp
+// URL:           https://github.com/craigsapp/humlib/blob/master/src/HumKeyWindow.cpp
+// Syntax:        C++11; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Key analysis of a sliding window of pitch-class histograms.
+//                The histogram of the window is updated by adding the
+//                segments entering the window and subtracting the ones
+//                leaving it, and the 24 key correlations are calculated
+//                with a single matrix-vector product.
+//
+
+#include "HumKeyWindow.h"
+
+#include <cmath>
+
+using namespace std;
+
+namespace hum {
+
+// START_MERGE
+
+
+
+//////////////////////////////
+//
+// HumKeyWindow::HumKeyWindow -- Uses Kostka-Payne key weights by default.
+//
+
+HumKeyWindow::HumKeyWindow(void) {
+	vector<double> major;
+	vector<double> minor;
+	getKostkaPayneWeights(major, minor);
+	setWeights(major, minor);
+	clear();
+}
+
+
+
+//////////////////////////////
+//
+// HumKeyWindow::setWeights -- Set the key profiles for C major and C minor.
+//     The Pearson correlation of a histogram with each rotated profile
+//     is the dot product of the normalized profile with the histogram
+//     divided by the deviation of the histogram, so the profiles are
+//     normalized here.
+//
+
+void HumKeyWindow::setWeights(const vector<double>& major,
+		const vector<double>& minor) {
+	for (int m=0; m<2; m++) {
+		const vector<double>& weights = m ? minor : major;
+		double mean = 0.0;
+		for (int i=0; i<12; i++) {
+			mean += weights[i];
+		}
+		mean /= 12.0;
+		double sum = 0.0;
+		for (int i=0; i<12; i++) {
+			sum += (weights[i] - mean) * (weights[i] - mean);
+		}
+		double norm = sqrt(sum);
+		for (int tonic=0; tonic<12; tonic++) {
+			for (int pc=0; pc<12; pc++) {
+				double value = weights[(pc - tonic + 12) % 12] - mean;
+				m_keyweights[m*12 + tonic][pc] = value / norm;
+			}
+		}
+	}
+}
+
+
+
+///////////////////////////////
+//
+// HumKeyWindow::getKostkaPayneWeights -- Key profiles for C major and
+//     C minor, found in David Temperley: Music and Probability 2006.
+//
+
+void HumKeyWindow::getKostkaPayneWeights(vector<double>& maj, vector<double>& min) {
+	maj.resize(12);
+	min.resize(12);
+
+	maj[0]  = 0.748;	// C major weights
+	maj[1]  = 0.060;	// C#
+	maj[2]  = 0.488;	// D
+	maj[3]  = 0.082;	// D#
+	maj[4]  = 0.670;	// E
+	maj[5]  = 0.460;	// F
+	maj[6]  = 0.096;	// F#
+	maj[7]  = 0.715;	// G
+	maj[8]  = 0.104;	// G#
+	maj[9]  = 0.366;	// A
+	maj[10] = 0.057;	// A#
+	maj[11] = 0.400;	// B
+	min[0]  = 0.712;	// c minor weights
+	min[1]  = 0.084;	// c#
+	min[2]  = 0.474;	// d
+	min[3]  = 0.618;	// d#
+	min[4]  = 0.049;	// e
+	min[5]  = 0.460;	// f
+	min[6]  = 0.105;	// f#
+	min[7]  = 0.747;	// g
+	min[8]  = 0.404;	// g#
+	min[9]  = 0.067;	// a
+	min[10] = 0.133;	// a#
+	min[11] = 0.330;	// b
+}
+
+
+
+//////////////////////////////
+//
+// HumKeyWindow::clear -- Empty the window.
+//
+
+void HumKeyWindow::clear(void) {
+	m_histogram.assign(12, 0.0);
+	m_active   = 0;
+	m_segments = NULL;
+	m_start    = 0;
+	m_end      = 0;
+}
+
+
+
+//////////////////////////////
+//
+// HumKeyWindow::addSegment -- Add a 12-element pitch-class histogram to
+//     the window.
+//
+
+void HumKeyWindow::addSegment(const vector<double>& histogram) {
+	bool active = false;
+	for (int i=0; i<12; i++) {
+		if (histogram[i] != 0.0) {
+			m_histogram[i] += histogram[i];
+			active = true;
+		}
+	}
+	if (active) {
+		m_active++;
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumKeyWindow::removeSegment -- Subtract a histogram that was added
+//     to the window.  Once no segments with notes are left, the histogram
+//     is reset so that rounding errors do not accumulate.
+//
+
+void HumKeyWindow::removeSegment(const vector<double>& histogram) {
+	bool active = false;
+	for (int i=0; i<12; i++) {
+		if (histogram[i] != 0.0) {
+			m_histogram[i] -= histogram[i];
+			active = true;
+		}
+	}
+	if (active) {
+		m_active--;
+	}
+	if (m_active <= 0) {
+		m_histogram.assign(12, 0.0);
+		m_active = 0;
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumKeyWindow::setWindow -- Move the window to the segments from start
+//     to start+length-1 (limited to the end of the list).  Segments that
+//     are already in the window from the previous call with the same list
+//     are not added again.  The segment list must not change between calls.
+//
+
+void HumKeyWindow::setWindow(const vector<vector<double>>& segments,
+		int start, int length) {
+	int end = start + length;
+	if (end > (int)segments.size()) {
+		end = (int)segments.size();
+	}
+	if (start < 0) {
+		start = 0;
+	}
+	if (end < start) {
+		end = start;
+	}
+
+	if ((m_segments != &segments) || (start >= m_end) || (end <= m_start)
+			|| (start < m_start) || (end < m_end)) {
+		// Not sliding forward through the same list, so start over:
+		clear();
+		for (int i=start; i<end; i++) {
+			addSegment(segments[i]);
+		}
+	} else {
+		for (int i=m_start; i<start; i++) {
+			removeSegment(segments[i]);
+		}
+		for (int i=m_end; i<end; i++) {
+			addSegment(segments[i]);
+		}
+	}
+	m_segments = &segments;
+	m_start    = start;
+	m_end      = end;
+}
+
+
+
+//////////////////////////////
+//
+// HumKeyWindow::getHistogram -- Return the pitch-class histogram of
+//     the window.
+//
+
+const vector<double>& HumKeyWindow::getHistogram(void) const {
+	return m_histogram;
+}
+
+
+
+//////////////////////////////
+//
+// HumKeyWindow::isEmpty -- Return true if the window contains no notes.
+//
+
+bool HumKeyWindow::isEmpty(void) const {
+	return m_active == 0;
+}
+
+
+
+//////////////////////////////
+//
+// HumKeyWindow::getCorrelations -- Return the Pearson correlations of the
+//     window's histogram with the 12 major key profiles (C to B), followed
+//     by the 12 minor key profiles.  If the histogram is flat, the
+//     correlations are NaN.
+//
+
+void HumKeyWindow::getCorrelations(vector<double>& correls) const {
+	double mean = 0.0;
+	for (int i=0; i<12; i++) {
+		mean += m_histogram[i];
+	}
+	mean /= 12.0;
+	double centered[12];
+	double sum = 0.0;
+	for (int i=0; i<12; i++) {
+		centered[i] = m_histogram[i] - mean;
+		sum += centered[i] * centered[i];
+	}
+	double scale = 1.0 / sqrt(sum);
+
+	correls.resize(24);
+	for (int k=0; k<24; k++) {
+		const double* weights = m_keyweights[k];
+		double dot = 0.0;
+		for (int i=0; i<12; i++) {
+			dot += weights[i] * centered[i];
+		}
+		correls[k] = dot * scale;
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumKeyWindow::getBestKey -- Return the index of the key with the highest
+//     correlation (0-11 for major keys, 12-23 for minor keys), or -1 if
+//     the window contains no notes.
+//
+
+int HumKeyWindow::getBestKey(void) const {
+	if (isEmpty()) {
+		return -1;
+	}
+	vector<double> correls;
+	getCorrelations(correls);
+	int output = 0;
+	for (int i=1; i<24; i++) {
+		if (correls[i] > correls[output]) {
+			output = i;
+		}
+	}
+	return output;
+}
+
+
+
+// END_MERGE
+
+} // end namespace hum
+
+
+
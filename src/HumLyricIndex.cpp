@@ -0,0 +1,504 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 22:44:19 PDT 2026
+// Last Modified: Sun Oct 18 22:44:19 PDT 2026
+// Filename:      HumLyricIndex.cpp
+// URL:           https://github.com/craigsapp/humlib/blob/master/src/HumLyricIndex.cpp
+// Syntax:        C++11; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Inverted index of the words in the **text (or **silbe)
+//                spines of a corpus, for searching lyrics without
+//                reconstructing the words from their syllables for
+//                every query.
+//
+//                Index files start with the line "!!!!HUMLYRICINDEX: N",
+//                where N is the number of words, followed by a line
+//                for each file ("file", then the filename) and a line
+//                for each word ("word", then the file index, track,
+//                line index and field index of the first syllable, and
+//                the word), separated by tabs.
+//
+//                Example of searching a corpus:
+//                   HumLyricIndex index;
+//                   index.readIndex("lyrics.txt");
+//                   vector<int> entries = index.findWildcard("glori*");
+//                   for (int i=0; i<(int)entries.size(); i++) {
+//                      const HumLyricEntry& entry = index.getEntry(entries[i]);
+//                      cout << index.getFilename(entry.file) << endl;
+//                   }
+//
+
+#include "HumLyricIndex.h"
+#include "HumdrumFileStream.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <regex>
+
+using namespace std;
+
+namespace hum {
+
+// START_MERGE
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::HumLyricIndex -- Constructor.
+//
+
+HumLyricIndex::HumLyricIndex(void) {
+	// do nothing
+}
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::~HumLyricIndex -- Deconstructor.
+//
+
+HumLyricIndex::~HumLyricIndex() {
+	// do nothing
+}
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::clear -- Remove all files and words.
+//
+
+void HumLyricIndex::clear(void) {
+	m_filenames.clear();
+	m_entries.clear();
+	m_words.clear();
+}
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::addFile -- Add the words of a file to the index.  The
+//     **silbe spines are used if there are any, otherwise the **text
+//     spines.  A syllable starting with "-" continues the previous word,
+//     and a trailing "-" is removed from each syllable.  Returns the index
+//     of the file in the index.  The filename version adds each segment
+//     of the file, and returns false if the file cannot be read.
+//
+
+int HumLyricIndex::addFile(HumdrumFile& infile) {
+	int file = (int)m_filenames.size();
+	m_filenames.push_back(infile.getFilename());
+	int startentry = (int)m_entries.size();
+
+	vector<HTp> textspines;
+	infile.getSpineStartList(textspines, "**silbe");
+	if (textspines.empty()) {
+		infile.getSpineStartList(textspines, "**text");
+	}
+	for (int i=0; i<(int)textspines.size(); i++) {
+		addWordsForSpine(file, textspines[i]);
+	}
+
+	indexEntries(startentry);
+	return file;
+}
+
+
+bool HumLyricIndex::addFile(const string& filename) {
+	ifstream input(filename, std::ios::binary);
+	if (!input.is_open()) {
+		cerr << "Error: cannot read " << filename << endl;
+		return false;
+	}
+	input.close();
+	vector<string> list(1, filename);
+	HumdrumFileStream instream(list);
+	HumdrumFile infile;
+	while (instream.read(infile)) {
+		addFile(infile);
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::addWordsForSpine -- Add the words in a text spine.
+//     A continuing syllable at the start of the spine is added to the
+//     last word of the previous spine (as in Tool_msearch).
+//
+
+void HumLyricIndex::addWordsForSpine(int file, HTp starttoken) {
+	int track = starttoken->getTrack();
+	bool hasword = (!m_entries.empty()) && (m_entries.back().file == file);
+	HTp tok = starttoken->getNextToken();
+	while (tok != NULL) {
+		if (tok->empty() || tok->isNull() || !tok->isData()) {
+			tok = tok->getNextToken();
+			continue;
+		}
+		if (tok->at(0) == '-') {
+			// append a syllable to the end of previous word
+			if (hasword) {
+				string& word = m_entries.back().word;
+				word += tok->substr(1, string::npos);
+				if ((!word.empty()) && (word.back() == '-')) {
+					word.pop_back();
+				}
+			}
+		} else {
+			// start a new word
+			m_entries.emplace_back();
+			HumLyricEntry& entry = m_entries.back();
+			entry.file  = file;
+			entry.track = track;
+			entry.line  = tok->getLineIndex();
+			entry.field = tok->getFieldIndex();
+			entry.word  = *tok;
+			if (entry.word.back() == '-') {
+				entry.word.pop_back();
+			}
+			hasword = true;
+		}
+		tok = tok->getNextToken();
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::indexEntries -- Add the entries from startentry to the
+//     end of the entry list to the word index.
+//
+
+void HumLyricIndex::indexEntries(int startentry) {
+	for (int i=startentry; i<(int)m_entries.size(); i++) {
+		m_words[foldCase(m_entries[i].word)].push_back(i);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::writeIndex -- Write the index to a file.  Returns
+//     false if the file cannot be written.
+//
+
+bool HumLyricIndex::writeIndex(const string& filename) {
+	std::ofstream output(filename, std::ios::binary);
+	if (!output.is_open()) {
+		cerr << "Error: cannot write " << filename << endl;
+		return false;
+	}
+	printIndex(output);
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::printIndex -- Print the index in the format read by
+//     readIndex().
+//
+
+ostream& HumLyricIndex::printIndex(ostream& out) {
+	out << "!!!!HUMLYRICINDEX: " << m_entries.size() << "\n";
+	for (int i=0; i<(int)m_filenames.size(); i++) {
+		out << "file\t" << m_filenames[i] << "\n";
+	}
+	for (int i=0; i<(int)m_entries.size(); i++) {
+		const HumLyricEntry& entry = m_entries[i];
+		out << "word\t" << entry.file << '\t' << entry.track << '\t'
+		    << entry.line << '\t' << entry.field << '\t' << entry.word << "\n";
+	}
+	return out;
+}
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::readIndex -- Read an index that was written with
+//     writeIndex().  Returns false if the index cannot be read.
+//
+
+bool HumLyricIndex::readIndex(const string& filename) {
+	ifstream input(filename, std::ios::binary);
+	if (!input.is_open()) {
+		cerr << "Error: cannot read " << filename << endl;
+		return false;
+	}
+	return readIndex(input);
+}
+
+
+bool HumLyricIndex::readIndex(istream& input) {
+	clear();
+	string line;
+	if (!getline(input, line) || (line.compare(0, 18, "!!!!HUMLYRICINDEX:") != 0)) {
+		cerr << "Error: input is not a lyric index" << endl;
+		return false;
+	}
+	m_entries.reserve(atoi(line.c_str() + 18));
+	while (getline(input, line)) {
+		if (line.compare(0, 5, "file\t") == 0) {
+			m_filenames.push_back(line.substr(5));
+			continue;
+		}
+		if (line.compare(0, 5, "word\t") != 0) {
+			continue;
+		}
+		HumLyricEntry entry;
+		const char* ptr = line.c_str() + 5;
+		char* end;
+		entry.file  = (int)strtol(ptr, &end, 10); ptr = end;
+		entry.track = (int)strtol(ptr, &end, 10); ptr = end;
+		entry.line  = (int)strtol(ptr, &end, 10); ptr = end;
+		entry.field = (int)strtol(ptr, &end, 10); ptr = end;
+		if ((*ptr != '\t') || (entry.file < 0) ||
+				(entry.file >= (int)m_filenames.size())) {
+			cerr << "Error: invalid lyric index line: " << line << endl;
+			clear();
+			return false;
+		}
+		entry.word = ptr + 1;
+		m_entries.push_back(std::move(entry));
+	}
+	indexEntries(0);
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::getEntryCount -- Return the number of words.
+//
+
+int HumLyricIndex::getEntryCount(void) const {
+	return (int)m_entries.size();
+}
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::getFileCount -- Return the number of files.
+//
+
+int HumLyricIndex::getFileCount(void) const {
+	return (int)m_filenames.size();
+}
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::getFilename -- Return the filename of a file.
+//
+
+const string& HumLyricIndex::getFilename(int file) const {
+	return m_filenames.at(file);
+}
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::getEntry -- Return a word and its location.
+//
+
+const HumLyricEntry& HumLyricIndex::getEntry(int entry) const {
+	return m_entries.at(entry);
+}
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::getNextEntry -- Return the next word of the same file,
+//     which ends the syllables of the given word, or -1 if the given
+//     word is the last one in the file.
+//
+
+int HumLyricIndex::getNextEntry(int entry) const {
+	if (entry + 1 >= (int)m_entries.size()) {
+		return -1;
+	}
+	if (m_entries[entry + 1].file != m_entries[entry].file) {
+		return -1;
+	}
+	return entry + 1;
+}
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::getToken -- Return the first syllable of a word in the
+//     file that the word was indexed from, or NULL if the location is not
+//     in the file.
+//
+
+HTp HumLyricIndex::getToken(int entry, HumdrumFile& infile) const {
+	const HumLyricEntry& item = m_entries.at(entry);
+	if ((item.line < 0) || (item.line >= infile.getLineCount())) {
+		return NULL;
+	}
+	if ((item.field < 0) || (item.field >= infile[item.line].getFieldCount())) {
+		return NULL;
+	}
+	return infile.token(item.line, item.field);
+}
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::findWord -- Return the entries of a word.
+//
+
+vector<int> HumLyricIndex::findWord(const string& word) const {
+	auto it = m_words.find(foldCase(word));
+	if (it == m_words.end()) {
+		return vector<int>();
+	}
+	return it->second;
+}
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::findPrefix -- Return the entries of words starting
+//     with the given string.
+//
+
+vector<int> HumLyricIndex::findPrefix(const string& prefix) const {
+	string folded = foldCase(prefix);
+	vector<int> output;
+	for (auto it = m_words.lower_bound(folded); it != m_words.end(); it++) {
+		if (it->first.compare(0, folded.size(), folded) != 0) {
+			break;
+		}
+		output.insert(output.end(), it->second.begin(), it->second.end());
+	}
+	std::sort(output.begin(), output.end());
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::findWildcard -- Return the entries of words matching a
+//     pattern, where "*" matches any number of characters and "?" matches
+//     a single character.  Only the words starting with the text before
+//     the first wildcard are checked.
+//
+
+vector<int> HumLyricIndex::findWildcard(const string& pattern) const {
+	string folded = foldCase(pattern);
+	size_t wildcard = folded.find_first_of("*?");
+	if (wildcard == string::npos) {
+		return findWord(folded);
+	}
+	string prefix = folded.substr(0, wildcard);
+	vector<int> output;
+	for (auto it = m_words.lower_bound(prefix); it != m_words.end(); it++) {
+		if (it->first.compare(0, prefix.size(), prefix) != 0) {
+			break;
+		}
+		if (wildcardMatch(folded.c_str(), it->first.c_str())) {
+			output.insert(output.end(), it->second.begin(), it->second.end());
+		}
+	}
+	std::sort(output.begin(), output.end());
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::findRegex -- Return the entries of words containing
+//     a match to a regular expression.  The expression is compiled once
+//     and checked once for each distinct word.
+//
+
+vector<int> HumLyricIndex::findRegex(const string& exp) const {
+	regex re(exp, regex::ECMAScript | regex::icase);
+	vector<int> output;
+	for (auto& it : m_words) {
+		if (regex_search(it.first, re)) {
+			output.insert(output.end(), it.second.begin(), it.second.end());
+		}
+	}
+	std::sort(output.begin(), output.end());
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::foldCase -- Convert ASCII letters to lower case.
+//
+
+string HumLyricIndex::foldCase(const string& input) {
+	string output = input;
+	for (int i=0; i<(int)output.size(); i++) {
+		output[i] = tolower((unsigned char)output[i]);
+	}
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumLyricIndex::wildcardMatch -- Return true if the text matches the
+//     pattern, where "*" matches any number of characters and "?" matches
+//     a single character.
+//
+
+bool HumLyricIndex::wildcardMatch(const char* pattern, const char* text) {
+	const char* star = NULL;   // position of the last "*" in the pattern
+	const char* retry = NULL;  // position in the text to retry after a "*"
+	while (*text) {
+		if ((*pattern == '?') || (*pattern == *text)) {
+			pattern++;
+			text++;
+		} else if (*pattern == '*') {
+			star = pattern++;
+			retry = text;
+		} else if (star) {
+			pattern = star + 1;
+			text = ++retry;
+		} else {
+			return false;
+		}
+	}
+	while (*pattern == '*') {
+		pattern++;
+	}
+	return *pattern == '\0';
+}
+
+
+
+// END_MERGE
+
+} // end namespace hum
+
+
+
@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Sat Aug  8 12:24:49 PDT 2015
-// Last Modified: Sun Aug  9 21:03:12 PDT 2015
+// Last Modified: Sun Oct 18 19:24:37 PDT 2026
 // Filename:      HumNum.cpp
 // URL:           https://github.com/craigsapp/humlib/blob/master/src/HumNum.cpp
 // Syntax:        C++11; humlib
@@ -12,10 +12,14 @@
 //                number formed from two ints.  The fractional
 //                number will be kept in reduced for, such as
 //                the number 3/6 which can be simplified to 1/2.
+//                HumNum64 is a 64-bit version with overflow checking.
 //
 
 #include "HumNum.h"
 
+#include <climits>
+#include <cstdint>
+
 using namespace std;
 
 namespace hum {
@@ -913,6 +917,501 @@ ostream& operator<<(ostream& out, const HumNum& number) {
 }
 
 
+
+ostream& operator<<(ostream& out, const HumNum64& number) {
+	number.printFraction(out);
+	return out;
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::HumNum64 -- HumNum64 Constructor.  Set the default value
+//   of the number to zero, or the given number if specified.
+//
+
+HumNum64::HumNum64(void) {
+	top = 0;
+	bot = 1;
+}
+
+
+HumNum64::HumNum64(int64_t value) {
+	top = value;
+	bot = 1;
+}
+
+
+HumNum64::HumNum64(int64_t numerator, int64_t denominator) {
+	setValue(numerator, denominator);
+}
+
+
+HumNum64::HumNum64(const HumNum& value) {
+	if (value.isNaN() || value.isInfinite()) {
+		top = 0;
+		bot = 0;
+	} else {
+		setValue(value.getNumerator(), value.getDenominator());
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::setValue -- Set the number from a numerator and denominator.
+//    The fraction is reduced and the sign is kept in the numerator.  A zero
+//    denominator gives NaN (infinity is not represented).
+//
+
+void HumNum64::setValue(int64_t numerator, int64_t denominator) {
+	if ((denominator == 0) || ((denominator < 0) &&
+			((numerator == INT64_MIN) || (denominator == INT64_MIN)))) {
+		top = 0;
+		bot = 0;
+		return;
+	}
+	if (denominator < 0) {
+		numerator = -numerator;
+		denominator = -denominator;
+	}
+	int64_t gcdval = gcd(numerator, denominator);
+	if (gcdval > 1) {
+		numerator /= gcdval;
+		denominator /= gcdval;
+	}
+	top = numerator;
+	bot = denominator;
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::isNaN -- Returns true if the number is not valid, which
+//     happens when a calculation overflows or divides by zero.
+//
+
+bool HumNum64::isNaN(void) const {
+	return bot == 0;
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::isNegative -- Returns true if value is negative.
+//
+
+bool HumNum64::isNegative(void) const {
+	return (bot != 0) && (top < 0);
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::isPositive -- Returns true if value is positive.
+//
+
+bool HumNum64::isPositive(void) const {
+	return (bot != 0) && (top > 0);
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::isZero -- Returns true if value is zero.
+//
+
+bool HumNum64::isZero(void) const {
+	return (bot != 0) && (top == 0);
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::isInteger -- Returns true if the denominator is 1.
+//
+
+bool HumNum64::isInteger(void) const {
+	return bot == 1;
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::getFloat -- Returns the floating-point equivalent of the
+//     rational number.
+//
+
+double HumNum64::getFloat(void) const {
+	return (double)top / (double)bot;
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::getHumNum -- Convert to a HumNum.  Returns false if the
+//     number is NaN or does not fit into a HumNum.
+//
+
+bool HumNum64::getHumNum(HumNum& output) const {
+	if (isNaN() || (top > INT_MAX) || (top < INT_MIN) || (bot > INT_MAX)) {
+		return false;
+	}
+	output.setValue((int)top, (int)bot);
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::getTicks -- Return the number as an integer count of ticks
+//     at the given number of ticks per unit (such as ticks per quarter
+//     note for durations).  Returns false if the number is NaN, is not
+//     an integer number of ticks, or if the tick count overflows.
+//
+
+bool HumNum64::getTicks(int64_t tpq, int64_t& ticks) const {
+	if (isNaN() || (tpq <= 0) || (tpq % bot != 0)) {
+		return false;
+	}
+	return multiply(top, tpq / bot, ticks);
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::operator+ -- Addition operator.
+//
+
+HumNum64 HumNum64::operator+(const HumNum64& value) const {
+	HumNum64 output;
+	output.top = 0;
+	output.bot = 0;
+	if (isNaN() || value.isNaN()) {
+		return output;
+	}
+	int64_t gcdval = gcd(bot, value.bot);
+	int64_t denominator;
+	int64_t a;
+	int64_t b;
+	int64_t numerator;
+	if (!multiply(bot / gcdval, value.bot, denominator)) {
+		return output;
+	}
+	if (!multiply(top, denominator / bot, a)) {
+		return output;
+	}
+	if (!multiply(value.top, denominator / value.bot, b)) {
+		return output;
+	}
+	if (!add(a, b, numerator)) {
+		return output;
+	}
+	output.setValue(numerator, denominator);
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::operator- -- Subtraction and negation operators.
+//
+
+HumNum64 HumNum64::operator-(const HumNum64& value) const {
+	return *this + (-value);
+}
+
+
+HumNum64 HumNum64::operator-(void) const {
+	HumNum64 output;
+	if (isNaN() || (top == INT64_MIN)) {
+		output.bot = 0;
+	} else {
+		output.top = -top;
+		output.bot = bot;
+	}
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::operator* -- Multiplication operator.  Common factors
+//    are removed before multiplying to avoid unnecessary overflows.
+//
+
+HumNum64 HumNum64::operator*(const HumNum64& value) const {
+	HumNum64 output;
+	output.bot = 0;
+	if (isNaN() || value.isNaN()) {
+		return output;
+	}
+	int64_t gcd1 = gcd(top, value.bot);
+	int64_t gcd2 = gcd(value.top, bot);
+	if (gcd1 == 0) {
+		gcd1 = 1;
+	}
+	if (gcd2 == 0) {
+		gcd2 = 1;
+	}
+	int64_t numerator;
+	int64_t denominator;
+	if (!multiply(top / gcd1, value.top / gcd2, numerator)) {
+		return output;
+	}
+	if (!multiply(bot / gcd2, value.bot / gcd1, denominator)) {
+		return output;
+	}
+	output.setValue(numerator, denominator);
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::operator/ -- Division operator.  Division by zero gives NaN.
+//
+
+HumNum64 HumNum64::operator/(const HumNum64& value) const {
+	HumNum64 inverse(value.bot, value.top);
+	if (value.isNaN()) {
+		inverse.bot = 0;
+	}
+	return *this * inverse;
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::operator+= -- Arithmetic assignment operators.
+//
+
+HumNum64& HumNum64::operator+=(const HumNum64& value) {
+	*this = *this + value;
+	return *this;
+}
+
+
+HumNum64& HumNum64::operator-=(const HumNum64& value) {
+	*this = *this - value;
+	return *this;
+}
+
+
+HumNum64& HumNum64::operator*=(const HumNum64& value) {
+	*this = *this * value;
+	return *this;
+}
+
+
+HumNum64& HumNum64::operator/=(const HumNum64& value) {
+	*this = *this / value;
+	return *this;
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::compare -- Returns -1 if the number is less than the given
+//     value, 0 if equal, and +1 if greater.  The comparison is exact unless
+//     the cross products overflow, in which case long doubles are compared.
+//     Neither number can be NaN.
+//
+
+int HumNum64::compare(const HumNum64& value) const {
+	int64_t a;
+	int64_t b;
+	if (multiply(top, value.bot, a) && multiply(value.top, bot, b)) {
+		return (a < b) ? -1 : ((a > b) ? +1 : 0);
+	}
+	long double x = (long double)top / (long double)bot;
+	long double y = (long double)value.top / (long double)value.bot;
+	return (x < y) ? -1 : ((x > y) ? +1 : 0);
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::operator== -- Comparison operators.  Comparisons with NaN
+//    are false, except for !=.
+//
+
+bool HumNum64::operator==(const HumNum64& value) const {
+	if (isNaN() || value.isNaN()) {
+		return false;
+	}
+	return (top == value.top) && (bot == value.bot);
+}
+
+
+bool HumNum64::operator!=(const HumNum64& value) const {
+	return !(*this == value);
+}
+
+
+bool HumNum64::operator<(const HumNum64& value) const {
+	if (isNaN() || value.isNaN()) {
+		return false;
+	}
+	return compare(value) < 0;
+}
+
+
+bool HumNum64::operator<=(const HumNum64& value) const {
+	if (isNaN() || value.isNaN()) {
+		return false;
+	}
+	return compare(value) <= 0;
+}
+
+
+bool HumNum64::operator>(const HumNum64& value) const {
+	if (isNaN() || value.isNaN()) {
+		return false;
+	}
+	return compare(value) > 0;
+}
+
+
+bool HumNum64::operator>=(const HumNum64& value) const {
+	if (isNaN() || value.isNaN()) {
+		return false;
+	}
+	return compare(value) >= 0;
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::printFraction -- Print as a fraction, such as 3/2.  If the
+//    number is an integer, then do not print the denominator.
+//
+
+ostream& HumNum64::printFraction(ostream& out) const {
+	if (isInteger()) {
+		out << top;
+	} else {
+		out << top << '/' << bot;
+	}
+	return out;
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::add -- Add two integers.  Returns false if the sum overflows.
+//
+
+bool HumNum64::add(int64_t a, int64_t b, int64_t& output) {
+	if (((b > 0) && (a > INT64_MAX - b)) || ((b < 0) && (a < INT64_MIN - b))) {
+		return false;
+	}
+	output = a + b;
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::subtract -- Subtract two integers.  Returns false if the
+//     difference overflows.
+//
+
+bool HumNum64::subtract(int64_t a, int64_t b, int64_t& output) {
+	if (((b < 0) && (a > INT64_MAX + b)) || ((b > 0) && (a < INT64_MIN + b))) {
+		return false;
+	}
+	output = a - b;
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::multiply -- Multiply two integers.  Returns false if the
+//     product overflows.
+//
+
+bool HumNum64::multiply(int64_t a, int64_t b, int64_t& output) {
+	if (a > 0) {
+		if (b > 0) {
+			if (a > INT64_MAX / b) {
+				return false;
+			}
+		} else if (b < INT64_MIN / a) {
+			return false;
+		}
+	} else if (a < 0) {
+		if (b > 0) {
+			if (a < INT64_MIN / b) {
+				return false;
+			}
+		} else if ((b < 0) && (b < INT64_MAX / a)) {
+			return false;
+		}
+	}
+	output = a * b;
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::lcm -- Least common multiple of two positive integers.
+//     Returns false if the result overflows.
+//
+
+bool HumNum64::lcm(int64_t a, int64_t b, int64_t& output) {
+	int64_t gcdval = gcd(a, b);
+	if (gcdval == 0) {
+		output = 0;
+		return true;
+	}
+	return multiply(a / gcdval, b, output);
+}
+
+
+
+//////////////////////////////
+//
+// HumNum64::gcd -- Greatest common divisor (always non-negative).
+//
+
+int64_t HumNum64::gcd(int64_t a, int64_t b) {
+	uint64_t x = a < 0 ? 0 - (uint64_t)a : (uint64_t)a;
+	uint64_t y = b < 0 ? 0 - (uint64_t)b : (uint64_t)b;
+	uint64_t c;
+	while (y) {
+		c = x % y;
+		x = y;
+		y = c;
+	}
+	return x > (uint64_t)INT64_MAX ? 1 : (int64_t)x;
+}
+
+
 // END_MERGE
 
 } // end namespace hum
@@ -0,0 +1,462 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 17:42:19 PDT 2026
+// Last Modified: Sun Oct 18 17:42:19 PDT 2026
+// Filename:      HumSonority.cpp
+// URL:           https://github.com/craigsapp/humlib/blob/master/src/HumSonority.cpp
+// Syntax:        C++11; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Pitch-class set of a sonority stored as bitmasks, with
+//                chord classification by table lookup.
+//
+
+#include "HumSonority.h"
+
+#include <cstdlib>
+
+using namespace std;
+
+namespace hum {
+
+// START_MERGE
+
+
+
+//////////////////////////////
+//
+// HumSonority::clear -- Remove all pitches and the bass.
+//
+
+void HumSonority::clear(void) {
+	m_pcmask  = 0;
+	m_b7mask  = 0;
+	m_b40mask = 0;
+	m_bass    = -1;
+}
+
+
+
+//////////////////////////////
+//
+// HumSonority::isEmpty -- Return true if no pitches have been added.
+//
+
+bool HumSonority::isEmpty(void) const {
+	return (m_pcmask == 0) && (m_b7mask == 0) && (m_b40mask == 0);
+}
+
+
+
+//////////////////////////////
+//
+// HumSonority::addMidi -- Add the pitch class of a MIDI note number.
+//     Negative numbers (sustained notes) are treated as positive, and
+//     0 (rest) is ignored.
+//
+
+void HumSonority::addMidi(int midi) {
+	midi = abs(midi);
+	if (midi == 0) {
+		return;
+	}
+	m_pcmask |= 1 << (midi % 12);
+}
+
+
+
+//////////////////////////////
+//
+// HumSonority::addDiatonic -- Add the pitch class of a base-7 pitch.
+//     Negative values (rests) are ignored.
+//
+
+void HumSonority::addDiatonic(int base7) {
+	if (base7 < 0) {
+		return;
+	}
+	m_b7mask |= 1 << (base7 % 7);
+}
+
+
+
+//////////////////////////////
+//
+// HumSonority::addBase40 -- Add the pitch class of a base-40 pitch.
+//     Negative values (rests) are ignored.
+//
+
+void HumSonority::addBase40(int base40) {
+	if (base40 < 0) {
+		return;
+	}
+	m_b40mask |= (uint64_t)1 << (base40 % 40);
+}
+
+
+
+//////////////////////////////
+//
+// HumSonority::setBass -- Set the bass pitch class from a MIDI note number.
+//
+
+void HumSonority::setBass(int midi) {
+	midi = abs(midi);
+	if (midi == 0) {
+		m_bass = -1;
+	} else {
+		m_bass = midi % 12;
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumSonority::hasPitchClass -- Return true if the 12-tone pitch class
+//     is present.
+//
+
+bool HumSonority::hasPitchClass(int pc) const {
+	if (pc < 0) {
+		return false;
+	}
+	return (m_pcmask >> (pc % 12)) & 1;
+}
+
+
+
+//////////////////////////////
+//
+// HumSonority::hasDiatonic -- Return true if the diatonic pitch class of
+//     the base-7 pitch is present.
+//
+
+bool HumSonority::hasDiatonic(int base7) const {
+	if (base7 < 0) {
+		return false;
+	}
+	return (m_b7mask >> (base7 % 7)) & 1;
+}
+
+
+
+//////////////////////////////
+//
+// HumSonority::hasBase40 -- Return true if the pitch class of the base-40
+//     pitch is present.
+//
+
+bool HumSonority::hasBase40(int base40) const {
+	if (base40 < 0) {
+		return false;
+	}
+	return (m_b40mask >> (base40 % 40)) & 1;
+}
+
+
+
+//////////////////////////////
+//
+// HumSonority::getPitchClassCount -- Return the number of distinct
+//     12-tone pitch classes.
+//
+
+int HumSonority::getPitchClassCount(void) const {
+	return countBits(m_pcmask);
+}
+
+
+
+//////////////////////////////
+//
+// HumSonority::getType -- Return the chord type of the 12-tone pitch-class
+//     set (see sonority_type in HumSonority.h).
+//
+
+int HumSonority::getType(void) const {
+	return getType(m_pcmask);
+}
+
+
+int HumSonority::getType(int pcmask) {
+	return getChordEntry(pcmask) & 0xf;
+}
+
+
+
+//////////////////////////////
+//
+// HumSonority::getRoot -- Return the pitch class of the root, or -1 if
+//     there is no root.  For dyads, the root is the lower note of the
+//     third or fifth (of the tritone when written as a diminished fifth).
+//     For augmented triads, the root is the lowest pitch class counting
+//     from C.
+//
+
+int HumSonority::getRoot(void) const {
+	return getRoot(m_pcmask);
+}
+
+
+int HumSonority::getRoot(int pcmask) {
+	return (int)((getChordEntry(pcmask) >> 4) & 0xf) - 1;
+}
+
+
+
+//////////////////////////////
+//
+// HumSonority::getThird -- Return the pitch class of the third above the
+//     root, or -1 if there is none.
+//
+
+int HumSonority::getThird(void) const {
+	return getThird(m_pcmask);
+}
+
+
+int HumSonority::getThird(int pcmask) {
+	return (int)((getChordEntry(pcmask) >> 8) & 0xf) - 1;
+}
+
+
+
+//////////////////////////////
+//
+// HumSonority::getFifth -- Return the pitch class of the fifth above the
+//     root, or -1 if there is none.
+//
+
+int HumSonority::getFifth(void) const {
+	return getFifth(m_pcmask);
+}
+
+
+int HumSonority::getFifth(int pcmask) {
+	return (int)((getChordEntry(pcmask) >> 12) & 0xf) - 1;
+}
+
+
+
+//////////////////////////////
+//
+// HumSonority::getPosition -- Return the chord position of a MIDI note
+//     in the sonority: 1 = root, 3 = third, 5 = fifth, 0 = other.
+//
+
+int HumSonority::getPosition(int midi) const {
+	return getPosition(m_pcmask, midi);
+}
+
+
+int HumSonority::getPosition(int pcmask, int midi) {
+	int pc = abs(midi) % 12;
+	uint32_t entry = getChordEntry(pcmask);
+	if (pc == (int)((entry >> 4) & 0xf) - 1) {
+		return 1;
+	} else if (pc == (int)((entry >> 8) & 0xf) - 1) {
+		return 3;
+	} else if (pc == (int)((entry >> 12) & 0xf) - 1) {
+		return 5;
+	}
+	return 0;
+}
+
+
+
+//////////////////////////////
+//
+// HumSonority::getInversion -- Return the inversion of a triad from the
+//     bass: 0 = root position, 1 = first inversion, 2 = second inversion.
+//     Returns -1 if the sonority is not a triad or there is no bass.
+//
+
+int HumSonority::getInversion(void) const {
+	if ((m_bass < 0) || !isTriad(getType())) {
+		return -1;
+	}
+	if (m_bass == getThird()) {
+		return 1;
+	} else if (m_bass == getFifth()) {
+		return 2;
+	}
+	return 0;
+}
+
+
+
+//////////////////////////////
+//
+// HumSonority::isTriad -- Return true if the chord type is a major,
+//     minor, diminished or augmented triad.
+//
+
+bool HumSonority::isTriad(int type) {
+	switch (type) {
+		case sonority_major:
+		case sonority_minor:
+		case sonority_diminished:
+		case sonority_augmented:
+			return true;
+	}
+	return false;
+}
+
+
+
+//////////////////////////////
+//
+// HumSonority::countBits -- Return the number of set bits in a mask.
+//
+
+int HumSonority::countBits(uint64_t mask) {
+	int output = 0;
+	while (mask) {
+		mask &= mask - 1;
+		output++;
+	}
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumSonority::getChordEntry -- Return the chord table entry for a
+//     12-tone pitch-class set.  The table covers all 4096 sets and is
+//     filled once on first use.  Entries store the chord type in bits
+//     0-3, and the root, third and fifth plus one in the next three
+//     groups of four bits (0 meaning not present).
+//
+
+uint32_t HumSonority::getChordEntry(int pcmask) {
+	static const vector<uint32_t> table = []() {
+		vector<uint32_t> output;
+		prepareChordTable(output);
+		return output;
+	}();
+	return table[pcmask & 0xfff];
+}
+
+
+
+//////////////////////////////
+//
+// HumSonority::prepareChordTable -- Classify every 12-tone pitch-class set.
+//
+
+void HumSonority::prepareChordTable(vector<uint32_t>& table) {
+	table.resize(4096);
+	for (int i=0; i<(int)table.size(); i++) {
+		table[i] = analyzeMask(i);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumSonority::analyzeMask -- Classify a pitch-class set.  Triads are
+//     identified by trying each pitch class as the root in order from C,
+//     checking for major, minor, diminished and then augmented triads.
+//
+
+uint32_t HumSonority::analyzeMask(int pcmask) {
+	vector<int> pcs;
+	for (int i=0; i<12; i++) {
+		if ((pcmask >> i) & 1) {
+			pcs.push_back(i);
+		}
+	}
+
+	int type  = sonority_empty;
+	int root  = -1;
+	int third = -1;
+	int fifth = -1;
+
+	if (pcs.size() == 1) {
+		type = sonority_unison;
+		root = pcs[0];
+	} else if (pcs.size() == 2) {
+		int interval = pcs[1] - pcs[0];
+		switch (interval) {
+			case 3:
+				type = sonority_minor_third;
+				root = pcs[0];
+				third = pcs[1];
+				break;
+			case 9:
+				type = sonority_minor_third;
+				root = pcs[1];
+				third = pcs[0];
+				break;
+			case 4:
+				type = sonority_major_third;
+				root = pcs[0];
+				third = pcs[1];
+				break;
+			case 8:
+				type = sonority_major_third;
+				root = pcs[1];
+				third = pcs[0];
+				break;
+			case 7:
+				type = sonority_fifth;
+				root = pcs[0];
+				fifth = pcs[1];
+				break;
+			case 5:
+				type = sonority_fifth;
+				root = pcs[1];
+				fifth = pcs[0];
+				break;
+			case 6:
+				type = sonority_tritone;
+				root = pcs[0];
+				fifth = pcs[1];
+				break;
+			default:
+				type = sonority_dyad;
+		}
+	} else if (pcs.size() == 3) {
+		type = sonority_trichord;
+		for (int i=0; i<3; i++) {
+			int r = pcs[i];
+			auto has = [&](int interval) {
+				return (pcmask >> ((r + interval) % 12)) & 1;
+			};
+			if (has(4) && has(7)) {
+				type = sonority_major;
+			} else if (has(3) && has(7)) {
+				type = sonority_minor;
+			} else if (has(3) && has(6)) {
+				type = sonority_diminished;
+			} else if (has(4) && has(8)) {
+				type = sonority_augmented;
+			} else {
+				continue;
+			}
+			root  = r;
+			third = (r + ((type == sonority_minor) || (type == sonority_diminished) ? 3 : 4)) % 12;
+			fifth = (r + (type == sonority_diminished ? 6 : (type == sonority_augmented ? 8 : 7))) % 12;
+			break;
+		}
+	} else if (pcs.size() > 3) {
+		type = sonority_large;
+	}
+
+	return (uint32_t)type
+			| ((uint32_t)(root  + 1) << 4)
+			| ((uint32_t)(third + 1) << 8)
+			| ((uint32_t)(fifth + 1) << 12);
+}
+
+
+
+// END_MERGE
+
+} // end namespace hum
+
+
+
@@ -0,0 +1,214 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 16:41:07 PDT 2026
+// Last Modified: Sun Oct 18 16:41:07 PDT 2026
+// Filename:      HumStatistics.cpp
+// URL:           https://github.com/craigsapp/humlib/blob/master/src/HumStatistics.cpp
+// Syntax:        C++11; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Named counters for collecting analysis statistics over
+//                many files.  Counters from separate workers can be merged
+//                and printed as a JSON summary.
+//
+
+#include "HumStatistics.h"
+
+#include <cmath>
+#include <cstdio>
+
+using namespace std;
+
+namespace hum {
+
+// START_MERGE
+
+
+
+//////////////////////////////
+//
+// HumStatistics::clear -- Remove all counters.
+//
+
+void HumStatistics::clear(void) {
+	m_files = 0;
+	m_counters.clear();
+}
+
+
+
+//////////////////////////////
+//
+// HumStatistics::isEmpty -- Return true if no files have been counted
+//     and there are no counters.
+//
+
+bool HumStatistics::isEmpty(void) const {
+	return (m_files == 0) && m_counters.empty();
+}
+
+
+
+//////////////////////////////
+//
+// HumStatistics::addFile -- Count another analyzed file.
+//
+
+void HumStatistics::addFile(void) {
+	m_files++;
+}
+
+
+
+//////////////////////////////
+//
+// HumStatistics::getFileCount -- Return the number of analyzed files.
+//
+
+int HumStatistics::getFileCount(void) const {
+	return m_files;
+}
+
+
+
+//////////////////////////////
+//
+// HumStatistics::increment -- Add an amount to a counter, creating the
+//     counter if it does not exist yet.
+//
+
+void HumStatistics::increment(const string& group, const string& key,
+		double amount) {
+	m_counters[group][key] += amount;
+}
+
+
+
+//////////////////////////////
+//
+// HumStatistics::getValue -- Return the value of a counter, or 0 if it
+//     does not exist.
+//
+
+double HumStatistics::getValue(const string& group, const string& key) const {
+	auto git = m_counters.find(group);
+	if (git == m_counters.end()) {
+		return 0.0;
+	}
+	auto kit = git->second.find(key);
+	if (kit == git->second.end()) {
+		return 0.0;
+	}
+	return kit->second;
+}
+
+
+
+//////////////////////////////
+//
+// HumStatistics::merge -- Add the counters of another object to this one.
+//     Used to combine the results of separate workers.
+//
+
+void HumStatistics::merge(const HumStatistics& other) {
+	m_files += other.m_files;
+	for (auto& group : other.m_counters) {
+		map<string, double>& target = m_counters[group.first];
+		for (auto& counter : group.second) {
+			target[counter.first] += counter.second;
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumStatistics::printJson -- Print the counters as a JSON object, with
+//     one member object for each group.  If a name is given, it is printed
+//     as the "tool" member.
+//
+
+void HumStatistics::printJson(ostream& out, const string& name) const {
+	out << "{\n";
+	if (!name.empty()) {
+		out << "\t\"tool\": ";
+		printJsonString(out, name);
+		out << ",\n";
+	}
+	out << "\t\"files\": " << m_files;
+	for (auto& group : m_counters) {
+		out << ",\n\t";
+		printJsonString(out, group.first);
+		out << ": {";
+		bool first = true;
+		for (auto& counter : group.second) {
+			out << (first ? "\n\t\t" : ",\n\t\t");
+			first = false;
+			printJsonString(out, counter.first);
+			out << ": ";
+			printJsonNumber(out, counter.second);
+		}
+		out << (first ? "}" : "\n\t}");
+	}
+	out << "\n}\n";
+}
+
+
+
+//////////////////////////////
+//
+// HumStatistics::printJsonString -- Print text as a quoted JSON string.
+//
+
+void HumStatistics::printJsonString(ostream& out, const string& text) {
+	out << '"';
+	for (int i=0; i<(int)text.size(); i++) {
+		unsigned char ch = (unsigned char)text[i];
+		switch (ch) {
+			case '"':  out << "\\\""; break;
+			case '\\': out << "\\\\"; break;
+			case '\n': out << "\\n";  break;
+			case '\t': out << "\\t";  break;
+			case '\r': out << "\\r";  break;
+			default:
+				if (ch < 0x20) {
+					char buffer[8];
+					snprintf(buffer, sizeof(buffer), "\\u%04x", ch);
+					out << buffer;
+				} else {
+					out << text[i];
+				}
+		}
+	}
+	out << '"';
+}
+
+
+
+//////////////////////////////
+//
+// HumStatistics::printJsonNumber -- Print counts as integers and other
+//     values with enough digits to survive a round trip.
+//
+
+void HumStatistics::printJsonNumber(ostream& out, double value) {
+	if (!std::isfinite(value)) {
+		out << "null";
+	} else if ((value == std::floor(value)) && (std::fabs(value) < 1.0e15)) {
+		out << (long long)value;
+	} else {
+		char buffer[32];
+		snprintf(buffer, sizeof(buffer), "%.15g", value);
+		out << buffer;
+	}
+}
+
+
+
+// END_MERGE
+
+} // end namespace hum
+
+
+
@@ -0,0 +1,194 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 13:05:31 PDT 2026
+// Last Modified: Sun Oct 18 13:05:31 PDT 2026
+// Filename:      HumThreadPool.cpp
+// URL:           https://github.com/craigsapp/humlib/blob/master/src/HumThreadPool.cpp
+// Syntax:        C++11; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   A small set of persistent worker threads for running
+//                independent tasks of an analysis in parallel.
+//
+
+#include "HumThreadPool.h"
+
+using namespace std;
+
+namespace hum {
+
+// START_MERGE
+
+
+
+//////////////////////////////
+//
+// HumThreadPool::HumThreadPool -- Start the worker threads.  A thread
+//     count of zero or less means to use the number of hardware threads.
+//
+
+HumThreadPool::HumThreadPool(int threads) {
+	if (threads <= 0) {
+		threads = getHardwareThreads();
+	}
+	m_next = 0;
+	for (int i=1; i<threads; i++) {
+		m_workers.emplace_back(&HumThreadPool::workerLoop, this);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumThreadPool::~HumThreadPool -- Stop the worker threads.
+//
+
+HumThreadPool::~HumThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+	for (int i=0; i<(int)m_workers.size(); i++) {
+		m_workers[i].join();
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumThreadPool::getThreadCount -- Return the number of threads that
+//     process tasks, including the thread calling run().
+//
+
+int HumThreadPool::getThreadCount(void) const {
+	return (int)m_workers.size() + 1;
+}
+
+
+
+//////////////////////////////
+//
+// HumThreadPool::getHardwareThreads -- Return the number of hardware
+//     threads, or 1 if unknown.
+//
+
+int HumThreadPool::getHardwareThreads(void) {
+	int output = (int)std::thread::hardware_concurrency();
+	if (output < 1) {
+		output = 1;
+	}
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumThreadPool::run -- Call task(0) through task(count-1), spread over
+//     the worker threads and the calling thread.  Returns when all tasks
+//     have finished.  The order in which tasks run is not defined, so each
+//     task should only modify data that belongs to its index.  If a task
+//     throws an exception, the remaining tasks are skipped and the first
+//     exception is rethrown.
+//
+
+void HumThreadPool::run(int count, const std::function<void(int)>& task) {
+	if (count <= 0) {
+		return;
+	}
+	std::lock_guard<std::mutex> runlock(m_runMutex);
+	if (m_workers.empty() || (count == 1)) {
+		for (int i=0; i<count; i++) {
+			task(i);
+		}
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_task  = &task;
+		m_count = count;
+		m_next  = 0;
+		m_busy  = (int)m_workers.size();
+		m_error = NULL;
+		m_generation++;
+	}
+	m_wake.notify_all();
+
+	doTasks();
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_finished.wait(lock, [this]() { return m_busy == 0; });
+	m_task = NULL;
+	if (m_error) {
+		std::exception_ptr error = m_error;
+		m_error = NULL;
+		std::rethrow_exception(error);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumThreadPool::workerLoop -- Wait for a run, then process tasks until
+//     none are left.
+//
+
+void HumThreadPool::workerLoop(void) {
+	int generation = 0;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wake.wait(lock, [&]() { return m_stop || (m_generation != generation); });
+			if (m_stop) {
+				return;
+			}
+			generation = m_generation;
+		}
+		doTasks();
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_busy--;
+		}
+		m_finished.notify_one();
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumThreadPool::doTasks -- Process tasks from the current run until all
+//     have been taken.
+//
+
+void HumThreadPool::doTasks(void) {
+	while (true) {
+		int index = m_next++;
+		if (index >= m_count) {
+			return;
+		}
+		try {
+			(*m_task)(index);
+		} catch (...) {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (!m_error) {
+				m_error = std::current_exception();
+			}
+			m_next = m_count;
+		}
+	}
+}
+
+
+
+// END_MERGE
+
+} // end namespace hum
+
+
+
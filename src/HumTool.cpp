@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Mon Nov 28 08:55:15 PST 2016
-// Last Modified: Tue Dec 20 22:33:15 PST 2016
+// Last Modified: Mon Oct 19 01:16:38 PDT 2026
 // Filename:      HumTool.cpp
 // URL:           https://github.com/craigsapp/humlib/blob/master/src/HumTool.cpp
 // Syntax:        C++11; humlib
@@ -278,6 +278,36 @@ void HumTool::clearOutput(void) {
 
 
 
+//////////////////////////////
+//
+// HumTool::isReusable -- Returns true if the tool resets all of its
+//     analysis data at the start of each run, so that an instance can
+//     be run on several files with the same options (and only the output
+//     cleared between files).  Tool_filter reuses the instances of such
+//     tools.  Tools with data that carry over from one file to the next
+//     must not override this function.
+//
+
+bool HumTool::isReusable(void) {
+	return false;
+}
+
+
+
+//////////////////////////////
+//
+// HumTool::getSegmentBatchSize -- Returns the number of segments that
+//     STREAM_INTERFACE reads before each call to run(HumdrumFileSet&).
+//     Tools which process the files of a set in parallel can return a
+//     larger number.  Called after the options have been processed.
+//
+
+int HumTool::getSegmentBatchSize(void) {
+	return 1;
+}
+
+
+
 ///////////////////////////////
 //
 // HumTool::setError --
@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Fri Dec  2 09:30:17 PST 2016
-// Last Modified: Fri Dec  2 09:30:21 PST 2016
+// Last Modified: Mon Oct 19 00:21:34 PDT 2026
 // Filename:      HumdrumFileBase-net.cpp
 // URL:           https://github.com/craigsapp/humlib/blob/master/src/HumdrumFileBase-net.cpp
 // Syntax:        C++11; humlib
@@ -15,7 +15,10 @@
 #include "HumdrumFileBase.h"
 
 #include <cstdarg>
+#include <cstdint>
+#include <cstdlib>
 #include <cstring>
+#include <ctime>
 #include <fstream>
 #include <sstream>
 
@@ -100,6 +103,11 @@ string HumdrumFileBase::getUriToUrlMapping(const string& uri) {
 
 #ifdef USING_URI
 
+thread_local HumHttpConnections HumdrumFileBase::m_httpConnections;
+string HumdrumFileBase::m_uriCacheDirectory;
+int HumdrumFileBase::m_uriCacheMaxAge = 24 * 60 * 60;
+
+
 //////////////////////////////
 //
 // HumdrumFileBase::readFromHumdrumUri -- Read a Humdrum file from an
@@ -150,7 +158,101 @@ void HumdrumFileBase::readFromHttpUri(const string& webaddress) {
 
 //////////////////////////////
 //
-// readStringFromHttpUri -- Read a Humdrum file from an http:// web address
+// HumdrumFileBase::setUriCacheDirectory -- Set a directory in which to
+//     store files downloaded from the web.  Downloaded content is stored
+//     in a file named by a hash of the content, and a metadata file named
+//     by a hash of the URL stores the ETag and expiry time of the
+//     download.  Set to an empty string to disable caching (the
+//     HUMLIB_URI_CACHE environment variable will then be used if set).
+//
+
+void HumdrumFileBase::setUriCacheDirectory(const string& directory) {
+	m_uriCacheDirectory = directory;
+	while ((m_uriCacheDirectory.size() > 1) && (m_uriCacheDirectory.back() == '/')) {
+		m_uriCacheDirectory.pop_back();
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::getUriCacheDirectory -- Return the directory used to
+//     cache downloaded files, or an empty string if no caching.
+//
+
+string HumdrumFileBase::getUriCacheDirectory(void) {
+	if (!m_uriCacheDirectory.empty()) {
+		return m_uriCacheDirectory;
+	}
+	const char* env = getenv("HUMLIB_URI_CACHE");
+	if (env == NULL) {
+		return "";
+	}
+	return env;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::setUriCacheMaxAge -- Set the number of seconds that
+//     a cached download is used without checking with the server, when
+//     the server does not give a Cache-Control max-age.  Default is one day.
+//
+
+void HumdrumFileBase::setUriCacheMaxAge(int seconds) {
+	m_uriCacheMaxAge = seconds;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::closeHttpConnections -- Close all keep-alive
+//     connections to web servers that were opened by the current thread.
+//
+
+void HumdrumFileBase::closeHttpConnections(void) {
+	m_httpConnections.closeAll();
+}
+
+
+
+//////////////////////////////
+//
+// HumHttpConnections::~HumHttpConnections -- Close the connections when
+//     the thread that owns them ends.
+//
+
+HumHttpConnections::~HumHttpConnections() {
+	closeAll();
+}
+
+
+
+//////////////////////////////
+//
+// HumHttpConnections::closeAll -- Close all of the connections.
+//
+
+void HumHttpConnections::closeAll(void) {
+	for (auto& item : *this) {
+		close(item.second);
+	}
+	clear();
+}
+
+
+
+//////////////////////////////
+//
+// readStringFromHttpUri -- Read a Humdrum file from an http:// web address.
+//     If a cache directory is set, then the cached copy of the file will be
+//     returned if it has not expired, or if the server replies that it has
+//     not changed since it was cached.  Connections to the server are kept
+//     open, so that downloading multiple files from the same server does not
+//     require a new connection for each file.
 //
 
 void HumdrumFileBase::readStringFromHttpUri(stringstream& inputdata,
@@ -158,6 +260,8 @@ void HumdrumFileBase::readStringFromHttpUri(stringstream& inputdata,
 	auto css = webaddress.find("://");
 	if (css == string::npos) {
 		// give up since URI was not in correct format
+		cerr << "Error: invalid URL: " << webaddress << endl;
+		exit(1);
 	}
 	string rest = webaddress.substr(css+3);
 	string hostname;
@@ -174,125 +278,388 @@ void HumdrumFileBase::readStringFromHttpUri(stringstream& inputdata,
 		location = "/";
 	}
 
+	unsigned short int port = 80;
+	auto colon = hostname.find(':');
+	if (colon != string::npos) {
+		port = (unsigned short int)atoi(hostname.substr(colon+1).c_str());
+		hostname = hostname.substr(0, colon);
+	}
+
+	string cached;
+	string etag;
+	bool expiredQ = true;
+	bool cachedQ = readUriCache(webaddress, cached, etag, expiredQ);
+	if (cachedQ && !expiredQ) {
+		inputdata << cached;
+		return;
+	}
+	if (!cachedQ) {
+		etag.clear();
+	}
+
+	stringstream body;
+	int status = 0;
+	string newetag;
+	int maxage = -1;
+	requestHttpUri(body, hostname, port, location, etag, status, newetag, maxage);
+
+	if ((status == 304) && cachedQ) {
+		// data has not changed on the server, so use the cached copy
+		writeUriCache(webaddress, cached, etag, maxage);
+		inputdata << cached;
+		return;
+	}
+
+	if ((status < 200) || (status >= 300)) {
+		// Do not return error pages as data.
+		cerr << "Error: HTTP status " << status << " for URI\n";
+		cerr << "URL:   " << webaddress << endl;
+		exit(1);
+	}
+
+	string contents = body.str();
+	if (contents.empty()) {
+		cerr << "Error: no data found for URI (probably invalid)\n";
+		cerr << "URL:   " << webaddress << endl;
+		exit(1);
+	}
+	if ((status == 200) && ((maxage != 0) || !newetag.empty())) {
+		// (Data that expires immediately and cannot be revalidated
+		// is not worth caching.)
+		writeUriCache(webaddress, contents, newetag, maxage);
+	}
+	inputdata << contents;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::requestHttpUri -- Send a GET request to a web server
+//     and read the response into inputdata.  An open connection to the
+//     server will be reused if available.  If the reused connection was
+//     closed by the server, then a new connection will be made.  If etag
+//     is not empty, then the request is conditional, and a status of 304
+//     means that the data has not changed.  The maxage parameter is set
+//     to the max-age value from a Cache-Control header, or -1 if none.
+//
+
+bool HumdrumFileBase::requestHttpUri(stringstream& inputdata,
+		const string& hostname, unsigned short int port, const string& location,
+		const string& etag, int& status, string& newetag, int& maxage) {
+
 	string newline({0x0d, 0x0a});
 
 	stringstream request;
 	request << "GET "   << location << " HTTP/1.1" << newline;
-	request << "Host: " << hostname << newline;
-	request << "User-Agent: HumdrumFile Downloader 2.0 ("
+	request << "Host: " << hostname;
+	if (port != 80) {
+		request << ":" << port;
+	}
+	request << newline;
+	request << "User-Agent: HumdrumFile Downloader 2.1 ("
 		     << __DATE__ << ")" << newline;
-	request << "Connection: close" << newline;  // this line is necessary
+	if (!etag.empty()) {
+		request << "If-None-Match: " << etag << newline;
+	}
+	request << "Connection: keep-alive" << newline;
 	request << newline;
+	string rstring = request.str();
+
+	for (int attempt=0; attempt<2; attempt++) {
+		bool reusedQ = false;
+		int socket_id = getHttpConnection(hostname, port, reusedQ);
+		// Do not raise SIGPIPE if the server has reset a kept-alive
+		// connection, so that the request can be tried again.
+		int flags = 0;
+		#ifdef MSG_NOSIGNAL
+			flags = MSG_NOSIGNAL;
+		#endif
+		if (send(socket_id, rstring.c_str(), rstring.size(), flags) != (ssize_t)rstring.size()) {
+			dropHttpConnection(hostname, port);
+			if (reusedQ) {
+				continue;
+			}
+			cerr << "Error writing to " << hostname << endl;
+			exit(1);
+		}
 
-	unsigned short int port = 80;
-	int socket_id = open_network_socket(hostname, port);
-	if (::write(socket_id, request.str().c_str(), request.str().size()) == -1) {
-		exit(-1);
-	}
-
-	#define URI_BUFFER_SIZE (10000)
-	char buffer[URI_BUFFER_SIZE];
-	unsigned int message_len;
-	stringstream header;
-	int foundcontent   = 0;
-	int newlinecounter = 0;
-	int i;
-
-	// read the response header:
-	while ((message_len = ::read(socket_id, buffer, 1)) != 0) {
-		header << buffer[0];
-		if ((buffer[0] == 0x0a) || (buffer[0] == 0x0d)) {
-					newlinecounter++;
+		HumHttpReader reader(socket_id);
+		string line;
+		if (!reader.readLine(line)) {
+			// The server closed a kept-alive connection, so try again
+			// with a new connection.
+			dropHttpConnection(hostname, port);
+			if (reusedQ) {
+				continue;
+			}
+			cerr << "Funny error trying to read server response" << endl;
+			exit(1);
+		}
+
+		// status line: "HTTP/1.1 200 OK"
+		status = 0;
+		auto space = line.find(' ');
+		if (space != string::npos) {
+			status = atoi(line.c_str() + space + 1);
+		}
+		bool closeQ = Convert::startsWith(line, "HTTP/1.0");
+
+		// read the response header:
+		int datalength = -1;
+		bool chunked = false;
+		maxage = -1;
+		newetag.clear();
+		while (reader.readLine(line)) {
+			if (line.empty()) {
+				break;
+			}
+			auto colon = line.find(':');
+			if (colon == string::npos) {
+				continue;
+			}
+			string key = line.substr(0, colon);
+			for (int i=0; i<(int)key.size(); i++) {
+				key[i] = std::tolower(key[i]);
+			}
+			string value = Convert::trimWhiteSpace(line.substr(colon+1));
+			string lvalue = value;
+			for (int i=0; i<(int)lvalue.size(); i++) {
+				lvalue[i] = std::tolower(lvalue[i]);
+			}
+			if (key == "content-length") {
+				datalength = atoi(value.c_str());
+			} else if (key == "transfer-encoding") {
+				if (lvalue.find("chunked") != string::npos) {
+					chunked = true;
+				}
+			} else if (key == "connection") {
+				if (lvalue.find("close") != string::npos) {
+					closeQ = true;
+				} else if (lvalue.find("keep-alive") != string::npos) {
+					closeQ = false;
+				}
+			} else if (key == "etag") {
+				newetag = value;
+			} else if (key == "cache-control") {
+				auto loc = lvalue.find("max-age=");
+				if (loc != string::npos) {
+					maxage = atoi(lvalue.c_str() + loc + 8);
+				}
+				if ((lvalue.find("no-cache") != string::npos) ||
+						(lvalue.find("no-store") != string::npos)) {
+					maxage = 0;
+				}
+			}
+		}
+
+		#define URI_BUFFER_SIZE (10000)
+		char buffer[URI_BUFFER_SIZE];
+		if ((status == 304) || (status == 204) || ((status >= 100) && (status < 200))) {
+			// no content in response
+		} else if (chunked) {
+			int chunksize;
+			do {
+				chunksize = getChunk(reader, inputdata, buffer, URI_BUFFER_SIZE);
+			} while (chunksize > 0);
+		} else if (datalength >= 0) {
+			getFixedDataSize(reader, datalength, inputdata, buffer,
+					URI_BUFFER_SIZE);
 		} else {
-					newlinecounter = 0;
+			// if the size of the rest of the data cannot be found in the
+			// header, then just keep reading until the server closes
+			// the connection.
+			int message_len;
+			while ((message_len = reader.read(buffer, URI_BUFFER_SIZE)) > 0) {
+				inputdata.write(buffer, message_len);
+			}
+			closeQ = true;
 		}
-		if (newlinecounter == 4) {
-			foundcontent = 1;
-			break;
+
+		if (closeQ) {
+			dropHttpConnection(hostname, port);
 		}
+		return true;
 	}
-	if (foundcontent == 0) {
-		cerr << "Funny error trying to read server response" << endl;
-		exit(1);
+
+	cerr << "Error: could not download data from " << hostname << endl;
+	exit(1);
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::getHttpConnection -- Return an open connection to
+//     the given server, reusing a kept-alive connection if available.
+//
+
+int HumdrumFileBase::getHttpConnection(const string& hostname,
+		unsigned short int port, bool& reusedQ) {
+	string key = hostname + ":" + to_string(port);
+	auto it = m_httpConnections.find(key);
+	if (it != m_httpConnections.end()) {
+		reusedQ = true;
+		return it->second;
+	}
+	reusedQ = false;
+	int socket_id = open_network_socket(hostname, port);
+	m_httpConnections[key] = socket_id;
+	return socket_id;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::dropHttpConnection -- Close the connection to
+//     the given server (such as when the server requests to close it).
+//
+
+void HumdrumFileBase::dropHttpConnection(const string& hostname,
+		unsigned short int port) {
+	string key = hostname + ":" + to_string(port);
+	auto it = m_httpConnections.find(key);
+	if (it == m_httpConnections.end()) {
+		return;
+	}
+	close(it->second);
+	m_httpConnections.erase(it);
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::getUriCacheKey -- Return a 64-bit FNV-1a hash of
+//     the input string as a hexadecimal string.  Used to name files
+//     in the URI cache directory.
+//
+
+string HumdrumFileBase::getUriCacheKey(const string& contents) {
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	for (int i=0; i<(int)contents.size(); i++) {
+		hash ^= (unsigned char)contents[i];
+		hash *= 0x100000001b3ULL;
 	}
+	char output[32];
+	snprintf(output, 32, "%016llx", (unsigned long long)hash);
+	return output;
+}
 
-	// now read the size of the rest of the data which is expected
-	int datalength = -1;
 
-	// also, check for chunked transfer encoding:
 
-	int chunked = 0;
+//////////////////////////////
+//
+// HumdrumFileBase::readUriCache -- Read the cached copy of a download.
+//     Returns false if there is no cached copy.  The metadata file for
+//     a URL is named by the hash of the URL and contains the lines:
+//        url: <webaddress>
+//        etag: <ETag from server>
+//        expires: <seconds since epoch>
+//        content: <hash of contents>
+//     The contents are stored in a file named by the hash of the contents.
+//
 
-	header << ends; // necessary?
-	while (header.getline(buffer, URI_BUFFER_SIZE)) {
-		int len = (int)strlen(buffer);
-		for (i=0; i<len; i++) {
-			buffer[i] = std::tolower(buffer[i]);
+bool HumdrumFileBase::readUriCache(const string& webaddress, string& contents,
+		string& etag, bool& expiredQ) {
+	expiredQ = true;
+	string directory = getUriCacheDirectory();
+	if (directory.empty()) {
+		return false;
+	}
+	string metaname = directory + "/" + getUriCacheKey(webaddress) + ".meta";
+	ifstream metafile(metaname);
+	if (!metafile.is_open()) {
+		return false;
+	}
+	string url;
+	string content;
+	long long expires = 0;
+	string line;
+	while (getline(metafile, line)) {
+		auto colon = line.find(": ");
+		if (colon == string::npos) {
+			continue;
 		}
-		if (strstr(buffer, "content-length") != NULL) {
-			for (i=14; i<len; i++) {
-				if (std::isdigit(buffer[i])) {
-					sscanf(&buffer[i], "%d", &datalength);
-					if (datalength == 0) {
-						cerr << "Error: no data found for URI, probably invalid\n";
-						cerr << "URL:   " << webaddress << endl;
-						exit(1);
-					}
-					break;
-				}
-			}
-		} else if ((strstr(buffer, "transfer-encoding") != NULL) &&
-			(strstr(buffer, "chunked") != NULL)) {
-			chunked = 1;
+		string key = line.substr(0, colon);
+		string value = line.substr(colon+2);
+		if (key == "url") {
+			url = value;
+		} else if (key == "etag") {
+			etag = value;
+		} else if (key == "expires") {
+			expires = atoll(value.c_str());
+		} else if (key == "content") {
+			content = value;
 		}
 	}
+	if ((url != webaddress) || content.empty()) {
+		// hash collision or corrupted metadata
+		return false;
+	}
+	ifstream datafile(directory + "/" + content + ".dat", std::ios::binary);
+	if (!datafile.is_open()) {
+		return false;
+	}
+	contents.assign(istreambuf_iterator<char>(datafile), istreambuf_iterator<char>());
+	expiredQ = (long long)time(NULL) >= expires;
+	return true;
+}
 
-	// once the length of the remaining data is known (or not), read it:
-	if (datalength > 0) {
-		getFixedDataSize(socket_id, datalength, inputdata, buffer,
-				URI_BUFFER_SIZE);
-
-	} else if (chunked) {
-		int chunksize;
-		int totalsize = 0;
-		do {
-			chunksize = getChunk(socket_id, inputdata, buffer, URI_BUFFER_SIZE);
-			totalsize += chunksize;
-		} while (chunksize > 0);
-		if (totalsize == 0) {
-			cerr << "Error: no data found for URI (probably invalid)\n";
-			exit(1);
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::writeUriCache -- Store a downloaded file in the cache
+//     directory (if there is one).  If maxage is negative, then use the
+//     default cache age.
+//
+
+void HumdrumFileBase::writeUriCache(const string& webaddress,
+		const string& contents, const string& etag, int maxage) {
+	string directory = getUriCacheDirectory();
+	if (directory.empty()) {
+		return;
+	}
+	struct stat info;
+	if (stat(directory.c_str(), &info) != 0) {
+		if (mkdir(directory.c_str(), 0755) != 0) {
+			cerr << "Warning: cannot create cache directory " << directory << endl;
+			return;
 		}
-	} else {
-		// if the size of the rest of the data cannot be found in the
-		// header, then just keep reading until done (but this will
-		// probably cause a 5 second delay at the last read).
-		while ((message_len = ::read(socket_id, buffer, URI_BUFFER_SIZE)) != 0) {
-			if (foundcontent) {
-				inputdata.write(buffer, message_len);
-			} else {
-				for (i=0; i<(int)message_len; i++) {
-					if (foundcontent) {
-						inputdata << buffer[i];
-					} else {
-						header << buffer[i];
-						if ((buffer[i] == 0x0a) || (buffer[i] == 0x0d)) {
-							newlinecounter++;
-						} else {
-							newlinecounter = 0;
-						}
-						if (newlinecounter == 4) {
-							foundcontent = 1;
-							continue;
-						}
-					}
+	}
+	if (maxage < 0) {
+		maxage = m_uriCacheMaxAge;
+	}
 
-				}
-			}
+	string content = getUriCacheKey(contents);
+	string dataname = directory + "/" + content + ".dat";
+	if (stat(dataname.c_str(), &info) != 0) {
+		// Write to a temporary file first so that other processes
+		// will not read a partially written file.
+		string tempname = dataname + ".tmp" + to_string(getpid());
+		std::ofstream datafile(tempname, std::ios::binary);
+		if (!datafile.is_open()) {
+			return;
 		}
+		datafile << contents;
+		datafile.close();
+		rename(tempname.c_str(), dataname.c_str());
 	}
 
-	close(socket_id);
+	string metaname = directory + "/" + getUriCacheKey(webaddress) + ".meta";
+	string tempname = metaname + ".tmp" + to_string(getpid());
+	std::ofstream metafile(tempname);
+	if (!metafile.is_open()) {
+		return;
+	}
+	metafile << "url: "     << webaddress << "\n";
+	metafile << "etag: "    << etag << "\n";
+	metafile << "expires: " << (long long)time(NULL) + maxage << "\n";
+	metafile << "content: " << content << "\n";
+	metafile.close();
+	rename(tempname.c_str(), metaname.c_str());
 }
 
 
@@ -324,43 +691,32 @@ void HumdrumFileBase::readStringFromHttpUri(stringstream& inputdata,
 //
 // The message is finally closed by a last CRLF combination.
 
-int HumdrumFileBase::getChunk(int socket_id, stringstream& inputdata,
+int HumdrumFileBase::getChunk(HumHttpReader& reader, stringstream& inputdata,
 		char* buffer, int bufsize) {
-	int chunksize = 0;
-	unsigned int message_len;
-	char digit[2] = {0};
-	int founddigit = 0;
-
-	// first read the chunk size:
-	while ((message_len = ::read(socket_id, buffer, 1)) != 0) {
-		if (isxdigit(buffer[0])) {
-			digit[0] = buffer[0];
-			chunksize = (chunksize << 4) | (int)strtol(digit, NULL, 16);
-			founddigit = 1;
-		} else if (founddigit) {
-			break;
-		} // else skipping whitespace before chunksize
-	}
-	if ((chunksize <= 0) || (message_len == 0)) {
-		// next chunk is zero, so no more primary data0:w
-		return 0;
-	}
-
-	// read the 0x0d and 0x0a characters which are expected (required)
-	// after the size of chunk size:
-	if (buffer[0] != 0x0d) {
-		cerr << "Strange error occurred right after reading a chunk size" << endl;
-		exit(1);
-	}
+	string line;
 
-	// now expect 0x0a:
-	message_len = ::read(socket_id, buffer, 1);
-	if ((message_len == 0) || (buffer[0] != 0x0a)) {
-		cerr << "Strange error after reading newline at end of chunk size"<< endl;
-		exit(1);
+	// first read the chunk size (skipping over the CRLF at the end
+	// of the previous chunk):
+	do {
+		if (!reader.readLine(line)) {
+			return 0;
+		}
+		line = Convert::trimWhiteSpace(line);
+	} while (line.empty());
+
+	int chunksize = (int)strtol(line.c_str(), NULL, 16);
+	if (chunksize <= 0) {
+		// Last chunk: read the optional trailers and the final CRLF
+		// so that the connection can be reused.
+		while (reader.readLine(line)) {
+			if (line.empty()) {
+				break;
+			}
+		}
+		return 0;
 	}
 
-	return getFixedDataSize(socket_id, chunksize, inputdata, buffer, bufsize);
+	return getFixedDataSize(reader, chunksize, inputdata, buffer, bufsize);
 }
 
 
@@ -370,7 +726,7 @@ int HumdrumFileBase::getChunk(int socket_id, stringstream& inputdata,
 // getFixedDataSize -- read a know amount of data from a socket.
 //
 
-int HumdrumFileBase::getFixedDataSize(int socket_id, int datalength,
+int HumdrumFileBase::getFixedDataSize(HumHttpReader& reader, int datalength,
 		stringstream& inputdata, char* buffer, int bufsize) {
 	int readcount = 0;
 	int readsize;
@@ -381,8 +737,8 @@ int HumdrumFileBase::getFixedDataSize(int socket_id, int datalength,
 		if (readcount + readsize > datalength) {
 			readsize = datalength - readcount;
 		}
-		message_len = (int)::read(socket_id, buffer, readsize);
-		if (message_len == 0) {
+		message_len = reader.read(buffer, readsize);
+		if (message_len <= 0) {
 			// shouldn't happen, but who knows...
 			break;
 		}
@@ -395,6 +751,88 @@ int HumdrumFileBase::getFixedDataSize(int socket_id, int datalength,
 
 
 
+//////////////////////////////
+//
+// HumHttpReader::fill -- Read the next block of data from the socket.
+//    Returns the number of bytes read, or 0 if the connection was closed.
+//
+
+int HumHttpReader::fill(void) {
+	m_index = 0;
+	m_length = 0;
+	int count = (int)::read(m_socket, m_buffer, sizeof(m_buffer));
+	if (count > 0) {
+		m_length = count;
+	}
+	return m_length;
+}
+
+
+
+//////////////////////////////
+//
+// HumHttpReader::readLine -- Read a line ending in LF (with an optional
+//    CR before it, which is removed).  Returns false if the connection was
+//    closed before any characters were read.
+//
+
+bool HumHttpReader::readLine(string& line) {
+	line.clear();
+	bool foundQ = false;
+	while (true) {
+		if (m_index >= m_length) {
+			if (fill() == 0) {
+				return foundQ;
+			}
+		}
+		foundQ = true;
+		char* start = m_buffer + m_index;
+		char* end = (char*)memchr(start, 0x0a, m_length - m_index);
+		if (end == NULL) {
+			line.append(start, m_length - m_index);
+			m_index = m_length;
+			continue;
+		}
+		line.append(start, end - start);
+		m_index += (int)(end - start) + 1;
+		break;
+	}
+	if (!line.empty() && (line.back() == 0x0d)) {
+		line.pop_back();
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumHttpReader::read -- Read up to size bytes, first returning any
+//    data already buffered.  Returns 0 if the connection was closed.
+//
+
+int HumHttpReader::read(char* buffer, int size) {
+	if (m_index >= m_length) {
+		if (size >= (int)sizeof(m_buffer)) {
+			// large reads do not need to go through the buffer
+			int count = (int)::read(m_socket, buffer, size);
+			return count > 0 ? count : 0;
+		}
+		if (fill() == 0) {
+			return 0;
+		}
+	}
+	int count = m_length - m_index;
+	if (count > size) {
+		count = size;
+	}
+	memcpy(buffer, m_buffer + m_index, count);
+	m_index += count;
+	return count;
+}
+
+
+
 //////////////////////////////
 //
 // HumdrumFileBase::prepare_address -- Store a computer name, such as
@@ -449,6 +887,11 @@ int HumdrumFileBase::open_network_socket(const string& hostname,
 		cerr << "Error opening socket to computer " << hostname << endl;
 		exit(1);
 	}
+	#ifdef SO_NOSIGPIPE
+		// Systems without MSG_NOSIGNAL (macOS) disable SIGPIPE on the socket.
+		int nosigpipe = 1;
+		setsockopt(inet_socket, SOL_SOCKET, SO_NOSIGPIPE, &nosigpipe, sizeof(nosigpipe));
+	#endif
 	if (connect(inet_socket, (struct sockaddr *)&servaddr,
 			sizeof(struct sockaddr_in)) < 0) {
 		// connect returns -1 on error
@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Sat Aug  8 12:24:49 PDT 2015
-// Last Modified: Fri Aug 14 21:57:09 PDT 2015
+// Last Modified: Mon Oct 19 00:58:12 PDT 2026
 // Filename:      HumdrumFileBase.cpp
 // URL:           https://github.com/craigsapp/humlib/blob/master/src/HumdrumFileBase.cpp
 // Syntax:        C++11; humlib
@@ -70,10 +70,12 @@ HumdrumFileBase::HumdrumFileBase(HumdrumFileBase& infile) {
 	m_filename = infile.m_filename;
 	m_segmentlevel = infile.m_segmentlevel;
 	m_trackstarts.clear();
+	m_trackdatatypes.clear();
 	m_trackends.clear();
 	m_barlines.clear();
 	m_ticksperquarternote = infile.m_ticksperquarternote;
 	m_idprefix = infile.m_idprefix;
+	m_analysisThreads = infile.m_analysisThreads;
 	m_strand1d.clear();
 	m_strand2d.clear();
 	m_strophes1d.clear();
@@ -88,7 +90,8 @@ HumdrumFileBase::HumdrumFileBase(HumdrumFileBase& infile) {
 		m_lines[i]->setOwner(this);
 	}
 
-	analyzeBaseFromLines();
+	// Tokens are created by the HumdrumLine constructor.
+	analyzeBaseFromTokens();
 }
 
 
@@ -108,10 +111,12 @@ HumdrumFileBase& HumdrumFileBase::operator=(HumdrumFileBase& infile) {
 	m_filename = infile.m_filename;
 	m_segmentlevel = infile.m_segmentlevel;
 	m_trackstarts.clear();
+	m_trackdatatypes.clear();
 	m_trackends.clear();
 	m_barlines.clear();
 	m_ticksperquarternote = infile.m_ticksperquarternote;
 	m_idprefix = infile.m_idprefix;
+	m_analysisThreads = infile.m_analysisThreads;
 	m_strand1d.clear();
 	m_strand2d.clear();
 	m_strophes1d.clear();
@@ -126,7 +131,8 @@ HumdrumFileBase& HumdrumFileBase::operator=(HumdrumFileBase& infile) {
 		m_lines[i]->setOwner(this);
 	}
 
-	analyzeBaseFromLines();
+	// Tokens are created by the HumdrumLine constructor.
+	analyzeBaseFromTokens();
 	return *this;
 }
 
@@ -160,6 +166,7 @@ void HumdrumFileBase::clear(void) {
 
 	// clear state variables which are now invalid:
 	m_trackstarts.clear();
+	m_trackdatatypes.clear();
 	m_trackends.clear();
 	m_barlines.clear();
 	m_ticksperquarternote = -1;
@@ -219,6 +226,65 @@ bool HumdrumFileBase::areStrophesAnalyzed(void) {
 
 
 
+//////////////////////////////
+//
+// HumdrumFileBase::setAnalysisThreads -- Set the number of threads to use
+//     for analyses that are done independently for each spine or strand
+//     (such as rhythm, slur, phrase, beam and stem-length analyses).  Set
+//     this before reading data to include the rhythm analysis.  A count of
+//     1 (the default) does all analysis in the calling thread, and 0 will
+//     use the number of hardware threads.  Results are the same as with
+//     a single thread.
+//
+
+void HumdrumFileBase::setAnalysisThreads(int count) {
+	if (count <= 0) {
+		count = HumThreadPool::getHardwareThreads();
+	}
+	if (count != m_analysisThreads) {
+		m_threadPool.reset();
+	}
+	m_analysisThreads = count;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::getAnalysisThreads -- Return the number of threads used
+//     for per-spine analyses.
+//
+
+int HumdrumFileBase::getAnalysisThreads(void) const {
+	return m_analysisThreads;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::runParallel -- Call task(0) through task(count-1) on the
+//     analysis threads, or in order in the calling thread if only one
+//     analysis thread is used.  Each task must only modify data that
+//     belongs to its index (such as the tokens of one spine), and anything
+//     shared must be merged after this function returns.
+//
+
+void HumdrumFileBase::runParallel(int count, const std::function<void(int)>& task) {
+	if ((m_analysisThreads <= 1) || (count <= 1)) {
+		for (int i=0; i<count; i++) {
+			task(i);
+		}
+		return;
+	}
+	if (!m_threadPool) {
+		m_threadPool = std::make_shared<HumThreadPool>(m_analysisThreads);
+	}
+	m_threadPool->run(count, task);
+}
+
+
+
 //////////////////////////////
 //
 // HumdrumFileBase::setXmlIdPrefix -- Set the prefix for a HumdrumXML ID
@@ -355,7 +421,8 @@ bool HumdrumFileBase::read(istream& contents) {
       s->setOwner(this);
       m_lines.push_back(s);
    }
-   return analyzeBaseFromLines();
+   // Tokens are created by the HumdrumLine constructor.
+   return analyzeBaseFromTokens();
 }
 
 
@@ -368,7 +435,7 @@ bool HumdrumFileBase::read(istream& contents) {
 //
 
 bool HumdrumFileBase::readCsv(const string& filename, const string& separator) {
-	return HumdrumFileBase::readCsv(filename.c_str());
+	return HumdrumFileBase::readCsv(filename.c_str(), separator);
 }
 
 
@@ -389,16 +456,39 @@ bool HumdrumFileBase::readCsv(const char* filename, const string& separator) {
 
 
 bool HumdrumFileBase::readCsv(istream& contents, const string& separator) {
+	string data((istreambuf_iterator<char>(contents)), istreambuf_iterator<char>());
+	return readCsvText(data.data(), data.size(), separator);
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::readCsvText -- Create lines and tokens from CSV data.
+//    Newlines are located with memchr(), and there is no limit on the
+//    length of lines.  The tokens are created while converting each line
+//    into TSV format, so they do not need to be created from the text of
+//    the line afterwards.
+//
+
+bool HumdrumFileBase::readCsvText(const char* contents, size_t length,
+		const string& separator) {
+	clear();
 	m_displayError = true;
-	char buffer[123123] = {0};
-	HLp s;
-	while (contents.getline(buffer, sizeof(buffer), '\n')) {
-		s = new HumdrumLine;
-		s->setLineFromCsv(buffer);
+	const char* ptr = contents;
+	const char* end = contents + length;
+	while (ptr < end) {
+		const char* newline = (const char*)memchr(ptr, '\n', end - ptr);
+		if (newline == NULL) {
+			newline = end;
+		}
+		HLp s = new HumdrumLine;
+		s->createTokensFromCsv(ptr, (int)(newline - ptr), separator);
 		s->setOwner(this);
 		m_lines.push_back(s);
+		ptr = newline + 1;
 	}
-	return analyzeBaseFromLines();
+	return analyzeBaseFromTokens();
 }
 
 
@@ -497,17 +587,13 @@ bool HumdrumFileBase::readString(const char* contents) {
 
 bool HumdrumFileBase::readStringCsv(const char* contents,
 		const string& separator) {
-	stringstream infile;
-	infile << contents;
-	return readCsv(infile, separator);
+	return readCsvText(contents, strlen(contents), separator);
 }
 
 
 bool HumdrumFileBase::readStringCsv(const string& contents,
 		const string& separator) {
-	stringstream infile;
-	infile << contents;
-	return readCsv(infile, separator);
+	return readCsvText(contents.data(), contents.size(), separator);
 }
 
 
@@ -842,6 +928,7 @@ void HumdrumFileBase::createLinesFromTokens(void) {
 	for (int i=0; i<(int)m_lines.size(); i++) {
 		m_lines[i]->createLineFromTokens();
 	}
+	m_analyses.m_references_analyzed = false;
 }
 
 
@@ -855,12 +942,18 @@ void HumdrumFileBase::createLinesFromTokens(void) {
 void HumdrumFileBase::appendLine(const string& line) {
 	HLp s = new HumdrumLine(line);
 	m_lines.push_back(s);
+	m_analyses.m_slices_analyzed = false;
+	m_analyses.m_references_analyzed = false;
+	m_analyses.m_metric_analyzed = false;
 }
 
 
 void HumdrumFileBase::appendLine(HLp line) {
 	// deletion will be handled by class.
 	m_lines.push_back(line);
+	m_analyses.m_slices_analyzed = false;
+	m_analyses.m_references_analyzed = false;
+	m_analyses.m_metric_analyzed = false;
 }
 
 
@@ -874,6 +967,9 @@ void HumdrumFileBase::appendLine(HLp line) {
 void HumdrumFileBase::insertLine(int index, const string& line) {
 	HLp s = new HumdrumLine(line);
 	m_lines.insert(m_lines.begin() + index, s);
+	m_analyses.m_slices_analyzed = false;
+	m_analyses.m_references_analyzed = false;
+	m_analyses.m_metric_analyzed = false;
 
 	// Update the line indexes for this line and the following ones:
 	for (int i=index; i<(int)m_lines.size(); i++) {
@@ -885,6 +981,9 @@ void HumdrumFileBase::insertLine(int index, const string& line) {
 void HumdrumFileBase::insertLine(int index, HLp line) {
 	// deletion will be handled by class.
 	m_lines.insert(m_lines.begin() + index, line);
+	m_analyses.m_slices_analyzed = false;
+	m_analyses.m_references_analyzed = false;
+	m_analyses.m_metric_analyzed = false;
 
 	// Update the line indexes for this line and the following ones:
 	for (int i=index; i<(int)m_lines.size(); i++) {
@@ -914,6 +1013,9 @@ void HumdrumFileBase::deleteLine(int index) {
 		m_lines[i-1] = m_lines[i];
 	}
 	m_lines.resize(m_lines.size() - 1);
+	m_analyses.m_slices_analyzed = false;
+	m_analyses.m_references_analyzed = false;
+	m_analyses.m_metric_analyzed = false;
 }
 
 
@@ -930,19 +1032,107 @@ HLp HumdrumFileBase::back(void) {
 
 //////////////////////////////
 //
-// HumdrumFileBase::getReferenceRecords --
+// HumdrumFileBase::analyzeReferenceRecords -- Index the reference records
+//     in the file by key, so that they can be found without checking every
+//     line of the file.  This is done automatically by the reference-record
+//     accessor functions below, and is redone after lines are inserted,
+//     appended or deleted, after the spine structure is analyzed again, and
+//     after the text of a global line or token is changed (see
+//     clearReferenceRecords()).
+//
+
+void HumdrumFileBase::analyzeReferenceRecords(void) {
+	m_referencelines.clear();
+	m_referencekeys.clear();
+	HumdrumFileBase& infile = *this;
+	for (int i=0; i<infile.getLineCount(); i++) {
+		if (!infile[i].isCommentGlobal()) {
+			continue;
+		}
+		if (!infile[i].isReference()) {
+			continue;
+		}
+		m_referencelines.push_back(i);
+		m_referencekeys[infile[i].getReferenceKey()].push_back(i);
+	}
+	m_analyses.m_references_analyzed = true;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::clearReferenceRecords -- Mark the index of reference
+//     records as out of date, so that it is made again when next needed.
+//     Called by HumdrumLine and HumdrumToken when their text changes.
+//
+
+void HumdrumFileBase::clearReferenceRecords(void) {
+	m_analyses.m_references_analyzed = false;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::prepareReferenceRecords -- Index the reference records
+//     if the index is out of date.  The indexed lines are also checked
+//     to still be reference records, in case the text of a line was
+//     changed through the std::string interface.
+//
+
+void HumdrumFileBase::prepareReferenceRecords(void) {
+	if (m_analyses.m_references_analyzed) {
+		for (int i=0; i<(int)m_referencelines.size(); i++) {
+			int index = m_referencelines[i];
+			if ((index >= (int)m_lines.size()) || !m_lines[index]->isReference()) {
+				m_analyses.m_references_analyzed = false;
+				break;
+			}
+		}
+	}
+	if (!m_analyses.m_references_analyzed) {
+		analyzeReferenceRecords();
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::getReferenceRecords -- Return the global and universal
+//     reference records in the file.  If a key is given, then only the
+//     reference records with that key are returned.
 //
 
 vector<HLp> HumdrumFileBase::getReferenceRecords(void) {
+	prepareReferenceRecords();
 	vector<HLp> hlps;
-	hlps.reserve(32);
-	HLp hlp;
-	auto& infile = *this;
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (infile[i].isReference()) {
-			hlp = &infile[i];
-			hlps.push_back(hlp);
+	hlps.reserve(m_referencelines.size());
+	for (int i=0; i<(int)m_referencelines.size(); i++) {
+		hlps.push_back(m_lines[m_referencelines[i]]);
+	}
+	return hlps;
+}
+
+
+vector<HLp> HumdrumFileBase::getReferenceRecords(const string& key) {
+	prepareReferenceRecords();
+	vector<HLp> hlps;
+	auto it = m_referencekeys.find(key);
+	if (it == m_referencekeys.end()) {
+		return hlps;
+	}
+	hlps.reserve(it->second.size());
+	for (int i=0; i<(int)it->second.size(); i++) {
+		HLp hlp = m_lines[it->second[i]];
+		if (hlp->getReferenceKey() != key) {
+			// The text of the line was changed after the index was
+			// made, so make the index again.
+			analyzeReferenceRecords();
+			return getReferenceRecords(key);
 		}
+		hlps.push_back(hlp);
 	}
 	return hlps;
 }
@@ -955,13 +1145,12 @@ vector<HLp> HumdrumFileBase::getReferenceRecords(void) {
 //
 
 vector<HLp> HumdrumFileBase::getGlobalReferenceRecords(void) {
+	prepareReferenceRecords();
 	vector<HLp> hlps;
-	hlps.reserve(32);
-	HLp hlp;
-	auto& infile = *this;
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (infile[i].isGlobalReference()) {
-			hlp = &infile[i];
+	hlps.reserve(m_referencelines.size());
+	for (int i=0; i<(int)m_referencelines.size(); i++) {
+		HLp hlp = m_lines[m_referencelines[i]];
+		if (hlp->isGlobalReference()) {
 			hlps.push_back(hlp);
 		}
 	}
@@ -976,13 +1165,11 @@ vector<HLp> HumdrumFileBase::getGlobalReferenceRecords(void) {
 //
 
 vector<HLp> HumdrumFileBase::getUniversalReferenceRecords(void) {
+	prepareReferenceRecords();
 	vector<HLp> hlps;
-	hlps.reserve(32);
-	HLp hlp;
-	HumdrumFileBase& infile = *this;
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (infile[i].isUniversalReference()) {
-			hlp = &infile[i];
+	for (int i=0; i<(int)m_referencelines.size(); i++) {
+		HLp hlp = m_lines[m_referencelines[i]];
+		if (hlp->isUniversalReference()) {
 			hlps.push_back(hlp);
 		}
 	}
@@ -1147,10 +1334,20 @@ void HumdrumFileBase::getSpineStartList(vector<HTp>& spinestarts,
 		newexinterp = "**";
 		newexinterp += exinterp;
 	}
+	getSpineStartList(spinestarts, HumDataType::findId(newexinterp));
+}
+
+
+void HumdrumFileBase::getSpineStartList(vector<HTp>& spinestarts,
+		int datatype) {
 	spinestarts.reserve(m_trackstarts.size());
 	spinestarts.resize(0);
+	if (datatype < 0) {
+		// data type is not in the registry, so no spines can match.
+		return;
+	}
 	for (int i=1; i<(int)m_trackstarts.size(); i++) {
-		if (newexinterp == *m_trackstarts[i]) {
+		if (m_trackdatatypes[i] == datatype) {
 			spinestarts.push_back(m_trackstarts[i]);
 		}
 	}
@@ -1186,7 +1383,7 @@ void HumdrumFileBase::getSpineStartList(vector<HTp>& spinestarts,
 //
 
 void HumdrumFileBase::getKernSpineStartList(vector<HTp>& spinestarts) {
-	getSpineStartList(spinestarts, "**kern");
+	getSpineStartList(spinestarts, datatype_kern);
 }
 
 vector<HTp> HumdrumFileBase::getKernSpineStartList(void) {
@@ -1448,6 +1645,54 @@ HTp HumdrumFileBase::getTrackStart(int track) const {
 
 
 
+//////////////////////////////
+//
+// HumdrumFileBase::getTrackDataType -- Return the HumDataType ID of the
+//     exclusive interpretation for the given track, such as datatype_kern.
+//     Returns datatype_unknown if the track number is out of range.
+//
+
+int HumdrumFileBase::getTrackDataType(int track) const {
+	if ((track > 0) && (track < (int)m_trackdatatypes.size())) {
+		return m_trackdatatypes[track];
+	} else {
+		return datatype_unknown;
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::getTrackDataTypes -- Return the HumDataType ID of the
+//     exclusive interpretation of each track.  The list is indexed by track
+//     number (index 0 is not used).
+//
+
+const vector<int>& HumdrumFileBase::getTrackDataTypes(void) const {
+	return m_trackdatatypes;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::updateTrackDataType -- Register the exclusive
+//     interpretation of a track again after its text has been changed
+//     (called by HumdrumToken::setText()).
+//
+
+void HumdrumFileBase::updateTrackDataType(int track) {
+	HTp start = getTrackStart(track);
+	if ((start == NULL) || (track >= (int)m_trackdatatypes.size())) {
+		return;
+	}
+	m_trackdatatypes[track] = HumDataType::getId(*start);
+	m_analyses.m_slices_analyzed = false;
+}
+
+
+
 //////////////////////////////
 //
 // HumdrumFileBase::getTrackEndCount -- Return the number of ending tokens
@@ -1710,7 +1955,11 @@ bool HumdrumFileBase::analyzeSpines(void) {
 	vector<string> sinfo;
 	vector<vector<HTp> > lastspine;
 	m_trackstarts.resize(0);
+	m_trackdatatypes.resize(0);
 	m_trackends.resize(0);
+	m_analyses.m_slices_analyzed = false;
+	m_analyses.m_references_analyzed = false;
+	m_analyses.m_metric_analyzed = false;
 	addToTrackStarts(NULL);
 
 	bool init = false;
@@ -1772,17 +2021,22 @@ bool HumdrumFileBase::analyzeSpines(void) {
 //
 // HumdrumFileBase::addToTrackStarts -- A starting exclusive interpretation was
 //    found, so store in the list of track starts.  The first index position
-//    in trackstarts is reserve for non-spine usage.
+//    in trackstarts is reserve for non-spine usage.  The exclusive
+//    interpretation is also registered in HumDataType so that data types
+//    can be compared as integers.
 //
 
 void HumdrumFileBase::addToTrackStarts(HTp token) {
 	if (token == NULL) {
 		m_trackstarts.push_back(NULL);
+		m_trackdatatypes.push_back(datatype_unknown);
 		m_trackends.resize(m_trackends.size()+1);
 	} else if ((m_trackstarts.size() > 1) && (m_trackstarts.back() == NULL)) {
 		m_trackstarts.back() = token;
+		m_trackdatatypes.back() = HumDataType::getId(*token);
 	} else {
 		m_trackstarts.push_back(token);
+		m_trackdatatypes.push_back(HumDataType::getId(*token));
 		m_trackends.resize(m_trackends.size()+1);
 	}
 }
@@ -2504,22 +2758,17 @@ int HumdrumFileBase::getMeasureNumber(int line) {
 
 //////////////////////////////
 //
-// HumdrumFileBase::getReferenceRecord --
+// HumdrumFileBase::getReferenceRecord -- Return the value of the first
+//     reference record with the given key, or an empty string if there
+//     is no such reference record.
 //
 
 std::string HumdrumFileBase::getReferenceRecord(const std::string& key) {
-	HumdrumFileBase& infile = *this;
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (!infile[i].isReference()) {
-			continue;
-		}
-		string refkey = infile[i].getReferenceKey();
-		if (refkey == key) {
-			string value = infile[i].getReferenceValue();
-			return value;
-		}
+	vector<HLp> hlps = getReferenceRecords(key);
+	if (hlps.empty()) {
+		return "";
 	}
-	return "";
+	return hlps[0]->getReferenceValue();
 }
 
 
@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Mon Nov 28 21:19:11 PST 2016
-// Last Modified: Mon Nov 28 21:40:41 PST 2016
+// Last Modified: Sun Oct 18 22:31:07 PDT 2026
 // Filename:      HumdrumFileContent-metlev.cpp
 // URL:           https://github.com/craigsapp/humlib/blob/master/src/HumdrumFileContent-metlev.cpp
 // Syntax:        C++11; humlib
@@ -16,6 +16,11 @@
 //   log2 for smallert rhythmic value levels.  Metric positions above the
 //   beat level have yet to be implemented.
 //
+//   The metric position of each line (measure, beat, ticks from the
+//   barline, the whole/half/quarter-note weight and the metric level) is
+//   calculated once and stored in the file, so that tools which need
+//   the metric position of notes do not have to recalculate it.
+//
 
 #include "Convert.h"
 #include "HumdrumFileContent.h"
@@ -31,7 +36,7 @@ namespace hum {
 
 //////////////////////////////
 //
-// HumdrumFileStructure::getMetricLevels -- Each line in the output
+// HumdrumFileContent::getMetricLevels -- Each line in the output
 //     vector matches to the line of the metric analysis data.
 //     undefined is the value to represent undefined analysis data
 //     (for non-data spines).
@@ -46,17 +51,97 @@ namespace hum {
 void HumdrumFileContent::getMetricLevels(vector<double>& output,
 		int track, double undefined) {
 
-	HumdrumFileStructure& infile = *this;
+	HumdrumFileContent& infile = *this;
 	int lineCount = infile.getLineCount();
 	output.resize(lineCount);
 	fill(output.begin(), output.end(), undefined);
-	vector<HTp> kernspines = infile.getKernSpineStartList();
-	if ((track == 0) && (kernspines.size() > 0)) {
+
+	if ((track == 0) || (track == getMetricTrack())) {
+		for (int i=0; i<lineCount; i++) {
+			if (infile[i].isData()) {
+				output[i] = getMetricPosition(i).level;
+			}
+		}
+		return;
+	}
+
+	vector<HumMetricPosition> positions;
+	fillMetricPositions(positions, track);
+	for (int i=0; i<lineCount; i++) {
+		if (infile[i].isData()) {
+			output[i] = positions[i].level;
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileContent::getMetricTrack -- Return the track used for the
+//     time signatures of the metric positions: the first **kern spine
+//     in the file, or the first spine if there are no **kern spines.
+//
+
+int HumdrumFileContent::getMetricTrack(void) {
+	vector<HTp> kernspines = getKernSpineStartList();
+	int track = 0;
+	if (kernspines.size() > 0) {
 		track = kernspines[0]->getTrack();
 	}
 	if (track == 0) {
 		track = 1;
 	}
+	return track;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileContent::analyzeMetricPositions -- Store the metric position
+//     of each line.  This is done automatically by getMetricPosition(),
+//     and is redone after the rhythm of the file is analyzed again, or
+//     lines are inserted or deleted.
+//
+
+void HumdrumFileContent::analyzeMetricPositions(void) {
+	fillMetricPositions(m_metricpositions, getMetricTrack());
+	m_analyses.m_metric_analyzed = true;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileContent::getMetricPosition -- Return the metric position
+//     of a line, using the time signatures of the first **kern spine.
+//
+
+const HumMetricPosition& HumdrumFileContent::getMetricPosition(int line) {
+	if ((!m_analyses.m_metric_analyzed) ||
+			((int)m_metricpositions.size() != getLineCount())) {
+		analyzeMetricPositions();
+	}
+	return m_metricpositions[line];
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileContent::fillMetricPositions -- Calculate the metric position
+//     of each line, using the time signatures in the given track.
+//
+
+void HumdrumFileContent::fillMetricPositions(vector<HumMetricPosition>& positions,
+		int track) {
+
+	HumdrumFileContent& infile = *this;
+	int lineCount = infile.getLineCount();
+	positions.clear();
+	positions.resize(lineCount);
+	int tpq = infile.tpq();
 
 	int top = 1;                // top number of time signature (0 for no meter)
 	int bot = 4;                // bottom number of time signature
@@ -65,8 +150,14 @@ void HumdrumFileContent::getMetricLevels(vector<double>& output,
 	HumNum measurepos;          // quarter notes from the start of barline
 	HumNum combeatdur;          // for adjusting beat level in compound meters
 	HumNum commeasurepos;       // for adjusting beat level in compound meters
+	int measure = 0;
 
 	for (int i=0; i<lineCount; i++) {
+		HumMetricPosition& position = positions[i];
+		position.measure = measure;
+		if (infile[i].isBarline()) {
+			measure++;
+		}
 		if (infile[i].isInterpretation()) {
 			// check for time signature:
 			HumdrumLine& line = *infile.getLine(i);
@@ -89,35 +180,51 @@ void HumdrumFileContent::getMetricLevels(vector<double>& output,
 				}
 			}
 		}
-		if (!infile[i].isData()) {
-				continue;
+		if (!infile[i].hasSpines()) {
+			continue;
 		}
 
-		measurepos = infile[i].getDurationFromBarline();
+		HumNum durbar = infile[i].getDurationFromBarline();
+		position.ticks = (durbar * tpq).getInteger();
+		if (durbar.isInteger()) {
+			if (durbar.getNumerator() % 4 == 0) {
+				position.weight = 2;
+			} else if (durbar.getNumerator() % 2 == 0) {
+				position.weight = 1;
+			} else {
+				position.weight = 0;
+			}
+		}
 		// Might want to handle cases where the time signature changes in
 		// the middle or a measure...
-		measurepos /= beatdur;
+		measurepos = durbar / beatdur;
+		position.beat = measurepos.getInteger();
+
+		if (!infile[i].isData()) {
+			continue;
+		}
 		int denominator = measurepos.getDenominator();
 		if (compoundQ) {
-			output[i] = Convert::nearIntQuantize(log(denominator) / log(3.0));
-			if ((output[i] != 0.0) && (output[i] != 1.0)) {
+			position.level = Convert::nearIntQuantize(log(denominator) / log(3.0));
+			if ((position.level != 0.0) && (position.level != 1.0)) {
 				// if not the beat or first level, then calculate
 				// levels above level 1.  In 6/8 this means
 				// to move the 8th note level to be the "beat"
 				// and then use binary levels for rhythmic levels
 				// smaller than a beat.
 				combeatdur.setValue(4,bot);
-				commeasurepos = infile[i].getDurationFromBarline() / combeatdur;
+				commeasurepos = durbar / combeatdur;
 				denominator = commeasurepos.getDenominator();
-				output[i] = 1.0 + log(denominator)/log(2.0);
+				position.level = 1.0 + log(denominator)/log(2.0);
 			}
 		} else {
-			output[i] = Convert::nearIntQuantize(log(denominator) / log(2.0));
+			position.level = Convert::nearIntQuantize(log(denominator) / log(2.0));
 		}
 	}
 }
 
 
+
 // END_MERGE
 
 } // end namespace hum
@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Mon Aug 17 02:39:28 PDT 2015
-// Last Modified: Mon Oct  5 23:15:44 PDT 2015
+// Last Modified: Mon Oct 19 00:34:12 PDT 2026
 // Filename:      HumdrumFileContent-slur.cpp
 // URL:           https://github.com/craigsapp/humlib/blob/master/src/HumdrumFileContent-midi.cpp
 // Syntax:        C++11; humlib
@@ -13,6 +13,13 @@
 #include "HumdrumFileContent.h"
 #include "Convert.h"
 
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <set>
+#include <string>
+#include <vector>
+
 using namespace std;
 
 namespace hum {
@@ -70,27 +77,31 @@ void HumdrumFileContent::fillMidiInfo(vector<vector<vector<pair<HTp, int>>>>& tr
 
 void HumdrumFileContent::processStrandNotesForMidi(HTp sstart, HTp send, vector<vector<pair<HTp, int>>>& trackInfo) {
 	HTp current = sstart->getNextToken();
+	string subtoken;
 	while (current && (current != send)) {
 		if (!current->isData() || current->isNull()) {
 			current = current->getNextToken();
 			continue;
 		}
-		vector<string> subtokens = current->getSubtokens();
-		for (int i=0; i<(int)subtokens.size(); i++) {
-			if (subtokens[i] == ".") {
+		// Iterate over subtokens without creating a list of them:
+		HumSubtokenRange subtokens = current->getSubtokenViews();
+		for (auto it = subtokens.begin(); it != subtokens.end(); ++it) {
+			subtoken.assign(*it);
+			int index = it.getIndex();
+			if (subtoken == ".") {
 				// something strange happened (no null tokens expected)
 				continue;
 			}
-			if (subtokens[i].find("r") != string::npos) {
+			if (subtoken.find("r") != string::npos) {
 				// rest, so store in MIDI[0]
 				trackInfo.at(0).emplace_back(current, 0);
-			} else if (subtokens[i].find("R") != string::npos) {
+			} else if (subtoken.find("R") != string::npos) {
 				// unpitched or quasi-pitched note, so store in MIDI[0]
 				trackInfo.at(0).emplace_back(current, 0);
 			} else {
-				int keyno = Convert::kernToMidiNoteNumber(subtokens[i]);
+				int keyno = Convert::kernToMidiNoteNumber(subtoken);
 				if ((keyno >= 0) && (keyno < 128)) {
-					trackInfo.at(keyno).emplace_back(current, i);
+					trackInfo.at(keyno).emplace_back(current, index);
 				}
 			}
 		}
@@ -99,6 +110,248 @@ void HumdrumFileContent::processStrandNotesForMidi(HTp sstart, HTp send, vector<
 }
 
 
+
+//////////////////////////////
+//
+// HumdrumFileContent::getMidiEvents -- Generate note-on, note-off and tempo
+//     (from *MM) events for the **kern spines in the file, and send them to
+//     the callback function in time order.  Tied notes generate a single
+//     note-on/note-off pair: ties are followed through the spine from the
+//     first note, or with the links from analyzeKernTies() for linked ties.
+//     Only currently sounding notes are stored while processing the file,
+//     so long files use little memory.  Returns
+//     the tick time at the end of the file, which can be given as the
+//     tickoffset for the next file when converting a set of concatenated
+//     files into a single MIDI file.
+//
+//     tpq        == ticks per quarter note (0 = use tpq() of the file).
+//     tickoffset == tick time of the start of the file.
+//     velocity   == note-on attack velocity.
+//
+
+int HumdrumFileContent::getMidiEvents(std::function<void(const HumMidiEvent&)> callback,
+		int tpq, int tickoffset, int velocity) {
+	HumdrumFileContent& infile = *this;
+	if (tpq <= 0) {
+		tpq = infile.tpq();
+	}
+
+	auto getTick = [&](HumNum value) {
+		long long top = (long long)value.getNumerator() * tpq;
+		long long bot = value.getDenominator();
+		return tickoffset + (int)((top + bot / 2) / bot);
+	};
+
+	// pending note-offs, earliest first:
+	auto later = [](const HumMidiEvent& a, const HumMidiEvent& b) {
+		return a.tick > b.tick;
+	};
+	std::priority_queue<HumMidiEvent, vector<HumMidiEvent>, decltype(later)> noteoffs(later);
+
+	// Secondary notes of ties (token and subtoken index) which are
+	// already sounding from the first note of the tie:
+	std::set<pair<HTp, int>> tied;
+
+	auto flushEvents = [&](int tick) {
+		while (!noteoffs.empty() && (noteoffs.top().tick <= tick)) {
+			callback(noteoffs.top());
+			noteoffs.pop();
+		}
+	};
+
+	// Return the index of the subtoken in the token that continues a tie
+	// for the given key, or -1 if none:
+	auto findTiedNote = [&](HTp token, int key) {
+		HumSubtokenRange subtokens = token->getSubtokenViews();
+		for (auto it = subtokens.begin(); it != subtokens.end(); ++it) {
+			string_view note = *it;
+			if ((note.find('_') == string_view::npos) &&
+					(note.find(']') == string_view::npos)) {
+				continue;
+			}
+			if (Convert::kernToMidiNoteNumber(string(note)) == key) {
+				return it.getIndex();
+			}
+		}
+		return -1;
+	};
+
+	// Follow a tie from its first note to its last note, and return the
+	// end time of the last note.  Linked ties are followed with the links
+	// from analyzeKernTies(), and other ties with the next tokens in the
+	// spine (including both sides of spine splits).  The secondary notes
+	// are stored in "tied" so that they are not sounded again.
+	auto followTie = [&](HTp token, int index, int key, HumNum endtime) {
+		HTp current = token;
+		int cindex = index;
+		vector<HTp> pending;
+		while (true) {
+			string_view note = current->getSubtokenView(cindex);
+			if ((note.find('[') == string_view::npos) &&
+					(note.find('_') == string_view::npos)) {
+				break;
+			}
+			HTp next = NULL;
+			int nindex = -1;
+			string tag = "tieEnd";
+			if (current->isChord()) {
+				tag += to_string(cindex + 1);
+			}
+			HTp linked = current->getValueHTp("auto", tag);
+			if (linked) {
+				next = linked;
+				nindex = findTiedNote(linked, key);
+			} else {
+				pending.clear();
+				for (int k=0; k<current->getNextTokenCount(); k++) {
+					pending.push_back(current->getNextToken(k));
+				}
+				for (int k=0; k<(int)pending.size(); k++) {
+					HTp tok = pending[k];
+					if (!tok || (std::find(pending.begin(), pending.begin() + k, tok)
+							!= pending.begin() + k)) {
+						continue;
+					}
+					if (tok->isData() && !tok->isNull()) {
+						// The tie can only continue to the next note in
+						// the sub-spine.
+						nindex = findTiedNote(tok, key);
+						if (nindex >= 0) {
+							next = tok;
+							break;
+						}
+						continue;
+					}
+					for (int m=0; m<tok->getNextTokenCount(); m++) {
+						pending.push_back(tok->getNextToken(m));
+					}
+				}
+			}
+			if (!next || (nindex < 0)) {
+				// incomplete tie
+				break;
+			}
+			tied.emplace(next, nindex);
+			note = next->getSubtokenView(nindex);
+			endtime = next->getDurationFromStart() +
+					Convert::recipToDuration(string(note));
+			current = next;
+			cindex = nindex;
+		}
+		return endtime;
+	};
+
+	infile.analyzeKernTies();
+
+	vector<int> trackToKernIndex = infile.getTrackToKernIndex();
+	string subtoken;
+
+	for (int i=0; i<infile.getLineCount(); i++) {
+		HumdrumLine& line = infile[i];
+		if (!line.hasSpines()) {
+			continue;
+		}
+		bool interpQ = line.isInterpretation();
+		if (!(interpQ || line.isData())) {
+			continue;
+		}
+		HumNum starttime = line.getDurationFromStart();
+		int tick = getTick(starttime);
+		flushEvents(tick);
+
+		if (interpQ) {
+			for (int j=0; j<line.getFieldCount(); j++) {
+				HTp token = line.token(j);
+				if (!token->isKern()) {
+					continue;
+				}
+				if ((token->compare(0, 3, "*MM") != 0) || (token->size() < 4) ||
+						!isdigit(token->at(3))) {
+					continue;
+				}
+				HumMidiEvent event;
+				event.tick  = tick;
+				event.tempo = std::stod(token->substr(3));
+				callback(event);
+				break;
+			}
+			continue;
+		}
+
+		for (int j=0; j<line.getFieldCount(); j++) {
+			HTp token = line.token(j);
+			if (!token->isKern() || token->isNull()) {
+				continue;
+			}
+			int track = trackToKernIndex.at(token->getTrack());
+			int channel = track % 15;
+			if (channel >= 9) {
+				// skip the General MIDI percussion channel
+				channel++;
+			}
+
+			// Iterate over the notes in the token without creating
+			// a list of subtokens:
+			int sindex = 0;
+			size_t start = 0;
+			while (start <= token->size()) {
+				size_t end = token->find(' ', start);
+				if (end == string::npos) {
+					end = token->size();
+				}
+				subtoken.assign(*token, start, end - start);
+				start = end + 1;
+				int index = sindex++;
+
+				if (subtoken.find_first_of("rRqQ") != string::npos) {
+					// rests, unpitched notes and grace notes
+					continue;
+				}
+				int key = Convert::kernToMidiNoteNumber(subtoken);
+				if ((key < 0) || (key > 127)) {
+					continue;
+				}
+				HumNum duration = Convert::recipToDuration(subtoken);
+
+				if (tied.erase(make_pair(token, index))) {
+					// secondary note of a tie which is already sounding
+					continue;
+				}
+				HumNum endtime = starttime + duration;
+				if ((subtoken.find('[') != string::npos) ||
+						(subtoken.find('_') != string::npos)) {
+					// (A tie middle without a start is treated as a start
+					// of a tie, such as at the start of a segment.)
+					endtime = followTie(token, index, key, endtime);
+				}
+
+				HumMidiEvent event;
+				event.tick     = tick;
+				event.track    = track;
+				event.channel  = channel;
+				event.key      = key;
+				event.velocity = velocity;
+				event.token    = token;
+				event.subtoken = index;
+				callback(event);
+
+				event.tick     = getTick(endtime);
+				event.velocity = 0;
+				noteoffs.push(event);
+			}
+		}
+	}
+
+	int endtick = getTick(infile.getScoreDuration());
+	while (!noteoffs.empty()) {
+		callback(noteoffs.top());
+		noteoffs.pop();
+	}
+
+	return endtick;
+}
+
+
 // END_MERGE
 
 } // end namespace hum
@@ -0,0 +1,550 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 11:40:05 PDT 2026
+// Last Modified: Sun Oct 18 13:05:31 PDT 2026
+// Filename:      HumdrumFileContent-notation.cpp
+// URL:           https://github.com/craigsapp/humlib/blob/master/src/HumdrumFileContent-notation.cpp
+// Syntax:        C++11; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Combined slur, phrase, beam, tie and accidental analysis
+//                in a single sweep through the data lines, as well as the
+//                marker-linking functions shared with the separate analyses.
+//
+
+#include "HumdrumFileContent.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace hum {
+
+// START_MERGE
+
+
+
+//////////////////////////////
+//
+// HumdrumFileContent::analyzeNotation -- Do the same analyses as
+//    analyzeSlurs(), analyzePhrasings(), analyzeBeams(), analyzeKernTies()
+//    and analyzeKernAccidentals(), but visit each data token only once.
+//    Slur, phrase and beam analyses that were already done are skipped.
+//    The results are identical to calling the separate functions.
+//
+
+bool HumdrumFileContent::analyzeNotation(void) {
+	bool slurQ   = !m_analyses.m_slurs_analyzed;
+	bool phraseQ = !m_analyses.m_phrases_analyzed;
+	bool beamQ   = !m_analyses.m_beams_analyzed;
+	m_analyses.m_slurs_analyzed   = true;
+	m_analyses.m_phrases_analyzed = true;
+	m_analyses.m_beams_analyzed   = true;
+
+	HumdrumFileContent& infile = *this;
+	string linkSignifier = m_signifiers.getKernLinkSignifier();
+
+	vector<pair<HTp, HTp>> labels;
+	vector<int> endings;
+	if (slurQ || phraseQ || beamQ) {
+		getLabelSequence(labels, endings);
+	}
+
+	// spinetype == 1 for **kern tracks, 2 for **mens tracks, 0 otherwise.
+	int maxtrack = getMaxTrack();
+	vector<int> spinetype(maxtrack + 1, 0);
+	vector<HTp> kernspines;
+	vector<HTp> mensspines;
+	getSpineStartList(kernspines, "**kern");
+	getSpineStartList(mensspines, "**mens");
+	for (int i=0; i<(int)kernspines.size(); i++) {
+		spinetype[kernspines[i]->getTrack()] = 1;
+	}
+	for (int i=0; i<(int)mensspines.size(); i++) {
+		spinetype[mensspines[i]->getTrack()] = 2;
+	}
+
+	vector<SpanState> slurs(maxtrack + 1, SpanState('(', linkSignifier));
+	vector<SpanState> phrases(maxtrack + 1, SpanState('{', linkSignifier));
+	vector<SpanState> beams(maxtrack + 1, SpanState('L', linkSignifier));
+
+	TieState ties(linkSignifier);
+	bool tieQ = !linkSignifier.empty();
+
+	// ottava marks must be analyzed before accidentals:
+	this->analyzeOttavas();
+	AccidentalState accidentals;
+	bool accidentalQ = prepareAccidentalState(accidentals, "**kern");
+
+	vector<int> layers(maxtrack + 1, 0);
+	vector<string> subtokens;
+	for (int i=0; i<infile.getLineCount(); i++) {
+		if (!infile[i].hasSpines()) {
+			continue;
+		}
+		if (accidentalQ) {
+			if (!startAccidentalLine(infile[i], accidentals)) {
+				continue;
+			}
+		} else if (!infile[i].isData()) {
+			continue;
+		}
+		std::fill(layers.begin(), layers.end(), 0);
+
+		for (int j=0; j<infile[i].getFieldCount(); j++) {
+			HTp token = infile.token(i, j);
+			int track = token->getTrack();
+			int layer = layers[track]++;
+			int type = spinetype[track];
+			if (type == 0) {
+				continue;
+			}
+			if (token->isNull()) {
+				continue;
+			}
+
+			int slurstarts   = 0;
+			int slurends     = 0;
+			int phrasestarts = 0;
+			int phraseends   = 0;
+			int beamstarts   = 0;
+			int beamends     = 0;
+			for (int k=0; k<(int)token->size(); k++) {
+				switch (token->at(k)) {
+					case '(': slurstarts++;   break;
+					case ')': slurends++;     break;
+					case '{': phrasestarts++; break;
+					case '}': phraseends++;   break;
+					case 'L': beamstarts++;   break;
+					case 'J': beamends++;     break;
+				}
+			}
+			if (slurQ && (slurstarts || slurends)) {
+				analyzeSpanMarkers(token, layer, slurstarts, slurends, slurs[track],
+						labels, endings);
+			}
+			if (phraseQ && (type == 1) && (phrasestarts || phraseends)) {
+				analyzeSpanMarkers(token, layer, phrasestarts, phraseends, phrases[track],
+						labels, endings);
+			}
+			if (beamQ && (beamstarts || beamends)) {
+				analyzeSpanMarkers(token, layer, beamstarts, beamends, beams[track],
+						labels, endings);
+			}
+
+			if (type != 1) {
+				continue;
+			}
+			if (token->isRest()) {
+				continue;
+			}
+			if (!(tieQ || accidentalQ)) {
+				continue;
+			}
+			splitSubtokens(token, subtokens);
+			if (tieQ) {
+				analyzeKernTieToken(token, subtokens, ties);
+			}
+			if (accidentalQ) {
+				analyzeAccidentalToken(token, subtokens, accidentals);
+			}
+		}
+		if (accidentalQ) {
+			std::fill(accidentals.firstinbar.begin(), accidentals.firstinbar.end(), 0);
+		}
+	}
+
+	// Link markers in the same order as the separate analyses: unclosed
+	// markers first, then linked markers in spine order for **kern spines
+	// followed by **mens spines.
+	for (int stype=1; stype<=2; stype++) {
+		vector<HTp> slurstarts;
+		vector<HTp> slurends;
+		vector<HTp> beamstarts;
+		vector<HTp> beamends;
+		vector<HTp> phrasestarts;
+		vector<HTp> phraseends;
+		vector<HTp>& spines = (stype == 1) ? kernspines : mensspines;
+		for (int i=0; i<(int)spines.size(); i++) {
+			int track = spines[i]->getTrack();
+			if (slurQ) {
+				markHangingSpans(slurs[track]);
+				slurstarts.insert(slurstarts.end(), slurs[track].linkstarts.begin(),
+						slurs[track].linkstarts.end());
+				slurends.insert(slurends.end(), slurs[track].linkends.begin(),
+						slurs[track].linkends.end());
+			}
+			if (phraseQ && (stype == 1)) {
+				markHangingSpans(phrases[track]);
+				phrasestarts.insert(phrasestarts.end(), phrases[track].linkstarts.begin(),
+						phrases[track].linkstarts.end());
+				phraseends.insert(phraseends.end(), phrases[track].linkends.begin(),
+						phrases[track].linkends.end());
+			}
+			if (beamQ) {
+				markHangingSpans(beams[track]);
+				beamstarts.insert(beamstarts.end(), beams[track].linkstarts.begin(),
+						beams[track].linkstarts.end());
+				beamends.insert(beamends.end(), beams[track].linkends.begin(),
+						beams[track].linkends.end());
+			}
+		}
+		createLinkedSlurs(slurstarts, slurends);
+		createLinkedPhrasings(phrasestarts, phraseends);
+		createLinkedBeams(beamstarts, beamends);
+	}
+	createLinkedTies(ties.linkstarts, ties.linkends);
+
+	if (accidentalQ) {
+		infile.setValue("auto", "accidentalAnalysis**kern", "true");
+	}
+
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileContent::analyzeSpans -- Link the slur, phrase or beam
+//     markers (depending on the opener character) within each of the
+//     given spines.  The spines are independent, so they are analyzed in
+//     parallel if setAnalysisThreads() is greater than one.  Linked
+//     markers, which cross spines, are returned in spine order.
+//
+
+void HumdrumFileContent::analyzeSpans(vector<HTp>& spines, char opener,
+		vector<HTp>& linkstarts, vector<HTp>& linkends) {
+	vector<pair<HTp, HTp>> labels; // first is previous label, second is next label
+	vector<int> endings;
+	getLabelSequence(labels, endings);
+
+	string linkSignifier = m_signifiers.getKernLinkSignifier();
+	vector<SpanState> states(spines.size(), SpanState(opener, linkSignifier));
+	runParallel((int)spines.size(), [&](int index) {
+		analyzeSpineSpans(spines[index], states[index], labels, endings);
+	});
+
+	for (int i=0; i<(int)states.size(); i++) {
+		linkstarts.insert(linkstarts.end(), states[i].linkstarts.begin(),
+				states[i].linkstarts.end());
+		linkends.insert(linkends.end(), states[i].linkends.begin(),
+				states[i].linkends.end());
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileContent::analyzeSpineSpans -- Link the slur, phrase or beam
+//     markers in a single spine, and then mark unclosed starts.  Only tokens
+//     in the spine are modified.
+//
+
+void HumdrumFileContent::analyzeSpineSpans(HTp spinestart, SpanState& state,
+		vector<pair<HTp, HTp>>& labels, vector<int>& endings) {
+	// tracktokens == the 2-D data list for the track,
+	// arranged in layers with the second dimension.
+	vector<vector<HTp> > tracktokens;
+	this->getTrackSeq(tracktokens, spinestart, OPT_DATA | OPT_NOEMPTY);
+
+	HTp token;
+	for (int row=0; row<(int)tracktokens.size(); row++) {
+		for (int layer=0; layer<(int)tracktokens[row].size(); layer++) {
+			token = tracktokens[row][layer];
+			if (!token->isData()) {
+				continue;
+			}
+			if (token->isNull()) {
+				continue;
+			}
+			int opencount = (int)count(token->begin(), token->end(), state.open);
+			int closecount = (int)count(token->begin(), token->end(), state.close);
+			analyzeSpanMarkers(token, layer, opencount, closecount, state, labels, endings);
+		}
+	}
+
+	markHangingSpans(state);
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileContent::getLabelSequence -- Find the previous and next
+//     expansion label for each line, as well as the ending number that
+//     each line is in (0 if not in a numbered ending).
+//
+
+void HumdrumFileContent::getLabelSequence(vector<pair<HTp, HTp>>& labels,
+		vector<int>& endings) {
+	HumdrumFileBase& infile = *this;
+	vector<HTp> l(infile.getLineCount(), NULL);
+	labels.resize(infile.getLineCount());
+	for (int i=0; i<infile.getLineCount(); i++) {
+		labels[i].first = NULL;
+		labels[i].second = NULL;
+	}
+	for (int i=0; i<infile.getLineCount(); i++) {
+		if (!infile[i].isInterpretation()) {
+			continue;
+		}
+		HTp token = infile.token(i, 0);
+		if ((token->compare(0, 2, "*>") == 0) && (token->find("[") == std::string::npos)) {
+			l[i] = token;
+		}
+	}
+	HTp current = NULL;
+	for (int i=0; i<infile.getLineCount(); i++) {
+		if (l[i] != NULL) {
+			current = l[i];
+		}
+		labels[i].first = current;
+	}
+	current = NULL;
+	for (int i=infile.getLineCount() - 1; i>=0; i--) {
+		if (l[i] != NULL) {
+			current = l[i];
+		}
+		labels[i].second = current;
+	}
+
+	endings.resize(infile.getLineCount());
+	int ending = 0;
+	for (int i=0; i<(int)endings.size(); i++) {
+		if (l[i]) {
+			char lastchar = l[i]->back();
+			if (isdigit(lastchar)) {
+				ending = lastchar - '0';
+			} else {
+				ending = 0;
+			}
+		}
+		endings[i] = ending;
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileContent::SpanState::SpanState -- Prepare the bookkeeping for
+//     slurs (opener '('), phrases ('{') or beams ('L').
+//
+
+HumdrumFileContent::SpanState::SpanState(char opener, const string& linksig) {
+	open = opener;
+	if (opener == '(') {
+		close  = ')';
+		name   = "Slur";
+		prefix = "slur";
+	} else if (opener == '{') {
+		close  = '}';
+		name   = "Phrase";
+		prefix = "phrase";
+	} else {
+		close  = 'J';
+		name   = "Beam";
+		prefix = "beam";
+	}
+	// linked markers handled separately, so generate an ignore sequence:
+	ignorebegin = linksig + open;
+	ignoreend   = linksig + close;
+	opens.resize(4); // maximum of 4 elision levels
+	for (int i=0; i<(int)opens.size(); i++) {
+		opens[i].resize(8);  // 8 layers, expanded if necessary
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileContent::analyzeSpanMarkers -- Process the slur, phrase or
+//     beam markers on a data token (depending on the state's opener).
+//     Closing markers are processed before opening markers.  The layer
+//     is the index of the token among the tokens of its spine on the line.
+//
+
+void HumdrumFileContent::analyzeSpanMarkers(HTp token, int layer, int opencount,
+		int closecount, SpanState& state, vector<pair<HTp, HTp>>& labels,
+		vector<int>& endings) {
+	vector<vector<vector<HTp>>>& opens = state.opens;
+	int elision;
+
+	for (int i=0; i<closecount; i++) {
+		bool isLinked;
+		if (state.open == '(') {
+			isLinked = isLinkedSlurEnd(token, i, state.ignoreend);
+		} else if (state.open == '{') {
+			isLinked = isLinkedPhraseEnd(token, i, state.ignoreend);
+		} else {
+			isLinked = isLinkedBeamEnd(token, i, state.ignoreend);
+		}
+		if (isLinked) {
+			state.linkends.push_back(token);
+			continue;
+		}
+		if (state.open == '(') {
+			elision = token->getSlurEndElisionLevel(i);
+		} else if (state.open == '{') {
+			elision = token->getPhraseEndElisionLevel(i);
+		} else {
+			elision = token->getBeamEndElisionLevel(i);
+		}
+		if ((elision < 0) || (elision >= (int)opens.size())) {
+			continue;
+		}
+		if (layer >= (int)opens[elision].size()) {
+			opens[elision].resize(layer + 1);
+		}
+		if (opens[elision][layer].size() > 0) {
+			linkSpanEndpoints(opens[elision][layer].back(), token, state.open);
+			// remove opening from buffer
+			opens[elision][layer].pop_back();
+			continue;
+		}
+
+		// No starting marker to match to this end in the given layer.
+		// search for an open marker in another layer:
+		bool found = false;
+		for (int ilayer=0; ilayer<(int)opens[elision].size(); ilayer++) {
+			if (opens[elision][ilayer].size() > 0) {
+				linkSpanEndpoints(opens[elision][ilayer].back(), token, state.open);
+				// remove opening from buffer
+				opens[elision][ilayer].pop_back();
+				found = true;
+				break;
+			}
+		}
+		if (found) {
+			continue;
+		}
+
+		int lineindex = token->getLineIndex();
+		int endnum = endings[lineindex];
+		int pindex = -1;
+		if (labels[lineindex].first) {
+			pindex = labels[lineindex].first->getLineIndex();
+			pindex--;
+		}
+		int endnumpre = -1;
+		if (pindex >= 0) {
+			endnumpre = endings[pindex];
+		}
+
+		if ((endnumpre > 0) && (endnum > 0) && (endnumpre != endnum)) {
+			// This is a marker in an ending that start at the start of an ending.
+			token->setValue("auto", "ending" + state.name + "Back", "true");
+			token->setValue("auto", state.prefix + "Side", "stop");
+			token->setValue("auto", state.prefix + "Duration",
+				token->getDurationToEnd());
+		} else {
+			// This is a closing that does not have a matching opening.
+			token->setValue("auto", "hanging" + state.name, "true");
+			token->setValue("auto", state.prefix + "Side", "stop");
+			token->setValue("auto", state.prefix + "OpenIndex", to_string(i));
+			token->setValue("auto", state.prefix + "Duration",
+				token->getDurationToEnd());
+		}
+	}
+
+	for (int i=0; i<opencount; i++) {
+		bool isLinked;
+		if (state.open == '(') {
+			isLinked = isLinkedSlurBegin(token, i, state.ignorebegin);
+		} else if (state.open == '{') {
+			isLinked = isLinkedPhraseBegin(token, i, state.ignorebegin);
+		} else {
+			isLinked = isLinkedBeamBegin(token, i, state.ignorebegin);
+		}
+		if (isLinked) {
+			state.linkstarts.push_back(token);
+			continue;
+		}
+		if (state.open == '(') {
+			elision = token->getSlurStartElisionLevel(i);
+		} else if (state.open == '{') {
+			elision = token->getPhraseStartElisionLevel(i);
+		} else {
+			elision = token->getBeamStartElisionLevel(i);
+		}
+		if ((elision < 0) || (elision >= (int)opens.size())) {
+			continue;
+		}
+		if (layer >= (int)opens[elision].size()) {
+			opens[elision].resize(layer + 1);
+		}
+		opens[elision][layer].push_back(token);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileContent::markHangingSpans -- Mark slur, phrase or beam
+//     starts that were never closed.
+//
+
+void HumdrumFileContent::markHangingSpans(SpanState& state) {
+	vector<vector<vector<HTp>>>& opens = state.opens;
+	for (int i=0; i<(int)opens.size(); i++) {
+		for (int j=0; j<(int)opens[i].size(); j++) {
+			for (int k=0; k<(int)opens[i][j].size(); k++) {
+				opens[i][j][k]->setValue("", "auto", "hanging" + state.name, "true");
+				opens[i][j][k]->setValue("", "auto", state.prefix + "Side", "start");
+				opens[i][j][k]->setValue("", "auto", state.prefix + "Duration",
+						opens[i][j][k]->getDurationFromStart());
+			}
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileContent::linkSpanEndpoints -- Link the start and end of a
+//     slur, phrase or beam.
+//
+
+void HumdrumFileContent::linkSpanEndpoints(HTp start, HTp end, char opener) {
+	if (opener == '(') {
+		linkSlurEndpoints(start, end);
+	} else if (opener == '{') {
+		linkPhraseEndpoints(start, end);
+	} else {
+		linkBeamEndpoints(start, end);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileContent::splitSubtokens -- Split a token into its
+//     space-separated subtokens, equivalent to calling getSubtoken() for
+//     each index up to getSubtokenCount().
+//
+
+void HumdrumFileContent::splitSubtokens(HTp token, vector<string>& subtokens) {
+	subtokens.clear();
+	size_t start = 0;
+	size_t loc;
+	while ((loc = token->find(' ', start)) != string::npos) {
+		subtokens.emplace_back(*token, start, loc - start);
+		start = loc + 1;
+	}
+	subtokens.emplace_back(*token, start);
+}
+
+
+
+// END_MERGE
+
+} // end namespace hum
+
+
+
@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Fri Dec  6 19:09:35 PST 2019
-// Last Modified: Fri Dec  6 19:09:39 PST 2019
+// Last Modified: Sun Oct 18 14:20:12 PDT 2026
 // Filename:      HumdrumFileContent-phrase.cpp
 // URL:           https://github.com/craigsapp/humlib/blob/master/src/HumdrumFileContent-phrase.cpp
 // Syntax:        C++11; humlib
@@ -49,198 +49,21 @@ bool HumdrumFileContent::analyzePhrasings(void) {
 bool HumdrumFileContent::analyzeKernPhrasings(void) {
 	vector<HTp> phrasestarts;
 	vector<HTp> phraseends;
-
-	vector<HTp> l;
-	vector<pair<HTp, HTp>> labels; // first is previous label, second is next label
-	HumdrumFileBase& infile = *this;
-	labels.resize(infile.getLineCount());
-	l.resize(infile.getLineCount());
-	for (int i=0; i<infile.getLineCount(); i++) {
-		labels[i].first = NULL;
-		labels[i].second = NULL;
-		l[i] = NULL;
-	}
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (!infile[i].isInterpretation()) {
-			continue;
-		}
-		HTp token = infile.token(i, 0);
-		if ((token->compare(0, 2, "*>") == 0) && (token->find("[") == std::string::npos)) {
-			l[i] = token;
-		}
-	}
-	HTp current = NULL;
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (l[i] != NULL) {
-			current = l[i];
-		}
-		labels[i].first = current;
-	}
-	current = NULL;
-	for (int i=infile.getLineCount() - 1; i>=0; i--) {
-		if (l[i] != NULL) {
-			current = l[i];
-		}
-		labels[i].second = current;
-	}
-
-	vector<int> endings(infile.getLineCount(), 0);
-	int ending = 0;
-	for (int i=0; i<(int)endings.size(); i++) {
-		if (l[i]) {
-			char lastchar = l[i]->back();
-			if (isdigit(lastchar)) {
-				ending = lastchar - '0';
-			} else {
-				ending = 0;
-			}
-		}
-		endings[i] = ending;
-	}
-
 	vector<HTp> kernspines;
 	getSpineStartList(kernspines, "**kern");
-	bool output = true;
-	string linkSignifier = m_signifiers.getKernLinkSignifier();
-	for (int i=0; i<(int)kernspines.size(); i++) {
-		output = output && analyzeKernPhrasings(kernspines[i], phrasestarts, phraseends, labels, endings, linkSignifier);
-	}
-
+	analyzeSpans(kernspines, '{', phrasestarts, phraseends);
 	createLinkedPhrasings(phrasestarts, phraseends);
-	return output;
+	return true;
 }
 
 
 bool HumdrumFileContent::analyzeKernPhrasings(HTp spinestart,
 		vector<HTp>& linkstarts, vector<HTp>& linkends, vector<pair<HTp, HTp>>& labels,
 		vector<int>& endings, const string& linksig) {
-
-	// linked phrases handled separately, so generate an ignore sequence:
-	string ignorebegin = linksig + "{";
-	string ignoreend = linksig + "}";
-
-	// tracktokens == the 2-D data list for the track,
-	// arranged in layers with the second dimension.
-	vector<vector<HTp> > tracktokens;
-	this->getTrackSeq(tracktokens, spinestart, OPT_DATA | OPT_NOEMPTY);
-	// printSequence(tracktokens);
-
-	// phraseopens == list of phrase openings for each track and elision level
-	// first dimension: elision level
-	// second dimension: track number
-	vector<vector<vector<HTp>>> phraseopens;
-
-	phraseopens.resize(4); // maximum of 4 elision levels
-	for (int i=0; i<(int)phraseopens.size(); i++) {
-		phraseopens[i].resize(8);  // maximum of 8 layers
-	}
-
-	int opencount = 0;
-	int closecount = 0;
-	int elision = 0;
-	HTp token;
-	for (int row=0; row<(int)tracktokens.size(); row++) {
-		for (int track=0; track<(int)tracktokens[row].size(); track++) {
-			token = tracktokens[row][track];
-			if (!token->isData()) {
-				continue;
-			}
-			if (token->isNull()) {
-				continue;
-			}
-			opencount = (int)count(token->begin(), token->end(), '{');
-			closecount = (int)count(token->begin(), token->end(), '}');
-
-			for (int i=0; i<closecount; i++) {
-				bool isLinked = isLinkedPhraseEnd(token, i, ignoreend);
-				if (isLinked) {
-					linkends.push_back(token);
-					continue;
-				}
-				elision = token->getPhraseEndElisionLevel(i);
-				if (elision < 0) {
-					continue;
-				}
-				if (phraseopens[elision][track].size() > 0) {
-					linkPhraseEndpoints(phraseopens[elision][track].back(), token);
-					// remove phrase opening from buffer
-					phraseopens[elision][track].pop_back();
-				} else {
-					// No starting phrase marker to match to this phrase end in the
-					// given track.
-					// search for an open phrase in another track:
-					bool found = false;
-					for (int itrack=0; itrack<(int)phraseopens[elision].size(); itrack++) {
-						if (phraseopens[elision][itrack].size() > 0) {
-							linkPhraseEndpoints(phraseopens[elision][itrack].back(), token);
-							// remove phrase opening from buffer
-							phraseopens[elision][itrack].pop_back();
-							found = true;
-							break;
-						}
-					}
-					if (!found) {
-						int lineindex = token->getLineIndex();
-						int endnum = endings[lineindex];
-						int pindex = -1;
-						if (labels[lineindex].first) {
-							pindex = labels[lineindex].first->getLineIndex();
-							pindex--;
-						}
-						int endnumpre = -1;
-						if (pindex >= 0) {
-							endnumpre = endings[pindex];
-						}
-
-						if ((endnumpre > 0) && (endnum > 0) && (endnumpre != endnum)) {
-							// This is a phrase in an ending that start at the start of an ending.
-							HumNum duration = token->getDurationFromStart();
-							if (labels[token->getLineIndex()].first) {
-								duration -= labels[token->getLineIndex()].first->getDurationFromStart();
-							}
-							token->setValue("auto", "endingPhraseBack", "true");
-							token->setValue("auto", "phraseSide", "stop");
-							token->setValue("auto", "phraseDuration",
-								token->getDurationToEnd());
-						} else {
-							// This is a phrase closing that does not have a matching opening.
-							token->setValue("auto", "hangingPhrase", "true");
-							token->setValue("auto", "phraseSide", "stop");
-							token->setValue("auto", "phraseOpenIndex", to_string(i));
-							token->setValue("auto", "phraseDuration",
-								token->getDurationToEnd());
-						}
-					}
-				}
-			}
-
-			for (int i=0; i<opencount; i++) {
-				bool isLinked = isLinkedPhraseBegin(token, i, ignorebegin);
-				if (isLinked) {
-					linkstarts.push_back(token);
-					continue;
-				}
-				elision = token->getPhraseStartElisionLevel(i);
-				if (elision < 0) {
-					continue;
-				}
-				phraseopens[elision][track].push_back(token);
-			}
-		}
-	}
-
-	// Mark un-closed phrase starts:
-	for (int i=0; i<(int)phraseopens.size(); i++) {
-		for (int j=0; j<(int)phraseopens[i].size(); j++) {
-			for (int k=0; k<(int)phraseopens[i][j].size(); k++) {
-				phraseopens[i][j][k]->setValue("", "auto", "hangingPhrase", "true");
-				phraseopens[i][j][k]->setValue("", "auto", "phraseSide", "start");
-				phraseopens[i][j][k]->setValue("", "auto", "phraseDuration",
-						phraseopens[i][j][k]->getDurationFromStart());
-			}
-		}
-	}
-
+	SpanState state('{', linksig);
+	analyzeSpineSpans(spinestart, state, labels, endings);
+	linkstarts.insert(linkstarts.end(), state.linkstarts.begin(), state.linkstarts.end());
+	linkends.insert(linkends.end(), state.linkends.begin(), state.linkends.end());
 	return true;
 }
 
@@ -0,0 +1,138 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 18:20:44 PDT 2026
+// Last Modified: Sun Oct 18 18:52:10 PDT 2026
+// Filename:      HumdrumFileContent-slice.cpp
+// URL:           https://github.com/craigsapp/humlib/blob/master/src/HumdrumFileContent-slice.cpp
+// Syntax:        C++11; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Precomputed lists of the **kern fields on each line, so
+//                that tools can visit only the columns they need without
+//                checking the data type of every token.  The data type of
+//                each track is available as an integer ID from
+//                HumdrumFileBase::getTrackDataType().
+//
+//                Example of iterating over the **kern tokens of a file:
+//                   for (int i=0; i<infile.getLineCount(); i++) {
+//                      for (int j : infile.getKernFieldIndexes(i)) {
+//                         HTp token = infile.token(i, j);
+//                         int kernspine = infile.getFieldKernSpine(i, j);
+//                      }
+//                   }
+//
+
+#include "HumdrumFileContent.h"
+
+using namespace std;
+
+namespace hum {
+
+// START_MERGE
+
+
+
+//////////////////////////////
+//
+// HumdrumFileContent::analyzeSlices -- Store the **kern fields of each
+//     line.  This is done automatically by the accessor functions below,
+//     and is redone after the spine structure is analyzed again, lines
+//     are inserted or deleted, or an exclusive interpretation is changed.
+//
+
+void HumdrumFileContent::analyzeSlices(void) {
+	HumdrumFileContent& infile = *this;
+	int maxtrack = infile.getMaxTrack();
+
+	vector<int> trackToKernIndex(maxtrack + 1, -1);
+	int kernindex = 0;
+	for (int track=1; track<=maxtrack; track++) {
+		if (infile.getTrackDataType(track) == datatype_kern) {
+			trackToKernIndex[track] = kernindex++;
+		}
+	}
+
+	m_kernfields.resize(infile.getLineCount());
+	m_fieldkernspine.resize(infile.getLineCount());
+	for (int i=0; i<infile.getLineCount(); i++) {
+		m_kernfields[i].clear();
+		m_fieldkernspine[i].clear();
+		if (!infile[i].hasSpines()) {
+			continue;
+		}
+		int fieldcount = infile[i].getFieldCount();
+		m_fieldkernspine[i].resize(fieldcount, -1);
+		for (int j=0; j<fieldcount; j++) {
+			int track = infile.token(i, j)->getTrack();
+			if ((track < 1) || (track > maxtrack)) {
+				continue;
+			}
+			int kernspine = trackToKernIndex[track];
+			if (kernspine < 0) {
+				continue;
+			}
+			m_kernfields[i].push_back(j);
+			m_fieldkernspine[i][j] = kernspine;
+		}
+	}
+
+	m_analyses.m_slices_analyzed = true;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileContent::getKernFieldIndexes -- Return the field indexes of
+//     the **kern tokens on a line, in left-to-right order.  Lines without
+//     spines return an empty list.
+//
+
+const vector<int>& HumdrumFileContent::getKernFieldIndexes(int line) {
+	if (!m_analyses.m_slices_analyzed) {
+		analyzeSlices();
+	}
+	return m_kernfields[line];
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileContent::getFieldToKernSpine -- Return a list with an entry
+//     for each field on the line, which is the **kern spine index of the
+//     field (its position in getKernSpineStartList()), or -1 if the field
+//     is not **kern.
+//
+
+const vector<int>& HumdrumFileContent::getFieldToKernSpine(int line) {
+	if (!m_analyses.m_slices_analyzed) {
+		analyzeSlices();
+	}
+	return m_fieldkernspine[line];
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileContent::getFieldKernSpine -- Return the **kern spine index
+//     of a field, or -1 if the field is not **kern.
+//
+
+int HumdrumFileContent::getFieldKernSpine(int line, int field) {
+	const vector<int>& kernspines = getFieldToKernSpine(line);
+	if ((field < 0) || (field >= (int)kernspines.size())) {
+		return -1;
+	}
+	return kernspines[field];
+}
+
+
+
+// END_MERGE
+
+} // end namespace hum
+
+
+
@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Mon Aug 17 02:39:28 PDT 2015
-// Last Modified: Mon Oct  5 23:15:44 PDT 2015
+// Last Modified: Sun Oct 18 14:20:12 PDT 2026
 // Filename:      HumdrumFileContent-slur.cpp
 // URL:           https://github.com/craigsapp/humlib/blob/master/src/HumdrumFileContent-slur.cpp
 // Syntax:        C++11; humlib
@@ -51,64 +51,11 @@ bool HumdrumFileContent::analyzeSlurs(void) {
 bool HumdrumFileContent::analyzeMensSlurs(void) {
 	vector<HTp> slurstarts;
 	vector<HTp> slurends;
-
-	vector<HTp> l;
-	vector<pair<HTp, HTp>> labels; // first is previous label, second is next label
-	HumdrumFileBase& infile = *this;
-	labels.resize(infile.getLineCount());
-	l.resize(infile.getLineCount());
-	for (int i=0; i<infile.getLineCount(); i++) {
-		labels[i].first = NULL;
-		labels[i].second = NULL;
-		l[i] = NULL;
-	}
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (!infile[i].isInterpretation()) {
-			continue;
-		}
-		HTp token = infile.token(i, 0);
-		if ((token->compare(0, 2, "*>") == 0) && (token->find("[") == std::string::npos)) {
-			l[i] = token;
-		}
-	}
-	HTp current = NULL;
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (l[i] != NULL) {
-			current = l[i];
-		}
-		labels[i].first = current;
-	}
-	current = NULL;
-	for (int i=infile.getLineCount() - 1; i>=0; i--) {
-		if (l[i] != NULL) {
-			current = l[i];
-		}
-		labels[i].second = current;
-	}
-
-	vector<int> endings(infile.getLineCount(), 0);
-	int ending = 0;
-	for (int i=0; i<(int)endings.size(); i++) {
-		if (l[i]) {
-			char lastchar = l[i]->back();
-			if (isdigit(lastchar)) {
-				ending = lastchar - '0';
-			} else {
-				ending = 0;
-			}
-		}
-		endings[i] = ending;
-	}
-
 	vector<HTp> mensspines;
 	getSpineStartList(mensspines, "**mens");
-	bool output = true;
-	string linkSignifier = m_signifiers.getKernLinkSignifier();
-	for (int i=0; i<(int)mensspines.size(); i++) {
-		output = output && analyzeKernSlurs(mensspines[i], slurstarts, slurends, labels, endings, linkSignifier);
-	}
+	analyzeSpans(mensspines, '(', slurstarts, slurends);
 	createLinkedSlurs(slurstarts, slurends);
-	return output;
+	return true;
 }
 
 
@@ -122,198 +69,21 @@ bool HumdrumFileContent::analyzeMensSlurs(void) {
 bool HumdrumFileContent::analyzeKernSlurs(void) {
 	vector<HTp> slurstarts;
 	vector<HTp> slurends;
-
-	vector<HTp> l;
-	vector<pair<HTp, HTp>> labels; // first is previous label, second is next label
-	HumdrumFileBase& infile = *this;
-	labels.resize(infile.getLineCount());
-	l.resize(infile.getLineCount());
-	for (int i=0; i<infile.getLineCount(); i++) {
-		labels[i].first = NULL;
-		labels[i].second = NULL;
-		l[i] = NULL;
-	}
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (!infile[i].isInterpretation()) {
-			continue;
-		}
-		HTp token = infile.token(i, 0);
-		if ((token->compare(0, 2, "*>") == 0) && (token->find("[") == std::string::npos)) {
-			l[i] = token;
-		}
-	}
-	HTp current = NULL;
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (l[i] != NULL) {
-			current = l[i];
-		}
-		labels[i].first = current;
-	}
-	current = NULL;
-	for (int i=infile.getLineCount() - 1; i>=0; i--) {
-		if (l[i] != NULL) {
-			current = l[i];
-		}
-		labels[i].second = current;
-	}
-
-	vector<int> endings(infile.getLineCount(), 0);
-	int ending = 0;
-	for (int i=0; i<(int)endings.size(); i++) {
-		if (l[i]) {
-			char lastchar = l[i]->back();
-			if (isdigit(lastchar)) {
-				ending = lastchar - '0';
-			} else {
-				ending = 0;
-			}
-		}
-		endings[i] = ending;
-	}
-
 	vector<HTp> kernspines;
 	getSpineStartList(kernspines, "**kern");
-	bool output = true;
-	string linkSignifier = m_signifiers.getKernLinkSignifier();
-	for (int i=0; i<(int)kernspines.size(); i++) {
-		output = output && analyzeKernSlurs(kernspines[i], slurstarts, slurends, labels, endings, linkSignifier);
-	}
-
+	analyzeSpans(kernspines, '(', slurstarts, slurends);
 	createLinkedSlurs(slurstarts, slurends);
-	return output;
+	return true;
 }
 
 
 bool HumdrumFileContent::analyzeKernSlurs(HTp spinestart,
 		vector<HTp>& linkstarts, vector<HTp>& linkends, vector<pair<HTp, HTp>>& labels,
 		vector<int>& endings, const string& linksig) {
-
-	// linked slurs handled separately, so generate an ignore sequence:
-	string ignorebegin = linksig + "(";
-	string ignoreend = linksig + ")";
-
-	// tracktokens == the 2-D data list for the track,
-	// arranged in layers with the second dimension.
-	vector<vector<HTp> > tracktokens;
-	this->getTrackSeq(tracktokens, spinestart, OPT_DATA | OPT_NOEMPTY);
-	// printSequence(tracktokens);
-
-	// sluropens == list of slur openings for each track and elision level
-	// first dimension: elision level
-	// second dimension: track number
-	vector<vector<vector<HTp>>> sluropens;
-
-	sluropens.resize(4); // maximum of 4 elision levels
-	for (int i=0; i<(int)sluropens.size(); i++) {
-		sluropens[i].resize(8);  // maximum of 8 layers
-	}
-
-	int opencount = 0;
-	int closecount = 0;
-	int elision = 0;
-	HTp token;
-	for (int row=0; row<(int)tracktokens.size(); row++) {
-		for (int track=0; track<(int)tracktokens[row].size(); track++) {
-			token = tracktokens[row][track];
-			if (!token->isData()) {
-				continue;
-			}
-			if (token->isNull()) {
-				continue;
-			}
-			opencount = (int)count(token->begin(), token->end(), '(');
-			closecount = (int)count(token->begin(), token->end(), ')');
-
-			for (int i=0; i<closecount; i++) {
-				bool isLinked = isLinkedSlurEnd(token, i, ignoreend);
-				if (isLinked) {
-					linkends.push_back(token);
-					continue;
-				}
-				elision = token->getSlurEndElisionLevel(i);
-				if (elision < 0) {
-					continue;
-				}
-				if (sluropens[elision][track].size() > 0) {
-					linkSlurEndpoints(sluropens[elision][track].back(), token);
-					// remove slur opening from buffer
-					sluropens[elision][track].pop_back();
-				} else {
-					// No starting slur marker to match to this slur end in the
-					// given track.
-					// search for an open slur in another track:
-					bool found = false;
-					for (int itrack=0; itrack<(int)sluropens[elision].size(); itrack++) {
-						if (sluropens[elision][itrack].size() > 0) {
-							linkSlurEndpoints(sluropens[elision][itrack].back(), token);
-							// remove slur opening from buffer
-							sluropens[elision][itrack].pop_back();
-							found = true;
-							break;
-						}
-					}
-					if (!found) {
-						int lineindex = token->getLineIndex();
-						int endnum = endings[lineindex];
-						int pindex = -1;
-						if (labels[lineindex].first) {
-							pindex = labels[lineindex].first->getLineIndex();
-							pindex--;
-						}
-						int endnumpre = -1;
-						if (pindex >= 0) {
-							endnumpre = endings[pindex];
-						}
-
-						if ((endnumpre > 0) && (endnum > 0) && (endnumpre != endnum)) {
-							// This is a slur in an ending that start at the start of an ending.
-							HumNum duration = token->getDurationFromStart();
-							if (labels[token->getLineIndex()].first) {
-								duration -= labels[token->getLineIndex()].first->getDurationFromStart();
-							}
-							token->setValue("auto", "endingSlurBack", "true");
-							token->setValue("auto", "slurSide", "stop");
-							token->setValue("auto", "slurDuration",
-								token->getDurationToEnd());
-						} else {
-							// This is a slur closing that does not have a matching opening.
-							token->setValue("auto", "hangingSlur", "true");
-							token->setValue("auto", "slurSide", "stop");
-							token->setValue("auto", "slurOpenIndex", to_string(i));
-							token->setValue("auto", "slurDuration",
-								token->getDurationToEnd());
-						}
-					}
-				}
-			}
-
-			for (int i=0; i<opencount; i++) {
-				bool isLinked = isLinkedSlurBegin(token, i, ignorebegin);
-				if (isLinked) {
-					linkstarts.push_back(token);
-					continue;
-				}
-				elision = token->getSlurStartElisionLevel(i);
-				if (elision < 0) {
-					continue;
-				}
-				sluropens[elision][track].push_back(token);
-			}
-		}
-	}
-
-	// Mark un-closed slur starts:
-	for (int i=0; i<(int)sluropens.size(); i++) {
-		for (int j=0; j<(int)sluropens[i].size(); j++) {
-			for (int k=0; k<(int)sluropens[i][j].size(); k++) {
-				sluropens[i][j][k]->setValue("", "auto", "hangingSlur", "true");
-				sluropens[i][j][k]->setValue("", "auto", "slurSide", "start");
-				sluropens[i][j][k]->setValue("", "auto", "slurDuration",
-						sluropens[i][j][k]->getDurationFromStart());
-			}
-		}
-	}
-
+	SpanState state('(', linksig);
+	analyzeSpineSpans(spinestart, state, labels, endings);
+	linkstarts.insert(linkstarts.end(), state.linkstarts.begin(), state.linkstarts.end());
+	linkends.insert(linkends.end(), state.linkends.begin(), state.linkends.end());
 	return true;
 }
 
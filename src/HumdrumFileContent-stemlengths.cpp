@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Sat Jun 16 06:37:31 PDT 2018
-// Last Modified: Sat Jun 16 06:37:34 PDT 2018
+// Last Modified: Sun Oct 18 14:20:12 PDT 2026
 // Filename:      HumdrumFileContent-stem.cpp
 // URL:           https://github.com/craigsapp/humlib/blob/master/src/HumdrumFileContent-stem.cpp
 // Syntax:        C++11; humlib
@@ -34,13 +34,19 @@ bool HumdrumFileContent::analyzeKernStemLengths(void) {
 
 	vector<vector<int>> centerlines;
 	getBaselines(centerlines);
-	for (int i=0; i<scount; i++) {
-		HTp sstart = this->getStrandStart(i);
+
+	// Each strand is independent, so they can be done in parallel:
+	vector<int> results(scount, 1);
+	runParallel(scount, [&](int index) {
+		HTp sstart = this->getStrandStart(index);
 		if (!sstart->isKern()) {
-			continue;
+			return;
 		}
-		HTp send = this->getStrandEnd(i);
-		output = output && analyzeKernStemLengths(sstart, send, centerlines);
+		HTp send = this->getStrandEnd(index);
+		results[index] = analyzeKernStemLengths(sstart, send, centerlines);
+	});
+	for (int i=0; i<scount; i++) {
+		output = output && results[i];
 	}
 	return output;
 }
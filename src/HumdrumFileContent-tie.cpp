@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Mon Oct  5 23:16:26 PDT 2015
-// Last Modified: Mon Oct  5 23:16:29 PDT 2015
+// Last Modified: Sun Oct 18 11:40:05 PDT 2026
 // Filename:      HumdrumFileContent-tie.cpp
 // URL:           https://github.com/craigsapp/humlib/blob/master/src/HumdrumFileContent-tie.cpp
 // Syntax:        C++11; humlib
@@ -62,16 +62,8 @@ bool HumdrumFileContent::analyzeKernTies(
 		return true;
 	}
 
-	string lstart  = linkSignifier + "[";
-	string lmiddle = linkSignifier + "_";
-	string lend    = linkSignifier + "]";
-
-	vector<pair<HTp, int>> startdatabase(400);
-
-	for (int i=0; i<(int)startdatabase.size(); i++) {
-		startdatabase[i].first  = NULL;
-		startdatabase[i].second = -1;
-	}
+	TieState state(linkSignifier);
+	vector<string> subtokens;
 
 	HumdrumFileContent& infile = *this;
 	for (int i=0; i<infile.getLineCount(); i++) {
@@ -92,49 +84,84 @@ bool HumdrumFileContent::analyzeKernTies(
 			if (tok->isRest()) {
 				continue;
 			}
-			int scount = tok->getSubtokenCount();
-			int b40;
-			for (int k=0; k<scount; k++) {
-				int index = k;
-				if (scount == 1) {
-					index = -1;
-				}
-				std::string tstring = tok->getSubtoken(k);
-				if (tstring.find(lstart) != std::string::npos) {
-					b40 = Convert::kernToBase40(tstring);
-					startdatabase[b40].first  = tok;
-					startdatabase[b40].second = index;
-					// linkedtiestarts.push_back(std::make_pair(tok, index));
-				}
-				if (tstring.find(lend) != std::string::npos) {
-					b40 = Convert::kernToBase40(tstring);
-					if (startdatabase.at(b40).first) {
-						linkedtiestarts.push_back(startdatabase[b40]);
-						linkedtieends.push_back(std::make_pair(tok, index));
-						startdatabase[b40].first  = NULL;
-						startdatabase[b40].second = -1;
-					}
-				}
-				if (tstring.find(lmiddle) != std::string::npos) {
-					b40 = Convert::kernToBase40(tstring);
-					if (startdatabase[b40].first) {
-						linkedtiestarts.push_back(startdatabase[b40]);
-						linkedtieends.push_back(std::make_pair(tok, index));
-					}
-					startdatabase[b40].first  = tok;
-					startdatabase[b40].second = index;
-					// linkedtiestarts.push_back(std::make_pair(tok, index));
-					// linkedtieends.push_back(std::make_pair(tok, index));
-				}
-			}
+			splitSubtokens(tok, subtokens);
+			analyzeKernTieToken(tok, subtokens, state);
 		}
 	}
 
+	linkedtiestarts.insert(linkedtiestarts.end(), state.linkstarts.begin(),
+			state.linkstarts.end());
+	linkedtieends.insert(linkedtieends.end(), state.linkends.begin(),
+			state.linkends.end());
 	return true;
 }
 
 
 
+//////////////////////////////
+//
+// HumdrumFileContent::TieState::TieState -- Prepare the bookkeeping for
+//     linked ties.
+//
+
+HumdrumFileContent::TieState::TieState(const string& linksig) {
+	lstart  = linksig + "[";
+	lmiddle = linksig + "_";
+	lend    = linksig + "]";
+	startdatabase.resize(400);
+	for (int i=0; i<(int)startdatabase.size(); i++) {
+		startdatabase[i].first  = NULL;
+		startdatabase[i].second = -1;
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileContent::analyzeKernTieToken -- Check the subtokens of a
+//     **kern note for linked tie markers.
+//
+
+void HumdrumFileContent::analyzeKernTieToken(HTp tok, const vector<string>& subtokens,
+		TieState& state) {
+	vector<pair<HTp, int>>& startdatabase = state.startdatabase;
+	int scount = (int)subtokens.size();
+	int b40;
+	for (int k=0; k<scount; k++) {
+		int index = k;
+		if (scount == 1) {
+			index = -1;
+		}
+		const std::string& tstring = subtokens[k];
+		if (tstring.find(state.lstart) != std::string::npos) {
+			b40 = Convert::kernToBase40(tstring);
+			startdatabase[b40].first  = tok;
+			startdatabase[b40].second = index;
+		}
+		if (tstring.find(state.lend) != std::string::npos) {
+			b40 = Convert::kernToBase40(tstring);
+			if (startdatabase.at(b40).first) {
+				state.linkstarts.push_back(startdatabase[b40]);
+				state.linkends.push_back(std::make_pair(tok, index));
+				startdatabase[b40].first  = NULL;
+				startdatabase[b40].second = -1;
+			}
+		}
+		if (tstring.find(state.lmiddle) != std::string::npos) {
+			b40 = Convert::kernToBase40(tstring);
+			if (startdatabase[b40].first) {
+				state.linkstarts.push_back(startdatabase[b40]);
+				state.linkends.push_back(std::make_pair(tok, index));
+			}
+			startdatabase[b40].first  = tok;
+			startdatabase[b40].second = index;
+		}
+	}
+}
+
+
+
 //////////////////////////////
 //
 // HumdrumFileContent::createLinkedTies --
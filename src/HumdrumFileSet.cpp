@@ -2,6 +2,7 @@
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Fri Mar 29 15:14:19 PDT 2013
 // Last Modified: Sun Jul 28 20:18:00 CEST 2019 Convert to humlib.
+// Last Modified: Sun Oct 18 23:12:07 PDT 2026 Read streams without copying.
 // Filename:      HumdrumFileSet.cpp
 // URL:           https://github.com/craigsapp/humlib/blob/master/src/HumdrumFileSet.cpp
 // Syntax:        C++11; humlib
@@ -173,9 +174,7 @@ int HumdrumFileSet::read(HumdrumFileStream& instream) {
 int HumdrumFileSet::readAppendFile(const string& filename) {
 	ifstream indata;
 	indata.open(filename);
-	string contents((istreambuf_iterator<char>(indata)), istreambuf_iterator<char>());
-	HumdrumFileStream instream(contents);
-	return readAppend(instream);
+	return readAppend(indata);
 }
 
 
@@ -191,8 +190,9 @@ int HumdrumFileSet::readAppendStringCsv(const string& contents) {
 
 
 int HumdrumFileSet::readAppend(istream& inStream) {
-	string contents((istreambuf_iterator<char>(inStream)), istreambuf_iterator<char>());
-	HumdrumFileStream instream(contents);
+	// Read the segments directly from the stream rather than from a
+	// copy of its entire contents.
+	HumdrumFileStream instream(inStream);
 	return readAppend(instream);
 }
 
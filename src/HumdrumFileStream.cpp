@@ -4,6 +4,8 @@
 // Last Modified: Tue Dec 11 16:09:38 PST 2012
 // Last Modified: Fri Mar 11 21:26:18 PST 2016 Changed to STL
 // Last Modified: Fri Dec  2 19:25:41 PST 2016 Moved to humlib
+// Last Modified: Sun Oct 18 23:12:07 PDT 2026 Added input streams and prefetching
+// Last Modified: Mon Oct 19 01:16:38 PDT 2026 Added readSegments
 // Filename:      HumdrumFileStream.cpp
 // URL:           https://github.com/craigsapp/humlib/blob/master/src/HumdrumFileStream.cpp
 // Syntax:        C++11; humlib
@@ -20,6 +22,7 @@
 
 #include <cstring>
 #include <fstream>
+#include <future>
 #include <iostream>
 #include <sstream>
 #include <vector>
@@ -62,6 +65,22 @@ HumdrumFileStream::HumdrumFileStream(const string& datastring) {
 	m_stringbuffer << datastring;
 }
 
+HumdrumFileStream::HumdrumFileStream(istream& input) {
+	m_curfile = -1;
+	m_input = &input;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStream::~HumdrumFileStream --
+//
+
+HumdrumFileStream::~HumdrumFileStream() {
+	waitForPrefetch();
+}
+
 
 
 //////////////////////////////
@@ -70,9 +89,12 @@ HumdrumFileStream::HumdrumFileStream(const string& datastring) {
 //
 
 void HumdrumFileStream::clear(void) {
+	waitForPrefetch();
+	m_prefetchstatus = -1;
 	m_curfile = 0;
+	m_input = NULL;
 	m_filelist.resize(0);
-	m_universals.resize(0);
+	m_universals.clear();
 	m_newfilebuffer.resize(0);
 	// m_stringbuffer.clear(0);
 	m_stringbuffer.str("");
@@ -86,6 +108,7 @@ void HumdrumFileStream::clear(void) {
 //
 
 int HumdrumFileStream::setFileList(char** list) {
+	waitForPrefetch();
 	m_filelist.reserve(1000);
 	m_filelist.resize(0);
 	int i = 0;
@@ -98,6 +121,7 @@ int HumdrumFileStream::setFileList(char** list) {
 
 
 int HumdrumFileStream::setFileList(const vector<string>& list) {
+	waitForPrefetch();
 	m_filelist = list;
 	return (int)list.size();
 }
@@ -110,12 +134,45 @@ int HumdrumFileStream::setFileList(const vector<string>& list) {
 //
 
 void HumdrumFileStream::loadString(const string& data) {
+	waitForPrefetch();
 	m_curfile = -1;
 	m_stringbuffer << data;
 }
 
 
 
+//////////////////////////////
+//
+// HumdrumFileStream::setPrefetch -- Read the text of the next segment in
+//    a separate thread while the current segment is being parsed and
+//    processed.  At most one segment is read ahead, so the memory usage
+//    is still limited to that of two segments, regardless of the size
+//    of the input stream.
+//
+
+void HumdrumFileStream::setPrefetch(bool state) {
+	m_prefetchQ = state;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStream::waitForPrefetch -- Wait for the read-ahead thread to
+//    finish.  Returns -1 if no segment has been read ahead, 0 if the
+//    end of the input was reached, or 1 if the text of a segment is
+//    waiting in m_prefetchtext.
+//
+
+int HumdrumFileStream::waitForPrefetch(void) {
+	if (m_prefetch.valid()) {
+		m_prefetchstatus = m_prefetch.get();
+	}
+	return m_prefetchstatus;
+}
+
+
+
 //////////////////////////////
 //
 // HumdrumFileStream::read -- alias for getFile.
@@ -158,6 +215,29 @@ int HumdrumFileStream::readSingleSegment(HumdrumFileSet& infiles) {
 
 
 
+//////////////////////////////
+//
+// HumdrumFileStream::readSegments -- Get up to the given number of files
+//     for a set structure, so that several segments can be processed
+//     together while only a limited number of them are kept in memory.
+//     Returns the number of files read.
+//
+
+int HumdrumFileStream::readSegments(HumdrumFileSet& infiles, int count) {
+	infiles.clear();
+	for (int i=0; i<count; i++) {
+		HumdrumFile* infile = new HumdrumFile;
+		if (!getFile(*infile)) {
+			delete infile;
+			break;
+		}
+		infiles.appendHumdrumPointer(infile);
+	}
+	return infiles.getCount();
+}
+
+
+
 //////////////////////////////
 //
 // HumdrumFileStream::eof -- returns true if there is no more segements
@@ -165,6 +245,9 @@ int HumdrumFileStream::readSingleSegment(HumdrumFileSet& infiles) {
 //
 
 int HumdrumFileStream::eof(void) {
+	if (waitForPrefetch() > 0) {
+		return 0;
+	}
 	istream* newinput = NULL;
 
 	// Read HumdrumFile contents from:
@@ -177,6 +260,11 @@ int HumdrumFileStream::eof(void) {
 		return 0;
 	}
 
+	// (1a) Is there more to read from the given istream?
+	else if ((m_input != NULL) && m_input->good()) {
+		return 0;
+	}
+
 	// (1b) Is the URL data buffer open?
 	else if (m_urlbuffer.str() != "") {
 		return 0;
@@ -212,11 +300,71 @@ int HumdrumFileStream::eof(void) {
 //
 
 int HumdrumFileStream::getFile(HumdrumFile& infile) {
+	stringstream contents;
+	if (!getFileText(infile, contents)) {
+		return 0;
+	}
+	parseFileText(infile, contents);
+	return 1;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStream::getFileText -- Same as getFile(), but only read the
+//    text of the next HumdrumFile into contents without parsing it.  The
+//    filename and segment level are stored in infile.  Use parseFileText()
+//    to finish reading the file, which can be done in a separate thread
+//    since it does not access the stream.
+//
+
+int HumdrumFileStream::getFileText(HumdrumFile& infile, stringstream& contents) {
+	if (!m_prefetchQ && !m_prefetch.valid() && (m_prefetchstatus < 0)) {
+		return readFileText(infile, contents);
+	}
+
+	if (waitForPrefetch() < 0) {
+		m_prefetchstatus = readFileText(m_prefetchfile, m_prefetchtext);
+	}
+	int status = m_prefetchstatus;
+	m_prefetchstatus = -1;
+
+	infile.clear();
+	infile.setFilename(m_prefetchfile.getFilename());
+	infile.setSegmentLevel(m_prefetchfile.getSegmentLevel());
+	if (!status) {
+		return 0;
+	}
+	contents.swap(m_prefetchtext);
+
+	if (m_prefetchQ) {
+		m_prefetch = std::async(std::launch::async, [this]() {
+			return readFileText(m_prefetchfile, m_prefetchtext);
+		});
+	}
+	return 1;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStream::readFileText -- Read the text of the next segment
+//    from the input for getFileText().  The data lines are written
+//    directly into contents after the universal comments, so only one
+//    copy of the segment is kept in memory.
+//
+
+int HumdrumFileStream::readFileText(HumdrumFile& infile, stringstream& contents) {
 	infile.clear();
 	istream* newinput = NULL;
 
 restarting:
 
+	contents.str(""); // empty any contents in buffer
+	contents.clear(); // reset error flags in buffer
+
 	stringstream buffer;
 	string templine;
 	if (!m_newfilebuffer.empty()) {
@@ -237,11 +385,18 @@ restarting:
 	// (3) Next filename if ifstream is done
 	// (4) cin if no ifstream open and no filenames
 
-	// (1) Is there content in the string buffer?
-	if (!m_stringbuffer.str().empty()) {
+	// (1) Is there content in the string buffer?  (Check the size of
+	// the buffer without copying it as str() does.)
+	if (m_stringbuffer.rdbuf()->pubseekoff(0, std::ios::cur, std::ios::out) > 0) {
 		newinput = &m_stringbuffer;
 	}
 
+	// (1a) Is there a given istream?  (Like the string buffer, it is the
+	// only input source.)
+	else if (m_input != NULL) {
+		newinput = m_input;
+	}
+
 	// (2) Is an ifstream open?
 	else if (m_instream.is_open() && !m_instream.eof()) {
 		newinput = &m_instream;
@@ -269,6 +424,11 @@ restarting:
 			infile.setFilename(m_filelist[m_curfile]);
 			goto restarting;
 		}
+		if (m_readbuffer.empty()) {
+			// Use a fixed-size read-ahead buffer (set before opening).
+			m_readbuffer.resize(1 << 16);
+			m_instream.rdbuf()->pubsetbuf(m_readbuffer.data(), m_readbuffer.size());
+		}
 		m_instream.open(m_filelist[m_curfile]);
 		infile.setFilename(m_filelist[m_curfile]);
 		if (!m_instream.is_open()) {
@@ -332,7 +492,7 @@ restarting:
 		//searchName = 1;
 	}
 
-	if (newinput->eof()) {
+	if (!newinput->good()) {
 		if (m_curfile < (int)m_filelist.size()-1) {
 			m_curfile++;
 			goto restarting;
@@ -351,12 +511,12 @@ restarting:
 		starstarFoundQ = 1;
 	}
 
-	while (!input.eof()) {
+	while (input.good()) {
 		getline(input, templine);
 		if (templine.compare(0, strlen("!!!!SEGMENT"), "!!!!SEGMENT") == 0) {
 			// Store the current segment line in the buffer before breaking.
-			if (!buffer.str().empty()) {
-				m_newfilebuffer = templine;
+			if (dataFoundQ || (buffer.tellp() > 0)) {
+				m_newfilebuffer.swap(templine);
 				break;
 			}
 			m_newfilebuffer = templine;
@@ -364,7 +524,7 @@ restarting:
 
 		if (templine.compare(0, 2, "**") == 0) {
 			if (starstarFoundQ == 1) {
-				m_newfilebuffer = templine;
+				m_newfilebuffer.swap(templine);
 				// already found a **, so this one is defined as a file
 				// segment.  Exit from the loop and process the previous
 				// content, waiting until the next read to start with
@@ -391,17 +551,15 @@ restarting:
 			// This is a universal comment.  Should it be appended
 			// to the list or should the current list be erased and
 			// this record placed into the first entry?
-			if (foundUniversalQ) {
-				// already found a previous universal, so append.
-				m_universals.push_back(templine);
-			} else {
+			if (!foundUniversalQ) {
 				// new universal comment, to delete all previous
 				// universal comments and store this one.
-				m_universals.reserve(1000);
-				m_universals.resize(1);
-				m_universals[0] = templine;
+				m_universals.clear();
 				foundUniversalQ = 1;
 			}
+			// Store as a global comment:
+			m_universals.append(templine, 1, string::npos);
+			m_universals += '\n';
 			continue;
 		}
 
@@ -425,10 +583,19 @@ restarting:
 			}
 		}
 
-		dataFoundQ = 1; // found something other than universal comments
+		if (!dataFoundQ) {
+			// found something other than universal comments, so the
+			// universal comments for this segment are complete.
+			// Prepend them (demoted into global comments) at the start
+			// of the data stream (maybe allow for postpending Universal
+			// comments in the future).
+			contents << m_universals << buffer.rdbuf();
+			contents.clear();
+			dataFoundQ = 1;
+		}
 
 		// store the data line for later parsing into HumdrumFile record:
-		buffer << templine << "\n";
+		contents << templine << "\n";
 	}
 
 /*
@@ -442,23 +609,24 @@ restarting:
 */
 
 	// Arriving here means that reading of the data stream is complete.
-	// The string stream variable "buffer" contains the HumdrumFile
-	// content, so send it to the HumdrumFile variable.  Also, prepend
-	// Universal comments (demoted into Global comments) at the start
-	// of the data stream (maybe allow for postpending Universal comments
-	// in the future).
-	stringstream contents;
-	contents.str(""); // empty any contents in buffer
-	contents.clear(); // reset error flags in buffer
-
-	for (int i=0; i < (int)m_universals.size(); i++) {
-		if (m_universals[i].compare(0, 11, "!!!!filter:") == 0) {
-			continue;
-		}
-		contents << &(m_universals[i][1]) << "\n";
+	// The string stream variable "contents" contains the HumdrumFile
+	// content, unless only universal comments were found.
+	if (!dataFoundQ) {
+		contents << m_universals << buffer.rdbuf();
+		contents.clear();
 	}
+	return 1;
+}
+
+
 
-	contents << buffer.str();
+//////////////////////////////
+//
+// HumdrumFileStream::parseFileText -- Parse the text read by getFileText()
+//    into the HumdrumFile.
+//
+
+void HumdrumFileStream::parseFileText(HumdrumFile& infile, stringstream& contents) {
 	string oldfilename = infile.getFilename();
 	infile.readNoRhythm(contents);
 	string newfilename = infile.getFilename();
@@ -466,8 +634,6 @@ restarting:
 		infile.setFilename(oldfilename);
 	}
 	infile.setFilenameFromSegment();
-
-	return 1;
 }
 
 
@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Mon Aug 17 02:39:28 PDT 2015
-// Last Modified: Mon Aug 17 02:39:32 PDT 2015
+// Last Modified: Sun Oct 18 22:31:07 PDT 2026
 // Filename:      HumdrumFileStructure.cpp
 // URL:           https://github.com/craigsapp/humlib/blob/master/src/HumdrumFileStructure.cpp
 // Syntax:        C++11; humlib
@@ -337,20 +337,20 @@ bool HumdrumFileStructure::readNoRhythm(const string& filename) {
 //
 
 bool HumdrumFileStructure::readNoRhythmCsv(istream& infile,
-		const string& seperator) {
-	return HumdrumFileBase::readCsv(infile);
+		const string& separator) {
+	return HumdrumFileBase::readCsv(infile, separator);
 }
 
 
 bool HumdrumFileStructure::readNoRhythmCsv(const char* filename,
-		const string& seperator) {
-	return HumdrumFileBase::readCsv(filename);
+		const string& separator) {
+	return HumdrumFileBase::readCsv(filename, separator);
 }
 
 
 bool HumdrumFileStructure::readNoRhythmCsv(const string& filename,
-		const string& seperator) {
-	return HumdrumFileBase::readCsv(filename);
+		const string& separator) {
+	return HumdrumFileBase::readCsv(filename, separator);
 }
 
 
@@ -383,13 +383,13 @@ bool HumdrumFileStructure::readStringNoRhythm(const string& contents) {
 
 bool HumdrumFileStructure::readStringNoRhythmCsv(const char* contents,
 		const string& separator) {
-	return HumdrumFileBase::readStringCsv(contents);
+	return HumdrumFileBase::readStringCsv(contents, separator);
 }
 
 
 bool HumdrumFileStructure::readStringNoRhythmCsv(const string& contents,
 		const string& separator) {
-	return HumdrumFileBase::readStringCsv(contents);
+	return HumdrumFileBase::readStringCsv(contents, separator);
 }
 
 
@@ -614,6 +614,7 @@ bool HumdrumFileStructure::analyzeRhythm(void) {
 	HumNum zero(0);
 
 	int i;
+	vector<int> tracks;
 	for (int i=1; i<=getMaxTrack(); i++) {
 		if (!getTrackStart(i)->hasRhythm()) {
 			// Can't analyze rhythm of spines that do not have rhythm.
@@ -621,9 +622,7 @@ bool HumdrumFileStructure::analyzeRhythm(void) {
 		}
 		testline = getTrackStart(i)->getLineIndex();
 		if (testline == startline) {
-			if (!assignDurationsToTrack(getTrackStart(i), zero)) {
-				return false;
-			}
+			tracks.push_back(i);
 		} else {
 			// Spine does not start at beginning of data, so
 			// the starting position of the spine has to be
@@ -634,6 +633,30 @@ bool HumdrumFileStructure::analyzeRhythm(void) {
 		}
 	}
 
+	// Use integer timestamps while walking the spines if possible:
+	prepareRhythmTicks();
+
+	if ((getAnalysisThreads() > 1) && (tracks.size() > 1) && !hasCrossTrackMerges()) {
+		// Walk the tracks in parallel, then set the line durations in
+		// track order so that results (and rhythm errors) are the same
+		// as for a serial analysis.
+		bool status;
+		if (m_rhythmtpq > 0) {
+			status = assignDurationsInParallel(tracks, (int64_t)0);
+		} else {
+			status = assignDurationsInParallel(tracks, zero);
+		}
+		if (!status) {
+			return false;
+		}
+	} else {
+		for (i=0; i<(int)tracks.size(); i++) {
+			if (!assignDurationsToTrack(getTrackStart(tracks[i]), zero)) {
+				return false;
+			}
+		}
+	}
+
 	// Go back and analyze spines that do not start at the
 	// beginning of the data stream.
 	for (i=1; i<=getMaxTrack(); i++) {
@@ -646,6 +669,8 @@ bool HumdrumFileStructure::analyzeRhythm(void) {
 			if (!analyzeRhythmOfFloatingSpine(getTrackStart(i))) { return false; }
 		}
 	}
+	m_rhythmtpq = 0;
+	m_lineticks.clear();
 
 	if (!analyzeNullLineRhythms()) { return false; }
 	fillInNegativeStartTimes();
@@ -671,6 +696,7 @@ bool HumdrumFileStructure::analyzeRhythm(void) {
 bool HumdrumFileStructure::analyzeMeter(void) {
 
 	m_barlines.resize(0);
+	m_analyses.m_metric_analyzed = false;
 
 	int i;
 	HumNum sum = 0;
@@ -1014,6 +1040,11 @@ bool HumdrumFileStructure::assignDurationsToTrack(HTp starttoken,
 		return isValid();
 	}
 	int state = starttoken->getState();
+	int64_t startticks;
+	if ((m_rhythmtpq > 0) && HumNum64(startdur).getTicks(m_rhythmtpq, startticks)) {
+		prepareDurations(starttoken, state, startticks);
+		return isValid();
+	}
 	if (!prepareDurations(starttoken, state, startdur)) {
 		return isValid();
 	}
@@ -1022,30 +1053,62 @@ bool HumdrumFileStructure::assignDurationsToTrack(HTp starttoken,
 
 
 
+//////////////////////////////
+//
+// HumdrumFileStructure::assignDurationsInParallel -- Assign durations to
+//    tracks in separate threads, then set the line durations in track
+//    order so that results (and rhythm errors) are the same as for a
+//    serial analysis.  The tracks cannot be linked by merges.
+//
+
+template <class DURTYPE>
+bool HumdrumFileStructure::assignDurationsInParallel(vector<int>& tracks,
+		DURTYPE startdur) {
+	vector<vector<pair<HTp, DURTYPE>>> linedurs(tracks.size());
+	runParallel((int)tracks.size(), [&](int index) {
+		HTp starttoken = getTrackStart(tracks[index]);
+		prepareDurations(starttoken, starttoken->getState(), startdur, &linedurs[index]);
+	});
+	for (int i=0; i<(int)linedurs.size(); i++) {
+		for (int j=0; j<(int)linedurs[i].size(); j++) {
+			if (!setLineDurationFromStart(linedurs[i][j].first, linedurs[i][j].second)) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+
+
 //////////////////////////////
 //
 // HumdrumFileStructure::prepareDurations -- Helper function for
 //     HumdrumFileStructure::assignDurationsToTrack() which does all of the
-//     work for assigning durationFromStart values.
+//     work for assigning durationFromStart values.  DURTYPE is either
+//     HumNum or int64_t ticks (see prepareRhythmTicks()).
 //
 
+template <class DURTYPE>
 bool HumdrumFileStructure::prepareDurations(HTp token, int state,
-		HumNum startdur) {
+		DURTYPE startdur, vector<pair<HTp, DURTYPE>>* linedurs) {
 	if (state != token->getState()) {
 		return isValid();
 	}
 
-	HumNum dursum = startdur;
+	DURTYPE dursum = startdur;
 	token->incrementState();
 
-	if (!setLineDurationFromStart(token, dursum)) { return isValid(); }
-	if (token->getDuration().isPositive()) {
-		dursum += token->getDuration();
+	if (linedurs) {
+		linedurs->emplace_back(token, dursum);
+	} else if (!setLineDurationFromStart(token, dursum)) {
+		return isValid();
 	}
+	addTokenDuration(dursum, token);
 	int tcount = token->getNextTokenCount();
 
 	vector<HTp> reservoir;
-	vector<HumNum> startdurs;
+	vector<DURTYPE> startdurs;
 
 	// Assign line durationFromStarts for primary track first.
 	while (tcount > 0) {
@@ -1058,22 +1121,28 @@ bool HumdrumFileStructure::prepareDurations(HTp token, int state,
 			break;
 		}
 		token->incrementState();
-		if (!setLineDurationFromStart(token, dursum)) { return isValid(); }
-		if (token->getDuration().isPositive()) {
-			dursum += token->getDuration();
+		if (linedurs) {
+			linedurs->emplace_back(token, dursum);
+		} else if (!setLineDurationFromStart(token, dursum)) {
+			return isValid();
 		}
+		addTokenDuration(dursum, token);
 		tcount = token->getNextTokenCount();
 	}
 
 	if ((tcount == 0) && (token->isTerminateInterpretation())) {
-		if (!setLineDurationFromStart(token, dursum)) { return isValid(); }
+		if (linedurs) {
+			linedurs->emplace_back(token, dursum);
+		} else if (!setLineDurationFromStart(token, dursum)) {
+			return isValid();
+		}
 	}
 
 	// Process secondary tracks next:
 	int newstate = state;
 
 	for (int i=(int)reservoir.size()-1; i>=0; i--) {
-		prepareDurations(reservoir[i], newstate, startdurs[i]);
+		prepareDurations(reservoir[i], newstate, startdurs[i], linedurs);
 	}
 
 	return isValid();
@@ -1081,12 +1150,143 @@ bool HumdrumFileStructure::prepareDurations(HTp token, int state,
 
 
 
+//////////////////////////////
+//
+// HumdrumFileStructure::prepareRhythmTicks -- Prepare integer timestamps
+//     for the rhythm analysis, so that durations can be added without
+//     reducing fractions.  The number of ticks per quarter note is the
+//     least common multiple of the denominators of all token durations,
+//     which is calculated before the line durations needed for tpq() are
+//     known.  No timestamp can be larger than the sum of all token
+//     durations, so if that sum fits into 64 bits the analysis cannot
+//     overflow.  Returns false if ticks cannot be used, in which case the
+//     analysis is done with HumNum timestamps.
+//
+
+bool HumdrumFileStructure::prepareRhythmTicks(void) {
+	m_rhythmtpq = 0;
+	m_lineticks.clear();
+
+	int64_t tpq = 1;
+	for (int i=0; i<getLineCount(); i++) {
+		if (!m_lines[i]->isData()) {
+			continue;
+		}
+		for (int j=0; j<m_lines[i]->getTokenCount(); j++) {
+			HumNum dur = m_lines[i]->token(j)->getDuration();
+			if (dur.isPositive() && !HumNum64::lcm(tpq, dur.getDenominator(), tpq)) {
+				return false;
+			}
+		}
+	}
+
+	int64_t total = 0;
+	int64_t ticks;
+	for (int i=0; i<getLineCount(); i++) {
+		if (!m_lines[i]->isData()) {
+			continue;
+		}
+		for (int j=0; j<m_lines[i]->getTokenCount(); j++) {
+			HumNum dur = m_lines[i]->token(j)->getDuration();
+			if (!dur.isPositive()) {
+				continue;
+			}
+			if (!HumNum64::multiply(dur.getNumerator(), tpq / dur.getDenominator(), ticks)) {
+				return false;
+			}
+			if (!HumNum64::add(total, ticks, total)) {
+				return false;
+			}
+		}
+	}
+
+	// Timestamps already assigned to lines:
+	m_lineticks.assign(getLineCount(), -1);
+	for (int i=0; i<getLineCount(); i++) {
+		HumNum dur = m_lines[i]->getDurationFromStart();
+		if (dur.isNegative()) {
+			continue;
+		}
+		if (!HumNum64(dur).getTicks(tpq, m_lineticks[i])) {
+			m_lineticks.clear();
+			return false;
+		}
+	}
+
+	m_rhythmtpq = tpq;
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::addTokenDuration -- Add the duration of a token
+//     to a running timestamp if the duration is positive.
+//
+
+void HumdrumFileStructure::addTokenDuration(HumNum& dursum, HTp token) {
+	HumNum dur = token->getDuration();
+	if (dur.isPositive()) {
+		dursum += dur;
+	}
+}
+
+
+void HumdrumFileStructure::addTokenDuration(int64_t& durticks, HTp token) {
+	HumNum dur = token->getDuration();
+	if (dur.isPositive()) {
+		// Cannot overflow (checked in prepareRhythmTicks()):
+		durticks += (int64_t)dur.getNumerator() * (m_rhythmtpq / dur.getDenominator());
+	}
+}
+
+
+
 //////////////////////////////
 //
 // HumdrumFileStructure::setLineDurationFromStart -- Set the duration of
-//      a line based on the analysis of tokens in the spine.
+//      a line based on the analysis of tokens in the spine.  The second
+//      form takes the timestamp in ticks (see prepareRhythmTicks()), and
+//      only converts it to a HumNum when the line has no timestamp yet.
+//      Timestamps that do not fit into a HumNum are a parse error.
 //
 
+bool HumdrumFileStructure::setLineDurationFromStart(HTp token,
+		int64_t durticks) {
+	if ((!token->isTerminateInterpretation()) &&
+			token->getDuration().isNegative()) {
+		// undefined rhythm, so don't assign line duration information:
+		return isValid();
+	}
+	HLp line = token->getOwner();
+	int64_t& lineticks = m_lineticks[line->getLineIndex()];
+	if (lineticks < 0) {
+		HumNum dursum;
+		if (!HumNum64(durticks, m_rhythmtpq).getHumNum(dursum)) {
+			stringstream err;
+			err << "Error: durationFromStart too large near line "
+			    << token->getLineNumber() << endl;
+			err << "Duration is: " << HumNum64(durticks, m_rhythmtpq) << endl;
+			err << "Line: " << *line << endl;
+			return setParseError(err);
+		}
+		lineticks = durticks;
+		line->setDurationFromStart(dursum);
+	} else if (lineticks != durticks) {
+		stringstream err;
+		err << "Error: Inconsistent rhythm analysis occurring near line "
+		    << token->getLineNumber() << endl;
+		err << "Expected durationFromStart to be: " << HumNum64(durticks, m_rhythmtpq)
+		    << " but found it to be " << line->getDurationFromStart() << endl;
+		err << "Line: " << *line << endl;
+		return setParseError(err);
+	}
+
+	return isValid();
+}
+
+
 bool HumdrumFileStructure::setLineDurationFromStart(HTp token,
 		HumNum dursum) {
 	if ((!token->isTerminateInterpretation()) &&
@@ -1094,6 +1294,11 @@ bool HumdrumFileStructure::setLineDurationFromStart(HTp token,
 		// undefined rhythm, so don't assign line duration information:
 		return isValid();
 	}
+	if (m_rhythmtpq > 0) {
+		// Stop using ticks since the line timestamps will change:
+		m_rhythmtpq = 0;
+		m_lineticks.clear();
+	}
 	HLp line = token->getOwner();
 	if (line->getDurationFromStart().isNegative()) {
 		line->setDurationFromStart(dursum);
@@ -1112,6 +1317,34 @@ bool HumdrumFileStructure::setLineDurationFromStart(HTp token,
 
 
 
+//////////////////////////////
+//
+// HumdrumFileStructure::hasCrossTrackMerges -- Returns true if any spine
+//     manipulator links a token to a token in a different track (such as
+//     when *v merges two primary spines).  Tracks cannot be analyzed
+//     independently in that case.
+//
+
+bool HumdrumFileStructure::hasCrossTrackMerges(void) {
+	for (int i=0; i<getLineCount(); i++) {
+		if (!m_lines[i]->isManipulator()) {
+			continue;
+		}
+		for (int j=0; j<m_lines[i]->getFieldCount(); j++) {
+			HTp token = m_lines[i]->token(j);
+			int track = token->getTrack();
+			for (int k=0; k<token->getNextTokenCount(); k++) {
+				if (token->getNextToken(k)->getTrack() != track) {
+					return true;
+				}
+			}
+		}
+	}
+	return false;
+}
+
+
+
 //////////////////////////////
 //
 // HumdrumFileStructure::analyzeRhythmOfFloatingSpine --  This analysis
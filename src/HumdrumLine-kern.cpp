@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Tue Apr 12 11:58:02 PDT 2022
-// Last Modified: Tue Apr 12 11:58:06 PDT 2022
+// Last Modified: Sun Oct 18 18:07:12 PDT 2026
 // Filename:      HumdrumLine-kern.cpp
 // URL:           https://github.com/craigsapp/humlib/blob/master/src/HumdrumLine-kern.cpp
 // Syntax:        C++11; humlib
@@ -13,6 +13,7 @@
 #include "HumdrumLine.h"
 #include "HumdrumFile.h"
 #include "Convert.h"
+#include "HumSonority.h"
 
 using namespace std;
 
@@ -64,6 +65,7 @@ string HumdrumLine::getTriadicQuality(HumdrumFile& infile, int index,
 	}
 
 	vector<int> notes;
+	HumSonority sonority;
 
 	// Collect notes from all sounding tokens, including resolved nulls.
 	for (int i=0; i<infile[index].getFieldCount(); i++) {
@@ -85,6 +87,7 @@ string HumdrumLine::getTriadicQuality(HumdrumFile& infile, int index,
 
 		for (int j=0; j<(int)subtoks.size(); j++) {
 			notes.push_back(subtoks[j]);
+			sonority.addMidi(subtoks[j]);
 		}
 	}
 
@@ -97,22 +100,22 @@ string HumdrumLine::getTriadicQuality(HumdrumFile& infile, int index,
 		}
 	}
 
-	// Sort pitches if requested.
-	if (lowQ) {
-		sort(notes.begin(), notes.end(),
-			[](const int& a, const int& b) {
-				return abs(a) > abs(b);
-			}
-		);
-	} else {
-		sort(notes.begin(), notes.end(),
-			[](const int& a, const int& b) {
-				return abs(a) < abs(b);
-			}
-		);
-	}
-
 	if (pitchesQ) {
+		// Sort pitches if requested.
+		if (lowQ) {
+			sort(notes.begin(), notes.end(),
+				[](const int& a, const int& b) {
+					return abs(a) > abs(b);
+				}
+			);
+		} else {
+			sort(notes.begin(), notes.end(),
+				[](const int& a, const int& b) {
+					return abs(a) < abs(b);
+				}
+			);
+		}
+
 		string output = "[";
 
 		for (int i=0; i<(int)notes.size(); i++) {
@@ -179,38 +182,15 @@ string HumdrumLine::getTriadicQuality(HumdrumFile& infile, int index,
 		}
 	}
 
-	vector<bool> pcs(12, false);
-
-	for (int i=0; i<(int)notes.size(); i++) {
-
-		int pitch = notes[i];
-
-		if (pitch == 0) {
-			continue;
-		}
-
-		if (pitch < 0) {
-			pitch = -pitch;
-		}
-
-		pcs[pitch % 12] = true;
-	}
-
-	vector<int> pcs_new;
-
-	for (int i=0; i<12; i++) {
-		if (pcs[i]) {
-			pcs_new.push_back(i);
-		}
-	}
-
 	if (classQ) {
 
 		string output = "{";
 
-		for (int i=0; i<(int)pcs_new.size(); i++) {
-			output += to_string(pcs_new[i]);
-			output += " ";
+		for (int i=0; i<12; i++) {
+			if (sonority.hasPitchClass(i)) {
+				output += to_string(i);
+				output += " ";
+			}
 		}
 
 		if (output.size() == 1) {
@@ -227,7 +207,11 @@ string HumdrumLine::getTriadicQuality(HumdrumFile& infile, int index,
 		"F#", "G", "A♭", "A", "B♭", "B"
 	};
 
-	if (pcs_new.empty()) {
+	// Classify the pitch-class set by table lookup.
+	int type = sonority.getType();
+	int r    = sonority.getRoot();
+
+	if (type == sonority_empty) {
 		if (restQ) {
 			quality = "R";
 			return "";
@@ -237,240 +221,110 @@ string HumdrumLine::getTriadicQuality(HumdrumFile& infile, int index,
 	}
 
 	// Unison.
-	if (pcs_new.size() == 1) {
+	if (type == sonority_unison) {
 		if (unisonQ && partialQ) {
 			quality = "U";
-			root = pcnames[pcs_new[0]];
+			root = pcnames[r];
 			if (asciiQ) {
 				inversion = "1";
 			} else {
 				inversion = "₁";
 			}
-			return "";
 		}
+		return "";
 	}
 
 	// Dyads.
-	if (pcs_new.size() == 2) {
-
-		int pc1 = pcs_new[0];
-		int pc2 = pcs_new[1];
-
-		int interval = (pc2 - pc1 + 12) % 12;
-
-		if (interval == 7) {
-			if (partialQ) {
-				quality = "-5";
-				root = pcnames[pc1];
-				if (asciiQ) {
-					inversion = "5";
-				} else {
-					inversion = "₅";
-				}
-			}
-		} else if (interval == 5) {
-			if (partialQ) {
-				quality = "-5";
-					root = pcnames[pc2];
-				if (asciiQ) {
-					inversion = "5";
-				} else {
-					inversion = "₅";
-				}
-			}
-
-		} else if (interval == 3) {
-			if (partialQ) {
-				quality = "-m";
-				root = pcnames[pc1];
-				root[0] = tolower(root[0]);
-				if (asciiQ) {
-					inversion = "3";
-				} else {
-					inversion = "₃";
-				}
-			}
-
-		} else if (interval == 9) {
-			if (partialQ) {
-				quality = "-m";
-				root = pcnames[pc2];
-				root[0] = tolower(root[0]);
-				if (asciiQ) {
-					inversion = "3";
-				} else {
-					inversion = "₃";
-				}
+	if (type == sonority_fifth) {
+		if (partialQ) {
+			quality = "-5";
+			root = pcnames[r];
+			if (asciiQ) {
+				inversion = "5";
+			} else {
+				inversion = "₅";
 			}
-
-		} else if (interval == 4) {
-			if (partialQ) {
-				quality = "-M";
-				root = pcnames[pc1];
-				if (asciiQ) {
-					inversion = "3";
-				} else {
-					inversion = "₃";
-				}
+		}
+		return "";
+	} else if (type == sonority_minor_third) {
+		if (partialQ) {
+			quality = "-m";
+			root = pcnames[r];
+			root[0] = tolower(root[0]);
+			if (asciiQ) {
+				inversion = "3";
+			} else {
+				inversion = "₃";
 			}
-
-		} else if (interval == 8) {
-			if (partialQ) {
-				quality = "-M";
-				root = pcnames[pc2];
-				if (asciiQ) {
-					inversion = "3";
-				} else {
-					inversion = "₃";
-				}
+		}
+		return "";
+	} else if (type == sonority_major_third) {
+		if (partialQ) {
+			quality = "-M";
+			root = pcnames[r];
+			if (asciiQ) {
+				inversion = "3";
+			} else {
+				inversion = "₃";
 			}
-
-		} else {
-			quality = "?";
-			root.clear();
-			inversion.clear();
 		}
-
+		return "";
+	} else if ((type == sonority_tritone) || (type == sonority_dyad)) {
+		quality = "?";
 		return "";
 	}
 
 	// More than triad.
-	if (pcs_new.size() > 3) {
+	if (type == sonority_large) {
 		quality = "+";
 		return "";
 	}
 
-	// Try all pitch classes as root.
-	for (int i=0; i<3; i++) {
-
-		int r = pcs_new[i];
-
-		bool has3 = false;
-		bool has4 = false;
-		bool has6 = false;
-		bool has7 = false;
-		bool has8 = false;
-
-		for (int j=0; j<3; j++) {
-			int interval = (pcs_new[j] - r + 12) % 12;
-			if (interval == 3) {
-				has3 = true;
-			} else if (interval == 4) {
-				has4 = true;
-			} else if (interval == 6) {
-				has6 = true;
-			} else if (interval == 7) {
-				has7 = true;
-			} else if (interval == 8) {
-				has8 = true;
-			}
-		}
-
-		int bassint = (basspc - r + 12) % 12;
+	// Unknown trichord.
+	if (!HumSonority::isTriad(type)) {
+		quality = "?";
+		return "";
+	}
 
-		// Major triad.
-		if (has4 && has7) {
-			quality = "M";
-			root = pcnames[r];
-			if (bassint == 4) {
-				if (asciiQ) {
-					inversion = "6";
-				} else {
-					inversion += "₆";
-				}
-			} else if (bassint == 7) {
-				if (asciiQ) {
-					inversion = "4";
-				} else {
-					inversion = "₄";
-				}
-			}
-			return "";
+	// Triads: the bass indicates the inversion.
+	bool thirdQ = (basspc >= 0) && (basspc == sonority.getThird());
+	bool fifthQ = (basspc >= 0) && (basspc == sonority.getFifth());
+	root = pcnames[r];
+	if (type == sonority_major) {
+		quality = "M";
+	} else if (type == sonority_minor) {
+		quality = "m";
+		root[0] = tolower(root[0]);
+	} else if (type == sonority_diminished) {
+		quality = "d";
+		if (asciiQ) {
+			root += "o";
+		} else {
+			root += "°";
 		}
-
-		// Minor triad.
-		if (has3 && has7) {
-			quality = "m";
-			root = pcnames[r];
-			if (!root.empty()) {
-				root[0] = tolower(root[0]);
-			}
-			if (bassint == 3) {
-				if (asciiQ) {
-					inversion = "6";
-				} else {
-					inversion = "₆";
-				}
-			} else if (bassint == 7) {
-				if (asciiQ) {
-					inversion = "4";
-				} else {
-					inversion = "₄";
-				}
-			}
-
-			return "";
+		root[0] = tolower(root[0]);
+	} else if (type == sonority_augmented) {
+		quality = "A";
+		if (asciiQ) {
+			root += "+";
+		} else {
+			root += "⁺";
 		}
-
-		// Diminished triad.
-		if (has3 && has6) {
-			quality = "d";
-			root = pcnames[r];
-			if (asciiQ) {
-				root += "o";
-			} else {
-				root += "°";
-			}
-			if (!root.empty()) {
-				root[0] = tolower(root[0]);
-			}
-			if (bassint == 3) {
-				if (asciiQ) {
-					inversion = "6";
-				} else {
-					inversion = "₆";
-				}
-			} else if (bassint == 6) {
-				if (asciiQ) {
-					inversion = "4";
-				} else {
-					inversion = "₄";
-				}
-			}
-			return "";
+	}
+	if (thirdQ) {
+		if (asciiQ) {
+			inversion = "6";
+		} else {
+			inversion = "₆";
 		}
-
-		// Augmented triad.
-		if (has4 && has8) {
-			quality = "A";
-			root = pcnames[r];
-			if (asciiQ) {
-				root += "+";
-			} else {
-				root += "⁺";
-			}
-			if (bassint == 4) {
-				if (asciiQ) {
-					inversion = "6";
-				} else {
-					inversion = "₆";
-				}
-			} else if (bassint == 8) {
-				if (asciiQ) {
-					inversion = "4";
-				} else {
-					inversion = "₄";
-				}
-			}
-			return "";
+	} else if (fifthQ) {
+		if (asciiQ) {
+			inversion = "4";
+		} else {
+			inversion = "₄";
 		}
 	}
 
-	// Unknown trichord.
-	quality = "?";
-	root.clear();
-	inversion.clear();
-
 	return "";
 }
 
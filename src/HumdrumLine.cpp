@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Sat Aug  8 12:24:49 PDT 2015
-// Last Modified: Fri Oct 14 11:41:22 PDT 2016 Added insertion functionality
+// Last Modified: Mon Oct 19 00:58:12 PDT 2026
 // Filename:      HumdrumLine.cpp
 // URL:           https://github.com/craigsapp/humlib/blob/master/src/HumdrumLine.cpp
 // Syntax:        C++11; humlib
@@ -17,6 +17,7 @@
 #include "HumdrumLine.h"
 
 #include <algorithm>
+#include <cstring>
 #include <sstream>
 
 using namespace std;
@@ -149,7 +150,7 @@ HumdrumLine::~HumdrumLine() {
 
 void HumdrumLine::setLineFromCsv(const char* csv, const string& separator) {
 	string temp = csv;
-	setLineFromCsv(temp);
+	setLineFromCsv(temp, separator);
 }
 
 
@@ -210,6 +211,9 @@ void HumdrumLine::setLineFromCsv(const string& csv, const string& separator) {
 
 void HumdrumLine::setText(const string& text) {
 	string::assign(text);
+	if (m_owner) {
+		((HumdrumFile*)m_owner)->clearReferenceRecords();
+	}
 }
 
 
@@ -278,7 +282,7 @@ bool HumdrumLine::isKernBoundaryStart(void) const {
 		return false;
 	}
 	for (int i=0; i<getFieldCount(); i++) {
-		if (!token(i)->isDataType("**kern")) {
+		if (!token(i)->isKern()) {
 			continue;
 		}
 		if (token(i)->isNull()) {
@@ -322,7 +326,7 @@ bool HumdrumLine::isKernBoundaryEnd(void) const {
 	}
 	HTp ntok;
 	for (int i=0; i<getFieldCount(); i++) {
-		if (!token(i)->isDataType("**kern")) {
+		if (!token(i)->isKern()) {
 			continue;
 		}
 		ntok = token(i)->getNextToken();
@@ -1043,6 +1047,22 @@ HTp HumdrumLine::getTrackStart(int track) const {
 
 
 
+//////////////////////////////
+//
+// HumdrumLine::getTrackDataType --  Returns the HumDataType ID of the
+//    exclusive interpretation for the given spine/track.
+//
+
+int HumdrumLine::getTrackDataType(int track) const {
+	if (!m_owner) {
+		return datatype_unknown;
+	} else {
+		return ((HumdrumFile*)m_owner)->getTrackDataType(track);
+	}
+}
+
+
+
 //////////////////////////////
 //
 // HumdrumLine::getTrackEnd --  Returns the ending exclusive interpretation
@@ -1279,7 +1299,12 @@ string HumdrumLine::getTokenString(int index) const {
 //////////////////////////////
 //
 // HumdrumLine::createTokensFromLine -- Chop up a HumdrumLine string into
-//     individual tokens.
+//     individual tokens.  Tab characters are found with memchr(), and the
+//     token and tab-count lists are sized in advance from the number of
+//     tabs on the line, so that each token is created with a single copy
+//     of its text.  A run of tabs separates two tokens (the number of tabs
+//     is stored in m_tabs), a leading tab creates an empty first token,
+//     and trailing tabs do not create an empty last token.
 //
 
 int HumdrumLine::createTokensFromLine(void) {
@@ -1292,51 +1317,203 @@ int HumdrumLine::createTokensFromLine(void) {
 	m_tokens.clear();
 	m_tabs.clear();
 	HTp token;
-	char ch = 0;
-	char lastch = 0;
-	string tstring;
 
-	if (this->size() == 0) {
-		token = new HumdrumToken();
+	if ((this->size() == 0) || (this->compare(0, 2, "!!") == 0)) {
+		token = new HumdrumToken(this->c_str());
 		token->setOwner(this);
 		m_tokens.push_back(token);
 		m_tabs.push_back(0);
-	} else if (this->compare(0, 2, "!!") == 0) {
-		token = new HumdrumToken(this->c_str());
+		return 1;
+	}
+
+	const char* start = this->data();
+	const char* end = start + this->size();
+	const char* ptr;
+
+	int tabcount = 0;
+	ptr = start;
+	while ((ptr = (const char*)memchr(ptr, '\t', end - ptr)) != NULL) {
+		tabcount++;
+		ptr++;
+	}
+	m_tokens.reserve(tabcount + 1);
+	m_tabs.reserve(tabcount + 1);
+
+	ptr = start;
+	while (ptr < end) {
+		const char* tab = (const char*)memchr(ptr, '\t', end - ptr);
+		if (tab == NULL) {
+			tab = end;
+		}
+		token = new HumdrumToken();
+		token->assign(ptr, tab - ptr);
 		token->setOwner(this);
 		m_tokens.push_back(token);
-		m_tabs.push_back(0);
+		if (tab == end) {
+			m_tabs.push_back(0);
+			break;
+		}
+		// Parser allows multiple tab characters in a row to represent
+		// a single tab.
+		m_tabs.push_back(1);
+		ptr = tab + 1;
+		while ((ptr < end) && (*ptr == '\t')) {
+			m_tabs.back()++;
+			ptr++;
+		}
+	}
+
+	return (int)m_tokens.size();
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumLine::getTabCount -- Return the number of tab characters after
+//     a token on the line (0 for the last token unless the line has
+//     trailing tabs).
+//
+
+int HumdrumLine::getTabCount(int index) const {
+	if ((index < 0) || (index >= (int)m_tabs.size())) {
+		return 0;
+	}
+	return m_tabs[index];
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumLine::createTokensFromCsv -- Set the text of the line from a
+//     line of CSV data (not including the newline), and create the tokens
+//     for the line at the same time.  The tokens are the same as those
+//     that createTokensFromLine() would create from the equivalent TSV line.
+//     Separators and quotes are found with memchr(), so that lines without
+//     quotes do not need to be examined one character at a time.  Lines
+//     starting with "!!" are not split into fields.
+// default value: separator = ","
+//
+
+int HumdrumLine::createTokensFromCsv(const char* csv, int length,
+		const string& separator) {
+	for (int i=0; i < (int)m_tokens.size(); i++) {
+		delete m_tokens[i];
+		m_tokens[i] = NULL;
+	}
+	m_tokens.clear();
+	m_tabs.clear();
+
+	if ((length > 0) && (csv[length-1] == 0x0d)) {
+		length--;
+	}
+	string& value = *this;
+	if (((length >= 2) && (csv[0] == '!') && (csv[1] == '!')) ||
+			separator.empty()) {
+		// Global comments and reference records are literal.
+		value.assign(csv, length);
+		return createTokensFromLine();
+	}
+	value.clear();
+	value.reserve(length);
+
+	// Fields may contain tab characters, which would be token separators
+	// in the TSV line, so let createTokensFromLine() deal with them.
+	bool tabQ = memchr(csv, '\t', length) != NULL;
+	bool quoteQ = memchr(csv, '"', length) != NULL;
+	const char* end = csv + length;
+	const char* sep = separator.data();
+	int seplen = (int)separator.size();
+	int fieldindex = 0;
+	int fieldstart = 0;
+
+	// addToken: Add a token for the field at the end of value.  An empty
+	// field after the first one adds an extra tab to the previous token
+	// instead of creating a token (and an empty last field is ignored).
+	auto addToken = [&](bool lastQ) {
+		int fieldlength = (int)value.size() - fieldstart;
+		if (!tabQ) {
+			if ((fieldlength > 0) || ((fieldindex == 0) && !lastQ)) {
+				HTp token = new HumdrumToken();
+				token->assign(value, fieldstart, fieldlength);
+				token->setOwner(this);
+				m_tokens.push_back(token);
+				m_tabs.push_back(lastQ ? 0 : 1);
+			} else if (!lastQ && !m_tabs.empty()) {
+				m_tabs.back()++;
+			}
+		}
+		if (!lastQ) {
+			value += '\t';
+			fieldstart = (int)value.size();
+			fieldindex++;
+		}
+	};
+
+	const char* ptr = csv;
+	if (!quoteQ) {
+		while (true) {
+			const char* found = ptr;
+			const char* next = NULL;
+			while (found < end) {
+				found = (const char*)memchr(found, sep[0], end - found);
+				if (found == NULL) {
+					break;
+				}
+				if ((end - found >= seplen) && (memcmp(found, sep, seplen) == 0)) {
+					next = found;
+					break;
+				}
+				found++;
+			}
+			if (next == NULL) {
+				value.append(ptr, end - ptr);
+				addToken(true);
+				break;
+			}
+			value.append(ptr, next - ptr);
+			addToken(false);
+			ptr = next + seplen;
+		}
 	} else {
-		for (int i=0; i<(int)size(); i++) {
-			lastch = ch;
-			ch = getChar(i);
-			if (ch == '\t') {
-				// Parser now allows multiple tab characters in a
-				// row to represent a single tab.
-				if (lastch != '\t') {
-					token = new HumdrumToken(tstring);
-					token->setOwner(this);
-					m_tokens.push_back(token);
-					m_tabs.push_back(1);
-					tstring.clear();
+		bool inquote = false;
+		while (ptr < end) {
+			if (*ptr == '"') {
+				if (!inquote) {
+					inquote = true;
+				} else if ((ptr + 1 < end) && (ptr[1] == '"')) {
+					value += '"';
+					ptr++;
 				} else {
-					if (m_tabs.size() > 0) {
-						m_tabs.back()++;
-					}
+					inquote = false;
 				}
-			} else {
-				tstring += ch;
+				ptr++;
+				continue;
+			}
+			if (!inquote && (end - ptr >= seplen) && (memcmp(ptr, sep, seplen) == 0)) {
+				addToken(false);
+				ptr += seplen;
+				continue;
 			}
+			if (inquote) {
+				// copy quoted text up to the next quote
+				const char* quote = (const char*)memchr(ptr, '"', end - ptr);
+				if (quote == NULL) {
+					quote = end;
+				}
+				value.append(ptr, quote - ptr);
+				ptr = quote;
+				continue;
+			}
+			value += *ptr++;
 		}
-	}
-	if (tstring.size() > 0) {
-		token = new HumdrumToken(tstring);
-		token->setOwner(this);
-		m_tokens.push_back(token);
-		m_tabs.push_back(0);
-		tstring.clear();
+		addToken(true);
 	}
 
+	if (tabQ || value.empty()) {
+		return createTokensFromLine();
+	}
 	return (int)m_tokens.size();
 }
 
@@ -1353,6 +1530,7 @@ int HumdrumLine::createTokensFromLine(void) {
 
 void HumdrumLine::createLineFromTokens(void) {
 	string& iline = *this;
+	bool globalQ = iline.compare(0, 2, "!!") == 0;
 	iline = "";
 	// needed for empty lines for some reason:
 	if (m_tokens.size()) {
@@ -1376,6 +1554,11 @@ void HumdrumLine::createLineFromTokens(void) {
 			}
 		}
 	}
+
+	// A global line may have become (or stopped being) a reference record:
+	if (m_owner && (globalQ || (iline.compare(0, 2, "!!") == 0))) {
+		((HumdrumFile*)m_owner)->clearReferenceRecords();
+	}
 }
 
 
@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Sun May 15 17:51:11 PDT 2022
-// Last Modified: Sun May 15 17:51:14 PDT 2022
+// Last Modified: Sun Oct 18 20:02:16 PDT 2026
 // Filename:      HumdrumToken-midi.cpp
 // URL:           https://github.com/craigsapp/humlib/blob/master/src/HumdrumToken-midi.cpp
 // Syntax:        C++11; humlib
@@ -14,6 +14,7 @@
 #include "HumdrumToken.h"
 
 #include <string>
+#include <string_view>
 #include <vector>
 
 using namespace std;
@@ -37,20 +38,26 @@ void HumdrumToken::getBase40Pitches(vector<int>& output) {
 		output.clear();
 		return;
 	}
-	vector<string> pieces = this->getSubtokens();
-	output.resize(pieces.size());
-	for (int i=0; i<(int)pieces.size(); i++) {
-		if (pieces[i].find("r") != string::npos) {
-			output[i] = 0;
+	output.clear();
+	string piece;
+	for (string_view view : this->getSubtokenViews()) {
+		if (view.empty()) {
+			continue;
+		}
+		piece.assign(view);
+		int value;
+		if (piece.find("r") != string::npos) {
+			value = 0;
 		} else {
-			output[i] = Convert::kernToBase40(pieces[i]);
+			value = Convert::kernToBase40(piece);
 			// sustained notes are negative values:
-			if (pieces[i].find("_") != string::npos) {
-				output[i] = -output[i];
-			} else if (pieces[i].find("]") != string::npos) {
-				output[i] = -output[i];
+			if (piece.find("_") != string::npos) {
+				value = -value;
+			} else if (piece.find("]") != string::npos) {
+				value = -value;
 			}
 		}
+		output.push_back(value);
 	}
 }
 
@@ -152,22 +159,27 @@ void HumdrumToken::getBase40PitchesResolveNull(vector<int>& output) {
 	if (*token == ".") {
 		return;
 	}
-	vector<string> pieces = token->getSubtokens();
-	output.resize(pieces.size());
-	for (int i=0; i<(int)pieces.size(); i++) {
-		if (pieces[i].find("r") != string::npos) {
-			output[i] = 0;
+	string piece;
+	for (string_view view : token->getSubtokenViews()) {
+		if (view.empty()) {
+			continue;
+		}
+		piece.assign(view);
+		int value;
+		if (piece.find("r") != string::npos) {
+			value = 0;
 		} else {
-			output[i] = Convert::kernToBase40(pieces[i]);
+			value = Convert::kernToBase40(piece);
 			// sustained notes are negative values:
 			if (nullQ) {
-				output[i] = -output[i];
-			} else if (pieces[i].find("_") != string::npos) {
-				output[i] = -output[i];
-			} else if (pieces[i].find("]") != string::npos) {
-				output[i] = -output[i];
+				value = -value;
+			} else if (piece.find("_") != string::npos) {
+				value = -value;
+			} else if (piece.find("]") != string::npos) {
+				value = -value;
 			}
 		}
+		output.push_back(value);
 	}
 }
 
@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Sat Aug  8 12:24:49 PDT 2015
-// Last Modified: Sun Aug  9 21:03:12 PDT 2015
+// Last Modified: Mon Oct 19 00:58:12 PDT 2026
 // Filename:      HumdrumToken.cpp
 // URL:           https://github.com/craigsapp/humlib/blob/master/src/HumdrumToken.cpp
 // Syntax:        C++11; humlib
@@ -18,6 +18,9 @@
 #include "HumdrumToken.h"
 
 #include <cstring>
+#include <functional>
+#include <string_view>
+#include <utility>
 
 using namespace std;
 
@@ -154,6 +157,7 @@ HumdrumToken& HumdrumToken::operator=(HumdrumToken& token) {
 	}
 	(string)(*this)   = (string)token;
 	(HumHash)(*this)  = (HumHash)token;
+	clearSubtokenStarts();
 
 	m_address         = token.m_address;
 	m_address.m_owner = NULL;
@@ -173,7 +177,9 @@ HumdrumToken& HumdrumToken::operator=(HumdrumToken& token) {
 
 
 HumdrumToken& HumdrumToken::operator=(const string& token) {
-	(string)(*this) = token;
+	// setText() before the owner is cleared, so that the data type of
+	// the track is updated if the token was an exclusive interpretation.
+	setText(token);
 
 	m_address.m_owner = NULL;
 	m_duration        = 0;
@@ -192,7 +198,7 @@ HumdrumToken& HumdrumToken::operator=(const string& token) {
 
 
 HumdrumToken& HumdrumToken::operator=(const char* token) {
-	(string)(*this) = token;
+	setText(token);
 
 	m_address.m_owner = NULL;
 	m_duration        = 0;
@@ -386,6 +392,20 @@ const string& HumdrumToken::getDataType(void) const {
 }
 
 
+
+//////////////////////////////
+//
+// HumdrumToken::getDataTypeId -- Get the HumDataType ID of the exclusive
+//     interpretation for the token, such as datatype_kern.  This is
+//     faster than getDataType() for comparing data types.
+// @SEEALSO: isDataType
+//
+
+int HumdrumToken::getDataTypeId(void) const {
+	return m_address.getDataTypeId();
+}
+
+
 /////////////////////////////
 //
 // HumdrumToken::getExclusiveInterpretation -- Get the exclusive
@@ -414,6 +434,11 @@ bool HumdrumToken::isDataType(const string& dtype) const {
 }
 
 
+bool HumdrumToken::isDataType(int datatype) const {
+	return getDataTypeId() == datatype;
+}
+
+
 
 //////////////////////////////
 //
@@ -459,7 +484,7 @@ bool HumdrumToken::isDataTypeLike(const string& dtype) const {
 //
 
 bool HumdrumToken::isKern(void) const {
-	return isDataType("**kern");
+	return getDataTypeId() == datatype_kern;
 }
 
 
@@ -475,10 +500,14 @@ bool HumdrumToken::isKern(void) const {
 //
 
 bool HumdrumToken::isKernLike(void) const {
-	string dtype = getDataType();
-	if (dtype == "**kern") {
+	int id = getDataTypeId();
+	if (id == datatype_kern) {
 		return true;
-	} else if (dtype.compare(0, 7, "**kern-") == 0) {
+	} else if ((id == datatype_unknown) || (id == datatype_mens)) {
+		return false;
+	}
+	const string& dtype = getDataType();
+	if (dtype.compare(0, 7, "**kern-") == 0) {
 		return true;
 	} else if (dtype == "**kernyy") {
 		return true;
@@ -496,7 +525,7 @@ bool HumdrumToken::isKernLike(void) const {
 //
 
 bool HumdrumToken::isMens(void) const {
-	return isDataType("**mens");
+	return getDataTypeId() == datatype_mens;
 }
 
 
@@ -512,10 +541,14 @@ bool HumdrumToken::isMens(void) const {
 //
 
 bool HumdrumToken::isMensLike(void) const {
-	string dtype = getDataType();
-	if (dtype == "**mens") {
+	int id = getDataTypeId();
+	if (id == datatype_mens) {
 		return true;
-	} else if (dtype.compare(0, 7, "**mens-") == 0) {
+	} else if ((id == datatype_unknown) || (id == datatype_kern)) {
+		return false;
+	}
+	const string& dtype = getDataType();
+	if (dtype.compare(0, 7, "**mens-") == 0) {
 		return true;
 	}
 	return false;
@@ -1477,7 +1510,7 @@ bool HumdrumToken::isNoteAttack(void) {
 //
 
 bool HumdrumToken::isInvisible(void) {
-	if (!isDataType("**kern")) {
+	if (!isKern()) {
 			return false;
 	}
 	if (isBarline()) {
@@ -1501,7 +1534,7 @@ bool HumdrumToken::isInvisible(void) {
 //
 
 bool HumdrumToken::isGrace(void) {
-	if (!isDataType("**kern")) {
+	if (!isKern()) {
 			return false;
 	}
 	if (!isData()) {
@@ -1521,7 +1554,7 @@ bool HumdrumToken::isGrace(void) {
 //
 
 bool HumdrumToken::isClef(void) {
-	if (!(isDataType("**kern") || isDataType("**mens"))) {
+	if (!(isKern() || isMens())) {
 			return false;
 	}
 	if (!isInterpretation()) {
@@ -1541,7 +1574,7 @@ bool HumdrumToken::isClef(void) {
 //
 
 bool HumdrumToken::isModernClef(void) {
-	if (!(isDataType("**kern") || isDataType("**mens"))) {
+	if (!(isKern() || isMens())) {
 			return false;
 	}
 	if (!isInterpretation()) {
@@ -1561,7 +1594,7 @@ bool HumdrumToken::isModernClef(void) {
 //
 
 bool HumdrumToken::isOriginalClef(void) {
-	if (!(isDataType("**kern") || isDataType("**mens"))) {
+	if (!(isKern() || isMens())) {
 			return false;
 	}
 	if (!isInterpretation()) {
@@ -2005,7 +2038,7 @@ string HumdrumToken::getInstrumentAbbreviation(void) {
 //
 
 bool HumdrumToken::hasSlurStart(void) {
-	if (isDataType("**kern")) {
+	if (isKern()) {
 		if (Convert::hasKernSlurStart((string)(*this))) {
 			return true;
 		}
@@ -2022,7 +2055,7 @@ bool HumdrumToken::hasSlurStart(void) {
 //
 
 bool HumdrumToken::hasSlurEnd(void) {
-	if (isDataType("**kern")) {
+	if (isKern()) {
 		if (Convert::hasKernSlurEnd((string)(*this))) {
 			return true;
 		}
@@ -2238,7 +2271,7 @@ bool HumdrumToken::hasObliquaLigatureEnd(void) {
 //
 
 bool HumdrumToken::isSecondaryTiedNote(void) {
-	if (isDataType("**kern")) {
+	if (isKern()) {
 		if (Convert::isKernSecondaryTiedNote((string)(*this))) {
 			return true;
 		}
@@ -2610,19 +2643,35 @@ string HumdrumToken::getTrackString(void) const {
 // HumdrumToken::getSubtokenCount -- Returns the number of sub-tokens in
 //     a token.  The input parameter is the sub-token separator.  If the
 //     separator comes at the start or end of the token, then there will
-//     be empty sub-token(s) included in the count.
+//     be empty sub-token(s) included in the count.  An empty separator
+//     counts characters.  The non-const version stores the subtoken
+//     offsets for later calls to getSubtoken() and getSubtokenView().
 // default value: separator = " "
 // @SEEALSO: getSubtoken
 //
 
 int HumdrumToken::getSubtokenCount(const string& separator) const {
-	int count = 0;
+	if (separator.empty()) {
+		return (int)size();
+	}
+	if (hasSubtokenStarts(separator)) {
+		return (int)m_subtokenstarts.size();
+	}
+	int output = 1;
 	string::size_type start = 0;
 	while ((start = string::find(separator, start)) != string::npos) {
-		count++;
 		start += separator.size();
+		output++;
+	}
+	return output;
+}
+
+
+int HumdrumToken::getSubtokenCount(const string& separator) {
+	if (!separator.empty()) {
+		prepareSubtokenStarts(separator);
 	}
-	return count+1;
+	return std::as_const(*this).getSubtokenCount(separator);
 }
 
 
@@ -2638,109 +2687,356 @@ int HumdrumToken::getSubtokenCount(const string& separator) const {
 //
 
 string HumdrumToken::getSubtoken(int index, const string& separator) const {
-    if (index < 0) return "";
+	return string(getSubtokenView(index, separator));
+}
 
-    const string& s = *this;
 
-    // If "separator" is empty, treat "index" as a character index.
-    if (separator.empty()) {
-        if (index >= 0 && static_cast<size_t>(index) < s.size()) {
-            return string(1, s[static_cast<size_t>(index)]);
-        } else {
-            return "";
-        }
-    }
+string HumdrumToken::getSubtoken(int index, const string& separator) {
+	return string(getSubtokenView(index, separator));
+}
+
 
-    size_t pos = 0;
-    int current = 0;
 
-    while (true) {
-        size_t next = s.find(separator, pos);
+/////////////////////////////
+//
+// HumdrumToken::getSubtokenView -- Same as getSubtoken(), but returns a
+//    view into the token text rather than a copy.  The view is valid
+//    until the token text is changed.  The non-const version caches the
+//    offsets of the subtokens, so calling it for each index does not
+//    split the token each time.  The const version only reads the cache,
+//    so it can be used in several threads at a time.
+// default value: separator = " "
+//
+
+string_view HumdrumToken::getSubtokenView(int index, const string& separator) const {
+	if (index < 0) {
+		return string_view();
+	}
+	string_view text(*this);
 
-        if (current == index) {
-            // We are at the target field: return up to the next separator (or end)
-            if (next == string::npos) {
-                return s.substr(pos);
-            } else {
-                return s.substr(pos, next - pos);
-            }
-        }
+	// If "separator" is empty, treat "index" as a character index.
+	if (separator.empty()) {
+		if (index < (int)text.size()) {
+			return text.substr(index, 1);
+		}
+		return string_view();
+	}
 
-        // Not at the target yet: advance to the next field
-        if (next == string::npos) {
-            return "";  // ran out of fields
-        }
-        pos = next + separator.size();
-        ++current;
-    }
+	size_t start = 0;
+	size_t end = text.size();
+	if (hasSubtokenStarts(separator)) {
+		if (index >= (int)m_subtokenstarts.size()) {
+			return string_view();
+		}
+		start = m_subtokenstarts[index];
+		if (index + 1 < (int)m_subtokenstarts.size()) {
+			end = m_subtokenstarts[index + 1] - separator.size();
+		}
+	} else {
+		for (int i=0; i<index; i++) {
+			start = text.find(separator, start);
+			if (start == string_view::npos) {
+				return string_view();
+			}
+			start += separator.size();
+		}
+		end = text.find(separator, start);
+		if (end == string_view::npos) {
+			end = text.size();
+		}
+	}
+	return text.substr(start, end - start);
 }
 
 
+string_view HumdrumToken::getSubtokenView(int index, const string& separator) {
+	if (!separator.empty()) {
+		prepareSubtokenStarts(separator);
+	}
+	return std::as_const(*this).getSubtokenView(index, separator);
+}
+
+
+
+/////////////////////////////
+//
+// HumdrumToken::getSubtokenViews -- Return the subtokens as views into
+//    the token text, for use in a range-based for loop.  Unlike
+//    getSubtokens(), empty subtokens are included.
+// default value: separator = " "
+//
+// Example:
+//    for (string_view subtok : token->getSubtokenViews()) {
+//       if (subtok.find('r') != string_view::npos) { ... }
+//    }
+//
+
+HumSubtokenRange HumdrumToken::getSubtokenViews(const string& separator) const {
+	return HumSubtokenRange(*this, separator);
+}
+
 
 
 //////////////////////////////
 //
 // HumdrumToken::getSubtokens -- Return the list of subtokens as an array
-//     of strings.
+//     of strings.  Empty subtokens are not included.
 //     default value: separator = " "
 //
 
 std::vector<std::string> HumdrumToken::getSubtokens(const std::string& separator) const {
-    std::vector<std::string> out;
-    const std::string& s = *this;
+	std::vector<std::string> out;
+	if (separator.empty()) {
+		if (!empty()) {
+			out.push_back(*this);
+		}
+		return out;
+	}
+	for (string_view piece : getSubtokenViews(separator)) {
+		if (!piece.empty()) {
+			out.emplace_back(piece);
+		}
+	}
+	return out;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumToken::replaceSubtoken -- Replace a subtoken, where the index
+//     counts only non-empty subtokens (as in getSubtokens()).  Empty
+//     subtokens are removed from the output.
+//     default value: separator = " "
+//
+
+void HumdrumToken::replaceSubtoken(int index, const std::string& newsubtok,
+		const std::string& separator) {
+	if (index < 0) {
+		return;
+	}
+	if (separator.empty()) {
+		if ((index == 0) && !empty()) {
+			setText(newsubtok);
+		}
+		return;
+	}
 
-    if (separator.empty()) {
-        if (!s.empty()) out.push_back(s);
-        return out;
-    }
+	std::string output;
+	int count = 0;
+	bool found = false;
+	for (string_view piece : getSubtokenViews(separator)) {
+		if (piece.empty()) {
+			continue;
+		}
+		if (count > 0) {
+			output += separator;
+		}
+		if (count == index) {
+			output += newsubtok;
+			found = true;
+		} else {
+			output.append(piece);
+		}
+		count++;
+	}
+	if (!found) {
+		return;
+	}
 
-    std::string::size_type start = 0;
-    while (true) {
-        auto pos = s.find(separator, start);
-        if (pos == std::string::npos) {
-            if (start < s.size()) out.emplace_back(s.substr(start)); // last piece
-            break;
-        }
-        if (pos > start) out.emplace_back(s.substr(start, pos - start)); // ignore empties
-        start = pos + separator.size();
-    }
-    return out;
+	// Update the HumdrumToken text
+	setText(output);
 }
 
 
 
 //////////////////////////////
 //
-// HumdrumToken::replaceSubtoken --
-//     default value: separator = " "
+// HumdrumToken::prepareSubtokenStarts -- Store the start offsets of the
+//     subtokens for the given separator, unless they are already stored.
+//     The separator must not be empty.
 //
 
+void HumdrumToken::prepareSubtokenStarts(const string& separator) {
+	if (hasSubtokenStarts(separator)) {
+		return;
+	}
+	m_subtokenstarts.clear();
+	m_subtokenstarts.push_back(0);
+	string::size_type start = 0;
+	while ((start = string::find(separator, start)) != string::npos) {
+		start += separator.size();
+		m_subtokenstarts.push_back((int)start);
+	}
+	m_subtokenseparator = separator;
+	m_subtokenlength = size();
+	m_subtokenhash = std::hash<string_view>()(string_view(*this));
+	m_subtokenvalid = true;
+}
+
+
+
 //////////////////////////////
 //
-// HumdrumToken::replaceSubtoken --
-//     default value: separator = " "
+// HumdrumToken::hasSubtokenStarts -- Return true if the stored subtoken
+//     offsets are for the separator and the current text of the token.
+//     The length and hash of the text are compared to the ones when the
+//     offsets were stored, so that changes to the text through the
+//     std::string interface are also noticed.
 //
 
-void HumdrumToken::replaceSubtoken(int index, const std::string& newsubtok,
-                const std::string& separator) {
+bool HumdrumToken::hasSubtokenStarts(const string& separator) const {
+	if (!m_subtokenvalid || (m_subtokenlength != size())) {
+		return false;
+	}
+	if (m_subtokenseparator != separator) {
+		return false;
+	}
+	return m_subtokenhash == std::hash<string_view>()(string_view(*this));
+}
+
+
 
-	if (index < 0) return;
+//////////////////////////////
+//
+// HumdrumToken::clearSubtokenStarts -- Remove the cached subtoken offsets
+//     after the token text has been changed.
+//
 
-	std::vector<std::string> subtokens = getSubtokens(separator);
-	if (index >= static_cast<int>(subtokens.size())) return;
+void HumdrumToken::clearSubtokenStarts(void) {
+	m_subtokenstarts.clear();
+	m_subtokenvalid = false;
+}
 
-	// Replace the requested subtoken safely
-	subtokens[index] = newsubtok;
 
-	// Reconstruct the token text
-	std::string output;
-	for (std::size_t i = 0; i < subtokens.size(); i++) {
-		if (i > 0) output += separator;
-		output += subtokens[i];
+
+//////////////////////////////
+//
+// HumSubtokenIterator::HumSubtokenIterator -- The default constructor is
+//     the end iterator.
+//
+
+HumSubtokenIterator::HumSubtokenIterator(void) {
+	// do nothing
+}
+
+
+HumSubtokenIterator::HumSubtokenIterator(const string& text,
+		const string& separator) {
+	m_text = &text;
+	m_separator = &separator;
+	if (separator.empty() && text.empty()) {
+		// no characters to iterate over
+		return;
 	}
+	m_start = 0;
+	findEnd();
+}
 
-	// Update the HumdrumToken text
-	setText(output);
+
+
+//////////////////////////////
+//
+// HumSubtokenIterator::operator* -- Return the current subtoken.
+//
+
+string_view HumSubtokenIterator::operator*(void) const {
+	if (m_start == string::npos) {
+		return string_view();
+	}
+	return string_view(*m_text).substr(m_start, m_end - m_start);
+}
+
+
+
+//////////////////////////////
+//
+// HumSubtokenIterator::operator++ -- Move to the next subtoken.
+//
+
+HumSubtokenIterator& HumSubtokenIterator::operator++(void) {
+	if (m_start == string::npos) {
+		return *this;
+	}
+	if (m_end >= m_text->size()) {
+		m_start = string::npos;
+		m_end = string::npos;
+		return *this;
+	}
+	m_start = m_end + m_separator->size();
+	m_index++;
+	findEnd();
+	return *this;
+}
+
+
+
+//////////////////////////////
+//
+// HumSubtokenIterator::operator== -- Iterators are equal if they are at
+//     the same position (all end iterators are equal).
+//
+
+bool HumSubtokenIterator::operator==(const HumSubtokenIterator& other) const {
+	return m_start == other.m_start;
+}
+
+
+bool HumSubtokenIterator::operator!=(const HumSubtokenIterator& other) const {
+	return m_start != other.m_start;
+}
+
+
+
+//////////////////////////////
+//
+// HumSubtokenIterator::findEnd -- Find the end of the current subtoken.
+//
+
+void HumSubtokenIterator::findEnd(void) {
+	if (m_separator->empty()) {
+		m_end = m_start + 1;
+		return;
+	}
+	m_end = m_text->find(*m_separator, m_start);
+	if (m_end == string::npos) {
+		m_end = m_text->size();
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumSubtokenRange::HumSubtokenRange -- The separator is copied so that
+//     the range can be used with a temporary separator string.
+//
+
+HumSubtokenRange::HumSubtokenRange(const string& text, const string& separator) {
+	m_text = &text;
+	m_separator = separator;
+}
+
+
+
+//////////////////////////////
+//
+// HumSubtokenRange::begin --
+//
+
+HumSubtokenIterator HumSubtokenRange::begin(void) const {
+	return HumSubtokenIterator(*m_text, m_separator);
+}
+
+
+
+//////////////////////////////
+//
+// HumSubtokenRange::end --
+//
+
+HumSubtokenIterator HumSubtokenRange::end(void) const {
+	return HumSubtokenIterator();
 }
 
 
@@ -2798,7 +3094,45 @@ void HumdrumToken::setParameters(const string& pdata, HumdrumToken* ptok) {
 //
 
 void HumdrumToken::setText(const string& text) {
+	bool exinterp = compare(0, 2, "**") == 0;
+	bool global = compare(0, 2, "!!") == 0;
 	string::assign(text);
+	clearSubtokenStarts();
+	if (exinterp || (compare(0, 2, "**") == 0)) {
+		updateDataType();
+	}
+	if (global || (compare(0, 2, "!!") == 0)) {
+		// The token may have become (or stopped being) a reference record.
+		HLp line = getOwner();
+		if (line && line->getOwner()) {
+			line->getOwner()->clearReferenceRecords();
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumToken::updateDataType -- If the token is the starting exclusive
+//     interpretation of a track, update the data type ID of the track
+//     after the text of the token has been changed.
+//
+
+void HumdrumToken::updateDataType(void) {
+	HLp line = getOwner();
+	if (line == NULL) {
+		return;
+	}
+	int track = getTrack();
+	if (line->getTrackStart(track) != this) {
+		return;
+	}
+	HumdrumFile* infile = line->getOwner();
+	if (infile == NULL) {
+		return;
+	}
+	infile->updateTrackDataType(track);
 }
 
 
@@ -3444,7 +3778,7 @@ int  HumdrumToken::getStrandIndex(void) const {
 //
 
 int HumdrumToken::getBeamStartElisionLevel(int index) const {
-	if (isDataType("**kern") || isDataType("**mens")) {
+	if (isKern() || isMens()) {
 		return Convert::getKernBeamStartElisionLevel((string)(*this), index);
 	} else {
 		return -1;
@@ -3462,7 +3796,7 @@ int HumdrumToken::getBeamStartElisionLevel(int index) const {
 //
 
 int HumdrumToken::getSlurStartElisionLevel(int index) const {
-	if (isDataType("**kern") || isDataType("**mens")) {
+	if (isKern() || isMens()) {
 		return Convert::getKernSlurStartElisionLevel((string)(*this), index);
 	} else {
 		return -1;
@@ -3480,7 +3814,7 @@ int HumdrumToken::getSlurStartElisionLevel(int index) const {
 //
 
 int HumdrumToken::getPhraseStartElisionLevel(int index) const {
-	if (isDataType("**kern") || isDataType("**mens")) {
+	if (isKern() || isMens()) {
 		return Convert::getKernPhraseStartElisionLevel((string)(*this), index);
 	} else {
 		return -1;
@@ -3498,7 +3832,7 @@ int HumdrumToken::getPhraseStartElisionLevel(int index) const {
 //
 
 int HumdrumToken::getBeamEndElisionLevel(int index) const {
-	if (isDataType("**kern") || isDataType("**mens")) {
+	if (isKern() || isMens()) {
 		return Convert::getKernBeamEndElisionLevel((string)(*this), index);
 	} else {
 		return -1;
@@ -3516,7 +3850,7 @@ int HumdrumToken::getBeamEndElisionLevel(int index) const {
 //
 
 int HumdrumToken::getSlurEndElisionLevel(int index) const {
-	if (isDataType("**kern") || isDataType("**mens")) {
+	if (isKern() || isMens()) {
 		return Convert::getKernSlurEndElisionLevel((string)(*this), index);
 	} else {
 		return -1;
@@ -3534,7 +3868,7 @@ int HumdrumToken::getSlurEndElisionLevel(int index) const {
 //
 
 int HumdrumToken::getPhraseEndElisionLevel(int index) const {
-	if (isDataType("**kern")) {
+	if (isKern()) {
 		return Convert::getKernPhraseEndElisionLevel((string)(*this), index);
 	} else {
 		return -1;
@@ -3755,7 +4089,7 @@ ostream& HumdrumToken::printXmlBaseInfo(ostream& out, int level,
 	out << "</tokenType>\n";
 
 	// <tokenFunction>
-	if (isDataType("**kern")) {
+	if (isKern()) {
 		if (isNote()) {
 			out << Convert::repeatString(indent, level) << "<tokenFunction>";
 			out << "note" << "</tokenFunction>\n";
@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Fri Nov 25 19:41:43 PST 2016
-// Last Modified: Fri Nov 25 19:41:49 PST 2016
+// Last Modified: Sun Oct 18 18:20:44 PDT 2026
 // Filename:      NoteGrid.cpp
 // URL:           https://github.com/craigsapp/humlib/blob/master/src/NoteGrid.cpp
 // Syntax:        C++11; humlib
@@ -130,17 +130,19 @@ bool NoteGrid::load(HumdrumFile& infile) {
 	vector<HTp> current;
 	HumRegex hre;
 	for (int i=0; i<infile.getLineCount(); i++) {
+		const vector<int>& kernfields = infile.getKernFieldIndexes(i);
 		if (infile[i].isInterpretation()) {
-			for (int j=0; j<infile[i].getFieldCount(); j++) {
-				if (!infile[i].token(j)->isKern()) {
+			for (int j : kernfields) {
+				HTp token = infile.token(i, j);
+				if (token->find("*M") == string::npos) {
 					continue;
 				}
-				track = infile.token(i, j)->getTrack();
-				if (hre.search(*infile.token(i, j), "\\*M(\\d+)/(\\d+)%(\\d+)")) {
+				track = token->getTrack();
+				if (hre.search(*token, "\\*M(\\d+)/(\\d+)%(\\d+)")) {
 					metertops[track] = hre.getMatchInt(1);
 					meterbots[track] = hre.getMatchInt(2);
 					meterbots[track] /= hre.getMatchInt(3);
-				} else if (hre.search(*infile.token(i, j), "\\*M(\\d+)/(\\d+)")) {
+				} else if (hre.search(*token, "\\*M(\\d+)/(\\d+)")) {
 					metertops[track] = hre.getMatchInt(1);
 					meterbots[track] = hre.getMatchInt(2);
 				} else {
@@ -152,24 +154,15 @@ bool NoteGrid::load(HumdrumFile& infile) {
 		if (!infile[i].isData()) {
 			continue;
 		}
-		track = 0;
-		//attack = 0;
 		current.clear();
-		for (int j=0; j<infile[i].getFieldCount(); j++) {
-			lasttrack = track;
+		for (int j : kernfields) {
 			track = infile.token(i, j)->getTrack();
-			if (!infile[i].token(j)->isDataType("**kern")) {
-				continue;
-			}
+			lasttrack = j > 0 ? infile.token(i, j-1)->getTrack() : 0;
 			if (track == lasttrack) {
 				// secondary voice: ignore
 				continue;
 			}
 			current.push_back(infile.token(i, j));
-			if (!(current.back()->isRest()
-					|| current.back()->isSecondaryTiedNote())) {
-				//attack++;
-			}
 		}
 		if (current.size() != kernspines.size()) {
 			cerr << "Error: Unequal vector sizes " << current.size()
@@ -44,6 +44,18 @@ Tool_autobeam::Tool_autobeam(void) {
 
 
 
+//////////////////////////////
+//
+// Tool_autobeam::isReusable -- Instances can be run on several files.
+//     Time signatures and track lists are recalculated for each file.
+//
+
+bool Tool_autobeam::isReusable(void) {
+	return true;
+}
+
+
+
 /////////////////////////////////
 //
 // Tool_autobeam::run -- Primary interfaces to the tool.
@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Sun Dec 26 17:03:54 PST 2010
-// Last Modified: Tue May 30 15:35:10 CEST 2017
+// Last Modified: Sun Oct 18 17:04:38 PDT 2026
 // Filename:      tool-cint.cpp
 // URL:           https://github.com/craigsapp/minHumdrum/blob/master/src/tool-cint.cpp
 // Syntax:        C++11; humlib
@@ -81,6 +81,7 @@ Tool_cint::Tool_cint(void) {
 	define("search=s:",                           "search string");
 	define("mark=b",                              "mark matches notes from searches in data");
 	define("count=b",                             "count matched modules from search query");
+	define("stats|statistics=b",                  "only print JSON summary of module counts for all inputs");
 	define("debug=b",                             "determine bad input line number");
 	define("author=b",                            "author of the program");
 	define("version=b",                           "complation info");
@@ -136,7 +137,7 @@ bool Tool_cint::run(HumdrumFile& infile) {
 	processFile(infile);
 
 
-	if (hasAnyText()) {
+	if (hasAnyText() || statsQ) {
 		// getAllText(cout);
 	} else {
 		// Re-load the text for each line from their tokens.
@@ -147,6 +148,34 @@ bool Tool_cint::run(HumdrumFile& infile) {
 }
 
 
+
+//////////////////////////////
+//
+// Tool_cint::finally -- Print the JSON summary of the module counts
+//     when using --stats.
+//
+
+void Tool_cint::finally(void) {
+	if (!statsQ) {
+		return;
+	}
+	m_stats.printJson(m_free_text, "cint");
+}
+
+
+
+//////////////////////////////
+//
+// Tool_cint::getStatistics -- Return the module counts collected with
+//     --stats.  Counts from tool objects used in separate threads can be
+//     combined with HumStatistics::merge().
+//
+
+HumStatistics& Tool_cint::getStatistics(void) {
+	return m_stats;
+}
+
+
 ///////////////////////////////////////////////////////////////////////////
 //
 // NoteNode class functions:
@@ -267,8 +296,15 @@ int Tool_cint::processFile(HumdrumFile& infile) {
 		exit(0);
 	}
 
+	if (statsQ) {
+		m_stats.addFile();
+	}
+
 	int count = 0;
-	if (latticeQ) {
+	if (statsQ && !suspensionsQ) {
+		count = printCombinations(notes, infile, ktracks, reverselookup,
+				Chaincount, retrospective, SearchString);
+	} else if (latticeQ) {
 		printLattice(notes, infile, ktracks, reverselookup, Chaincount);
 	} else if (interleavedQ) {
 		printLatticeInterleaved(notes, infile, ktracks, reverselookup,
@@ -667,7 +703,18 @@ int Tool_cint::printCombinationModulePrepare(ostream& out, const string& filenam
 // ggg
 	int status = printCombinationModule(tempstream, filename, notes,
 			n, startline, part1, part2, retrospective, notemarker);
-	if (status) {
+	if (status && statsQ) {
+		string module = tempstream.str();
+		if (!suspensionsQ) {
+			m_stats.increment("modules", module);
+			m_stats.increment("summary", "modules");
+		}
+		if (searchQ && hre.search(module, searchstring)) {
+			count++;
+			m_stats.increment("matches", module);
+			m_stats.increment("summary", "matches");
+		}
+	} else if (status) {
 		if (raw2Q || rawQ) {
 			tempstream << "\n";
 		}
@@ -2707,6 +2754,17 @@ void Tool_cint::initialize(void) {
 		SearchString = getString("search");
 	}
 
+	statsQ = getBoolean("stats");
+	if (statsQ) {
+		// Only collect counts: suppress all score and module output.
+		countQ    = 1;
+		markQ     = 0;
+		retroQ    = 0;
+		locationQ = 0;
+		debugQ    = 0;
+		pitchesQ  = 0;
+	}
+
 }
 
 
@@ -291,16 +291,8 @@ bool cmr_note_info::isLeapBefore(HTp token) {
 //
 
 double cmr_note_info::getMetricLevel(HTp token) {
-	HumNum beat = token->getDurationFromBarline();
-	if (!beat.isInteger()) { // anything less than quarter note level
-		return -1;
-	} else if (beat.getNumerator() % 4 == 0) { // whole note level
-		return 2;
-	} else if (beat.getNumerator() % 2 == 0) { // half note level
-		return 1;
-	} else { // quarter note level
-		return 0;
-	}
+	HumdrumFile& infile = *token->getOwner()->getOwner();
+	return infile.getMetricPosition(token->getLineIndex()).weight;
 }
 
 
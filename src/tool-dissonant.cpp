@@ -2,7 +2,7 @@
 // Programmer:    Alexander Morgan
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Sat Aug  8 12:24:49 PDT 2015
-// Last Modified: Wed May 24 15:39:19 CEST 2017
+// Last Modified: Sun Oct 18 16:52:13 PDT 2026
 // Filename:      tool-dissonant.cpp
 // URL:           https://github.com/craigsapp/humlib/blob/master/src/tool-dissonant.cpp
 // Syntax:        C++11; humlib
@@ -49,6 +49,7 @@ Tool_dissonant::Tool_dissonant(void) {
 	define("i|x|e|exinterp=s:**cdata-rdiss", "specify exinterp for **diss spines");
 	define("color|colorize|color-by-rhythm=b",        "color dissonant notes by beat level");
 	define("color2|colorize2|color-by-interval=b",    "color dissonant notes by dissonant interval");
+	define("stats|statistics=b",             "only print JSON summary of dissonance counts for all inputs");
 }
 
 
@@ -105,6 +106,8 @@ bool Tool_dissonant::run(HumdrumFile& infile, ostream& out) {
 
 bool Tool_dissonant::run(HumdrumFile& infile) {
 
+	m_statsQ = getBoolean("stats");
+
 	if (getBoolean("voice-number")) {
 		m_voicenumQ = true;
 	}
@@ -151,8 +154,8 @@ bool Tool_dissonant::run(HumdrumFile& infile) {
 	suppressQ = getBoolean("suppress");
 	voiceFuncsQ = getBoolean("voice-functions");
 
-	vector<vector<string>> results;
-	vector<vector<string>> results2;
+	vector<vector<int>> results;
+	vector<vector<int>> results2;
 	vector<vector<string>> voiceFuncs;
 	vector<vector<NoteCell*>> attacks;
 	vector<vector<NoteCell*>> attacks2;
@@ -160,7 +163,7 @@ bool Tool_dissonant::run(HumdrumFile& infile) {
 	attacks.resize(grid.getVoiceCount());
 	results.resize(grid.getVoiceCount());
 	for (int i=0; i<(int)results.size(); i++) {
-		results[i].resize(infile.getLineCount());
+		results[i].resize(infile.getLineCount(), NO_LABEL);
 	}
 	doAnalysis(results, grid, attacks, getBoolean("debug"));
 
@@ -176,7 +179,7 @@ bool Tool_dissonant::run(HumdrumFile& infile) {
 		results2.resize(grid2.getVoiceCount());
 		for (int i=0; i<(int)results2.size(); i++) {
 			results2[i].clear();
-			results2[i].resize(infile.getLineCount());
+			results2[i].resize(infile.getLineCount(), NO_LABEL);
 		}
 		vector<vector<NoteCell*>> attacks2;
 		doAnalysis(results2, grid2, attacks2, getBoolean("debug"));
@@ -184,16 +187,19 @@ bool Tool_dissonant::run(HumdrumFile& infile) {
 	}
 
 	if (suppressQ) {
-		if (getBoolean("count")) {
+		if (m_statsQ) {
+			addStatistics(results2);
+			return true;
+		} else if (getBoolean("count")) {
 			printCountAnalysis(results2);
 			return false;
 		} else {
 			string exinterp = getString("exinterp");
 			vector<HTp> kernspines = infile.getKernSpineStartList();
-			infile.appendDataSpine(results2.back(), "", exinterp);
+			infile.appendDataSpine(getLabelStrings(results2.back()), "", exinterp);
 			for (int i = (int)results2.size()-1; i>0; i--) {
 				int track = kernspines[i]->getTrack();
-				infile.insertDataSpineBefore(track, results2[i-1], "", exinterp);
+				infile.insertDataSpineBefore(track, getLabelStrings(results2[i-1]), "", exinterp);
 			}
 			printColorLegend(infile);
 
@@ -215,6 +221,10 @@ bool Tool_dissonant::run(HumdrumFile& infile) {
 		for (int i=0; i<grid.getVoiceCount(); i++) {
 			findCadentialVoiceFunctions(results, grid, attacks[i], voiceFuncs, i);
 		}
+		if (m_statsQ) {
+			addStatistics(voiceFuncs);
+			return true;
+		}
 
 		string exinterp = getString("exinterp");
 		vector<HTp> kernspines = infile.getKernSpineStartList();
@@ -231,16 +241,19 @@ bool Tool_dissonant::run(HumdrumFile& infile) {
 		infile.createLinesFromTokens();
 		return true;
 	} else {
-		if (getBoolean("count")) {
+		if (m_statsQ) {
+			addStatistics(results);
+			return true;
+		} else if (getBoolean("count")) {
 			printCountAnalysis(results);
 			return false;
 		} else {
 			string exinterp = getString("exinterp");
 			vector<HTp> kernspines = infile.getKernSpineStartList();
-			infile.appendDataSpine(results.back(), "", exinterp);
+			infile.appendDataSpine(getLabelStrings(results.back()), "", exinterp);
 			for (int i = (int)results.size()-1; i>0; i--) {
 				int track = kernspines[i]->getTrack();
-				infile.insertDataSpineBefore(track, results[i-1], "", exinterp);
+				infile.insertDataSpineBefore(track, getLabelStrings(results[i-1]), "", exinterp);
 			}
 			printColorLegend(infile);
 			adjustColorization(infile);
@@ -252,6 +265,34 @@ bool Tool_dissonant::run(HumdrumFile& infile) {
 
 
 
+//////////////////////////////
+//
+// Tool_dissonant::finally -- Print the JSON summary of the dissonance
+//     counts when using --stats.
+//
+
+void Tool_dissonant::finally(void) {
+	if (!m_statsQ) {
+		return;
+	}
+	m_stats.printJson(m_free_text, "dissonant");
+}
+
+
+
+//////////////////////////////
+//
+// Tool_dissonant::getStatistics -- Return the dissonance counts collected
+//     with --stats.  Counts from tool objects used in separate threads
+//     can be combined with HumStatistics::merge().
+//
+
+HumStatistics& Tool_dissonant::getStatistics(void) {
+	return m_stats;
+}
+
+
+
 /////////////////////////////
 //
 // Tool_dissonant::adjustColorization -- The dissonance analysis will color the
@@ -505,7 +546,7 @@ void Tool_dissonant::addLabelToSuspensions(HTp disslabel, const string& marker)
 //
 
 void Tool_dissonant::suppressDissonances(HumdrumFile& infile, NoteGrid& grid,
-		vector<vector<NoteCell*>>& attacks, vector<vector<string>>& results) {
+		vector<vector<NoteCell*>>& attacks, vector<vector<int>>& results) {
 
 	// Loop over the dissonance results one full row at a time. The point of doing it
 	// one row at a time instead of one voice at a time is so that a weak dissonance in
@@ -543,30 +584,30 @@ void Tool_dissonant::suppressDissonances(HumdrumFile& infile, NoteGrid& grid,
 				continue;
 			}
 			int v = kernTrackToVoiceIndex.at(token->getTrack());
-			if (results[v][i].empty() || (results[v][i] == ".")) {
+			if ((results[v][i] == NO_LABEL) || (results[v][i] == NULL_LABEL)) {
 				continue;
 			}
 			// cerr << "\tCHECKING DISSONANCE " << results[v][i] << " for note " << token << endl;
 			HumNum notedur = token->getTiedDuration();
 
-			if ((results[v][i] == m_labels[PASSING_DOWN]) ||
-					(results[v][i] == m_labels[PASSING_UP]) ||
-					(results[v][i] == m_labels[NEIGHBOR_DOWN]) ||
-					(results[v][i] == m_labels[NEIGHBOR_UP]) ||
-					(results[v][i] == m_labels[CAMBIATA_DOWN_S]) ||
-					(results[v][i] == m_labels[CAMBIATA_UP_S]) ||
-					(results[v][i] == m_labels[CAMBIATA_DOWN_L]) ||
-					(results[v][i] == m_labels[CAMBIATA_UP_L]) ||
-					(results[v][i] == m_labels[ECHAPPEE_DOWN]) ||
-					(results[v][i] == m_labels[ECHAPPEE_UP]) ||
-					(results[v][i] == m_labels[ANT_DOWN]) ||
-					(results[v][i] == m_labels[ANT_UP]) ||
-					(results[v][i] == m_labels[REV_ECHAPPEE_DOWN]) ||
-					(results[v][i] == m_labels[REV_ECHAPPEE_UP]) ||
-					(results[v][i] == m_labels[REV_CAMBIATA_DOWN]) ||
-					(results[v][i] == m_labels[REV_CAMBIATA_UP]) ||
-					(results[v][i] == m_labels[DBL_NEIGHBOR_DOWN]) ||
-					(results[v][i] == m_labels[DBL_NEIGHBOR_UP]) ) {
+			if ((isLabel(results[v][i], PASSING_DOWN)) ||
+					(isLabel(results[v][i], PASSING_UP)) ||
+					(isLabel(results[v][i], NEIGHBOR_DOWN)) ||
+					(isLabel(results[v][i], NEIGHBOR_UP)) ||
+					(isLabel(results[v][i], CAMBIATA_DOWN_S)) ||
+					(isLabel(results[v][i], CAMBIATA_UP_S)) ||
+					(isLabel(results[v][i], CAMBIATA_DOWN_L)) ||
+					(isLabel(results[v][i], CAMBIATA_UP_L)) ||
+					(isLabel(results[v][i], ECHAPPEE_DOWN)) ||
+					(isLabel(results[v][i], ECHAPPEE_UP)) ||
+					(isLabel(results[v][i], ANT_DOWN)) ||
+					(isLabel(results[v][i], ANT_UP)) ||
+					(isLabel(results[v][i], REV_ECHAPPEE_DOWN)) ||
+					(isLabel(results[v][i], REV_ECHAPPEE_UP)) ||
+					(isLabel(results[v][i], REV_CAMBIATA_DOWN)) ||
+					(isLabel(results[v][i], REV_CAMBIATA_UP)) ||
+					(isLabel(results[v][i], DBL_NEIGHBOR_DOWN)) ||
+					(isLabel(results[v][i], DBL_NEIGHBOR_UP)) ) {
 				if (notedur > maxWeakDur) {
 					maxWeakDur = notedur;
 					maxToken = token;
@@ -595,14 +636,14 @@ void Tool_dissonant::suppressDissonances(HumdrumFile& infile, NoteGrid& grid,
 				continue;
 			}
 			int v = kernTrackToVoiceIndex.at(token->getTrack());
-			if (results[v][i].empty() || (results[v][i] == ".")) {
+			if ((results[v][i] == NO_LABEL) || (results[v][i] == NULL_LABEL)) {
 				continue;
 			}
 			HumNum notedur = token->getTiedDuration();
-			if ((results[v][i] == m_labels[SUS_BIN]) ||
-					(results[v][i] == m_labels[SUS_TERN]) ||
-					(results[v][i] == m_labels[AGENT_BIN]) ||
-					(results[v][i] == m_labels[AGENT_TERN])) {
+			if ((isLabel(results[v][i], SUS_BIN)) ||
+					(isLabel(results[v][i], SUS_TERN)) ||
+					(isLabel(results[v][i], AGENT_BIN)) ||
+					(isLabel(results[v][i], AGENT_TERN))) {
 				continue;
 			} else if (notedur <= maxWeakDur) {
 				mergeWithPreviousNote(infile, i, j);
@@ -628,12 +669,12 @@ void Tool_dissonant::suppressDissonances(HumdrumFile& infile, NoteGrid& grid,
 
 void Tool_dissonant::suppressDissonancesInVoice(HumdrumFile& infile,
 		NoteGrid& grid, int vindex, vector<NoteCell*>& attacks,
-		vector<string>& results) {
+		vector<int>& results) {
 
 	for (int i=0; i<(int)attacks.size(); i++) {
 		int lineindex = attacks[i]->getLineIndex();
 		int fieldindex = attacks[i]->getFieldIndex();
-		if ((results[lineindex] == "") || (results[lineindex] == ".") ) {
+		if ((results[lineindex] == NO_LABEL) || (results[lineindex] == NULL_LABEL) ) {
 			continue;
 		}
 
@@ -647,21 +688,21 @@ void Tool_dissonant::suppressDissonancesInVoice(HumdrumFile& infile,
 			continue;
 		}
 
-		if ((results[lineindex] == m_labels[THIRD_Q_PASS_UP]) ||
-			(results[lineindex] == m_labels[THIRD_Q_PASS_DOWN]) ||
-			(results[lineindex] == m_labels[THIRD_Q_LOWER_NEI]) ||
-			(results[lineindex] == m_labels[THIRD_Q_UPPER_NEI]) ||
-			(results[lineindex] == m_labels[ACC_PASSING_UP]) ||
-			(results[lineindex] == m_labels[ACC_PASSING_DOWN]) ||
-			(results[lineindex] == m_labels[ACC_LO_NEI]) ||
-			(results[lineindex] == m_labels[ACC_UP_NEI]) ||
-			(results[lineindex] == m_labels[RES_PITCH]) ||
-			(results[lineindex] == m_labels[APP_UPPER]) ||
-			(results[lineindex] == m_labels[APP_LOWER]) ||
-			(results[lineindex] == m_labels[PARALLEL_DOWN]) ||
-			(results[lineindex] == m_labels[PARALLEL_UP]) ||
-			(results[lineindex] == m_labels[ORNAMENTAL_SUS]) ||
-			(results[lineindex] == m_labels[CHANSON_IDIOM]) ) {
+		if ((isLabel(results[lineindex], THIRD_Q_PASS_UP)) ||
+			(isLabel(results[lineindex], THIRD_Q_PASS_DOWN)) ||
+			(isLabel(results[lineindex], THIRD_Q_LOWER_NEI)) ||
+			(isLabel(results[lineindex], THIRD_Q_UPPER_NEI)) ||
+			(isLabel(results[lineindex], ACC_PASSING_UP)) ||
+			(isLabel(results[lineindex], ACC_PASSING_DOWN)) ||
+			(isLabel(results[lineindex], ACC_LO_NEI)) ||
+			(isLabel(results[lineindex], ACC_UP_NEI)) ||
+			(isLabel(results[lineindex], RES_PITCH)) ||
+			(isLabel(results[lineindex], APP_UPPER)) ||
+			(isLabel(results[lineindex], APP_LOWER)) ||
+			(isLabel(results[lineindex], PARALLEL_DOWN)) ||
+			(isLabel(results[lineindex], PARALLEL_UP)) ||
+			(isLabel(results[lineindex], ORNAMENTAL_SUS)) ||
+			(isLabel(results[lineindex], CHANSON_IDIOM)) ) {
 			// cerr << "MERGING " << token << " with next note" << endl;
 			mergeWithNextNote(infile, lineindex, fieldindex);
 		}
@@ -677,12 +718,12 @@ void Tool_dissonant::suppressDissonancesInVoice(HumdrumFile& infile,
 
 void Tool_dissonant::suppressSusOrnamentsInVoice(HumdrumFile& infile,
 		NoteGrid& grid, int vindex, vector<NoteCell*>& attacks,
-		vector<string>& results) {
+		vector<int>& results) {
 
 	for (int i=0; i<(int)attacks.size(); i++) {
 		int lineindex = attacks[i]->getLineIndex();
 		int fieldindex = attacks[i]->getFieldIndex();
-		if ((results[lineindex] == "") || (results[lineindex] == ".") ) {
+		if ((results[lineindex] == NO_LABEL) || (results[lineindex] == NULL_LABEL) ) {
 			continue;
 		}
 
@@ -696,8 +737,8 @@ void Tool_dissonant::suppressSusOrnamentsInVoice(HumdrumFile& infile,
 			continue;
 		}
 
-		if (((results[lineindex] == m_labels[SUS_BIN]) ||
-			 (results[lineindex] == m_labels[SUS_TERN])) &&
+		if (((isLabel(results[lineindex], SUS_BIN)) ||
+			 (isLabel(results[lineindex], SUS_TERN))) &&
 			(i < ((int)attacks.size() - 3)) ) {
 			HumNum durn   = attacks[i+1]->getDuration();
 			HumNum durnn  = attacks[i+2]->getDuration();
@@ -717,23 +758,23 @@ void Tool_dissonant::suppressSusOrnamentsInVoice(HumdrumFile& infile,
 
 			if ((durn == durnn) && (durn < durnnn) && (levn > levnnn) &&
 				(intn == -1) && (intnn == -1) && (intnnn == 1) ) { // turn figure anticipation of resolution phase
-				if ((results[lineindexnn] == ".") && (!tokennn->isNull()) &&
+				if ((results[lineindexnn] == NULL_LABEL) && (!tokennn->isNull()) &&
 					(tokennn->isNoteAttack()) ) {
 					mergeWithPreviousNote(infile, lineindexnn, vindex);
 				}
-				if ((results[lineindexn] == ".") && (!tokenn->isNull()) &&
+				if ((results[lineindexn] == NULL_LABEL) && (!tokenn->isNull()) &&
 					(tokenn->isNoteAttack()) ) {
 					mergeWithPreviousNote(infile, lineindexn, vindex);
 				}
 			} else if ((durn == durnn) && (durn == durnnn) && (levn > levnn) &&
 				(levnn < levnnn) && (intn == -1) && (intnn == 0) &&
-				(intnnn == -1) && (results[lineindexnnn] == ".") &&
+				(intnnn == -1) && (results[lineindexnnn] == NULL_LABEL) &&
 				(!tokennnn->isNull()) && (tokennnn->isNoteAttack()) ) { // Du Fay ornament
 				mergeWithPreviousNote(infile, lineindexnnn, vindex);
 			}
 		}
-		if (((results[lineindex] == m_labels[SUS_BIN]) ||
-			 (results[lineindex] == m_labels[SUS_TERN])) &&
+		if (((isLabel(results[lineindex], SUS_BIN)) ||
+			 (isLabel(results[lineindex], SUS_TERN))) &&
 			(i < ((int)attacks.size() - 2)) ) {
 			HumNum durn  = attacks[i+1]->getDuration();
 			HumNum durnn = attacks[i+2]->getDuration();
@@ -745,7 +786,7 @@ void Tool_dissonant::suppressSusOrnamentsInVoice(HumdrumFile& infile,
 			HTp tokenn = infile.token(lineindexn, fieldindex);
 
 			if ((durn <= durnn) && (levn >= levnn) && (intn == -1) &&
-				(intnn == 0) && (results[lineindexn] == ".") &&
+				(intnn == 0) && (results[lineindexn] == NULL_LABEL) &&
 				(!tokenn->isNull()) && (tokenn->isNoteAttack()) ) { // anticipation of resolution phase
 				mergeWithPreviousNote(infile, lineindexn, vindex);
 			}
@@ -1176,7 +1217,7 @@ void Tool_dissonant::printColorLegend(HumdrumFile& infile) {
 // Tool_dissonant::doAnalysis -- do a basic melodic analysis of all parts.
 //
 
-void Tool_dissonant::doAnalysis(vector<vector<string>>& results,
+void Tool_dissonant::doAnalysis(vector<vector<int>>& results,
 		NoteGrid& grid, vector<vector<NoteCell*>>& attacks, bool debug) {
 	attacks.resize(grid.getVoiceCount());
 
@@ -1210,7 +1251,7 @@ void Tool_dissonant::doAnalysis(vector<vector<string>>& results,
 //     subtracting NoteCells to calculate the diatonic intervals.
 //
 
-void Tool_dissonant::doAnalysisForVoice(vector<vector<string>>& results,
+void Tool_dissonant::doAnalysisForVoice(vector<vector<int>>& results,
 		NoteGrid& grid, vector<NoteCell*>& attacks, int vindex, bool debug) {
 	attacks.clear();
 	grid.getNoteAndRestAttacks(attacks, vindex);
@@ -1225,8 +1266,8 @@ void Tool_dissonant::doAnalysisForVoice(vector<vector<string>>& results,
 		}
 	}
 	bool nodissonanceQ = getBoolean("no-dissonant");
-	bool colorizeQ = getBoolean("colorize");
-	bool colorize2Q = getBoolean("colorize2");
+	bool colorizeQ = getBoolean("colorize") && !m_statsQ;
+	bool colorize2Q = getBoolean("colorize2") && !m_statsQ;
 
 	HumNum durpp = -1; // duration of previous previous note
 	HumNum durp;       // duration of previous melodic note
@@ -1250,7 +1291,7 @@ void Tool_dissonant::doAnalysisForVoice(vector<vector<string>>& results,
 	bool dissonant;    // true if  note is dissonant with other sounding notes.
 	char marking = '\0';
 	int ovoiceindex = -1;
-	string unexp_label; // default dissonance label if none of the diss types apply
+	int unexp_label = NO_LABEL; // default dissonance label if none of the diss types apply
 	int refMeterNum;    // the numerator of the reference voice's notated time signature
 	HumNum refMeterDen; // the denominator of the reference voice's notated time signature
 	int othMeterNum;    // the numerator of the other voice's notated time signature
@@ -1324,7 +1365,7 @@ RECONSIDER:
 				dissonant = true;
 				diss2Q = true;
 				marking = '@';
-				unexp_label = m_labels[UNLABELED_Z2];
+				unexp_label = UNLABELED_Z2;
 				ovoiceindex = j;
 				oattackindexn = getNextPitchAttackIndex(grid, ovoiceindex, sliceindex);
 				break;
@@ -1333,7 +1374,7 @@ RECONSIDER:
 				dissonant = true;
 				diss7Q = true;
 				marking = '+';
-				unexp_label = m_labels[UNLABELED_Z7];
+				unexp_label = UNLABELED_Z7;
 				ovoiceindex = j;
 				oattackindexn = getNextPitchAttackIndex(grid, ovoiceindex, sliceindex);
 				break;
@@ -1349,7 +1390,7 @@ RECONSIDER:
 				dissonant = true;
 				diss4Q = true;
 				marking = 'N';
-				unexp_label = m_labels[UNLABELED_Z4];
+				unexp_label = UNLABELED_Z4;
 				// ovoiceindex = lowestnotei;
 				ovoiceindex = j;
 				// oattackindexn = grid.cell(ovoiceindex, sliceindex)->getNextAttackIndex();
@@ -1369,7 +1410,7 @@ RECONSIDER:
 				marking = 'N';
 				ovoiceindex = lowestnotei;
 				oattackindexn = grid.cell(ovoiceindex, sliceindex)->getNextAttackIndex();
-				unexp_label = m_labels[UNLABELED_Z4];
+				unexp_label = UNLABELED_Z4;
 			}
 		}
 */
@@ -1527,10 +1568,10 @@ RECONSIDER:
 
 		ternAgent = false;
 		if (((othMeterNum % 3 == 0) && (odur >= othMeterDen)) && // the durational value of the meter's denominator groups in threes and the sus lasts at least as long as the denominator
-			(results[ovoiceindex][lineindex] != m_labels[SUS_BIN]) && // the other voice hasn't already been labeled as a binary suspension
+			(!isLabel(results[ovoiceindex][lineindex], SUS_BIN)) && // the other voice hasn't already been labeled as a binary suspension
 			((dur == othMeterDen*2) || // the ref note lasts 2 times as long as the meter's denominator
 			 ((dur == othMeterDen*threehalves) && ((intn == 0) || (intn == -1))) || // ref note lasts 1.5 times the meter's denominator and next note is a tenorizans ornament
-			 ((dur == othMeterDen*threehalves) && ((unexp_label == m_labels[UNLABELED_Z4]) || (intn == 3))) || // 4-3 susp where agent leaps to diatonic pitch class of resolution
+			 ((dur == othMeterDen*threehalves) && (isLabel(unexp_label, UNLABELED_Z4) || (intn == 3))) || // 4-3 susp where agent leaps to diatonic pitch class of resolution
 			 ((dur == sixteenthirds) && (refMeterNum == 3) && (refMeterDen == threehalves)) || // special case for 3/3 time signature
 			 ((odur == othMeterDen*threehalves) && (ointn == -1) && (odurn == 2) && (ointnn == 0)) || // change of agent suspension with ant of resolution
 			 ((dur == othMeterDen) && (odur == othMeterDen*2)) || // unornamented change of agent suspension
@@ -1549,63 +1590,63 @@ RECONSIDER:
 			(dur <= durp) && (condition2 || condition2b) && valid_acc_exit) { // weak dissonances
 			if (intp == -1) { // descending dissonances
 				if (intn == -1) { // downward passing tone
-					results[vindex][lineindex] = m_labels[PASSING_DOWN];
+					results[vindex][lineindex] = PASSING_DOWN;
 				} else if (intn == 1) { // lower neighbor
-					results[vindex][lineindex] = m_labels[NEIGHBOR_DOWN];
+					results[vindex][lineindex] = NEIGHBOR_DOWN;
 				} else if ((intn == 0) && (dur <= 2)) { // descending anticipation
-					results[vindex][lineindex] = m_labels[ANT_DOWN];
+					results[vindex][lineindex] = ANT_DOWN;
 				} else if (intn > 1) { // lower échappée
-					results[vindex][lineindex] = m_labels[ECHAPPEE_DOWN];
+					results[vindex][lineindex] = ECHAPPEE_DOWN;
 				} else if (intn < -1) { // descending short nota cambiata
-					results[vindex][lineindex] = m_labels[CAMBIATA_DOWN_S];
+					results[vindex][lineindex] = CAMBIATA_DOWN_S;
 				}
 			} else if (intp == 1) { // ascending dissonances
 				if (intn == 1) { // rising passing tone
-					results[vindex][lineindex] = m_labels[PASSING_UP];
+					results[vindex][lineindex] = PASSING_UP;
 				} else if (intn == -1) { // upper neighbor
-					results[vindex][lineindex] = m_labels[NEIGHBOR_UP];
+					results[vindex][lineindex] = NEIGHBOR_UP;
 				} else if (intn < -1) { // upper échappée
-					results[vindex][lineindex] = m_labels[ECHAPPEE_UP];
+					results[vindex][lineindex] = ECHAPPEE_UP;
 				} else if ((intn == 0) && (dur <= 2)) { // rising anticipation
-					results[vindex][lineindex] = m_labels[ANT_UP];
+					results[vindex][lineindex] = ANT_UP;
 				} else if (intn > 1) { // ascending short nota cambiata
-					results[vindex][lineindex] = m_labels[CAMBIATA_UP_S];
+					results[vindex][lineindex] = CAMBIATA_UP_S;
 				}
 			} else if (intp < -1) {
 				if (intn == 1) { // reverse lower échappée
-					results[vindex][lineindex] = m_labels[REV_ECHAPPEE_DOWN];
+					results[vindex][lineindex] = REV_ECHAPPEE_DOWN;
 				} else if (intn == -1) { // reverse descending nota cambiata
-					results[vindex][lineindex] = m_labels[REV_CAMBIATA_DOWN];
+					results[vindex][lineindex] = REV_CAMBIATA_DOWN;
 				}
 			} else if (intp > 1) {
 				if (intn == -1) { // reverse upper échappée
-					results[vindex][lineindex] = m_labels[REV_ECHAPPEE_UP];
+					results[vindex][lineindex] = REV_ECHAPPEE_UP;
 				} else if (intn == 1) { // reverse ascending nota cambiata
-					results[vindex][lineindex] = m_labels[REV_CAMBIATA_UP];
+					results[vindex][lineindex] = REV_CAMBIATA_UP;
 				}
 			}
 		} else if ((durp >= 2) && (dur == 1) && (lev < levn) && valid_acc_exit &&
 					 (condition2 || condition2b) && (lev == 1)) {
 			if (intp == -1) {
 				if (intn == -1) { // dissonant third quarter descending passing tone
-					results[vindex][lineindex] = m_labels[THIRD_Q_PASS_DOWN];
+					results[vindex][lineindex] = THIRD_Q_PASS_DOWN;
 				} else if (intn == 1) { // dissonant third quarter lower neighbor
-					results[vindex][lineindex] = m_labels[THIRD_Q_LOWER_NEI];
+					results[vindex][lineindex] = THIRD_Q_LOWER_NEI;
 				}
 			} else if (intp == 1) {
 				if (intn == 1) { // dissonant third quarter ascending passing tone
-					results[vindex][lineindex] = m_labels[THIRD_Q_PASS_UP];
+					results[vindex][lineindex] = THIRD_Q_PASS_UP;
 				} else if (intn == -1) { // dissonant third quarter upper neighbor
-					results[vindex][lineindex] = m_labels[THIRD_Q_UPPER_NEI];
+					results[vindex][lineindex] = THIRD_Q_UPPER_NEI;
 				}
 			}
 		} else if (((lev > levp) || (durp+durp+durp+durp == dur)) &&
 				   (lev == levn) && condition2 && (intn == -1) &&
 				   (dur == (durn+durn)) && ((dur+dur) <= odur)) {
 			if (fabs(intp) > 1.0) {
-				results[vindex][lineindex] = m_labels[SUS_NO_AGENT_LEAP];
+				results[vindex][lineindex] = SUS_NO_AGENT_LEAP;
 			} else if ((fabs(intp) == 1.0) || ((intp == 0) && (fabs(intpp) == 1.0))) {
-				results[vindex][lineindex] = m_labels[SUS_NO_AGENT_STEP];
+				results[vindex][lineindex] = SUS_NO_AGENT_STEP;
 			}
 		}
 
@@ -1616,54 +1657,54 @@ RECONSIDER:
 
 		else if (valid_sus_acc && ((ointn == -1) || ((ointn == -2) && (ointnn == 1)))) {
 			if ((durpp == 1) && (durp == 1) && (intpp == -1) && (intp == 1) &&
-					((results[vindex][lineindexpp] == m_labels[THIRD_Q_PASS_DOWN]) ||
-					(results[vindex][lineindexpp] == m_labels[ACC_PASSING_DOWN]) ||
-					(results[vindex][lineindexpp] == m_labels[UNLABELED_Z7]) ||
-					(results[vindex][lineindexpp] == m_labels[UNLABELED_Z4]))) {
-				results[vindex][lineindexpp] = m_labels[CHANSON_IDIOM];
+					((isLabel(results[vindex][lineindexpp], THIRD_Q_PASS_DOWN)) ||
+					(isLabel(results[vindex][lineindexpp], ACC_PASSING_DOWN)) ||
+					(isLabel(results[vindex][lineindexpp], UNLABELED_Z7)) ||
+					(isLabel(results[vindex][lineindexpp], UNLABELED_Z4)))) {
+				results[vindex][lineindexpp] = CHANSON_IDIOM;
 			}
 			if (ternAgent) { // ternary agent and suspension
-				results[vindex][lineindex] = m_labels[AGENT_TERN];
-				results[ovoiceindex][lineindex] = m_labels[SUS_TERN];
+				results[vindex][lineindex] = AGENT_TERN;
+				results[ovoiceindex][lineindex] = SUS_TERN;
 			} else if (((odur == .5) || (odur == 1)) && // purely ornamental suspension
 						((odurn == .5) || (odurn == 1)) &&
 						(ointn == -1) && (ointnn == -1) ) {
-				results[vindex][lineindex] = m_labels[AGENT_BIN];
-				results[ovoiceindex][lineindex] = m_labels[ORNAMENTAL_SUS];
+				results[vindex][lineindex] = AGENT_BIN;
+				results[ovoiceindex][lineindex] = ORNAMENTAL_SUS;
 			} else { // binary agent and suspension
-				results[vindex][lineindex] = m_labels[AGENT_BIN];
-				results[ovoiceindex][lineindex] = m_labels[SUS_BIN];
+				results[vindex][lineindex] = AGENT_BIN;
+				results[ovoiceindex][lineindex] = SUS_BIN;
 			}
 		} else if (valid_ornam_sus_acc && ((ointn == 0) && (ointnn == -1))) {
 			if ((durpp == 1) && (durp == 1) && (intpp == -1) && (intp == 1) &&
-					((results[vindex][lineindexpp] == m_labels[THIRD_Q_PASS_DOWN]) ||
-					(results[vindex][lineindexpp] == m_labels[ACC_PASSING_DOWN]) ||
-					(results[vindex][lineindexpp] == m_labels[UNLABELED_Z7]) ||
-					(results[vindex][lineindexpp] == m_labels[UNLABELED_Z4]))) {
-				results[vindex][lineindexpp] = m_labels[CHANSON_IDIOM];
+					((isLabel(results[vindex][lineindexpp], THIRD_Q_PASS_DOWN)) ||
+					(isLabel(results[vindex][lineindexpp], ACC_PASSING_DOWN)) ||
+					(isLabel(results[vindex][lineindexpp], UNLABELED_Z7)) ||
+					(isLabel(results[vindex][lineindexpp], UNLABELED_Z4)))) {
+				results[vindex][lineindexpp] = CHANSON_IDIOM;
 			}
 			if (ternAgent) { // ternary agent and suspension
-				results[vindex][lineindex] = m_labels[AGENT_TERN];
-				results[ovoiceindex][lineindex] = m_labels[SUS_TERN];
+				results[vindex][lineindex] = AGENT_TERN;
+				results[ovoiceindex][lineindex] = SUS_TERN;
 			} else { // binary agent and suspension
-				results[vindex][lineindex] = m_labels[AGENT_BIN];
-				results[ovoiceindex][lineindex] = m_labels[SUS_BIN];
+				results[vindex][lineindex] = AGENT_BIN;
+				results[ovoiceindex][lineindex] = SUS_BIN;
 			} // repeated-note of suspension
-			results[ovoiceindex][olineindexn] = m_labels[SUSPENSION_REP];
+			results[ovoiceindex][olineindexn] = SUSPENSION_REP;
 		} else if (valid_ornam_sus_acc && ((ointn == 1) && (ointnn == -2))) {
 			if ((durpp == 1) && (durp == 1) && (intpp == -1) && (intp == 1) &&
-					((results[vindex][lineindexpp] == m_labels[THIRD_Q_PASS_DOWN]) ||
-					(results[vindex][lineindexpp] == m_labels[ACC_PASSING_DOWN]) ||
-					(results[vindex][lineindexpp] == m_labels[UNLABELED_Z7]) ||
-					(results[vindex][lineindexpp] == m_labels[UNLABELED_Z4]))) {
-				results[vindex][lineindexpp] = m_labels[CHANSON_IDIOM];
+					((isLabel(results[vindex][lineindexpp], THIRD_Q_PASS_DOWN)) ||
+					(isLabel(results[vindex][lineindexpp], ACC_PASSING_DOWN)) ||
+					(isLabel(results[vindex][lineindexpp], UNLABELED_Z7)) ||
+					(isLabel(results[vindex][lineindexpp], UNLABELED_Z4)))) {
+				results[vindex][lineindexpp] = CHANSON_IDIOM;
 			}
 			if (ternAgent) { // ternary agent and suspension
-				results[vindex][lineindex] = m_labels[AGENT_TERN];
-				results[ovoiceindex][lineindex] = m_labels[SUS_TERN];
+				results[vindex][lineindex] = AGENT_TERN;
+				results[ovoiceindex][lineindex] = SUS_TERN;
 			} else { // binary agent and suspension
-				results[vindex][lineindex] = m_labels[AGENT_BIN];
-				results[ovoiceindex][lineindex] = m_labels[SUS_BIN];
+				results[vindex][lineindex] = AGENT_BIN;
+				results[ovoiceindex][lineindex] = SUS_BIN;
 			} // This ornament is consonant against the agent so no ornament label.
 		}
 
@@ -1677,10 +1718,10 @@ RECONSIDER:
 
 			if ((dur <= durp) && (lev >= levp) && (lev >= levn) &&
 					(intp == -1) && (intn == -2) && (intnn == 1)) { // long-form descending cambiata
-				results[vindex][lineindex] = m_labels[CAMBIATA_DOWN_L];
+				results[vindex][lineindex] = CAMBIATA_DOWN_L;
 			} else if ((dur <= durp) && (lev >= levp) && (lev >= levn) &&
 					(intp == 1) && (intn == 2) && (intnn == -1)) { // long-form ascending nota cambiata
-				results[vindex][lineindex] = m_labels[CAMBIATA_UP_L];
+				results[vindex][lineindex] = CAMBIATA_UP_L;
 			}
 		}
 
@@ -1691,7 +1732,7 @@ RECONSIDER:
 		bool refLeaptFrom = fabs(intn) > 1 ? true : false;
 		bool othLeaptFrom = fabs(ointn) > 1 ? true : false;
 
-		if ((results[vindex][lineindex] == "") && // this voice doesn't already have a dissonance label
+		if ((results[vindex][lineindex] == NO_LABEL) && // this voice doesn't already have a dissonance label
 				((olineindexc < lineindex) || // other voice does not attack at this point
 				((olineindexc == lineindex) && (dur < odur)) || // both voices attack together, but ref voice leaves dissonance first
 				(((olineindexc == lineindex) && (dur == odur)) && // both voices enter and leave dissonance simultaneously
@@ -1709,10 +1750,10 @@ RECONSIDER:
 		// against another note with which it might have a known dissonant function.
 		// Also go back if this voice was identified as an agent, because it may be
 		// the agent of multiple patients.
-		if ((results[vindex][lineindex] == m_labels[UNLABELED_Z4]) ||
-				(results[vindex][lineindex] == m_labels[UNLABELED_Z7]) ||
-				(results[vindex][lineindex] == m_labels[AGENT_BIN]) ||
-				(results[vindex][lineindex] == m_labels[AGENT_TERN])) {
+		if ((isLabel(results[vindex][lineindex], UNLABELED_Z4)) ||
+				(isLabel(results[vindex][lineindex], UNLABELED_Z7)) ||
+				(isLabel(results[vindex][lineindex], AGENT_BIN)) ||
+				(isLabel(results[vindex][lineindex], AGENT_TERN))) {
 			if (nextj < (int)harmint.size()) {
 				goto RECONSIDER;
 			}
@@ -1728,7 +1769,7 @@ RECONSIDER:
 // Tool_dissonant::findFakeSuspensions --
 //
 
-void Tool_dissonant::findFakeSuspensions(vector<vector<string>>& results, NoteGrid& grid,
+void Tool_dissonant::findFakeSuspensions(vector<vector<int>>& results, NoteGrid& grid,
 		vector<NoteCell*>& attacks, int vindex) {
 	double intp;        // abs value of diatonic interval from previous melodic note
 	int lineindexn;     // line index of the next note in the voice
@@ -1736,18 +1777,17 @@ void Tool_dissonant::findFakeSuspensions(vector<vector<string>>& results, NoteGr
 
 	for (int i=1; i<(int)attacks.size()-1; i++) {
 		int lineindex = attacks[i]->getLineIndex();
-		if ((results[vindex][lineindex].find("Z") == string::npos) &&
-			(results[vindex][lineindex].find("z") == string::npos) &&
-			(results[vindex][lineindex].find("M") == string::npos) &&
-			(results[vindex][lineindex].find("m") == string::npos)) {
+		if (!isUnexplained(results[vindex][lineindex]) &&
+			!isLabel(results[vindex][lineindex], SUS_NO_AGENT_LEAP) &&
+			!isLabel(results[vindex][lineindex], SUS_NO_AGENT_STEP)) {
 			continue;
 		}
 		intp = fabs(*attacks[i] - *attacks[i-1]);
 		lineindexn = attacks[i+1]->getLineIndex();
 		sfound = false;
 		for (int j=lineindex + 1; j<=lineindexn; j++) {
-			if ((results[vindex][j].compare(0, 1, "s") == 0) ||
-					(results[vindex][j].compare(0, 1, "S") == 0)) {
+			if (isLabel(results[vindex][j], SUS_BIN) ||
+					isLabel(results[vindex][j], SUS_TERN)) {
 				sfound = true;
 				break;
 			}
@@ -1759,16 +1799,16 @@ void Tool_dissonant::findFakeSuspensions(vector<vector<string>>& results, NoteGr
 		// and sustained through to the beginning of the resolution.
 
 		if (intp == 1) { // Apply labels for normal fake suspensions.
-			results[vindex][lineindex] = m_labels[FAKE_SUSPENSION_STEP];
+			results[vindex][lineindex] = FAKE_SUSPENSION_STEP;
 		} else if (intp > 1) {
-			results[vindex][lineindex] = m_labels[FAKE_SUSPENSION_LEAP];
+			results[vindex][lineindex] = FAKE_SUSPENSION_LEAP;
 		} else if (i > 1) { // as long as i > 1 intpp will be in range.
 			double intpp = fabs(*attacks[i-1] - *attacks[i-2]);
 			if (intp == 0) { // fake suspensions preceded by an anticipation.
 				if (intpp == 1) {
-					results[vindex][lineindex] = m_labels[FAKE_SUSPENSION_STEP];
+					results[vindex][lineindex] = FAKE_SUSPENSION_STEP;
 				} else if (intpp > 1) {
-					results[vindex][lineindex] = m_labels[FAKE_SUSPENSION_LEAP];
+					results[vindex][lineindex] = FAKE_SUSPENSION_LEAP;
 				}
 			}
 		}
@@ -1779,7 +1819,7 @@ void Tool_dissonant::findFakeSuspensions(vector<vector<string>>& results, NoteGr
 //
 // Tool_dissonant::findLs --
 //
-void Tool_dissonant::findLs(vector<vector<string>>& results, NoteGrid& grid,
+void Tool_dissonant::findLs(vector<vector<int>>& results, NoteGrid& grid,
 		vector<NoteCell*>& attacks, int vindex) {
 	HumNum dur;        // duration of current note;
 	HumNum odur;       // duration of current note in other voice which may have started earlier;
@@ -1799,8 +1839,7 @@ void Tool_dissonant::findLs(vector<vector<string>>& results, NoteGrid& grid,
 
 	for (int i=1; i<(int)attacks.size()-1; i++) {
 		lineindex = attacks[i]->getLineIndex();
-		if ((results[vindex][lineindex].find("Z") == string::npos) &&
-			(results[vindex][lineindex].find("z") == string::npos)) {
+		if (!isUnexplained(results[vindex][lineindex])) {
 			continue;
 		}
 		dur  = attacks[i]->getDuration();
@@ -1812,11 +1851,11 @@ void Tool_dissonant::findLs(vector<vector<string>>& results, NoteGrid& grid,
 			if (vindex == j) { // only compare different voices
 				continue;
 			}
-			if ((results[j][lineindex] == m_labels[AGENT_BIN]) ||
-				(results[j][lineindex] == m_labels[AGENT_TERN]) ||
-				(results[j][lineindex] == m_labels[UNLABELED_Z7]) ||
-				(results[j][lineindex] == m_labels[UNLABELED_Z4]) ||
-				(results[j][lineindex] == "")) {
+			if ((isLabel(results[j][lineindex], AGENT_BIN)) ||
+				(isLabel(results[j][lineindex], AGENT_TERN)) ||
+				(isLabel(results[j][lineindex], UNLABELED_Z7)) ||
+				(isLabel(results[j][lineindex], UNLABELED_Z4)) ||
+				(results[j][lineindex] == NO_LABEL)) {
 				continue; // skip if other voice is an agent, unexplainable, or empty.
 			}
 			oattackindexc = grid.cell(j, sliceindex)->getCurrAttackIndex();
@@ -1837,10 +1876,10 @@ void Tool_dissonant::findLs(vector<vector<string>>& results, NoteGrid& grid,
 			ointn = opitchn - opitch;
 			if ((intp == ointp) && (intn == ointn)) { // this note moves in parallel with an identifiable dissonance
 				if (intp > 0) {
-					results[vindex][lineindex] = m_labels[PARALLEL_UP];
+					results[vindex][lineindex] = PARALLEL_UP;
 					break;
 				} else if (intp < 0) {
-					results[vindex][lineindex] = m_labels[PARALLEL_DOWN];
+					results[vindex][lineindex] = PARALLEL_DOWN;
 					break;
 				}
 			}
@@ -1852,7 +1891,7 @@ void Tool_dissonant::findLs(vector<vector<string>>& results, NoteGrid& grid,
 //
 // Tool_dissonant::findYs --
 //
-void Tool_dissonant::findYs(vector<vector<string>>& results, NoteGrid& grid,
+void Tool_dissonant::findYs(vector<vector<int>>& results, NoteGrid& grid,
 		vector<NoteCell*>& attacks, int vindex) {
 	double intp;       // diatonic interval from previous melodic note
 	double intn;       // diatonic interval to next melodic note
@@ -1869,8 +1908,7 @@ void Tool_dissonant::findYs(vector<vector<string>>& results, NoteGrid& grid,
 
 	for (int i=1; i<(int)attacks.size()-1; i++) {
 		lineindex = attacks[i]->getLineIndex();
-		if ((results[vindex][lineindex].find("Z") == string::npos) &&
-			(results[vindex][lineindex].find("z") == string::npos)) {
+		if (!isUnexplained(results[vindex][lineindex])) {
 			continue;
 		}
 		intp = *attacks[i] - *attacks[i-1];
@@ -1907,10 +1945,10 @@ void Tool_dissonant::findYs(vector<vector<string>>& results, NoteGrid& grid,
 			}
 
 			if (((thisMod7 == 1) || (thisMod7 == -6)) && // creates 2nd or 7th diss
-				((results[j][lineindex] == m_labels[SUS_BIN]) || // other voice is susp
-				 (results[j][lineindex] == m_labels[SUS_TERN])) &&
+				((isLabel(results[j][lineindex], SUS_BIN)) || // other voice is susp
+				 (isLabel(results[j][lineindex], SUS_TERN))) &&
 				(fabs(intp) == 1) && (intn == -1) && valid_acc_exit) {
-				results[vindex][lineindex] = m_labels[RES_PITCH];
+				results[vindex][lineindex] = RES_PITCH;
 				onlyWithValids = false;
 			} else if (((abs(thisMod7) == 1) || (abs(thisMod7) == 6)  ||
 					((thisInt > 0) && (thisMod7 == 3) &&
@@ -1919,23 +1957,23 @@ void Tool_dissonant::findYs(vector<vector<string>>& results, NoteGrid& grid,
 					((thisInt < 0) && (thisMod7 == -3) && // a fourth by inversion is -3 and -3%7 = -3.
 					!(((int(opitch-lowestnote) % 7) == 2) ||
 					((int(opitch-lowestnote) % 7) == 4)))) &&
-					((results[j][olineindex] == m_labels[AGENT_BIN]) ||
-					(results[j][olineindex] == m_labels[AGENT_TERN]) ||
-					(results[j][olineindex] == m_labels[UNLABELED_Z7]) ||
-					(results[j][olineindex] == m_labels[UNLABELED_Z4]) ||
-					((results[j][olineindex] == "") &&
-					((results[j][lineindex] != m_labels[SUS_BIN]) &&
-					(results[j][lineindex] != m_labels[SUS_TERN]))))) {
+					((isLabel(results[j][olineindex], AGENT_BIN)) ||
+					(isLabel(results[j][olineindex], AGENT_TERN)) ||
+					(isLabel(results[j][olineindex], UNLABELED_Z7)) ||
+					(isLabel(results[j][olineindex], UNLABELED_Z4)) ||
+					((results[j][olineindex] == NO_LABEL) &&
+					((!isLabel(results[j][lineindex], SUS_BIN)) &&
+					(!isLabel(results[j][lineindex], SUS_TERN)))))) {
 				onlyWithValids = false;
 			}
 		}
 
-		if (onlyWithValids && ((results[vindex][lineindex] == m_labels[UNLABELED_Z7]) ||
-				(results[vindex][lineindex] == m_labels[UNLABELED_Z4]))) {
+		if (onlyWithValids && ((isLabel(results[vindex][lineindex], UNLABELED_Z7)) ||
+				(isLabel(results[vindex][lineindex], UNLABELED_Z4)))) {
 			if (intp > 0) {
-				results[vindex][lineindex] = m_labels[ONLY_WITH_VALID_UP];
+				results[vindex][lineindex] = ONLY_WITH_VALID_UP;
 			} else if (intp <= 0) {
-				results[vindex][lineindex] = m_labels[ONLY_WITH_VALID_DOWN];
+				results[vindex][lineindex] = ONLY_WITH_VALID_DOWN;
 			}
 		}
 	}
@@ -1945,7 +1983,7 @@ void Tool_dissonant::findYs(vector<vector<string>>& results, NoteGrid& grid,
 //
 // Tool_dissonant::findAppoggiaturas --
 //
-void Tool_dissonant::findAppoggiaturas(vector<vector<string>>& results, NoteGrid& grid,
+void Tool_dissonant::findAppoggiaturas(vector<vector<int>>& results, NoteGrid& grid,
 		vector<NoteCell*>& attacks, int vindex) {
 	HumNum durpp;      // duration of previous previous note
 	HumNum durp;       // duration of previous note
@@ -1969,10 +2007,9 @@ void Tool_dissonant::findAppoggiaturas(vector<vector<string>>& results, NoteGrid
 	for (int i=1; i<(int)attacks.size()-1; i++) {
 		lineindexp = attacks[i-1]->getLineIndex();
 		lineindex = attacks[i]->getLineIndex();
-		if ((results[vindex][lineindex].find("Z") == string::npos) &&
-			(results[vindex][lineindex].find("z") == string::npos) &&
-			(results[vindex][lineindex].find("J") == string::npos) &&
-			(results[vindex][lineindex].find("j") == string::npos)) {
+		if (!isUnexplained(results[vindex][lineindex]) &&
+			!isLabel(results[vindex][lineindex], REV_ECHAPPEE_UP) &&
+			!isLabel(results[vindex][lineindex], REV_ECHAPPEE_DOWN)) {
 			continue;
 		}
 		durp = attacks[i-1]->getDuration();
@@ -2040,48 +2077,48 @@ void Tool_dissonant::findAppoggiaturas(vector<vector<string>>& results, NoteGrid
 					((int(opitch-lowestnote) % 7) == 4))))) {
 				continue;
 			} else if (((intp == -1) || ant_down) && ((lev <= levn) && (dur <= durn)) &&
-						((results[vindex][lineindex] == m_labels[UNLABELED_Z7]) ||
-						(results[vindex][lineindex] == m_labels[UNLABELED_Z4]))) {
+						((isLabel(results[vindex][lineindex], UNLABELED_Z7)) ||
+						(isLabel(results[vindex][lineindex], UNLABELED_Z4)))) {
 				if (intn == -1) {
-					results[vindex][lineindex] = m_labels[ACC_PASSING_DOWN]; // descending accented passing tone
+					results[vindex][lineindex] = ACC_PASSING_DOWN; // descending accented passing tone
 				} else if (intn == 1) {
-					results[vindex][lineindex] = m_labels[ACC_LO_NEI]; // accented lower neighbor
+					results[vindex][lineindex] = ACC_LO_NEI; // accented lower neighbor
 				}
 			} else if (((intp == 1) || ant_up) && ((lev <= levn) && (dur <= durn)) &&
-						((results[vindex][lineindex] == m_labels[UNLABELED_Z7]) ||
-						(results[vindex][lineindex] == m_labels[UNLABELED_Z4]))) {
+						((isLabel(results[vindex][lineindex], UNLABELED_Z7)) ||
+						(isLabel(results[vindex][lineindex], UNLABELED_Z4)))) {
 				if (intn == 1) {
-					results[vindex][lineindex] = m_labels[ACC_PASSING_UP]; // rising accented passing tone
+					results[vindex][lineindex] = ACC_PASSING_UP; // rising accented passing tone
 				} else if (intn == -1) {
-					results[vindex][lineindex] = m_labels[ACC_UP_NEI]; // accented upper neighbor
+					results[vindex][lineindex] = ACC_UP_NEI; // accented upper neighbor
 				}
 			} else if (intn == -1) {
-				if ((intp == 2) && (results[vindex][lineindexp] == m_labels[ECHAPPEE_DOWN]) &&
-					(((results[vindex][lineindex] == m_labels[UNLABELED_Z7]) ||
-						(results[vindex][lineindex] == m_labels[UNLABELED_Z4]) ||
-						(results[vindex][lineindex] == m_labels[REV_ECHAPPEE_UP])) ||
+				if ((intp == 2) && (isLabel(results[vindex][lineindexp], ECHAPPEE_DOWN)) &&
+					(((isLabel(results[vindex][lineindex], UNLABELED_Z7)) ||
+						(isLabel(results[vindex][lineindex], UNLABELED_Z4)) ||
+						(isLabel(results[vindex][lineindex], REV_ECHAPPEE_UP))) ||
 					 ((lev <= levn) && (dur <= durn)))) {
-					results[vindex][lineindexp] = m_labels[DBL_NEIGHBOR_DOWN];
-					results[vindex][lineindex]  = m_labels[DBL_NEIGHBOR_DOWN];
+					results[vindex][lineindexp] = DBL_NEIGHBOR_DOWN;
+					results[vindex][lineindex] = DBL_NEIGHBOR_DOWN;
 				} else if (((fabs(intp) > 1) || ant_leapt_to) &&
 							((lev <= levn) && (dur <= durn)) &&
-							((results[vindex][lineindex] == m_labels[UNLABELED_Z7]) ||
-							(results[vindex][lineindex] == m_labels[UNLABELED_Z4]))) { // upper appoggiatura
-					results[vindex][lineindex] = m_labels[APP_UPPER];
+							((isLabel(results[vindex][lineindex], UNLABELED_Z7)) ||
+							(isLabel(results[vindex][lineindex], UNLABELED_Z4)))) { // upper appoggiatura
+					results[vindex][lineindex] = APP_UPPER;
 				}
 			} else if (intn == 1) {
-				if ((intp == -2) && (results[vindex][lineindexp] == m_labels[ECHAPPEE_UP]) &&
-					(((results[vindex][lineindex] == m_labels[UNLABELED_Z7]) ||
-						(results[vindex][lineindex] == m_labels[UNLABELED_Z4]) ||
-						(results[vindex][lineindex] == m_labels[REV_ECHAPPEE_DOWN])) ||
+				if ((intp == -2) && (isLabel(results[vindex][lineindexp], ECHAPPEE_UP)) &&
+					(((isLabel(results[vindex][lineindex], UNLABELED_Z7)) ||
+						(isLabel(results[vindex][lineindex], UNLABELED_Z4)) ||
+						(isLabel(results[vindex][lineindex], REV_ECHAPPEE_DOWN))) ||
 					 ((lev <= levn) && (dur <= durn)))) {
-					results[vindex][lineindexp] = m_labels[DBL_NEIGHBOR_UP];
-					results[vindex][lineindex]  = m_labels[DBL_NEIGHBOR_UP];
+					results[vindex][lineindexp] = DBL_NEIGHBOR_UP;
+					results[vindex][lineindex] = DBL_NEIGHBOR_UP;
 				} else if (((fabs(intp) > 1) || ant_leapt_to) &&
 							((lev <= levn) && (dur <= durn)) &&
-							((results[vindex][lineindex] == m_labels[UNLABELED_Z7]) ||
-							(results[vindex][lineindex] == m_labels[UNLABELED_Z4]))) { // lower appoggiatura
-					results[vindex][lineindex] = m_labels[APP_LOWER];
+							((isLabel(results[vindex][lineindex], UNLABELED_Z7)) ||
+							(isLabel(results[vindex][lineindex], UNLABELED_Z4)))) { // lower appoggiatura
+					results[vindex][lineindex] = APP_LOWER;
 				}
 			}
 		}
@@ -2101,7 +2138,7 @@ void Tool_dissonant::findAppoggiaturas(vector<vector<string>>& results, NoteGrid
 //		Altizans must be found set against any of the other three types for
 //		anything to be detected.
 //
-void Tool_dissonant::findCadentialVoiceFunctions(vector<vector<string>>& results, NoteGrid& grid,
+void Tool_dissonant::findCadentialVoiceFunctions(vector<vector<int>>& results, NoteGrid& grid,
 		vector<NoteCell*>& attacks, vector<vector<string>>& voiceFuncs, int vindex) {
 	double int2;      // diatonic interval to next melodic note
 	double int3 = -22; // diatonic interval from next melodic note to following note
@@ -2132,8 +2169,8 @@ void Tool_dissonant::findCadentialVoiceFunctions(vector<vector<string>>& results
 	for (int i=1; i<(int)attacks.size()-1; i++) {
 		lineindex  = attacks[i]->getLineIndex();
 		// pass over if ref voice is not an agent
-		if ((results[vindex][lineindex] != m_labels[AGENT_BIN]) &&
-			(results[vindex][lineindex] != m_labels[AGENT_TERN])) {
+		if ((!isLabel(results[vindex][lineindex], AGENT_BIN)) &&
+			(!isLabel(results[vindex][lineindex], AGENT_TERN))) {
 			continue;
 		}
 		int2 = *attacks[i+1] - *attacks[i];
@@ -2145,8 +2182,8 @@ void Tool_dissonant::findCadentialVoiceFunctions(vector<vector<string>>& results
 			}
 
 			// skip if other voice isn't a patient
-			if ((results[j][lineindex] != m_labels[SUS_BIN]) &&
-				(results[j][lineindex] != m_labels[SUS_TERN])) {
+			if ((!isLabel(results[j][lineindex], SUS_BIN)) &&
+				(!isLabel(results[j][lineindex], SUS_TERN))) {
 				continue;
 			}
 
@@ -2214,12 +2251,12 @@ void Tool_dissonant::findCadentialVoiceFunctions(vector<vector<string>>& results
 				attInd3  = attacks[i+1]->getNextAttackIndex();
 				lineindex3 = attacks[i+2]->getLineIndex();
 				if (((thisMod7 == 6) || (thisMod7 == -1)) && (int2 == -1) &&
-					(results[vindex][lineindex2] == m_labels[ANT_DOWN]) &&
+					(isLabel(results[vindex][lineindex2], ANT_DOWN)) &&
 					(attInd3 == oattInd3) && (oint2 == -1) && (oint3 == 1)) {
 					voiceFuncs[j][lineindex3] = "C"; // cantizans
 					voiceFuncs[vindex][lineindex3] = "T"; // tenorizans
 				} else if ((thisMod7 == 3) && (int2 == -1) && (attInd3 == oattInd3) &&
-					(results[vindex][lineindex2] == m_labels[ANT_DOWN]) &&
+					(isLabel(results[vindex][lineindex2], ANT_DOWN)) &&
 					(oint2 == -1) && (oint3 == 1)) { // "^4xs 1 3sx -2 5xx$"
 					voiceFuncs[j][lineindex3] = "A"; // altizans
 					voiceFuncs[vindex][lineindex3] = "T"; // tenorizans
@@ -2334,7 +2371,149 @@ void Tool_dissonant::findCadentialVoiceFunctions(vector<vector<string>>& results
 
 ///////////////////////////////
 //
-// printCountAnalysis --
+// printCountAnalysis -- Print the number of each type of dissonance in
+//     each voice.  The labels are only needed for the row names.
+//
+
+void Tool_dissonant::printCountAnalysis(vector<vector<int>>& data) {
+
+	bool brief = getBoolean("u");
+	bool percentQ = getBoolean("percent");
+
+	// Count label types that are displayed with the same text together:
+	vector<vector<int>> analysis(data.size());
+	for (int i=0; i<(int)data.size(); i++) {
+		analysis[i].resize(LABELS_SIZE, 0);
+		for (int j=0; j<(int)data[i].size(); j++) {
+			if (data[i][j] >= 0) {
+				analysis[i][m_labelIndex[data[i][j]]]++;
+			}
+		}
+	}
+
+	m_humdrum_text << "**rdis";
+	if (brief) {
+		m_humdrum_text << "u";
+	}
+	m_humdrum_text << "\t**sum";
+	for (int j=0; j<(int)analysis.size(); j++) {
+		m_humdrum_text << "\t" << "**v" << j + 1;
+	}
+	m_humdrum_text << endl;
+
+	vector<bool> reduced(LABELS_SIZE, false);
+	int sumsum = 0;
+	for (int i=0; i<(int)LABELS_SIZE; i++) {
+		if (i == UNLABELED_Z2) {
+			continue;
+		}
+		if (i == UNLABELED_Z7) {
+			continue;
+		}
+
+		int item = m_labelIndex[i];
+		bool agent = isLabel(item, AGENT_BIN) || isLabel(item, AGENT_TERN);
+
+		if (brief && reduced[item]) {
+			continue;
+		}
+		reduced[item] = true;
+
+		int sum = 0;
+		for (int j=0; j<(int)analysis.size(); j++) {
+			sum += analysis[j][item];
+			// Don't include agents in dissonant note summation.
+			if (!agent) {
+				sumsum += analysis[j][item];
+			}
+		}
+
+		if (sum == 0) {
+			continue;
+		}
+
+		m_humdrum_text << m_labels[i];
+		m_humdrum_text << "\t" << sum;
+
+		for (int j=0; j<(int)analysis.size(); j++) {
+			m_humdrum_text << "\t";
+			if (percentQ && analysis[j][item]) {
+				if (agent) {
+					m_humdrum_text << ".";
+				} else {
+					m_humdrum_text << int(analysis[j][item] * 1.0 / sum * 1000.0 + 0.5) / 10.0;
+				}
+			} else {
+				m_humdrum_text << analysis[j][item];
+			}
+		}
+		m_humdrum_text << endl;
+	}
+
+	m_humdrum_text << "*-\t*-";
+	for (int j=0; j<(int)analysis.size(); j++) {
+		m_humdrum_text << "\t" << "*-";
+	}
+	m_humdrum_text << endl;
+
+	m_humdrum_text << "!!total_dissonances:\t" << sumsum << endl;
+
+}
+
+
+
+///////////////////////////////
+//
+// addStatistics -- Add the number of each type of dissonance to the
+//     statistics for --stats.  Labels with the same text are counted
+//     together, and agents are not included in the dissonance total.
+//
+
+void Tool_dissonant::addStatistics(vector<vector<int>>& data) {
+	m_stats.addFile();
+	int total = 0;
+	for (int i=0; i<(int)data.size(); i++) {
+		for (int j=0; j<(int)data[i].size(); j++) {
+			int value = data[i][j];
+			if (value < 0) {
+				continue;
+			}
+			m_stats.increment("labels", m_labels[value]);
+			if (!(isLabel(value, AGENT_BIN) || isLabel(value, AGENT_TERN))) {
+				total++;
+			}
+		}
+	}
+	m_stats.increment("summary", "dissonances", total);
+	m_stats.increment("summary", "voices", (double)data.size());
+}
+
+
+
+///////////////////////////////
+//
+// addStatistics -- String version, used for voice function labels.
+//
+
+void Tool_dissonant::addStatistics(vector<vector<string>>& data) {
+	m_stats.addFile();
+	for (int i=0; i<(int)data.size(); i++) {
+		for (int j=0; j<(int)data[i].size(); j++) {
+			const string& value = data[i][j];
+			if (value.empty() || (value == ".")) {
+				continue;
+			}
+			m_stats.increment("voice-functions", value);
+		}
+	}
+	m_stats.increment("summary", "voices", (double)data.size());
+}
+
+
+
+///////////////////////////////
+//
+// printCountAnalysis -- String version, used for voice function labels.
 //
 
 void Tool_dissonant::printCountAnalysis(vector<vector<string>>& data) {
@@ -2527,6 +2706,7 @@ void Tool_dissonant::fillLabels(void) {
 	m_labels[UNLABELED_Z2        ] = "Z"; // unknown dissonance, 2nd interval
 	m_labels[UNLABELED_Z7        ] = "Z"; // unknown dissonance, 7th interval
 	m_labels[UNLABELED_Z4        ] = "z"; // unknown dissonance, 4th interval
+	fillLabelIndexes();
 }
 
 
@@ -2587,6 +2767,78 @@ void Tool_dissonant::fillLabels2(void) {
 	m_labels[UNLABELED_Z2        ] = "Z"; // unknown dissonance, 2nd interval
 	m_labels[UNLABELED_Z7        ] = "Z"; // unknown dissonance, 7th interval
 	m_labels[UNLABELED_Z4        ] = "Z"; // unknown dissonance, 4th interval
+	fillLabelIndexes();
+}
+
+
+
+//////////////////////////////
+//
+// Tool_dissonant::fillLabelIndexes -- Map each label type to the first
+//     label type that is displayed with the same text, so that types which
+//     are not distinguished in the output (such as the upward and downward
+//     variants in undirected mode) compare as equal in isLabel().
+//
+
+void Tool_dissonant::fillLabelIndexes(void) {
+	m_labelIndex.resize(LABELS_SIZE);
+	for (int i=0; i<LABELS_SIZE; i++) {
+		m_labelIndex[i] = i;
+		for (int j=0; j<i; j++) {
+			if (m_labels[j] == m_labels[i]) {
+				m_labelIndex[i] = j;
+				break;
+			}
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// Tool_dissonant::isLabel -- Return true if the analysis result is the
+//     given label type (or another type displayed with the same text).
+//
+
+bool Tool_dissonant::isLabel(int value, int label) {
+	if (value < 0) {
+		return false;
+	}
+	return m_labelIndex[value] == m_labelIndex[label];
+}
+
+
+
+//////////////////////////////
+//
+// Tool_dissonant::isUnexplained -- Return true if the analysis result is
+//     a dissonance that has not been identified (Z/z).
+//
+
+bool Tool_dissonant::isUnexplained(int value) {
+	return isLabel(value, UNLABELED_Z2) ||
+	       isLabel(value, UNLABELED_Z7) ||
+	       isLabel(value, UNLABELED_Z4) ||
+	       isLabel(value, UNKNOWN_DISSONANCE);
+}
+
+
+
+//////////////////////////////
+//
+// Tool_dissonant::getLabelStrings -- Convert the analysis results of a
+//     voice into the text labels for the output spine.
+//
+
+vector<string> Tool_dissonant::getLabelStrings(vector<int>& results) {
+	vector<string> output(results.size());
+	for (int i=0; i<(int)results.size(); i++) {
+		if (results[i] >= 0) {
+			output[i] = m_labels[results[i]];
+		}
+	}
+	return output;
 }
 
 
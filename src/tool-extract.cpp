@@ -69,6 +69,18 @@ Tool_extract::Tool_extract(void) {
 
 
 
+//////////////////////////////
+//
+// Tool_extract::isReusable -- Instances can be run on several files.
+//     Field lists are recalculated for each file.
+//
+
+bool Tool_extract::isReusable(void) {
+	return true;
+}
+
+
+
 /////////////////////////////////
 //
 // Tool_extract::run -- Primary interfaces to the tool.
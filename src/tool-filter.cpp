@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Wed Nov 30 01:02:57 PST 2016
-// Last Modified: Thu Nov 14 07:42:26 PST 2024
+// Last Modified: Sun Oct 18 22:18:40 PDT 2026
 // Filename:      tool-filter.cpp
 // URL:           https://github.com/craigsapp/humlib/blob/master/src/tool-filter.cpp
 // Syntax:        C++11; humlib
@@ -118,60 +118,56 @@ namespace hum {
 
 
 #define RUNTOOL(NAME, INFILE, COMMAND, STATUS)     \
-	Tool_##NAME *tool = new Tool_##NAME;            \
-	tool->process(COMMAND);                         \
+	Tool_##NAME *tool = getTool<Tool_##NAME>(COMMAND); \
 	tool->run(INFILE);                              \
 	if (tool->hasError()) {                         \
 		status = false;                              \
 		tool->getError(cerr);                        \
-		delete tool;                                 \
+		releaseTool(COMMAND, tool);                  \
 		break;                                       \
 	} else if (tool->hasHumdrumText()) {            \
 		INFILE.readString(tool->getHumdrumText());   \
 	}                                               \
-	delete tool;
+	releaseTool(COMMAND, tool);
 
 #define RUNTOOL2(NAME, INFILE1, INFILE2, COMMAND, STATUS) \
-	Tool_##NAME *tool = new Tool_##NAME;            \
-	tool->process(COMMAND);                         \
+	Tool_##NAME *tool = getTool<Tool_##NAME>(COMMAND); \
 	tool->run(INFILE1, INFILE2);                    \
 	if (tool->hasError()) {                         \
 		status = false;                              \
 		tool->getError(cerr);                        \
-		delete tool;                                 \
+		releaseTool(COMMAND, tool);                  \
 		break;                                       \
 	} else if (tool->hasHumdrumText()) {            \
 		INFILE1.readString(tool->getHumdrumText());  \
 	}                                               \
-	delete tool;
+	releaseTool(COMMAND, tool);
 
 #define RUNTOOLSET(NAME, INFILES, COMMAND, STATUS) \
-	Tool_##NAME *tool = new Tool_##NAME;            \
-	tool->process(COMMAND);                         \
+	Tool_##NAME *tool = getTool<Tool_##NAME>(COMMAND); \
 	tool->run(INFILES);                             \
 	if (tool->hasError()) {                         \
 		status = false;                              \
 		tool->getError(cerr);                        \
-		delete tool;                                 \
+		releaseTool(COMMAND, tool);                  \
 		break;                                       \
 	} else if (tool->hasHumdrumText()) {            \
 		INFILES.readString(tool->getHumdrumText());  \
 	}                                               \
-	delete tool;
+	releaseTool(COMMAND, tool);
 
 #define RUNTOOLSTREAM(NAME, INFILES, COMMAND, STATUS) \
-	Tool_##NAME *tool = new Tool_##NAME;               \
-	tool->process(COMMAND);                            \
+	Tool_##NAME *tool = getTool<Tool_##NAME>(COMMAND); \
 	tool->run(INFILES);                                \
 	if (tool->hasError()) {                            \
 		status = false;                                 \
 		tool->getError(cerr);                           \
-		delete tool;                                    \
+		releaseTool(COMMAND, tool);                     \
 		break;                                          \
 	} else if (tool->hasHumdrumText()) {               \
 		INFILES.readString(tool->getHumdrumText());     \
 	}                                                  \
-	delete tool;
+	releaseTool(COMMAND, tool);
 
 
 
@@ -500,21 +496,17 @@ bool Tool_filter::run(HumdrumFileSet& infiles) {
 //
 
 void Tool_filter::removeGlobalFilterLines(HumdrumFile& infile) {
-	HumRegex hre;
 	string text;
 
 	string maintag = "!!!filter:";
 	string mainXtag = "!!!Xfilter:";
-	string maintagQuery = "^!!!filter:";
 
 	string maintagV;
 	string mainXtagV;
-	string maintagQueryV;
 
 	if (m_variant.size() > 0) {
 		maintagV = "!!!filter-" + m_variant + ":";
 		mainXtagV = "!!!Xfilter-" + m_variant + ":";
-		maintagQueryV = "^!!!filter-" + m_variant + ":";
 	}
 
 	for (int i=0; i<infile.getLineCount(); i++) {
@@ -524,14 +516,12 @@ void Tool_filter::removeGlobalFilterLines(HumdrumFile& infile) {
 
 		if (m_variant.size() > 0) {
 			if (infile.token(i, 0)->compare(0, maintagV.size(), maintagV) == 0) {
-				text = infile.token(i, 0)->getText();
-				hre.replaceDestructive(text, mainXtagV, maintagQueryV);
+				text = mainXtagV + infile.token(i, 0)->substr(maintagV.size());
 				infile.token(i, 0)->setText(text);
 			}
 		} else {
 			if (infile.token(i, 0)->compare(0, maintag.size(), maintag) == 0) {
-				text = infile.token(i, 0)->getText();
-				hre.replaceDestructive(text, mainXtag, maintagQuery);
+				text = mainXtag + infile.token(i, 0)->substr(maintag.size());
 				infile.token(i, 0)->setText(text);
 			}
 		}
@@ -607,7 +597,6 @@ void Tool_filter::getCommandList(vector<pair<string, string> >& commands,
 		tag += m_variant;
 	}
 	vector<string> clist;
-	HumRegex hre;
 	for (int i=0; i<(int)refs.size(); i++) {
 		string refkey = refs[i]->getGlobalReferenceKey();
 		if (refkey != tag) {
@@ -616,11 +605,14 @@ void Tool_filter::getCommandList(vector<pair<string, string> >& commands,
 		string command = refs[i]->getGlobalReferenceValue();
 		splitPipeline(clist, command);
 		for (int j=0; j<(int)clist.size(); j++) {
-			if (hre.search(clist[j], "^\\s*([^\\s]+)")) {
-				entry.first  = hre.getMatch(1);
-				entry.second = clist[j];
-				commands.push_back(entry);
+			// commands have no leading spaces after splitPipeline():
+			if (clist[j].empty()) {
+				continue;
 			}
+			auto found = find_if(clist[j].begin(), clist[j].end(), ::isspace);
+			entry.first  = string(clist[j].begin(), found);
+			entry.second = clist[j];
+			commands.push_back(entry);
 		}
 	}
 }
@@ -712,10 +704,11 @@ void Tool_filter::splitPipeline(vector<string>& clist, const string& command) {
 	}
 
 	// remove leading and trailing spaces
-	HumRegex hre;
 	for (int i=0; i<(int)clist.size(); i++) {
-		hre.replaceDestructive(clist[i], "", "^\\s+");
-		hre.replaceDestructive(clist[i], "", "\\s+$");
+		auto first = find_if_not(clist[i].begin(), clist[i].end(), ::isspace);
+		clist[i].erase(clist[i].begin(), first);
+		auto last = find_if_not(clist[i].rbegin(), clist[i].rend(), ::isspace);
+		clist[i].erase(last.base(), clist[i].end());
 	}
 
 }
@@ -757,6 +750,40 @@ void Tool_filter::getUniversalCommandList(vector<pair<string, string> >& command
 
 
 
+//////////////////////////////
+//
+// Tool_filter::getToolCache -- Return the tool instances of the current
+//     thread, indexed by filter command.
+//
+
+map<string, std::unique_ptr<HumTool>>& Tool_filter::getToolCache(void) {
+	thread_local map<string, std::unique_ptr<HumTool>> cache;
+	return cache;
+}
+
+
+
+//////////////////////////////
+//
+// Tool_filter::releaseTool -- Clear the output of a cached tool so that
+//     it can be run again, or delete the tool if it is not cached.  Cached
+//     tools that had an error are deleted as well.
+//
+
+void Tool_filter::releaseTool(const string& command, HumTool* tool) {
+	map<string, std::unique_ptr<HumTool>>& cache = getToolCache();
+	auto it = cache.find(command);
+	if ((it == cache.end()) || (it->second.get() != tool)) {
+		delete tool;
+	} else if (tool->hasError()) {
+		cache.erase(it);
+	} else {
+		tool->clearOutput();
+	}
+}
+
+
+
 //////////////////////////////
 //
 // Tool_filter::initialize -- extract time signature lines for
@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Sat Jun 17 15:24:23 CEST 2017
-// Last Modified: Fri Aug 11 18:25:50 EDT 2017
+// Last Modified: Sun Oct 18 21:06:33 PDT 2026
 // Filename:      tool-imitation.cpp
 // URL:           https://github.com/craigsapp/humlib/blob/master/src/tool-imitation.cpp
 // Syntax:        C++11; humlib
@@ -272,9 +272,62 @@ void Tool_imitation::doAnalysis(vector<vector<string> >& results,
 		getIntervals(intervals.at(i), attacks.at(i));
 	}
 
+	vector<ImitationVoice> voices(attacks.size());
+	map<HumNum, int> durationids;
+	for (int i=0; i<(int)voices.size(); i++) {
+		prepareVoice(voices.at(i), attacks.at(i), intervals.at(i), durationids);
+	}
+
 	for (int i=0; i<(int)attacks.size(); i++) {
 		for (int j=i+1; j<(int)attacks.size(); j++) {
-			analyzeImitation(results, attacks, intervals, i, j);
+			analyzeImitation(results, attacks, intervals, voices, i, j);
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// Tool_imitation::prepareVoice -- Store the intervals, durations and start
+//    times of the attacks in a voice, and index the attacks by their
+//    interval and duration.  Only attacks that have the same interval (or
+//    the inverted interval) and duration as the first attack of a sequence
+//    can start a match with it, so the index gives the candidate matches
+//    without comparing every pair of attacks.
+//
+
+void Tool_imitation::prepareVoice(ImitationVoice& voice,
+		vector<NoteCell*>& attacks, vector<double>& intervals,
+		map<HumNum, int>& durationids) {
+	int size = (int)attacks.size();
+	voice.intervals.resize(size);
+	voice.durations.resize(size);
+	voice.starttimes.resize(size);
+	voice.starts.clear();
+
+	for (int i=0; i<size; i++) {
+		if (Convert::isNaN(intervals.at(i))) {
+			voice.intervals.at(i) = ImitationVoice::NOINTERVAL;
+		} else {
+			voice.intervals.at(i) = (int)intervals.at(i);
+		}
+		if (m_duration) {
+			HumNum duration = attacks.at(i)->getDuration();
+			auto it = durationids.find(duration);
+			if (it == durationids.end()) {
+				int id = (int)durationids.size();
+				durationids[duration] = id;
+				voice.durations.at(i) = id;
+			} else {
+				voice.durations.at(i) = it->second;
+			}
+		} else {
+			voice.durations.at(i) = 0;
+		}
+		voice.starttimes.at(i) = attacks.at(i)->getToken()->getDurationFromStart();
+		if (voice.intervals.at(i) != ImitationVoice::NOINTERVAL) {
+			voice.starts[std::make_pair(voice.intervals.at(i), voice.durations.at(i))].push_back(i);
 		}
 	}
 }
@@ -312,12 +365,14 @@ void Tool_imitation::getIntervals(vector<double>& intervals,
 
 void Tool_imitation::analyzeImitation(vector<vector<string>>& results,
 		vector<vector<NoteCell*>>& attacks, vector<vector<double>>& intervals,
-		int v1, int v2) {
+		vector<ImitationVoice>& voices, int v1, int v2) {
 
 	vector<NoteCell*>& v1a = attacks.at(v1);
 	vector<NoteCell*>& v2a = attacks.at(v2);
 	vector<double>& v1i = intervals.at(v1);
 	vector<double>& v2i = intervals.at(v2);
+	ImitationVoice& voice1 = voices.at(v1);
+	ImitationVoice& voice2 = voices.at(v2);
 
 	int min = m_threshold - 1;
 	int count;
@@ -326,14 +381,38 @@ void Tool_imitation::analyzeImitation(vector<vector<string>>& results,
 	vector<int> enum2(v2a.size(), 0);
 
 	for (int i=0; i<(int)v1i.size() - 1; i++) {
-		count = 0;
-		for (int j=0; j<(int)v2i.size() - 1; j++) {
-			if (m_rest || m_rest2) {
-				if ((i > 0) && (!Convert::isNaN(attacks.at(v1).at(i-1)->getSgnDiatonicPitch()))) {
-					// match initiator must be preceded by a rest (or start of music)
-					continue;
-				}
+		if (m_rest || m_rest2) {
+			if ((i > 0) && (!Convert::isNaN(attacks.at(v1).at(i-1)->getSgnDiatonicPitch()))) {
+				// match initiator must be preceded by a rest (or start of music)
+				continue;
+			}
+		}
+		int interval1 = voice1.intervals.at(i);
+		if (interval1 == ImitationVoice::NOINTERVAL) {
+			// sequences cannot start with rests
+			continue;
+		}
+		if (m_inversion) {
+			interval1 = -interval1;
+		}
+		auto found = voice2.starts.find(std::make_pair(interval1, voice1.durations.at(i)));
+		if (found == voice2.starts.end()) {
+			continue;
+		}
+
+		// Attacks in the second voice that are not in the list cannot
+		// start a match, so stepping over them is the same as comparing
+		// them.  nextj is the next attack that is not inside of an
+		// earlier (partial) match.
+		int nextj = 0;
+		for (int j : found->second) {
+			if (j >= (int)v2i.size() - 1) {
+				break;
 			}
+			if (j < nextj) {
+				continue;
+			}
+			nextj = j + 1;
 			if (m_rest2) {
 				if ((j > 0) && (!Convert::isNaN(attacks.at(v2).at(j-1)->getSgnDiatonicPitch()))) {
 					// match target must be preceded by a rest (or start of music)
@@ -344,12 +423,12 @@ void Tool_imitation::analyzeImitation(vector<vector<string>>& results,
 				// avoid re-matching an existing match as a submatch
 				continue;
 			}
-			count = compareSequences(v1a, v1i, i, v2a, v2i, j);
+			count = compareSequences(voice1, i, voice2, j);
 			if ((count >= min) && (m_intervals.size() > 0)) {
 				count = checkForIntervalSequence(m_intervals, v1i, i, count);
 			}
 			if (count < min) {
-				j += count;
+				nextj = j + count + 1;
 				continue;
 			}
 
@@ -362,7 +441,7 @@ void Tool_imitation::analyzeImitation(vector<vector<string>>& results,
 			HumNum distance2 = time1 - time2;
 
 			if (m_maxdistanceQ && (distance1.getAbs().getFloat() > m_maxdistance)) {
-				j += count;
+				nextj = j + count + 1;
 				continue;
 			}
 
@@ -626,7 +705,7 @@ void Tool_imitation::analyzeImitation(vector<vector<string>>& results,
 			}
 
 			// skip over match (need to do in i as well somehow)
-			j += count;
+			nextj = j + count + 1;
 		} // j loop
 	} // i loop
 }
@@ -686,90 +765,68 @@ int Tool_imitation::checkForIntervalSequence(vector<int>& m_intervals,
 //     interval count).
 //
 
-int Tool_imitation::compareSequences(vector<NoteCell*>& attack1,
-		vector<double>& seq1, int i1, vector<NoteCell*>& attack2,
-		vector<double>& seq2, int i2) {
+int Tool_imitation::compareSequences(ImitationVoice& voice1, int i1,
+		ImitationVoice& voice2, int i2) {
+	vector<int>& seq1 = voice1.intervals;
+	vector<int>& seq2 = voice2.intervals;
+	vector<int>& dur1 = voice1.durations;
+	vector<int>& dur2 = voice2.durations;
+
 	int count = 0;
 	// sequences cannot start with rests
-	if (Convert::isNaN(seq1.at(i1)) || Convert::isNaN(seq2.at(i2))) {
+	if ((seq1.at(i1) == ImitationVoice::NOINTERVAL) || (seq2.at(i2) == ImitationVoice::NOINTERVAL)) {
 		return count;
 	}
 	if (m_nozero) {
 		// exclude matches that start at the same time.
-		if (attack1.at(i1)->getToken()->getDurationFromStart() == attack2.at(i2)->getToken()->getDurationFromStart()) {
+		if (voice1.starttimes.at(i1) == voice2.starttimes.at(i2)) {
 			return count;
 		}
 	} else if (m_onlyzero) {
 		// exclude matches that do not start at the same time (parallel motion).
-		if (attack1.at(i1)->getToken()->getDurationFromStart() != attack2.at(i2)->getToken()->getDurationFromStart()) {
+		if (voice1.starttimes.at(i1) != voice2.starttimes.at(i2)) {
 			return count;
 		}
 	}
 
-	HumNum dur1;
-	HumNum dur2;
-
-	while ((i1+count < (int)seq1.size()) && (i2+count < (int)seq2.size())) {
-
-		if (m_duration) {
-			dur1 = attack1.at(i1+count)->getDuration();
-			dur2 = attack2.at(i2+count)->getDuration();
-			if (dur1 != dur2) {
-				break;
-			}
+	int size1 = (int)seq1.size();
+	int size2 = (int)seq2.size();
+	while ((i1+count < size1) && (i2+count < size2)) {
+		// (duration IDs are all zero if not comparing durations)
+		if (dur1[i1+count] != dur2[i2+count]) {
+			break;
 		}
 
-		if (Convert::isNaN(seq1.at(i1+count))) {
-			// the first voice's interval is to/from a rest
-			if (Convert::isNaN(seq2.at(i2+count))) {
-				// The seoncd voice's interval is also to/from a rest,
-				// so increment count and continue.
+		int interval1 = seq1[i1+count];
+		int interval2 = seq2[i2+count];
+		if ((interval1 == ImitationVoice::NOINTERVAL) || (interval2 == ImitationVoice::NOINTERVAL)) {
+			if (interval1 == interval2) {
+				// Both intervals are to/from a rest, so increment count
+				// and continue.
 				count++;
 				continue;
-			} else {
-				// The second voice's interval is not to/from a rest,
-				// so return the current count.
-				if (count) {
-					return count + 1;
-				} else {
-					return count;
-				}
-			}
-		} else if (Convert::isNaN(seq2.at(i2+count))) {
-			// The second voice's interval is to/from a rest
-			// but already know that the first one is not, so return
-			// current count;
-			if (count) {
-				return count + 1;
-			} else {
-				return count;
 			}
-		} else if (m_inversion && (seq1.at(i1+count) == -seq2.at(i2+count))) {
-         // The two sequences match as inversions at this point, so continue.
-			count++;
-		} else if ((!m_inversion) && (seq1.at(i1+count) == seq2.at(i2+count))) {
-         // The two sequences match at this point, so continue.
-			count++;
-			continue;
-		} else {
+			// Only one interval is to/from a rest, so return the
+			// current count.
+			return count ? count + 1 : count;
+		}
+		if (m_inversion) {
+			interval2 = -interval2;
+		}
+		if (interval1 != interval2) {
 			// The sequences do not match so return the current count.
-			if (count) {
-				return count + 1;
-			} else {
-				return count;
-			}
+			return count ? count + 1 : count;
 		}
+		// The two sequences match at this point, so continue.
+		count++;
 	}
 
-	if (count) {
-		// don't add one for some reaason (this will cause out-of-bounds)
-		return count;
-	} else {
-		return count;
-	}
+	// don't add one for some reaason (this will cause out-of-bounds)
+	return count;
 }
 
 
+
 // END_MERGE
 
 } // end namespace hum
@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Tue Sep 12 13:31:48 PDT 2023
-// Last Modified: Mon Sep 18 10:45:14 PDT 2023
+// Last Modified: Sun Oct 18 22:31:07 PDT 2026
 // Filename:      tool-meter.cpp
 // URL:           https://github.com/craigsapp/humlib/blob/master/src/tool-meter.cpp
 // Syntax:        C++11; humlib
@@ -739,14 +739,13 @@ void Tool_meter::processLine(HumdrumLine& line, vector<HumNum>& curNum,
 		return;
 	}
 
-	HumRegex hre;
 	if (line.isBarline()) {
 		for (int i=0; i<fieldCount; i++) {
 			HTp token = line.token(i);
 			if (!token->isKern()) {
 				continue;
 			}
-			if (hre.search(token, "-")) {
+			if (token->find('-') != string::npos) {
 				// invisible barline: ignore
 				continue;
 			}
@@ -759,11 +758,16 @@ void Tool_meter::processLine(HumdrumLine& line, vector<HumNum>& curNum,
 
 	if (line.isInterpretation()) {
 		// check for time signatures
+		HumRegex hre;
 		for (int i=0; i<fieldCount; i++) {
 			HTp token = line.token(i);
 			if (!token->isKern()) {
 				continue;
 			}
+			if ((token->compare(0, 2, "*M") != 0) &&
+					(token->compare(0, 6, "*beat:") != 0)) {
+				continue;
+			}
 			if (hre.search(token, "^\\*M(\\d+)/(\\d+)")) {
 				int top = hre.getMatchInt(1);
 				int bot = hre.getMatchInt(2);
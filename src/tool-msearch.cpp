@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Sun Aug 27 06:15:38 PDT 2017
-// Last Modified: Tue Nov 23 16:00:54 CET 2021
+// Last Modified: Sun Oct 18 22:44:19 PDT 2026
 // Filename:      tool-msearch.cpp
 // URL:           https://github.com/craigsapp/humlib/blob/master/src/tool-msearch.cpp
 // Syntax:        C++11; humlib
@@ -12,7 +12,7 @@
 
 #include "tool-msearch.h"
 #include "Convert.h"
-#include "HumRegex.h"
+#include "HumLyricIndex.h"
 
 using namespace std;
 
@@ -59,6 +59,8 @@ void SonorityDatabase::buildDatabase(HLp line) {
 		for (int j=0; j<scount; j++) {
 			expandList();
 			m_notes.back().setToken(token, nullQ, j);
+			m_sonority.addDiatonic(m_notes.back().getBase7());
+			m_sonority.addBase40(m_notes.back().getBase40());
 			if (m_notes.back().getBase12() < lowest12) {
 				lowesti = (int)m_notes.size() - 1;
 				lowest12 = m_notes.back().getBase12();
@@ -80,6 +82,8 @@ void SonorityDatabase::buildDatabase(HLp line) {
 void SonorityDatabase::addNote(const std::string& text) {
 	expandList();
 	m_notes.back().setString(text);
+	m_sonority.addDiatonic(m_notes.back().getBase7());
+	m_sonority.addBase40(m_notes.back().getBase40());
 	// not dealing with lowest note
 }
 
@@ -110,8 +114,11 @@ void MSearchQueryToken::parseHarmonicQuery(void) {
 	}
 
 	hquery.resize(hpieces.size());
+	hsonority.clear();
 	for (int i=0; i<(int)hpieces.size(); i++) {
 		hquery[i].setString(hpieces[i]);
+		hsonority.addDiatonic(hquery[i].getBase7());
+		hsonority.addBase40(hquery[i].getBase40());
 	}
 }
 
@@ -232,98 +239,30 @@ void Tool_msearch::initialize(void) {
 
 
 
-//////////////////////////////
-//
-// Tool_msearch::fillWords --
-//
-
-void Tool_msearch::fillWords(HumdrumFile& infile, vector<TextInfo*>& words) {
-	vector<HTp> textspines;
-	infile.getSpineStartList(textspines, "**silbe");
-	if (textspines.empty()) {
-		infile.getSpineStartList(textspines, "**text");
-	}
-	for (int i=0; i<(int)textspines.size(); i++) {
-		fillWordsForTrack(words, textspines[i]);
-	}
-}
-
-
-
-//////////////////////////////
-//
-// Tool_msearch::fillWordsForTrack --
-//
-
-void Tool_msearch::fillWordsForTrack(vector<TextInfo*>& words,
-		HTp starttoken) {
-	HTp tok = starttoken->getNextToken();
-	while (tok != NULL) {
-		if (tok->empty()) {
-			tok = tok->getNextToken();
-			continue;
-		}
-		if (tok->isNull()) {
-			tok = tok->getNextToken();
-			continue;
-		}
-		if (!tok->isData()) {
-			tok = tok->getNextToken();
-			continue;
-		}
-		if (tok->at(0) == '-') {
-			// append a syllable to the end of previous word
-			if (!words.empty()) {
-				words.back()->fullword += tok->substr(1, string::npos);
-				if (words.back()->fullword.back() == '-') {
-					words.back()->fullword.pop_back();
-				}
-			}
-			tok = tok->getNextToken();
-			continue;
-		} else {
-			// start a new word
-			TextInfo* temp = new TextInfo();
-			temp->nexttoken = NULL;
-			if (!words.empty()) {
-				words.back()->nexttoken = tok;
-			}
-			temp->fullword = *tok;
-			if (!temp->fullword.empty()) {
-				if (temp->fullword.back() == '-') {
-					temp->fullword.pop_back();
-				}
-			}
-			temp->starttoken = tok;
-			words.push_back(temp);
-			tok = tok->getNextToken();
-			continue;
-		}
-	}
-}
-
-
-
 //////////////////////////////
 //
 // Tool_msearch::doTextSearch -- do a basic text search of all parts.
+//     The words of the file are collected in a HumLyricIndex, so that
+//     each query is only compared once to each distinct word.
 //
 
 void Tool_msearch::doTextSearch(HumdrumFile& infile, NoteGrid& grid,
 		vector<MSearchTextQuery>& query) {
 
-	vector<TextInfo*> words;
-	words.reserve(10000);
-	fillWords(infile, words);
+	HumLyricIndex index;
+	index.addFile(infile);
 	int tcount = 0;
 
-	HumRegex hre;
+	TextInfo word;
 	for (int i=0; i<(int)query.size(); i++) {
-		for (int j=0; j<(int)words.size(); j++) {
-			if (hre.search(words.at(j)->fullword, query.at(i).word, "i")) {
-				tcount++;
-				markTextMatch(infile, *words[j]);
-			}
+		vector<int> entries = index.findRegex(query.at(i).word);
+		for (int j=0; j<(int)entries.size(); j++) {
+			int next = index.getNextEntry(entries[j]);
+			word.fullword = index.getEntry(entries[j]).word;
+			word.starttoken = index.getToken(entries[j], infile);
+			word.nexttoken = next < 0 ? NULL : index.getToken(next, infile);
+			tcount++;
+			markTextMatch(infile, word);
 		}
 	}
 
@@ -358,11 +297,6 @@ void Tool_msearch::doTextSearch(HumdrumFile& infile, NoteGrid& grid,
 		infile.createLinesFromTokens();
 	}
 
-	for (int i=0; i<(int)words.size(); i++) {
-		delete words[i];
-		words[i] = NULL;
-	}
-
 	if (!m_quietQ) {
 		addTextSearchSummary(infile, tcount, m_marker);
 	}
@@ -1035,17 +969,30 @@ bool Tool_msearch::doHarmonicPitchSearch(MSearchQueryToken& query, HTp token) {
 		onlyQ = true;
 	}
 
+	// Reject the sonority with pitch-class mask lookups if any pitch class
+	// in the query is missing, before collecting notes to mark.
+	const HumSonority& present = sonorities.getSonority();
+	for (int i=0; i<(int)query.hquery.size(); i++) {
+		if (query.hquery[i].hasAccidental()) {
+			if (!present.hasBase40(query.hquery[i].getBase40())) {
+				return false;
+			}
+		} else if (!present.hasDiatonic(query.hquery[i].getBase7())) {
+			return false;
+		}
+	}
+	if (onlyQ) {
+		// All notes in the sonority must be in the query.
+		int extra = present.getDiatonicMask() & ~query.hsonority.getDiatonicMask();
+		if (extra) {
+			return false;
+		}
+	}
+
 	vector<int> diatonicCountsQuery(7, 0);
 	vector<int> diatonicCountsMatch(7, 0);
-	vector<int> diatonicCountsData(7, 0);
 	vector<int> chromaticCountsQuery(40, 0);
 	vector<int> chromaticCountsMatch(40, 0);
-	vector<int> chromaticCountsData(40, 0);
-
-	for (int i=0; i<sonorities.getNoteCount(); i++) {
-		diatonicCountsData.at(sonorities[i].getBase7Pc())++;
-		chromaticCountsData.at(sonorities[i].getBase40Pc())++;
-	}
 
 	int sum = 0;
 	for(int i=0; i<(int)query.hquery.size(); i++) {
@@ -1110,18 +1057,6 @@ bool Tool_msearch::doHarmonicPitchSearch(MSearchQueryToken& query, HTp token) {
 				return false;
 			}
 		}
-	} else if (onlyQ) {
-		SonorityDatabase son2;
-		for (int i=0; i<(int)query.hpieces.size(); i++) {
-			son2.addNote(query.hpieces[i]);
-		}
-
-		for (int k=0; k<sonorities.getNoteCount(); k++) {
-			int status2 = checkHarmonicPitchMatch(sonorities[k], son2, true);
-			if (!status2) {
-				return false;
-			}
-		}
 	}
 
 	return true;
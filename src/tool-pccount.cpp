@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Sat Sep  7 20:22:22 PDT 2019
-// Last Modified: Sat Sep  7 20:22:25 PDT 2019
+// Last Modified: Mon Oct 19 01:16:38 PDT 2026
 // Filename:      tool-pccount.cpp
 // URL:           https://github.com/craigsapp/humlib/blob/master/src/tool-pccount.cpp
 // Syntax:        C++11; humlib
@@ -14,6 +14,7 @@
 #include "tool-pccount.h"
 #include "Convert.h"
 #include "HumRegex.h"
+#include "HumThreadPool.h"
 
 using namespace std;
 
@@ -22,6 +23,57 @@ namespace hum {
 // START_MERGE
 
 
+
+//////////////////////////////
+//
+// PccountHistogram::clear -- Remove all voices.
+//
+
+void PccountHistogram::clear(void) {
+	names.clear();
+	counts.clear();
+}
+
+
+
+//////////////////////////////
+//
+// PccountHistogram::getVoiceIndex -- Return the index of the voice with
+//     the given instrument name, adding the voice if it is not yet in
+//     the histogram.
+//
+
+int PccountHistogram::getVoiceIndex(const string& name) {
+	for (int i=0; i<(int)names.size(); i++) {
+		if (names[i] == name) {
+			return i;
+		}
+	}
+	names.push_back(name);
+	counts.emplace_back(40, 0.0);
+	return (int)names.size() - 1;
+}
+
+
+
+//////////////////////////////
+//
+// PccountHistogram::merge -- Add the counts of another histogram.  Voices
+//     with the same instrument name are combined, and new voices are added
+//     after the current ones.
+//
+
+void PccountHistogram::merge(const PccountHistogram& histogram) {
+	for (int i=0; i<(int)histogram.names.size(); i++) {
+		int index = getVoiceIndex(histogram.names[i]);
+		for (int j=0; j<(int)histogram.counts[i].size(); j++) {
+			counts[index][j] += histogram.counts[i][j];
+		}
+	}
+}
+
+
+
 /////////////////////////////////
 //
 // Tool_gridtest::Tool_pccount -- Set the recognized options for the tool.
@@ -29,6 +81,7 @@ namespace hum {
 
 Tool_pccount::Tool_pccount(void) {
 	define("a|attacks=b",                 "count attacks instead of durations");
+	define("C|corpus=b",                  "combine counts of all inputs by instrument name");
 	define("d|data|vega-data=b",          "display the vega-lite template.");
 	define("f|full=b",                    "full count attacks all single sharps and flats.");
 	define("ff|double-full=b",            "full count attacks all double sharps and flats.");
@@ -53,6 +106,19 @@ Tool_pccount::Tool_pccount(void) {
 //
 
 bool Tool_pccount::run(HumdrumFileSet& infiles) {
+	if (getBoolean("corpus") && (infiles.getCount() > 1)) {
+		// Count the files in parallel, then merge the counts in input order.
+		initialize(infiles[0]);
+		vector<PccountHistogram> histograms(infiles.getCount());
+		HumThreadPool pool;
+		pool.run(infiles.getCount(), [&](int index) {
+			fillHistogram(infiles[index], histograms[index]);
+		});
+		for (int i=0; i<(int)histograms.size(); i++) {
+			m_histogram.merge(histograms[i]);
+		}
+		return true;
+	}
 	bool status = true;
 	for (int i=0; i<infiles.getCount(); i++) {
 		status &= run(infiles[i]);
@@ -74,13 +140,78 @@ bool Tool_pccount::run(HumdrumFile& infile, ostream& out) {
 
 
 bool Tool_pccount::run(HumdrumFile& infile) {
-   initialize(infile);
+	initialize(infile);
+	if (m_corpus) {
+		PccountHistogram histogram;
+		fillHistogram(infile, histogram);
+		m_histogram.merge(histogram);
+		return true;
+	}
 	processFile(infile);
 	return true;
 }
 
 
 
+//////////////////////////////
+//
+// Tool_pccount::getSegmentBatchSize -- With the --corpus option, read several
+//     segments at a time in STREAM_INTERFACE so that they are counted in
+//     parallel by run(HumdrumFileSet&).
+//
+
+int Tool_pccount::getSegmentBatchSize(void) {
+	if (getBoolean("corpus")) {
+		return 4 * HumThreadPool::getHardwareThreads();
+	}
+	return 1;
+}
+
+
+
+//////////////////////////////
+//
+// Tool_pccount::finally -- Print the combined counts of all inputs
+//     for the --corpus option.
+//
+
+void Tool_pccount::finally(void) {
+	if (!m_corpus || m_histogram.names.empty()) {
+		return;
+	}
+	loadHistogram();
+	HumdrumFile empty;
+	printOutput(empty);
+	m_histogram.clear();
+}
+
+
+
+//////////////////////////////
+//
+// Tool_pccount::getHistogram -- Return the combined counts of the inputs
+//     for the --corpus option.
+//
+
+const PccountHistogram& Tool_pccount::getHistogram(void) const {
+	return m_histogram;
+}
+
+
+
+//////////////////////////////
+//
+// Tool_pccount::mergeHistogram -- Add counts (such as from another
+//     instance of the tool) to the combined counts for the --corpus
+//     option.
+//
+
+void Tool_pccount::mergeHistogram(const PccountHistogram& histogram) {
+	m_histogram.merge(histogram);
+}
+
+
+
 //////////////////////////////
 //
 // Tool_pccount::initialize --
@@ -88,6 +219,7 @@ bool Tool_pccount::run(HumdrumFile& infile) {
 
 void Tool_pccount::initialize(HumdrumFile& infile) {
 	m_attack     = getBoolean("attacks");
+	m_corpus     = getBoolean("corpus");
 	m_full       = getBoolean("full");
 	m_doublefull = getBoolean("double-full");
 	m_normalize  = getBoolean("normalize");
@@ -105,7 +237,7 @@ void Tool_pccount::initialize(HumdrumFile& infile) {
 	m_page       = getBoolean("page");
 	if (getBoolean("id")) {
 		m_id = getString("id");
-	} else {
+	} else if (!m_corpus) {
 		string filename = infile.getFilename();
 	 	auto pos = filename.rfind("/");
 		if (pos != string::npos) {
@@ -211,7 +343,17 @@ string Tool_pccount::getFinal(HumdrumFile& infile) {
 
 void Tool_pccount::processFile(HumdrumFile& infile) {
 	countPitches(infile);
+	printOutput(infile);
+}
+
+
+
+//////////////////////////////
+//
+// Tool_pccount::printOutput -- Print the counts in the requested format.
+//
 
+void Tool_pccount::printOutput(HumdrumFile& infile) {
 	string datavar;
 	string target;
 	string jsonvar;
@@ -491,7 +633,11 @@ void Tool_pccount::countPitches(HumdrumFile& infile) {
 	for (int i=0; i<infile.getStrandCount(); i++) {
 		HTp sstart = infile.getStrandStart(i);
 		HTp send = infile.getStrandEnd(i);
-		addCounts(sstart, send);
+		if ((!sstart) || (!sstart->isKern())) {
+			continue;
+		}
+		int kindex = m_rkern[sstart->getTrack()];
+		addCounts(sstart, send, m_counts[kindex]);
 	}
 
 	// fill in sum for all parts
@@ -504,20 +650,80 @@ void Tool_pccount::countPitches(HumdrumFile& infile) {
 }
 
 
+
 //////////////////////////////
 //
-// Tool_pccount::addCounts --
+// Tool_pccount::fillHistogram -- Count the pitch classes of a file by
+//     instrument name (or "voice N" for the Nth **kern spine if it has
+//     no name).  This only uses the counting options of the tool, so
+//     files can be counted in parallel.
 //
 
-void Tool_pccount::addCounts(HTp sstart, HTp send) {
-	if (!sstart) {
-		return;
+void Tool_pccount::fillHistogram(HumdrumFile& infile, PccountHistogram& histogram) {
+	vector<int> rkern(infile.getTrackCount() + 1, -1);
+	vector<HTp> starts = infile.getKernSpineStartList();
+	for (int i=0; i<(int)starts.size(); i++) {
+		string name;
+		HTp current = starts[i];
+		while (current && !current->isData()) {
+			if (current->compare(0, 3, "*I\"") == 0) {
+				name = current->substr(3);
+				break;
+			}
+			current = current->getNextToken();
+		}
+		if (name.empty()) {
+			name = "voice " + to_string(i + 1);
+		}
+		rkern[starts[i]->getTrack()] = histogram.getVoiceIndex(name);
 	}
-	if (!sstart->isKern()) {
-		return;
+
+	for (int i=0; i<infile.getStrandCount(); i++) {
+		HTp sstart = infile.getStrandStart(i);
+		HTp send = infile.getStrandEnd(i);
+		if ((!sstart) || (!sstart->isKern())) {
+			continue;
+		}
+		int index = rkern[sstart->getTrack()];
+		if (index < 0) {
+			continue;
+		}
+		addCounts(sstart, send, histogram.counts[index]);
 	}
-	int track = sstart->getTrack();
-	int kindex = m_rkern[track];
+}
+
+
+
+//////////////////////////////
+//
+// Tool_pccount::loadHistogram -- Use the combined counts of the --corpus
+//     option for printing, with the sum of all voices first.
+//
+
+void Tool_pccount::loadHistogram(void) {
+	m_names.clear();
+	m_abbreviations.clear();
+	m_counts.clear();
+	m_names.push_back("all");
+	m_counts.emplace_back(40, 0.0);
+	for (int i=0; i<(int)m_histogram.names.size(); i++) {
+		m_names.push_back(m_histogram.names[i]);
+		m_counts.push_back(m_histogram.counts[i]);
+		for (int j=0; j<(int)m_counts[0].size(); j++) {
+			m_counts[0][j] += m_histogram.counts[i][j];
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// Tool_pccount::addCounts -- Add the pitch classes of a strand to the
+//     counts.
+//
+
+void Tool_pccount::addCounts(HTp sstart, HTp send, vector<double>& counts) {
 	HTp current = sstart;
 	while (current && (current != send)) {
 		if (!current->isData()) {
@@ -541,10 +747,10 @@ void Tool_pccount::addCounts(HTp sstart, HTp send) {
 			}
 			int b40 = Convert::kernToBase40(subtokens[i]);
 			if (m_attack) {
-				m_counts[kindex][b40%40]++;
+				counts[b40%40]++;
 			} else {
 				double duration = Convert::recipToDuration(subtokens[i]).getFloat();
-				m_counts[kindex][b40%40] += duration;
+				counts[b40%40] += duration;
 			}
 		}
 		current = current->getNextToken();
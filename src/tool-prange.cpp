@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Mon Jul 18 11:23:42 PDT 2005
-// Last Modified: Sat Jun  8 17:37:39 PDT 2024 (ported to humlib)
+// Last Modified: Mon Oct 19 01:16:38 PDT 2026
 // Filename:      src/tool-prange.cpp
 // URL:           https://github.com/craigsapp/humlib/blob/master/src/tool-prange.cpp
 // Syntax:        C++11; humlib
@@ -15,7 +15,9 @@
 #include "tool-prange.h"
 #include "HumRegex.h"
 #include "Convert.h"
+#include "HumThreadPool.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
@@ -78,6 +80,27 @@ void _VoiceInfo::clear(void) {
 }
 
 
+
+//////////////////////////////
+//
+// _VoiceInfo::add -- Add the histograms and finals of another voice.
+//
+
+void _VoiceInfo::add(const _VoiceInfo& info) {
+	for (int i=0; i<(int)midibins.size(); i++) {
+		midibins[i] += info.midibins.at(i);
+	}
+	for (int i=0; i<(int)diatonic.size(); i++) {
+		for (int j=0; j<(int)diatonic[i].size(); j++) {
+			diatonic[i][j] += info.diatonic.at(i).at(j);
+		}
+	}
+	diafinal.insert(diafinal.end(), info.diafinal.begin(), info.diafinal.end());
+	accfinal.insert(accfinal.end(), info.accfinal.begin(), info.accfinal.end());
+	namfinal.insert(namfinal.end(), info.namfinal.begin(), info.namfinal.end());
+}
+
+
 //////////////////////////////
 //
 // _VoiceInfo::print --
@@ -128,6 +151,7 @@ Tool_prange::Tool_prange(void) {
 	define("S|score=b",                 "convert range info to SCORE");
 	define("T|no-title=b",              "do not display a title");
 	define("a|all=b",                   "generate all-voice analysis");
+	define("C|corpus=b",                "combine histograms of all inputs by voice (or instrument with -i)");
 	define("c|range|count=s:60-71",     "count notes in a particular MIDI note number range (inclusive)");
 	define("debug=b",                   "trace input parsing");
 	define("d|duration=b",              "weight pitches by duration");
@@ -158,6 +182,21 @@ Tool_prange::Tool_prange(void) {
 //
 
 bool Tool_prange::run(HumdrumFileSet& infiles) {
+	if (getBoolean("corpus") && (infiles.getCount() > 1)) {
+		// Fill the histograms of the files in parallel, then merge them
+		// in input order.
+		initialize();
+		vector<vector<_VoiceInfo>> voiceInfo(infiles.getCount());
+		HumThreadPool pool;
+		pool.run(infiles.getCount(), [&](int index) {
+			getVoiceInfo(voiceInfo[index], infiles[index]);
+			fillHistograms(voiceInfo[index], infiles[index]);
+		});
+		for (int i=0; i<(int)voiceInfo.size(); i++) {
+			mergeCorpusVoiceInfo(voiceInfo[i]);
+		}
+		return true;
+	}
 	bool status = true;
 	for (int i=0; i<infiles.getCount(); i++) {
 		status &= run(infiles[i]);
@@ -191,12 +230,52 @@ bool Tool_prange::run(HumdrumFile& infile, ostream& out) {
 
 bool Tool_prange::run(HumdrumFile& infile) {
 	initialize();
+	if (m_corpusQ) {
+		vector<_VoiceInfo> voiceInfo;
+		getVoiceInfo(voiceInfo, infile);
+		fillHistograms(voiceInfo, infile);
+		mergeCorpusVoiceInfo(voiceInfo);
+		return true;
+	}
 	processFile(infile);
 	return true;
 }
 
 
 
+//////////////////////////////
+//
+// Tool_prange::getSegmentBatchSize -- With the --corpus option, read several
+//     segments at a time in STREAM_INTERFACE so that they are analyzed in
+//     parallel by run(HumdrumFileSet&).
+//
+
+int Tool_prange::getSegmentBatchSize(void) {
+	if (getBoolean("corpus")) {
+		return 4 * HumThreadPool::getHardwareThreads();
+	}
+	return 1;
+}
+
+
+
+//////////////////////////////
+//
+// Tool_prange::finally -- Print the combined histograms of all inputs
+//     for the --corpus option.
+//
+
+void Tool_prange::finally(void) {
+	if (!m_corpusQ || m_corpusInfo.empty()) {
+		return;
+	}
+	printCorpusAnalysis();
+	m_corpusInfo.clear();
+	m_corpusKeys.clear();
+}
+
+
+
 //////////////////////////////
 //
 // Tool_prange::initialize --  Initializations that only have to be done once
@@ -207,6 +286,7 @@ void Tool_prange::initialize(void) {
 	m_accQ         = getBoolean("color-accidentals");
 	m_addFractionQ = getBoolean("fraction");
 	m_allQ         = getBoolean("all");
+	m_corpusQ      = getBoolean("corpus");
 	m_debugQ       = getBoolean("debug");
 	m_defineQ      = false;
 	m_diatonicQ    = getBoolean("diatonic");
@@ -480,6 +560,86 @@ void Tool_prange::mergeAllVoiceInfo(vector<_VoiceInfo>& voiceInfo) {
 
 
 
+//////////////////////////////
+//
+// Tool_prange::mergeCorpusVoiceInfo -- Add the **kern voices of a file to
+//     the combined histograms of the --corpus option.  Voices are matched
+//     by their position in the file, or by instrument name with the
+//     --instrument option (unnamed voices are then matched by position).
+//
+
+void Tool_prange::mergeCorpusVoiceInfo(vector<_VoiceInfo>& voiceInfo) {
+	if (m_corpusInfo.empty()) {
+		m_corpusInfo.resize(1);
+		m_corpusInfo[0].name  = "all";
+		m_corpusInfo[0].abbr  = "all";
+		m_corpusInfo[0].track = 0;
+		m_corpusInfo[0].index = 0;
+		m_corpusKeys.resize(1);
+	}
+
+	int voice = 0;
+	for (int i=1; i<(int)voiceInfo.size(); i++) {
+		if (!voiceInfo[i].kernQ) {
+			continue;
+		}
+		voice++;
+		string key;
+		if (m_instrumentQ && !voiceInfo[i].name.empty()) {
+			key = "*I\"" + voiceInfo[i].name;
+		} else {
+			key = to_string(voice);
+		}
+		auto it = std::find(m_corpusKeys.begin(), m_corpusKeys.end(), key);
+		if (it != m_corpusKeys.end()) {
+			m_corpusInfo[it - m_corpusKeys.begin()].add(voiceInfo[i]);
+			continue;
+		}
+		int index = (int)m_corpusInfo.size();
+		m_corpusInfo.push_back(voiceInfo[i]);
+		m_corpusInfo.back().index = index;
+		m_corpusInfo.back().track = index;
+		m_corpusKeys.push_back(key);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// Tool_prange::printCorpusAnalysis -- Print the combined histograms of
+//     the --corpus option.  Reference records and key signatures are not
+//     used since they differ between the inputs.
+//
+
+void Tool_prange::printCorpusAnalysis(void) {
+	vector<_VoiceInfo>& voiceInfo = m_corpusInfo;
+	voiceInfo[0].clear();
+	voiceInfo[0].name  = "all";
+	voiceInfo[0].abbr  = "all";
+	voiceInfo[0].track = 0;
+	voiceInfo[0].index = 0;
+	mergeAllVoiceInfo(voiceInfo);
+	m_refmap.clear();
+
+	if (m_debugQ) {
+		for (int i=0; i<(int)voiceInfo.size(); i++) {
+			voiceInfo[i].print(cerr);
+		}
+	}
+
+	if (m_scoreQ) {
+		HumdrumFile empty;
+		stringstream scoreout;
+		printScoreFile(scoreout, voiceInfo, empty);
+		m_humdrum_text << scoreout.str();
+	} else {
+		printAnalysis(m_humdrum_text, voiceInfo[0].midibins);
+	}
+}
+
+
+
 //////////////////////////////
 //
 // Tool_prange::getVoiceInfo -- get names and track info for **kern spines.
@@ -50,6 +50,18 @@ Tool_rid::Tool_rid(void) {
 
 
 
+//////////////////////////////
+//
+// Tool_rid::isReusable -- Instances can be run on several files.
+//     Options are read again for each file, and no other data is kept.
+//
+
+bool Tool_rid::isReusable(void) {
+	return true;
+}
+
+
+
 /////////////////////////////////
 //
 // Tool_rid::run -- Do the main work of the tool.
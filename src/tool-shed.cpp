@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Sun Oct 13 11:41:16 PDT 2019
-// Last Modified: Thu May 13 09:42:30 PDT 2021
+// Last Modified: Sun Oct 18 23:51:02 PDT 2026
 // Filename:      tool-shed.cpp
 // URL:           https://github.com/craigsapp/humlib/blob/master/src/tool-shed.cpp
 // Syntax:        C++11; humlib
@@ -39,6 +39,18 @@ Tool_shed::Tool_shed(void) {
 
 
 
+//////////////////////////////
+//
+// Tool_shed::isReusable -- Instances can be run on several files.
+//     Search expressions are prepared again for each file.
+//
+
+bool Tool_shed::isReusable(void) {
+	return true;
+}
+
+
+
 /////////////////////////////////
 //
 // Tool_shed::run -- Do the main work of the tool.
@@ -140,6 +152,11 @@ void Tool_shed::prepareSearch(int index) {
 	m_exinterp = false;        // process exclusive interpretations
 	m_interpretation = false;  // process interpretations (other than exinterp
 	                           //     and spine manipulators).
+	m_localcomment = false;    // process local comments
+	m_globalcomment = false;   // process global comments
+	m_reference = false;       // process reference records
+	m_referencekey = false;    // process reference record keys
+	m_referencevalue = false;  // process reference record values
 
 	if (m_option.find("I") != std::string::npos) {
 		m_interpretation = true;
@@ -200,6 +217,9 @@ void Tool_shed::initialize(void) {
 		parseExpression(value);
 	}
 	m_exclusion = getString("exclusion-expression");
+	if (!m_exclusion.empty()) {
+		m_exclusionRegex = regex(m_exclusion);
+	}
 
 	if (getBoolean("X")) {
 		m_xInterp = getExInterp(getString("X"));
@@ -210,6 +230,7 @@ void Tool_shed::initialize(void) {
 	if (getBoolean("Z")) {
 		m_zInterp = getExInterp(getString("Z"));
 	}
+	prepareExpressions();
 }
 
 
@@ -371,13 +392,120 @@ vector<string> Tool_shed::addToExInterpList(void) {
 
 //////////////////////////////
 //
-// Tool_shed::processFile --
+// Tool_shed::prepareExpressions -- Prepare the options of each expression
+//     and compile its regular expressions, so that they do not have to be
+//     compiled again for each token.
 //
 
-void Tool_shed::processFile(HumdrumFile& infile) {
+void Tool_shed::prepareExpressions(void) {
+	m_expressions.clear();
+	m_expressions.resize(m_options.size());
 	for (int i=0; i<(int)m_options.size(); i++) {
 		prepareSearch(i);
-		processExpression(infile);
+		ShedExpression& expression = m_expressions[i];
+		expression.search         = m_search;
+		expression.replace        = m_replace;
+		expression.grepoptions    = m_grepoptions;
+		expression.exinterps      = m_exinterps;
+		expression.data           = m_data;
+		expression.barline        = m_barline;
+		expression.exinterp       = m_exinterp;
+		expression.interpretation = m_interpretation;
+		expression.localcomment   = m_localcomment;
+		expression.globalcomment  = m_globalcomment;
+		expression.reference      = m_reference;
+		expression.referencekey   = m_referencekey;
+		expression.referencevalue = m_referencevalue;
+		if (m_search.empty()) {
+			continue;
+		}
+
+		std::regex_constants::syntax_option_type flags = std::regex_constants::ECMAScript;
+		if (m_grepoptions.find("i") != std::string::npos) {
+			flags |= std::regex_constants::icase;
+		}
+		if (m_grepoptions.find("g") != std::string::npos) {
+			expression.replaceFlags = std::regex_constants::format_default;
+		} else {
+			expression.replaceFlags = std::regex_constants::format_first_only;
+		}
+
+		// searches that follow the signifier of the record type:
+		string anchor;
+		string search;
+		if (m_search[0] == '^') {
+			anchor = "";
+			search = m_search.substr(1);
+		} else {
+			anchor = ".*";
+			search = m_search;
+		}
+
+		expression.searchRegex = regex(m_search, flags);
+		if (expression.barline) {
+			expression.barlineRegex = regex("^=" + anchor + search, flags);
+		}
+		if (expression.interpretation) {
+			expression.interpretationRegex = regex("^\\*" + anchor + search, flags);
+		}
+		if (expression.localcomment) {
+			expression.localCommentRegex = regex("^!" + anchor + search, flags);
+		}
+		if (expression.globalcomment) {
+			expression.globalCommentRegex = regex("^!!" + anchor + search, flags);
+		}
+		if (expression.reference) {
+			expression.referenceRegex = regex("^!!!" + anchor + search, flags);
+		}
+		if (expression.exinterp) {
+			expression.exinterpRegex = regex("^\\*\\*" + anchor + search, flags);
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// Tool_shed::needsSequentialProcessing -- Returns true if the expressions
+//     have to be applied one at a time to the whole file.  This is only
+//     needed when an expression changes exclusive interpretations and an
+//     expression is limited to particular data types, since changing an
+//     exclusive interpretation changes the data type of the rest of the
+//     spine.  Otherwise all expressions can be applied to each line in turn.
+//
+
+bool Tool_shed::needsSequentialProcessing(void) {
+	bool exinterpQ = false;
+	bool datatypeQ = false;
+	for (int i=0; i<(int)m_expressions.size(); i++) {
+		if (m_expressions[i].search.empty()) {
+			continue;
+		}
+		if (m_expressions[i].exinterp) {
+			exinterpQ = true;
+		}
+		if (!m_expressions[i].exinterps.empty()) {
+			datatypeQ = true;
+		}
+	}
+	return exinterpQ && datatypeQ;
+}
+
+
+
+//////////////////////////////
+//
+// Tool_shed::processFile --
+//
+
+void Tool_shed::processFile(HumdrumFile& infile) {
+	if (needsSequentialProcessing()) {
+		for (int i=0; i<(int)m_expressions.size(); i++) {
+			processExpression(infile, m_expressions[i]);
+		}
+	} else {
+		processLines(infile);
 	}
 	m_humdrum_text << infile;
 }
@@ -386,53 +514,71 @@ void Tool_shed::processFile(HumdrumFile& infile) {
 
 //////////////////////////////
 //
-// Tool_shed::processExpression --
+// Tool_shed::processExpression -- Apply an expression to the whole file.
 //
 
-void Tool_shed::processExpression(HumdrumFile& infile) {
-	if (m_search == "") {
+void Tool_shed::processExpression(HumdrumFile& infile, ShedExpression& expression) {
+	if (expression.search == "") {
 		// nothing to do
 		return;
 	}
-	m_modified = false;
+	bool modified = false;
 
-	if (m_interpretation) {
-		searchAndReplaceInterpretation(infile);
+	if (expression.interpretation) {
+		for (int i=0; i<infile.getLineCount(); i++) {
+			modified |= searchAndReplaceInterpretation(infile, i, expression);
+		}
 	}
 
-	if (m_localcomment) {
-		searchAndReplaceLocalComment(infile);
+	if (expression.localcomment) {
+		for (int i=0; i<infile.getLineCount(); i++) {
+			modified |= searchAndReplaceLocalComment(infile, i, expression);
+		}
 	}
 
-	if (m_globalcomment) {
-		searchAndReplaceGlobalComment(infile);
+	if (expression.globalcomment) {
+		for (int i=0; i<infile.getLineCount(); i++) {
+			modified |= searchAndReplaceGlobalComment(infile, i, expression);
+		}
 	}
 
-	if (m_reference) {
-		searchAndReplaceReferenceRecords(infile);
+	if (expression.reference) {
+		for (int i=0; i<infile.getLineCount(); i++) {
+			modified |= searchAndReplaceReferenceRecords(infile, i, expression);
+		}
 	}
 
-	if (m_referencekey) {
-		searchAndReplaceReferenceKeys(infile);
+	if (expression.referencekey) {
+		for (int i=0; i<infile.getLineCount(); i++) {
+			modified |= searchAndReplaceReferenceKeys(infile, i, expression);
+		}
 	}
 
-	if (m_referencevalue) {
-		searchAndReplaceReferenceValues(infile);
+	if (expression.referencevalue) {
+		for (int i=0; i<infile.getLineCount(); i++) {
+			modified |= searchAndReplaceReferenceValues(infile, i, expression);
+		}
 	}
 
-	if (m_exinterp) {
-		searchAndReplaceExinterp(infile);
+	if (expression.exinterp) {
+		for (int i=0; i<infile.getLineCount(); i++) {
+			modified |= searchAndReplaceExinterp(infile, i, expression);
+		}
 	}
 
-	if (m_barline) {
-		searchAndReplaceBarline(infile);
+	if (expression.barline) {
+		for (int i=0; i<infile.getLineCount(); i++) {
+			modified |= searchAndReplaceBarline(infile, i, expression);
+		}
 	}
 
-	if (m_data) {
-		searchAndReplaceData(infile);
+	if (expression.data) {
+		for (int i=0; i<infile.getLineCount(); i++) {
+			modified |= searchAndReplaceData(infile, i, expression);
+		}
 	}
 
-	if (m_modified) {
+	if (modified) {
 		infile.createLinesFromTokens();
 	}
 }
@@ -441,326 +587,380 @@ void Tool_shed::processExpression(HumdrumFile& infile) {
 
 //////////////////////////////
 //
-// Tool_shed::searchAndReplaceBarline --
+// Tool_shed::processLines -- Apply all expressions to each line in turn,
+//     which gives the same result as applying each expression to the whole
+//     file before the next one (see needsSequentialProcessing()).  The text
+//     of a line is updated after each expression that changes it, since
+//     the type of a line and the keys and values of reference records are
+//     taken from the line text.
 //
 
-void Tool_shed::searchAndReplaceBarline(HumdrumFile& infile) {
-	string isearch;
-	if (m_search[0] == '^') {
-		isearch = "^=" + m_search.substr(1);
-	} else {
-		isearch = "^=.*" + m_search;
-	}
-	HumRegex hre;
+void Tool_shed::processLines(HumdrumFile& infile) {
+	bool modified = false;
 	for (int i=0; i<infile.getLineCount(); i++) {
-		if (!infile[i].isBarline()) {
-			continue;
-		}
-		for (int j=0; j<infile[i].getFieldCount(); j++) {
-			HTp token = infile.token(i, j);
-			if (token->isNull()) {
-				// Don't mess with null interpretations
-				continue;
-			}
-			if (!isValid(token)) {
-				continue;
-			}
-			if (hre.search(token, isearch, m_grepoptions)) {
-				string text = token->getText().substr(1);
-				hre.replaceDestructive(text, m_replace, m_search, m_grepoptions);
-				hre.replaceDestructive(text, "", "^=+");
-				text = "=" + text;
-				token->setText(text);
-				m_modified = true;
+		for (int j=0; j<(int)m_expressions.size(); j++) {
+			if (processLine(infile, i, m_expressions[j])) {
+				infile[i].createLineFromTokens();
+				modified = true;
 			}
 		}
 	}
+	if (modified) {
+		infile.createLinesFromTokens();
+	}
 }
 
 
 
 //////////////////////////////
 //
-// Tool_shed::searchAndReplaceInterpretation --
+// Tool_shed::processLine -- Apply an expression to a single line, with
+//     the record types processed in the same order as processExpression().
+//     Returns true if the line was changed.
 //
 
-void Tool_shed::searchAndReplaceInterpretation(HumdrumFile& infile) {
-	string isearch;
-	if (m_search[0] == '^') {
-		isearch = "^\\*" + m_search.substr(1);
-	} else {
-		isearch = "^\\*.*" + m_search;
+bool Tool_shed::processLine(HumdrumFile& infile, int index, ShedExpression& expression) {
+	if (expression.search == "") {
+		// nothing to do
+		return false;
 	}
-	HumRegex hre;
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (!infile[i].isInterpretation()) {
-			continue;
-		} else if (infile[i].isExclusiveInterpretation()) {
-			continue;
-		} else if (infile[i].isManipulator()) {
-			continue;
-		}
-		for (int j=0; j<infile[i].getFieldCount(); j++) {
-			HTp token = infile.token(i, j);
-			if (token->isNull()) {
-				// Don't mess with null interpretations
-				continue;
-			}
-			if (!isValid(token)) {
-				continue;
-			}
-			if (hre.search(token, isearch, m_grepoptions)) {
-				string text = token->getText().substr(1);
-				hre.replaceDestructive(text, m_replace, m_search, m_grepoptions);
-				hre.replaceDestructive(text, "", "^\\*+");
-				text = "*" + text;
-				token->setText(text);
-				m_modified = true;
-			}
-		}
+	bool modified = false;
+	if (expression.interpretation) {
+		modified |= searchAndReplaceInterpretation(infile, index, expression);
+	}
+	if (expression.localcomment) {
+		modified |= searchAndReplaceLocalComment(infile, index, expression);
+	}
+	if (expression.globalcomment) {
+		modified |= searchAndReplaceGlobalComment(infile, index, expression);
+	}
+	if (expression.reference) {
+		modified |= searchAndReplaceReferenceRecords(infile, index, expression);
+	}
+	if (expression.referencekey) {
+		modified |= searchAndReplaceReferenceKeys(infile, index, expression);
+	}
+	if (expression.referencevalue) {
+		modified |= searchAndReplaceReferenceValues(infile, index, expression);
 	}
+	if (expression.exinterp) {
+		modified |= searchAndReplaceExinterp(infile, index, expression);
+	}
+	if (expression.barline) {
+		modified |= searchAndReplaceBarline(infile, index, expression);
+	}
+	if (expression.data) {
+		modified |= searchAndReplaceData(infile, index, expression);
+	}
+	return modified;
 }
 
 
 
 //////////////////////////////
 //
-// Tool_shed::searchAndReplaceLocalComment --
+// Tool_shed::searchAndReplaceBarline -- Returns true if the line was changed.
 //
 
-void Tool_shed::searchAndReplaceLocalComment(HumdrumFile& infile) {
-	string isearch;
-	if (m_search[0] == '^') {
-		isearch = "^!" + m_search.substr(1);
-	} else {
-		isearch = "^!.*" + m_search;
+bool Tool_shed::searchAndReplaceBarline(HumdrumFile& infile, int index,
+		ShedExpression& expression) {
+	static const regex leading("^=+");
+	if (!infile[index].isBarline()) {
+		return false;
 	}
-	HumRegex hre;
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (!infile[i].isLocalComment()) {
+	bool modified = false;
+	for (int j=0; j<infile[index].getFieldCount(); j++) {
+		HTp token = infile.token(index, j);
+		if (token->isNull()) {
+			// Don't mess with null interpretations
 			continue;
 		}
-		for (int j=0; j<infile[i].getFieldCount(); j++) {
-			HTp token = infile.token(i, j);
-			if (token->isNull()) {
-				// Don't mess with null interpretations
-				continue;
-			}
-			if (!isValid(token)) {
-				continue;
-			}
-			if (hre.search(token, isearch, m_grepoptions)) {
-				string text = token->getText().substr(1);
-				hre.replaceDestructive(text, m_replace, m_search, m_grepoptions);
-				hre.replaceDestructive(text, "", "^!+");
-				text = "!" + text;
-				token->setText(text);
-				m_modified = true;
-			}
+		if (!isValid(token, expression)) {
+			continue;
+		}
+		if (regex_search(*token, expression.barlineRegex)) {
+			string text = token->getText().substr(1);
+			text = regex_replace(text, expression.searchRegex, expression.replace,
+					expression.replaceFlags);
+			text = regex_replace(text, leading, "", std::regex_constants::format_first_only);
+			text = "=" + text;
+			token->setText(text);
+			modified = true;
 		}
 	}
+	return modified;
 }
 
 
 
 //////////////////////////////
 //
-// Tool_shed::searchAndReplaceGlobalComment --
+// Tool_shed::searchAndReplaceInterpretation -- Returns true if the line
+//     was changed.
 //
 
-void Tool_shed::searchAndReplaceGlobalComment(HumdrumFile& infile) {
-	string isearch;
-	if (m_search[0] == '^') {
-		isearch = "^!!" + m_search.substr(1);
-	} else {
-		isearch = "^!!.*" + m_search;
+bool Tool_shed::searchAndReplaceInterpretation(HumdrumFile& infile, int index,
+		ShedExpression& expression) {
+	static const regex leading("^\\*+");
+	if (!infile[index].isInterpretation()) {
+		return false;
+	} else if (infile[index].isExclusiveInterpretation()) {
+		return false;
+	} else if (infile[index].isManipulator()) {
+		return false;
 	}
-	HumRegex hre;
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (!infile[i].isGlobalComment()) {
+	bool modified = false;
+	for (int j=0; j<infile[index].getFieldCount(); j++) {
+		HTp token = infile.token(index, j);
+		if (token->isNull()) {
+			// Don't mess with null interpretations
 			continue;
 		}
-		HTp token = infile.token(i, 0);
-		if (token->size() < 3) {
-			// Don't mess with null comments
+		if (!isValid(token, expression)) {
 			continue;
 		}
-		if (hre.search(token, isearch, m_grepoptions)) {
-			string text = token->getText().substr(2);
-			hre.replaceDestructive(text, m_replace, m_search, m_grepoptions);
-			hre.replaceDestructive(text, "", "^!+");
-			text = "!!" + text;
+		if (regex_search(*token, expression.interpretationRegex)) {
+			string text = token->getText().substr(1);
+			text = regex_replace(text, expression.searchRegex, expression.replace,
+					expression.replaceFlags);
+			text = regex_replace(text, leading, "", std::regex_constants::format_first_only);
+			text = "*" + text;
 			token->setText(text);
-			m_modified = true;
+			modified = true;
 		}
 	}
+	return modified;
 }
 
 
 
 //////////////////////////////
 //
-// Tool_shed::searchAndReplaceReferenceRecords --
+// Tool_shed::searchAndReplaceLocalComment -- Returns true if the line
+//     was changed.
 //
 
-void Tool_shed::searchAndReplaceReferenceRecords(HumdrumFile& infile) {
-	string isearch;
-	if (m_search[0] == '^') {
-		isearch = "^!!!" + m_search.substr(1);
-	} else {
-		isearch = "^!!!.*" + m_search;
+bool Tool_shed::searchAndReplaceLocalComment(HumdrumFile& infile, int index,
+		ShedExpression& expression) {
+	static const regex leading("^!+");
+	if (!infile[index].isLocalComment()) {
+		return false;
 	}
-	HumRegex hre;
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (!infile[i].isGlobalReference()) {
+	bool modified = false;
+	for (int j=0; j<infile[index].getFieldCount(); j++) {
+		HTp token = infile.token(index, j);
+		if (token->isNull()) {
+			// Don't mess with null interpretations
 			continue;
 		}
-		HTp token = infile.token(i, 0);
-		if (hre.search(token, isearch, m_grepoptions)) {
+		if (!isValid(token, expression)) {
+			continue;
+		}
+		if (regex_search(*token, expression.localCommentRegex)) {
 			string text = token->getText().substr(1);
-			hre.replaceDestructive(text, m_replace, m_search, m_grepoptions);
-			hre.replaceDestructive(text, "", "^!+");
-			text = "!!!" + text;
+			text = regex_replace(text, expression.searchRegex, expression.replace,
+					expression.replaceFlags);
+			text = regex_replace(text, leading, "", std::regex_constants::format_first_only);
+			text = "!" + text;
 			token->setText(text);
-			m_modified = true;
+			modified = true;
 		}
 	}
+	return modified;
 }
 
 
 
 //////////////////////////////
 //
-// Tool_shed::searchAndReplaceReferenceKeys --
+// Tool_shed::searchAndReplaceGlobalComment -- Returns true if the line
+//     was changed.
 //
 
-void Tool_shed::searchAndReplaceReferenceKeys(HumdrumFile& infile) {
-	string isearch = m_search;
-	HumRegex hre;
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (!infile[i].isGlobalReference()) {
-			continue;
-		}
-		HTp token = infile.token(i, 0);
-		string key = infile[i].getReferenceKey();
-		if (hre.search(key, isearch, m_grepoptions)) {
-			hre.replaceDestructive(key, m_replace, m_search, m_grepoptions);
-			hre.replaceDestructive(key, "", "^!+");
-			hre.replaceDestructive(key, "", ":+$");
-			string value = infile[i].getReferenceValue();
-			string text = "!!!" + key + ": " + value;
-			token->setText(text);
-			m_modified = true;
-		}
+bool Tool_shed::searchAndReplaceGlobalComment(HumdrumFile& infile, int index,
+		ShedExpression& expression) {
+	static const regex leading("^!+");
+	if (!infile[index].isGlobalComment()) {
+		return false;
 	}
+	HTp token = infile.token(index, 0);
+	if (token->size() < 3) {
+		// Don't mess with null comments
+		return false;
+	}
+	if (!regex_search(*token, expression.globalCommentRegex)) {
+		return false;
+	}
+	string text = token->getText().substr(2);
+	text = regex_replace(text, expression.searchRegex, expression.replace,
+			expression.replaceFlags);
+	text = regex_replace(text, leading, "", std::regex_constants::format_first_only);
+	text = "!!" + text;
+	token->setText(text);
+	return true;
 }
 
 
 
 //////////////////////////////
 //
-// Tool_shed::searchAndReplaceReferenceValues --
+// Tool_shed::searchAndReplaceReferenceRecords -- Returns true if the line
+//     was changed.
 //
 
-void Tool_shed::searchAndReplaceReferenceValues(HumdrumFile& infile) {
-	string isearch = m_search;
-	HumRegex hre;
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (!infile[i].isGlobalReference()) {
-			continue;
-		}
-		HTp token = infile.token(i, 0);
-		string value = infile[i].getReferenceValue();
-		if (hre.search(value, isearch, m_grepoptions)) {
-			hre.replaceDestructive(value, m_replace, m_search, m_grepoptions);
-			hre.replaceDestructive(value, "", "^!+");
-			hre.replaceDestructive(value, "", ":+$");
-			string key = infile[i].getReferenceKey();
-			string text = "!!!" + key + ": " + value;
-			token->setText(text);
-			m_modified = true;
-		}
+bool Tool_shed::searchAndReplaceReferenceRecords(HumdrumFile& infile, int index,
+		ShedExpression& expression) {
+	static const regex leading("^!+");
+	if (!infile[index].isGlobalReference()) {
+		return false;
 	}
+	HTp token = infile.token(index, 0);
+	if (!regex_search(*token, expression.referenceRegex)) {
+		return false;
+	}
+	string text = token->getText().substr(1);
+	text = regex_replace(text, expression.searchRegex, expression.replace,
+			expression.replaceFlags);
+	text = regex_replace(text, leading, "", std::regex_constants::format_first_only);
+	text = "!!!" + text;
+	token->setText(text);
+	return true;
 }
 
 
 
 //////////////////////////////
 //
-// Tool_shed::searchAndReplaceExinterp --
+// Tool_shed::searchAndReplaceReferenceKeys -- Returns true if the line
+//     was changed.
 //
 
-void Tool_shed::searchAndReplaceExinterp(HumdrumFile& infile) {
-	string isearch;
-	if (m_search[0] == '^') {
-		isearch = "^\\*\\*" + m_search.substr(1);
-	} else {
-		isearch = "^\\*\\*.*" + m_search;
+bool Tool_shed::searchAndReplaceReferenceKeys(HumdrumFile& infile, int index,
+		ShedExpression& expression) {
+	static const regex leading("^!+");
+	static const regex trailing(":+$");
+	if (!infile[index].isGlobalReference()) {
+		return false;
 	}
-	HumRegex hre;
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (!infile[i].isInterpretation()) {
+	HTp token = infile.token(index, 0);
+	string key = infile[index].getReferenceKey();
+	if (!regex_search(key, expression.searchRegex)) {
+		return false;
+	}
+	key = regex_replace(key, expression.searchRegex, expression.replace,
+			expression.replaceFlags);
+	key = regex_replace(key, leading, "", std::regex_constants::format_first_only);
+	key = regex_replace(key, trailing, "", std::regex_constants::format_first_only);
+	string value = infile[index].getReferenceValue();
+	string text = "!!!" + key + ": " + value;
+	token->setText(text);
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// Tool_shed::searchAndReplaceReferenceValues -- Returns true if the line
+//     was changed.
+//
+
+bool Tool_shed::searchAndReplaceReferenceValues(HumdrumFile& infile, int index,
+		ShedExpression& expression) {
+	static const regex leading("^!+");
+	static const regex trailing(":+$");
+	if (!infile[index].isGlobalReference()) {
+		return false;
+	}
+	HTp token = infile.token(index, 0);
+	string value = infile[index].getReferenceValue();
+	if (!regex_search(value, expression.searchRegex)) {
+		return false;
+	}
+	value = regex_replace(value, expression.searchRegex, expression.replace,
+			expression.replaceFlags);
+	value = regex_replace(value, leading, "", std::regex_constants::format_first_only);
+	value = regex_replace(value, trailing, "", std::regex_constants::format_first_only);
+	string key = infile[index].getReferenceKey();
+	string text = "!!!" + key + ": " + value;
+	token->setText(text);
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// Tool_shed::searchAndReplaceExinterp -- Returns true if the line was
+//     changed.
+//
+
+bool Tool_shed::searchAndReplaceExinterp(HumdrumFile& infile, int index,
+		ShedExpression& expression) {
+	static const regex leading("^\\*+");
+	if (!infile[index].isInterpretation()) {
+		return false;
+	} else if (!infile[index].isExclusiveInterpretation()) {
+		// assuming a single line for all exclusive interpretations
+		return false;
+	}
+	bool modified = false;
+	for (int j=0; j<infile[index].getFieldCount(); j++) {
+		HTp token = infile.token(index, j);
+		if (token->isNull()) {
+			// Don't mess with null interpretations
 			continue;
-		} else if (!infile[i].isExclusiveInterpretation()) {
-			// assuming a single line for all exclusive interpretations
+		}
+		if (!isValid(token, expression)) {
 			continue;
 		}
-		for (int j=0; j<infile[i].getFieldCount(); j++) {
-			HTp token = infile.token(i, j);
-			if (token->isNull()) {
-				// Don't mess with null interpretations
-				continue;
-			}
-			if (!isValid(token)) {
-				continue;
-			}
-			if (hre.search(token, isearch, m_grepoptions)) {
-				string text = token->getText().substr(2);
-				hre.replaceDestructive(text, m_replace, m_search, m_grepoptions);
-				hre.replaceDestructive(text, "", "^\\*+");
-				text = "**" + text;
-				token->setText(text);
-				m_modified = true;
-			}
+		if (regex_search(*token, expression.exinterpRegex)) {
+			string text = token->getText().substr(2);
+			text = regex_replace(text, expression.searchRegex, expression.replace,
+					expression.replaceFlags);
+			text = regex_replace(text, leading, "", std::regex_constants::format_first_only);
+			text = "**" + text;
+			token->setText(text);
+			modified = true;
 		}
 	}
+	return modified;
 }
 
 
 
 //////////////////////////////
 //
-// Tool_shed::searchAndReplaceData --
+// Tool_shed::searchAndReplaceData -- Returns true if the line was changed.
 //
 
-void Tool_shed::searchAndReplaceData(HumdrumFile& infile) {
-	string dsearch = m_search;
-
-	HumRegex hre;
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (!infile[i].isData()) {
+bool Tool_shed::searchAndReplaceData(HumdrumFile& infile, int index,
+		ShedExpression& expression) {
+	if (!infile[index].isData()) {
+		return false;
+	}
+	bool modified = false;
+	for (int j=0; j<infile[index].getFieldCount(); j++) {
+		HTp token = infile.token(index, j);
+		if (token->isNull()) {
+			// Don't mess with null interpretations
 			continue;
 		}
-		for (int j=0; j<infile[i].getFieldCount(); j++) {
-			HTp token = infile.token(i, j);
-			if (token->isNull()) {
-				// Don't mess with null interpretations
-				continue;
-			}
-			if (!isValid(token)) {
-				continue;
-			}
-			if (hre.search(token, dsearch, m_grepoptions)) {
-				string text = token->getText();
-				hre.replaceDestructive(text, m_replace, dsearch, m_grepoptions);
-				if (text == "") {
-					text = ".";
-				}
-				token->setText(text);
-				m_modified = true;
+		if (!isValid(token, expression)) {
+			continue;
+		}
+		if (regex_search(*token, expression.searchRegex)) {
+			string text = token->getText();
+			text = regex_replace(text, expression.searchRegex, expression.replace,
+					expression.replaceFlags);
+			if (text == "") {
+				text = ".";
 			}
+			token->setText(text);
+			modified = true;
 		}
 	}
+	return modified;
 }
 
 
@@ -770,13 +970,13 @@ void Tool_shed::searchAndReplaceData(HumdrumFile& infile) {
 // Tool_shed::isValidDataType -- usar with -x and -k options.
 //
 
-bool Tool_shed::isValidDataType(HTp token) {
-	if (m_exinterps.empty()) {
+bool Tool_shed::isValidDataType(HTp token, ShedExpression& expression) {
+	if (expression.exinterps.empty()) {
 		return true;
 	}
-	string datatype = token->getDataType();
-	for (int i=0; i<(int)m_exinterps.size(); i++) {
-		if (datatype == m_exinterps[i]) {
+	const string& datatype = token->getDataType();
+	for (int i=0; i<(int)expression.exinterps.size(); i++) {
+		if (datatype == expression.exinterps[i]) {
 			return true;
 		}
 	}
@@ -805,14 +1005,13 @@ bool Tool_shed::isValidSpine(HTp token) {
 // Tool_shed::isValid --
 //
 
-bool Tool_shed::isValid(HTp token) {
+bool Tool_shed::isValid(HTp token, ShedExpression& expression) {
 	if (!m_exclusion.empty()) {
-		HumRegex hre;
-		if (hre.search(token, m_exclusion)) {
+		if (regex_search(*token, m_exclusionRegex)) {
 			return false;
 		}
 	}
-	if (isValidDataType(token) && isValidSpine(token)) {
+	if (isValidDataType(token, expression) && isValidSpine(token)) {
 		return true;
 	}
 	return false;
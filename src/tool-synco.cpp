@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Sat Apr 30 10:42:45 PDT 2022
-// Last Modified: Wed May  4 01:03:46 PDT 2022
+// Last Modified: Sun Oct 18 22:31:07 PDT 2026
 // Filename:      tool-synco.cpp
 // URL:           https://github.com/craigsapp/humlib/blob/master/src/tool-synco.cpp
 // Syntax:        C++11; humlib
@@ -215,17 +215,8 @@ bool Tool_synco::isSyncopated(HTp token) {
 //
 
 double Tool_synco::getMetricLevel(HTp token) {
-	HumNum durbar = token->getDurationFromBarline();
-	if (!durbar.isInteger()) {
-		return -1.0;
-	}
-	if (durbar.getNumerator() % 4 == 0) {
-		return 2.0;
-	}
-	if (durbar.getNumerator() % 2 == 0) {
-		return 1.0;
-	}
-	return 0.0;
+	HumdrumFile& infile = *token->getOwner()->getOwner();
+	return infile.getMetricPosition(token->getLineIndex()).weight;
 }
 
 
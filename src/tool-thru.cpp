@@ -38,6 +38,18 @@ Tool_thru::Tool_thru(void) {
 }
 
 
+//////////////////////////////
+//
+// Tool_thru::isReusable -- Instances can be run on several files.
+//     The tool keeps no data between files.
+//
+
+bool Tool_thru::isReusable(void) {
+	return true;
+}
+
+
+
 /////////////////////////////////
 //
 // Tool_thru::run -- Do the main work of the tool.
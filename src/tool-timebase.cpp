@@ -38,6 +38,18 @@ Tool_timebase::Tool_timebase(void) {
 
 
 
+//////////////////////////////
+//
+// Tool_timebase::isReusable -- Instances can be run on several files.
+//     Options are read again for each file, and no other data is kept.
+//
+
+bool Tool_timebase::isReusable(void) {
+	return true;
+}
+
+
+
 ///////////////////////////////
 //
 // Tool_timebase::run -- Primary interfaces to the tool.
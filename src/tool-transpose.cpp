@@ -11,6 +11,7 @@
 // Last Modified: Mon Dec  5 23:28:50 PST 2016 Ported to humlib from humextras
 // Last Modified: Wed May 16 22:47:11 PDT 2018 Added **mxhm transposition
 // Last Modified: Thu Jun 14 15:30:53 PDT 2018 Added rest position transposition
+// Last Modified: Sun Oct 18 15:02:44 PDT 2026 Incremental sliding-window key analysis
 // Filename:      tool-transpose.cpp
 // URL:           https://github.com/craigsapp/humlib/blob/master/src/tool-transpose.cpp
 // Syntax:        C++11; humlib; humlib
@@ -21,6 +22,7 @@
 
 #include "tool-transpose.h"
 #include "Convert.h"
+#include "HumKeyWindow.h"
 #include "HumRegex.h"
 
 #include <cstring>
@@ -68,6 +70,18 @@ Tool_transpose::Tool_transpose(void) {
 
 
 
+//////////////////////////////
+//
+// Tool_transpose::isReusable -- Instances can be run on several files.
+//     Transposition settings are recalculated for each file.
+//
+
+bool Tool_transpose::isReusable(void) {
+	return true;
+}
+
+
+
 /////////////////////////////////
 //
 // Tool_transpose::run -- Do the main work of the tool.
@@ -1076,9 +1090,7 @@ void Tool_transpose::doAutoTransposeAnalysis(HumdrumFile& infile) {
 	int i;
 	for (i=0; i<(int)tracks.size(); i++) {
 		if (tracks[i]->isKern()) {
-			ktracks[i] = tracks[i]->getTrack();
-		} else {
-			ktracks[i] = 0;
+			ktracks[tracks[i]->getTrack()] = tracks[i]->getTrack();
 		}
 	}
 
@@ -1147,8 +1159,8 @@ void Tool_transpose::doTranspositionAnalysis(vector<vector<vector<double> > >& a
 	int value;
 
 	for (i=0; i<1; i++) {
-		for (j=2; j<3; j++) {
-			for (k=0; k<(int)analysis[i].size(); k++) {
+		for (j=2; (j<3) && (j<(int)analysis.size()); j++) {
+			for (k=0; (k<(int)analysis[i].size()) && (k<(int)analysis[j].size()); k++) {
 				if (analysis[i][k][24] >= 0 && analysis[j][k][24] >= 0) {
 					value1 = (int)analysis[i][k][25];
 	 				if (value1 >= 12) {
@@ -1186,6 +1198,10 @@ void Tool_transpose::printRawTrackAnalysis(vector<vector<vector<double> > >& ana
 	int value;
 	int value2;
 
+	if (analysis.empty()) {
+		return;
+	}
+
 	for (i=0; i<(int)analysis[0].size(); i++) {
 		m_free_text << "Frame\t" << i << ":";
 		for (j=0; j<(int)analysis.size(); j++) {
@@ -1218,10 +1234,6 @@ void Tool_transpose::doAutoKeyAnalysis(vector<vector<vector<double> > >& analysi
 		int hop, int count, int segments, vector<int>& ktracks,
 		vector<vector<vector<double> > >& trackhist) {
 
-	vector<double> majorweights;
-	vector<double> minorweights;
-	fillWeightsWithKostkaPayne(majorweights, minorweights);
-
 	int size = 0;
 	int i;
 	for (i=1; i<(int)ktracks.size(); i++) {
@@ -1235,13 +1247,16 @@ void Tool_transpose::doAutoKeyAnalysis(vector<vector<vector<double> > >& analysi
 		analysis[i].reserve(count);
 	}
 
+	// Kostka-Payne weights are used by default:
+	HumKeyWindow keywindow;
+
 	int aindex = 0;
 	for (i=1; i<(int)ktracks.size(); i++) {
 		if (!ktracks[i]) {
 			continue;
 		}
 		doTrackKeyAnalysis(analysis[aindex++], level, hop, count,
-				trackhist[i], majorweights, minorweights);
+				trackhist[i], keywindow);
 	}
 }
 
@@ -1250,85 +1265,27 @@ void Tool_transpose::doAutoKeyAnalysis(vector<vector<vector<double> > >& analysi
 //////////////////////////////
 //
 // Tool_transpose::doTrackKeyAnalysis -- Do individual key analyses of sections of the
-//   given track.
+//   given track.  The key window slides over the track's segment histograms, so
+//   only the segments entering and leaving the window are processed for each hop.
 //
 
 void Tool_transpose::doTrackKeyAnalysis(vector<vector<double> >& analysis, int level, int hop,
-		int count, vector<vector<double> >& trackhist,
-		vector<double>& majorweights, vector<double>& minorweights) {
+		int count, vector<vector<double> >& trackhist, HumKeyWindow& keywindow) {
 
+	keywindow.clear();
 	int i;
 	for (i=0; i<count; i++) {
 		if (i * hop + level > (int)trackhist.size()) {
 			break;
 		}
 		analysis.resize(i+1);
-		doSingleAnalysis(analysis[analysis.size()-1], i*hop+level, level,
-				trackhist, majorweights, minorweights);
+		keywindow.setWindow(trackhist, i*hop, level);
+		identifyKey(analysis[analysis.size()-1], keywindow);
 	}
 }
 
 
 
-//////////////////////////////
-//
-// Tool_transpose::doSingleAnalysis --
-//
-
-void Tool_transpose::doSingleAnalysis(vector<double>& analysis, int startindex, int length,
-		vector<vector<double> >& trackhist, vector<double>& majorweights,
-		vector<double>& minorweights) {
-	vector<double> histsum(12, 0);
-
-	for (int i=0; (i<length) && (startindex+i+length<(int)trackhist.size()); i++) {
-		for (int k=0; k<12; k++) {
-			histsum[k] += trackhist[i+startindex][k];
-		}
-	}
-
-	identifyKey(analysis, histsum, majorweights, minorweights);
-}
-
-
-
-///////////////////////////////
-//
-// Tool_transpose::fillWeightsWithKostkaPayne --
-//
-
-void Tool_transpose::fillWeightsWithKostkaPayne(vector<double>& maj, vector<double>& min) {
-	maj.resize(12);
-	min.resize(12);
-
-	// found in David Temperley: Music and Probability 2006
-	maj[0]  = 0.748;	// C major weights
-	maj[1]  = 0.060;	// C#
-	maj[2]  = 0.488;	// D
-	maj[3]  = 0.082;	// D#
-	maj[4]  = 0.670;	// E
-	maj[5]  = 0.460;	// F
-	maj[6]  = 0.096;	// F#
-	maj[7]  = 0.715;	// G
-	maj[8]  = 0.104;	// G#
-	maj[9]  = 0.366;	// A
-	maj[10] = 0.057;	// A#
-	maj[11] = 0.400;	// B
-	min[0]  = 0.712;	// c minor weights
-	min[1]  = 0.084;	// c#
-	min[2]  = 0.474;	// d
-	min[3]  = 0.618;	// d#
-	min[4]  = 0.049;	// e
-	min[5]  = 0.460;	// f
-	min[6]  = 0.105;	// f#
-	min[7]  = 0.747;	// g
-	min[8]  = 0.404;	// g#
-	min[9]  = 0.067;	// a
-	min[10] = 0.133;	// a#
-	min[11] = 0.330;	// b
-}
-
-
-
 ////////////////////////////////////////
 //
 // identifyKey -- correls contains the 12 major key correlation
@@ -1338,18 +1295,12 @@ void Tool_transpose::fillWeightsWithKostkaPayne(vector<double>& maj, vector<doub
 //      all entries in the original histogram were zero (all rests).
 //
 
-void Tool_transpose::identifyKey(vector<double>& correls,
-		vector<double>& histogram, vector<double>& majorweights,
-		vector<double>& minorweights) {
+void Tool_transpose::identifyKey(vector<double>& correls, HumKeyWindow& keywindow) {
 
 	correls.clear();
 	correls.reserve(26);
 
-	double testsum = 0.0;
-	for (int i=0; i<12; i++) {
-		testsum += histogram[i];
-	}
-	if (testsum == 0.0) {
+	if (keywindow.isEmpty()) {
 		correls.resize(26);
 		fill(correls.begin(), correls.end(), -1);
 		correls[24] = -1;
@@ -1357,12 +1308,10 @@ void Tool_transpose::identifyKey(vector<double>& correls,
 		return;
 	}
 
-	vector<double> majorcorrels;
-	vector<double> minorcorrels;
-	for (int i=0; i<12; i++) {
-		majorcorrels[i] = Convert::pearsonCorrelation(majorweights, histogram);
-		minorcorrels[i] = Convert::pearsonCorrelation(minorweights, histogram);
-	}
+	vector<double> allcorrels;
+	keywindow.getCorrelations(allcorrels);
+	vector<double> majorcorrels(allcorrels.begin(), allcorrels.begin() + 12);
+	vector<double> minorcorrels(allcorrels.begin() + 12, allcorrels.end());
 
 	// find max value
 	int besti;
@@ -1471,7 +1420,7 @@ double Tool_transpose::storeHistogramForTrack(vector<vector<double> >& histogram
 		HumdrumFile& infile, int track, int segments) {
 
 	histogram.clear();
-	histogram.reserve(segments);
+	histogram.resize(segments);
 
 	int i;
 	int j;
@@ -1504,12 +1453,12 @@ double Tool_transpose::storeHistogramForTrack(vector<vector<double> >& histogram
 			if (!infile.token(i, j)->isKern()) {
 				continue;
 			}
-			if (!infile.token(i, j)->isNull()) {
+			if (infile.token(i, j)->isNull()) {
 				continue;
 			}
 			tokencount = infile.token(i, j)->getSubtokenCount();
 			for (k=0; k<tokencount; k++) {
-				buffer = *infile.token(j, k);
+				buffer = infile.token(i, j)->getSubtoken(k);
 				if (buffer == ".") {
 					continue;  // ignore illegal inline null tokens
 				}
@@ -2,7 +2,7 @@
 // Programmer:    Katherine Wong
 // Programmer:    Craig Stuart Sapp
 // Creation Date: Mon Mar 13 23:45:00 PDT 2023
-// Last Modified: Mon Jun 12 20:22:01 PDT 2023
+// Last Modified: Sun Oct 18 17:58:40 PDT 2026
 // Filename:      tool-tspos.cpp
 // URL:           https://github.com/craigsapp/humlib/blob/master/src/tool-tspos.cpp
 // Syntax:        C++11; humlib
@@ -54,6 +54,7 @@ Tool_tspos::Tool_tspos(void) {
 	define("t|table=b",         "add analysis table above score");
 	define("V|all-voices=b",    "require all voices in score to be sounding");
 	define("Q|no-question=b",   "do not show question mark in table header");
+	define("stats|statistics=b", "only print JSON summary of triadic positions for all inputs");
 }
 
 
@@ -103,6 +104,34 @@ bool Tool_tspos::run(HumdrumFile& infile) {
 
 
 
+//////////////////////////////
+//
+// Tool_tspos::finally -- Print the JSON summary of the triadic position
+//     counts when using --stats.
+//
+
+void Tool_tspos::finally(void) {
+	if (!m_statsQ) {
+		return;
+	}
+	m_stats.printJson(m_free_text, m_toolName);
+}
+
+
+
+//////////////////////////////
+//
+// Tool_tspos::getStatistics -- Return the counts collected with --stats.
+//     Counts from tool objects used in separate threads can be combined
+//     with HumStatistics::merge().
+//
+
+HumStatistics& Tool_tspos::getStatistics(void) {
+	return m_stats;
+}
+
+
+
 //////////////////////////////
 //
 // Tool_tspos::initialize -- Setup to do before processing a file.
@@ -133,6 +162,7 @@ void Tool_tspos::initialize(HumdrumFile& infile) {
 		m_minorQ = true;
 	}
 	m_questionQ = !getBoolean("no-question");
+	m_statsQ = getBoolean("stats");
 }
 
 
@@ -152,7 +182,9 @@ void Tool_tspos::processFile(HumdrumFile& infile) {
 	m_used_markers.resize(7);
 	fill(m_used_markers.begin(), m_used_markers.end(), 0);
 
-	avoidRdfCollisions(infile);
+	if (!m_statsQ) {
+		avoidRdfCollisions(infile);
+	}
 	analyzeVoiceCount(infile);
 
 	m_partTriadPositions.resize(infile.getMaxTrack() + 1);
@@ -169,6 +201,7 @@ void Tool_tspos::processFile(HumdrumFile& infile) {
 	vector<int> chordPositions;
 	vector<int> thirdPositions;
 	vector<int> fifthPositions;
+	HumSonority sonority;
 
 	for (int i=0; i<infile.getLineCount(); i++) {
 		if (!infile[i].isData()) { // if no notes in the line
@@ -217,9 +250,14 @@ void Tool_tspos::processFile(HumdrumFile& infile) {
 			}
 		}
 		midiNotes = getMidiNotes(kernNotes);
+		sonority.clear();
+		for (int k=0; k<(int)midiNotes.size(); k++) {
+			sonority.addMidi(midiNotes[k]);
+		}
+		int pcmask = sonority.getPitchClassMask();
 
 		if (m_colorThirds) { // thirds
-			thirdPositions = getThirds(midiNotes);
+			thirdPositions = getThirds(midiNotes, pcmask);
 			checkForTriadicSonority(thirdPositions, i);
 
 			if (m_doubleQ) { // label only doubles if prompted
@@ -230,7 +268,7 @@ void Tool_tspos::processFile(HumdrumFile& infile) {
 		}
 
 		if (m_colorFifths) { // fifths
-			fifthPositions = getFifths(midiNotes);
+			fifthPositions = getFifths(midiNotes, pcmask);
 			checkForTriadicSonority(fifthPositions, i);
 
 			if (m_doubleQ) { // label only doubles if prompted
@@ -241,7 +279,7 @@ void Tool_tspos::processFile(HumdrumFile& infile) {
 		}
 
 		if (m_colorTriads) { // triads
-		  	chordPositions = getChordPositions(midiNotes);
+		  	chordPositions = getChordPositions(midiNotes, pcmask);
 			checkForTriadicSonority(chordPositions, i);
 			if (m_doubleQ) { // label only doubles if prompted
 				keepOnlyDoubles(chordPositions);
@@ -250,6 +288,11 @@ void Tool_tspos::processFile(HumdrumFile& infile) {
 		}
 	}
 
+	if (m_statsQ) {
+		addStatistics(infile);
+		return;
+	}
+
 	infile.createLinesFromTokens();
 
 	m_humdrum_text << infile;
@@ -344,43 +387,14 @@ void Tool_tspos::printUsedMarkers(void) {
 //
 
 bool Tool_tspos::hasFullTriadAttack(HumdrumLine& line) {
-	vector<int> midiPitches = line.getMidiPitchesSortLH();
-	vector<int> positive(24, 0);
-	int count = 0;
+	vector<int> midiPitches = line.getMidiPitches();
+	HumSonority sonority;
 	for (int i=0; i<(int)midiPitches.size(); i++) {
 		if (midiPitches[i] > 0) {
-			if (!positive[midiPitches[i] % 12]) {
-				positive[midiPitches[i] % 12]++;
-				positive[midiPitches[i] % 12 + 12]++;
-				count++;
-			}
+			sonority.addMidi(midiPitches[i]);
 		}
 	}
-
-	if (count != 3) {
-		return false;
-	}
-
-	for (int i=0; i<12; i++) {
-		if (!positive[i]) {
-			continue;
-		}
-		if (positive[i+3]) {
-			if (positive[i+3+3]) { // diminished triad pitch-classes present
-				return true;
-			} else if (positive[i+3+4]) { // minor
-				return true;
-			}
-		} else if (positive[i+4]) {
-			if (positive[i+4+3]) { // major
-				return true;
-			} else if (positive[i+4+4]) { // augmented
-				return true;
-			}
-		}
-	}
-
-	return false;
+	return HumSonority::isTriad(sonority.getType());
 }
 
 
@@ -462,22 +476,7 @@ string Tool_tspos::generateStatistics(HumdrumFile& infile) {
 	int sonorityCount = 0;  // total number of sonorities
 	int triadCount = 0;     // sonorities that are triads
 	HumNum triadDuration = 0;
-	for (int i=0; i<infile.getLineCount(); i++) {
-		if (!infile[i].isData()) {
-			continue;
-		}
-		if (m_triadState.at(i)) {
-			triadDuration += infile[i].getDuration();
-		}
-		int attacks = infile[i].getKernNoteAttacks();
-		if (attacks == 0) {
-			continue;
-		}
-		sonorityCount++;
-		if (m_triadState.at(i)) {
-			triadCount++;
-		}
-	}
+	countSonorities(infile, sonorityCount, triadCount, triadDuration);
 
 	string toolPrefix = "!!!TOOL-";
 	if (m_toolCount > 0) {
@@ -556,6 +555,90 @@ string Tool_tspos::generateStatistics(HumdrumFile& infile) {
 
 
 
+//////////////////////////////
+//
+// Tool_tspos::countSonorities -- Count the sonorities with note attacks,
+//     the triadic sonorities among them, and the duration of the triadic
+//     sonorities.
+//
+
+void Tool_tspos::countSonorities(HumdrumFile& infile, int& sonorityCount,
+		int& triadCount, HumNum& triadDuration) {
+	sonorityCount = 0;
+	triadCount = 0;
+	triadDuration = 0;
+	for (int i=0; i<infile.getLineCount(); i++) {
+		if (!infile[i].isData()) {
+			continue;
+		}
+		if (m_triadState.at(i)) {
+			triadDuration += infile[i].getDuration();
+		}
+		int attacks = infile[i].getKernNoteAttacks();
+		if (attacks == 0) {
+			continue;
+		}
+		sonorityCount++;
+		if (m_triadState.at(i)) {
+			triadCount++;
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// Tool_tspos::addStatistics -- Add the counts for the current file to the
+//     statistics for --stats.  The "positions" group combines the full and
+//     partial triad counts in the same way as generateStatistics(), and
+//     "top-voice" gives the same counts for the highest **kern spine.
+//
+
+void Tool_tspos::addStatistics(HumdrumFile& infile) {
+	int sonorityCount = 0;
+	int triadCount = 0;
+	HumNum triadDuration = 0;
+	countSonorities(infile, sonorityCount, triadCount, triadDuration);
+
+	m_stats.addFile();
+	m_stats.increment("summary", "sonority-count", sonorityCount);
+	m_stats.increment("summary", "sonority-duration", infile.getScoreDuration().getFloat());
+	m_stats.increment("summary", "triadic-count", triadCount);
+	m_stats.increment("summary", "triadic-duration", triadDuration.getFloat());
+
+	vector<string> categories = {
+		"triad-root", "triad-third", "triad-fifth",
+		"third-root", "third-third", "fifth-root", "fifth-fifth"
+	};
+	vector<string> positions = {
+		"root", "third", "fifth", "root", "third", "root", "fifth"
+	};
+
+	int topTrack = -1;
+	vector<HTp> kernstarts;
+	infile.getKernSpineStartList(kernstarts);
+	if (!kernstarts.empty()) {
+		topTrack = kernstarts.back()->getTrack();
+	}
+
+	for (int i=1; i<(int)m_partTriadPositions.size(); i++) {
+		vector<int>& entry = m_partTriadPositions[i];
+		for (int j=0; j<(int)entry.size(); j++) {
+			if (entry[j] == 0) {
+				continue;
+			}
+			m_stats.increment("categories", categories.at(j), entry[j]);
+			m_stats.increment("positions", positions.at(j), entry[j]);
+			if (i == topTrack) {
+				m_stats.increment("top-voice", positions.at(j), entry[j]);
+			}
+		}
+	}
+}
+
+
+
 //////////////////////////////
 //
 // Tool_tspos::generateTable -- Create an HTML table that the statistics
@@ -902,7 +985,7 @@ void Tool_tspos::labelChordPositions(vector<HTp>& kernNotes, vector<int>& chordP
 				m_partTriadPositions.at(track).at(2)++;
 				break;
 		}
-		if (label.empty()) {
+		if (label.empty() || m_statsQ) {
 			continue;
 		}
 		string text = *kernNotes.at(i);
@@ -942,7 +1025,7 @@ void Tool_tspos::labelThirds(vector<HTp>& kernNotes, vector<int>& thirdPositions
 				break;
 		}
 
-		if (label.empty()) {
+		if (label.empty() || m_statsQ) {
 			continue;
 		}
 		string text = *kernNotes.at(i);
@@ -982,7 +1065,7 @@ void Tool_tspos::labelFifths(vector<HTp>& kernNotes, vector<int>& fifthPositions
 				break;
 		}
 
-		if (label.empty()) {
+		if (label.empty() || m_statsQ) {
 			continue;
 		}
 		string text = *kernNotes.at(i);
@@ -993,37 +1076,6 @@ void Tool_tspos::labelFifths(vector<HTp>& kernNotes, vector<int>& fifthPositions
 
 
 
-//////////////////////////////
-//
-// Tool_tspos::getNoteMods -- Identify if the sonority is a triad, and if so, place
-//    the position of the note in the chord:
-//       0: not in triadic sonority.
-//       1: root (such as C in C major triad)
-//       3: third (such as E in C major triad)
-//       5: fifth (such as G in C major triad)
-//
-
-vector<int> Tool_tspos::getNoteMods(vector<int>& midiNotes) {
-	// create modulo 12 arr
-	vector<int> pitchClasses(12, 0);
-	for (int i = 0; i < (int)midiNotes.size(); i++) {
-		int index = midiNotes.at(i) % 12;
-		pitchClasses.at(index)++; // add one to the pitch
-	}
-
-	vector<int> noteMods;
-
-	for (int i = 0; i < (int)pitchClasses.size(); i++) {
-		if (pitchClasses.at(i) != 0) { // not zero
-			noteMods.push_back(i); // add the index
-		}
-	}
-
-	return noteMods;
-}
-
-
-
 //////////////////////////////
 //
 // Tool_tspos::getThirds -- Identify if the sonority is a third interval, and if so,
@@ -1032,70 +1084,25 @@ vector<int> Tool_tspos::getNoteMods(vector<int>& midiNotes) {
 //       1: root (bottom of the interval)
 //       3: third (top of the interval)
 
-vector<int> Tool_tspos::getThirds(vector<int>& midiNotes) {
+vector<int> Tool_tspos::getThirds(vector<int>& midiNotes, int pcmask) {
 	vector<int> output(midiNotes.size(), 0);
 
-	if (midiNotes.empty()) {
-		return output;
-	}
-
-	vector<int> noteMods = getNoteMods(midiNotes); // we know noteMods is sorted
-	if (noteMods.size() != 2) {
-		return output;
-	}
-
-	int interval = noteMods[1] - noteMods[0];
-	int rootClass = -1; // currently uninitialized
-	int thirdClass = -1;
-
+	int type = HumSonority::getType(pcmask);
+	bool found = false;
 	if (m_majorQ && m_minorQ) {
-
-		if (interval == 3 || interval == 4) { // third is found
-			rootClass = noteMods.at(0);
-			thirdClass = noteMods.at(1);
-		}
-		else if (interval == 8 || interval == 9) { // third is found (inversion)
-			rootClass = noteMods.at(1);
-			thirdClass = noteMods.at(0);
-		}
-
-	}
-
-	else if (!m_majorQ && m_minorQ) {
-		if (interval == 3) { // minor third is found
-			rootClass = noteMods.at(0);
-			thirdClass = noteMods.at(1);
-		}
-		else if (interval == 9) { // major sixth is found (inversion)
-			rootClass = noteMods.at(1);
-			thirdClass = noteMods.at(0);
-		}
-	}
-
-	else if (m_majorQ && !m_minorQ) {
-
-		if (interval == 4) { // major third is found
-			rootClass = noteMods.at(0);
-			thirdClass = noteMods.at(1);
-		}
-		else if (interval == 8) { // minor sixth is found (inversion)
-			rootClass = noteMods.at(1);
-			thirdClass = noteMods.at(0);
-		}
-
+		found = (type == sonority_minor_third) || (type == sonority_major_third);
+	} else if (!m_majorQ && m_minorQ) {
+		found = (type == sonority_minor_third);
+	} else if (m_majorQ && !m_minorQ) {
+		found = (type == sonority_major_third);
 	}
-
-	if (rootClass == -1) { // third was not found
+	if (!found) {
 		return output;
 	}
 
 	// populate output
 	for (int i = 0; i < (int)midiNotes.size(); i++) {
-		if (midiNotes.at(i) % 12 == rootClass) {
-		output.at(i) = 1;
-		} else if (midiNotes.at(i) % 12 == thirdClass) {
-			output.at(i) = 3;
-		}
+		output.at(i) = HumSonority::getPosition(pcmask, midiNotes.at(i));
 	}
 
 	return output;
@@ -1106,49 +1113,23 @@ vector<int> Tool_tspos::getThirds(vector<int>& midiNotes) {
 //////////////////////////////
 //
 // Tool_tspos::getFifths -- Identify if the sonority is a fifth interval, and if so,
-//    place the position of the note in the output.
+//    place the position of the note in the output.  Tritones are included,
+//    with the lower pitch class as the root.
 //       0: not in the sonority
 //       1: root (bottom of the interval)
 //       5: fifth (top of the interval)
 
-vector<int> Tool_tspos::getFifths(vector<int>& midiNotes) {
+vector<int> Tool_tspos::getFifths(vector<int>& midiNotes, int pcmask) {
 	vector<int> output(midiNotes.size(), 0);
 
-	if (midiNotes.empty()) {
-		return output;
-	}
-
-	vector<int> noteMods = getNoteMods(midiNotes);
-	if (noteMods.size() != 2) {
-		return output;
-	}
-
-	int interval = noteMods.at(1) - noteMods.at(0);
-	int rootClass = -1; // currently uninitialized
-	int fifthClass = -1;
-
-	if ((interval == 7) || (interval == 6)) { // fifth found
-		rootClass = noteMods.at(0);
-		fifthClass = noteMods.at(1);
-	}
-
-	if (interval == 5) { // inverted fifth found
-		rootClass = noteMods.at(1);
-		fifthClass = noteMods.at(0);
-	}
-
-	if (rootClass == -1) { // fifth not found
+	int type = HumSonority::getType(pcmask);
+	if ((type != sonority_fifth) && (type != sonority_tritone)) {
 		return output;
 	}
 
 	// populate output
 	for (int i = 0; i < (int)midiNotes.size(); i++) {
-		if (midiNotes.at(i) % 12 == rootClass) {
-			output.at(i) = 1;
-		}
-		else if (midiNotes.at(i) % 12 == fifthClass) {
-			output.at(i) = 5;
-		}
+		output.at(i) = HumSonority::getPosition(pcmask, midiNotes.at(i));
 	}
 
 	return output;
@@ -1158,91 +1139,34 @@ vector<int> Tool_tspos::getFifths(vector<int>& midiNotes) {
 
 ///////////////////////////////
 //
-// Tool_tspos::getChordPositions --
+// Tool_tspos::getChordPositions -- Identify if the sonority is a major,
+//    minor or diminished triad, and if so, place the position of the note
+//    in the chord in the output.
+//       0: not in the triad
+//       1: root
+//       3: third
+//       5: fifth
 //
 
-vector<int> Tool_tspos::getChordPositions(vector<int>& midiNotes) {
+vector<int> Tool_tspos::getChordPositions(vector<int>& midiNotes, int pcmask) {
 	vector<int> output(midiNotes.size(), 0);
-	if (midiNotes.empty()) {
-		return output;
-	}
-
-	vector<int> noteMods = getNoteMods(midiNotes);
-
-	if (noteMods.size() != 3) { // not a triad
-		return output;
-	}
-
-	int bint = noteMods.at(1) - noteMods.at(0);
-	int tint = noteMods.at(2) - noteMods.at(1);
-
-	int rootClass = -1; // curr uninitialized
-	int thirdClass = -1;
-	int fifthClass = -1;
 
+	int type = HumSonority::getType(pcmask);
+	bool found = false;
 	if (m_majorQ && m_minorQ) {
-
-		if ((bint == 3 && tint == 4) || (bint == 4 && tint == 3) || (bint == 3 && tint == 3)) { // root pos
-			rootClass = noteMods.at(0);
-			thirdClass = noteMods.at(1);
-			fifthClass = noteMods.at(2);
-		} else if ((bint == 4 && tint == 5) || (bint == 3 && tint == 5) || (bint == 3 && tint == 6)) { // first inv
-			rootClass = noteMods.at(2);
-			thirdClass = noteMods.at(0);
-			fifthClass = noteMods.at(1);
-		} else if ((bint == 5 && tint == 3) || (bint == 5 && tint == 4) || (bint == 6 && tint == 3)) { // sec inv
-			rootClass = noteMods.at(1);
-			thirdClass = noteMods.at(2);
-			fifthClass = noteMods.at(0);
-		}
-	}
-
-	else if (!m_majorQ && m_minorQ) {
-		if (bint == 3 && tint == 4) {// minor root pos
-			rootClass = noteMods.at(0);
-			thirdClass = noteMods.at(1);
-			fifthClass = noteMods.at(2);
-		} else if (bint == 4 && tint == 5) { // minor first inv
-			rootClass = noteMods.at(2);
-			thirdClass = noteMods.at(0);
-			fifthClass = noteMods.at(1);
-		} else if (bint == 5 && tint == 3) { // minor sec inv
-			rootClass = noteMods.at(1);
-			thirdClass = noteMods.at(2);
-			fifthClass = noteMods.at(0);
-		}
-	}
-
-	else if (m_majorQ && !m_minorQ) {
-		if (bint == 4 && tint == 3) {// major root pos
-			rootClass = noteMods.at(0);
-			thirdClass = noteMods.at(1);
-			fifthClass = noteMods.at(2);
-		} else if (bint == 3 && tint == 5) { // major first inv
-			rootClass = noteMods.at(2);
-			thirdClass = noteMods.at(0);
-			fifthClass = noteMods.at(1);
-		} else if (bint == 5 && tint == 4) { // major sec inv
-			rootClass = noteMods.at(1);
-			thirdClass = noteMods.at(2);
-			fifthClass = noteMods.at(0);
-		}
+		found = (type == sonority_major) || (type == sonority_minor) ||
+				(type == sonority_diminished);
+	} else if (!m_majorQ && m_minorQ) {
+		found = (type == sonority_minor);
+	} else if (m_majorQ && !m_minorQ) {
+		found = (type == sonority_major);
 	}
-
-	if (rootClass == -1) {
+	if (!found) {
 		return output;
 	}
 
 	for (int i = 0; i < (int)midiNotes.size(); i++) {
-		if (midiNotes.at(i) % 12 == rootClass) {
-			output.at(i) = 1;
-		}
-		else if (midiNotes.at(i) % 12 == thirdClass) {
-			output.at(i) = 3;
-		}
-		else if (midiNotes.at(i) % 12 == fifthClass) {
-			output.at(i) = 5;
-		}
+		output.at(i) = HumSonority::getPosition(pcmask, midiNotes.at(i));
 	}
 
 	if (m_doubleQ) {
@@ -0,0 +1,153 @@
+// Description: Check building, writing, reading and querying a catalog
+//              of reference records, and loading entries from it.
+
+#include "humlib.h"
+
+#include <cstdio>
+#include <fstream>
+
+using namespace hum;
+
+
+//////////////////////////////
+//
+// check -- Print an error message if the value is not the expected one.
+//
+
+int check(const string& name, const string& value, const string& expected) {
+   if (value == expected) {
+      return 0;
+   }
+   cout << "ERROR: " << name << " is \"" << value << "\" instead of \""
+        << expected << "\"" << endl;
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// join -- Convert a list of entries into a string.
+//
+
+string join(const vector<int>& entries) {
+   string output;
+   for (int i=0; i<(int)entries.size(); i++) {
+      output += (i ? " " : "") + to_string(entries[i]);
+   }
+   return output;
+}
+
+
+
+int main(int argc, char** argv) {
+   string segmented =
+      "!!!!ENC: Encoder\n"
+      "!!!!SEGMENT: first.krn\n"
+      "!!!COM: Bach, Johann Sebastian\n"
+      "!!!OTL: Chorale\tone\n"
+      "**kern\t**kern\t**kern\t**kern\t**text\n"
+      "*M3/4\t*M3/4\t*M3/4\t*M3/4\t*\n"
+      "*k[f#]\t*k[f#]\t*k[f#]\t*k[f#]\t*\n"
+      "*G:\t*G:\t*G:\t*G:\t*\n"
+      "4g\t4b\t4d\t4G\tla\n"
+      "*-\t*-\t*-\t*-\t*-\n"
+      "!!!COM: Ignored trailer\n"
+      "!!!!SEGMENT: second.krn\n"
+      "!!!COM: Bach, Carl Philipp Emanuel\n"
+      "!!!YEM: 1760\n"
+      "**kern\t**kern\n"
+      "*MM120\t*MM120\n"
+      "*M4/4\t*M4/4\n"
+      "=1\t=1\n"
+      "4c\t4e\n"
+      "*-\t*-\n"
+      "!!!!SEGMENT: third.krn\n"
+      "!!!COM: Mozart\n"
+      "!!!YEM: 1785\n"
+      "**kern\n"
+      "*e-:\n"
+      "4e-\n"
+      "*-\n";
+
+   string filename = "test-catalog-input.krn";
+   std::ofstream output(filename);
+   output << segmented;
+   output.close();
+
+   HumCatalog catalog;
+   catalog.addFile(filename);
+
+   int errors = 0;
+   errors += check("count", to_string(catalog.getEntryCount()), "3");
+   errors += check("segment", catalog.getSegment(1), "second.krn");
+   errors += check("offset", to_string(catalog.getOffset(1)),
+         to_string(segmented.find("!!!!SEGMENT: second.krn")));
+   errors += check("COM", catalog.getValue(0, "COM"), "Bach, Johann Sebastian");
+   errors += check("OTL", catalog.getValue(0, "OTL"), "Chorale\tone");
+   errors += check("ENC", catalog.getValue(2, "ENC"), "Encoder");
+   errors += check("spines", catalog.getValue(0, "spines"), "5");
+   errors += check("voices", catalog.getValue(0, "voices"), "4");
+   errors += check("meter", catalog.getValue(1, "meter"), "4/4");
+   errors += check("keysig", catalog.getValue(0, "keysig"), "f#");
+   errors += check("key", catalog.getValue(0, "key"), "G");
+   errors += check("key2", catalog.getValue(2, "key"), "e-");
+   errors += check("missing", catalog.getValue(2, "OTL"), "");
+
+   errors += check("equal", join(catalog.findEqual("COM", "Mozart")), "2");
+   errors += check("prefix", join(catalog.findPrefix("COM", "Bach")), "0 1");
+   errors += check("range", join(catalog.findRange("YEM", 1700, 1770)), "1");
+   errors += check("query", join(catalog.query("COM^=Bach; voices>=2")), "0 1");
+   errors += check("query2", join(catalog.query("YEM>1760")), "2");
+   errors += check("query3", join(catalog.query("YEM<1760")), "");
+   errors += check("query4", join(catalog.query("YEM<=1760; meter=4/4")), "1");
+
+   stringstream stored;
+   catalog.printCatalog(stored);
+   HumCatalog catalog2;
+   catalog2.readCatalog(stored);
+   errors += check("read count", to_string(catalog2.getEntryCount()), "3");
+   errors += check("read OTL", catalog2.getValue(0, "OTL"), "Chorale\tone");
+   errors += check("read query", join(catalog2.query("COM^=Bach; YEM>=1700")), "1");
+
+   HumdrumFile infile;
+   catalog2.readEntry(1, infile);
+   errors += check("entry filename", infile.getFilename(), "second.krn");
+   errors += check("entry lines", to_string(infile.getLineCount()), "9");
+   errors += check("entry COM", infile.getReferenceRecord("COM"),
+         "Bach, Carl Philipp Emanuel");
+
+   remove(filename.c_str());
+
+   // Entries without a segment name stop at the next segment:
+   string unnamed =
+      "!!!!SEGMENT: first.krn\n"
+      "**kern\n"
+      "4c\n"
+      "*-\n"
+      "!!!!SEGMENT:\n"
+      "**kern\n"
+      "4d\n"
+      "4e\n"
+      "*-\n"
+      "!!!!SEGMENT: last.krn\n"
+      "**kern\n"
+      "4f\n"
+      "*-\n";
+   output.open(filename);
+   output << unnamed;
+   output.close();
+   HumCatalog catalog3;
+   catalog3.addFile(filename);
+   errors += check("unnamed count", to_string(catalog3.getEntryCount()), "3");
+   catalog3.readEntry(1, infile);
+   errors += check("unnamed entry lines", to_string(infile.getLineCount()), "5");
+
+   remove(filename.c_str());
+
+   cout << (errors ? "FAILED" : "PASSED") << endl;
+   return errors ? 1 : 0;
+}
+
+
+
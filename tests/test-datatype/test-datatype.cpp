@@ -0,0 +1,86 @@
+// Description: Check the integer data types of tracks and tokens, including
+//              after an exclusive interpretation is renamed, and the
+//              precomputed **kern field lists of HumdrumFileContent.
+
+#include "humlib.h"
+
+using namespace hum;
+
+const char* SCORE =
+   "**kern\t**text\t**kern\t**mens\n"
+   "*^\t*\t*\t*\n"
+   "4c\t4e\ta\t4g\tmc\n"
+   "*v\t*v\t*\t*\t*\n"
+   "4d\tb\t4a\tmd\n"
+   "*-\t*-\t*-\t*-\n";
+
+
+
+int main(int argc, char** argv) {
+   int errors = 0;
+   HumdrumFile infile;
+   infile.readString(SCORE);
+
+   if ((infile.getTrackDataType(1) != datatype_kern)
+         || (infile.getTrackDataType(2) != datatype_text)
+         || (infile.getTrackDataType(4) != datatype_mens)) {
+      cout << "ERROR: track data types" << endl;
+      errors++;
+   }
+   if (HumDataType::getName(HumDataType::getId("kern")) != "**kern") {
+      cout << "ERROR: registry names" << endl;
+      errors++;
+   }
+   if (HumDataType::findId("**not-registered-here") != -1) {
+      cout << "ERROR: findId registered a data type" << endl;
+      errors++;
+   }
+
+   // line 2 has a split first spine:
+   vector<int> expected = {0, 1, 3};
+   if (infile.getKernFieldIndexes(2) != expected) {
+      cout << "ERROR: kern field indexes" << endl;
+      errors++;
+   }
+   if ((infile.getFieldKernSpine(2, 1) != 0) || (infile.getFieldKernSpine(2, 3) != 1)
+         || (infile.getFieldKernSpine(2, 2) != -1)) {
+      cout << "ERROR: field to kern spine" << endl;
+      errors++;
+   }
+
+   // Renaming an exclusive interpretation changes the data type:
+   HTp start = infile.getTrackStart(3);
+   start->setText("**kern-tag");
+   if (infile.token(2, 3)->isKern() || !infile.token(2, 3)->isKernLike()
+         || !infile.token(2, 3)->isDataType("**kern-tag")
+         || (infile.getKernSpineStartList().size() != 1)
+         || (infile.getKernFieldIndexes(2).size() != 2)) {
+      cout << "ERROR: renamed exclusive interpretation" << endl;
+      errors++;
+   }
+   start->setText("**kern");
+   if (!infile.token(2, 3)->isKern() || (infile.getKernSpineStartList().size() != 2)) {
+      cout << "ERROR: restored exclusive interpretation" << endl;
+      errors++;
+   }
+   if (!infile.token(2, 4)->isMens() || !infile.token(2, 4)->isMensLike()
+         || infile.token(2, 4)->isKernLike()) {
+      cout << "ERROR: **mens data type" << endl;
+      errors++;
+   }
+
+   // Assigning text to an exclusive interpretation also changes the
+   // data type of the track:
+   *infile.getTrackStart(4) = "**text";
+   if ((infile.getTrackDataType(4) != datatype_text)
+         || (*infile.getTrackStart(4) != "**text")) {
+      cout << "ERROR: assigned exclusive interpretation" << endl;
+      errors++;
+   }
+
+   cout << (errors ? "FAILED" : "PASSED") << endl;
+   return errors ? 1 : 0;
+}
+
+
+
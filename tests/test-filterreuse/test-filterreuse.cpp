@@ -0,0 +1,69 @@
+// Description: Check that a filter tool which is reused for several
+//              files gives the same output for each file.
+
+#include "humlib.h"
+
+using namespace hum;
+
+
+//////////////////////////////
+//
+// check -- Print an error message if the value is not the expected one.
+//
+
+int check(const string& name, const string& value, const string& expected) {
+   if (value == expected) {
+      return 0;
+   }
+   cout << "ERROR: " << name << " is \"" << value << "\" instead of \""
+        << expected << "\"" << endl;
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// runFilter -- Run the filter command of the input data, and return
+//     the output.
+//
+
+string runFilter(const string& data) {
+   HumdrumFile infile;
+   infile.readString(data);
+   Tool_filter filter;
+   filter.run(infile);
+   stringstream output;
+   if (filter.hasHumdrumText()) {
+      filter.getHumdrumText(output);
+   } else {
+      output << infile;
+   }
+   return output.str();
+}
+
+
+
+int main(int argc, char** argv) {
+   string data =
+      "**kern\n"
+      "!a\n"
+      "4a\n"
+      "*-\n"
+      "!!!filter: shed -e 's/a/b/; s/x/y/L'\n";
+
+   int errors = 0;
+   string output1 = runFilter(data);
+   string output2 = runFilter(data);
+   errors += check("first comment", to_string(output1.find("\n!a\n")
+         != string::npos), "1");
+   errors += check("first data", to_string(output1.find("\n4b\n")
+         != string::npos), "1");
+   errors += check("second file", output2, output1);
+
+   cout << (errors ? "FAILED" : "PASSED") << endl;
+   return errors ? 1 : 0;
+}
+
+
+
@@ -0,0 +1,82 @@
+// Description: Check combining the pitch-class and range histograms of
+//              several files with the --corpus option of pccount and
+//              prange.
+
+#include "humlib.h"
+
+using namespace hum;
+
+
+//////////////////////////////
+//
+// check -- Print an error message if the value is not the expected one.
+//
+
+int check(const string& name, const string& value, const string& expected) {
+   if (value == expected) {
+      return 0;
+   }
+   cout << "ERROR: " << name << " is \"" << value << "\" instead of \""
+        << expected << "\"" << endl;
+   return 1;
+}
+
+
+
+int main(int argc, char** argv) {
+   HumdrumFileSet infiles;
+   stringstream input;
+   input <<
+      "!!!!SEGMENT: one.krn\n"
+      "**kern\t**kern\n"
+      "*I\"Bass\t*I\"Soprano\n"
+      "4C\t4e\n"
+      "4G\t4c\n"
+      "*-\t*-\n"
+      "!!!!SEGMENT: two.krn\n"
+      "**kern\t**kern\t**kern\n"
+      "*I\"Bass\t*\t*I\"Soprano\n"
+      "4C\t4G\t4g\n"
+      "*-\t*-\t*-\n";
+   infiles.read(input);
+
+   int errors = 0;
+
+   PccountHistogram a;
+   PccountHistogram b;
+   a.counts.at(a.getVoiceIndex("Bass"))[2] = 1.0;
+   b.counts.at(b.getVoiceIndex("Alto"))[2] = 2.0;
+   b.counts.at(b.getVoiceIndex("Bass"))[2] = 3.0;
+   a.merge(b);
+   errors += check("merge voices", to_string(a.names.size()), "2");
+   errors += check("merge count", to_string((int)a.counts[0][2]), "4");
+   errors += check("merge order", a.names[1], "Alto");
+
+   Tool_pccount pccount;
+   pccount.process("pccount -C -a");
+   pccount.run(infiles);
+   pccount.finally();
+   string output = pccount.getFreeText();
+   errors += check("pccount voices", to_string(output.find(
+         "*\t*I\"all\t*I\"Bass\t*I\"Soprano\t*I\"voice 2\n") != string::npos), "1");
+   errors += check("pccount c", to_string(output.find("\nc\t3\t2\t1\t0\n")
+         != string::npos), "1");
+   errors += check("pccount g", to_string(output.find("\ng\t3\t1\t1\t1\n")
+         != string::npos), "1");
+
+   Tool_prange prange;
+   prange.process("prange -C");
+   prange.run(infiles);
+   prange.finally();
+   output = prange.getHumdrumText();
+   errors += check("prange G", to_string(output.find("\n55\tG\t2\n")
+         != string::npos), "1");
+   errors += check("prange C", to_string(output.find("\n48\tC\t2\n")
+         != string::npos), "1");
+
+   cout << (errors ? "FAILED" : "PASSED") << endl;
+   return errors ? 1 : 0;
+}
+
+
+
@@ -0,0 +1,92 @@
+// Description: Check HumNum64 checked arithmetic, and that rhythm analysis
+//              of dense tuplets reports an error instead of overflowing.
+
+#include "humlib.h"
+
+using namespace hum;
+
+
+//////////////////////////////
+//
+// check -- Print an error message if the test fails.
+//
+
+int check(bool test, const string& message) {
+   if (!test) {
+      cout << "ERROR: " << message << endl;
+      return 1;
+   }
+   return 0;
+}
+
+
+
+int main(int argc, char** argv) {
+   int errors = 0;
+
+   // Arithmetic results are reduced:
+   HumNum64 a(1, 3);
+   HumNum64 b(1, 6);
+   errors += check(a + b == HumNum64(1, 2), "1/3 + 1/6");
+   errors += check(a - b == b, "1/3 - 1/6");
+   errors += check(a * b == HumNum64(1, 18), "1/3 * 1/6");
+   errors += check(a / b == HumNum64(2), "1/3 / 1/6");
+   errors += check(HumNum64(2, -4) == HumNum64(-1, 2), "negative denominator");
+   errors += check(HumNum64(1, 3) < HumNum64(1, 2), "comparison");
+
+   // Values that do not fit into a HumNum:
+   HumNum64 large(INT64_C(3000000000), 7);
+   HumNum value;
+   errors += check(!large.getHumNum(value), "HumNum conversion of large value");
+   errors += check(HumNum64(5, 7).getHumNum(value) && (value == HumNum(5, 7)),
+         "HumNum conversion");
+
+   // Ticks:
+   int64_t ticks = 0;
+   errors += check(HumNum64(5, 3).getTicks(12, ticks) && (ticks == 20), "ticks");
+   errors += check(!HumNum64(1, 5).getTicks(12, ticks), "ticks with wrong tpq");
+
+   // Overflow is sticky:
+   HumNum64 big(INT64_MAX / 2);
+   HumNum64 overflow = big * HumNum64(3) + HumNum64(1);
+   errors += check(overflow.isNaN(), "overflow is NaN");
+   errors += check(!big.isNaN(), "no overflow");
+   errors += check(!(overflow == overflow), "NaN comparison");
+
+   // Durations from the start of a score with prime-number tuplets in
+   // separate spines, analyzed with two threads:
+   stringstream tuplets;
+   tuplets << "**kern\t**kern\t**kern\t**kern\t**kern\n";
+   tuplets << "*M4/4\t*M4/4\t*M4/4\t*M4/4\t*M4/4\n";
+   tuplets << "1c\t3d\t5e\t7f\t11g\n";
+   tuplets << ".\t.\t.\t.\t11%10g\n";
+   tuplets << ".\t.\t.\t7%6f\t.\n";
+   tuplets << ".\t.\t5%4e\t.\t.\n";
+   tuplets << ".\t3%2d\t.\t.\t.\n";
+   tuplets << "*-\t*-\t*-\t*-\t*-\n";
+   HumdrumFile infile;
+   infile.setAnalysisThreads(2);
+   errors += check(infile.read(tuplets), "prime tuplets: " + infile.getParseError());
+   errors += check(infile.getScoreDuration() == 4, "prime tuplets score duration");
+   errors += check(infile[6].getDurationFromStart() == HumNum(4, 3), "prime tuplets timestamp");
+   errors += check(infile.tpq() == 1155, "prime tuplets tpq");
+
+   // A single spine with a duration denominator that does not fit into
+   // an int is an error:
+   stringstream dense;
+   dense << "**kern\n";
+   vector<int> primes = {3, 5, 7, 11, 13, 17, 19, 23, 29, 31};
+   for (int prime : primes) {
+      dense << prime << "c\n";
+   }
+   dense << "*-\n";
+   HumdrumFile densefile;
+   densefile.read(dense);
+   errors += check(!densefile.isValid(), "dense tuplets should be an error");
+
+   cout << (errors ? "FAILED" : "PASSED") << endl;
+   return errors ? 1 : 0;
+}
+
+
+
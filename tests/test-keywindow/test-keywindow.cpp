@@ -0,0 +1,98 @@
+// Description: Check that HumKeyWindow gives the same key correlations
+//              as Pearson correlations of rotated key profiles with
+//              histograms summed directly over each window.
+
+#include "humlib.h"
+
+#include <random>
+
+using namespace hum;
+
+
+//////////////////////////////
+//
+// getDirectCorrelations -- Sum the window's segments and correlate the
+//     histogram with the rotated Kostka-Payne profiles.
+//
+
+vector<double> getDirectCorrelations(vector<vector<double>>& segments,
+      int start, int length) {
+   vector<double> histogram(12, 0.0);
+   for (int i=start; (i<start+length) && (i<(int)segments.size()); i++) {
+      for (int k=0; k<12; k++) {
+         histogram[k] += segments[i][k];
+      }
+   }
+   vector<double> major;
+   vector<double> minor;
+   HumKeyWindow::getKostkaPayneWeights(major, minor);
+   vector<double> output;
+   for (int m=0; m<2; m++) {
+      for (int tonic=0; tonic<12; tonic++) {
+         vector<double> rotated(12);
+         for (int k=0; k<12; k++) {
+            rotated[k] = histogram[(k + tonic) % 12];
+         }
+         output.push_back(Convert::pearsonCorrelation(m ? minor : major, rotated));
+      }
+   }
+   return output;
+}
+
+
+
+int main(int argc, char** argv) {
+   std::mt19937 generator(1);
+   std::uniform_real_distribution<double> random(0.0, 4.0);
+   vector<vector<double>> segments(200, vector<double>(12, 0.0));
+   for (int i=0; i<(int)segments.size(); i++) {
+      // leave some segments empty (rests):
+      if ((i >= 40) && (i < 60)) {
+         continue;
+      }
+      for (int k=0; k<12; k++) {
+         if (random(generator) > 2.5) {
+            segments[i][k] = random(generator);
+         }
+      }
+   }
+
+   int errors = 0;
+   HumKeyWindow keywindow;
+   int windows[3][2] = { {16, 8}, {8, 4}, {4, 8} };
+   for (int w=0; w<3; w++) {
+      int length = windows[w][0];
+      int hop = windows[w][1];
+      for (int start=0; start<(int)segments.size(); start += hop) {
+         keywindow.setWindow(segments, start, length);
+         bool empty = true;
+         for (int i=start; (i<start+length) && (i<(int)segments.size()); i++) {
+            for (int k=0; k<12; k++) {
+               if (segments[i][k] != 0.0) {
+                  empty = false;
+               }
+            }
+         }
+         if (empty != keywindow.isEmpty()) {
+            cout << "Window " << start << ":" << length << " empty state differs" << endl;
+            errors++;
+         }
+         if (empty) {
+            continue;
+         }
+         vector<double> expected = getDirectCorrelations(segments, start, length);
+         vector<double> correls;
+         keywindow.getCorrelations(correls);
+         for (int k=0; k<24; k++) {
+            if (fabs(expected[k] - correls[k]) > 1.0e-9) {
+               cout << "Window " << start << ":" << length << " key " << k
+                    << ": expected " << expected[k] << " got " << correls[k] << endl;
+               errors++;
+            }
+         }
+      }
+   }
+
+   cout << (errors ? "FAILED" : "PASSED") << endl;
+   return errors ? 1 : 0;
+}
@@ -0,0 +1,91 @@
+// Description: Check building, writing, reading and searching an index
+//              of the words in **text spines.
+
+#include "humlib.h"
+
+using namespace hum;
+
+
+//////////////////////////////
+//
+// check -- Print an error message if the value is not the expected one.
+//
+
+int check(const string& name, const string& value, const string& expected) {
+   if (value == expected) {
+      return 0;
+   }
+   cout << "ERROR: " << name << " is \"" << value << "\" instead of \""
+        << expected << "\"" << endl;
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// words -- Convert a list of entries into a string of their words.
+//
+
+string words(HumLyricIndex& index, const vector<int>& entries) {
+   string output;
+   for (int i=0; i<(int)entries.size(); i++) {
+      output += (i ? " " : "") + index.getEntry(entries[i]).word;
+   }
+   return output;
+}
+
+
+
+int main(int argc, char** argv) {
+   HumdrumFile infile;
+   infile.readString(
+      "**kern\t**text\t**kern\t**text\n"
+      "4c\tGlo-\t4e\tEt\n"
+      "4d\t-ri-\t4f\tin\n"
+      "4e\t.\t4g\tter-\n"
+      "4f\t-a\t4a\t-ra\n"
+      "4g\tin\t4b\tpax\n"
+      "*-\t*-\t*-\t*-\n");
+   infile.setFilename("gloria.krn");
+
+   HumLyricIndex index;
+   index.addFile(infile);
+
+   int errors = 0;
+   errors += check("count", to_string(index.getEntryCount()), "6");
+   errors += check("word", index.getEntry(0).word, "Gloria");
+   errors += check("line", to_string(index.getEntry(3).line), "2");
+   errors += check("field", to_string(index.getEntry(3).field), "3");
+   errors += check("next", to_string(index.getNextEntry(0)), "1");
+   errors += check("last", to_string(index.getNextEntry(5)), "-1");
+   errors += check("token", *index.getToken(4, infile), "ter-");
+
+   errors += check("word", words(index, index.findWord("IN")), "in in");
+   errors += check("prefix", words(index, index.findPrefix("glo")), "Gloria");
+   errors += check("wildcard", words(index, index.findWildcard("?e*")), "terra");
+   errors += check("wildcard2", words(index, index.findWildcard("*a")), "Gloria terra");
+   errors += check("regex", words(index, index.findRegex("^(et|pax)$")), "Et pax");
+
+   stringstream stored;
+   index.printIndex(stored);
+   HumLyricIndex index2;
+   index2.readIndex(stored);
+   errors += check("read count", to_string(index2.getEntryCount()), "6");
+   errors += check("read filename", index2.getFilename(0), "gloria.krn");
+   errors += check("read prefix", words(index2, index2.findPrefix("ter")), "terra");
+
+   Tool_msearch msearch;
+   msearch.process("msearch -t terra -Q");
+   msearch.run(infile);
+   stringstream output;
+   msearch.getAllText(output);
+   errors += check("msearch", to_string(output.str().find("ter@-")
+         != string::npos), "1");
+
+   cout << (errors ? "FAILED" : "PASSED") << endl;
+   return errors ? 1 : 0;
+}
+
+
+
@@ -0,0 +1,71 @@
+// Description: Check the metric positions of lines, and that they are
+//              recalculated after the file is changed.
+
+#include "humlib.h"
+
+using namespace hum;
+
+
+//////////////////////////////
+//
+// check -- Print an error message if the value is not the expected one.
+//
+
+int check(const string& name, double value, double expected) {
+   if ((value == expected) || (std::isnan(value) && std::isnan(expected))) {
+      return 0;
+   }
+   cout << "ERROR: " << name << " is " << value << " instead of "
+        << expected << endl;
+   return 1;
+}
+
+
+
+int main(int argc, char** argv) {
+   HumdrumFile infile;
+   infile.readString(
+      "**kern\t**kern\n"
+      "*M6/8\t*M3/4\n"
+      "=1\t=1\n"
+      "4.c\t4.e\n"
+      "8d\t8f\n"
+      "8e\t8g\n"
+      "8f\t8a\n"
+      "4g\t4b\n"
+      "=2\t=2\n"
+      "2.c\t2.e\n"
+      "==\t==\n"
+      "*-\t*-\n");
+
+   int errors = 0;
+   errors += check("tpq", infile.tpq(), 2);
+   errors += check("measure 0", infile.getMetricPosition(1).measure, 0);
+   errors += check("measure 1", infile.getMetricPosition(3).measure, 1);
+   errors += check("measure 1 end", infile.getMetricPosition(8).measure, 1);
+   errors += check("measure 2", infile.getMetricPosition(9).measure, 2);
+   errors += check("beat", infile.getMetricPosition(6).beat, 1);
+   errors += check("ticks", infile.getMetricPosition(5).ticks, 4);
+   errors += check("weight", infile.getMetricPosition(3).weight, 2);
+   errors += check("weight half", infile.getMetricPosition(5).weight, 1);
+   errors += check("weight quarter", infile.getMetricPosition(7).weight, 0);
+   errors += check("weight eighth", infile.getMetricPosition(6).weight, -1);
+   errors += check("level", infile.getMetricPosition(3).level, 0);
+   errors += check("level eighth", infile.getMetricPosition(5).level, 1);
+   errors += check("level barline", infile.getMetricPosition(2).level, NAN);
+
+   vector<double> levels;
+   infile.getMetricLevels(levels, 2, -1);
+   errors += check("track 2 level", levels[6], 1);
+   errors += check("track 2 barline", levels[2], -1);
+
+   errors += check("before delete", infile.getMetricPosition(8).measure, 1);
+   infile.deleteLine(4);
+   errors += check("after delete", infile.getMetricPosition(8).measure, 2);
+
+   cout << (errors ? "FAILED" : "PASSED") << endl;
+   return errors ? 1 : 0;
+}
+
+
+
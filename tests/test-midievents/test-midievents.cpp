@@ -0,0 +1,35 @@
+// Description: Print the MIDI events generated from **kern data.
+
+#include "humlib.h"
+
+using namespace hum;
+
+int main(int argc, char** argv) {
+   HumdrumFile infile;
+   if (argc > 1) {
+      if (!infile.read(argv[1])) {
+         return 1;
+      }
+   } else {
+      infile.readString(
+         "**kern\t**kern\n"
+         "*MM96\t*\n"
+         "4c[\t4e\n"
+         "8c_\t4g\n"
+         "8c]\t.\n"
+         "4c 4e\t8d\n"
+         ".\t8r\n"
+         "*-\t*-\n");
+   }
+   int endtick = infile.getMidiEvents([](const HumMidiEvent& event) {
+      cout << event.tick << "\t";
+      if (event.isTempo()) {
+         cout << "tempo\t" << event.tempo << endl;
+      } else {
+         cout << (event.isNoteOn() ? "on" : "off") << "\t" << event.track
+              << "\t" << event.key << endl;
+      }
+   }, 4);
+   cout << "end\t" << endtick << endl;
+   return 0;
+}
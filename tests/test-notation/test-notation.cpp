@@ -0,0 +1,78 @@
+// Description: Check that HumdrumFileContent::analyzeNotation() gives the
+//              same token parameters as the separate slur, phrase, beam,
+//              tie and accidental analyses.
+
+#include "humlib.h"
+
+using namespace hum;
+
+
+//////////////////////////////
+//
+// getParameterList -- Return the analysis parameters of every token,
+//     with token references replaced by line and field numbers.
+//
+
+vector<string> getParameterList(HumdrumFile& infile) {
+   map<string, string> ids;
+   for (int i=0; i<infile.getLineCount(); i++) {
+      for (int j=0; j<infile[i].getFieldCount(); j++) {
+         string id = "HT_" + to_string((size_t)infile.token(i, j));
+         ids[id] = "(" + to_string(i) + "," + to_string(j) + ")";
+      }
+   }
+   vector<string> output;
+   for (int i=0; i<infile.getLineCount(); i++) {
+      for (int j=0; j<infile[i].getFieldCount(); j++) {
+         HTp token = infile.token(i, j);
+         string entry = *token;
+         for (auto& it : token->getParameters("", "auto")) {
+            string value = ids.count(it.second) ? ids[it.second] : it.second;
+            entry += "\t" + it.first + "=" + value;
+         }
+         for (int k=0; k<token->getSubtokenCount(); k++) {
+            for (auto& it : token->getParameters("auto", to_string(k))) {
+               entry += "\t" + to_string(k) + ":" + it.first + "=" + it.second;
+            }
+         }
+         output.push_back(entry);
+      }
+   }
+   return output;
+}
+
+
+
+int main(int argc, char** argv) {
+   if (argc < 2) {
+      cerr << "Usage: " << argv[0] << " file.krn [file2.krn ...]" << endl;
+      return 1;
+   }
+   int errors = 0;
+   for (int i=1; i<argc; i++) {
+      HumdrumFile separate;
+      HumdrumFile fused;
+      if (!separate.read(argv[i]) || !fused.read(argv[i])) {
+         return 1;
+      }
+      separate.analyzeSlurs();
+      separate.analyzePhrasings();
+      separate.analyzeBeams();
+      separate.analyzeKernTies();
+      separate.analyzeKernAccidentals();
+      fused.analyzeNotation();
+
+      vector<string> list1 = getParameterList(separate);
+      vector<string> list2 = getParameterList(fused);
+      for (int j=0; j<(int)list1.size(); j++) {
+         if (list1[j] != list2[j]) {
+            cout << argv[i] << ": token " << j << " differs:" << endl;
+            cout << "\tseparate: " << list1[j] << endl;
+            cout << "\tfused:    " << list2[j] << endl;
+            errors++;
+         }
+      }
+   }
+   cout << (errors ? "FAILED" : "PASSED") << endl;
+   return errors ? 1 : 0;
+}
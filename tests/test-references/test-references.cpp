@@ -0,0 +1,86 @@
+// Description: Check reference-record lookups, including after lines
+//              are inserted, deleted or changed.
+
+#include "humlib.h"
+
+using namespace hum;
+
+
+//////////////////////////////
+//
+// check -- Print an error message if the value is not the expected one.
+//
+
+int check(const string& name, const string& value, const string& expected) {
+   if (value == expected) {
+      return 0;
+   }
+   cout << "ERROR: " << name << " is \"" << value << "\" instead of \""
+        << expected << "\"" << endl;
+   return 1;
+}
+
+
+
+int main(int argc, char** argv) {
+   HumdrumFile infile;
+   infile.readString(
+      "!!!COM: Composer\n"
+      "!!!!SEGMENT: file.krn\n"
+      "!! comment\n"
+      "**kern\n"
+      "4c\n"
+      "*-\n"
+      "!!!OTL: Title\n"
+      "!!!COM: Second composer\n");
+
+   int errors = 0;
+   errors += check("COM", infile.getReferenceRecord("COM"), "Composer");
+   errors += check("OTL", infile.getReferenceRecord("OTL"), "Title");
+   errors += check("SEGMENT", infile.getReferenceRecord("SEGMENT"), "file.krn");
+   errors += check("missing", infile.getReferenceRecord("XXX"), "");
+   errors += check("reference count", to_string(infile.getReferenceRecords().size()), "4");
+   errors += check("global count", to_string(infile.getGlobalReferenceRecords().size()), "3");
+   errors += check("universal count", to_string(infile.getUniversalReferenceRecords().size()), "1");
+   errors += check("COM count", to_string(infile.getReferenceRecords("COM").size()), "2");
+
+   infile.insertLine(0, "!!!COM: Inserted composer");
+   errors += check("inserted COM", infile.getReferenceRecord("COM"), "Inserted composer");
+   infile.deleteLine(0);
+   infile.deleteLine(0);
+   errors += check("deleted COM", infile.getReferenceRecord("COM"), "Second composer");
+   infile.appendLine("!!!OPR: Parent");
+   errors += check("appended OPR", infile.getReferenceRecord("OPR"), "Parent");
+
+   // Changing the key of a reference record through its token:
+   HLp line = infile.getReferenceRecords("OTL").at(0);
+   line->token(0)->setText("!!!OTP: Popular title");
+   infile.createLinesFromTokens();
+   errors += check("changed OTL", infile.getReferenceRecord("OTL"), "");
+   errors += check("changed OTP", infile.getReferenceRecord("OTP"), "Popular title");
+
+   // A global comment which becomes a reference record, and back:
+   int count = (int)infile.getReferenceRecords().size();
+   HLp comment = NULL;
+   for (int i=0; i<infile.getLineCount(); i++) {
+      if (infile[i] == "!! comment") {
+         comment = &infile[i];
+      }
+   }
+   comment->token(0)->setText("!!!OTL: Title");
+   comment->createLineFromTokens();
+   errors += check("new OTL", infile.getReferenceRecord("OTL"), "Title");
+   errors += check("new count", to_string(infile.getReferenceRecords().size()),
+         to_string(count + 1));
+   comment->token(0)->setText("!! comment");
+   comment->createLineFromTokens();
+   errors += check("removed OTL", infile.getReferenceRecord("OTL"), "");
+   errors += check("removed count", to_string(infile.getReferenceRecords().size()),
+         to_string(count));
+
+   cout << (errors ? "FAILED" : "PASSED") << endl;
+   return errors ? 1 : 0;
+}
+
+
+
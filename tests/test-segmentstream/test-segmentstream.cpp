@@ -0,0 +1,88 @@
+// Description: Check reading the segments of a stream one at a time,
+//              with and without reading the next segment ahead.
+
+#include "humlib.h"
+
+using namespace hum;
+
+
+//////////////////////////////
+//
+// check -- Print an error message if the value is not the expected one.
+//
+
+int check(const string& name, const string& value, const string& expected) {
+   if (value == expected) {
+      return 0;
+   }
+   cout << "ERROR: " << name << " is \"" << value << "\" instead of \""
+        << expected << "\"" << endl;
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// readSegments -- Read all segments of the stream one at a time and
+//     list their line counts and first lines.
+//
+
+string readSegments(HumdrumFileStream& instream) {
+   string output;
+   HumdrumFileSet infiles;
+   while (instream.readSingleSegment(infiles)) {
+      output += to_string(infiles[0].getLineCount()) + ":";
+      output += infiles[0][0].getText() + ";";
+   }
+   return output;
+}
+
+
+
+int main(int argc, char** argv) {
+   string data =
+      "!!!!COM: one\n"
+      "!!!!SEGMENT: a.krn\n"
+      "**kern\n"
+      "4c\n"
+      "*-\n"
+      "!!!!SEGMENT: b.krn\n"
+      "**kern\n"
+      "4d\n"
+      "*-\n"
+      "!!!!SEGMENT: c.krn\n"
+      "!!!!COM: two\n"
+      "!!!!OTL: title\n"
+      "**kern\n"
+      "4e\n"
+      "*-\n";
+   string expected = "5:!!!COM: one;5:!!!COM: one;6:!!!COM: two;";
+
+   int errors = 0;
+
+   stringstream input1(data);
+   HumdrumFileStream instream1(input1);
+   errors += check("istream", readSegments(instream1), expected);
+
+   stringstream input2(data);
+   HumdrumFileStream instream2(input2);
+   instream2.setPrefetch();
+   errors += check("prefetch", readSegments(instream2), expected);
+   errors += check("eof", to_string(instream2.eof()), "1");
+
+   HumdrumFileStream instream3(data);
+   instream3.setPrefetch();
+   errors += check("string", readSegments(instream3), expected);
+
+   stringstream input4(data);
+   HumdrumFileSet infiles;
+   errors += check("set", to_string(infiles.read(input4)), "3");
+   errors += check("set line", infiles[2][2].getText(), "!!!!SEGMENT: c.krn");
+
+   cout << (errors ? "FAILED" : "PASSED") << endl;
+   return errors ? 1 : 0;
+}
+
+
+
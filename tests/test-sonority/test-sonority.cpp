@@ -0,0 +1,105 @@
+// Description: Check the HumSonority chord table against triads and
+//              dyads built in every transposition.
+
+#include "humlib.h"
+
+using namespace hum;
+
+
+//////////////////////////////
+//
+// checkChord -- Check the type, root, third and fifth of a pitch-class
+//     set built on each of the twelve roots.
+//
+
+int checkChord(const string& name, vector<int> intervals, int type,
+      int third, int fifth) {
+   int errors = 0;
+   for (int root=0; root<12; root++) {
+      HumSonority sonority;
+      for (int i=0; i<(int)intervals.size(); i++) {
+         // use different octaves to check that only pitch classes matter:
+         sonority.addMidi(48 + 12 * i + root + intervals[i]);
+      }
+      int expectedThird = third < 0 ? -1 : (root + third) % 12;
+      int expectedFifth = fifth < 0 ? -1 : (root + fifth) % 12;
+      if ((sonority.getType() != type) || (sonority.getRoot() != root)
+            || (sonority.getThird() != expectedThird)
+            || (sonority.getFifth() != expectedFifth)) {
+         cout << "ERROR: " << name << " on " << root << ": type "
+              << sonority.getType() << " root " << sonority.getRoot()
+              << " third " << sonority.getThird()
+              << " fifth " << sonority.getFifth() << endl;
+         errors++;
+      }
+   }
+   return errors;
+}
+
+
+
+int main(int argc, char** argv) {
+   int errors = 0;
+   errors += checkChord("major",      {0, 4, 7}, sonority_major,      4, 7);
+   errors += checkChord("minor",      {0, 3, 7}, sonority_minor,      3, 7);
+   errors += checkChord("diminished", {0, 3, 6}, sonority_diminished, 3, 6);
+   errors += checkChord("fifth",      {0, 7},    sonority_fifth,     -1, 7);
+   errors += checkChord("fourth",     {7, 12},   sonority_fifth,     -1, 7);
+   errors += checkChord("m3",         {0, 3},    sonority_minor_third, 3, -1);
+   errors += checkChord("M6",         {3, 12},   sonority_minor_third, 3, -1);
+   errors += checkChord("M3",         {0, 4},    sonority_major_third, 4, -1);
+
+   // Augmented triads use the lowest pitch class as the root:
+   HumSonority aug;
+   aug.addMidi(64);
+   aug.addMidi(68);
+   aug.addMidi(72);
+   if ((aug.getType() != sonority_augmented) || (aug.getRoot() != 0)) {
+      cout << "ERROR: augmented triad root " << aug.getRoot() << endl;
+      errors++;
+   }
+
+   // Inversions depend on the bass:
+   HumSonority chord;
+   chord.addMidi(67);
+   chord.addMidi(72);
+   chord.addMidi(76);
+   chord.setBass(67);
+   if ((chord.getInversion() != 2) || (chord.getPosition(55) != 5)) {
+      cout << "ERROR: second inversion" << endl;
+      errors++;
+   }
+
+   // Other sets:
+   HumSonority other;
+   other.addMidi(60);
+   other.addMidi(62);
+   if (other.getType() != sonority_dyad) {
+      errors++;
+   }
+   other.addMidi(64);
+   if ((other.getType() != sonority_trichord) || (other.getRoot() != -1)) {
+      errors++;
+   }
+   other.addMidi(65);
+   if ((other.getType() != sonority_large) || (other.getPitchClassCount() != 4)) {
+      errors++;
+   }
+
+   // Spelled pitch classes:
+   HumSonority spelled;
+   spelled.addBase40(Convert::kernToBase40("c#"));
+   spelled.addDiatonic(Convert::kernToBase7("c#"));
+   if (!spelled.hasDiatonic(Convert::kernToBase7("CC"))
+         || spelled.hasBase40(Convert::kernToBase40("d-"))
+         || !spelled.hasBase40(Convert::kernToBase40("C#"))) {
+      cout << "ERROR: spelled pitch classes" << endl;
+      errors++;
+   }
+
+   cout << (errors ? "FAILED" : "PASSED") << endl;
+   return errors ? 1 : 0;
+}
+
+
+
@@ -0,0 +1,114 @@
+// Description: Check that --stats leaves the input scores unchanged and
+//              that statistics collected by separate tool objects (one
+//              per worker) merge into the same summary as a single tool
+//              object processing every file.
+
+#include "humlib.h"
+
+using namespace hum;
+
+const char* SCORES[] = {
+   "**kern\t**kern\t**kern\n*M4/4\t*M4/4\t*M4/4\n=1\t=1\t=1\n2C\t2e\t2g\n"
+   "2D\t4f\t2a\n.\t4e\t.\n=2\t=2\t=2\n2E\t2g\t2cc\n2C\t2e\t2g\n==\t==\t==\n*-\t*-\t*-\n",
+
+   "**kern\t**kern\n*M3/4\t*M3/4\n=1\t=1\n2.G\t4d\n.\t4e\n.\t4f\n=2\t=2\n"
+   "2.c\t2.e\n==\t==\n*-\t*-\n",
+
+   "**kern\t**kern\t**kern\n*M2/2\t*M2/2\t*M2/2\n=1\t=1\t=1\n1F\t2a\t1cc\n"
+   ".\t2b-\t.\n=2\t=2\t=2\n1C\t1g\t1ee\n==\t==\t==\n*-\t*-\t*-\n",
+};
+
+const int SCORECOUNT = 3;
+
+
+
+//////////////////////////////
+//
+// runStatistics -- Run a tool with --stats on the scores, assigning score
+//     i to tools[i % tools.size()].  Return the merged JSON summary.
+//
+
+template <class TOOL>
+string runStatistics(int workers, int& errors) {
+   vector<TOOL> tools(workers);
+   for (int i=0; i<workers; i++) {
+      tools[i].process("tool --stats");
+   }
+   for (int i=0; i<SCORECOUNT; i++) {
+      HumdrumFile infile;
+      infile.readString(SCORES[i]);
+      stringstream before;
+      before << infile;
+      tools[i % workers].run(infile);
+      stringstream after;
+      after << infile;
+      if (before.str() != after.str()) {
+         cout << "ERROR: score " << i << " was modified with --stats" << endl;
+         errors++;
+      }
+      if (tools[i % workers].hasAnyText()) {
+         cout << "ERROR: output generated for score " << i << endl;
+         errors++;
+      }
+   }
+   for (int i=1; i<workers; i++) {
+      tools[0].getStatistics().merge(tools[i].getStatistics());
+   }
+   stringstream out;
+   tools[0].getStatistics().printJson(out);
+   return out.str();
+}
+
+
+
+//////////////////////////////
+//
+// checkTool --
+//
+
+template <class TOOL>
+void checkTool(const string& name, int& errors) {
+   string single = runStatistics<TOOL>(1, errors);
+   string merged = runStatistics<TOOL>(2, errors);
+   if (single != merged) {
+      cout << "ERROR: merged " << name << " statistics differ:" << endl;
+      cout << single << merged;
+      errors++;
+   }
+   if (single.find("\"files\": " + to_string(SCORECOUNT)) == string::npos) {
+      cout << "ERROR: wrong file count for " << name << ":" << endl << single;
+      errors++;
+   }
+}
+
+
+
+int main(int argc, char** argv) {
+   int errors = 0;
+   checkTool<Tool_dissonant>("dissonant", errors);
+   checkTool<Tool_cint>("cint", errors);
+   checkTool<Tool_tspos>("tspos", errors);
+
+   HumStatistics a;
+   HumStatistics b;
+   a.increment("labels", "P", 2);
+   b.increment("labels", "P", 3);
+   b.increment("labels", "\"quoted\"");
+   a.merge(b);
+   if ((a.getValue("labels", "P") != 5) || (a.getValue("labels", "\"quoted\"") != 1)) {
+      cout << "ERROR: bad merge" << endl;
+      errors++;
+   }
+   stringstream json;
+   a.printJson(json, "test");
+   if (json.str().find("\"\\\"quoted\\\"\": 1") == string::npos) {
+      cout << "ERROR: bad JSON string escaping:" << endl << json.str();
+      errors++;
+   }
+
+   cout << (errors ? "FAILED" : "PASSED") << endl;
+   return errors ? 1 : 0;
+}
+
+
+
@@ -0,0 +1,102 @@
+// Description: Check that subtoken views match the allocating subtoken
+//              functions, and that cached offsets follow text changes.
+
+#include "humlib.h"
+
+using namespace hum;
+
+
+//////////////////////////////
+//
+// checkToken -- Compare getSubtokenViews(), getSubtokenView() and
+//     getSubtoken() for each index of the token.
+//
+
+int checkToken(HumdrumToken& token, const string& separator) {
+   int errors = 0;
+   int count = token.getSubtokenCount(separator);
+   int index = 0;
+   for (string_view view : token.getSubtokenViews(separator)) {
+      if ((string)view != token.getSubtoken(index, separator)) {
+         cout << "ERROR: view " << index << " of \"" << token << "\"" << endl;
+         errors++;
+      }
+      if (view != token.getSubtokenView(index, separator)) {
+         cout << "ERROR: indexed view " << index << " of \"" << token << "\"" << endl;
+         errors++;
+      }
+      index++;
+   }
+   if (index != count) {
+      cout << "ERROR: \"" << token << "\" has " << index << " views but count is "
+           << count << endl;
+      errors++;
+   }
+   if (!token.getSubtokenView(count, separator).empty()) {
+      cout << "ERROR: view after the last subtoken of \"" << token << "\"" << endl;
+      errors++;
+   }
+   return errors;
+}
+
+
+
+int main(int argc, char** argv) {
+   int errors = 0;
+   vector<string> texts = {"4c 4e 4g", "4c", "", " 4c", "4c ", "4c  4e", "8C#L 8e-"};
+   for (auto& text : texts) {
+      HumdrumToken token(text);
+      errors += checkToken(token, " ");
+      errors += checkToken(token, "");
+   }
+
+   HumdrumToken chord("4c 4e  4g");
+   if (chord.getSubtokens() != vector<string>({"4c", "4e", "4g"})) {
+      cout << "ERROR: getSubtokens should skip empty subtokens" << endl;
+      errors++;
+   }
+   if (chord.getSubtokenCount() != 4) {
+      cout << "ERROR: getSubtokenCount should count empty subtokens" << endl;
+      errors++;
+   }
+
+   // Cached offsets must be updated when the text changes:
+   chord.setText("2d 2f");
+   errors += checkToken(chord, " ");
+   chord.replaceSubtoken(1, "2f#");
+   if ((chord != "2d 2f#") || (chord.getSubtoken(1) != "2f#")) {
+      cout << "ERROR: replaceSubtoken: " << chord << endl;
+      errors++;
+   }
+   chord.setText("4A 4c 4e");
+   if ((chord.getSubtokenCount() != 3) || (chord.getSubtokenView(2) != "4e")) {
+      cout << "ERROR: setText did not update subtokens" << endl;
+      errors++;
+   }
+
+   // Changes through the std::string interface are noticed, and the
+   // const accessors work without the cache:
+   chord.getSubtokenCount();
+   chord.replace(2, 1, "  ");
+   const HumdrumToken& constchord = chord;
+   if ((constchord.getSubtokenCount() != 4) || (constchord.getSubtokenView(1) != "")
+         || (constchord.getSubtokenView(3) != "4e")
+         || (chord.getSubtokenView(2) != "4c")) {
+      cout << "ERROR: subtokens after std::string change: " << chord << endl;
+      errors++;
+   }
+
+   // Pitch functions use the subtoken views:
+   HumdrumToken pitches("4c 4r 4e_");
+   vector<int> midi = pitches.getMidiPitches();
+   if (midi != vector<int>({60, 0, -64})) {
+      cout << "ERROR: getMidiPitches" << endl;
+      errors++;
+   }
+
+   cout << (errors ? "FAILED" : "PASSED") << endl;
+   return errors ? 1 : 0;
+}
+
+
+
@@ -0,0 +1,95 @@
+// Description: Check that analyses run with several threads give the
+//              same line durations and token parameters as analyses run
+//              with a single thread.
+
+#include "humlib.h"
+
+using namespace hum;
+
+
+//////////////////////////////
+//
+// getAnalysisList -- Return the line durations and the analysis parameters
+//     of every token, with token references replaced by line and field
+//     numbers.
+//
+
+vector<string> getAnalysisList(HumdrumFile& infile) {
+   map<string, string> ids;
+   for (int i=0; i<infile.getLineCount(); i++) {
+      for (int j=0; j<infile[i].getFieldCount(); j++) {
+         string id = "HT_" + to_string((size_t)infile.token(i, j));
+         ids[id] = "(" + to_string(i) + "," + to_string(j) + ")";
+      }
+   }
+   vector<string> output;
+   for (int i=0; i<infile.getLineCount(); i++) {
+      stringstream line;
+      line << infile[i].getDurationFromStart() << "\t" << infile[i].getDuration();
+      output.push_back(line.str());
+      for (int j=0; j<infile[i].getFieldCount(); j++) {
+         HTp token = infile.token(i, j);
+         string entry = *token;
+         for (auto& it : token->getParameters("", "auto")) {
+            string value = ids.count(it.second) ? ids[it.second] : it.second;
+            entry += "\t" + it.first + "=" + value;
+         }
+         output.push_back(entry);
+      }
+   }
+   return output;
+}
+
+
+
+//////////////////////////////
+//
+// analyzeFile -- Read a file using the given number of threads and run
+//     the analyses that can process spines in parallel.
+//
+
+bool analyzeFile(HumdrumFile& infile, const string& filename, int threads) {
+   infile.setAnalysisThreads(threads);
+   if (!infile.read(filename)) {
+      return false;
+   }
+   infile.analyzeSlurs();
+   infile.analyzePhrasings();
+   infile.analyzeBeams();
+   infile.analyzeKernStemLengths();
+   return true;
+}
+
+
+
+int main(int argc, char** argv) {
+   if (argc < 2) {
+      cerr << "Usage: " << argv[0] << " file.krn [file2.krn ...]" << endl;
+      return 1;
+   }
+   int errors = 0;
+   for (int i=1; i<argc; i++) {
+      HumdrumFile serial;
+      HumdrumFile parallel;
+      if (!analyzeFile(serial, argv[i], 1) || !analyzeFile(parallel, argv[i], 4)) {
+         return 1;
+      }
+      vector<string> list1 = getAnalysisList(serial);
+      vector<string> list2 = getAnalysisList(parallel);
+      if (list1.size() != list2.size()) {
+         cout << argv[i] << ": analysis sizes differ" << endl;
+         errors++;
+         continue;
+      }
+      for (int j=0; j<(int)list1.size(); j++) {
+         if (list1[j] != list2[j]) {
+            cout << argv[i] << ": entry " << j << " differs:" << endl;
+            cout << "\tserial:   " << list1[j] << endl;
+            cout << "\tparallel: " << list2[j] << endl;
+            errors++;
+         }
+      }
+   }
+   cout << (errors ? "FAILED" : "PASSED") << endl;
+   return errors ? 1 : 0;
+}
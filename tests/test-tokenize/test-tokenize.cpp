@@ -0,0 +1,157 @@
+// Description: Check that HumdrumLine::createTokensFromLine() splits lines
+//              in the same way as the previous character-by-character
+//              tokenizer, and compare the speed of the two on wide lines.
+//              Optional argument: number of repetitions for the timing.
+
+#include "humlib.h"
+
+#include <chrono>
+#include <cstdlib>
+
+using namespace hum;
+
+
+//////////////////////////////
+//
+// oldTokenize -- The tokenizer that was used before memchr() was used to
+//     find tabs (without the token objects).
+//
+
+void oldTokenize(const string& line, vector<string>& tokens, vector<int>& tabs) {
+   tokens.clear();
+   tabs.clear();
+   char ch = 0;
+   char lastch = 0;
+   string tstring;
+   if (line.size() == 0) {
+      tokens.push_back("");
+      tabs.push_back(0);
+   } else if (line.compare(0, 2, "!!") == 0) {
+      tokens.push_back(line);
+      tabs.push_back(0);
+   } else {
+      for (int i=0; i<(int)line.size(); i++) {
+         lastch = ch;
+         ch = line[i];
+         if (ch == '\t') {
+            if (lastch != '\t') {
+               tokens.push_back(tstring);
+               tabs.push_back(1);
+               tstring.clear();
+            } else if (tabs.size() > 0) {
+               tabs.back()++;
+            }
+         } else {
+            tstring += ch;
+         }
+      }
+   }
+   if (tstring.size() > 0) {
+      tokens.push_back(tstring);
+      tabs.push_back(0);
+   }
+}
+
+
+
+//////////////////////////////
+//
+// checkLine -- Return true if the tokens and tab counts of the line
+//     match those of the old tokenizer.
+//
+
+bool checkLine(const string& text) {
+   HumdrumLine line(text);
+   vector<string> tokens;
+   vector<int> tabs;
+   oldTokenize(text, tokens, tabs);
+   bool ok = line.getTokenCount() == (int)tokens.size();
+   for (int i=0; ok && (i<(int)tokens.size()); i++) {
+      ok = (*line.token(i) == tokens[i]) && (line.getTabCount(i) == tabs[i]);
+   }
+   if (!ok) {
+      cout << "ERROR: tokens differ for line \"" << text << "\"" << endl;
+   }
+   return ok;
+}
+
+
+
+//////////////////////////////
+//
+// makeWideLine -- Create a data line with the given number of fields.
+//
+
+string makeWideLine(int fields) {
+   string output;
+   const char* notes[] = {"4c", "8d-L", "8eJ", ".", "2.gg#", "4r", "(16AA)"};
+   for (int i=0; i<fields; i++) {
+      if (i > 0) {
+         output += '\t';
+      }
+      output += notes[i % 7];
+   }
+   return output;
+}
+
+
+
+int main(int argc, char** argv) {
+   int errors = 0;
+   vector<string> lines = {
+      "", "!!", "!!!COM:\tBach", "!! global\t\tcomment", "*", "4c",
+      "4c\t4d", "4c\t\t4d", "4c\t\t\t4d\t4e", "\t4c", "\t\t4c\t4d",
+      "4c\t", "4c\t\t", "\t", "\t\t", "!\t!", "*^\t*\t*v\t*v", "a\tb\t\tc\t",
+      "4c 4e 4g\t.", makeWideLine(200)
+   };
+   for (auto& line : lines) {
+      errors += !checkLine(line);
+   }
+
+   // Random lines of tabs and short fields:
+   srand(1);
+   for (int i=0; i<1000; i++) {
+      string line;
+      int length = rand() % 20;
+      for (int j=0; j<length; j++) {
+         int r = rand() % 4;
+         line += r == 0 ? '\t' : (r == 1 ? '!' : 'a');
+      }
+      errors += !checkLine(line);
+   }
+
+   // Timing on wide lines:
+   int count = argc > 1 ? atoi(argv[1]) : 2000;
+   string wide = makeWideLine(256);
+   vector<string> tokens;
+   vector<int> tabs;
+   auto start = std::chrono::steady_clock::now();
+   for (int i=0; i<count; i++) {
+      vector<HTp> oldtokens;
+      string text(wide);
+      oldTokenize(text, tokens, tabs);
+      // Create the token objects as the old tokenizer did:
+      for (auto& text : tokens) {
+         oldtokens.push_back(new HumdrumToken(text));
+      }
+      for (auto token : oldtokens) {
+         delete token;
+      }
+   }
+   auto middle = std::chrono::steady_clock::now();
+   for (int i=0; i<count; i++) {
+      // The constructor copies the text and creates the tokens:
+      HumdrumLine line(wide);
+   }
+   auto stop = std::chrono::steady_clock::now();
+   std::chrono::duration<double, std::milli> oldtime = middle - start;
+   std::chrono::duration<double, std::milli> newtime = stop - middle;
+   cout << "Tokenized " << count << " lines with 256 fields: old "
+        << oldtime.count() << " ms, new " << newtime.count() << " ms" << endl;
+
+   cout << (errors ? "FAILED" : "PASSED") << endl;
+   return errors ? 1 : 0;
+}
+
+
+
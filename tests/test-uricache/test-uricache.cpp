@@ -0,0 +1,200 @@
+// Description: Test downloading with keep-alive connections and the
+//              URI cache directory against a local HTTP server.  The
+//              humlib library must be compiled with -DUSING_URI.
+
+#include "humlib.h"
+
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <signal.h>
+
+using namespace hum;
+
+const char* CONTENT = "**kern\n4c\n4d\n*-\n";
+
+
+//////////////////////////////
+//
+// serveClient -- Answer requests on a connection until the client closes
+//     it.  Every response includes the total number of connections and
+//     requests in the X-Stats header.  Requests with a matching
+//     If-None-Match header receive a 304 reply.
+//
+
+void serveClient(int client, int& connections, int& requests) {
+   string request;
+   char buffer[4096];
+   while (true) {
+      auto end = request.find("\r\n\r\n");
+      if (end == string::npos) {
+         int count = (int)::read(client, buffer, sizeof(buffer));
+         if (count <= 0) {
+            return;
+         }
+         request.append(buffer, count);
+         continue;
+      }
+      string header = request.substr(0, end);
+      request = request.substr(end + 4);
+      requests++;
+      stringstream response;
+      bool chunked = header.find("GET /chunked") != string::npos;
+      if (header.find("GET /stats") != string::npos) {
+         string body = to_string(connections) + " " + to_string(requests - 1);
+         response << "HTTP/1.1 200 OK\r\nContent-Length: " << body.size()
+                  << "\r\nCache-Control: no-store\r\n\r\n" << body;
+      } else if (header.find("If-None-Match: \"v1\"") != string::npos) {
+         response << "HTTP/1.1 304 Not Modified\r\nETag: \"v1\"\r\n"
+                  << "Cache-Control: max-age=0\r\n\r\n";
+      } else if (chunked) {
+         string content = CONTENT;
+         response << "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n";
+         response << std::hex << 5 << "\r\n" << content.substr(0, 5) << "\r\n";
+         response << std::hex << content.size() - 5 << "\r\n"
+                  << content.substr(5) << "\r\n0\r\n\r\n";
+      } else {
+         response << "HTTP/1.1 200 OK\r\nContent-Length: " << strlen(CONTENT)
+                  << "\r\nETag: \"v1\"\r\nCache-Control: max-age=0\r\n\r\n"
+                  << CONTENT;
+      }
+      string output = response.str();
+      if (::write(client, output.data(), output.size()) < 0) {
+         return;
+      }
+   }
+}
+
+
+
+//////////////////////////////
+//
+// runServer -- Accept connections one at a time.
+//
+
+void runServer(int server) {
+   int connections = 0;
+   int requests = 0;
+   while (true) {
+      int client = accept(server, NULL, NULL);
+      if (client < 0) {
+         continue;
+      }
+      connections++;
+      serveClient(client, connections, requests);
+      close(client);
+   }
+}
+
+
+
+//////////////////////////////
+//
+// download --
+//
+
+string download(const string& url) {
+   stringstream data;
+   HumdrumFileBase::readStringFromHttpUri(data, url);
+   return data.str();
+}
+
+
+
+int main(int argc, char** argv) {
+   int server = socket(AF_INET, SOCK_STREAM, 0);
+   struct sockaddr_in address;
+   memset(&address, 0, sizeof(address));
+   address.sin_family = AF_INET;
+   address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+   address.sin_port = 0;
+   if (::bind(server, (struct sockaddr*)&address, sizeof(address)) != 0) {
+      return 1;
+   }
+   listen(server, 5);
+   socklen_t length = sizeof(address);
+   getsockname(server, (struct sockaddr*)&address, &length);
+   int port = ntohs(address.sin_port);
+
+   pid_t pid = fork();
+   if (pid == 0) {
+      runServer(server);
+      return 0;
+   }
+   close(server);
+
+   string base = "http://127.0.0.1:" + to_string(port);
+   int errors = 0;
+
+   // Three downloads should share a single connection:
+   for (int i=0; i<3; i++) {
+      if (download(base + "/file.krn") != CONTENT) {
+         cout << "ERROR: bad content in download " << i << endl;
+         errors++;
+      }
+   }
+   if (download(base + "/chunked.krn") != CONTENT) {
+      cout << "ERROR: bad content in chunked download" << endl;
+      errors++;
+   }
+   string stats = download(base + "/stats");
+   cout << "Without cache (connections requests): " << stats << endl;
+   if (stats != "1 4") {
+      errors++;
+   }
+
+   // With a cache, the expired copy is revalidated with the ETag:
+   char tempdir[] = "/tmp/humlib-uricache-XXXXXX";
+   if (mkdtemp(tempdir) == NULL) {
+      return 1;
+   }
+   HumdrumFileBase::setUriCacheDirectory(tempdir);
+   download(base + "/file.krn");
+   if (download(base + "/file.krn") != CONTENT) {
+      cout << "ERROR: bad content from revalidated cache" << endl;
+      errors++;
+   }
+
+   // Fresh cache entries do not contact the server:
+   HumdrumFileBase::setUriCacheMaxAge(3600);
+   download(base + "/chunked.krn");
+   if (download(base + "/chunked.krn") != CONTENT) {
+      cout << "ERROR: bad content from fresh cache" << endl;
+      errors++;
+   }
+   stats = download(base + "/stats");
+   cout << "With cache (connections requests): " << stats << endl;
+   if (stats != "1 8") {
+      errors++;
+   }
+
+   // Identical content is stored only once in the cache directory:
+   string command = "ls ";
+   command += tempdir;
+   command += "/*.dat | wc -l";
+   FILE* listing = popen(command.c_str(), "r");
+   int datcount = 0;
+   if (listing && (fscanf(listing, "%d", &datcount) == 1) && (datcount != 1)) {
+      cout << "ERROR: expected one content file in cache, found " << datcount << endl;
+      errors++;
+   }
+   if (listing) {
+      pclose(listing);
+   }
+
+   HumdrumFileBase::closeHttpConnections();
+   kill(pid, SIGTERM);
+   waitpid(pid, NULL, 0);
+   command = "rm -rf ";
+   command += tempdir;
+   if (system(command.c_str()) != 0) {
+      errors++;
+   }
+
+   cout << (errors ? "FAILED" : "PASSED") << endl;
+   return errors ? 1 : 0;
+}
+
+
+